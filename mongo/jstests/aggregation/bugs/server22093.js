@@ -46,7 +46,12 @@ load('jstests/libs/analyze_plan.js');
     explained = coll.explain().aggregate([{$match: {foo: {$gt: 0}}}, {$count: "count"}]);
     assert(planHasStage(explained.stages[0].$cursor.queryPlanner.winningPlan, "COUNT_SCAN"));
 
-    // A $match that is not a single range cannot use the COUNT_SCAN optimization.
-    explained = coll.explain().aggregate([{$match: {foo: {$in: [0, 1]}}}, {$count: "count"}]);
-    assert(!planHasStage(explained.stages[0].$cursor.queryPlanner.winningPlan, "COUNT_SCAN"));
+    // A $match that is not a single range uses a COUNT_SCAN over the index bounds, which seeks
+    // between the intervals.
+    explained = coll.explain().aggregate([{$match: {foo: {$in: [0, 2]}}}, {$count: "count"}]);
+    var countScan = getPlanStage(explained.stages[0].$cursor.queryPlanner.winningPlan, "COUNT_SCAN");
+    assert.neq(null, countScan, tojson(explained));
+    assert.eq({foo: ["[0.0, 0.0]", "[2.0, 2.0]"]}, countScan.indexBounds, tojson(countScan));
+    assert.eq([{count: 10}],
+              coll.aggregate([{$match: {foo: {$in: [0, 2]}}}, {$count: "count"}]).toArray());
 }());
@@ -0,0 +1,61 @@
+// Cannot implicitly shard accessed collections because unsupported use of sharded collection
+// for target collection of $lookup and $graphLookup.
+// @tags: [assumes_unsharded_collection]
+
+// Tests that a $graphLookup with 'endWith' returns a shortest chain of documents from the start
+// to the end, in order.
+(function() {
+    "use strict";
+
+    const local = db.graphLookup_end_with_local;
+    const foreign = db.graphLookup_end_with_foreign;
+
+    local.drop();
+    foreign.drop();
+
+    // An org chart, in which each employee reports to their manager. Bob reports to both Carol and
+    // Dave, and there is a longer chain from Eve to Alice through Frank and Grace.
+    assert.writeOK(foreign.insert([
+        {_id: "Alice"},
+        {_id: "Carol", reportsTo: "Alice"},
+        {_id: "Dave", reportsTo: "Carol"},
+        {_id: "Bob", reportsTo: ["Dave", "Carol"]},
+        {_id: "Eve", reportsTo: "Frank"},
+        {_id: "Frank", reportsTo: "Grace"},
+        {_id: "Grace", reportsTo: "Alice"},
+    ]));
+    assert.writeOK(local.insert([
+        {_id: 0, employee: "Bob", boss: "Alice"},
+        {_id: 1, employee: "Eve", boss: "Alice"},
+        {_id: 2, employee: "Alice", boss: "Bob"},
+        {_id: 3, employee: "Bob", boss: "Bob"},
+    ]));
+
+    const chainOf = function(maxDepth) {
+        let spec = {
+            from: foreign.getName(),
+            startWith: "$employee",
+            endWith: "$boss",
+            connectFromField: "reportsTo",
+            connectToField: "_id",
+            depthField: "depth",
+            as: "chain"
+        };
+        if (maxDepth !== undefined) {
+            spec.maxDepth = maxDepth;
+        }
+        return local.aggregate([{$graphLookup: spec}, {$sort: {_id: 1}}])
+            .toArray()
+            .map(doc => doc.chain.map(link => [link._id, link.depth]));
+    };
+
+    assert.eq(chainOf(), [
+        [["Bob", 0], ["Carol", 1], ["Alice", 2]],
+        [["Eve", 0], ["Frank", 1], ["Grace", 2], ["Alice", 3]],
+        [],
+        [["Bob", 0]],
+    ]);
+
+    // A chain longer than 'maxDepth' is not returned.
+    assert.eq(chainOf(2), [[["Bob", 0], ["Carol", 1], ["Alice", 2]], [], [], [["Bob", 0]]]);
+}());
@@ -0,0 +1,77 @@
+// Tests that $out builds the indexes of its temporary collection from the inserted documents, and
+// that the results match those of the classic insert path.
+// @tags: [assumes_unsharded_collection]
+(function() {
+    "use strict";
+
+    const input = db.out_bulk_load_in;
+    const output = db.out_bulk_load_out;
+    input.drop();
+    output.drop();
+
+    function tempCollections() {
+        return db.getCollectionNames().filter(name => /^tmp\.agg_out/.test(name));
+    }
+
+    function sortedIndexes(coll) {
+        return coll.getIndexes()
+            .map(spec => ({name: spec.name, key: spec.key, unique: spec.unique}))
+            .sort((a, b) => (a.name < b.name ? -1 : 1));
+    }
+
+    const bulk = input.initializeUnorderedBulkOp();
+    for (let i = 0; i < 1000; ++i) {
+        bulk.insert({_id: i, a: i % 10, b: -i, s: "str" + i});
+    }
+    assert.writeOK(bulk.execute());
+
+    assert.commandWorked(output.createIndex({a: 1}));
+    assert.commandWorked(output.createIndex({b: 1}, {unique: true}));
+    assert.commandWorked(output.createIndex({s: "hashed"}));
+    const expectedIndexes = sortedIndexes(output);
+
+    for (let bulkLoad of [true, false]) {
+        assert.commandWorked(
+            db.adminCommand({setParameter: 1, internalDocumentSourceOutBulkLoad: bulkLoad}));
+
+        input.aggregate([{$out: output.getName()}]);
+        assert.eq(1000, output.find().itcount());
+        assert.eq(sortedIndexes(output), expectedIndexes);
+        assert.eq(100, output.find({a: 3}).hint({a: 1}).itcount());
+        assert.eq({_id: 7, a: 7, b: -7, s: "str7"}, output.findOne({b: -7}));
+        assert.eq(output.find().hint({_id: 1}).itcount(), 1000);
+        assert.eq([], tempCollections());
+
+        // Documents without an _id get one.
+        input.aggregate([{$project: {_id: 0, b: 1}}, {$out: output.getName()}]);
+        assert.eq(1000, output.find({_id: {$type: "objectId"}}).hint({_id: 1}).itcount());
+        assert.eq([], tempCollections());
+
+        // A duplicate key in a unique index fails the $out and leaves the target untouched.
+        const before = output.find().sort({_id: 1}).toArray();
+        assert.throws(
+            () => input.aggregate([{$project: {b: {$literal: 1}}}, {$out: output.getName()}]));
+        assert.throws(
+            () => input.aggregate([{$project: {_id: {$literal: 1}}}, {$out: output.getName()}]));
+        assert.eq(before, output.find().sort({_id: 1}).toArray());
+        assert.eq(sortedIndexes(output), expectedIndexes);
+        assert.eq([], tempCollections());
+
+        assert.writeOK(output.remove({}));
+    }
+
+    // Without an existing target, only the _id index is built.
+    output.drop();
+    assert.commandWorked(
+        db.adminCommand({setParameter: 1, internalDocumentSourceOutBulkLoad: true}));
+    input.aggregate([{$match: {a: 0}}, {$out: output.getName()}]);
+    assert.eq(100, output.find().hint({_id: 1}).itcount());
+    assert.eq(1, output.getIndexes().length);
+
+    // A target created without an _id index doesn't get one.
+    output.drop();
+    assert.commandWorked(db.createCollection(output.getName(), {autoIndexId: false}));
+    input.aggregate([{$match: {a: 0}}, {$out: output.getName()}]);
+    assert.eq(100, output.find().itcount());
+    assert.eq(0, output.getIndexes().length);
+}());
@@ -0,0 +1,81 @@
+// Tests that a leading $group whose _id is a single field path and which only uses $first, or only
+// $last, accumulators can be answered with a DISTINCT_SCAN over an index on that field.
+//
+// Relies on the $group being the first stage of the pipeline, so the pipelines cannot be wrapped in
+// facet stages.
+// @tags: [do_not_wrap_aggregations_in_facets]
+(function() {
+    "use strict";
+
+    load("jstests/libs/analyze_plan.js");  // For 'aggPlanHasStage'.
+
+    const coll = db.use_query_distinct_scan;
+    coll.drop();
+
+    const bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < 100; ++i) {
+        bulk.insert({_id: i, a: i % 5, b: i % 3, c: "c" + (i % 5)});
+    }
+    assert.writeOK(bulk.execute());
+
+    function assertUsesDistinctScan(pipeline) {
+        const explainOutput = coll.explain().aggregate(pipeline);
+        assert(aggPlanHasStage(explainOutput, "DISTINCT_SCAN"),
+               "Expected pipeline " + tojsononeline(pipeline) +
+                   " to use a DISTINCT_SCAN: " + tojson(explainOutput));
+    }
+
+    function assertDoesNotUseDistinctScan(pipeline) {
+        const explainOutput = coll.explain().aggregate(pipeline);
+        assert(!aggPlanHasStage(explainOutput, "DISTINCT_SCAN"),
+               "Expected pipeline " + tojsononeline(pipeline) +
+                   " not to use a DISTINCT_SCAN: " + tojson(explainOutput));
+    }
+
+    function assertResults(pipeline, expected) {
+        const results = coll.aggregate(pipeline.concat([{$sort: {_id: 1}}])).toArray();
+        assert.eq(results, expected, tojsononeline(pipeline));
+    }
+
+    // Without an index the $group has to look at every document.
+    assertDoesNotUseDistinctScan([{$group: {_id: "$a"}}]);
+
+    assert.commandWorked(coll.createIndex({a: 1, c: 1}));
+
+    const distinctA = [{_id: 0}, {_id: 1}, {_id: 2}, {_id: 3}, {_id: 4}];
+    assertUsesDistinctScan([{$group: {_id: "$a"}}]);
+    assertResults([{$group: {_id: "$a"}}], distinctA);
+
+    // $first of a field in the index is covered, and of a field outside it requires a FETCH.
+    assertUsesDistinctScan([{$group: {_id: "$a", c: {$first: "$c"}}}]);
+    assertResults([{$group: {_id: "$a", c: {$first: "$c"}}}],
+                  distinctA.map((doc) => ({_id: doc._id, c: "c" + doc._id})));
+    assertUsesDistinctScan([{$group: {_id: "$a", b: {$first: "$b"}}}]);
+    assertResults([{$group: {_id: "$a", n: {$first: {$literal: 1}}}}],
+                  distinctA.map((doc) => ({_id: doc._id, n: 1})));
+
+    // $last is answered by scanning the index backwards, which visits the last index entry of each
+    // group. All documents of a group have the same key here, so that is the one inserted last.
+    assertUsesDistinctScan([{$group: {_id: "$a", b: {$last: "$b"}}}]);
+    assertResults([{$group: {_id: "$a", b: {$last: "$b"}}}],
+                  distinctA.map((doc) => ({_id: doc._id, b: (95 + doc._id) % 3})));
+    assertUsesDistinctScan([{$match: {a: {$lte: 1}}}, {$group: {_id: "$a", b: {$last: "$b"}}}]);
+    assertResults([{$match: {a: {$lte: 1}}}, {$group: {_id: "$a", b: {$last: "$b"}}}],
+                  [{_id: 0, b: 95 % 3}, {_id: 1, b: 96 % 3}]);
+
+    // A predicate answerable from the index still allows the distinct scan.
+    assertUsesDistinctScan([{$match: {a: {$gte: 3}}}, {$group: {_id: "$a"}}]);
+    assertResults([{$match: {a: {$gte: 3}}}, {$group: {_id: "$a"}}], [{_id: 3}, {_id: 4}]);
+
+    // Accumulators that need every document in the group cannot skip keys.
+    assertDoesNotUseDistinctScan([{$group: {_id: "$a", n: {$sum: 1}}}]);
+    assertResults([{$group: {_id: "$a", n: {$sum: 1}}}],
+                  distinctA.map((doc) => ({_id: doc._id, n: 20})));
+    assertDoesNotUseDistinctScan([{$group: {_id: "$a", b: {$first: "$b"}, c: {$last: "$c"}}}]);
+    assertDoesNotUseDistinctScan([{$group: {_id: {a: "$a", c: "$c"}}}]);
+
+    // A multikey index may contain several keys per document, which $group would not see.
+    assert.writeOK(coll.insert({_id: 100, a: [5, 6]}));
+    assertDoesNotUseDistinctScan([{$group: {_id: "$a"}}]);
+    assertResults([{$group: {_id: "$a"}}], distinctA.concat([{_id: [5, 6]}]));
+}());
@@ -0,0 +1,60 @@
+// @tags: [does_not_support_stepdowns]
+
+// Confirms that profiled operations report the resources they consumed: CPU time, time queued for
+// a global lock ticket and, on WiredTiger, the bytes read and written by the operation.
+
+(function() {
+    "use strict";
+
+    // For getLatestProfilerEntry.
+    load("jstests/libs/profiler.js");
+
+    var testDB = db.getSiblingDB("profile_resource_usage");
+    assert.commandWorked(testDB.dropDatabase());
+    var coll = testDB.getCollection("test");
+
+    var buildInfo = assert.commandWorked(testDB.adminCommand({buildInfo: 1}));
+    var isLinux = buildInfo.buildEnvironment.target_os === "linux";
+    var isWiredTiger = testDB.serverStatus().storageEngine.name === "wiredTiger";
+
+    testDB.setProfilingLevel(2);
+
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 100; ++i) {
+        bulk.insert({_id: i, padding: "x".repeat(100)});
+    }
+    assert.writeOK(bulk.execute());
+
+    var profileObj = getLatestProfilerEntry(testDB, {op: "insert"});
+    if (isWiredTiger) {
+        assert.gt(profileObj.storage.data.bytesWritten, 100 * 100, tojson(profileObj));
+    }
+
+    assert.eq(100, coll.find({padding: {$exists: true}}).itcount());
+
+    profileObj = getLatestProfilerEntry(testDB, {op: "query"});
+    if (isLinux) {
+        assert.gte(profileObj.cpuTimeMicros, 0, tojson(profileObj));
+    }
+    if (isWiredTiger) {
+        assert.gt(profileObj.storage.data.bytesRead, 100 * 100, tojson(profileObj));
+    }
+
+    // Each statement of a batched write is profiled on its own, with only its own share of the
+    // operation's resources.
+    var deletes = [];
+    for (var i = 0; i < 100; ++i) {
+        deletes.push({q: {_id: i}, limit: 1});
+    }
+    assert.commandWorked(testDB.runCommand({delete: coll.getName(), deletes: deletes}));
+
+    var removes = testDB.system.profile.find({op: "remove"}).toArray();
+    assert.eq(100, removes.length, tojson(removes));
+    if (isWiredTiger) {
+        removes.forEach(function(entry) {
+            assert.lt(entry.storage.data.bytesRead, 10 * 100, tojson(entry));
+        });
+    }
+
+    testDB.setProfilingLevel(0);
+})();
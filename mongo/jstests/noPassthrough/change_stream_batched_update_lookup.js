@@ -0,0 +1,80 @@
+// Tests that a change stream with fullDocument: "updateLookup" looks up the post-images of several
+// update events with a single query, returns the events in their original order, and reports the
+// lookups in the profiler.
+(function() {
+    "use strict";
+
+    // For supportsMajorityReadConcern().
+    load("jstests/multiVersion/libs/causal_consistency_helpers.js");
+
+    if (!supportsMajorityReadConcern()) {
+        jsTestLog("Skipping test since storage engine doesn't support majority read concern.");
+        return;
+    }
+
+    // Read the oplog with the stream's own cursor, so that all of the changes are visible to the
+    // same getMore.
+    const rst = new ReplSetTest(
+        {nodes: 1, nodeOptions: {setParameter: {internalChangeStreamUseSharedOplogReader: false}}});
+    rst.startSet();
+    rst.initiate();
+
+    const db = rst.getPrimary().getDB("test");
+    const coll = db.change_stream_batched_update_lookup;
+    const kNumDocs = 10;
+    const comment = "change_stream_batched_update_lookup";
+
+    for (let i = 0; i < kNumDocs; ++i) {
+        assert.writeOK(coll.insert({_id: i}));
+    }
+
+    const res = assert.commandWorked(db.runCommand({
+        aggregate: coll.getName(),
+        pipeline: [{$changeStream: {fullDocument: "updateLookup"}}],
+        cursor: {batchSize: 0},
+        comment: comment
+    }));
+    const cursorId = res.cursor.id;
+
+    // Update every document, then delete the last one before its update is looked up.
+    for (let i = 0; i < kNumDocs; ++i) {
+        assert.writeOK(coll.update({_id: i}, {$set: {x: i}}, {writeConcern: {w: "majority"}}));
+    }
+    assert.writeOK(coll.remove({_id: kNumDocs - 1}, {writeConcern: {w: "majority"}}));
+
+    assert.commandWorked(db.setProfilingLevel(2));
+
+    let changes = [];
+    assert.soon(() => {
+        const getMore = assert.commandWorked(
+            db.runCommand({getMore: cursorId, collection: coll.getName(), batchSize: 100}));
+        changes = changes.concat(getMore.cursor.nextBatch);
+        return changes.length >= kNumDocs + 1;
+    });
+
+    // The changes are returned in order, with the post-images as of the lookup.
+    assert.eq(changes.length, kNumDocs + 1, tojson(changes));
+    for (let i = 0; i < kNumDocs; ++i) {
+        assert.eq(changes[i].operationType, "update", tojson(changes[i]));
+        assert.eq(changes[i].documentKey, {_id: i}, tojson(changes[i]));
+        assert.eq(changes[i].fullDocument, i < kNumDocs - 1 ? {_id: i, x: i} : null);
+    }
+    assert.eq(changes[kNumDocs].operationType, "delete", tojson(changes[kNumDocs]));
+
+    // Every post-image was looked up, and at least one batch looked up several of them.
+    let lookups = 0;
+    let batchedLookups = false;
+    db.system.profile.find({op: "getmore", "originatingCommand.comment": comment})
+        .forEach((entry) => {
+            if (entry.documentKeyLookupBatches) {
+                lookups += entry.documentKeyLookups;
+                batchedLookups = batchedLookups ||
+                    entry.documentKeyLookups > entry.documentKeyLookupBatches;
+            }
+        });
+    assert.eq(lookups, kNumDocs);
+    assert(batchedLookups);
+
+    assert.commandWorked(db.runCommand({killCursors: coll.getName(), cursors: [cursorId]}));
+    rst.stopSet();
+})();
@@ -0,0 +1,84 @@
+// Tests that change streams share the scan of the oplog once they have caught up with it, that
+// each stream still only sees the changes to its own collection, and that a stream which falls
+// behind the shared scan goes back to reading the oplog on its own without missing any change.
+(function() {
+    "use strict";
+
+    // For supportsMajorityReadConcern().
+    load("jstests/multiVersion/libs/causal_consistency_helpers.js");
+
+    if (!supportsMajorityReadConcern()) {
+        jsTestLog("Skipping test since storage engine doesn't support majority read concern.");
+        return;
+    }
+
+    const rst = new ReplSetTest({nodes: 1});
+    rst.startSet();
+    rst.initiate();
+
+    const db = rst.getPrimary().getDB("test");
+    const kNumStreams = 10;
+
+    function readerStats() {
+        return assert.commandWorked(db.adminCommand({serverStatus: 1})).sharedOplogReader;
+    }
+
+    // Returns the _ids of the next 'n' documents inserted according to 'changeStream'.
+    function nextInsertedIds(changeStream, n) {
+        const ids = [];
+        for (let i = 0; i < n; ++i) {
+            assert.soon(() => changeStream.hasNext());
+            const change = changeStream.next();
+            assert.eq(change.operationType, "insert", tojson(change));
+            ids.push(change.documentKey._id);
+        }
+        return ids;
+    }
+
+    let changeStreams = [];
+    for (let i = 0; i < kNumStreams; ++i) {
+        assert.commandWorked(db.createCollection("coll" + i));
+        changeStreams.push(db["coll" + i].watch());
+    }
+
+    // The first getMore of each stream exhausts its own cursor, after which it attaches to the
+    // shared reader.
+    for (let i = 0; i < kNumStreams; ++i) {
+        assert.writeOK(db["coll" + i].insert({_id: i}));
+    }
+    for (let i = 0; i < kNumStreams; ++i) {
+        assert.eq(nextInsertedIds(changeStreams[i], 1), [i]);
+    }
+    assert.soon(() => readerStats().subscribers === kNumStreams, () => tojson(readerStats()));
+
+    for (let i = 0; i < kNumStreams; ++i) {
+        assert.writeOK(db["coll" + i].insert({_id: kNumStreams + i}));
+    }
+    for (let i = 0; i < kNumStreams; ++i) {
+        assert.eq(nextInsertedIds(changeStreams[i], 1), [kNumStreams + i]);
+        assert(!changeStreams[i].hasNext());
+    }
+
+    let stats = readerStats();
+    assert.eq(stats.namespaces, kNumStreams, tojson(stats));
+    assert.gte(stats.scan.entriesScanned, kNumStreams, tojson(stats));
+    assert.gte(stats.scan.entriesDispatched, kNumStreams, tojson(stats));
+
+    // A stream whose buffer overflows falls back to its own cursor without missing any change.
+    assert.commandWorked(db.adminCommand(
+        {setParameter: 1, internalChangeStreamSharedOplogReaderMaxBufferedEntries: 2}));
+    const kNumInserts = 20;
+    for (let i = 0; i < kNumInserts; ++i) {
+        assert.writeOK(db.coll0.insert({_id: 100 + i}));
+    }
+    assert.soon(() => readerStats().overflows > 0, () => tojson(readerStats()));
+    assert.eq(nextInsertedIds(changeStreams[0], kNumInserts),
+              Array.from({length: kNumInserts}, (_, i) => 100 + i));
+    assert(!changeStreams[0].hasNext());
+
+    // Closing the streams detaches them from the reader.
+    changeStreams.forEach((changeStream) => changeStream.close());
+    assert.soon(() => readerStats().subscribers === 0, () => tojson(readerStats()));
+
+    rst.stopSet();
+}());
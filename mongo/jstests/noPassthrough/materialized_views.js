@@ -0,0 +1,112 @@
+// Tests that a materialized view is served from its backing collection, which is kept up to date
+// with its source collection in the background, and that collStats reports its staleness.
+(function() {
+    "use strict";
+
+    const conn = MongoRunner.runMongod({setParameter: "materializedViewRefreshIntervalMillis=100"});
+    const testDB = conn.getDB("test");
+    const source = testDB.source;
+
+    assert.commandWorked(source.insert([{_id: 1, a: "x", v: 1}, {_id: 2, a: "y", v: 5}]));
+    assert.commandWorked(testDB.runCommand({
+        create: "totals",
+        viewOn: source.getName(),
+        pipeline: [{$group: {_id: "$a", total: {$sum: "$v"}, low: {$min: "$v"}, n: {$sum: 1}}}],
+        materialized: true
+    }));
+
+    const listing = testDB.getCollectionInfos({name: "totals"});
+    assert.eq(listing.length, 1, tojson(listing));
+    assert.eq(listing[0].options.materialized, true, tojson(listing));
+
+    function waitUntilFresh() {
+        let stats;
+        assert.soon(() => {
+            stats = assert.commandWorked(testDB.runCommand({collStats: "totals"}));
+            return stats.materialized.populated && !stats.materialized.stale;
+        }, () => tojson(stats));
+        return stats;
+    }
+
+    function totals() {
+        return testDB.totals.find().sort({_id: 1}).toArray();
+    }
+
+    let stats = waitUntilFresh();
+    assert.eq(stats.materialized.backingCollection, "system.materialized.totals", tojson(stats));
+    assert.eq(stats.count, 2, tojson(stats));
+    assert.eq(totals(),
+              [{_id: "x", total: 1, low: 1, n: 1}, {_id: "y", total: 5, low: 5, n: 1}]);
+
+    // The backing collection holds the result of the pipeline, each wrapped in a document.
+    assert.eq(testDB.getCollection("system.materialized.totals")
+                  .find()
+                  .sort({_id: 1})
+                  .toArray()
+                  .map(doc => doc.r),
+              totals());
+
+    // Inserts are folded into the existing results.
+    assert.commandWorked(source.insert([{_id: 3, a: "x", v: -2}, {_id: 4, a: "z", v: 7}]));
+    stats = waitUntilFresh();
+    assert.gte(stats.materialized.incrementalRefreshes, 1, tojson(stats));
+    assert.eq(totals(), [
+        {_id: "x", total: -1, low: -2, n: 2},
+        {_id: "y", total: 5, low: 5, n: 1},
+        {_id: "z", total: 7, low: 7, n: 1}
+    ]);
+
+    // Any other write recomputes the view, removing the results which are no longer produced.
+    const fullRefreshes = stats.materialized.fullRefreshes;
+    assert.commandWorked(source.remove({a: "y"}));
+    stats = waitUntilFresh();
+    assert.gt(stats.materialized.fullRefreshes, fullRefreshes, tojson(stats));
+    assert.eq(totals(),
+              [{_id: "x", total: -1, low: -2, n: 2}, {_id: "z", total: 7, low: 7, n: 1}]);
+
+    // Writes which the refresher has not yet applied are reported as refresh lag.
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, materializedViewRefresherEnabled: false}));
+    sleep(500);  // Let a refresh which was already in progress finish.
+    assert.commandWorked(source.insert({_id: 5, a: "x", v: 1}));
+    assert.soon(() => {
+        stats = assert.commandWorked(testDB.runCommand({collStats: "totals"}));
+        return stats.materialized.stale && stats.materialized.refreshLagMillis > 0;
+    }, () => tojson(stats));
+    assert.eq(stats.materialized.pendingInserts, 1, tojson(stats));
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, materializedViewRefresherEnabled: true}));
+    waitUntilFresh();
+    assert.eq(totals()[0], {_id: "x", total: 0, low: -2, n: 3});
+
+    // Results without an _id, or with duplicate ones, are returned as the pipeline produced them,
+    // and a trailing $sort keeps its order.
+    assert.commandWorked(testDB.runCommand({
+        create: "sorted",
+        viewOn: source.getName(),
+        pipeline: [{$project: {_id: 0, a: 1}}, {$sort: {a: -1}}],
+        materialized: true
+    }));
+    assert.soon(() => {
+        const stats = assert.commandWorked(testDB.runCommand({collStats: "sorted"}));
+        return stats.materialized.populated && !stats.materialized.stale;
+    });
+    assert.eq(testDB.sorted.find().toArray(),
+              [{a: "z"}, {a: "x"}, {a: "x"}, {a: "x"}],
+              tojson(testDB.sorted.find().explain()));
+
+    // A view whose order could not be restored from its results cannot be materialized.
+    assert.commandFailedWithCode(testDB.runCommand({
+        create: "unsortable",
+        viewOn: source.getName(),
+        pipeline: [{$sort: {v: 1}}, {$project: {v: 0}}],
+        materialized: true
+    }),
+                                 ErrorCodes.OptionNotSupportedOnView);
+
+    // Dropping the view drops its backing collection.
+    assert(testDB.totals.drop());
+    assert.eq(testDB.getCollectionInfos({name: "system.materialized.totals"}).length, 0);
+
+    MongoRunner.stopMongod(conn);
+})();
@@ -0,0 +1,32 @@
+// Tests that a leading $group which could be answered with a DISTINCT_SCAN does not return the
+// group keys of orphaned documents on a shard.
+(function() {
+    "use strict";
+
+    const st = new ShardingTest({shards: 2});
+    const coll = st.s0.getCollection("test.agg_distinct_scan_orphans");
+
+    //
+    // Pre-split collection: shard 0 takes {x: {$lt: 0}}, shard 1 takes {x: {$gte: 0}}.
+    //
+    assert.commandWorked(coll.getDB().adminCommand({enableSharding: coll.getDB().getName()}));
+    st.ensurePrimaryShard(coll.getDB().toString(), "shard0000");
+    assert.commandWorked(
+        coll.getDB().adminCommand({shardCollection: coll.getFullName(), key: {x: 1}}));
+    assert.commandWorked(coll.getDB().adminCommand({split: coll.getFullName(), middle: {x: 0}}));
+    assert.commandWorked(
+        coll.getDB().adminCommand({moveChunk: coll.getFullName(), find: {x: 0}, to: "shard0001"}));
+    assert.commandWorked(coll.createIndex({a: 1}));
+
+    assert.writeOK(coll.insert({_id: 0, x: -1, a: "owned"}));
+    assert.writeOK(coll.insert({_id: 1, x: 1, a: "owned"}));
+
+    // An orphan on shard 0 in the range owned by shard 1.
+    assert.writeOK(st.shard0.getCollection(coll.getFullName()).insert({_id: 2, x: 2, a: "orphan"}));
+
+    const pipeline = [{$group: {_id: "$a", x: {$first: "$x"}}}, {$sort: {_id: 1}}];
+    const results = coll.aggregate(pipeline).toArray();
+    assert.eq(results.map(doc => doc._id), ["owned"], tojson(results));
+
+    st.stop();
+})();
@@ -0,0 +1,79 @@
+/**
+ * Tests that when a sharded $sort + $limit is merged on mongoS, each shard returns its top-k
+ * results in its initial response, so that mongoS does not need to issue any getMores to merge
+ * them. Also tests that a $limit which follows a $lookup or $addFields is pushed down into the
+ * $sort.
+ */
+(function() {
+    'use strict';
+
+    load("jstests/libs/profiler.js");  // For profilerHas*OrThrow helper functions.
+
+    const st = new ShardingTest({shards: 2});
+
+    const mongosDB = st.s0.getDB(jsTestName());
+    const mongosColl = mongosDB.test;
+    const shard0DB = st.shard0.getDB(jsTestName());
+    const shard1DB = st.shard1.getDB(jsTestName());
+
+    assert.commandWorked(mongosDB.dropDatabase());
+
+    // Shard the collection on _id, with the chunk [0, MaxKey) on shard0001.
+    assert.commandWorked(mongosDB.adminCommand({enableSharding: mongosDB.getName()}));
+    st.ensurePrimaryShard(mongosDB.getName(), "shard0000");
+    assert.commandWorked(
+        mongosDB.adminCommand({shardCollection: mongosColl.getFullName(), key: {_id: 1}}));
+    assert.commandWorked(
+        mongosDB.adminCommand({split: mongosColl.getFullName(), middle: {_id: 0}}));
+    assert.commandWorked(mongosDB.adminCommand(
+        {moveChunk: mongosColl.getFullName(), find: {_id: 50}, to: "shard0001"}));
+
+    const bulk = mongosColl.initializeUnorderedBulkOp();
+    for (let i = -50; i < 50; ++i) {
+        bulk.insert({_id: i, x: (i * 37) % 100});
+    }
+    assert.writeOK(bulk.execute());
+
+    const expected = mongosColl.find().sort({x: -1, _id: 1}).limit(5).toArray();
+
+    assert.commandWorked(shard0DB.setProfilingLevel(2));
+    assert.commandWorked(shard1DB.setProfilingLevel(2));
+
+    const comment = "agg_sort_limit_initial_batch";
+    const results = mongosColl
+                        .aggregate([{$sort: {x: -1, _id: 1}}, {$addFields: {y: 1}}, {$limit: 5}],
+                                   {comment: comment})
+                        .toArray();
+    assert.eq(results, expected.map((doc) => Object.merge(doc, {y: 1})));
+
+    for (let shardDB of[shard0DB, shard1DB]) {
+        // The shards executed the $sort with the $limit absorbed, and returned its results in the
+        // initial response.
+        profilerHasSingleMatchingEntryOrThrow({
+            profileDB: shardDB,
+            filter: {
+                "command.aggregate": mongosColl.getName(),
+                "command.comment": comment,
+                "command.cursor.batchSize": 5,
+                "command.pipeline.1.$limit": 5
+            }
+        });
+
+        // No getMores were needed to merge the results.
+        profilerHasZeroMatchingEntriesOrThrow({
+            profileDB: shardDB,
+            filter: {op: "getmore", "originatingCommand.comment": comment}
+        });
+    }
+
+    // The limit is absorbed by the $sort even though a $lookup separates them.
+    const explain = mongosColl.explain().aggregate([
+        {$sort: {x: -1}},
+        {$lookup: {from: "other", localField: "_id", foreignField: "_id", as: "joined"}},
+        {$limit: 5}
+    ]);
+    assert.eq(explain.splitPipeline.shardsPart, [{$sort: {sortKey: {x: -1}, limit: NumberLong(5)}}],
+              tojson(explain));
+
+    st.stop();
+})();
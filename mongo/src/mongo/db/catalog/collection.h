@@ -190,6 +190,11 @@ public:
     enum ValidationLevel { OFF, MODERATE, STRICT_V };
     enum class StoreDeletedDoc { Off, On };
 
+    /**
+     * Callback function for callers of insertDocumentForBulkLoader().
+     */
+    using OnRecordInsertedFn = stdx::function<Status(const RecordId& loc)>;
+
     //CollectionImpl̳и࣬ӿڸʵ
     class Impl : virtual CappedCallback, virtual UpdateNotifier {
     public:
@@ -277,6 +282,11 @@ public:
                                       const std::vector<MultiIndexBlock*>& indexBlocks,
                                       bool enforceQuota) = 0;
 
+        virtual Status insertDocumentForBulkLoader(OperationContext* opCtx,
+                                                   const BSONObj& doc,
+                                                   const OnRecordInsertedFn& callback,
+                                                   bool enforceQuota) = 0;
+
         virtual RecordId updateDocument(OperationContext* opCtx,
                                         const RecordId& oldLocation,
                                         const Snapshotted<BSONObj>& oldDoc,
@@ -550,6 +560,19 @@ public:
         return this->_impl().insertDocument(opCtx, doc, indexBlocks, enforceQuota);
     }
 
+    /**
+     * Inserts a document into the record store without maintaining any of the collection's
+     * indexes and calls 'callback' with its RecordId, so that the caller can index it itself.
+     *
+     * NOTE: It is up to caller to keep the indexes consistent with the collection.
+     */
+    inline Status insertDocumentForBulkLoader(OperationContext* const opCtx,
+                                              const BSONObj& doc,
+                                              const OnRecordInsertedFn& callback,
+                                              const bool enforceQuota) {
+        return this->_impl().insertDocumentForBulkLoader(opCtx, doc, callback, enforceQuota);
+    }
+
     /**
      * Updates the document @ oldLocation with newDoc.
      *
@@ -150,6 +150,12 @@ public:
      */
     virtual void setIsTemp(OperationContext* opCtx, bool isTemp) = 0;
 
+    /**
+     * Updates the 'indexesIncomplete' setting for this collection, which records across restarts
+     * that its indexes do not yet hold the keys of all of its documents.
+     */
+    virtual void setIndexesIncomplete(OperationContext* opCtx, bool incomplete) = 0;
+
     /**
      * Assigns a new UUID to this collection. This is to be called when the schemaVersion is set
      * to 3.6 and there are collections that still do not have UUIDs.
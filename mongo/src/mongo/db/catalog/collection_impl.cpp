@@ -186,6 +186,12 @@ void CollectionImpl::init(OperationContext* opCtx) {
 	//CollectionInfoCacheImpl::init
 	//ʼüϵplanCache IndexEntry
     _infoCache.init(opCtx);
+
+    // A bulk load that did not commit before the restart left the indexes without the keys of
+    // the documents it inserted.
+    if (_details->getCollectionOptions(opCtx).indexesIncomplete) {
+        _infoCache.setIndexesIncomplete(true);
+    }
 }
 
 CollectionImpl::~CollectionImpl() {
@@ -420,6 +426,24 @@ Status CollectionImpl::insertDocument(OperationContext* opCtx,
                                       const BSONObj& doc,
                                       const std::vector<MultiIndexBlock*>& indexBlocks,
                                       bool enforceQuota) {
+    return insertDocumentForBulkLoader(opCtx,
+                                       doc,
+                                       [&](const RecordId& loc) {
+                                           for (auto&& indexBlock : indexBlocks) {
+                                               Status status = indexBlock->insert(doc, loc);
+                                               if (!status.isOK()) {
+                                                   return status;
+                                               }
+                                           }
+                                           return Status::OK();
+                                       },
+                                       enforceQuota);
+}
+
+Status CollectionImpl::insertDocumentForBulkLoader(OperationContext* opCtx,
+                                                   const BSONObj& doc,
+                                                   const Collection::OnRecordInsertedFn& callback,
+                                                   bool enforceQuota) {
 
     MONGO_FAIL_POINT_BLOCK(failCollectionInserts, extraData) {
         const BSONObj& data = extraData.getData();
@@ -450,11 +474,9 @@ Status CollectionImpl::insertDocument(OperationContext* opCtx,
     if (!loc.isOK())
         return loc.getStatus();
 
-    for (auto&& indexBlock : indexBlocks) {
-        Status status = indexBlock->insert(doc, loc.getValue());
-        if (!status.isOK()) {
-            return status;
-        }
+    Status status = callback(loc.getValue());
+    if (!status.isOK()) {
+        return status;
     }
 
     vector<InsertStatement> inserts;
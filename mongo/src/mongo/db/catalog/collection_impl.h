@@ -207,6 +207,17 @@ public:
                           const std::vector<MultiIndexBlock*>& indexBlocks,
                           bool enforceQuota) final;
 
+    /**
+     * Inserts a document into the record store without maintaining any indexes and calls
+     * 'callback' with its RecordId.
+     *
+     * NOTE: It is up to caller to keep the indexes consistent with the collection.
+     */
+    Status insertDocumentForBulkLoader(OperationContext* opCtx,
+                                       const BSONObj& doc,
+                                       const Collection::OnRecordInsertedFn& callback,
+                                       bool enforceQuota) final;
+
     /**
      * Updates the document @ oldLocation with newDoc.
      *
@@ -70,6 +70,10 @@ public:
 
         virtual void notifyOfQuery(OperationContext* opCtx,
                                    const std::set<std::string>& indexesUsed) = 0;
+
+        virtual void setIndexesIncomplete(bool incomplete) = 0;
+
+        virtual bool indexesIncomplete() const = 0;
     };
 
 private:
@@ -162,6 +166,19 @@ public:
         return this->_impl().notifyOfQuery(opCtx, indexesUsed);
     }
 
+    /**
+     * Marks the ready indexes of the collection as missing the keys of some of its documents, as
+     * they are while $out bulk loads the collection, or as complete again. Queries and validate
+     * refuse to read a collection whose indexes are incomplete.
+     */
+    inline void setIndexesIncomplete(const bool incomplete) {
+        return this->_impl().setIndexesIncomplete(incomplete);
+    }
+
+    inline bool indexesIncomplete() const {
+        return this->_impl().indexesIncomplete();
+    }
+
     //explicit inline CollectionInfoCache(Collection* const collection, const NamespaceString& ns)
     //ȷӦ
     std::unique_ptr<Impl> _pimpl;
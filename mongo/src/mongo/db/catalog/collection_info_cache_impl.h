@@ -34,6 +34,7 @@
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/query_settings.h"
 #include "mongo/db/update_index_data.h"
+#include "mongo/platform/atomic_word.h"
 
 namespace mongo {
 
@@ -108,6 +109,14 @@ public:
      */
     void notifyOfQuery(OperationContext* opCtx, const std::set<std::string>& indexesUsed);
 
+    void setIndexesIncomplete(bool incomplete) {
+        _indexesIncomplete.store(incomplete);
+    }
+
+    bool indexesIncomplete() const {
+        return _indexesIncomplete.load();
+    }
+
 private:
     void computeIndexKeys(OperationContext* opCtx);
     void updatePlanCacheIndexEntries(OperationContext* opCtx);
@@ -139,6 +148,10 @@ private:
     CollectionIndexUsageTracker _indexUsageTracker;
 
     bool _hasTTLIndex = false;
+
+    // Set while the collection is bulk loaded. Read by queries without a collection lock held in
+    // mode X.
+    AtomicBool _indexesIncomplete;
 };
 
 }  // namespace mongo
@@ -169,6 +169,13 @@ public:
         std::abort();
     }
 
+    Status insertDocumentForBulkLoader(OperationContext* opCtx,
+                                       const BSONObj& doc,
+                                       const Collection::OnRecordInsertedFn& callback,
+                                       bool enforceQuota) {
+        std::abort();
+    }
+
     RecordId updateDocument(OperationContext* opCtx,
                             const RecordId& oldLocation,
                             const Snapshotted<BSONObj>& oldDoc,
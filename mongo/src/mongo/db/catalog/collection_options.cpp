@@ -114,6 +114,7 @@ Status CollectionOptions::validateForStorage() const {
   indexOptionDefaults: <document>,
   viewOn: <source>,
   pipeline: <pipeline>,
+  materialized: <true|false>,
   collation: <document>,
   writeConcern: <document>,
   comment: <any>
@@ -150,6 +151,8 @@ Status CollectionOptions::parse(const BSONObj& options, ParseKind kind) {
                 return res.getStatus();
             }
             uuid = res.getValue();
+        } else if (fieldName == "indexesIncomplete" && kind == parseForStorage) {
+            indexesIncomplete = e.trueValue();
         } else if (fieldName == "capped") {
             capped = e.trueValue();
         } else if (fieldName == "size") {
@@ -263,6 +266,12 @@ Status CollectionOptions::parse(const BSONObj& options, ParseKind kind) {
             }
 
             pipeline = e.Obj().getOwned();
+        } else if (fieldName == "materialized") {
+            if (!e.isBoolean()) {
+                return Status(ErrorCodes::BadValue, "'materialized' has to be a boolean.");
+            }
+
+            materialized = e.boolean();
         } else if (!createdOn24OrEarlier && !Command::isGenericArgument(fieldName)) {
             return Status(ErrorCodes::InvalidOptions,
                           str::stream() << "The field '" << fieldName
@@ -275,6 +284,10 @@ Status CollectionOptions::parse(const BSONObj& options, ParseKind kind) {
         return Status(ErrorCodes::BadValue, "'pipeline' cannot be specified without 'viewOn'");
     }
 
+    if (viewOn.empty() && materialized) {
+        return Status(ErrorCodes::BadValue, "'materialized' cannot be specified without 'viewOn'");
+    }
+
     return Status::OK();
 }
 
@@ -307,6 +320,9 @@ BSONObj CollectionOptions::toBSON() const {
     if (temp)
         b.appendBool("temp", true);
 
+    if (indexesIncomplete)
+        b.appendBool("indexesIncomplete", true);
+
     if (!storageEngine.isEmpty()) {
         b.append("storageEngine", storageEngine);
     }
@@ -339,6 +355,10 @@ BSONObj CollectionOptions::toBSON() const {
         b.append("pipeline", pipeline);
     }
 
+    if (materialized) {
+        b.appendBool("materialized", true);
+    }
+
     return b.obj();
 }
 }
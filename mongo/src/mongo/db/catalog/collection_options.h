@@ -50,6 +50,7 @@
   indexOptionDefaults: <document>,
   viewOn: <source>,
   pipeline: <pipeline>,
+  materialized: <true|false>,
   collation: <document>,
   writeConcern: <document>,
   comment: <any>
@@ -164,5 +165,11 @@ struct CollectionOptions {
     std::string viewOn;
     // The aggregation pipeline that defines this view.
     BSONObj pipeline;
+    // Whether the result of the view's pipeline is stored in a backing collection.
+    bool materialized = false;
+
+    // Set while a bulk load has inserted documents without adding their keys to the indexes yet.
+    // Only ever stored in the catalog; it cannot be given to the create command.
+    bool indexesIncomplete = false;
 };
 }
@@ -252,6 +252,19 @@ TEST(CollectionOptions, PipelineFieldRequiresViewOn) {
     ASSERT_NOT_OK(options.parse(fromjson("{pipeline: [{$match: {}}]}")));
 }
 
+TEST(CollectionOptions, MaterializedViewParsesCorrectly) {
+    CollectionOptions options;
+    ASSERT_OK(options.parse(fromjson("{viewOn: 'c', pipeline: [], materialized: true}")));
+    ASSERT_TRUE(options.materialized);
+    ASSERT_TRUE(options.toBSON()["materialized"].trueValue());
+}
+
+TEST(CollectionOptions, MaterializedFieldRequiresViewOnAndBoolean) {
+    CollectionOptions options;
+    ASSERT_NOT_OK(options.parse(fromjson("{materialized: true}")));
+    ASSERT_NOT_OK(options.parse(fromjson("{viewOn: 'c', materialized: 1}")));
+}
+
 TEST(CollectionOptions, UnknownTopLevelOptionFailsToParse) {
     CollectionOptions options;
     auto status = options.parse(fromjson("{invalidOption: 1}"));
@@ -333,4 +346,18 @@ TEST(CollectionOptions, ParseUUID) {
     // Check that a collection options containing a UUID passes validation.
     ASSERT_OK(options.validateForStorage());
 }
+
+TEST(CollectionOptions, ParseIndexesIncomplete) {
+    CollectionOptions options;
+    ASSERT_NOT_OK(options.parse(BSON("indexesIncomplete" << true)));
+    ASSERT_FALSE(options.indexesIncomplete);
+
+    ASSERT_OK(options.parse(BSON("indexesIncomplete" << true), CollectionOptions::parseForStorage));
+    ASSERT_TRUE(options.indexesIncomplete);
+    ASSERT_BSONOBJ_EQ(BSON("indexesIncomplete" << true), options.toBSON());
+
+    // A cleared mark is not written out.
+    options.indexesIncomplete = false;
+    ASSERT_BSONOBJ_EQ(BSONObj(), options.toBSON());
+}
 }  // namespace mongo
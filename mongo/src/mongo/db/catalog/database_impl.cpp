@@ -70,6 +70,7 @@
 #include "mongo/db/storage/storage_engine.h"
 #include "mongo/db/storage/storage_options.h"
 #include "mongo/db/system_index.h"
+#include "mongo/db/views/materialized_view_registry.h"
 #include "mongo/db/views/view_catalog.h"
 #include "mongo/platform/random.h"
 #include "mongo/stdx/memory.h"
@@ -472,8 +473,18 @@ void DatabaseImpl::getStats(OperationContext* opCtx, BSONObjBuilder* output, dou
 
 //viewأԺпٷ
 Status DatabaseImpl::dropView(OperationContext* opCtx, StringData fullns) {
-    Status status = _views.dropView(opCtx, NamespaceString(fullns));
+    const NamespaceString viewNss(fullns);
+    Status status = _views.dropView(opCtx, viewNss);
     Top::get(opCtx->getServiceContext()).collectionDropped(fullns);
+    if (!status.isOK()) {
+        return status;
+    }
+
+    // A materialized view takes its backing collection with it.
+    const auto backingNss = MaterializedViewRegistry::backingNamespace(viewNss);
+    if (getCollection(opCtx, backingNss)) {
+        return dropCollectionEvenIfSystem(opCtx, backingNss, {});
+    }
     return status;
 }
 
@@ -858,7 +869,12 @@ Status DatabaseImpl::createView(OperationContext* opCtx,
         return Status(ErrorCodes::InvalidNamespace,
                       str::stream() << "invalid namespace name for a view: " + nss.toString());
 
-    return _views.createView(opCtx, nss, viewOnNss, BSONArray(options.pipeline), options.collation);
+    return _views.createView(opCtx,
+                             nss,
+                             viewOnNss,
+                             BSONArray(options.pipeline),
+                             options.collation,
+                             options.materialized);
 }
 
 //AutoGetDb::AutoGetDbAutoGetOrCreateDb::AutoGetOrCreateDb->DatabaseHolderImpl::getDatabaseHolderImpl._dbsһȡDatabase
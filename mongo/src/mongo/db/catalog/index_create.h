@@ -39,6 +39,7 @@
 #include "mongo/db/catalog/index_catalog_impl.h"
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/record_id.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/functional.h"
 
 namespace mongo {
@@ -47,6 +48,10 @@ class BSONObj;
 class Collection;
 class OperationContext;
 
+// The amount of memory the bulk builders of the indexes built together may use between them before
+// they spill their keys to disk.
+extern AtomicInt32 maxIndexBuildMemoryUsageMegabytes;
+
 /**
  * Builds one or more indexes.
  *
@@ -0,0 +1,306 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kCommand
+
+#include "mongo/platform/basic.h"
+
+#include <string>
+#include <vector>
+
+#include "mongo/db/bson/dotted_path_support.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/dbhelpers.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/index_names.h"
+#include "mongo/db/query/collection_statistics.h"
+#include "mongo/db/query/histogram.h"
+#include "mongo/db/repl/replication_coordinator_global.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/platform/random.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+using std::string;
+using std::stringstream;
+
+namespace {
+
+const long long kDefaultSampleSize = 10000;
+const long long kMaxSampleSize = 1000 * 1000;
+const long long kDefaultNumBuckets = 64;
+const long long kMaxNumBuckets = 1000;
+
+/**
+ * Returns up to 'sampleSize' documents of 'collection', chosen at random. Uses a random cursor
+ * when the storage engine has one and the collection is larger than the sample, and otherwise
+ * reservoir-samples a full scan.
+ */
+std::vector<BSONObj> sampleDocuments(OperationContext* opCtx,
+                                     Collection* collection,
+                                     long long sampleSize) {
+    std::vector<BSONObj> sample;
+    RecordStore* rs = collection->getRecordStore();
+
+    if (rs->numRecords(opCtx) > sampleSize) {
+        if (auto cursor = rs->getRandomCursor(opCtx)) {
+            while (static_cast<long long>(sample.size()) < sampleSize) {
+                auto record = cursor->next();
+                if (!record) {
+                    break;
+                }
+                sample.push_back(record->data.toBson().getOwned());
+                if (sample.size() % 1024 == 0) {
+                    opCtx->checkForInterrupt();
+                }
+            }
+            return sample;
+        }
+    }
+
+    PseudoRandom random(Date_t::now().asInt64());
+    auto cursor = rs->getCursor(opCtx);
+    long long seen = 0;
+    while (auto record = cursor->next()) {
+        ++seen;
+        if (static_cast<long long>(sample.size()) < sampleSize) {
+            sample.push_back(record->data.toBson().getOwned());
+        } else {
+            const long long slot = random.nextInt64(seen);
+            if (slot < sampleSize) {
+                sample[slot] = record->data.toBson().getOwned();
+            }
+        }
+        if (seen % 1024 == 0) {
+            opCtx->checkForInterrupt();
+        }
+    }
+    return sample;
+}
+
+/**
+ * The leading field of every btree index of 'collection', which are the fields whose statistics
+ * the planner can use.
+ */
+std::vector<std::string> getIndexedFields(OperationContext* opCtx, Collection* collection) {
+    std::set<std::string> fields;
+    IndexCatalog::IndexIterator ii = collection->getIndexCatalog()->getIndexIterator(opCtx, false);
+    while (ii.more()) {
+        const IndexDescriptor* desc = ii.next();
+        if (IndexNames::nameToType(desc->getAccessMethodName()) != INDEX_BTREE) {
+            continue;
+        }
+        fields.insert(desc->keyPattern().firstElementFieldName());
+    }
+    return std::vector<std::string>(fields.begin(), fields.end());
+}
+
+/**
+ * Builds the histogram of 'field' over 'sample', collecting values the way a btree index on
+ * 'field' would generate keys.
+ */
+Histogram buildHistogram(const std::vector<BSONObj>& sample,
+                         const std::string& field,
+                         size_t numBuckets,
+                         double scale) {
+    std::vector<BSONObj> values;
+    values.reserve(sample.size());
+    for (const BSONObj& doc : sample) {
+        BSONElementSet elements;
+        dotted_path_support::extractAllElementsAlongPath(doc, field, elements);
+        if (elements.empty()) {
+            values.push_back(BSON("" << BSONNULL));
+            continue;
+        }
+        for (const BSONElement& elem : elements) {
+            BSONObjBuilder bob;
+            bob.appendAs(elem, "");
+            values.push_back(bob.obj());
+        }
+    }
+    return Histogram::build(&values, numBuckets, scale);
+}
+
+}  // namespace
+
+/**
+ * { analyze: <collection>, fields: [<field>, ...], sampleSize: <n>, numBuckets: <n> }
+ *
+ * Samples the collection, builds a histogram for each field and stores them in
+ * <db>.system.statistics for the query planner. Without 'fields', analyzes the leading field of
+ * each index.
+ */
+class AnalyzeCmd : public BasicCommand {
+public:
+    AnalyzeCmd() : BasicCommand("analyze") {}
+
+    virtual bool slaveOk() const {
+        return false;
+    }
+
+    virtual void help(stringstream& h) const {
+        h << "Gather statistics on the values of fields of a collection for the query planner.\n"
+             "{ analyze: <collection>, fields: [<field>, ...], sampleSize: <n>, numBuckets: <n> }"
+             "\nBy default the leading field of each index is analyzed.";
+    }
+
+    virtual bool supportsWriteConcern(const BSONObj& cmd) const override {
+        return false;
+    }
+
+    virtual void addRequiredPrivileges(const std::string& dbname,
+                                       const BSONObj& cmdObj,
+                                       std::vector<Privilege>* out) {
+        ActionSet actions;
+        actions.addAction(ActionType::planCacheWrite);
+        out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+    }
+
+    bool run(OperationContext* opCtx,
+             const string& dbname,
+             const BSONObj& cmdObj,
+             BSONObjBuilder& result) {
+        const NamespaceString nss(parseNsCollectionRequired(dbname, cmdObj));
+        if (!nss.isNormal()) {
+            return appendCommandStatus(
+                result,
+                {ErrorCodes::InvalidNamespace, "Can only analyze a regular collection"});
+        }
+
+        long long sampleSize = kDefaultSampleSize;
+        if (BSONElement elem = cmdObj["sampleSize"]) {
+            if (!elem.isNumber() || elem.safeNumberLong() <= 0 ||
+                elem.safeNumberLong() > kMaxSampleSize) {
+                return appendCommandStatus(result,
+                                           {ErrorCodes::BadValue,
+                                            str::stream() << "sampleSize must be a number between "
+                                                             "1 and "
+                                                          << kMaxSampleSize});
+            }
+            sampleSize = elem.safeNumberLong();
+        }
+
+        long long numBuckets = kDefaultNumBuckets;
+        if (BSONElement elem = cmdObj["numBuckets"]) {
+            if (!elem.isNumber() || elem.safeNumberLong() <= 0 ||
+                elem.safeNumberLong() > kMaxNumBuckets) {
+                return appendCommandStatus(result,
+                                           {ErrorCodes::BadValue,
+                                            str::stream() << "numBuckets must be a number between "
+                                                             "1 and "
+                                                          << kMaxNumBuckets});
+            }
+            numBuckets = elem.safeNumberLong();
+        }
+
+        std::vector<std::string> fields;
+        if (BSONElement elem = cmdObj["fields"]) {
+            if (elem.type() != Array) {
+                return appendCommandStatus(
+                    result, {ErrorCodes::TypeMismatch, "fields must be an array of field names"});
+            }
+            for (auto&& fieldElem : elem.Obj()) {
+                if (fieldElem.type() != String || fieldElem.valueStringData().empty()) {
+                    return appendCommandStatus(
+                        result,
+                        {ErrorCodes::TypeMismatch, "fields must be an array of field names"});
+                }
+                fields.push_back(fieldElem.str());
+            }
+        }
+
+        auto stats = std::make_shared<CollectionStatistics>();
+        size_t numSampled = 0;
+        {
+            AutoGetCollectionForRead autoColl(opCtx, nss);
+            Collection* collection = autoColl.getCollection();
+            if (!collection) {
+                return appendCommandStatus(result,
+                                           {ErrorCodes::NamespaceNotFound, "ns not found"});
+            }
+
+            if (fields.empty()) {
+                fields = getIndexedFields(opCtx, collection);
+            }
+
+            stats->numRecords = collection->numRecords(opCtx);
+            stats->analyzedAt = Date_t::now();
+
+            const std::vector<BSONObj> sample = sampleDocuments(opCtx, collection, sampleSize);
+            numSampled = sample.size();
+            const double scale =
+                numSampled ? static_cast<double>(stats->numRecords) / numSampled : 1.0;
+            for (const std::string& field : fields) {
+                stats->histograms[field] = buildHistogram(sample, field, numBuckets, scale);
+            }
+        }
+
+        BSONObjBuilder statsDoc;
+        statsDoc.append("_id", nss.coll());
+        statsDoc.appendElements(stats->toBSON());
+        const BSONObj statsObj = statsDoc.obj();
+        const NamespaceString statsNss = StatisticsCatalog::statisticsNamespace(nss.db());
+
+        writeConflictRetry(opCtx, "analyze", statsNss.ns(), [&] {
+            AutoGetOrCreateDb autoDb(opCtx, statsNss.db(), MODE_X);
+            uassert(ErrorCodes::NotMaster,
+                    str::stream() << "Not primary while analyzing " << nss.ns(),
+                    repl::getGlobalReplicationCoordinator()->canAcceptWritesFor(opCtx, statsNss));
+            Helpers::upsert(opCtx, statsNss.ns(), statsObj);
+        });
+
+        // The write invalidated the cached entry; install the new statistics directly rather than
+        // waiting for the next query to read them back.
+        StatisticsCatalog::get(opCtx)->set(nss, stats);
+
+        LOG(1) << "analyzed " << nss.ns() << ": sampled " << numSampled << " of "
+               << stats->numRecords << " documents";
+
+        result.append("ns", nss.ns());
+        result.appendNumber("numRecords", stats->numRecords);
+        result.appendNumber("sampledDocuments", static_cast<long long>(numSampled));
+        BSONArrayBuilder fieldsBuilder(result.subarrayStart("fields"));
+        for (auto&& entry : stats->histograms) {
+            BSONObjBuilder fieldBuilder(fieldsBuilder.subobjStart());
+            fieldBuilder.append("field", entry.first);
+            fieldBuilder.append("distinctValues", entry.second.distinctValues());
+            fieldBuilder.appendNumber("buckets",
+                                      static_cast<long long>(entry.second.buckets().size()));
+        }
+        fieldsBuilder.doneFast();
+        return true;
+    }
+} analyzeCmd;
+
+}  // namespace mongo
@@ -89,6 +89,8 @@
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/storage_stats.h"
+#include "mongo/db/views/materialized_view_registry.h"
+#include "mongo/db/views/view_catalog.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/grid.h"
@@ -942,7 +944,28 @@ public:
         }
 
         result.append("ns", nss.ns());
-        Status status = appendCollectionStorageStats(opCtx, nss, jsobj, &result);
+
+        // A materialized view reports its refresh state and the storage of its backing
+        // collection.
+        NamespaceString statsNss = nss;
+        {
+            AutoGetDb autoDb(opCtx, nss.db(), MODE_IS);
+            auto view = autoDb.getDb()
+                ? autoDb.getDb()->getViewCatalog()->lookup(opCtx, nss.ns())
+                : nullptr;
+            if (view && view->isMaterialized()) {
+                BSONObjBuilder materializedBuilder(result.subobjStart("materialized"));
+                MaterializedViewRegistry::get(opCtx)->appendStats(nss, &materializedBuilder);
+                materializedBuilder.doneFast();
+
+                statsNss = MaterializedViewRegistry::backingNamespace(nss);
+                if (!autoDb.getDb()->getCollection(opCtx, statsNss)) {
+                    return true;
+                }
+            }
+        }
+
+        Status status = appendCollectionStorageStats(opCtx, statsNss, jsobj, &result);
         if (!status.isOK()) {
             errmsg = status.reason();
             return false;
@@ -141,6 +141,9 @@ BSONObj buildViewBson(const ViewDefinition& view) {
     if (view.defaultCollator()) {
         optionsBuilder.append("collation", view.defaultCollator()->getSpec().toBSON());
     }
+    if (view.isMaterialized()) {
+        optionsBuilder.appendBool("materialized", true);
+    }
     optionsBuilder.doneFast();
 
     BSONObj info = BSON("readOnly" << true);
@@ -179,6 +182,9 @@ BSONObj buildCollectionBson(OperationContext* opCtx,
     // unsettable read-only property, so put it in the 'info' section.
     auto uuid = options.uuid;
     options.uuid.reset();
+
+    // Neither is the mark left by an unfinished bulk load, which the create command would reject.
+    options.indexesIncomplete = false;
     b.append("options", options.toBSON());
 
     BSONObjBuilder infoBuilder;
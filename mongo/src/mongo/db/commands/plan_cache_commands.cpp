@@ -670,6 +670,7 @@ Status PlanCacheListPlans::list(OperationContext* opCtx,
         // multi plan runner.
         BSONObjBuilder reasonBob(planBob.subobjStart("reason"));
         reasonBob.append("score", entry->decision->scores[i]);
+        reasonBob.append("discarded", i + entry->decision->numDiscarded >= numPlans);
         BSONObjBuilder statsBob(reasonBob.subobjStart("stats"));
         PlanStageStats* stats = entry->decision->stats[i].get();
         if (stats) {
@@ -699,6 +700,10 @@ Status PlanCacheListPlans::list(OperationContext* opCtx,
     // Append the time the entry was inserted into the plan cache.
     bob->append("timeOfCreation", entry->timeOfCreation);
 
+    // Append how long it took to choose the plans and how many were cut from the trial period.
+    bob->append("planningTimeMicros", entry->decision->planningTimeMicros);
+    bob->appendNumber("discardedPlans", entry->decision->numDiscarded);
+
     return Status::OK();
 }
 
@@ -136,6 +136,14 @@ public:
             return false;
         }
 
+        if (collection->infoCache()->indexesIncomplete()) {
+            return appendCommandStatus(
+                result,
+                {ErrorCodes::BackgroundOperationInProgressForNamespace,
+                 str::stream() << "Cannot validate " << nss.ns()
+                               << " while its indexes are being bulk loaded"});
+        }
+
         // Omit background validation logic until it is fully implemented and vetted.
         const bool background = false;
         /*
@@ -1004,6 +1004,35 @@ TEST_F(DConcurrencyTestFixture, Throttling) {
     ASSERT(!overlongWait);
 }
 
+TEST_F(DConcurrencyTestFixture, ThrottlingRecordsTimeQueuedForTicket) {
+    auto clientOpctxPairs = makeKClientsWithLockers<DefaultLockerImpl>(2);
+    auto opctx1 = clientOpctxPairs[0].second.get();
+    auto opctx2 = clientOpctxPairs[1].second.get();
+    UseGlobalThrottling throttle(opctx1, 1);
+
+    ASSERT_EQ(Microseconds(0), opctx2->lockState()->getTimeQueuedForTicket());
+
+    const int timeoutMillis = 20;
+    {
+        Lock::GlobalRead R1(opctx1, 0);
+        ASSERT(R1.isLocked());
+
+        // The only ticket is held by opctx1, so opctx2 queues until its acquisition times out.
+        Lock::GlobalRead R2(opctx2, timeoutMillis);
+        ASSERT(!R2.isLocked());
+    }
+    ASSERT_GTE(opctx2->lockState()->getTimeQueuedForTicket(), Milliseconds(timeoutMillis));
+
+    // An uncontended acquisition does not add meaningfully to the total.
+    const auto queuedBefore = opctx1->lockState()->getTimeQueuedForTicket();
+    {
+        Lock::GlobalRead R1(opctx1, 0);
+        ASSERT(R1.isLocked());
+    }
+    ASSERT_LT(opctx1->lockState()->getTimeQueuedForTicket() - queuedBefore,
+              Milliseconds(timeoutMillis));
+}
+
 
 // These tests exercise single- and multi-threaded performance of uncontended lock acquisition. It
 // is neither practical nor useful to run them on debug builds.
@@ -43,6 +43,8 @@
 #include "mongo/util/debug_util.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 namespace {
@@ -466,7 +468,12 @@ LockResult LockerImpl<IsForMMAPV1>::_lockGlobalBegin(LockMode mode, Milliseconds
 		//S  IS  IXÿҪȫ128źƣҲֻ128߳ͬʱ
 		//⼸͵
 		
-            _clientState.store(reader ? kQueuedReader : kQueuedWriter); 
+            _clientState.store(reader ? kQueuedReader : kQueuedWriter);
+            const unsigned long long queuedAt = curTimeMicros64();
+            ON_BLOCK_EXIT([&] {
+                _timeQueuedForTicketMicros.fetchAndAdd(
+                    static_cast<long long>(curTimeMicros64() - queuedAt));
+            });
 			//ȴڼΪQueued״̬ȡΪActive״̬ȡʱΪinactive
             if (timeout == Milliseconds::max()) {
 				//TicketHolder::waitForTicketһֱź
@@ -111,6 +111,10 @@ public:
 
     stdx::thread::id getThreadId() const override;
 
+    Microseconds getTimeQueuedForTicket() const override {
+        return Microseconds(_timeQueuedForTicketMicros.load());
+    }
+
     virtual LockResult lockGlobal(LockMode mode);
     //shutdownTaskе   
     virtual LockResult lockGlobalBegin(LockMode mode, Milliseconds timeout) { 
@@ -257,6 +261,10 @@ private:
     //ֵLockerImpl<IsForMMAPV1>::_lockGlobalBegin
     AtomicWord<ClientState> _clientState{kInactive};
 
+    // Total time spent waiting on a TicketHolder in _lockGlobalBegin. Atomic because $currentOp
+    // reads it while the owning thread may be queued.
+    AtomicInt64 _timeQueuedForTicketMicros{0};
+
     // Track the thread who owns the lock for debugging purposes
     stdx::thread::id _threadId;
 
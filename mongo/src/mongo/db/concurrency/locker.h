@@ -118,6 +118,12 @@ public:
      */
     virtual stdx::thread::id getThreadId() const = 0;
 
+    /**
+     * Returns the cumulative time this locker has spent queued waiting for a global lock ticket
+     * (see setGlobalThrottling). May be called from a thread other than the owning one.
+     */
+    virtual Microseconds getTimeQueuedForTicket() const = 0;
+
     /**
      * This should be the first method invoked for a particular Locker object. It acquires the
      * Global lock in the specified mode and effectively indicates the mode of the operation.
@@ -57,6 +57,10 @@ public:
         invariant(false);
     }
 
+    Microseconds getTimeQueuedForTicket() const override {
+        return Microseconds(0);
+    }
+
     virtual LockResult lockGlobal(LockMode mode) {
         invariant(false);
     }
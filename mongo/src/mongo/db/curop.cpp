@@ -34,14 +34,22 @@
 
 #include "mongo/db/curop.h"
 
+#include <algorithm>
+
+#if defined(__linux__)
+#include <pthread.h>
+#endif
+
 #include "mongo/base/disallow_copying.h"
 #include "mongo/bson/mutable/document.h"
 #include "mongo/db/client.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/concurrency/locker.h"
 #include "mongo/db/json.h"
 #include "mongo/db/query/getmore_request.h"
 #include "mongo/db/query/plan_summary_stats.h"
+#include "mongo/db/storage/recovery_unit.h"
 #include "mongo/rpc/metadata/client_metadata.h"
 #include "mongo/rpc/metadata/client_metadata_ismaster.h"
 #include "mongo/util/log.h"
@@ -68,6 +76,20 @@ const std::vector<const char*> kDollarQueryModifiers = {
     "$maxTimeMS",
 };
 
+#if defined(__linux__)
+/**
+ * Reads a per-thread CPU-time clock obtained from pthread_getcpuclockid(). Returns -1 if the clock
+ * cannot be read.
+ */
+long long readCpuClockMicros(clockid_t clock) {
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0) {
+        return -1;
+    }
+    return static_cast<long long>(ts.tv_sec) * 1000 * 1000 + ts.tv_nsec / 1000;
+}
+#endif
+
 }  // namespace
 
 BSONObj upconvertQueryEntry(const BSONObj& query,
@@ -231,6 +253,12 @@ CurOp::CurOp(OperationContext* opCtx) : CurOp(opCtx, &_curopStack(opCtx)) {}
 CurOp::CurOp(OperationContext* opCtx, CurOpStack* stack) : _stack(stack) {
     if (opCtx) {
         _stack->push(opCtx, this);
+        if (opCtx->lockState()) {
+            _startTicketWait = opCtx->lockState()->getTimeQueuedForTicket();
+        }
+        if (opCtx->recoveryUnit()) {
+            _startStorageStats = opCtx->recoveryUnit()->getOperationStatistics();
+        }
     } else {
         _stack->push_nolock(this);
     }
@@ -273,7 +301,54 @@ void CurOp::setNS_inlock(StringData ns) {
 void CurOp::ensureStarted() { //runQueryл
     if (_start == 0) {
         _start = curTimeMicros64();
+#if defined(__linux__)
+        if (pthread_getcpuclockid(pthread_self(), &_cpuClock) == 0) {
+            _startCpuTime = readCpuClockMicros(_cpuClock);
+        }
+#endif
+    }
+}
+
+void CurOp::done() {
+    _end = curTimeMicros64();
+#if defined(__linux__)
+    if (_startCpuTime >= 0) {
+        _endCpuTime = readCpuClockMicros(_cpuClock);
+    }
+#endif
+}
+
+Microseconds CurOp::cpuTime() const {
+    if (_startCpuTime < 0) {
+        return Microseconds{-1};
+    }
+
+    long long now = _endCpuTime;
+#if defined(__linux__)
+    if (!isDone()) {
+        now = readCpuClockMicros(_cpuClock);
     }
+#endif
+    if (now < 0) {
+        return Microseconds{-1};
+    }
+    return Microseconds{now - _startCpuTime};
+}
+
+Microseconds CurOp::ticketWaitTime(OperationContext* opCtx) const {
+    return opCtx->lockState()->getTimeQueuedForTicket() - _startTicketWait;
+}
+
+RecoveryUnit::OperationStatistics CurOp::storageStatistics(OperationContext* opCtx) const {
+    auto stats = opCtx->recoveryUnit()->getOperationStatistics();
+
+    // A recovery unit swapped in since this CurOp was created counts from zero.
+    if (stats.bytesRead >= _startStorageStats.bytesRead &&
+        stats.bytesWritten >= _startStorageStats.bytesWritten) {
+        stats.bytesRead -= _startStorageStats.bytesRead;
+        stats.bytesWritten -= _startStorageStats.bytesWritten;
+    }
+    return stats;
 }
 
 void CurOp::enter_inlock(const char* ns, boost::optional<int> dbProfileLevel) {
@@ -411,6 +486,17 @@ void CurOp::reportState(BSONObjBuilder* builder, bool truncateOps) {
     }
 
     builder->append("numYields", _numYields);
+
+    if (_debug.documentKeyLookupBatches > 0) {
+        builder->appendNumber("documentKeyLookupBatches", _debug.documentKeyLookupBatches);
+        builder->appendNumber("documentKeyLookups", _debug.documentKeyLookups);
+        builder->appendNumber("documentKeyLookupMillis", _debug.documentKeyLookupMillis);
+    }
+
+    const auto cpu = cpuTime();
+    if (cpu >= Microseconds{0}) {
+        builder->append("cpuTimeMicros", durationCount<Microseconds>(cpu));
+    }
 }
 
 namespace {
@@ -424,6 +510,26 @@ StringData getProtoString(int op) {
     }
     MONGO_UNREACHABLE;
 }
+
+void appendGraphLookupDepthStats(const std::vector<OpDebug::GraphLookupDepthStats>& stats,
+                                 BSONArrayBuilder* builder) {
+    for (size_t depth = 0; depth < stats.size(); ++depth) {
+        BSONObjBuilder entry(builder->subobjStart());
+        entry.appendNumber("depth", static_cast<long long>(depth));
+        entry.appendNumber("frontierValues", stats[depth].frontierValues);
+        entry.appendNumber("cacheHits", stats[depth].cacheHits);
+        entry.appendNumber("queries", stats[depth].queries);
+        entry.appendNumber("documentsReturned", stats[depth].documentsReturned);
+        entry.appendNumber("documentsAdded", stats[depth].documentsAdded);
+    }
+}
+
+void appendFacetExecutionMillis(const std::vector<std::pair<std::string, long long>>& millis,
+                                BSONObjBuilder* builder) {
+    for (auto&& facet : millis) {
+        builder->appendNumber(facet.first, facet.second);
+    }
+}
 }  // namespace
 
 //ԲοOpDebug::report   
@@ -530,6 +636,34 @@ string OpDebug::report(Client* client,
         s << " writeConflicts:" << writeConflicts;
     }
 
+    OPDEBUG_TOSTRING_HELP(cpuTimeMicros);
+
+    if (ticketWaitMicros > 0) {
+        s << " ticketWaitMicros:" << ticketWaitMicros;
+    }
+
+    if (!storageStats.isEmpty()) {
+        s << " storage:" << storageStats.toString();
+    }
+
+    if (documentKeyLookupBatches > 0) {
+        s << " documentKeyLookupBatches:" << documentKeyLookupBatches;
+        s << " documentKeyLookups:" << documentKeyLookups;
+        s << " documentKeyLookupMillis:" << documentKeyLookupMillis;
+    }
+
+    if (!graphLookupDepthStats.empty()) {
+        BSONArrayBuilder depths;
+        appendGraphLookupDepthStats(graphLookupDepthStats, &depths);
+        s << " graphLookupDepths:" << depths.arr().toString();
+    }
+
+    if (!facetExecutionMillis.empty()) {
+        BSONObjBuilder facets;
+        appendFacetExecutionMillis(facetExecutionMillis, &facets);
+        s << " facetExecutionMillis:" << facets.obj().toString();
+    }
+
     if (!exceptionInfo.isOK()) {
         s << " exception: " << redact(exceptionInfo.reason());
         s << " code:" << exceptionInfo.code();
@@ -626,6 +760,32 @@ void OpDebug::append(const CurOp& curop,
         b.appendNumber("writeConflicts", writeConflicts);
     }
 
+    OPDEBUG_APPEND_NUMBER(cpuTimeMicros);
+
+    if (ticketWaitMicros > 0) {
+        b.appendNumber("ticketWaitMicros", ticketWaitMicros);
+    }
+
+    if (!storageStats.isEmpty()) {
+        b.append("storage", storageStats);
+    }
+
+    if (documentKeyLookupBatches > 0) {
+        b.appendNumber("documentKeyLookupBatches", documentKeyLookupBatches);
+        b.appendNumber("documentKeyLookups", documentKeyLookups);
+        b.appendNumber("documentKeyLookupMillis", documentKeyLookupMillis);
+    }
+
+    if (!graphLookupDepthStats.empty()) {
+        BSONArrayBuilder depths(b.subarrayStart("graphLookupDepths"));
+        appendGraphLookupDepthStats(graphLookupDepthStats, &depths);
+    }
+
+    if (!facetExecutionMillis.empty()) {
+        BSONObjBuilder facets(b.subobjStart("facetExecutionMillis"));
+        appendFacetExecutionMillis(facetExecutionMillis, &facets);
+    }
+
     b.appendNumber("numYield", curop.numYields());
 
     {
@@ -662,4 +822,48 @@ void OpDebug::setPlanSummaryMetrics(const PlanSummaryStats& planSummaryStats) {
     replanned = planSummaryStats.replanned;
 }
 
+void OpDebug::addGraphLookupDepthStats(long long depth, const GraphLookupDepthStats& stats) {
+    const size_t index = std::min(static_cast<size_t>(depth), kMaxGraphLookupDepthStats - 1);
+    if (graphLookupDepthStats.size() <= index) {
+        graphLookupDepthStats.resize(index + 1);
+    }
+
+    auto& total = graphLookupDepthStats[index];
+    total.frontierValues += stats.frontierValues;
+    total.cacheHits += stats.cacheHits;
+    total.queries += stats.queries;
+    total.documentsReturned += stats.documentsReturned;
+    total.documentsAdded += stats.documentsAdded;
+}
+
+void OpDebug::addFacetExecutionMillis(StringData facetName, long long millis) {
+    auto facet = std::find_if(facetExecutionMillis.begin(),
+                              facetExecutionMillis.end(),
+                              [&](const auto& entry) { return entry.first == facetName; });
+    if (facet == facetExecutionMillis.end()) {
+        facetExecutionMillis.emplace_back(facetName.toString(), millis);
+    } else {
+        facet->second += millis;
+    }
+}
+
+void OpDebug::setResourceUsageMetrics(OperationContext* opCtx, const CurOp& curop) {
+    cpuTimeMicros = durationCount<Microseconds>(curop.cpuTime());
+    ticketWaitMicros = durationCount<Microseconds>(curop.ticketWaitTime(opCtx));
+
+    const auto storage = curop.storageStatistics(opCtx);
+    if (storage.bytesRead == 0 && storage.bytesWritten == 0) {
+        storageStats = BSONObj();
+        return;
+    }
+
+    BSONObjBuilder storageBuilder;
+    {
+        BSONObjBuilder data(storageBuilder.subobjStart("data"));
+        data.appendNumber("bytesRead", storage.bytesRead);
+        data.appendNumber("bytesWritten", storage.bytesWritten);
+    }
+    storageStats = storageBuilder.obj();
+}
+
 }  // namespace mongo
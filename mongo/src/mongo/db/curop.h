@@ -31,6 +31,10 @@
 
 #pragma once
 
+#if defined(__linux__)
+#include <time.h>
+#endif
+
 #include "mongo/base/disallow_copying.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/cursor_id.h"
@@ -72,6 +76,13 @@ public:
      */
     void setPlanSummaryMetrics(const PlanSummaryStats& planSummaryStats);
 
+    /**
+     * Copies the resources consumed by 'curop' to this OpDebug instance: CPU time, time queued
+     * for a global lock ticket and the storage engine statistics of the operation's recovery
+     * unit. Called once the operation is done(), before it is logged or profiled.
+     */
+    void setResourceUsageMetrics(OperationContext* opCtx, const CurOp& curop);
+
     // -------------------
 
     // basic options
@@ -124,6 +135,45 @@ public:
     long long keysDeleted{0};   // Number of index keys removed.
     long long writeConflicts{0};
 
+    // Resource usage, filled in by setResourceUsageMetrics().
+    long long cpuTimeMicros{-1};  // -1 if per-thread CPU clocks are unavailable
+    long long ticketWaitMicros{0};
+    BSONObj storageStats;  // Owned here.
+
+    // Batched lookups of documents by document key, such as those of change stream post-images.
+    // Only set through CurOp::recordDocumentKeyLookups_inlock(), so that currentOp can report
+    // them while the operation runs.
+    long long documentKeyLookupBatches{0};
+    long long documentKeyLookups{0};
+    long long documentKeyLookupMillis{0};
+
+    // The work done by each level of the breadth-first searches of $graphLookup stages, summed
+    // over all of the stage's input documents. Levels at or beyond kMaxGraphLookupDepthStats are
+    // added to the last entry.
+    struct GraphLookupDepthStats {
+        long long frontierValues{0};     // values to look up at this depth
+        long long cacheHits{0};          // values answered from the stage's cache
+        long long queries{0};            // batched queries run against the 'from' collection
+        long long documentsReturned{0};  // documents the cache and the queries returned
+        long long documentsAdded{0};     // documents not found at a shallower depth
+    };
+    static constexpr size_t kMaxGraphLookupDepthStats = 32;
+    std::vector<GraphLookupDepthStats> graphLookupDepthStats;
+
+    /**
+     * Adds 'stats' to the entry of 'graphLookupDepthStats' for 'depth'.
+     */
+    void addGraphLookupDepthStats(long long depth, const GraphLookupDepthStats& stats);
+
+    // The time each $facet sub-pipeline spent producing its output, by facet name. Facets of the
+    // same name in several $facet stages share an entry.
+    std::vector<std::pair<std::string, long long>> facetExecutionMillis;
+
+    /**
+     * Adds 'millis' to the entry of 'facetExecutionMillis' for 'facetName'.
+     */
+    void addFacetExecutionMillis(StringData facetName, long long millis);
+
     //ֵendQueryOp
     BSONObj execStats;  // Owned here.
 
@@ -296,13 +346,30 @@ public:
         return _start; //_startֵCurOp::ensureStarted
     }
     //ʱ  finishCurOp(delete  update)   performInserts(insert)  ServiceEntryPointMongod::handleRequestִ
-    void done() { //_startֵCurOp::ensureStarted
-        _end = curTimeMicros64();
-    }
+    void done(); //_startֵCurOp::ensureStarted
     bool isDone() const {
         return _end > 0;
     }
 
+    /**
+     * Returns the CPU time consumed by the thread executing this operation between
+     * ensureStarted() and done(), or up to now if the operation has not been marked done. May be
+     * called from another thread while holding the Client lock, as for elapsedTimeTotal().
+     *
+     * Returns Microseconds(-1) if this op has not been started or the platform does not provide
+     * per-thread CPU clocks.
+     */
+    Microseconds cpuTime() const;
+
+    /**
+     * Return the time 'opCtx' has spent queued for a global lock ticket, and the storage engine
+     * statistics of its recovery unit, since this CurOp was created. The counters behind them are
+     * cumulative over the whole OperationContext, which runs one CurOp per statement of a batched
+     * write. Must be called by the thread that owns 'opCtx'.
+     */
+    Microseconds ticketWaitTime(OperationContext* opCtx) const;
+    RecoveryUnit::OperationStatistics storageStatistics(OperationContext* opCtx) const;
+
     /**
      * Stops the operation latency timer from "ticking". Time spent paused is not included in the
      * latencies returned by elapsedTimeExcludingPauses().
@@ -462,6 +529,17 @@ public:
         _planSummary = std::move(summary);
     }
 
+    /**
+     * Records a batch which looked up 'numDocumentKeys' documents by their document keys in
+     * 'elapsed'. Callers must lock the client, since currentOp reports these while the operation
+     * runs.
+     */
+    void recordDocumentKeyLookups_inlock(long long numDocumentKeys, Milliseconds elapsed) {
+        _debug.documentKeyLookupBatches++;
+        _debug.documentKeyLookups += numDocumentKeys;
+        _debug.documentKeyLookupMillis += durationCount<Milliseconds>(elapsed);
+    }
+
 private:
     class CurOpStack;
 
@@ -480,6 +558,16 @@ private:
     //CurOp::doneֵ
     long long _end{0};
 
+#if defined(__linux__)
+    // The CPU-time clock of the thread which started this CurOp. Unlike CLOCK_THREAD_CPUTIME_ID,
+    // it can also be read by other threads for $currentOp.
+    clockid_t _cpuClock{};
+#endif
+
+    // CPU time of the executing thread when this CurOp was started and marked done, or -1.
+    long long _startCpuTime{-1};
+    long long _endCpuTime{-1};
+
     // The time at which this CurOp instance had its timer paused, or 0 if the timer is not
     // currently paused.
     long long _lastPauseTime{0};
@@ -487,6 +575,11 @@ private:
     // The cumulative duration for which the timer has been paused.
     Microseconds _totalPausedDuration{0};
 
+    // The OperationContext's ticket queueing time and storage statistics when this CurOp was
+    // created, subtracted from those reported for it.
+    Microseconds _startTicketWait{0};
+    RecoveryUnit::OperationStatistics _startStorageStats;
+
     // _networkOp represents the network-level op code: OP_QUERY, OP_GET_MORE, OP_COMMAND, etc.
     NetworkOp _networkOp{opInvalid};  // only set this through setNetworkOp_inlock() to keep synced
     // _logicalOp is the logical operation type, ie 'dbQuery' regardless of whether this is an
@@ -92,6 +92,7 @@
 #include "mongo/db/mongod_options.h"
 #include "mongo/db/op_observer_impl.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/pipeline/shared_oplog_scanner.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/repair_database.h"
 #include "mongo/db/repl/drop_pending_collection_reaper.h"
@@ -126,6 +127,7 @@
 #include "mongo/db/storage/storage_options.h"
 #include "mongo/db/system_index.h"
 #include "mongo/db/ttl.h"
+#include "mongo/db/views/materialized_view_refresher.h"
 #include "mongo/db/wire_version.h"
 #include "mongo/executor/network_connection_hook.h"
 #include "mongo/executor/network_interface_factory.h"
@@ -999,6 +1001,8 @@ ExitCode _initAndListen(int listenPort) {
             log() << startupWarningsLog;
         } else {
             startTTLBackgroundJob();
+            startMaterializedViewRefresher();
+            startSharedOplogScanner();
         }
 
         if (replSettings.usingReplSets() || (!replSettings.isMaster() && replSettings.isSlave()) ||
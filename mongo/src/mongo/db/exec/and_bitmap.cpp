@@ -0,0 +1,253 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/and_bitmap.h"
+
+#include "mongo/db/exec/scoped_timer.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+using std::unique_ptr;
+using stdx::make_unique;
+
+namespace {
+
+// Upper limit for the memory used by the bitmaps. Same as the limit of AndHashStage, which holds
+// a lot fewer RecordIds in that space.
+const size_t kDefaultMaxMemUsageBytes = 32 * 1024 * 1024;
+
+// How many RecordIds are added to a bitmap between memory usage checks.
+const size_t kMemCheckInterval = 4096;
+
+}  // namespace
+
+// static
+const char* AndBitmapStage::kStageType = "AND_BITMAP";
+
+AndBitmapStage::AndBitmapStage(OperationContext* opCtx,
+                               WorkingSet* ws,
+                               const Collection* collection)
+    : AndBitmapStage(opCtx, ws, collection, kDefaultMaxMemUsageBytes) {}
+
+AndBitmapStage::AndBitmapStage(OperationContext* opCtx,
+                               WorkingSet* ws,
+                               const Collection* collection,
+                               size_t maxMemUsage)
+    : PlanStage(kStageType, opCtx),
+      _collection(collection),
+      _ws(ws),
+      _currentChild(0),
+      _readingChildren(true),
+      _isEOF(false),
+      _maxMemUsage(maxMemUsage) {}
+
+void AndBitmapStage::addChild(PlanStage* child) {
+    _children.emplace_back(child);
+}
+
+size_t AndBitmapStage::getMemUsage() const {
+    return _intersection.getMemUsage() + _currentChildIds.getMemUsage();
+}
+
+bool AndBitmapStage::isEOF() {
+    return _isEOF;
+}
+
+PlanStage::StageState AndBitmapStage::doWork(WorkingSetID* out) {
+    if (isEOF()) {
+        return PlanStage::IS_EOF;
+    }
+
+    if (_readingChildren) {
+        return readChild(out);
+    }
+
+    // Return the intersection in RecordId order. Each RecordId is removed once returned, so that
+    // later invalidations of it are ignored.
+    RecordId recordId;
+    if (!_intersection.findNext(_nextToReturn, &recordId)) {
+        _isEOF = true;
+        return PlanStage::IS_EOF;
+    }
+    _intersection.remove(recordId);
+    if (recordId == RecordId::max()) {
+        // Nothing can follow the largest RecordId, and its successor would overflow.
+        _isEOF = true;
+    } else {
+        _nextToReturn = RecordId(recordId.repr() + 1);
+    }
+
+    WorkingSetID id = _ws->allocate();
+    WorkingSetMember* member = _ws->get(id);
+    member->recordId = recordId;
+    _ws->transitionToRecordIdAndIdx(id);
+
+    *out = id;
+    return PlanStage::ADVANCED;
+}
+
+PlanStage::StageState AndBitmapStage::readChild(WorkingSetID* out) {
+    WorkingSetID id = WorkingSet::INVALID_ID;
+    StageState childStatus = _children[_currentChild]->work(&id);
+
+    if (PlanStage::ADVANCED == childStatus) {
+        WorkingSetMember* member = _ws->get(id);
+
+        // Maybe the child had an invalidation.  We intersect RecordId(s) so we can't do anything
+        // with this WSM.
+        if (!member->hasRecordId()) {
+            _ws->flagForReview(id);
+            return PlanStage::NEED_TIME;
+        }
+
+        RecordIdBitmap* bitmap = (0 == _currentChild) ? &_intersection : &_currentChildIds;
+        bitmap->add(member->recordId);
+        _ws->free(id);
+
+        if (bitmap->size() % kMemCheckInterval == 0) {
+            Status status = checkMemUsage();
+            if (!status.isOK()) {
+                *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+                return PlanStage::FAILURE;
+            }
+        }
+        return PlanStage::NEED_TIME;
+    } else if (PlanStage::IS_EOF == childStatus) {
+        if (_currentChild > 0) {
+            _intersection.intersectWith(_currentChildIds);
+            _currentChildIds.clear();
+        }
+        _specificStats.bitmapAfterChild.push_back(_intersection.size());
+        _specificStats.memUsage = std::max(_specificStats.memUsage, getMemUsage());
+
+        // If we have nothing to AND with after finishing any child, stop.
+        if (_intersection.empty()) {
+            _isEOF = true;
+            return PlanStage::IS_EOF;
+        }
+
+        if (++_currentChild == _children.size()) {
+            _readingChildren = false;
+        }
+        return PlanStage::NEED_TIME;
+    } else if (PlanStage::FAILURE == childStatus || PlanStage::DEAD == childStatus) {
+        *out = id;
+        // If a stage fails, it may create a status WSM to indicate why it
+        // failed, in which case 'id' is valid.  If ID is invalid, we
+        // create our own error message.
+        if (WorkingSet::INVALID_ID == id) {
+            mongoutils::str::stream ss;
+            ss << "bitmap AND stage failed to read in results from child " << _currentChild;
+            Status status(ErrorCodes::InternalError, ss);
+            *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+        }
+        return childStatus;
+    } else {
+        if (PlanStage::NEED_YIELD == childStatus) {
+            *out = id;
+        }
+
+        return childStatus;
+    }
+}
+
+Status AndBitmapStage::checkMemUsage() {
+    const size_t memUsage = getMemUsage();
+    _specificStats.memUsage = std::max(_specificStats.memUsage, memUsage);
+    if (memUsage > _maxMemUsage) {
+        return Status(ErrorCodes::Overflow,
+                      str::stream() << "bitmap AND stage buffered data usage of " << memUsage
+                                    << " bytes exceeds internal limit of "
+                                    << _maxMemUsage
+                                    << " bytes");
+    }
+    return Status::OK();
+}
+
+void AndBitmapStage::doInvalidate(OperationContext* opCtx,
+                                  const RecordId& dl,
+                                  InvalidationType type) {
+    // A RecordId only read from the child in progress is forgotten: if it was also produced by
+    // the previous children it is in '_intersection' and handled below, otherwise it is not a
+    // result anyway.
+    _currentChildIds.remove(dl);
+
+    // If it's a deletion, we have to forget about the RecordId, and since the AND-ing is by
+    // RecordId we can't continue processing it even with the object.
+    //
+    // If it's a mutation the predicates implied by the AND-ing may no longer be true.
+    //
+    // So, we flag and try to pick it up later.
+    if (!_intersection.remove(dl)) {
+        return;
+    }
+
+    if (_readingChildren) {
+        ++_specificStats.flaggedInProgress;
+    } else {
+        ++_specificStats.flaggedButPassed;
+    }
+
+    WorkingSetID id = _ws->allocate();
+    WorkingSetMember* member = _ws->get(id);
+    member->recordId = dl;
+    _ws->transitionToRecordIdAndIdx(id);
+
+    // The RecordId is about to be invalidated.  Fetch it and clear the RecordId.
+    WorkingSetCommon::fetchAndInvalidateRecordId(opCtx, member, _collection);
+
+    // Add the WSID to the to-be-reviewed list in the WS.
+    _ws->flagForReview(id);
+}
+
+unique_ptr<PlanStageStats> AndBitmapStage::getStats() {
+    _commonStats.isEOF = isEOF();
+
+    _specificStats.memLimit = _maxMemUsage;
+
+    unique_ptr<PlanStageStats> ret = make_unique<PlanStageStats>(_commonStats, STAGE_AND_BITMAP);
+    ret->specific = make_unique<AndBitmapStats>(_specificStats);
+    for (size_t i = 0; i < _children.size(); ++i) {
+        ret->children.emplace_back(_children[i]->getStats());
+    }
+
+    return ret;
+}
+
+const SpecificStats* AndBitmapStage::getSpecificStats() const {
+    return &_specificStats;
+}
+
+}  // namespace mongo
@@ -0,0 +1,118 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/record_id_bitmap.h"
+#include "mongo/db/record_id.h"
+
+namespace mongo {
+
+/**
+ * Reads from N children, each of which must have a valid RecordId, and outputs the RecordIds
+ * produced by all of them in increasing RecordId order.
+ *
+ * Unlike AndHashStage, the children's results are reduced to compressed RecordId bitmaps, see
+ * RecordIdBitmap, and their WSMs are freed as soon as they are read. The output WSMs carry only a
+ * RecordId, with no index key data, so a FETCH with the full filter must sit above this stage.
+ *
+ * Preconditions: Valid RecordId.  More than one child.
+ *
+ * Any RecordId in the intersection that is invalidated before we return it is fetched and added
+ * to the WorkingSet as "flagged for further review", like AndHashStage does.
+ */
+class AndBitmapStage final : public PlanStage {
+public:
+    AndBitmapStage(OperationContext* opCtx, WorkingSet* ws, const Collection* collection);
+
+    /**
+     * For testing only. Allows tests to set memory usage threshold.
+     */
+    AndBitmapStage(OperationContext* opCtx,
+                   WorkingSet* ws,
+                   const Collection* collection,
+                   size_t maxMemUsage);
+
+    void addChild(PlanStage* child);
+
+    /**
+     * Returns memory usage.
+     * For testing only.
+     */
+    size_t getMemUsage() const;
+
+    StageState doWork(WorkingSetID* out) final;
+    bool isEOF() final;
+
+    void doInvalidate(OperationContext* opCtx, const RecordId& dl, InvalidationType type) final;
+
+    StageType stageType() const final {
+        return STAGE_AND_BITMAP;
+    }
+
+    std::unique_ptr<PlanStageStats> getStats() final;
+
+    const SpecificStats* getSpecificStats() const final;
+
+    static const char* kStageType;
+
+private:
+    StageState readChild(WorkingSetID* out);
+
+    // Checks the memory used by the bitmaps against '_maxMemUsage'.
+    Status checkMemUsage();
+
+    const Collection* _collection;
+
+    WorkingSet* _ws;
+
+    // The RecordIds output by every child read so far.
+    RecordIdBitmap _intersection;
+
+    // The RecordIds output by the child currently being read, when it is not the first one.
+    RecordIdBitmap _currentChildIds;
+
+    size_t _currentChild;
+
+    bool _readingChildren;
+
+    // Once every child has been read, the smallest RecordId which may still be returned.
+    RecordId _nextToReturn;
+
+    bool _isEOF;
+
+    AndBitmapStats _specificStats;
+
+    size_t _maxMemUsage;
+};
+
+}  // namespace mongo
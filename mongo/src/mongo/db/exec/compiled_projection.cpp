@@ -0,0 +1,236 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/compiled_projection.h"
+
+#include <cstdint>
+
+#include "mongo/db/exec/working_set.h"
+#include "mongo/stdx/memory.h"
+
+namespace mongo {
+
+namespace {
+const StringData kIdField = "_id"_sd;
+
+// Objects are scanned no further once every child has been seen, as long as there are few enough
+// children to track in a bitmask.
+const size_t kMaxTrackedChildren = 64;
+}  // namespace
+
+// static
+std::unique_ptr<CompiledInclusionProjection> CompiledInclusionProjection::compile(
+    const BSONObj& spec) {
+    bool includeId = true;
+    bool includesOtherFields = false;
+    bool idExplicitlyIncluded = false;
+    for (auto&& elt : spec) {
+        const StringData field = elt.fieldNameStringData();
+        if (field == kIdField) {
+            if (Object == elt.type() || Array == elt.type()) {
+                return nullptr;
+            }
+            includeId = elt.trueValue();
+            idExplicitlyIncluded = includeId;
+            continue;
+        }
+
+        // Exclusions and the $slice, $elemMatch, $meta and positional operators.
+        if (Object == elt.type() || Array == elt.type() || !elt.trueValue() ||
+            field.find('$') != std::string::npos) {
+            return nullptr;
+        }
+
+        // The whole of _id is included whatever its subfields, as ProjectionExec does.
+        if (field.startsWith("_id.")) {
+            return nullptr;
+        }
+        includesOtherFields = true;
+    }
+
+    // A spec of just {_id: 0} excludes rather than includes.
+    if (!includesOtherFields && !idExplicitlyIncluded) {
+        return nullptr;
+    }
+
+    std::unique_ptr<CompiledInclusionProjection> compiled(new CompiledInclusionProjection());
+
+    // ProjectionExec puts _id first when building covered results.
+    if (includeId) {
+        addPath(&compiled->_root, kIdField);
+    }
+
+    for (auto&& elt : spec) {
+        const StringData field = elt.fieldNameStringData();
+        if (field != kIdField && !addPath(&compiled->_root, field)) {
+            return nullptr;
+        }
+    }
+    return compiled;
+}
+
+// static
+bool CompiledInclusionProjection::addPath(Node* node, StringData path) {
+    const size_t dot = path.find('.');
+    const StringData head = path.substr(0, dot);
+    const StringData rest = (dot == std::string::npos) ? StringData() : path.substr(dot + 1);
+
+    Node* child;
+    auto it = node->childIndex.find(head);
+    if (it == node->childIndex.end()) {
+        auto newChild = stdx::make_unique<Node>();
+        newChild->name = head.toString();
+        newChild->path = node->path.empty() ? newChild->name : node->path + '.' + newChild->name;
+        child = newChild.get();
+
+        node->childIndex[head] = node->children.size();
+        node->children.push_back(std::move(newChild));
+        if (rest.empty()) {
+            return true;
+        }
+    } else {
+        child = node->children[it->second].get();
+
+        // Including both a field and one of its subfields, or the same field twice.
+        if (rest.empty() || child->isLeaf()) {
+            return false;
+        }
+    }
+    return addPath(child, rest);
+}
+
+void CompiledInclusionProjection::project(const BSONObj& in, BSONObjBuilder* out) const {
+    projectObject(_root, in, out);
+}
+
+void CompiledInclusionProjection::projectCovered(const WorkingSetMember& member,
+                                                 BSONObjBuilder* out) const {
+    projectCoveredNode(_root, member, out);
+}
+
+// static
+void CompiledInclusionProjection::projectObject(const Node& node,
+                                                const BSONObj& in,
+                                                BSONObjBuilder* out) {
+    // The run of consecutive included elements not yet copied to 'out'.
+    const char* runStart = nullptr;
+    const char* runEnd = nullptr;
+    auto flushRun = [&] {
+        if (runStart != runEnd) {
+            out->bb().appendBuf(runStart, runEnd - runStart);
+        }
+        runStart = runEnd = nullptr;
+    };
+
+    // A document may hold the same field name more than once, so a child only counts towards the
+    // early exit the first time it matches.
+    const bool canStopEarly = node.children.size() <= kMaxTrackedChildren;
+    std::uint64_t childrenSeen = 0;
+    size_t numChildrenSeen = 0;
+    for (auto&& elt : in) {
+        auto it = node.childIndex.find(elt.fieldNameStringData());
+        if (it == node.childIndex.end()) {
+            continue;
+        }
+
+        const Node& child = *node.children[it->second];
+        if (child.isLeaf()) {
+            if (runEnd != elt.rawdata()) {
+                flushRun();
+                runStart = elt.rawdata();
+            }
+            runEnd = elt.rawdata() + elt.size();
+        } else if (Object == elt.type()) {
+            flushRun();
+            BSONObjBuilder subBob(out->subobjStart(elt.fieldNameStringData()));
+            projectObject(child, elt.embeddedObject(), &subBob);
+        } else if (Array == elt.type()) {
+            flushRun();
+            BSONObjBuilder subBob(out->subarrayStart(elt.fieldNameStringData()));
+            projectArray(child, elt.embeddedObject(), &subBob);
+        }
+        // A scalar has none of the subfields being asked for.
+
+        if (canStopEarly) {
+            const std::uint64_t bit = std::uint64_t{1} << it->second;
+            if (!(childrenSeen & bit)) {
+                childrenSeen |= bit;
+                if (++numChildrenSeen == node.children.size()) {
+                    break;
+                }
+            }
+        }
+    }
+    flushRun();
+}
+
+// static
+void CompiledInclusionProjection::projectArray(const Node& node,
+                                               const BSONObj& array,
+                                               BSONObjBuilder* out) {
+    // The subfields are projected out of every object in the array, including those in nested
+    // arrays. Other array elements are dropped.
+    int index = 0;
+    for (auto&& elt : array) {
+        if (Object == elt.type()) {
+            BSONObjBuilder subBob(out->subobjStart(out->numStr(index++)));
+            projectObject(node, elt.embeddedObject(), &subBob);
+        } else if (Array == elt.type()) {
+            BSONObjBuilder subBob(out->subarrayStart(out->numStr(index++)));
+            projectArray(node, elt.embeddedObject(), &subBob);
+        }
+    }
+}
+
+// static
+void CompiledInclusionProjection::projectCoveredNode(const Node& node,
+                                                     const WorkingSetMember& member,
+                                                     BSONObjBuilder* out) {
+    for (auto&& child : node.children) {
+        if (child->isLeaf()) {
+            BSONElement elt;
+            if (member.getFieldDotted(child->path, &elt) && !elt.eoo()) {
+                out->appendAs(elt, child->name);
+            }
+            continue;
+        }
+
+        // Only create the enclosing object if one of its subfields is present.
+        BSONObjBuilder subBob;
+        projectCoveredNode(*child, member, &subBob);
+        BSONObj subObj = subBob.obj();
+        if (!subObj.isEmpty()) {
+            out->append(child->name, subObj);
+        }
+    }
+}
+
+}  // namespace mongo
@@ -0,0 +1,110 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/util/string_map.h"
+
+namespace mongo {
+
+class WorkingSetMember;
+
+/**
+ * An inclusion projection such as {a: 1, 'b.c': 1, _id: 0}, compiled once into a trie of the
+ * included paths so that applying it does not re-interpret the spec for every document.
+ *
+ * Documents are projected in a single pass over their top-level elements. Runs of consecutive
+ * included elements are copied into the output with one buffer append, and the walk ends as soon
+ * as every top-level field of the projection has been seen. Covered results are built straight
+ * from the index key data, creating the enclosing objects of dotted paths as they are reached.
+ *
+ * The output is the same as that of ProjectionExec for the specs that can be compiled: plain
+ * inclusions, possibly dotted, with an optional _id exclusion. Exclusions, $slice, $elemMatch,
+ * $meta and positional projections are left to ProjectionExec.
+ */
+class CompiledInclusionProjection {
+    MONGO_DISALLOW_COPYING(CompiledInclusionProjection);
+
+public:
+    /**
+     * Compiles 'spec', or returns nullptr if it is not an inclusion projection this class handles.
+     */
+    static std::unique_ptr<CompiledInclusionProjection> compile(const BSONObj& spec);
+
+    /**
+     * Appends the fields of 'in' selected by the projection to 'out'.
+     */
+    void project(const BSONObj& in, BSONObjBuilder* out) const;
+
+    /**
+     * Appends the selected fields to 'out', reading them from whatever data 'member' holds, which
+     * may be index keys rather than a document.
+     */
+    void projectCovered(const WorkingSetMember& member, BSONObjBuilder* out) const;
+
+private:
+    struct Node {
+        // Name of this field within its parent, and the full dotted path to it.
+        std::string name;
+        std::string path;
+
+        // Children in the order they first appear in the spec. A node without children is
+        // included whole.
+        std::vector<std::unique_ptr<Node>> children;
+        StringMap<size_t> childIndex;
+
+        bool isLeaf() const {
+            return children.empty();
+        }
+    };
+
+    CompiledInclusionProjection() = default;
+
+    /**
+     * Adds the dotted 'path' under 'node'. Returns false if it collides with a path already
+     * included, such as 'a' and 'a.b'.
+     */
+    static bool addPath(Node* node, StringData path);
+
+    static void projectObject(const Node& node, const BSONObj& in, BSONObjBuilder* out);
+    static void projectArray(const Node& node, const BSONObj& array, BSONObjBuilder* out);
+    static void projectCoveredNode(const Node& node,
+                                   const WorkingSetMember& member,
+                                   BSONObjBuilder* out);
+
+    Node _root;
+};
+
+}  // namespace mongo
@@ -105,17 +105,32 @@ PlanStage::StageState CountScan::doWork(WorkingSetID* out) {
     boost::optional<IndexKeyEntry> entry;
     const bool needInit = !_cursor;
     try {
-        // We don't care about the keys.
-        const auto kWantLoc = SortedDataInterface::Cursor::kWantLoc;
+        // We don't care about the keys, unless we have to check them against the bounds.
+        const bool useBounds = !_params.bounds.fields.empty();
+        const auto parts = useBounds ? SortedDataInterface::Cursor::kKeyAndLoc
+                                     : SortedDataInterface::Cursor::kWantLoc;
 
         if (needInit) {
             // First call to work().  Perform cursor init.
             _cursor = _iam->newCursor(getOpCtx());
-            _cursor->setEndPosition(_params.endKey, _params.endKeyInclusive);
-
-            entry = _cursor->seek(_params.startKey, _params.startKeyInclusive, kWantLoc);
+            if (useBounds) {
+                _checker = stdx::make_unique<IndexBoundsChecker>(
+                    &_params.bounds, _descriptor->keyPattern(), 1);
+                if (!_checker->getStartSeekPoint(&_seekPoint)) {
+                    _commonStats.isEOF = true;
+                    _cursor.reset();
+                    return PlanStage::IS_EOF;
+                }
+                entry = _cursor->seek(_seekPoint, parts);
+            } else {
+                _cursor->setEndPosition(_params.endKey, _params.endKeyInclusive);
+                entry = _cursor->seek(_params.startKey, _params.startKeyInclusive, parts);
+            }
+        } else if (_needSeek) {
+            ++_specificStats.seeks;
+            entry = _cursor->seek(_seekPoint, parts);
         } else {
-            entry = _cursor->next(kWantLoc);
+            entry = _cursor->next(parts);
         }
     } catch (const WriteConflictException&) {
         if (needInit) {
@@ -128,6 +143,22 @@ PlanStage::StageState CountScan::doWork(WorkingSetID* out) {
 
     ++_specificStats.keysExamined;
 
+    _needSeek = false;
+    if (entry && _checker) {
+        switch (_checker->checkKey(entry->key, &_seekPoint)) {
+            case IndexBoundsChecker::VALID:
+                break;
+
+            case IndexBoundsChecker::DONE:
+                entry = boost::none;
+                break;
+
+            case IndexBoundsChecker::MUST_ADVANCE:
+                _needSeek = true;
+                return PlanStage::NEED_TIME;
+        }
+    }
+
     if (!entry) {
         _commonStats.isEOF = true;
         _cursor.reset();
@@ -150,8 +181,15 @@ bool CountScan::isEOF() {
 }
 
 void CountScan::doSaveState() {
-    if (_cursor)
-        _cursor->save();
+    if (!_cursor)
+        return;
+
+    if (_needSeek) {
+        _cursor->saveUnpositioned();
+        return;
+    }
+
+    _cursor->save();
 }
 
 void CountScan::doRestoreState() {
@@ -198,6 +236,9 @@ unique_ptr<PlanStageStats> CountScan::getStats() {
     countStats->startKeyInclusive = _params.startKeyInclusive;
     countStats->endKey = replaceBSONFieldNames(_params.endKey, countStats->keyPattern);
     countStats->endKeyInclusive = _params.endKeyInclusive;
+    if (!_params.bounds.fields.empty()) {
+        countStats->indexBounds = _params.bounds.toBSON();
+    }
 
     ret->specific = std::move(countStats);
 
@@ -34,6 +34,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/query/index_bounds.h"
 #include "mongo/db/record_id.h"
 #include "mongo/platform/unordered_set.h"
 
@@ -54,10 +55,15 @@ struct CountScanParams {
 
     BSONObj endKey;
     bool endKeyInclusive;
+
+    // If not empty, the scan counts the keys within these bounds instead of the keys between
+    // startKey and endKey. The intervals must be oriented for a forward scan.
+    IndexBounds bounds;
 };
 
 /**
- * Used by the count command. Scans an index from a start key to an end key. Creates a
+ * Used by the count command. Scans an index from a start key to an end key, or over a set of
+ * index bounds, seeking past the keys between their intervals. Creates a
  * WorkingSetMember for each matching index key in RID_AND_OBJ state. It has a null record id and an
  * empty object with a null snapshot id rather than real data. Returning real data is unnecessary
  * since all we need is the count.
@@ -101,6 +107,12 @@ private:
     bool _shouldDedup;
     unordered_set<RecordId, RecordId::Hasher> _returned;
 
+    // Only used when scanning over '_params.bounds'. '_needSeek' is set when the last key examined
+    // was outside of the bounds and the cursor must be moved to '_seekPoint'.
+    std::unique_ptr<IndexBoundsChecker> _checker;
+    IndexSeekPoint _seekPoint;
+    bool _needSeek = false;
+
     CountScanParams _params;
 
     CountScanStats _specificStats;
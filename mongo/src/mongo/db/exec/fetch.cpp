@@ -75,6 +75,7 @@ FetchStage::FetchStage(OperationContext* opCtx,
       _collection(collection),
       _ws(ws),
       _filter(filter),
+      _compiledFilter(Filter::compile(filter)),
       _idRetrying(WorkingSet::INVALID_ID) {
     _children.emplace_back(child);
 }
@@ -256,7 +257,7 @@ PlanStage::StageState FetchStage::returnIfMatches(WorkingSetMember* member,
 	//size_t docsExamined; FetchStage::returnIfMatches     keysExaminedIndexScan::doWork
     ++_specificStats.docsExamined; 
 
-    if (Filter::passes(member, _filter)) { 
+    if (Filter::passes(member, _filter, _compiledFilter.get())) {
         *out = memberID;
         return PlanStage::ADVANCED; //Ҫ
     } else {
@@ -28,9 +28,13 @@
 
 #pragma once
 
+#include <memory>
+
 #include "mongo/db/exec/working_set.h"
+#include "mongo/db/matcher/compiled_match_expression.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/matcher/matchable.h"
+#include "mongo/db/query/query_knobs.h"
 
 namespace mongo {
 
@@ -158,6 +162,30 @@ public:
         return filter->matches(&doc, NULL);
     }
 
+    /**
+     * Like passes() above, but evaluates 'compiledFilter' instead of 'filter' when it is non-NULL
+     * and 'wsm' has a full document.
+     */
+    static bool passes(WorkingSetMember* wsm,
+                       const MatchExpression* filter,
+                       const CompiledMatchExpression* compiledFilter) {
+        if (compiledFilter && wsm->hasObj()) {
+            return compiledFilter->matchesBSON(wsm->obj.value());
+        }
+        return passes(wsm, filter);
+    }
+
+    /**
+     * Compiles 'filter' for a stage that evaluates it against many documents. Returns NULL if
+     * there is no filter or compiled filters are disabled.
+     */
+    static std::unique_ptr<CompiledMatchExpression> compile(const MatchExpression* filter) {
+        if (NULL == filter || !internalQueryEnableCompiledMatchExpressions.load()) {
+            return nullptr;
+        }
+        return CompiledMatchExpression::compile(filter);
+    }
+
     static bool passes(const BSONObj& keyData,
                        const BSONObj& keyPattern,
                        const MatchExpression* filter) {
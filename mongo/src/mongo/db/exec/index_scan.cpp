@@ -88,6 +88,8 @@ IndexScan::IndexScan(OperationContext* opCtx,
     _specificStats.isSparse = _params.descriptor->isSparse();
     _specificStats.isPartial = _params.descriptor->isPartial();
     _specificStats.indexVersion = static_cast<int>(_params.descriptor->version());
+    _specificStats.estimatedKeys = _params.estimatedKeys;
+    _specificStats.skipScan = _params.skipScan;
 }
 
 /*
@@ -47,7 +47,13 @@ class WorkingSet;
 
 struct IndexScanParams {
     IndexScanParams()
-        : descriptor(NULL), direction(1), doNotDedup(false), maxScan(0), addKeyMetadata(false) {}
+        : descriptor(NULL),
+          direction(1),
+          doNotDedup(false),
+          maxScan(0),
+          addKeyMetadata(false),
+          estimatedKeys(-1),
+          skipScan(false) {}
 
     const IndexDescriptor* descriptor;
 
@@ -62,6 +68,13 @@ struct IndexScanParams {
 
     // Do we want to add the key as metadata?
     bool addKeyMetadata;
+
+    // Planner estimate of the number of keys examined, or negative if unknown. Only reported.
+    long long estimatedKeys;
+
+    // Whether the planner chose this scan to skip through the distinct values of an unconstrained
+    // leading field. The skipping itself is done by the IndexBoundsChecker. Only reported.
+    bool skipScan;
 };
 
 /**
@@ -49,6 +49,7 @@
 #include "mongo/stdx/memory.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -250,9 +251,12 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
     ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis); 
 
 	//ȡcollectionܼ¼*0.2910000Сɨ10000Σ10000ôɨcollection*0.29Ρ  
+    Timer planningTimer;
     size_t numWorks = getTrialPeriodWorks(getOpCtx(), _collection);
 	//ȡNToReturn  limit internalQueryPlanEvaluationMaxResultsСֵ
     size_t numResults = getTrialPeriodNumToReturn(*_query);
+    size_t nextHalvingRound =
+        static_cast<size_t>(std::max(0, internalQueryPlanEvaluationHalvingWorks.load()));
 
     // Work the plans, stopping when a plan hits EOF or returns some
     // fixed number of results.
@@ -263,7 +267,15 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
         if (!moreToDo) {
             break;
         }
+
+        // Successive halving: at exponentially spaced rounds, stop working the plans that are
+        // clearly losing so that the remaining trial period is spent on the contenders.
+        if (nextHalvingRound > 0 && ix + 1 == nextHalvingRound) {
+            discardLosingPlans();
+            nextHalvingRound *= 2;
+        }
     }
+    _specificStats.numCandidates = _candidates.size();
 
     if (_failure) {
         invariant(WorkingSet::INVALID_ID != _statusMemberId);
@@ -280,6 +292,8 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
 	//PlanRanker::pickBestPlan(const vector<CandidatePlan>& candidates, PlanRankingDecision* why)
 	//MultiPlanStage::doWorkлȡݵʱõ
     _bestPlanIdx = PlanRanker::pickBestPlan(_candidates, ranking.get()); //ѡŵĲѯƻ
+    _specificStats.planningTimeMicros = planningTimer.micros();
+    ranking->planningTimeMicros = _specificStats.planningTimeMicros;
     verify(_bestPlanIdx >= 0 && _bestPlanIdx < static_cast<int>(_candidates.size()));
 
     // Copy candidate order. We will need this to sort candidate stats for explain
@@ -404,7 +418,7 @@ bool MultiPlanStage::workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolic
 	//ѡĲѯƻ_candidatesе
     for (size_t ix = 0; ix < _candidates.size(); ++ix) {
         CandidatePlan& candidate = _candidates[ix];
-        if (candidate.failed) {
+        if (candidate.failed || candidate.discarded) {
             continue;
         }
 
@@ -473,12 +487,64 @@ bool MultiPlanStage::workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolic
                 _failure = true;
                 return false;
             }
+
+            if (_failureCount + _specificStats.numDiscarded == _candidates.size()) {
+                // Every plan still in the running has failed. Go back to the plans discarded
+                // earlier rather than failing the query.
+                LOG(2) << "All remaining candidate plans failed, reviving discarded plans";
+                for (auto& discardedCandidate : _candidates) {
+                    discardedCandidate.discarded = false;
+                }
+                _specificStats.numDiscarded = 0;
+            }
         }
     }
 
     return !doneWorking;
 }
 
+void MultiPlanStage::discardLosingPlans() {
+    std::vector<std::pair<double, size_t>> scoresAndCandidateIndices;
+    for (size_t ix = 0; ix < _candidates.size(); ++ix) {
+        const CandidatePlan& candidate = _candidates[ix];
+        if (candidate.failed || candidate.discarded) {
+            continue;
+        }
+        scoresAndCandidateIndices.emplace_back(
+            PlanRanker::scoreTree(candidate.root->getStats().get()), ix);
+    }
+
+    if (scoresAndCandidateIndices.size() < 2U) {
+        return;
+    }
+
+    std::stable_sort(scoresAndCandidateIndices.begin(),
+                     scoresAndCandidateIndices.end(),
+                     [](const std::pair<double, size_t>& lhs,
+                        const std::pair<double, size_t>& rhs) { return lhs.first > rhs.first; });
+
+    // Keep the top half, and anything tied with the worst plan in it.
+    const size_t numToKeep = (scoresAndCandidateIndices.size() + 1) / 2;
+    const double cutoff = scoresAndCandidateIndices[numToKeep - 1].first;
+    const double epsilon = 1e-10;
+    for (size_t i = numToKeep; i < scoresAndCandidateIndices.size(); ++i) {
+        CandidatePlan& candidate = _candidates[scoresAndCandidateIndices[i].second];
+
+        // A plan with a blocking stage returns nothing until it has consumed its input, so a low
+        // score early in the trial period says little about it.
+        if (scoresAndCandidateIndices[i].first > cutoff - epsilon ||
+            candidate.solution->hasBlockingStage) {
+            continue;
+        }
+
+        LOG(2) << "Discarding losing candidate plan " << scoresAndCandidateIndices[i].second
+               << " with score " << scoresAndCandidateIndices[i].first
+               << ": " << redact(Explain::getPlanSummary(candidate.root));
+        candidate.discarded = true;
+        ++_specificStats.numDiscarded;
+    }
+}
+
 namespace {
 
 void invalidateHelper(OperationContext* opCtx,
@@ -171,6 +171,12 @@ private:
      */
     bool workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolicy);
 
+    /**
+     * Scores the plans that are still being worked and discards those in the bottom half, so
+     * that workAllPlans() skips them for the rest of the trial period.
+     */
+    void discardLosingPlans();
+
     /**
      * Checks whether we need to perform either a timing-based yield or a yield for a document
      * fetch. If so, then uses 'yieldPolicy' to actually perform the yield.
@@ -260,6 +260,28 @@ struct AndHashStats : public SpecificStats {
     size_t memLimit;
 };
 
+struct AndBitmapStats : public SpecificStats {
+    AndBitmapStats() : flaggedButPassed(0), flaggedInProgress(0), memUsage(0), memLimit(0) {}
+
+    SpecificStats* clone() const final {
+        AndBitmapStats* specific = new AndBitmapStats(*this);
+        return specific;
+    }
+
+    // How many RecordIds of the intersection were invalidated after all children were read?
+    size_t flaggedButPassed;
+
+    // How many were invalidated while children were still being read?
+    size_t flaggedInProgress;
+
+    // How many RecordIds are in the intersection after each child?
+    std::vector<size_t> bitmapAfterChild;
+
+    // Peak memory used by the bitmaps.
+    size_t memUsage;
+
+    size_t memLimit;
+};
 
 struct AndSortedStats : public SpecificStats {
     AndSortedStats() : flagged(0) {}
@@ -309,6 +331,19 @@ struct CollectionScanStats : public SpecificStats {
     boost::optional<Timestamp> maxTs;
 };
 
+struct ColumnScanStats : public SpecificStats {
+    SpecificStats* clone() const final {
+        ColumnScanStats* specific = new ColumnScanStats(*this);
+        return specific;
+    }
+
+    // How many documents did we check against our filter?
+    size_t docsTested = 0;
+
+    // The column store fields read by the scan.
+    std::vector<std::string> fields;
+};
+
 struct CountStats : public SpecificStats {
     CountStats() : nCounted(0), nSkipped(0), recordStoreCount(false) {}
 
@@ -334,7 +369,8 @@ struct CountScanStats : public SpecificStats {
           isPartial(false),
           isSparse(false),
           isUnique(false),
-          keysExamined(0) {}
+          keysExamined(0),
+          seeks(0) {}
 
     SpecificStats* clone() const final {
         CountScanStats* specific = new CountScanStats(*this);
@@ -343,6 +379,7 @@ struct CountScanStats : public SpecificStats {
         specific->collation = collation.getOwned();
         specific->startKey = startKey.getOwned();
         specific->endKey = endKey.getOwned();
+        specific->indexBounds = indexBounds.getOwned();
         return specific;
     }
 
@@ -381,6 +418,10 @@ struct CountScanStats : public SpecificStats {
 
     //1Ĳѯ ɨ˶ ɲ鿴 system.profile  keysExamined ֶΣ ֵԽ CPU Խ
     size_t keysExamined;
+
+    // Only set when counting over multi-interval index bounds, which the scan seeks between.
+    BSONObj indexBounds;
+    size_t seeks;
 };
 
 struct DeleteStats : public SpecificStats {
@@ -508,7 +549,9 @@ struct IndexScanStats : public SpecificStats {
           dupsDropped(0),
           seenInvalidated(0),
           keysExamined(0),
-          seeks(0) {}
+          seeks(0),
+          estimatedKeys(-1),
+          skipScan(false) {}
 
     SpecificStats* clone() const final {
         IndexScanStats* specific = new IndexScanStats(*this);
@@ -562,6 +605,13 @@ struct IndexScanStats : public SpecificStats {
 
     // Number of times the index cursor is re-positioned during the execution of the scan.
     size_t seeks; //IndexScan::doWorkֵ
+
+    // Number of keys the planner expected this scan to examine based on collection statistics,
+    // or negative if no statistics were available.
+    long long estimatedKeys;
+
+    // Whether the scan skips through the distinct values of an unconstrained leading field.
+    bool skipScan;
 };
 
 struct LimitStats : public SpecificStats {
@@ -590,6 +640,13 @@ struct MultiPlanStats : public SpecificStats {
     SpecificStats* clone() const final {
         return new MultiPlanStats(*this);
     }
+
+    size_t numCandidates = 0;
+
+    // How many candidates were discarded before the end of the trial period.
+    size_t numDiscarded = 0;
+
+    long long planningTimeMicros = 0;
 };
 
 struct OrStats : public SpecificStats {
@@ -641,6 +698,11 @@ struct SortStats : public SpecificStats {
 
     // The pattern according to which we are sorting.
     BSONObj sortPattern;
+
+    // How many times did we write the buffered data to disk, and how much of it?
+    size_t spills = 0;
+    size_t spilledRecords = 0;
+    size_t spilledBytes = 0;
 };
 
 struct MergeSortStats : public SpecificStats {
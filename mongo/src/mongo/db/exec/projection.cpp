@@ -35,6 +35,7 @@
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/record_id.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/log.h"
@@ -99,6 +100,10 @@ ProjectionStage::ProjectionStage(OperationContext* opCtx,
         } else {
             invariant(ProjectionStageParams::SIMPLE_DOC == params.projImpl);
         }
+
+        if (internalQueryCompileInclusionProjections.load()) {
+            _compiledInclusion = CompiledInclusionProjection::compile(_projObj);
+        }
     }
 }
 
@@ -161,7 +166,11 @@ Status ProjectionStage::transform(WorkingSetMember* member) {
         invariant(member->hasObj());
 
         // Apply the SIMPLE_DOC projection.
-        transformSimpleInclusion(member->obj.value(), _includedFields, bob);
+        if (_compiledInclusion) {
+            _compiledInclusion->project(member->obj.value(), &bob);
+        } else {
+            transformSimpleInclusion(member->obj.value(), _includedFields, bob);
+        }
     } else {
         invariant(ProjectionStageParams::COVERED_ONE_INDEX == _projImpl);
         // We're pulling data out of the key.
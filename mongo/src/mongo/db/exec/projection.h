@@ -135,6 +135,10 @@ private:
     // Has the field names present in the simple projection.
     FieldSet _includedFields;
 
+    // The SIMPLE_DOC projection compiled, unless disabled by
+    // internalQueryCompileInclusionProjections.
+    std::unique_ptr<CompiledInclusionProjection> _compiledInclusion;
+
     //
     // Used for the COVERED_ONE_INDEX path.
     //
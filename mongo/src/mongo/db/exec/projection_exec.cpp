@@ -33,6 +33,7 @@
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/query/collation/collator_interface.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_request.h"
 #include "mongo/db/update/path_support.h"
 #include "mongo/util/mongoutils/str.h"
@@ -181,6 +182,10 @@ ProjectionExec::ProjectionExec(OperationContext* opCtx,
             _arrayOpType = ARRAY_OP_POSITIONAL;
         }
     }
+
+    if (internalQueryCompileInclusionProjections.load()) {
+        _compiled = CompiledInclusionProjection::compile(_source);
+    }
 }
 
 ProjectionExec::~ProjectionExec() {
@@ -265,7 +270,13 @@ Status ProjectionExec::transform(WorkingSetMember* member) const {
     }
 
     BSONObjBuilder bob;
-    if (member->hasObj()) {
+    if (_compiled) {
+        if (member->hasObj()) {
+            _compiled->project(member->obj.value(), &bob);
+        } else {
+            _compiled->projectCovered(*member, &bob);
+        }
+    } else if (member->hasObj()) {
         MatchDetails matchDetails;
 
         // If it's a positional projection we need a MatchDetails.
@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include "mongo/db/exec/compiled_projection.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
@@ -184,6 +185,10 @@ private:
     // that perform matching (e.g. elemMatch projection). If null, the collation is a simple binary
     // compare.
     const CollatorInterface* _collator = nullptr;
+
+    // Set if the spec is a plain inclusion projection, which is then applied without going
+    // through the interpretation above.
+    std::unique_ptr<CompiledInclusionProjection> _compiled;
 };
 
 }  // namespace mongo
@@ -37,7 +37,9 @@
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
 #include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 #include <memory>
 
 using namespace mongo;
@@ -284,6 +286,89 @@ TEST(ProjectionExecTest, TransformNonCoveredDottedProjection) {
                   "{b: {c: 2, d: 3, f: {g: 4, h: 5}}}");
 }
 
+//
+// Compiled inclusion projections.
+//
+
+/**
+ * Checks that 'specStr' compiles, and that applying it to 'objStr' gives 'expectedObjStr' both
+ * compiled and interpreted.
+ */
+void testCompiledTransform(const char* specStr, const char* objStr, const char* expectedObjStr) {
+    const bool oldCompile = internalQueryCompileInclusionProjections.load();
+    ON_BLOCK_EXIT([oldCompile] { internalQueryCompileInclusionProjections.store(oldCompile); });
+
+    ASSERT(CompiledInclusionProjection::compile(fromjson(specStr)));
+    for (bool compile : {true, false}) {
+        internalQueryCompileInclusionProjections.store(compile);
+        testTransform(specStr, "{}", objStr, true, expectedObjStr);
+    }
+}
+
+TEST(ProjectionExecTest, CompiledInclusionTopLevelFields) {
+    testCompiledTransform("{a: 1}", "{_id: 1, a: 2, b: 3}", "{_id: 1, a: 2}");
+    testCompiledTransform("{a: 1, c: 1, _id: 0}", "{_id: 1, a: 2, b: 3, c: 4, d: 5}", "{a: 2, c: 4}");
+    testCompiledTransform("{_id: 1, a: 1, b: 1}", "{b: 1, _id: 2, c: 3, a: 4}", "{b: 1, _id: 2, a: 4}");
+    testCompiledTransform("{a: true}", "{a: {b: 1}, c: 2}", "{a: {b: 1}}");
+    testCompiledTransform("{x: 1}", "{a: 1}", "{}");
+    testCompiledTransform("{_id: 1}", "{_id: 1, a: 2}", "{_id: 1}");
+}
+
+TEST(ProjectionExecTest, CompiledInclusionDottedFields) {
+    testCompiledTransform("{'a.b': 1}", "{a: {b: 1, c: 2}, d: 3}", "{a: {b: 1}}");
+    testCompiledTransform("{'a.b': 1}", "{a: 5}", "{}");
+    testCompiledTransform("{'a.b': 1}", "{a: {c: 1}}", "{a: {}}");
+    testCompiledTransform("{'a.b': 1, 'a.c.d': 1, e: 1, _id: 0}",
+                          "{_id: 0, a: {y: 4, c: {x: 3, d: 2}, b: 1}, e: 5}",
+                          "{a: {c: {d: 2}, b: 1}, e: 5}");
+
+    // Subfields are projected out of every object in an array, nested arrays included, and other
+    // array elements are dropped.
+    testCompiledTransform("{'a.b': 1}",
+                          "{a: [{b: 1, c: 2}, 3, [{b: 4}, 5, []], {c: 6}]}",
+                          "{a: [{b: 1}, [{b: 4}, []], {}]}");
+}
+
+TEST(ProjectionExecTest, CompiledInclusionDuplicateFieldNames) {
+    // A repeated field name must not stop the scan before every projected field has been seen.
+    testCompiledTransform("{a: 1, b: 1}", "{a: 1, a: 2, b: 3}", "{a: 1, a: 2, b: 3}");
+    testCompiledTransform("{'a.c': 1, d: 1, _id: 0}",
+                          "{a: {b: 1}, a: {c: 2}, d: 3}",
+                          "{a: {}, a: {c: 2}, d: 3}");
+}
+
+TEST(ProjectionExecTest, CompiledInclusionCoveredMatchesInterpreted) {
+    const bool oldCompile = internalQueryCompileInclusionProjections.load();
+    ON_BLOCK_EXIT([oldCompile] { internalQueryCompileInclusionProjections.store(oldCompile); });
+
+    BSONObj keyPattern = fromjson("{_id: 1, 'a.b': 1, 'a.d.e': 1, c: 1}");
+    BSONObj keyData = fromjson("{'': 7, '': 8, '': 9, '': 10}");
+    for (bool compile : {true, false}) {
+        internalQueryCompileInclusionProjections.store(compile);
+
+        BSONObj result = transformCovered(fromjson("{c: 1, 'a.b': 1, 'a.x': 1, 'a.d.e': 1}"),
+                                          IndexKeyDatum(keyPattern, keyData, nullptr));
+        ASSERT_BSONOBJ_EQ(result, fromjson("{_id: 7, c: 10, a: {b: 8, d: {e: 9}}}"));
+
+        result = transformCovered(fromjson("{_id: 0, 'x.y': 1, c: 1}"),
+                                  IndexKeyDatum(keyPattern, keyData, nullptr));
+        ASSERT_BSONOBJ_EQ(result, fromjson("{c: 10}"));
+    }
+}
+
+TEST(ProjectionExecTest, CompiledInclusionRejectsOtherProjections) {
+    ASSERT_FALSE(CompiledInclusionProjection::compile(fromjson("{a: 0}")));
+    ASSERT_FALSE(CompiledInclusionProjection::compile(fromjson("{_id: 0}")));
+    ASSERT_FALSE(CompiledInclusionProjection::compile(fromjson("{a: 1, b: 0}")));
+    ASSERT_FALSE(CompiledInclusionProjection::compile(fromjson("{a: 1, 'a.b': 1}")));
+    ASSERT_FALSE(CompiledInclusionProjection::compile(fromjson("{'a.b': 1, a: 1}")));
+    ASSERT_FALSE(CompiledInclusionProjection::compile(fromjson("{'a.$': 1}")));
+    ASSERT_FALSE(CompiledInclusionProjection::compile(fromjson("{'_id.x': 1}")));
+    ASSERT_FALSE(CompiledInclusionProjection::compile(fromjson("{a: {$slice: 1}}")));
+    ASSERT_FALSE(CompiledInclusionProjection::compile(fromjson("{a: {$elemMatch: {b: 1}}}")));
+    ASSERT_FALSE(CompiledInclusionProjection::compile(fromjson("{a: 1, s: {$meta: 'textScore'}}")));
+}
+
 //
 // $meta
 // $meta projections add computed values to the projected object.
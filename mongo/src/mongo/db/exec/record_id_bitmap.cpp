@@ -0,0 +1,286 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/record_id_bitmap.h"
+
+#include <algorithm>
+#include <bitset>
+
+#include "mongo/platform/bits.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+namespace {
+
+int64_t highBits(const RecordId& id) {
+    return id.repr() >> 16;
+}
+
+uint16_t lowBits(const RecordId& id) {
+    return static_cast<uint16_t>(id.repr() & 0xFFFF);
+}
+
+RecordId makeRecordId(int64_t high, uint16_t low) {
+    return RecordId(static_cast<int64_t>((static_cast<uint64_t>(high) << 16) | low));
+}
+
+size_t popCount(uint64_t word) {
+    return std::bitset<64>(word).count();
+}
+
+}  // namespace
+
+bool RecordIdBitmap::Chunk::contains(uint16_t low) const {
+    if (isBitset()) {
+        return bits[low >> 6] & (1ULL << (low & 63));
+    }
+    return std::binary_search(array.begin(), array.end(), low);
+}
+
+bool RecordIdBitmap::Chunk::add(uint16_t low) {
+    if (isBitset()) {
+        uint64_t& word = bits[low >> 6];
+        const uint64_t mask = 1ULL << (low & 63);
+        if (word & mask) {
+            return false;
+        }
+        word |= mask;
+        ++count;
+        return true;
+    }
+
+    // Index scans mostly produce RecordIds in ascending order within a chunk, so check the end of
+    // the array before searching it.
+    if (array.empty() || array.back() < low) {
+        array.push_back(low);
+    } else {
+        auto it = std::lower_bound(array.begin(), array.end(), low);
+        if (*it == low) {
+            return false;
+        }
+        array.insert(it, low);
+    }
+    ++count;
+
+    if (count > kMaxArraySize) {
+        toBitset();
+    }
+    return true;
+}
+
+bool RecordIdBitmap::Chunk::remove(uint16_t low) {
+    if (isBitset()) {
+        uint64_t& word = bits[low >> 6];
+        const uint64_t mask = 1ULL << (low & 63);
+        if (!(word & mask)) {
+            return false;
+        }
+        word &= ~mask;
+        --count;
+        return true;
+    }
+
+    auto it = std::lower_bound(array.begin(), array.end(), low);
+    if (it == array.end() || *it != low) {
+        return false;
+    }
+    array.erase(it);
+    --count;
+    return true;
+}
+
+size_t RecordIdBitmap::Chunk::intersectWith(const Chunk& other) {
+    if (isBitset() && other.isBitset()) {
+        count = 0;
+        for (size_t i = 0; i < kBitsetWords; ++i) {
+            bits[i] &= other.bits[i];
+            count += popCount(bits[i]);
+        }
+        if (count <= kMaxArraySize) {
+            toArray();
+        }
+        return count;
+    }
+
+    // At least one side is an array, so the result is small enough to be one.
+    std::vector<uint16_t> result;
+    if (!isBitset() && !other.isBitset()) {
+        std::set_intersection(array.begin(),
+                              array.end(),
+                              other.array.begin(),
+                              other.array.end(),
+                              std::back_inserter(result));
+    } else {
+        const Chunk& arrayChunk = isBitset() ? other : *this;
+        const Chunk& bitsetChunk = isBitset() ? *this : other;
+        for (uint16_t low : arrayChunk.array) {
+            if (bitsetChunk.contains(low)) {
+                result.push_back(low);
+            }
+        }
+    }
+
+    bits.clear();
+    bits.shrink_to_fit();
+    array.swap(result);
+    count = array.size();
+    return count;
+}
+
+bool RecordIdBitmap::Chunk::findNext(uint32_t start, uint16_t* out) const {
+    if (start > 0xFFFF) {
+        return false;
+    }
+
+    if (isBitset()) {
+        size_t wordIdx = start >> 6;
+        uint64_t word = bits[wordIdx] & (~0ULL << (start & 63));
+        while (true) {
+            if (word) {
+                *out = static_cast<uint16_t>((wordIdx << 6) + countTrailingZeros64(word));
+                return true;
+            }
+            if (++wordIdx == kBitsetWords) {
+                return false;
+            }
+            word = bits[wordIdx];
+        }
+    }
+
+    auto it = std::lower_bound(array.begin(), array.end(), start);
+    if (it == array.end()) {
+        return false;
+    }
+    *out = *it;
+    return true;
+}
+
+void RecordIdBitmap::Chunk::toBitset() {
+    bits.assign(kBitsetWords, 0);
+    for (uint16_t low : array) {
+        bits[low >> 6] |= 1ULL << (low & 63);
+    }
+    array.clear();
+    array.shrink_to_fit();
+}
+
+void RecordIdBitmap::Chunk::toArray() {
+    std::vector<uint16_t> result;
+    result.reserve(count);
+    for (size_t i = 0; i < kBitsetWords; ++i) {
+        uint64_t word = bits[i];
+        while (word) {
+            result.push_back(static_cast<uint16_t>((i << 6) + countTrailingZeros64(word)));
+            word &= word - 1;
+        }
+    }
+    bits.clear();
+    bits.shrink_to_fit();
+    array.swap(result);
+}
+
+void RecordIdBitmap::add(const RecordId& id) {
+    if (_chunks[highBits(id)].add(lowBits(id))) {
+        ++_size;
+    }
+}
+
+bool RecordIdBitmap::remove(const RecordId& id) {
+    auto it = _chunks.find(highBits(id));
+    if (it == _chunks.end() || !it->second.remove(lowBits(id))) {
+        return false;
+    }
+
+    --_size;
+    if (it->second.count == 0) {
+        _chunks.erase(it);
+    }
+    return true;
+}
+
+bool RecordIdBitmap::contains(const RecordId& id) const {
+    auto it = _chunks.find(highBits(id));
+    return it != _chunks.end() && it->second.contains(lowBits(id));
+}
+
+void RecordIdBitmap::intersectWith(const RecordIdBitmap& other) {
+    _size = 0;
+    auto it = _chunks.begin();
+    auto otherIt = other._chunks.begin();
+    while (it != _chunks.end()) {
+        while (otherIt != other._chunks.end() && otherIt->first < it->first) {
+            ++otherIt;
+        }
+
+        if (otherIt == other._chunks.end() || otherIt->first != it->first) {
+            it = _chunks.erase(it);
+            continue;
+        }
+
+        const size_t remaining = it->second.intersectWith(otherIt->second);
+        if (remaining == 0) {
+            it = _chunks.erase(it);
+        } else {
+            _size += remaining;
+            ++it;
+        }
+    }
+}
+
+bool RecordIdBitmap::findNext(const RecordId& start, RecordId* out) const {
+    const int64_t startHigh = highBits(start);
+    for (auto it = _chunks.lower_bound(startHigh); it != _chunks.end(); ++it) {
+        const uint32_t startLow = it->first == startHigh ? lowBits(start) : 0;
+        uint16_t low;
+        if (it->second.findNext(startLow, &low)) {
+            *out = makeRecordId(it->first, low);
+            return true;
+        }
+    }
+    return false;
+}
+
+void RecordIdBitmap::clear() {
+    _chunks.clear();
+    _size = 0;
+}
+
+size_t RecordIdBitmap::getMemUsage() const {
+    size_t memUsage = 0;
+    for (auto&& chunk : _chunks) {
+        memUsage += sizeof(chunk) + chunk.second.array.capacity() * sizeof(uint16_t) +
+            chunk.second.bits.capacity() * sizeof(uint64_t);
+    }
+    return memUsage;
+}
+
+}  // namespace mongo
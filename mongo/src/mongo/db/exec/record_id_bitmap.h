@@ -0,0 +1,126 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "mongo/db/record_id.h"
+
+namespace mongo {
+
+/**
+ * A compressed set of RecordIds in the style of a roaring bitmap.
+ *
+ * RecordIds are grouped into chunks by the high 48 bits of their representation. Each chunk
+ * stores the low 16 bits of its members either as a sorted array, while it is sparse, or as a
+ * 65536-bit bitset once it holds more than kMaxArraySize members. Dense ranges of RecordIds, which
+ * is what index scans over a collection with sequential RecordIds produce, thus cost a little over
+ * one bit each and sparse ones two bytes each, instead of a hash table entry per RecordId.
+ *
+ * Intersections are computed a chunk at a time, word by word where both sides are bitsets.
+ */
+class RecordIdBitmap {
+public:
+    // Largest number of members a chunk stores as an array.
+    static const size_t kMaxArraySize = 4096;
+
+    void add(const RecordId& id);
+
+    /**
+     * Returns true if 'id' was a member.
+     */
+    bool remove(const RecordId& id);
+
+    bool contains(const RecordId& id) const;
+
+    /**
+     * Keeps only the members which are also in 'other'.
+     */
+    void intersectWith(const RecordIdBitmap& other);
+
+    /**
+     * Finds the smallest member which is greater than or equal to 'start'. Returns false if there
+     * is none. Iterating this way stays valid while members are removed.
+     */
+    bool findNext(const RecordId& start, RecordId* out) const;
+
+    size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+    void clear();
+
+    /**
+     * Approximate number of bytes of memory used by the members.
+     */
+    size_t getMemUsage() const;
+
+private:
+    static const size_t kBitsetWords = 65536 / 64;
+
+    struct Chunk {
+        bool isBitset() const {
+            return !bits.empty();
+        }
+
+        bool contains(uint16_t low) const;
+
+        // Returns true if 'low' was not already present.
+        bool add(uint16_t low);
+
+        // Returns true if 'low' was present.
+        bool remove(uint16_t low);
+
+        // Keeps only the members also in 'other' and returns the new number of members.
+        size_t intersectWith(const Chunk& other);
+
+        bool findNext(uint32_t start, uint16_t* out) const;
+
+        void toBitset();
+        void toArray();
+
+        size_t count = 0;
+
+        // Exactly one of these is in use: 'array' while the chunk is sparse, 'bits' once dense.
+        std::vector<uint16_t> array;
+        std::vector<uint64_t> bits;
+    };
+
+    std::map<int64_t, Chunk> _chunks;
+    size_t _size = 0;
+};
+
+}  // namespace mongo
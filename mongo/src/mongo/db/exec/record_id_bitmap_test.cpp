@@ -0,0 +1,131 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file contains tests for mongo/db/exec/record_id_bitmap.cpp
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <set>
+
+#include "mongo/db/exec/record_id_bitmap.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+TEST(RecordIdBitmapTest, AddContainsRemove) {
+    RecordIdBitmap bitmap;
+    ASSERT_TRUE(bitmap.empty());
+
+    bitmap.add(RecordId(5));
+    bitmap.add(RecordId(5));
+    bitmap.add(RecordId(1 << 20));
+    ASSERT_EQUALS(2U, bitmap.size());
+    ASSERT_TRUE(bitmap.contains(RecordId(5)));
+    ASSERT_TRUE(bitmap.contains(RecordId(1 << 20)));
+    ASSERT_FALSE(bitmap.contains(RecordId(6)));
+
+    ASSERT_TRUE(bitmap.remove(RecordId(5)));
+    ASSERT_FALSE(bitmap.remove(RecordId(5)));
+    ASSERT_EQUALS(1U, bitmap.size());
+    ASSERT_FALSE(bitmap.contains(RecordId(5)));
+}
+
+TEST(RecordIdBitmapTest, FindNextCrossesChunks) {
+    RecordIdBitmap bitmap;
+    bitmap.add(RecordId(3));
+    bitmap.add(RecordId(70000));
+    bitmap.add(RecordId(int64_t(1) << 40));
+
+    RecordId out;
+    ASSERT_TRUE(bitmap.findNext(RecordId(1), &out));
+    ASSERT_EQUALS(RecordId(3), out);
+    ASSERT_TRUE(bitmap.findNext(RecordId(4), &out));
+    ASSERT_EQUALS(RecordId(70000), out);
+    ASSERT_TRUE(bitmap.findNext(RecordId(70001), &out));
+    ASSERT_EQUALS(RecordId(int64_t(1) << 40), out);
+    ASSERT_FALSE(bitmap.findNext(RecordId((int64_t(1) << 40) + 1), &out));
+}
+
+TEST(RecordIdBitmapTest, DenseChunkConvertsToBitsetAndBack) {
+    RecordIdBitmap bitmap;
+    const int64_t n = RecordIdBitmap::kMaxArraySize * 2;
+    for (int64_t i = 1; i <= n; ++i) {
+        bitmap.add(RecordId(i));
+    }
+    ASSERT_EQUALS(size_t(n), bitmap.size());
+    // A bitset chunk takes 8KB regardless of how many members it holds.
+    ASSERT_LESS_THAN(bitmap.getMemUsage(), size_t(n) * sizeof(uint16_t));
+
+    for (int64_t i = 1; i <= n; i += 2) {
+        ASSERT_TRUE(bitmap.remove(RecordId(i)));
+    }
+    ASSERT_EQUALS(size_t(n / 2), bitmap.size());
+
+    RecordId out;
+    int64_t expected = 2;
+    RecordId start(1);
+    while (bitmap.findNext(start, &out)) {
+        ASSERT_EQUALS(RecordId(expected), out);
+        expected += 2;
+        start = RecordId(out.repr() + 1);
+    }
+    ASSERT_EQUALS(n + 2, expected);
+}
+
+TEST(RecordIdBitmapTest, IntersectMixedRepresentations) {
+    RecordIdBitmap dense;
+    RecordIdBitmap sparse;
+    std::set<int64_t> expected;
+    for (int64_t i = 1; i <= 10000; ++i) {
+        dense.add(RecordId(i));
+        if (i % 7 == 0) {
+            sparse.add(RecordId(i));
+            expected.insert(i);
+        }
+    }
+    // Only in 'sparse', in a chunk 'dense' does not have.
+    sparse.add(RecordId(int64_t(1) << 32));
+
+    RecordIdBitmap result = dense;
+    result.intersectWith(sparse);
+    ASSERT_EQUALS(expected.size(), result.size());
+    for (int64_t i : expected) {
+        ASSERT_TRUE(result.contains(RecordId(i)));
+    }
+    ASSERT_FALSE(result.contains(RecordId(int64_t(1) << 32)));
+
+    sparse.intersectWith(dense);
+    ASSERT_EQUALS(expected.size(), sparse.size());
+}
+
+}  // namespace
@@ -41,6 +41,7 @@
 #include "mongo/db/query/find_common.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/log.h"
 
@@ -67,6 +68,19 @@ bool SortStage::WorkingSetComparator::operator()(const SortableDataItem& lhs,
     return lhs.recordId < rhs.recordId;
 }
 
+SortStage::SpillComparator::SpillComparator(BSONObj p) : pattern(p) {}
+
+int SortStage::SpillComparator::operator()(const SpillIterator::Data& lhs,
+                                           const SpillIterator::Data& rhs) const {
+    int result = lhs.first.woCompare(rhs.first, pattern, false);
+    if (0 != result) {
+        return result;
+    }
+    const RecordId lhsId(lhs.second["r"].numberLong());
+    const RecordId rhsId(rhs.second["r"].numberLong());
+    return lhsId.compare(rhsId);
+}
+
 SortStage::SortStage(OperationContext* opCtx,
                      const SortStageParams& params,
                      WorkingSet* ws,
@@ -76,6 +90,7 @@ SortStage::SortStage(OperationContext* opCtx,
       _ws(ws),
       _pattern(params.pattern),
       _limit(params.limit),
+      _allowDiskUse(params.allowDiskUse),
       _sorted(false),
       _resultIterator(_data.end()),
       _memUsage(0) {
@@ -83,13 +98,6 @@ SortStage::SortStage(OperationContext* opCtx,
 
     BSONObj sortComparator = FindCommon::transformSortSpec(_pattern);
     _sortKeyComparator = stdx::make_unique<WorkingSetComparator>(sortComparator);
-
-    // If limit > 1, we need to initialize _dataSet here to maintain ordered set of data items while
-    // fetching from the child stage.
-    if (_limit > 1) {
-        const WorkingSetComparator& cmp = *_sortKeyComparator;
-        _dataSet.reset(new SortableDataItemSet(cmp));
-    }
 }
 
 SortStage::~SortStage() {}
@@ -97,19 +105,26 @@ SortStage::~SortStage() {}
 bool SortStage::isEOF() {
     // We're done when our child has no more results, we've sorted the child's results, and
     // we've returned all sorted results.
+    if (_spillMerger) {
+        return child()->isEOF() && _sorted && !_spillMerger->more();
+    }
     return child()->isEOF() && _sorted && (_data.end() == _resultIterator);
 }
 
 PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
     const size_t maxBytes = static_cast<size_t>(internalQueryExecMaxBlockingSortBytes.load());
 	//һѯĵڴ
-	if (_memUsage > maxBytes) {
-        mongoutils::str::stream ss;
-        ss << "Sort operation used more than the maximum " << maxBytes
-           << " bytes of RAM. Add an index, or specify a smaller limit.";
-        Status status(ErrorCodes::OperationFailed, ss);
-        *out = WorkingSetCommon::allocateStatusMember(_ws, status);
-        return PlanStage::FAILURE;
+    if (_memUsage > maxBytes) {
+        if (_allowDiskUse) {
+            spill();
+        } else {
+            mongoutils::str::stream ss;
+            ss << "Sort operation used more than the maximum " << maxBytes
+               << " bytes of RAM. Add an index, specify a smaller limit, or set allowDiskUse.";
+            Status status(ErrorCodes::OperationFailed, ss);
+            *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+            return PlanStage::FAILURE;
+        }
     }
 
     if (isEOF()) {
@@ -158,6 +173,12 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
             // TODO: We don't need the lock for this.  We could ask for a yield and do this work
             // unlocked.  Also, this is performing a lot of work for one call to work(...)
             sortBuffer();
+            if (!_spills.empty() || (_allowDiskUse && _memUsage > maxBytes)) {
+                // Merge what is left in memory with the data already on disk.
+                spill();
+                _spillMerger.reset(SpillIterator::merge(
+                    _spills, SortOptions().Limit(_limit), SpillComparator(_sortKeyComparator->pattern)));
+            }
             _resultIterator = _data.begin();
             _sorted = true;
             return PlanStage::NEED_TIME;
@@ -181,6 +202,11 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
     }
 
     // Returning results.
+    if (_spillMerger) {
+        *out = nextSpilledResult();
+        return PlanStage::ADVANCED;
+    }
+
     verify(_resultIterator != _data.end());
     verify(_sorted);
     *out = _resultIterator->wsid;
@@ -217,6 +243,10 @@ void SortStage::doInvalidate(OperationContext* opCtx, const RecordId& dl, Invali
         // Remove the RecordId from our set of active DLs.
         _wsidByRecordId.erase(it);
         ++_specificStats.forcedFetches;
+    } else if (!_spills.empty()) {
+        // The result may be on disk. Its spilled copy of the document is what the fetch above
+        // would have kept, so only stop handing out the RecordId.
+        _invalidatedSpilledRecordIds.insert(dl);
     }
 }
 
@@ -253,10 +283,14 @@ const SpecificStats* SortStage::getSpecificStats() const {
  *                     Updates memory usage if item was replaced.
  *     sortBuffer() - Does nothing.
  * limit > 1:
- *     addToBuffer() - Does not update vector. Adds item to set.
- *                     If size of set exceeds limit, remove item from set
- *                     with lowest key. Updates memory usage accordingly.
- *     sortBuffer() - Copies items from set to vectors.
+ *     addToBuffer() - Keeps the vector a max-heap of at most limit items.
+ *                     If size of heap exceeds limit, pops the item with
+ *                     the highest key. Updates memory usage accordingly.
+ *     sortBuffer() - Sorts the heap.
+ *
+ * spill() may empty the buffer at any point, after which each of the above
+ * starts over. Every spilled run then holds the first (up to limit) items of
+ * the data it was built from, so merging the runs yields the first results.
  */
 void SortStage::addToBuffer(const SortableDataItem& item) {
     // Holds ID of working set member to be freed at end of this function.
@@ -285,33 +319,28 @@ void SortStage::addToBuffer(const SortableDataItem& item) {
             _memUsage = member->getMemUsage();
         }
     } else {
-        // Update data item set instead of vector
-        // Limit not reached - insert and return
+        // Limit not reached - push onto the heap and return
+        const WorkingSetComparator& cmp = *_sortKeyComparator;
         vector<SortableDataItem>::size_type limit(_limit);
-        if (_dataSet->size() < limit) {
+        if (_data.size() < limit) {
             member->makeObjOwnedIfNeeded();
-            _dataSet->insert(item);
+            _data.push_back(item);
+            std::push_heap(_data.begin(), _data.end(), cmp);
             _memUsage += member->getMemUsage();
             return;
         }
-        // Limit will be exceeded - compare with item with lowest key
-        // If new item does not have a lower key value than last item,
-        // do nothing.
+        // Limit will be exceeded - compare with the item with the highest key, at the front of
+        // the heap. If new item does not have a lower key value, do nothing.
         wsidToFree = item.wsid;
-        SortableDataItemSet::const_iterator lastItemIt = --(_dataSet->end());
-        const SortableDataItem& lastItem = *lastItemIt;
-        const WorkingSetComparator& cmp = *_sortKeyComparator;
-        if (cmp(item, lastItem)) {
+        if (cmp(item, _data.front())) {
+            std::pop_heap(_data.begin(), _data.end(), cmp);
+            SortableDataItem& lastItem = _data.back();
             _memUsage -= _ws->get(lastItem.wsid)->getMemUsage();
             _memUsage += member->getMemUsage();
             wsidToFree = lastItem.wsid;
-            // According to std::set iterator validity rules,
-            // it does not matter which of erase()/insert() happens first.
-            // Here, we choose to erase first to release potential resources
-            // used by the last item and to keep the scope of the iterator to a minimum.
-            _dataSet->erase(lastItemIt);
             member->makeObjOwnedIfNeeded();
-            _dataSet->insert(item);
+            lastItem = item;
+            std::push_heap(_data.begin(), _data.end(), cmp);
         }
     }
 
@@ -335,13 +364,115 @@ void SortStage::sortBuffer() {
         // Buffer contains either 0 or 1 item so it is already in a sorted state.
         return;
     } else {
-        // Set already contains items in sorted order, so we simply copy the items
-        // from the set to the vector.
-        // Release the memory for the set after the copy.
-        vector<SortableDataItem> newData(_dataSet->begin(), _dataSet->end());
-        _data.swap(newData);
-        _dataSet.reset();
+        const WorkingSetComparator& cmp = *_sortKeyComparator;
+        std::sort_heap(_data.begin(), _data.end(), cmp);
     }
 }
 
+void SortStage::spill() {
+    invariant(_allowDiskUse);
+
+    // The buffer may be a heap or already sorted, so sort it in any case.
+    const WorkingSetComparator& cmp = *_sortKeyComparator;
+    std::sort(_data.begin(), _data.end(), cmp);
+
+    SortedFileWriter<BSONObj, BSONObj> writer(
+        SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp").ExtSortAllowed());
+    for (const SortableDataItem& item : _data) {
+        WorkingSetMember* member = _ws->get(item.wsid);
+        BSONObjBuilder bob;
+        bob.append("o", member->obj.value());
+        bob.append("r", item.recordId.repr());
+        if (member->hasRecordId()) {
+            bob.append("id", member->recordId.repr());
+        }
+        appendSpilledComputedData(member, &bob);
+        BSONObj value = bob.obj();
+
+        writer.addAlreadySorted(item.sortKey, value);
+        _specificStats.spilledBytes += item.sortKey.objsize() + value.objsize();
+
+        if (member->hasRecordId()) {
+            _wsidByRecordId.erase(member->recordId);
+        }
+        _ws->free(item.wsid);
+    }
+    _spills.emplace_back(writer.done());
+
+    ++_specificStats.spills;
+    _specificStats.spilledRecords += _data.size();
+    LOG(1) << "Sort spilled " << _data.size() << " results to disk using " << _memUsage
+           << " bytes of memory";
+
+    _data.clear();
+    _memUsage = 0;
+}
+
+void SortStage::appendSpilledComputedData(const WorkingSetMember* member, BSONObjBuilder* bob) {
+    BSONObjBuilder computed(bob->subobjStart("c"));
+    if (member->hasComputed(WSM_COMPUTED_TEXT_SCORE)) {
+        computed.append("textScore",
+                        static_cast<const TextScoreComputedData*>(
+                            member->getComputed(WSM_COMPUTED_TEXT_SCORE))
+                            ->getScore());
+    }
+    if (member->hasComputed(WSM_COMPUTED_GEO_DISTANCE)) {
+        computed.append("geoDistance",
+                        static_cast<const GeoDistanceComputedData*>(
+                            member->getComputed(WSM_COMPUTED_GEO_DISTANCE))
+                            ->getDist());
+    }
+    if (member->hasComputed(WSM_INDEX_KEY)) {
+        computed.append(
+            "indexKey",
+            static_cast<const IndexKeyComputedData*>(member->getComputed(WSM_INDEX_KEY))->getKey());
+    }
+    if (member->hasComputed(WSM_GEO_NEAR_POINT)) {
+        computed.append("geoNearPoint",
+                        static_cast<const GeoNearPointComputedData*>(
+                            member->getComputed(WSM_GEO_NEAR_POINT))
+                            ->getPoint());
+    }
+    computed.doneFast();
+}
+
+WorkingSetID SortStage::nextSpilledResult() {
+    SpillIterator::Data next = _spillMerger->next();
+    WorkingSetID id = _ws->allocate();
+    WorkingSetMember* member = _ws->get(id);
+    member->obj = Snapshotted<BSONObj>(SnapshotId(), next.second["o"].Obj().getOwned());
+    member->addComputed(new SortKeyComputedData(next.first));
+
+    BSONObj computed = next.second["c"].Obj();
+    if (computed.hasField("textScore")) {
+        member->addComputed(new TextScoreComputedData(computed["textScore"].numberDouble()));
+    }
+    if (computed.hasField("geoDistance")) {
+        member->addComputed(new GeoDistanceComputedData(computed["geoDistance"].numberDouble()));
+    }
+    if (computed.hasField("indexKey")) {
+        member->addComputed(new IndexKeyComputedData(computed["indexKey"].Obj()));
+    }
+    if (computed.hasField("geoNearPoint")) {
+        member->addComputed(new GeoNearPointComputedData(computed["geoNearPoint"].Obj()));
+    }
+
+    // The document was read in an earlier snapshot, so stages that need the current version
+    // fetch it again by its RecordId.
+    BSONElement recordIdElt = next.second["id"];
+    if (recordIdElt.ok()) {
+        RecordId recordId(recordIdElt.numberLong());
+        if (!_invalidatedSpilledRecordIds.count(recordId)) {
+            member->recordId = recordId;
+            _ws->transitionToRecordIdAndObj(id);
+            return id;
+        }
+    }
+    _ws->transitionToOwnedObj(id);
+    return id;
+}
+
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
@@ -28,7 +28,7 @@
 
 #pragma once
 
-#include <set>
+#include <memory>
 #include <vector>
 
 #include "mongo/db/exec/plan_stage.h"
@@ -37,7 +37,9 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/index_bounds.h"
 #include "mongo/db/record_id.h"
+#include "mongo/db/sorter/sorter.h"
 #include "mongo/platform/unordered_map.h"
+#include "mongo/platform/unordered_set.h"
 
 namespace mongo {
 
@@ -46,7 +48,7 @@ class BtreeKeyGenerator;
 // Parameters that must be provided to a SortStage
 class SortStageParams {
 public:
-    SortStageParams() : collection(NULL), limit(0) {}
+    SortStageParams() : collection(NULL), limit(0), allowDiskUse(false) {}
 
     // Used for resolving RecordIds to BSON
     const Collection* collection;
@@ -56,6 +58,10 @@ public:
 
     // Equal to 0 for no limit.
     size_t limit;
+
+    // Whether the buffered data may be spilled to disk instead of failing the query once it uses
+    // more than internalQueryExecMaxBlockingSortBytes.
+    bool allowDiskUse;
 };
 
 /**
@@ -106,6 +112,8 @@ private:
     // Equal to 0 for no limit.
     size_t _limit;
 
+    const bool _allowDiskUse;
+
     //
     // Data storage
     //
@@ -124,7 +132,7 @@ private:
         RecordId recordId;
     };
 
-    // Comparison object for data buffers (vector and set). Items are compared on (sortKey, loc).
+    // Comparison object for the data buffer. Items are compared on (sortKey, loc).
     // This is also how the items are ordered in the indices. Keys are compared using
     // BSONObj::woCompare() with RecordId as a tie-breaker.
     //
@@ -138,20 +146,49 @@ private:
         BSONObj pattern;
     };
 
+    // Spilled data: the key is the sort key, the value is {o: <document>, r: <RecordId>} plus
+    // 'id' when the member still had its RecordId and 'c' holding its other computed data.
+    typedef SortIteratorInterface<BSONObj, BSONObj> SpillIterator;
+
+    // Orders spilled data the same way as WorkingSetComparator.
+    struct SpillComparator {
+        explicit SpillComparator(BSONObj p);
+
+        int operator()(const SpillIterator::Data& lhs, const SpillIterator::Data& rhs) const;
+
+        BSONObj pattern;
+    };
+
     /**
-     * Inserts one item into data buffer (vector or set).
-     * If limit is exceeded, remove item with lowest key.
+     * Inserts one item into data buffer.
+     * If limit is exceeded, remove item with highest key.
      */
     void addToBuffer(const SortableDataItem& item);
 
     /**
      * Sorts data buffer.
      * Assumes no more items will be added to buffer.
-     * If data is stored in set, copy set
-     * contents to vector and clear set.
      */
     void sortBuffer();
 
+    /**
+     * Sorts the data buffer, writes it to a new file and frees its working set members. The
+     * buffer is empty afterwards. Only used when '_allowDiskUse' is set.
+     */
+    void spill();
+
+    /**
+     * Appends the computed data of 'member' other than its sort key to 'bob' as the 'c' field of
+     * a spilled result.
+     */
+    static void appendSpilledComputedData(const WorkingSetMember* member, BSONObjBuilder* bob);
+
+    /**
+     * Returns a new working set member holding the next result of '_spillMerger', with the
+     * RecordId and computed data it had before it was spilled.
+     */
+    WorkingSetID nextSpilledResult();
+
     // Comparator for data buffer
     // Initialization follows sort key generator
     std::unique_ptr<WorkingSetComparator> _sortKeyComparator;
@@ -160,12 +197,13 @@ private:
     // _data will contain sorted data when all data is gathered
     // and sorted.
     // When _limit is greater than 1 and not all data has been gathered from child stage,
-    // _dataSet is used instead to maintain an ordered set of the incomplete data set.
-    // When the data set is complete, we copy the items from _dataSet to _data which will
-    // be used to provide the results of this stage through _resultIterator.
+    // _data is a max-heap of at most _limit items, so that the item to evict is at the front.
     std::vector<SortableDataItem> _data;
-    typedef std::set<SortableDataItem, WorkingSetComparator> SortableDataItemSet;
-    std::unique_ptr<SortableDataItemSet> _dataSet;
+
+    // Sorted runs written by spill(). Once all data is gathered, the remaining buffer is spilled
+    // as well and results are produced by merging the runs.
+    std::vector<std::shared_ptr<SpillIterator>> _spills;
+    std::unique_ptr<SpillIterator> _spillMerger;
 
     // Iterates through _data post-sort returning it.
     std::vector<SortableDataItem>::iterator _resultIterator;
@@ -174,6 +212,10 @@ private:
     typedef unordered_map<RecordId, WorkingSetID, RecordId::Hasher> DataMap;
     DataMap _wsidByRecordId;
 
+    // RecordIds invalidated while their results were spilled. Such results come back as owned
+    // objects, the same as results invalidated while buffered.
+    unordered_set<RecordId, RecordId::Hasher> _invalidatedSpilledRecordIds;
+
     SortStats _specificStats;
 
     // The usage in bytes of all buffered data that we're sorting.
@@ -35,15 +35,20 @@
 #include <boost/optional.hpp>
 
 #include "mongo/db/exec/queued_data_stage.h"
+#include "mongo/db/exec/working_set_computed_data.h"
 #include "mongo/db/json.h"
 #include "mongo/db/operation_context_noop.h"
 #include "mongo/db/query/collation/collator_factory_mock.h"
 #include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/service_context_noop.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/unittest/temp_dir.h"
 #include "mongo/util/clock_source_mock.h"
+#include "mongo/util/scopeguard.h"
 
 using namespace mongo;
 
@@ -300,4 +305,130 @@ TEST_F(SortStageTest, SortDescendingWithCollation) {
              "{input: [{a: 'ba'}, {a: 'aa'}, {a: 'ab'}]}",
              "{output: [{a: 'ab'}, {a: 'ba'}, {a: 'aa'}]}");
 }
+
+TEST_F(SortStageTest, SortSpillsToDiskWhenAllowed) {
+    unittest::TempDir tempDir("sort_stage_test");
+    const std::string oldDbPath = storageGlobalParams.dbpath;
+    const int oldMaxBytes = internalQueryExecMaxBlockingSortBytes.load();
+    storageGlobalParams.dbpath = tempDir.path();
+    internalQueryExecMaxBlockingSortBytes.store(256);
+    ON_BLOCK_EXIT([&] {
+        storageGlobalParams.dbpath = oldDbPath;
+        internalQueryExecMaxBlockingSortBytes.store(oldMaxBytes);
+    });
+
+    const int kNumDocs = 50;
+    WorkingSet ws;
+    auto queuedDataStage = stdx::make_unique<QueuedDataStage>(getOpCtx(), &ws);
+    for (int i = kNumDocs - 1; i >= 0; --i) {
+        WorkingSetID id = ws.allocate();
+        WorkingSetMember* wsm = ws.get(id);
+        wsm->obj = Snapshotted<BSONObj>(SnapshotId(), BSON("a" << i));
+        wsm->transitionToOwnedObj();
+        queuedDataStage->pushBack(id);
+    }
+
+    SortStageParams params;
+    params.pattern = BSON("a" << 1);
+    params.allowDiskUse = true;
+    auto sortKeyGen = stdx::make_unique<SortKeyGeneratorStage>(
+        getOpCtx(), queuedDataStage.release(), &ws, params.pattern, nullptr);
+    SortStage sort(getOpCtx(), params, &ws, sortKeyGen.release());
+
+    int expected = 0;
+    WorkingSetID id = WorkingSet::INVALID_ID;
+    PlanStage::StageState state = PlanStage::NEED_TIME;
+    while (state != PlanStage::IS_EOF) {
+        state = sort.work(&id);
+        ASSERT_NE(state, PlanStage::FAILURE);
+        if (state == PlanStage::ADVANCED) {
+            ASSERT_BSONOBJ_EQ(BSON("a" << expected), ws.get(id)->obj.value());
+            ++expected;
+        }
+    }
+    ASSERT_EQUALS(kNumDocs, expected);
+
+    const SortStats* stats = static_cast<const SortStats*>(sort.getSpecificStats());
+    ASSERT_GT(stats->spills, 1U);
+    ASSERT_EQUALS(static_cast<size_t>(kNumDocs), stats->spilledRecords);
+}
+
+TEST_F(SortStageTest, SortSpillKeepsRecordIdAndComputedData) {
+    unittest::TempDir tempDir("sort_stage_test");
+    const std::string oldDbPath = storageGlobalParams.dbpath;
+    const int oldMaxBytes = internalQueryExecMaxBlockingSortBytes.load();
+    storageGlobalParams.dbpath = tempDir.path();
+    internalQueryExecMaxBlockingSortBytes.store(256);
+    ON_BLOCK_EXIT([&] {
+        storageGlobalParams.dbpath = oldDbPath;
+        internalQueryExecMaxBlockingSortBytes.store(oldMaxBytes);
+    });
+
+    const int kNumDocs = 50;
+    WorkingSet ws;
+    auto queuedDataStage = stdx::make_unique<QueuedDataStage>(getOpCtx(), &ws);
+    for (int i = kNumDocs - 1; i >= 0; --i) {
+        WorkingSetID id = ws.allocate();
+        WorkingSetMember* wsm = ws.get(id);
+        wsm->recordId = RecordId(i + 1);
+        wsm->obj = Snapshotted<BSONObj>(SnapshotId(), BSON("a" << i));
+        wsm->addComputed(new TextScoreComputedData(i));
+        wsm->addComputed(new GeoDistanceComputedData(2.0 * i));
+        ws.transitionToRecordIdAndObj(id);
+        queuedDataStage->pushBack(id);
+    }
+
+    // Sorts by descending text score.
+    SortStageParams params;
+    params.pattern = fromjson("{score: {$meta: 'textScore'}}");
+    params.allowDiskUse = true;
+    auto sortKeyGen = stdx::make_unique<SortKeyGeneratorStage>(
+        getOpCtx(), queuedDataStage.release(), &ws, params.pattern, nullptr);
+    SortStage sort(getOpCtx(), params, &ws, sortKeyGen.release());
+
+    const SortStats* stats = static_cast<const SortStats*>(sort.getSpecificStats());
+    WorkingSetID id = WorkingSet::INVALID_ID;
+    PlanStage::StageState state = PlanStage::NEED_TIME;
+    while (stats->spills == 0U) {
+        state = sort.work(&id);
+        ASSERT_EQ(state, PlanStage::NEED_TIME);
+    }
+
+    // The document with the highest score was spilled first. Invalidating it while it is on disk
+    // must take its RecordId away.
+    sort.invalidate(getOpCtx(), RecordId(kNumDocs), INVALIDATION_DELETION);
+
+    int expected = kNumDocs - 1;
+    while (state != PlanStage::IS_EOF) {
+        state = sort.work(&id);
+        ASSERT_NE(state, PlanStage::FAILURE);
+        if (state != PlanStage::ADVANCED) {
+            continue;
+        }
+
+        WorkingSetMember* member = ws.get(id);
+        ASSERT_BSONOBJ_EQ(BSON("a" << expected), member->obj.value());
+        if (expected == kNumDocs - 1) {
+            ASSERT_FALSE(member->hasRecordId());
+            ASSERT_EQ(WorkingSetMember::OWNED_OBJ, member->getState());
+        } else {
+            ASSERT_EQ(WorkingSetMember::RID_AND_OBJ, member->getState());
+            ASSERT_EQ(RecordId(expected + 1), member->recordId);
+        }
+
+        ASSERT_TRUE(member->hasComputed(WSM_COMPUTED_TEXT_SCORE));
+        ASSERT_EQ(expected,
+                  static_cast<const TextScoreComputedData*>(
+                      member->getComputed(WSM_COMPUTED_TEXT_SCORE))
+                      ->getScore());
+        ASSERT_TRUE(member->hasComputed(WSM_COMPUTED_GEO_DISTANCE));
+        ASSERT_EQ(2.0 * expected,
+                  static_cast<const GeoDistanceComputedData*>(
+                      member->getComputed(WSM_COMPUTED_GEO_DISTANCE))
+                      ->getDist());
+        --expected;
+    }
+    ASSERT_EQUALS(-1, expected);
+    ASSERT_GT(stats->spills, 1U);
+}
 }  // namespace
@@ -39,45 +39,38 @@ using std::string;
 
 namespace dps = ::mongo::dotted_path_support;
 
-WorkingSet::MemberHolder::MemberHolder() : member(NULL) {}
-WorkingSet::MemberHolder::~MemberHolder() {}
-
 WorkingSet::WorkingSet() : _freeList(INVALID_ID) {}
 
-WorkingSet::~WorkingSet() {
-    for (size_t i = 0; i < _data.size(); i++) {
-        delete _data[i].member;
-    }
-}
+WorkingSet::~WorkingSet() {}
 
 WorkingSetID WorkingSet::allocate() {
-	//_dataпÿռˣ´μһһĿռ
     if (_freeList == INVALID_ID) {
-        // The free list is empty so we need to make a single new WSM to return. This relies on
-        // vector::resize being amortized O(1) for efficient allocation. Note that the free list
-        // remains empty until something is returned by a call to free().
-        WorkingSetID id = _data.size();
-        _data.resize(_data.size() + 1);
-        _data.back().nextFreeOrSelf = id;
-        _data.back().member = new WorkingSetMember();
+        // The free list is empty so we need to hand out a new id. Its member comes from the
+        // current block, or from a new one once the current block is used up. Note that the free
+        // list remains empty until something is returned by a call to free().
+        WorkingSetID id = _nextFreeOrSelf.size();
+        if ((id >> kMemberBlockShift) == _memberBlocks.size()) {
+            _memberBlocks.emplace_back(new WorkingSetMember[kMembersPerBlock]);
+        }
+        _nextFreeOrSelf.push_back(id);
         return id;
     }
 
     // Pop the head off the free list and return it.
     WorkingSetID id = _freeList;
-    _freeList = _data[id].nextFreeOrSelf;
-    _data[id].nextFreeOrSelf = id;  // set to self to mark as in-use
+    _freeList = _nextFreeOrSelf[id];
+    _nextFreeOrSelf[id] = id;  // set to self to mark as in-use
     return id;
 }
 
 void WorkingSet::free(WorkingSetID i) {
-    MemberHolder& holder = _data[i];
-    verify(i < _data.size());            // ID has been allocated.
-    verify(holder.nextFreeOrSelf == i);  // ID currently in use.
+    verify(i < _nextFreeOrSelf.size());  // ID has been allocated.
+    verify(_nextFreeOrSelf[i] == i);     // ID currently in use.
 
-    // Free resources and push this WSM to the head of the freelist.
-    holder.member->clear();
-    holder.nextFreeOrSelf = _freeList;
+    // Free resources and push this WSM to the head of the freelist. The member keeps the
+    // capacity of its key data for the next user.
+    memberAt(i)->clear();
+    _nextFreeOrSelf[i] = _freeList;
     _freeList = i;
 }
 
@@ -92,15 +85,20 @@ const unordered_set<WorkingSetID>& WorkingSet::getFlagged() const {
 }
 
 bool WorkingSet::isFlagged(WorkingSetID id) const {
-    invariant(id < _data.size());
+    invariant(id < _nextFreeOrSelf.size());
     return _flagged.end() != _flagged.find(id);
 }
 
 void WorkingSet::clear() {
-    for (size_t i = 0; i < _data.size(); i++) {
-        delete _data[i].member;
+    // Return every member to its freshly constructed state, but keep the blocks so that the next
+    // batch of results does not have to allocate them again.
+    for (size_t i = 0; i < _nextFreeOrSelf.size(); i++) {
+        WorkingSetMember* member = memberAt(i);
+        member->clear();
+        member->isSuspicious = false;
+        member->_fetcher.reset();
     }
-    _data.clear();
+    _nextFreeOrSelf.clear();
 
     // Since working set is now empty, the free list pointer should
     // point to nothing.
@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "mongo/base/disallow_copying.h"
@@ -84,17 +85,13 @@ public:
      * Do not delete the returned pointer as the WorkingSet retains ownership. Call free() to
      * release it.
      */
-    WorkingSetMember* get(WorkingSetID i) const {
-        dassert(i < _data.size());              // ID has been allocated.
-        dassert(_data[i].nextFreeOrSelf == i);  // ID currently in use.
-        return _data[i].member;
-    }
+    WorkingSetMember* get(WorkingSetID i) const;
 
     /**
      * Returns true if WorkingSetMember with id 'i' is free.
      */
     bool isFree(WorkingSetID i) const {
-        return _data[i].nextFreeOrSelf != i;
+        return _nextFreeOrSelf[i] != i;
     }
 
     /**
@@ -123,7 +120,8 @@ public:
     const unordered_set<WorkingSetID>& getFlagged() const;
 
     /**
-     * Removes and deallocates all members of this working set.
+     * Removes all members of this working set. The memory backing them is kept and reused by
+     * later calls to allocate().
      */
     void clear();
 
@@ -150,30 +148,27 @@ public:
     std::vector<WorkingSetID> getAndClearYieldSensitiveIds();
 
 private:
-    //WorkingSet._dataΪ
-    struct MemberHolder { 
-        MemberHolder();
-        ~MemberHolder();
-
-        // Free list link if freed. Points to self if in use.
-        WorkingSetID nextFreeOrSelf;
+    // Members are carved out of blocks of kMembersPerBlock, so that once the WorkingSet has
+    // grown to its working size allocate() and free() never touch the heap, and members with
+    // nearby ids are adjacent in memory.
+    static const size_t kMemberBlockShift = 6;
+    static const size_t kMembersPerBlock = size_t(1) << kMemberBlockShift;
 
-        // Owning pointer
-        WorkingSetMember* member;
-    };
+    WorkingSetMember* memberAt(WorkingSetID i) const;
 
+    // Free list link of each allocated id. Points to self if in use. Kept apart from the members
+    // themselves so that the free list bookkeeping stays in one small dense array.
     // All WorkingSetIDs are indexes into this, except for INVALID_ID.
     // Elements are added to _freeList rather than removed when freed.
-    /*
-    γһṹ,ÿڵ MemberHolderڱһ¼һڵλ,¼
-    һЩWorkingSetMember.һβѯ ҪܶεͷMemberHolder,ͷ
-    ʱ,ڿ,ʹ.
-    */ //ռͨWorkingSet::allocateȡ
-    std::vector<MemberHolder> _data;
-
-    // Index into _data, forming a linked-list using MemberHolder::nextFreeOrSelf as the next
+    std::vector<WorkingSetID> _nextFreeOrSelf;
+
+    // Owns the members. Member 'i' lives at index i % kMembersPerBlock of block
+    // i / kMembersPerBlock. Blocks are only released when the WorkingSet is destroyed.
+    std::vector<std::unique_ptr<WorkingSetMember[]>> _memberBlocks;
+
+    // Index into _nextFreeOrSelf, forming a linked-list using _nextFreeOrSelf as the next
     // link. INVALID_ID is the list terminator since 0 is a valid index.
-    // If _freeList == INVALID_ID, the free list is empty and all elements in _data are in use.
+    // If _freeList == INVALID_ID, the free list is empty and all allocated ids are in use.
     WorkingSetID _freeList;
 
     // An insert-only set of WorkingSetIDs that have been flagged for review.
@@ -365,4 +360,14 @@ private:
     std::unique_ptr<RecordFetcher> _fetcher;
 };
 
+inline WorkingSetMember* WorkingSet::memberAt(WorkingSetID i) const {
+    return &_memberBlocks[i >> kMemberBlockShift][i & (kMembersPerBlock - 1)];
+}
+
+inline WorkingSetMember* WorkingSet::get(WorkingSetID i) const {
+    dassert(i < _nextFreeOrSelf.size());  // ID has been allocated.
+    dassert(_nextFreeOrSelf[i] == i);     // ID currently in use.
+    return memberAt(i);
+}
+
 }  // namespace mongo
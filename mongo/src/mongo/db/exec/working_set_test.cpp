@@ -30,6 +30,7 @@
  * This file contains tests for mongo/db/exec/working_set.cpp
  */
 
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
 
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/jsobj.h"
@@ -37,6 +38,8 @@
 #include "mongo/db/storage/snapshot.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/timer.h"
 
 using namespace mongo;
 
@@ -154,4 +157,110 @@ TEST_F(WorkingSetFixture, getDottedFieldFromIndex) {
     ASSERT_FALSE(member->getFieldDotted("y", &elt));
 }
 
+TEST(WorkingSetTest, MembersStayPutAcrossBlocks) {
+    WorkingSet ws;
+    std::vector<WorkingSetID> ids;
+    std::vector<WorkingSetMember*> members;
+    for (int i = 0; i < 1000; ++i) {
+        WorkingSetID id = ws.allocate();
+        WorkingSetMember* member = ws.get(id);
+        member->recordId = RecordId(i + 1);
+        ws.transitionToRecordIdAndIdx(id);
+        ids.push_back(id);
+        members.push_back(member);
+    }
+
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQUALS(members[i], ws.get(ids[i]));
+        ASSERT_EQUALS(RecordId(i + 1), ws.get(ids[i])->recordId);
+    }
+
+    // Freed ids are handed out again, with a cleared member.
+    ws.free(ids[500]);
+    ASSERT_TRUE(ws.isFree(ids[500]));
+    WorkingSetID reused = ws.allocate();
+    ASSERT_EQUALS(ids[500], reused);
+    ASSERT_EQUALS(WorkingSetMember::INVALID, ws.get(reused)->getState());
+}
+
+TEST(WorkingSetTest, ClearResetsMembers) {
+    WorkingSet ws;
+    for (int i = 0; i < 100; ++i) {
+        WorkingSetID id = ws.allocate();
+        WorkingSetMember* member = ws.get(id);
+        member->obj = Snapshotted<BSONObj>(SnapshotId(), BSON("x" << i));
+        ws.transitionToOwnedObj(id);
+        member->isSuspicious = true;
+    }
+
+    ws.clear();
+    ASSERT_TRUE(ws.getFlagged().empty());
+
+    WorkingSetID id = ws.allocate();
+    ASSERT_EQUALS(WorkingSetID(0), id);
+    WorkingSetMember* member = ws.get(id);
+    ASSERT_EQUALS(WorkingSetMember::INVALID, member->getState());
+    ASSERT_FALSE(member->isSuspicious);
+    ASSERT_TRUE(member->keyData.empty());
+}
+
+const uint64_t kMinPerfMicros = 20 * 1000;
+const size_t kPerfBatchSize = 101;
+
+/**
+ * Runs 'batch' a sufficient number of times to take at least kMinPerfMicros microseconds and
+ * logs the elapsed time per member.
+ */
+template <typename Batch>
+void perfTest(const char* name, Batch batch) {
+    uint64_t micros = 0;
+    uint64_t timedIters = 0;
+    for (uint64_t iters = 16; iters < (1 << 30) && micros < kMinPerfMicros; iters *= 2) {
+        Timer t;
+        for (uint64_t i = 0; i < iters; i++) {
+            batch();
+        }
+        micros = t.micros();
+        timedIters = iters;
+    }
+
+    log() << 1E3 * micros / static_cast<double>(timedIters * kPerfBatchSize) << " ns per member "
+          << name << (kDebugBuild ? " (DEBUG BUILD!)" : "");
+}
+
+// Compares the pooled WorkingSet against allocating every member on the heap, as a stage tree
+// producing one index key per result would without it.
+TEST(WorkingSetTest, AllocateFreePerf) {
+    const BSONObj keyPattern = BSON("a" << 1);
+    const BSONObj key = BSON("" << 1);
+
+    WorkingSet ws;
+    std::vector<WorkingSetID> ids(kPerfBatchSize);
+    perfTest("pooled", [&] {
+        for (size_t i = 0; i < kPerfBatchSize; ++i) {
+            ids[i] = ws.allocate();
+            WorkingSetMember* member = ws.get(ids[i]);
+            member->recordId = RecordId(i + 1);
+            member->keyData.push_back(IndexKeyDatum(keyPattern, key, NULL));
+            ws.transitionToRecordIdAndIdx(ids[i]);
+        }
+        for (size_t i = 0; i < kPerfBatchSize; ++i) {
+            ws.free(ids[i]);
+        }
+        ws.getAndClearYieldSensitiveIds();
+    });
+
+    std::vector<std::unique_ptr<WorkingSetMember>> members(kPerfBatchSize);
+    perfTest("heap", [&] {
+        for (size_t i = 0; i < kPerfBatchSize; ++i) {
+            members[i].reset(new WorkingSetMember());
+            members[i]->recordId = RecordId(i + 1);
+            members[i]->keyData.push_back(IndexKeyDatum(keyPattern, key, NULL));
+        }
+        for (size_t i = 0; i < kPerfBatchSize; ++i) {
+            members[i].reset();
+        }
+    });
+}
+
 }  // namespace
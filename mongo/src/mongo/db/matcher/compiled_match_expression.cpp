@@ -0,0 +1,234 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/compiled_match_expression.h"
+
+#include "mongo/db/field_ref.h"
+#include "mongo/db/matcher/expression_path.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+std::unique_ptr<CompiledMatchExpression> CompiledMatchExpression::compile(
+    const MatchExpression* root) {
+    invariant(root);
+    std::unique_ptr<CompiledMatchExpression> compiled(new CompiledMatchExpression(root));
+    compiled->_pathNodes.emplace_back();
+    compiled->_compileNode(root);
+    compiled->_resolved.resize(compiled->_numSlots);
+    compiled->_visited.resize(compiled->_pathNodes.size());
+    return compiled;
+}
+
+void CompiledMatchExpression::_emit(OpCode op, const MatchExpression* expr) {
+    Instruction instruction;
+    instruction.op = op;
+    instruction.expr = expr;
+    _program.push_back(instruction);
+}
+
+void CompiledMatchExpression::_compileNode(const MatchExpression* expr) {
+    switch (expr->matchType()) {
+        case MatchExpression::AND:
+        case MatchExpression::OR:
+        case MatchExpression::NOR: {
+            const bool isAnd = expr->matchType() == MatchExpression::AND;
+            const size_t numChildren = expr->numChildren();
+            if (numChildren == 0) {
+                _emit(OpCode::kConst);
+                _program.back().value = isAnd;
+            }
+
+            // Each child leaves its result in the register. Jump to the end as soon as one child
+            // decides the result of the whole $and/$or.
+            std::vector<size_t> jumps;
+            for (size_t i = 0; i < numChildren; ++i) {
+                _compileNode(expr->getChild(i));
+                if (i + 1 < numChildren) {
+                    jumps.push_back(_program.size());
+                    _emit(isAnd ? OpCode::kJumpIfFalse : OpCode::kJumpIfTrue);
+                }
+            }
+            for (size_t jump : jumps) {
+                _program[jump].target = _program.size();
+            }
+
+            if (expr->matchType() == MatchExpression::NOR) {
+                _emit(OpCode::kNot);
+            }
+            return;
+        }
+        case MatchExpression::NOT:
+            _compileNode(expr->getChild(0));
+            _emit(OpCode::kNot);
+            return;
+        case MatchExpression::ALWAYS_FALSE:
+        case MatchExpression::ALWAYS_TRUE:
+            _emit(OpCode::kConst);
+            _program.back().value = expr->matchType() == MatchExpression::ALWAYS_TRUE;
+            return;
+        default:
+            break;
+    }
+
+    // Every PathMatchExpression matches a document if any element its path resolves to satisfies
+    // matchesSingleElement(). Without arrays on the path that is exactly one element, possibly
+    // EOO, which the single walk in _resolvePaths() finds.
+    auto pathExpr = dynamic_cast<const PathMatchExpression*>(expr);
+    if (pathExpr && !pathExpr->path().empty()) {
+        _emit(OpCode::kPathLeaf, expr);
+        _program.back().slot = _slotForPath(pathExpr->path());
+        return;
+    }
+
+    _emit(OpCode::kFallback, expr);
+}
+
+size_t CompiledMatchExpression::_slotForPath(StringData path) {
+    FieldRef fieldRef(path);
+    size_t nodeIndex = 0;
+    for (size_t i = 0; i < fieldRef.numParts(); ++i) {
+        const StringData part = fieldRef.getPart(i);
+
+        size_t childIndex = 0;
+        bool found = false;
+        for (size_t child : _pathNodes[nodeIndex].children) {
+            if (_pathNodes[child].fieldName == part) {
+                childIndex = child;
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) {
+            childIndex = _pathNodes.size();
+            _pathNodes.emplace_back();
+            _pathNodes.back().fieldName = part.toString();
+            _pathNodes[nodeIndex].children.push_back(childIndex);
+        }
+        nodeIndex = childIndex;
+    }
+
+    if (_pathNodes[nodeIndex].slot < 0) {
+        _pathNodes[nodeIndex].slot = _numSlots++;
+    }
+    return _pathNodes[nodeIndex].slot;
+}
+
+void CompiledMatchExpression::_resolvePaths(const BSONObj& obj, size_t nodeIndex) const {
+    const PathNode& node = _pathNodes[nodeIndex];
+    size_t remaining = node.children.size();
+
+    BSONObjIterator it(obj);
+    while (remaining > 0 && it.more()) {
+        BSONElement elem = it.next();
+        const StringData fieldName = elem.fieldNameStringData();
+
+        for (size_t child : node.children) {
+            // Like BSONObj::getField(), only the first field with a given name counts.
+            if (_visited[child] || _pathNodes[child].fieldName != fieldName) {
+                continue;
+            }
+            _visited[child] = true;
+            --remaining;
+
+            const PathNode& childNode = _pathNodes[child];
+            if (childNode.slot >= 0) {
+                _resolved[childNode.slot].element = elem;
+            }
+
+            if (elem.type() == Array) {
+                _markReachedArray(child);
+            } else if (elem.type() == Object && !childNode.children.empty()) {
+                _resolvePaths(elem.Obj(), child);
+            }
+            break;
+        }
+    }
+}
+
+void CompiledMatchExpression::_markReachedArray(size_t nodeIndex) const {
+    const PathNode& node = _pathNodes[nodeIndex];
+    if (node.slot >= 0) {
+        _resolved[node.slot].reachedArray = true;
+    }
+    for (size_t child : node.children) {
+        _markReachedArray(child);
+    }
+}
+
+bool CompiledMatchExpression::matchesBSON(const BSONObj& doc) const {
+    if (_numSlots > 0) {
+        std::fill(_resolved.begin(), _resolved.end(), ResolvedPath());
+        std::fill(_visited.begin(), _visited.end(), false);
+        _resolvePaths(doc, 0);
+    }
+
+    bool result = true;
+    size_t pc = 0;
+    while (pc < _program.size()) {
+        const Instruction& instruction = _program[pc];
+        switch (instruction.op) {
+            case OpCode::kPathLeaf: {
+                const ResolvedPath& resolved = _resolved[instruction.slot];
+                result = resolved.reachedArray
+                    ? instruction.expr->matchesBSON(doc)
+                    : instruction.expr->matchesSingleElement(resolved.element);
+                break;
+            }
+            case OpCode::kFallback:
+                result = instruction.expr->matchesBSON(doc);
+                break;
+            case OpCode::kConst:
+                result = instruction.value;
+                break;
+            case OpCode::kNot:
+                result = !result;
+                break;
+            case OpCode::kJumpIfFalse:
+                if (!result) {
+                    pc = instruction.target;
+                    continue;
+                }
+                break;
+            case OpCode::kJumpIfTrue:
+                if (result) {
+                    pc = instruction.target;
+                    continue;
+                }
+                break;
+        }
+        ++pc;
+    }
+    return result;
+}
+
+}  // namespace mongo
@@ -0,0 +1,142 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonelement.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/matcher/expression.h"
+
+namespace mongo {
+
+/**
+ * A CompiledMatchExpression is a MatchExpression tree lowered into a flat program.
+ *
+ * Evaluating a MatchExpression walks the tree and makes every path expression look its path up
+ * in the document from scratch, so filters with many predicates on shared prefixes scan the same
+ * BSON subtrees over and over. The compiled form instead collects the paths of all the path
+ * expressions into a trie, resolves every path in one walk over the document, and then runs a
+ * short-circuiting sequence of instructions over the resolved elements.
+ *
+ * A path whose traversal reaches an array has array semantics the single walk does not model, so
+ * the path expressions on that path fall back to regular evaluation for that document. Nodes the
+ * compiler does not understand (e.g. $where or $expr) are evaluated through the original tree as
+ * well, so the result is always the same as calling matchesBSON() on the source expression.
+ *
+ * The compiled program points into the source expression, which must outlive it and must not be
+ * restructured after compilation. Evaluation uses scratch space owned by the program, so a single
+ * CompiledMatchExpression must not be used from multiple threads at once.
+ */
+class CompiledMatchExpression {
+    MONGO_DISALLOW_COPYING(CompiledMatchExpression);
+
+public:
+    static std::unique_ptr<CompiledMatchExpression> compile(const MatchExpression* root);
+
+    /**
+     * Returns whether 'doc' matches the source expression.
+     */
+    bool matchesBSON(const BSONObj& doc) const;
+
+    const MatchExpression* getSource() const {
+        return _source;
+    }
+
+    size_t numInstructions() const {
+        return _program.size();
+    }
+
+    /**
+     * Returns the number of distinct paths that are resolved up front for every document.
+     */
+    size_t numPaths() const {
+        return _numSlots;
+    }
+
+private:
+    enum class OpCode {
+        // Evaluates a path expression against the element resolved for its path.
+        kPathLeaf,
+        // Evaluates a subtree using the regular MatchExpression code.
+        kFallback,
+        kConst,
+        kNot,
+        kJumpIfFalse,
+        kJumpIfTrue,
+    };
+
+    struct Instruction {
+        OpCode op;
+        const MatchExpression* expr = nullptr;
+        size_t slot = 0;
+        size_t target = 0;
+        bool value = false;
+    };
+
+    /**
+     * A node of the trie of paths. Node 0 is the root and has no field name.
+     */
+    struct PathNode {
+        std::string fieldName;
+        std::vector<size_t> children;
+        // Index into '_resolved' if a path ends at this node, or -1.
+        int slot = -1;
+    };
+
+    struct ResolvedPath {
+        BSONElement element;
+        bool reachedArray = false;
+    };
+
+    explicit CompiledMatchExpression(const MatchExpression* root) : _source(root) {}
+
+    void _compileNode(const MatchExpression* expr);
+    void _emit(OpCode op, const MatchExpression* expr = nullptr);
+    size_t _slotForPath(StringData path);
+
+    void _resolvePaths(const BSONObj& obj, size_t nodeIndex) const;
+    void _markReachedArray(size_t nodeIndex) const;
+
+    const MatchExpression* _source;
+    std::vector<Instruction> _program;
+    std::vector<PathNode> _pathNodes;
+    size_t _numSlots = 0;
+
+    // Per-document scratch space, sized at compile time.
+    mutable std::vector<ResolvedPath> _resolved;
+    mutable std::vector<char> _visited;
+};
+
+}  // namespace mongo
@@ -0,0 +1,244 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/compiled_match_expression.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/matcher/extensions_callback_noop.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/platform/random.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+std::unique_ptr<MatchExpression> parse(const BSONObj& filter) {
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto status = MatchExpressionParser::parse(filter,
+                                               expCtx,
+                                               ExtensionsCallbackNoop(),
+                                               MatchExpressionParser::kAllowAllSpecialFeatures);
+    ASSERT_OK(status.getStatus());
+    return std::move(status.getValue());
+}
+
+/**
+ * Asserts that the compiled form of 'filter' agrees with the MatchExpression on 'doc'.
+ */
+void assertSameResult(const BSONObj& filter, const BSONObj& doc) {
+    auto expr = parse(filter);
+    auto compiled = CompiledMatchExpression::compile(expr.get());
+    ASSERT_EQ(expr->matchesBSON(doc), compiled->matchesBSON(doc))
+        << "filter: " << filter << ", doc: " << doc;
+}
+
+TEST(CompiledMatchExpressionTest, SharedPrefixesResolveToOnePathEach) {
+    auto expr = parse(fromjson("{'a.b': {$gt: 1, $lt: 5}, 'a.c': 2, a: {$exists: true}}"));
+    auto compiled = CompiledMatchExpression::compile(expr.get());
+    ASSERT_EQ(3U, compiled->numPaths());
+
+    ASSERT_TRUE(compiled->matchesBSON(fromjson("{a: {b: 3, c: 2}}")));
+    ASSERT_FALSE(compiled->matchesBSON(fromjson("{a: {b: 5, c: 2}}")));
+    ASSERT_FALSE(compiled->matchesBSON(fromjson("{a: {b: 3}}")));
+    ASSERT_FALSE(compiled->matchesBSON(fromjson("{b: 1}")));
+}
+
+TEST(CompiledMatchExpressionTest, MissingAndNonObjectPrefixesResolveToEOO) {
+    assertSameResult(fromjson("{'a.b': null}"), fromjson("{}"));
+    assertSameResult(fromjson("{'a.b': null}"), fromjson("{a: 1}"));
+    assertSameResult(fromjson("{'a.b': null}"), fromjson("{a: {b: 1}}"));
+    assertSameResult(fromjson("{'a.b': {$exists: false}}"), fromjson("{a: 'str'}"));
+}
+
+TEST(CompiledMatchExpressionTest, FirstDuplicateFieldWins) {
+    assertSameResult(fromjson("{a: 2}"), fromjson("{a: 1, a: 2}"));
+    assertSameResult(fromjson("{'a.b': 2}"), fromjson("{a: {b: 1}, a: {b: 2}}"));
+}
+
+TEST(CompiledMatchExpressionTest, ArraysFallBackToRegularEvaluation) {
+    assertSameResult(fromjson("{a: 2}"), fromjson("{a: [1, 2]}"));
+    assertSameResult(fromjson("{a: [1, 2]}"), fromjson("{a: [1, 2]}"));
+    assertSameResult(fromjson("{'a.b': 2}"), fromjson("{a: [{b: 1}, {b: 2}]}"));
+    assertSameResult(fromjson("{'a.0': 1}"), fromjson("{a: [1, 2]}"));
+    assertSameResult(fromjson("{'a.b': {$size: 2}}"), fromjson("{a: {b: [1, 2]}}"));
+    assertSameResult(fromjson("{a: {$elemMatch: {$gt: 1}}}"), fromjson("{a: [1, 2]}"));
+}
+
+TEST(CompiledMatchExpressionTest, LogicalOperatorsShortCircuit) {
+    assertSameResult(fromjson("{$or: [{a: 1}, {b: 1}]}"), fromjson("{a: 1}"));
+    assertSameResult(fromjson("{$or: [{a: 1}, {b: 1}]}"), fromjson("{a: 2, b: 2}"));
+    assertSameResult(fromjson("{$nor: [{a: 1}, {b: 1}]}"), fromjson("{a: 2, b: 1}"));
+    assertSameResult(fromjson("{$nor: [{a: 1}, {b: 1}]}"), fromjson("{a: 2, b: 2}"));
+    assertSameResult(fromjson("{a: {$not: {$gt: 1}}}"), fromjson("{a: 2}"));
+    assertSameResult(fromjson("{$and: [{a: 1}, {$or: [{b: 1}, {c: 1}]}]}"),
+                     fromjson("{a: 1, c: 1}"));
+}
+
+TEST(CompiledMatchExpressionTest, UnsupportedNodesFallBack) {
+    auto expr = parse(fromjson("{a: 1, $expr: {$eq: ['$b', 2]}}"));
+    auto compiled = CompiledMatchExpression::compile(expr.get());
+    ASSERT_EQ(1U, compiled->numPaths());
+    ASSERT_TRUE(compiled->matchesBSON(fromjson("{a: 1, b: 2}")));
+    ASSERT_FALSE(compiled->matchesBSON(fromjson("{a: 1, b: 3}")));
+}
+
+/**
+ * Generates random documents and filters over a small set of overlapping paths and checks that
+ * the compiled filters always agree with the MatchExpression they were compiled from.
+ */
+class MatchFuzzer {
+public:
+    explicit MatchFuzzer(int64_t seed) : _random(seed) {}
+
+    BSONObj generateDocument(int depth = 0) {
+        static const char* const kFields[] = {"a", "b", "c"};
+        BSONObjBuilder bob;
+        for (const char* field : kFields) {
+            if (_random.nextInt32(4) == 0) {
+                continue;
+            }
+            appendValue(&bob, field, depth);
+        }
+        return bob.obj();
+    }
+
+    BSONObj generateFilter(int depth = 0) {
+        if (depth < 3 && _random.nextInt32(3) == 0) {
+            static const char* const kTreeOps[] = {"$and", "$or", "$nor"};
+            BSONObjBuilder bob;
+            BSONArrayBuilder children(bob.subarrayStart(kTreeOps[_random.nextInt32(3)]));
+            const int numChildren = 1 + _random.nextInt32(3);
+            for (int i = 0; i < numChildren; ++i) {
+                children.append(generateFilter(depth + 1));
+            }
+            children.doneFast();
+            return bob.obj();
+        }
+
+        static const char* const kPaths[] = {"a", "b", "a.b", "a.c", "a.b.c", "b.a", "a.0"};
+        const char* path = kPaths[_random.nextInt32(7)];
+
+        BSONObjBuilder predicate;
+        appendPredicate(&predicate);
+        if (_random.nextInt32(5) == 0) {
+            return BSON(path << BSON("$not" << predicate.obj()));
+        }
+        return BSON(path << predicate.obj());
+    }
+
+private:
+    void appendScalar(BSONObjBuilder* bob, StringData field) {
+        switch (_random.nextInt32(4)) {
+            case 0:
+                bob->append(field, _random.nextInt32(4));
+                break;
+            case 1:
+                bob->append(field, std::string(1, 'x' + _random.nextInt32(3)));
+                break;
+            case 2:
+                bob->appendNull(field);
+                break;
+            default:
+                bob->append(field, _random.nextInt32(4) + 0.5);
+                break;
+        }
+    }
+
+    void appendValue(BSONObjBuilder* bob, StringData field, int depth) {
+        const int kind = _random.nextInt32(depth < 2 ? 4 : 2);
+        if (kind == 2) {
+            bob->append(field, generateDocument(depth + 1));
+        } else if (kind == 3) {
+            BSONArrayBuilder arr(bob->subarrayStart(field));
+            const int numElements = _random.nextInt32(3);
+            for (int i = 0; i < numElements; ++i) {
+                BSONObjBuilder elem;
+                appendValue(&elem, "x", depth + 1);
+                arr.append(elem.obj().firstElement());
+            }
+        } else {
+            appendScalar(bob, field);
+        }
+    }
+
+    void appendPredicate(BSONObjBuilder* bob) {
+        switch (_random.nextInt32(5)) {
+            case 0: {
+                static const char* const kComparisons[] = {"$eq", "$lt", "$lte", "$gt", "$gte"};
+                appendScalar(bob, kComparisons[_random.nextInt32(5)]);
+                break;
+            }
+            case 1:
+                bob->append("$exists", _random.nextInt32(2) == 0);
+                break;
+            case 2: {
+                BSONArrayBuilder arr(bob->subarrayStart("$in"));
+                for (int i = 0; i < 3; ++i) {
+                    BSONObjBuilder elem;
+                    appendScalar(&elem, "x");
+                    arr.append(elem.obj().firstElement());
+                }
+                break;
+            }
+            case 3:
+                bob->append("$type", _random.nextInt32(2) == 0 ? "object" : "number");
+                break;
+            default:
+                appendScalar(bob, "$ne");
+                break;
+        }
+    }
+
+    PseudoRandom _random;
+};
+
+TEST(CompiledMatchExpressionTest, FuzzedFiltersAgreeWithMatchExpression) {
+    MatchFuzzer fuzzer(20180501);
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < 200; ++i) {
+        docs.push_back(fuzzer.generateDocument());
+    }
+
+    for (int i = 0; i < 500; ++i) {
+        BSONObj filter = fuzzer.generateFilter();
+        auto expr = parse(filter);
+        auto compiled = CompiledMatchExpression::compile(expr.get());
+        for (const BSONObj& doc : docs) {
+            ASSERT_EQ(expr->matchesBSON(doc), compiled->matchesBSON(doc))
+                << "filter: " << filter << ", doc: " << doc;
+        }
+    }
+}
+
+}  // namespace
+}  // namespace mongo
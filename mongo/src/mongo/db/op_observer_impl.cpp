@@ -43,12 +43,14 @@
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/query/collection_statistics.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/s/collection_sharding_state.h"
 #include "mongo/db/server_options.h"
 #include "mongo/db/session_catalog.h"
 #include "mongo/db/views/durable_view_catalog.h"
+#include "mongo/db/views/materialized_view_registry.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/fail_point_service.h"
@@ -341,6 +343,8 @@ void OpObserverImpl::onInserts(OperationContext* opCtx,
         Scope::storedFuncMod(opCtx);
     } else if (nss.coll() == DurableViewCatalog::viewsCollectionName()) {
         DurableViewCatalog::onExternalChange(opCtx, nss);
+    } else if (nss.coll() == StatisticsCatalog::kCollectionName) {
+        StatisticsCatalog::get(opCtx)->invalidateDatabase(nss.db());
     } else if (nss.ns() == FeatureCompatibilityVersion::kCollection) {
         for (auto it = begin; it != end; it++) {
             FeatureCompatibilityVersion::onInsertOrUpdate(opCtx, it->doc);
@@ -351,6 +355,9 @@ void OpObserverImpl::onInserts(OperationContext* opCtx,
         }
     }
 
+    StatisticsCatalog::get(opCtx)->noteWrites(opCtx, nss, std::distance(begin, end));
+    MaterializedViewRegistry::get(opCtx)->onInserts(opCtx, nss, begin, end);
+
     std::vector<StmtId> stmtIdsWritten;
     std::transform(begin, end, std::back_inserter(stmtIdsWritten), [](const InsertStatement& stmt) {
         return stmt.stmtId;
@@ -402,6 +409,8 @@ void OpObserverImpl::onUpdate(OperationContext* opCtx, const OplogUpdateEntryArg
         Scope::storedFuncMod(opCtx);
     } else if (args.nss.coll() == DurableViewCatalog::viewsCollectionName()) {
         DurableViewCatalog::onExternalChange(opCtx, args.nss);
+    } else if (args.nss.coll() == StatisticsCatalog::kCollectionName) {
+        StatisticsCatalog::get(opCtx)->invalidateDatabase(args.nss.db());
     } else if (args.nss.ns() == FeatureCompatibilityVersion::kCollection) {
         FeatureCompatibilityVersion::onInsertOrUpdate(opCtx, args.updatedDoc);
     } else if (args.nss == NamespaceString::kSessionTransactionsTableNamespace &&
@@ -409,6 +418,9 @@ void OpObserverImpl::onUpdate(OperationContext* opCtx, const OplogUpdateEntryArg
         SessionCatalog::get(opCtx)->invalidateSessions(opCtx, args.updatedDoc);
     }
 
+    StatisticsCatalog::get(opCtx)->noteWrites(opCtx, args.nss, 1);
+    MaterializedViewRegistry::get(opCtx)->onWrite(opCtx, args.nss);
+
     onWriteOpCompleted(opCtx,
                        args.nss,
                        session,
@@ -454,6 +466,8 @@ void OpObserverImpl::onDelete(OperationContext* opCtx,
         Scope::storedFuncMod(opCtx);
     } else if (nss.coll() == DurableViewCatalog::viewsCollectionName()) {
         DurableViewCatalog::onExternalChange(opCtx, nss);
+    } else if (nss.coll() == StatisticsCatalog::kCollectionName) {
+        StatisticsCatalog::get(opCtx)->invalidateDatabase(nss.db());
     } else if (nss.isAdminDotSystemDotVersion()) {
         auto _id = deleteState.documentKey["_id"];
         if (_id.type() == BSONType::String &&
@@ -464,6 +478,9 @@ void OpObserverImpl::onDelete(OperationContext* opCtx,
         SessionCatalog::get(opCtx)->invalidateSessions(opCtx, deleteState.documentKey);
     }
 
+    StatisticsCatalog::get(opCtx)->noteWrites(opCtx, nss, 1);
+    MaterializedViewRegistry::get(opCtx)->onWrite(opCtx, nss);
+
     onWriteOpCompleted(
         opCtx, nss, session, std::vector<StmtId>{stmtId}, opTime.writeOpTime, opTime.wallClockTime);
 }
@@ -625,6 +642,7 @@ void OpObserverImpl::onDropDatabase(OperationContext* opCtx, const std::string&
     }
 
     NamespaceUUIDCache::get(opCtx).evictNamespacesInDatabase(dbName);
+    StatisticsCatalog::get(opCtx)->invalidateDatabase(dbName);
 
     AuthorizationManager::get(opCtx->getServiceContext())
         ->logOp(opCtx, "c", cmdNss, cmdObj, nullptr);
@@ -659,7 +677,11 @@ repl::OpTime OpObserverImpl::onDropCollection(OperationContext* opCtx,
         FeatureCompatibilityVersion::onDropCollection(opCtx);
     } else if (collectionName == NamespaceString::kSessionTransactionsTableNamespace) {
         SessionCatalog::get(opCtx)->invalidateSessions(opCtx, boost::none);
+    } else if (collectionName.coll() == StatisticsCatalog::kCollectionName) {
+        StatisticsCatalog::get(opCtx)->invalidateDatabase(collectionName.db());
     }
+    StatisticsCatalog::get(opCtx)->invalidate(collectionName);
+    MaterializedViewRegistry::get(opCtx)->onWrite(opCtx, collectionName);
 
     AuthorizationManager::get(opCtx->getServiceContext())
         ->logOp(opCtx, "c", cmdNss, cmdObj, nullptr);
@@ -743,6 +765,12 @@ repl::OpTime OpObserverImpl::onRenameCollection(OperationContext* opCtx,
     if (toCollection.isSystemDotViews())
         DurableViewCatalog::onExternalChange(opCtx, toCollection);
 
+    // The statistics document is keyed by collection name, so it no longer applies to either.
+    StatisticsCatalog::get(opCtx)->invalidate(fromCollection);
+    StatisticsCatalog::get(opCtx)->invalidate(toCollection);
+    MaterializedViewRegistry::get(opCtx)->onWrite(opCtx, fromCollection);
+    MaterializedViewRegistry::get(opCtx)->onWrite(opCtx, toCollection);
+
     AuthorizationManager::get(opCtx->getServiceContext())
         ->logOp(opCtx, "c", cmdNss, cmdObj, nullptr);
 
@@ -809,6 +837,8 @@ void OpObserverImpl::onEmptyCapped(OperationContext* opCtx,
                     {});
     }
 
+    MaterializedViewRegistry::get(opCtx)->onWrite(opCtx, collectionName);
+
     AuthorizationManager::get(opCtx->getServiceContext())
         ->logOp(opCtx, "c", cmdNss, cmdObj, nullptr);
 }
@@ -90,6 +90,7 @@ void finishCurOp(OperationContext* opCtx, CurOp* curOp) {
         long long executionTimeMicros =
             durationCount<Microseconds>(curOp->elapsedTimeExcludingPauses());
         curOp->debug().executionTimeMicros = executionTimeMicros;
+        curOp->debug().setResourceUsageMetrics(opCtx, *curOp);
 
 		log() << "yang test ........................ finishCurOp:";
         recordCurOpMetrics(opCtx);
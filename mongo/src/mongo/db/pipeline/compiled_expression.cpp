@@ -0,0 +1,475 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/compiled_expression.h"
+
+#include <cmath>
+
+#include "mongo/db/pipeline/document.h"
+#include "mongo/platform/overflow_arithmetic.h"
+
+namespace mongo {
+
+namespace {
+
+/**
+ * Returns true if evaluating 'expr' can never throw. The operands of such expressions can be
+ * evaluated eagerly, even by operators which stop evaluating operands after a null one.
+ */
+bool cannotThrow(const Expression* expr) {
+    if (dynamic_cast<const ExpressionConstant*>(expr)) {
+        return true;
+    }
+    auto fieldPath = dynamic_cast<const ExpressionFieldPath*>(expr);
+    return fieldPath && fieldPath->isRootFieldPath();
+}
+
+// The arithmetic helpers below have fast paths for operands of the same numeric type. Each fast
+// path produces exactly the result that ExpressionAdd, ExpressionSubtract or ExpressionMultiply
+// would, and every other case is handed off to the code shared with those expressions.
+
+Value add(const Value& lhs, const Value& rhs) {
+    if (lhs.getType() == rhs.getType()) {
+        switch (lhs.getType()) {
+            case NumberInt:
+                return Value::createIntOrLong(static_cast<long long>(lhs.getInt()) + rhs.getInt());
+            case NumberLong: {
+                long long sum;
+                if (!mongoSignedAddOverflow64(lhs.getLong(), rhs.getLong(), &sum)) {
+                    return Value(sum);
+                }
+                break;
+            }
+            case NumberDouble: {
+                // The compensated summation used by $add may give a zero or NaN result a
+                // different sign or payload, so leave those to it.
+                const double sum = lhs.getDouble() + rhs.getDouble();
+                if (sum != 0 && !std::isnan(sum)) {
+                    return Value(sum);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    ExpressionAdd::Sum sum;
+    if (!sum.add(lhs) || !sum.add(rhs)) {
+        return Value(BSONNULL);
+    }
+    return sum.getValue();
+}
+
+Value subtract(const Value& lhs, const Value& rhs) {
+    if (lhs.getType() == rhs.getType()) {
+        switch (lhs.getType()) {
+            case NumberInt:
+                return Value::createIntOrLong(static_cast<long long>(lhs.getInt()) - rhs.getInt());
+            case NumberDouble:
+                return Value(lhs.getDouble() - rhs.getDouble());
+            default:
+                break;
+        }
+    }
+    return ExpressionSubtract::apply(lhs, rhs);
+}
+
+Value multiply(const Value& lhs, const Value& rhs) {
+    if (lhs.getType() == rhs.getType()) {
+        switch (lhs.getType()) {
+            case NumberInt:
+                return Value::createIntOrLong(static_cast<long long>(lhs.getInt()) * rhs.getInt());
+            case NumberDouble:
+                return Value(lhs.getDouble() * rhs.getDouble());
+            default:
+                break;
+        }
+    }
+
+    ExpressionMultiply::Product product;
+    if (!product.multiply(lhs) || !product.multiply(rhs)) {
+        return Value(BSONNULL);
+    }
+    return product.getValue();
+}
+
+}  // namespace
+
+CompiledExpression::CompiledExpression(boost::intrusive_ptr<Expression> expression)
+    : _expression(std::move(expression)) {}
+
+std::unique_ptr<CompiledExpression> CompiledExpression::compile(
+    const boost::intrusive_ptr<Expression>& expression) {
+    std::unique_ptr<CompiledExpression> compiled(new CompiledExpression(expression));
+    compiled->_result = compiled->compileOperand(expression.get());
+
+    const auto& code = compiled->_code;
+    if (code.empty() || (code.size() == 1 && code[0].op == OpCode::kInterpret)) {
+        // Either a constant or an expression the interpreter would evaluate anyway.
+        return nullptr;
+    }
+    return compiled;
+}
+
+Value CompiledExpression::evaluate(const Document& root) const {
+    Value* const registers = _registers.data();
+
+    size_t pc = 0;
+    const size_t end = _code.size();
+    while (pc < end) {
+        const Instruction& instr = _code[pc++];
+        switch (instr.op) {
+            case OpCode::kLoadField:
+                registers[instr.dst] = loadField(_fields[instr.index], root);
+                break;
+            case OpCode::kInterpret:
+                registers[instr.dst] = _nodes[instr.index]->evaluate(root);
+                break;
+            case OpCode::kMove:
+                registers[instr.dst] = registers[instr.lhs];
+                break;
+            case OpCode::kJump:
+                pc = instr.target;
+                break;
+            case OpCode::kJumpIfFalse:
+                if (!registers[instr.lhs].coerceToBool()) {
+                    pc = instr.target;
+                }
+                break;
+            case OpCode::kJumpIfTrue:
+                if (registers[instr.lhs].coerceToBool()) {
+                    pc = instr.target;
+                }
+                break;
+            case OpCode::kJumpIfNotNullish:
+                if (!registers[instr.lhs].nullish()) {
+                    pc = instr.target;
+                }
+                break;
+            case OpCode::kCoerceToBool:
+                registers[instr.dst] = Value(registers[instr.lhs].coerceToBool());
+                break;
+            case OpCode::kNot:
+                registers[instr.dst] = Value(!registers[instr.lhs].coerceToBool());
+                break;
+            case OpCode::kCompare:
+                registers[instr.dst] = static_cast<const ExpressionCompare*>(_nodes[instr.index])
+                                           ->apply(registers[instr.lhs], registers[instr.rhs]);
+                break;
+            case OpCode::kAdd:
+                registers[instr.dst] = add(registers[instr.lhs], registers[instr.rhs]);
+                break;
+            case OpCode::kSubtract:
+                registers[instr.dst] = subtract(registers[instr.lhs], registers[instr.rhs]);
+                break;
+            case OpCode::kMultiply:
+                registers[instr.dst] = multiply(registers[instr.lhs], registers[instr.rhs]);
+                break;
+            case OpCode::kDivide:
+                registers[instr.dst] =
+                    ExpressionDivide::apply(registers[instr.lhs], registers[instr.rhs]);
+                break;
+            case OpCode::kBeginSum:
+                _sums[instr.index] = ExpressionAdd::Sum();
+                break;
+            case OpCode::kAddToSum:
+                if (!_sums[instr.index].add(registers[instr.lhs])) {
+                    registers[instr.dst] = Value(BSONNULL);
+                    pc = instr.target;
+                }
+                break;
+            case OpCode::kEndSum:
+                registers[instr.dst] = _sums[instr.index].getValue();
+                break;
+            case OpCode::kBeginProduct:
+                _products[instr.index] = ExpressionMultiply::Product();
+                break;
+            case OpCode::kMultiplyProduct:
+                if (!_products[instr.index].multiply(registers[instr.lhs])) {
+                    registers[instr.dst] = Value(BSONNULL);
+                    pc = instr.target;
+                }
+                break;
+            case OpCode::kEndProduct:
+                registers[instr.dst] = _products[instr.index].getValue();
+                break;
+        }
+    }
+
+    return registers[_result];
+}
+
+Value CompiledExpression::loadField(const FieldAccess& field, const Document& root) const {
+    const size_t last = field.names.size() - 1;
+
+    Document current = root;
+    for (size_t i = 0; i < last; ++i) {
+        const Value val = current.getField(field.names[i], field.hashes[i]);
+        switch (val.getType()) {
+            case Object:
+                current = val.getDocument();
+                break;
+            case Array:
+                // The rest of the path applies to each element of the array. This is rare enough
+                // to leave to the interpreter.
+                return field.expression->evaluate(root);
+            default:
+                return Value();
+        }
+    }
+    return current.getField(field.names[last], field.hashes[last]);
+}
+
+CompiledExpression::Register CompiledExpression::compileOperand(const Expression* expr) {
+    if (auto constant = dynamic_cast<const ExpressionConstant*>(expr)) {
+        return constantRegister(constant->getValue());
+    }
+    if (auto fieldPath = dynamic_cast<const ExpressionFieldPath*>(expr)) {
+        // A path of length one refers to a whole variable, such as "$$ROOT".
+        if (fieldPath->isRootFieldPath() && fieldPath->getFieldPath().getPathLength() > 1) {
+            return compileFieldPath(fieldPath);
+        }
+        return compileInterpreted(expr);
+    }
+    if (auto nary = dynamic_cast<const ExpressionNary*>(expr)) {
+        return compileNary(nary);
+    }
+    if (auto coerceToBool = dynamic_cast<const ExpressionCoerceToBool*>(expr)) {
+        return compileUnary(OpCode::kCoerceToBool, coerceToBool->getExpression().get());
+    }
+    return compileInterpreted(expr);
+}
+
+void CompiledExpression::compileInto(const Expression* expr, Register dst) {
+    Register result = compileOperand(expr);
+    if (result != dst) {
+        emit(OpCode::kMove, dst, result, 0);
+    }
+}
+
+CompiledExpression::Register CompiledExpression::compileFieldPath(const ExpressionFieldPath* expr) {
+    FieldAccess field;
+    field.expression = expr;
+
+    // Skip the first component, which names the variable.
+    const FieldPath& path = expr->getFieldPath();
+    for (size_t i = 1; i < path.getPathLength(); ++i) {
+        field.names.push_back(path.getFieldName(i));
+        field.hashes.push_back(DocumentStorage::hashFieldName(path.getFieldName(i)));
+    }
+    _fields.push_back(std::move(field));
+
+    Register dst = newRegister();
+    emit(OpCode::kLoadField, dst, 0, 0, _fields.size() - 1);
+    return dst;
+}
+
+CompiledExpression::Register CompiledExpression::compileNary(const ExpressionNary* expr) {
+    if (dynamic_cast<const ExpressionAdd*>(expr)) {
+        return compileSum(expr);
+    }
+    if (dynamic_cast<const ExpressionMultiply*>(expr)) {
+        return compileProduct(expr);
+    }
+    if (dynamic_cast<const ExpressionSubtract*>(expr)) {
+        return compileBinary(OpCode::kSubtract, expr);
+    }
+    if (dynamic_cast<const ExpressionDivide*>(expr)) {
+        return compileBinary(OpCode::kDivide, expr);
+    }
+    if (dynamic_cast<const ExpressionCompare*>(expr)) {
+        _nodes.push_back(expr);
+        return compileBinary(OpCode::kCompare, expr, _nodes.size() - 1);
+    }
+    if (dynamic_cast<const ExpressionAnd*>(expr)) {
+        return compileLogical(expr, OpCode::kJumpIfFalse, false);
+    }
+    if (dynamic_cast<const ExpressionOr*>(expr)) {
+        return compileLogical(expr, OpCode::kJumpIfTrue, true);
+    }
+    if (dynamic_cast<const ExpressionNot*>(expr)) {
+        return compileUnary(OpCode::kNot, expr->getOperandList()[0].get());
+    }
+    if (dynamic_cast<const ExpressionCond*>(expr)) {
+        return compileCond(expr);
+    }
+    if (dynamic_cast<const ExpressionIfNull*>(expr)) {
+        return compileIfNull(expr);
+    }
+    return compileInterpreted(expr);
+}
+
+CompiledExpression::Register CompiledExpression::compileSum(const ExpressionNary* expr) {
+    const auto& operands = expr->getOperandList();
+    if (operands.size() == 2 && cannotThrow(operands[0].get()) &&
+        cannotThrow(operands[1].get())) {
+        return compileBinary(OpCode::kAdd, expr);
+    }
+
+    // Add the operands one at a time, since evaluation stops at the first nullish operand.
+    const uint32_t sum = _sums.size();
+    _sums.emplace_back();
+
+    Register dst = newRegister();
+    emit(OpCode::kBeginSum, dst, 0, 0, sum);
+    std::vector<size_t> exits;
+    for (auto&& operand : operands) {
+        Register reg = compileOperand(operand.get());
+        exits.push_back(emit(OpCode::kAddToSum, dst, reg, 0, sum));
+    }
+    emit(OpCode::kEndSum, dst, 0, 0, sum);
+    for (auto exit : exits) {
+        patchJumpTarget(exit);
+    }
+    return dst;
+}
+
+CompiledExpression::Register CompiledExpression::compileProduct(const ExpressionNary* expr) {
+    const auto& operands = expr->getOperandList();
+    if (operands.size() == 2 && cannotThrow(operands[0].get()) &&
+        cannotThrow(operands[1].get())) {
+        return compileBinary(OpCode::kMultiply, expr);
+    }
+
+    // Multiply the operands one at a time, since evaluation stops at the first nullish operand.
+    const uint32_t product = _products.size();
+    _products.emplace_back();
+
+    Register dst = newRegister();
+    emit(OpCode::kBeginProduct, dst, 0, 0, product);
+    std::vector<size_t> exits;
+    for (auto&& operand : operands) {
+        Register reg = compileOperand(operand.get());
+        exits.push_back(emit(OpCode::kMultiplyProduct, dst, reg, 0, product));
+    }
+    emit(OpCode::kEndProduct, dst, 0, 0, product);
+    for (auto exit : exits) {
+        patchJumpTarget(exit);
+    }
+    return dst;
+}
+
+CompiledExpression::Register CompiledExpression::compileLogical(const ExpressionNary* expr,
+                                                                OpCode shortCircuit,
+                                                                bool result) {
+    Register dst = newRegister();
+    std::vector<size_t> exits;
+    for (auto&& operand : expr->getOperandList()) {
+        Register reg = compileOperand(operand.get());
+        exits.push_back(emit(shortCircuit, 0, reg, 0));
+    }
+    emit(OpCode::kMove, dst, constantRegister(Value(!result)), 0);
+    const size_t toEnd = emit(OpCode::kJump, 0, 0, 0);
+
+    for (auto exit : exits) {
+        patchJumpTarget(exit);
+    }
+    emit(OpCode::kMove, dst, constantRegister(Value(result)), 0);
+    patchJumpTarget(toEnd);
+    return dst;
+}
+
+CompiledExpression::Register CompiledExpression::compileCond(const ExpressionNary* expr) {
+    const auto& operands = expr->getOperandList();
+    Register cond = compileOperand(operands[0].get());
+    Register dst = newRegister();
+
+    const size_t toElse = emit(OpCode::kJumpIfFalse, 0, cond, 0);
+    compileInto(operands[1].get(), dst);
+    const size_t toEnd = emit(OpCode::kJump, 0, 0, 0);
+
+    patchJumpTarget(toElse);
+    compileInto(operands[2].get(), dst);
+    patchJumpTarget(toEnd);
+    return dst;
+}
+
+CompiledExpression::Register CompiledExpression::compileIfNull(const ExpressionNary* expr) {
+    const auto& operands = expr->getOperandList();
+    Register lhs = compileOperand(operands[0].get());
+    Register dst = newRegister();
+
+    emit(OpCode::kMove, dst, lhs, 0);
+    const size_t toEnd = emit(OpCode::kJumpIfNotNullish, 0, lhs, 0);
+    compileInto(operands[1].get(), dst);
+    patchJumpTarget(toEnd);
+    return dst;
+}
+
+CompiledExpression::Register CompiledExpression::compileUnary(OpCode op,
+                                                              const Expression* operand) {
+    Register reg = compileOperand(operand);
+    Register dst = newRegister();
+    emit(op, dst, reg, 0);
+    return dst;
+}
+
+CompiledExpression::Register CompiledExpression::compileBinary(OpCode op,
+                                                               const ExpressionNary* expr,
+                                                               uint32_t index) {
+    const auto& operands = expr->getOperandList();
+    invariant(operands.size() == 2);
+    Register lhs = compileOperand(operands[0].get());
+    Register rhs = compileOperand(operands[1].get());
+    Register dst = newRegister();
+    emit(op, dst, lhs, rhs, index);
+    return dst;
+}
+
+CompiledExpression::Register CompiledExpression::compileInterpreted(const Expression* expr) {
+    _nodes.push_back(expr);
+    Register dst = newRegister();
+    emit(OpCode::kInterpret, dst, 0, 0, _nodes.size() - 1);
+    return dst;
+}
+
+CompiledExpression::Register CompiledExpression::newRegister() {
+    _registers.emplace_back();
+    return _registers.size() - 1;
+}
+
+CompiledExpression::Register CompiledExpression::constantRegister(Value value) {
+    _registers.push_back(std::move(value));
+    return _registers.size() - 1;
+}
+
+size_t CompiledExpression::emit(
+    OpCode op, Register dst, Register lhs, Register rhs, uint32_t index) {
+    _code.push_back({op, dst, lhs, rhs, index, 0});
+    return _code.size() - 1;
+}
+
+void CompiledExpression::patchJumpTarget(size_t jump) {
+    _code[jump].target = _code.size();
+}
+
+}  // namespace mongo
@@ -0,0 +1,175 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/intrusive_ptr.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/value.h"
+
+namespace mongo {
+
+class Document;
+
+/**
+ * A flattened form of an optimized Expression tree. Rather than recursing through virtual
+ * evaluate() calls, a CompiledExpression runs a flat sequence of instructions over a register file
+ * holding the constants of the tree and the intermediate results of its nodes.
+ *
+ * Constants, field paths rooted at $$ROOT/$$CURRENT, $add, $subtract, $multiply, $divide, the
+ * comparison operators, $and, $or, $not, $cond and $ifNull are compiled into instructions. Each
+ * component of a compiled field path is hashed once, up front, and the arithmetic instructions
+ * have inlined fast paths for operands of matching numeric types. Every other node is compiled
+ * into a call to its own evaluate(), so any optimized Expression can be compiled.
+ *
+ * evaluate() returns the same result as the original Expression for every input, and throws the
+ * same error if the original would throw. In particular, operands are evaluated in the same order
+ * and short-circuiting operators skip the same operands.
+ *
+ * The register file is reused across calls, so evaluate() must not be called concurrently on the
+ * same CompiledExpression.
+ */
+class CompiledExpression {
+    MONGO_DISALLOW_COPYING(CompiledExpression);
+
+public:
+    /**
+     * Compiles 'expression', which should already have been optimized. Returns nullptr if there is
+     * nothing to gain from compiling it, that is if its root would be evaluated by the interpreter
+     * anyway or if it is a constant.
+     */
+    static std::unique_ptr<CompiledExpression> compile(
+        const boost::intrusive_ptr<Expression>& expression);
+
+    /**
+     * Evaluates the compiled expression with respect to the Document given by 'root'.
+     */
+    Value evaluate(const Document& root) const;
+
+    size_t getNumInstructions() const {
+        return _code.size();
+    }
+
+private:
+    using Register = uint32_t;
+
+    enum class OpCode : uint8_t {
+        kLoadField,         // dst = value of _fields[index] in the root document.
+        kInterpret,         // dst = _nodes[index]->evaluate(root).
+        kMove,              // dst = lhs.
+        kJump,              // Continue at 'target'.
+        kJumpIfFalse,       // Continue at 'target' if lhs coerces to false.
+        kJumpIfTrue,        // Continue at 'target' if lhs coerces to true.
+        kJumpIfNotNullish,  // Continue at 'target' if lhs is neither null nor missing.
+        kCoerceToBool,      // dst = lhs coerced to bool.
+        kNot,               // dst = !lhs coerced to bool.
+        kCompare,           // dst = _nodes[index], an ExpressionCompare, applied to lhs and rhs.
+        kAdd,               // dst = lhs + rhs, where neither operand could have thrown.
+        kSubtract,          // dst = lhs - rhs.
+        kMultiply,          // dst = lhs * rhs, where neither operand could have thrown.
+        kDivide,            // dst = lhs / rhs.
+        kBeginSum,          // Resets _sums[index].
+        kAddToSum,          // Adds lhs to _sums[index]. If lhs is nullish, dst = null and continue
+                            // at 'target'.
+        kEndSum,            // dst = _sums[index].
+        kBeginProduct,      // Resets _products[index].
+        kMultiplyProduct,   // Multiplies _products[index] by lhs. If lhs is nullish, dst = null and
+                            // continue at 'target'.
+        kEndProduct,        // dst = _products[index].
+    };
+
+    struct Instruction {
+        OpCode op;
+        Register dst;
+        Register lhs;
+        Register rhs;
+        uint32_t index;
+        uint32_t target;
+    };
+
+    /**
+     * A field path rooted at $$ROOT or $$CURRENT, with the hash of each of its components.
+     */
+    struct FieldAccess {
+        // Used to evaluate the path if it crosses an array.
+        const ExpressionFieldPath* expression;
+        std::vector<StringData> names;
+        std::vector<unsigned> hashes;
+    };
+
+    explicit CompiledExpression(boost::intrusive_ptr<Expression> expression);
+
+    // Compilation helpers. compileOperand() returns the register which holds the value of 'expr'
+    // once its instructions have run, while compileInto() also copies it into 'dst' if needed.
+    Register compileOperand(const Expression* expr);
+    void compileInto(const Expression* expr, Register dst);
+    Register compileFieldPath(const ExpressionFieldPath* expr);
+    Register compileNary(const ExpressionNary* expr);
+    Register compileSum(const ExpressionNary* expr);
+    Register compileProduct(const ExpressionNary* expr);
+    Register compileLogical(const ExpressionNary* expr, OpCode shortCircuit, bool result);
+    Register compileCond(const ExpressionNary* expr);
+    Register compileIfNull(const ExpressionNary* expr);
+    Register compileUnary(OpCode op, const Expression* operand);
+    Register compileBinary(OpCode op, const ExpressionNary* expr, uint32_t index = 0);
+    Register compileInterpreted(const Expression* expr);
+
+    Register newRegister();
+    Register constantRegister(Value value);
+    size_t emit(OpCode op, Register dst, Register lhs, Register rhs, uint32_t index = 0);
+
+    /**
+     * Makes the jump instruction at 'jump' continue at the next instruction to be emitted.
+     */
+    void patchJumpTarget(size_t jump);
+
+    Value loadField(const FieldAccess& field, const Document& root) const;
+
+    // Keeps all of the nodes referred to by '_fields' and '_nodes' alive.
+    boost::intrusive_ptr<Expression> _expression;
+
+    std::vector<Instruction> _code;
+    std::vector<FieldAccess> _fields;
+    std::vector<const Expression*> _nodes;
+    Register _result = 0;
+
+    // Scratch space for evaluate(). The constants of the expression are stored in registers when
+    // compiling and are never overwritten.
+    mutable std::vector<Value> _registers;
+    mutable std::vector<ExpressionAdd::Sum> _sums;
+    mutable std::vector<ExpressionMultiply::Product> _products;
+};
+
+}  // namespace mongo
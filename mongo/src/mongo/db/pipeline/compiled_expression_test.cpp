@@ -0,0 +1,358 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <limits>
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/pipeline/compiled_expression.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/document_value_test_util.h"
+#include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/platform/random.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using boost::intrusive_ptr;
+
+/**
+ * The outcome of evaluating an expression: either a value or the code of the error it threw.
+ */
+struct EvaluationResult {
+    Value value;
+    int errorCode = 0;
+};
+
+template <typename Evaluate>
+EvaluationResult evaluateCatchingErrors(Evaluate&& evaluate) {
+    EvaluationResult result;
+    try {
+        result.value = evaluate();
+    } catch (const DBException& ex) {
+        result.errorCode = ex.code();
+    }
+    return result;
+}
+
+/**
+ * Returns true if 'lhs' and 'rhs' are the same error or identical values, down to the types of
+ * numbers and the sign of zeros. Comparing the values with ValueComparator alone would hide
+ * differences such as 1 vs. 1.0.
+ */
+bool sameResult(const EvaluationResult& lhs, const EvaluationResult& rhs) {
+    if (lhs.errorCode || rhs.errorCode) {
+        return lhs.errorCode == rhs.errorCode;
+    }
+    if (lhs.value.missing() || rhs.value.missing()) {
+        return lhs.value.missing() == rhs.value.missing();
+    }
+    BSONObjBuilder lhsBuilder;
+    lhs.value.addToBsonObj(&lhsBuilder, "result");
+    BSONObjBuilder rhsBuilder;
+    rhs.value.addToBsonObj(&rhsBuilder, "result");
+    return lhsBuilder.obj().binaryEqual(rhsBuilder.obj());
+}
+
+std::string describe(const EvaluationResult& result) {
+    if (result.errorCode) {
+        return str::stream() << "error " << result.errorCode;
+    }
+    return result.value.missing() ? "missing" : result.value.toString();
+}
+
+class CompiledExpressionTest : public unittest::Test {
+protected:
+    intrusive_ptr<Expression> parseAndOptimize(const BSONObj& spec) {
+        return Expression::parseOperand(_expCtx, spec.firstElement(), _expCtx->variablesParseState)
+            ->optimize();
+    }
+
+    /**
+     * Checks that the compiled form of 'expression' produces the same result as the interpreter
+     * for each of 'docs'.
+     */
+    void assertCompiledMatchesInterpreter(const intrusive_ptr<Expression>& expression,
+                                          const std::vector<Document>& docs) {
+        auto compiled = CompiledExpression::compile(expression);
+        for (auto&& doc : docs) {
+            auto expected = evaluateCatchingErrors([&] { return expression->evaluate(doc); });
+            auto actual = evaluateCatchingErrors(
+                [&] { return compiled ? compiled->evaluate(doc) : expression->evaluate(doc); });
+            ASSERT_TRUE(sameResult(expected, actual))
+                << "expression: " << expression->serialize(false).toString()
+                << ", document: " << doc.toString() << ", interpreted: " << describe(expected)
+                << ", compiled: " << describe(actual);
+        }
+    }
+
+    intrusive_ptr<ExpressionContextForTest> _expCtx = new ExpressionContextForTest();
+};
+
+TEST_F(CompiledExpressionTest, DoesNotCompileConstantsOrExpressionsTheInterpreterWouldEvaluate) {
+    ASSERT_FALSE(CompiledExpression::compile(parseAndOptimize(BSON("" << 5))));
+    ASSERT_FALSE(
+        CompiledExpression::compile(parseAndOptimize(fromjson("{'': {$add: [1, 2, 3]}}"))));
+    ASSERT_FALSE(
+        CompiledExpression::compile(parseAndOptimize(fromjson("{'': {$concat: ['$a', '$b']}}"))));
+    ASSERT_FALSE(CompiledExpression::compile(parseAndOptimize(fromjson("{'': '$$ROOT'}"))));
+}
+
+TEST_F(CompiledExpressionTest, EvaluatesFieldPathsAndArithmetic) {
+    auto expression =
+        parseAndOptimize(fromjson("{'': {$add: ['$a', {$multiply: ['$b.c', 2]}, '$$CURRENT.d']}}"));
+    auto compiled = CompiledExpression::compile(expression);
+    ASSERT(compiled);
+
+    ASSERT_VALUE_EQ(compiled->evaluate(Document{{"a", 1}, {"b", Document{{"c", 2}}}, {"d", 3}}),
+                    Value(8));
+    ASSERT_VALUE_EQ(compiled->evaluate(Document{{"a", 1.5}, {"b", Document{{"c", 2}}}, {"d", 3}}),
+                    Value(8.5));
+    ASSERT_VALUE_EQ(compiled->evaluate(Document{{"a", 1}, {"d", 3}}), Value(BSONNULL));
+}
+
+TEST_F(CompiledExpressionTest, FieldPathsThroughArraysMatchInterpreter) {
+    auto expression = parseAndOptimize(fromjson("{'': {$ifNull: ['$a.b.c', 'none']}}"));
+    assertCompiledMatchesInterpreter(
+        expression,
+        {Document(fromjson("{a: [{b: {c: 1}}, {b: [{c: 2}, {c: 3}]}, 4, {b: 5}]}")),
+         Document(fromjson("{a: {b: [{c: 1}, {d: 2}]}}")),
+         Document(fromjson("{a: {b: {c: null}}}")),
+         Document(fromjson("{a: 1}"))});
+}
+
+TEST_F(CompiledExpressionTest, StopsEvaluatingOperandsWhereTheInterpreterDoes) {
+    // Each of these would throw if the division by zero were evaluated.
+    const std::vector<std::string> specs = {
+        "{'': {$add: ['$missing', {$divide: ['$a', 0]}]}}",
+        "{'': {$multiply: ['$missing', '$a', {$divide: ['$a', 0]}]}}",
+        "{'': {$and: ['$f', {$divide: ['$a', 0]}]}}",
+        "{'': {$or: ['$a', {$divide: ['$a', 0]}]}}",
+        "{'': {$cond: ['$f', {$divide: ['$a', 0]}, '$a']}}",
+        "{'': {$ifNull: ['$a', {$divide: ['$a', 0]}]}}",
+    };
+    const Document doc{{"a", 1}, {"f", false}};
+    for (auto&& spec : specs) {
+        auto expression = parseAndOptimize(fromjson(spec));
+        auto compiled = CompiledExpression::compile(expression);
+        ASSERT(compiled) << spec;
+        ASSERT_VALUE_EQ(compiled->evaluate(doc), expression->evaluate(doc));
+    }
+}
+
+TEST_F(CompiledExpressionTest, ThrowsTheSameErrorsAsTheInterpreter) {
+    const Document doc{{"a", 1}, {"s", "str"_sd}, {"d", Date_t::fromMillisSinceEpoch(0)}};
+    ASSERT_THROWS_CODE(
+        CompiledExpression::compile(parseAndOptimize(fromjson("{'': {$add: ['$a', '$s']}}")))
+            ->evaluate(doc),
+        AssertionException,
+        16554);
+    ASSERT_THROWS_CODE(
+        CompiledExpression::compile(
+            parseAndOptimize(fromjson("{'': {$add: ['$d', '$d', {$divide: ['$a', 0]}]}}")))
+            ->evaluate(doc),
+        AssertionException,
+        16612);
+    ASSERT_THROWS_CODE(
+        CompiledExpression::compile(parseAndOptimize(fromjson("{'': {$divide: ['$a', 0]}}")))
+            ->evaluate(doc),
+        AssertionException,
+        16608);
+}
+
+/**
+ * Generates random expressions and documents, favoring the operators and values for which
+ * CompiledExpression has special handling.
+ */
+class ExpressionGenerator {
+public:
+    explicit ExpressionGenerator(int64_t seed) : _random(seed) {}
+
+    BSONObj generateExpression() {
+        return Document{{"", generateOperand(0)}}.toBson();
+    }
+
+    Document generateDocument() {
+        MutableDocument doc;
+        for (auto&& field : {"a", "b", "c", "s", "e", "f", "g"}) {
+            if (_random.nextInt32(4) != 0) {
+                doc.addField(field, generateValue());
+            }
+        }
+        if (_random.nextInt32(3) != 0) {
+            doc.addField("d",
+                         _random.nextInt32(4) == 0
+                             ? generateValue()
+                             : Value(Document{{"x", generateValue()}, {"y", generateValue()}}));
+        }
+        if (_random.nextInt32(3) == 0) {
+            std::vector<Value> elements;
+            for (int i = _random.nextInt32(4); i > 0; --i) {
+                elements.push_back(_random.nextInt32(3) == 0
+                                       ? generateValue()
+                                       : Value(Document{{"x", generateValue()}}));
+            }
+            doc.addField("arr", Value(std::move(elements)));
+        }
+        return doc.freeze();
+    }
+
+private:
+    struct Operator {
+        const char* name;
+        int minArgs;
+        int maxArgs;
+    };
+
+    static constexpr int kMaxDepth = 4;
+
+    Value generateOperand(int depth) {
+        if (depth >= kMaxDepth || _random.nextInt32(3) == 0) {
+            return _random.nextInt32(2) == 0 ? generateFieldPath() : generateValue();
+        }
+
+        static const std::vector<Operator> kOperators = {
+            {"$add", 0, 4},
+            {"$subtract", 2, 2},
+            {"$multiply", 0, 4},
+            {"$divide", 2, 2},
+            {"$eq", 2, 2},
+            {"$ne", 2, 2},
+            {"$gt", 2, 2},
+            {"$gte", 2, 2},
+            {"$lt", 2, 2},
+            {"$lte", 2, 2},
+            {"$cmp", 2, 2},
+            {"$and", 0, 3},
+            {"$or", 0, 3},
+            {"$not", 1, 1},
+            {"$cond", 3, 3},
+            {"$ifNull", 2, 2},
+            // Left to the interpreter, including when nested inside compiled operators.
+            {"$abs", 1, 1},
+            {"$concat", 0, 3},
+            {"$size", 1, 1},
+        };
+        const auto& op = kOperators[_random.nextInt32(kOperators.size())];
+
+        std::vector<Value> args;
+        const int nArgs = op.minArgs + _random.nextInt32(op.maxArgs - op.minArgs + 1);
+        for (int i = 0; i < nArgs; ++i) {
+            args.push_back(generateOperand(depth + 1));
+        }
+        return Value(Document{{op.name, Value(std::move(args))}});
+    }
+
+    Value generateFieldPath() {
+        static const std::vector<std::string> kPaths = {"$a",
+                                                        "$b",
+                                                        "$c",
+                                                        "$s",
+                                                        "$d.x",
+                                                        "$d.y",
+                                                        "$d.x.z",
+                                                        "$arr.x",
+                                                        "$missing",
+                                                        "$$CURRENT.a",
+                                                        "$$ROOT.d.x"};
+        return Value(kPaths[_random.nextInt32(kPaths.size())]);
+    }
+
+    Value generateValue() {
+        static const std::vector<Value> kValues = {
+            Value(0),
+            Value(1),
+            Value(-7),
+            Value(std::numeric_limits<int>::max()),
+            Value(std::numeric_limits<int>::min()),
+            Value(0LL),
+            Value(3LL),
+            Value(std::numeric_limits<long long>::max()),
+            Value(std::numeric_limits<long long>::min()),
+            Value(0.0),
+            Value(-0.0),
+            Value(2.5),
+            Value(-1e308),
+            Value(1e308),
+            Value(std::numeric_limits<double>::quiet_NaN()),
+            Value(std::numeric_limits<double>::infinity()),
+            Value(-std::numeric_limits<double>::infinity()),
+            Value(Decimal128("1.5")),
+            Value(Decimal128("-0")),
+            Value(BSONNULL),
+            Value(true),
+            Value(false),
+            Value("abc"_sd),
+            Value(""_sd),
+            Value(Date_t::fromMillisSinceEpoch(86400000)),
+            Value(Date_t::fromMillisSinceEpoch(-1)),
+        };
+        return kValues[_random.nextInt32(kValues.size())];
+    }
+
+    PseudoRandom _random;
+};
+
+TEST_F(CompiledExpressionTest, RandomExpressionsMatchInterpreter) {
+    ExpressionGenerator generator(20180801);
+
+    std::vector<Document> docs;
+    for (int i = 0; i < 20; ++i) {
+        docs.push_back(generator.generateDocument());
+    }
+
+    int nCompiled = 0;
+    for (int i = 0; i < 2000; ++i) {
+        const BSONObj spec = generator.generateExpression();
+
+        // Constant folding may evaluate, and therefore reject, parts of the expression.
+        intrusive_ptr<Expression> expression;
+        try {
+            expression = parseAndOptimize(spec);
+        } catch (const DBException&) {
+            continue;
+        }
+
+        if (CompiledExpression::compile(expression)) {
+            ++nCompiled;
+        }
+        assertCompiledMatchesInterpreter(expression, docs);
+    }
+
+    // Make sure the generator is exercising the compiler rather than only the interpreter.
+    ASSERT_GT(nCompiled, 500);
+}
+
+}  // namespace
+}  // namespace mongo
@@ -49,26 +49,44 @@ const std::vector<StringData> Document::allMetadataFieldNames = {
     Document::metaFieldTextScore, Document::metaFieldRandVal, Document::metaFieldSortKey};
 
 Position DocumentStorage::findField(StringData requested) const {
-    int reqSize = requested.size();  // get size calculation out of the way if needed
+    if (_numFields >= HASH_TAB_MIN) {  // hash lookup
+        return findFieldInHashTable(requested, hashKey(requested));
+    }
+    return findFieldLinear(requested);
+}
 
+Position DocumentStorage::findField(StringData requested, unsigned requestedHash) const {
+    dassert(requestedHash == hashKey(requested));
     if (_numFields >= HASH_TAB_MIN) {  // hash lookup
-        const unsigned bucket = bucketForKey(requested);
+        return findFieldInHashTable(requested, requestedHash);
+    }
+    return findFieldLinear(requested);
+}
 
-        Position pos = _hashTab[bucket];
-        while (pos.found()) {
-            const ValueElement& elem = getField(pos);
-            if (elem.nameLen == reqSize && memcmp(requested.rawData(), elem._name, reqSize) == 0) {
-                return pos;
-            }
+Position DocumentStorage::findFieldInHashTable(StringData requested, unsigned requestedHash) const {
+    int reqSize = requested.size();  // get size calculation out of the way if needed
 
-            // possible collision
-            pos = elem.nextCollision;
+    Position pos = _hashTab[requestedHash & _hashTabMask];
+    while (pos.found()) {
+        const ValueElement& elem = getField(pos);
+        if (elem.nameLen == reqSize && memcmp(requested.rawData(), elem._name, reqSize) == 0) {
+            return pos;
         }
-    } else {  // linear scan
-        for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
-            if (it->nameLen == reqSize && memcmp(requested.rawData(), it->_name, reqSize) == 0) {
-                return it.position();
-            }
+
+        // possible collision
+        pos = elem.nextCollision;
+    }
+
+    // if we got here, there's no such field
+    return Position();
+}
+
+Position DocumentStorage::findFieldLinear(StringData requested) const {
+    int reqSize = requested.size();  // get size calculation out of the way if needed
+
+    for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
+        if (it->nameLen == reqSize && memcmp(requested.rawData(), it->_name, reqSize) == 0) {
+            return it.position();
         }
     }
 
@@ -136,6 +154,7 @@ void DocumentStorage::alloc(unsigned newSize) {
     const bool firstAlloc = !_buffer;
     const bool doingRehash = needRehash();
     const size_t oldCapacity = _bufferEnd - _buffer;
+    const size_t oldAllocatedBytes = allocatedBytes();
 
     // make new bucket count big enough
     while (needRehash() || hashTabBuckets() < HASH_TAB_INIT_SIZE)
@@ -148,13 +167,13 @@ void DocumentStorage::alloc(unsigned newSize) {
 
     uassert(16490, "Tried to make oversized document", capacity <= size_t(BufferMaxSize));
 
-    std::unique_ptr<char[]> oldBuf(_buffer);
-    _buffer = new char[capacity];
+    char* const oldBuf = _buffer;
+    _buffer = allocateBuffer(capacity);
     _bufferEnd = _buffer + capacity - hashTabBytes();
 
     if (!firstAlloc) {
         // This just copies the elements
-        memcpy(_buffer, oldBuf.get(), _usedBytes);
+        memcpy(_buffer, oldBuf, _usedBytes);
 
         if (_numFields >= HASH_TAB_MIN) {
             // if we were hashing, deal with the hash table
@@ -162,10 +181,24 @@ void DocumentStorage::alloc(unsigned newSize) {
                 rehash();
             } else {
                 // no rehash needed so just slide table down to new position
-                memcpy(_hashTab, oldBuf.get() + oldCapacity, hashTabBytes());
+                memcpy(_hashTab, oldBuf + oldCapacity, hashTabBytes());
             }
         }
     }
+
+    freeBuffer(oldBuf, oldAllocatedBytes);
+}
+
+char* DocumentStorage::allocateBuffer(size_t bytes) {
+    return _arena ? _arena->allocate(bytes) : new char[bytes];
+}
+
+void DocumentStorage::freeBuffer(char* buffer, size_t bytes) {
+    if (_arena) {
+        _arena->deallocate(buffer, bytes);
+    } else {
+        delete[] buffer;
+    }
 }
 
 void DocumentStorage::reserveFields(size_t expectedFields) {
@@ -181,7 +214,7 @@ void DocumentStorage::reserveFields(size_t expectedFields) {
 
     uassert(16491, "Tried to make oversized document", newSize <= size_t(BufferMaxSize));
 
-    _buffer = new char[newSize + hashTabBytes()];
+    _buffer = allocateBuffer(newSize + hashTabBytes());
     _bufferEnd = _buffer + newSize;
 }
 
@@ -191,7 +224,7 @@ intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
     // Make a copy of the buffer.
     // It is very important that the positions of each field are the same after cloning.
     const size_t bufferBytes = allocatedBytes();
-    out->_buffer = new char[bufferBytes];
+    out->_buffer = out->allocateBuffer(bufferBytes);
     out->_bufferEnd = out->_buffer + (_bufferEnd - _buffer);
     if (bufferBytes > 0) {
         memcpy(out->_buffer, _buffer, bufferBytes);
@@ -215,11 +248,11 @@ intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
 }
 
 DocumentStorage::~DocumentStorage() {
-    std::unique_ptr<char[]> deleteBufferAtScopeEnd(_buffer);
-
     for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
         it->val.~Value();  // explicit destructor call
     }
+
+    freeBuffer(_buffer, allocatedBytes());
 }
 
 Document::Document(const BSONObj& bson) {
@@ -380,8 +413,10 @@ size_t Document::getApproximateSize() const {
     if (!_storage)
         return 0;  // we've allocated no memory
 
+    // Counting the whole arena block keeps the memory limits of $group, $sort and the other
+    // stages which estimate their usage from Documents in step with what the arena really holds.
     size_t size = sizeof(DocumentStorage);
-    size += storage().allocatedBytes();
+    size += storage().heldBytes();
 
     for (DocumentStorageIterator it = storage().iterator(); !it.atEnd(); it.advance()) {
         size += it->val.getApproximateSize();
@@ -121,6 +121,13 @@ public:
         return storage().getField(key);
     }
 
+    /// Same as getField(key), where 'keyHash' is DocumentStorage::hashFieldName(key). Useful when
+    /// looking up the same key in many documents.
+    const Value getField(StringData key, unsigned keyHash) const {
+        Position pos = storage().findField(key, keyHash);
+        return pos.found() ? storage().getField(pos).val : Value();
+    }
+
     /// Look up a field by Position. See positionOf and getNestedField.
     const Value operator[](Position pos) const {
         return getField(pos);
@@ -0,0 +1,142 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/document_arena.h"
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+namespace {
+thread_local DocumentArena* currentArena = nullptr;
+}  // namespace
+
+constexpr size_t DocumentArena::kMinBlockBytes;
+constexpr size_t DocumentArena::kNumSizeClasses;
+constexpr size_t DocumentArena::kMaxPooledBlockBytes;
+constexpr size_t DocumentArena::kMaxCachedBytes;
+
+DocumentArena::Scope::Scope(DocumentArena* arena) : _previous(currentArena) {
+    currentArena = arena;
+}
+
+DocumentArena::Scope::~Scope() {
+    currentArena = _previous;
+}
+
+DocumentArena* DocumentArena::current() {
+    return currentArena;
+}
+
+DocumentArena::~DocumentArena() {
+    // Every allocated block holds a reference to its arena, so nothing can still be in use.
+    invariant(_bytesInUse == 0);
+    for (auto head : _freeLists) {
+        while (head) {
+            auto next = head->next;
+            delete[] reinterpret_cast<char*>(head);
+            head = next;
+        }
+    }
+}
+
+size_t DocumentArena::sizeClassFor(size_t bytes) {
+    size_t sizeClass = 0;
+    while (blockBytes(sizeClass) < bytes) {
+        ++sizeClass;
+    }
+    return sizeClass;
+}
+
+size_t DocumentArena::blockBytesFor(size_t bytes) {
+    return bytes > kMaxPooledBlockBytes ? bytes : blockBytes(sizeClassFor(bytes));
+}
+
+char* DocumentArena::allocate(size_t bytes) {
+    if (bytes > kMaxPooledBlockBytes) {
+        Guard guard(this);
+        _bytesInUse += bytes;
+        return new char[bytes];
+    }
+
+    const auto sizeClass = sizeClassFor(bytes);
+    {
+        Guard guard(this);
+        _bytesInUse += blockBytes(sizeClass);
+        if (auto block = _freeLists[sizeClass]) {
+            _freeLists[sizeClass] = block->next;
+            _bytesCached -= blockBytes(sizeClass);
+            return reinterpret_cast<char*>(block);
+        }
+    }
+    return new char[blockBytes(sizeClass)];
+}
+
+void DocumentArena::deallocate(char* block, size_t bytes) {
+    if (!block) {
+        return;
+    }
+
+    if (bytes > kMaxPooledBlockBytes) {
+        {
+            Guard guard(this);
+            _bytesInUse -= bytes;
+        }
+        delete[] block;
+        return;
+    }
+
+    const auto sizeClass = sizeClassFor(bytes);
+    {
+        Guard guard(this);
+        _bytesInUse -= blockBytes(sizeClass);
+        if (_bytesCached + blockBytes(sizeClass) <= kMaxCachedBytes) {
+            auto freeBlock = reinterpret_cast<FreeBlock*>(block);
+            freeBlock->next = _freeLists[sizeClass];
+            _freeLists[sizeClass] = freeBlock;
+            _bytesCached += blockBytes(sizeClass);
+            return;
+        }
+    }
+    delete[] block;
+}
+
+size_t DocumentArena::bytesInUse() const {
+    Guard guard(this);
+    return _bytesInUse;
+}
+
+size_t DocumentArena::bytesCached() const {
+    Guard guard(this);
+    return _bytesCached;
+}
+
+}  // namespace mongo
@@ -0,0 +1,172 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/util/concurrency/spin_lock.h"
+#include "mongo/util/intrusive_counter.h"
+
+namespace mongo {
+
+/**
+ * A pool of memory blocks for the field buffers of Documents built while a pipeline executes.
+ *
+ * Freed buffers are kept on per-size-class free lists and handed out again to the next Document
+ * that needs a buffer of that size class, instead of going back to the global heap. The arena also
+ * counts the bytes held by live buffers.
+ *
+ * A DocumentStorage allocates from the arena installed on the current thread by a Scope when it is
+ * constructed, and keeps a reference to that arena so that Documents may outlive the pipeline that
+ * built them.
+ *
+ * A single-threaded arena is for pipelines whose Documents are only ever touched by one thread at
+ * a time. It takes no lock, and both its own reference count, which every DocumentStorage built
+ * from it holds, and those of the DocumentStorage are updated without atomic read-modify-writes.
+ * A shared arena locks its free lists and leaves reference counts atomic, so that its Documents
+ * may be handed to other threads, as $facet does when it runs its sub-pipelines concurrently.
+ *
+ * The arrays of array Values (RCVector) are allocated from the global heap.
+ */
+class DocumentArena : public RefCountable {
+    MONGO_DISALLOW_COPYING(DocumentArena);
+
+public:
+    /**
+     * Installs an arena as the current thread's arena for its lifetime, restoring the previously
+     * installed one on destruction. 'arena' may be null, in which case Documents constructed in
+     * this scope allocate from the global heap.
+     */
+    class Scope {
+        MONGO_DISALLOW_COPYING(Scope);
+
+    public:
+        explicit Scope(DocumentArena* arena);
+        ~Scope();
+
+    private:
+        DocumentArena* const _previous;
+    };
+
+    explicit DocumentArena(bool singleThreaded) : _singleThreaded(singleThreaded) {
+        if (_singleThreaded) {
+            setSingleThreaded();
+        }
+    }
+    ~DocumentArena();
+
+    /**
+     * Returns the arena installed on this thread, or null if there is none.
+     */
+    static DocumentArena* current();
+
+    /**
+     * Returns the number of bytes an arena holds for a block of 'bytes' bytes, which is the size
+     * of the block's size class. Allocations with a size of their own count as themselves.
+     */
+    static size_t blockBytesFor(size_t bytes);
+
+    bool isSingleThreaded() const {
+        return _singleThreaded;
+    }
+
+    /**
+     * Returns a block of at least 'bytes' bytes. The same 'bytes' must be passed to deallocate().
+     */
+    char* allocate(size_t bytes);
+
+    void deallocate(char* block, size_t bytes);
+
+    /**
+     * Bytes held by blocks handed out and not yet returned, counting each at its size class.
+     */
+    size_t bytesInUse() const;
+
+    /**
+     * Bytes held by returned blocks waiting on the free lists.
+     */
+    size_t bytesCached() const;
+
+    // Blocks are sized in powers of two from kMinBlockBytes up to kMaxPooledBlockBytes. Larger
+    // requests go straight to the global heap.
+    static constexpr size_t kMinBlockBytes = 128;
+    static constexpr size_t kNumSizeClasses = 10;
+    static constexpr size_t kMaxPooledBlockBytes = kMinBlockBytes << (kNumSizeClasses - 1);
+
+    // Returned blocks past this many cached bytes are released to the global heap.
+    static constexpr size_t kMaxCachedBytes = 4 * 1024 * 1024;
+
+private:
+    // Free blocks are linked together through their first bytes.
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static size_t sizeClassFor(size_t bytes);
+
+    static size_t blockBytes(size_t sizeClass) {
+        return kMinBlockBytes << sizeClass;
+    }
+
+    /**
+     * Holds the arena's lock for its lifetime, unless the arena is single-threaded.
+     */
+    class Guard {
+        MONGO_DISALLOW_COPYING(Guard);
+
+    public:
+        explicit Guard(const DocumentArena* arena)
+            : _lock(arena->_singleThreaded ? nullptr : &arena->_lock) {
+            if (_lock) {
+                _lock->lock();
+            }
+        }
+
+        ~Guard() {
+            if (_lock) {
+                _lock->unlock();
+            }
+        }
+
+    private:
+        SpinLock* const _lock;
+    };
+
+    const bool _singleThreaded;
+
+    mutable SpinLock _lock;
+    std::array<FreeBlock*, kNumSizeClasses> _freeLists{};
+    size_t _bytesInUse = 0;
+    size_t _bytesCached = 0;
+};
+
+}  // namespace mongo
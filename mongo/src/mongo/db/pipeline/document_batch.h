@@ -0,0 +1,142 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/document_source.h"
+
+namespace mongo {
+
+/**
+ * A batch of results passed from one DocumentSource to the next by getNextBatch(), along with
+ * whether the source may have more results after them.
+ *
+ * A batch is normally allocated once by the consuming stage and refilled by each call to its
+ * child's getNextBatch(), so that its storage is reused from one batch to the next.
+ *
+ * The documents are stored whole, one per row, rather than as per-field columns sharing a
+ * field-name dictionary: $match, $project and the accumulators of $group evaluate one Document at
+ * a time, so columns would have to be reassembled into Documents at every stage boundary.
+ */
+class DocumentBatch {
+    MONGO_DISALLOW_COPYING(DocumentBatch);
+
+public:
+    using ReturnStatus = DocumentSource::GetNextResult::ReturnStatus;
+    using iterator = std::vector<Document>::iterator;
+
+    explicit DocumentBatch(size_t capacity) : _capacity(std::max<size_t>(capacity, 1)) {
+        _docs.reserve(_capacity);
+    }
+
+    /**
+     * Empties the batch so that it can be refilled.
+     */
+    void clear() {
+        _docs.clear();
+        _status = ReturnStatus::kAdvanced;
+    }
+
+    void push_back(Document&& doc) {
+        dassert(!full());
+        _docs.push_back(std::move(doc));
+    }
+
+    bool full() const {
+        return _docs.size() >= _capacity;
+    }
+
+    bool empty() const {
+        return _docs.empty();
+    }
+
+    size_t size() const {
+        return _docs.size();
+    }
+
+    size_t capacity() const {
+        return _capacity;
+    }
+
+    Document& operator[](size_t i) {
+        return _docs[i];
+    }
+
+    iterator begin() {
+        return _docs.begin();
+    }
+
+    iterator end() {
+        return _docs.end();
+    }
+
+    /**
+     * kEOF or kPauseExecution if the source stopped producing results after the documents in this
+     * batch because it was exhausted or paused, or kAdvanced if it may have more results. A paused
+     * source must be asked for another batch later, exactly as if its getNext() had returned
+     * kPauseExecution after these documents.
+     */
+    ReturnStatus getStatus() const {
+        return _status;
+    }
+
+    void setStatus(ReturnStatus status) {
+        _status = status;
+    }
+
+    bool isEOF() const {
+        return _status == ReturnStatus::kEOF;
+    }
+
+    bool isPaused() const {
+        return _status == ReturnStatus::kPauseExecution;
+    }
+
+    /**
+     * Removes the documents for which 'predicate' returns false, keeping the others in order.
+     */
+    template <typename Predicate>
+    void filter(Predicate predicate) {
+        auto newEnd = std::remove_if(
+            _docs.begin(), _docs.end(), [&](const Document& doc) { return !predicate(doc); });
+        _docs.erase(newEnd, _docs.end());
+    }
+
+private:
+    const size_t _capacity;
+    std::vector<Document> _docs;
+    ReturnStatus _status = ReturnStatus::kAdvanced;
+};
+
+}  // namespace mongo
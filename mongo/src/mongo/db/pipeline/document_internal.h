@@ -34,6 +34,7 @@
 #include <boost/intrusive_ptr.hpp>
 
 #include "mongo/base/static_assert.h"
+#include "mongo/db/pipeline/document_arena.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/util/intrusive_counter.h"
 
@@ -189,7 +190,12 @@ public:
           _hashTabMask(0),
           _metaFields(),
           _textScore(0),
-          _randVal(0) {}
+          _randVal(0),
+          _arena(DocumentArena::current()) {
+        if (_arena && _arena->isSingleThreaded()) {
+            setSingleThreaded();
+        }
+    }
 
     ~DocumentStorage();
 
@@ -221,6 +227,14 @@ public:
     /// Returns the position of the named field (may be missing) or Position()
     Position findField(StringData name) const;
 
+    /// Same as findField(name), where 'nameHash' is hashFieldName(name). Lets callers that look up
+    /// the same name in many documents hash it only once.
+    Position findField(StringData name, unsigned nameHash) const;
+
+    static unsigned hashFieldName(StringData name) {
+        return hashKey(name);
+    }
+
     // Document uses these
     const ValueElement& getField(Position pos) const {
         verify(pos.found());
@@ -270,6 +284,12 @@ public:
         return !_buffer ? 0 : (_bufferEnd - _buffer + hashTabBytes());
     }
 
+    /// The memory held by _buffer, which for a buffer taken from an arena is its whole block.
+    size_t heldBytes() const {
+        return _arena && _buffer ? DocumentArena::blockBytesFor(allocatedBytes())
+                                 : allocatedBytes();
+    }
+
     /**
      * Copies all metadata from source if it has any.
      * Note: does not clear metadata from this.
@@ -328,9 +348,17 @@ private:
     /// Allocates space in _buffer. Copies existing data if there is any.
     void alloc(unsigned newSize);
 
+    /// Allocates and frees blocks for _buffer from _arena, or the global heap if there is none.
+    char* allocateBuffer(size_t bytes);
+    void freeBuffer(char* buffer, size_t bytes);
+
     /// Call after adding field to _buffer and increasing _numFields
     void addFieldToHashTable(Position pos);
 
+    /// Helpers for findField(). The first requires _numFields >= HASH_TAB_MIN.
+    Position findFieldInHashTable(StringData requested, unsigned requestedHash) const;
+    Position findFieldLinear(StringData requested) const;
+
     // assumes _hashTabMask is (power of two) - 1
     unsigned hashTabBuckets() const {
         return _hashTabMask + 1;
@@ -403,6 +431,10 @@ private:
     BSONObj _sortKey;
     // When adding a field, make sure to update clone() method
 
+    // The arena _buffer is allocated from, if any. Not copied by clone(), which allocates from the
+    // arena current at the time.
+    const boost::intrusive_ptr<DocumentArena> _arena;
+
     // Defined in document.cpp
     static const DocumentStorage kEmptyDoc;
 };
@@ -30,7 +30,10 @@
 
 #include "mongo/db/pipeline/document_source.h"
 
+#include <algorithm>
+
 #include "mongo/db/matcher/expression_algo.h"
+#include "mongo/db/pipeline/document_batch.h"
 #include "mongo/db/pipeline/document_source_match.h"
 #include "mongo/db/pipeline/document_source_sequential_document_cache.h"
 #include "mongo/db/pipeline/expression_context.h"
@@ -89,6 +92,18 @@ intrusive_ptr<DocumentSource> DocumentSource::optimize() {
     return this;
 }
 
+void DocumentSource::getNextBatch(DocumentBatch* batch) {
+    batch->clear();
+    while (!batch->full()) {
+        auto next = getNext();
+        if (!next.isAdvanced()) {
+            batch->setStatus(next.getStatus());
+            return;
+        }
+        batch->push_back(next.releaseDocument());
+    }
+}
+
 namespace {
 
 /**
@@ -258,4 +273,31 @@ BSONObjSet DocumentSource::truncateSortSet(const BSONObjSet& sorts,
 
     return out;
 }
+
+BSONObj DocumentSourceNeedsMongoProcessInterface::MongoProcessInterface::makeDocumentKeysFilter(
+    const vector<Document>& documentKeys) {
+    invariant(!documentKeys.empty());
+    const bool idOnly =
+        std::all_of(documentKeys.begin(), documentKeys.end(), [](const Document& documentKey) {
+            return documentKey.size() == 1u && !documentKey["_id"].missing();
+        });
+
+    BSONObjBuilder filter;
+    if (idOnly) {
+        BSONObjBuilder idFilter(filter.subobjStart("_id"));
+        BSONArrayBuilder ids(idFilter.subarrayStart("$in"));
+        for (auto&& documentKey : documentKeys) {
+            documentKey["_id"].addToBsonArray(&ids);
+        }
+        ids.doneFast();
+        idFilter.doneFast();
+    } else {
+        BSONArrayBuilder keys(filter.subarrayStart("$or"));
+        for (auto&& documentKey : documentKeys) {
+            keys.append(documentKey.toBson());
+        }
+        keys.doneFast();
+    }
+    return filter.obj();
+}
 }
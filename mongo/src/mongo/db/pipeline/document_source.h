@@ -59,6 +59,7 @@ namespace mongo {
 
 class AggregationRequest;
 class Document;
+class DocumentBatch;
 
 /**
  * Registers a DocumentSource to have the name 'key'.
@@ -395,6 +396,18 @@ public:
      */
     virtual GetNextResult getNext() = 0;
 
+    /**
+     * The batched form of getNext(). Clears 'batch' and fills it with up to batch->capacity()
+     * results, then sets its status to kEOF or kPauseExecution if this stage stopped producing
+     * results after them, or leaves it at kAdvanced if there may be more. A batch may hold fewer
+     * documents than its capacity, or none, even when its status is kAdvanced.
+     *
+     * The default implementation calls getNext() repeatedly. Stages override it when they can
+     * produce a batch more cheaply, for instance by passing through their child's batch. Calls to
+     * getNext() and getNextBatch() on the same stage may be interleaved.
+     */
+    virtual void getNextBatch(DocumentBatch* batch);
+
     /**
      * Returns a struct containing information about any special constraints imposed on using this
      * stage. Input parameter Pipeline::SplitState is used by stages whose requirements change
@@ -792,6 +805,41 @@ public:
             const BSONObj& originalCollectionOptions,
             const std::list<BSONObj>& originalIndexes) = 0;
 
+        /**
+         * Inserts documents into a collection created by createCollectionForBulkLoading() while
+         * handing their keys to bulk builders for the collection's indexes. The indexes are
+         * missing the keys of the inserted documents until commit() succeeds. Queries and validate
+         * fail on the collection until then, so a collection whose loader is destroyed first
+         * must be dropped.
+         */
+        class BulkLoader {
+        public:
+            virtual ~BulkLoader() = default;
+
+            /**
+             * Inserts 'objs', throwing if any of them could not be inserted or if the collection
+             * was dropped or renamed since the previous call.
+             */
+            virtual void insert(const std::vector<BSONObj>& objs) = 0;
+
+            /**
+             * Builds the indexes from the keys of all inserted documents. Throws on failure, for
+             * example if a unique index found a duplicate key.
+             */
+            virtual void commit() = 0;
+        };
+
+        /**
+         * Creates the collection 'ns' with the given collection options and the empty indexes
+         * described by 'indexSpecs', and returns a BulkLoader which fills them in. An _id index is
+         * added to 'indexSpecs' if it has none, unless the options disable it. Nothing but the
+         * returned loader may write to 'ns' until it has been committed or destroyed.
+         */
+        virtual std::unique_ptr<BulkLoader> createCollectionForBulkLoading(
+            const NamespaceString& ns,
+            const BSONObj& collectionOptions,
+            std::vector<BSONObj> indexSpecs) = 0;
+
         /**
          * Parses a Pipeline from a vector of BSONObjs representing DocumentSources. The state of
          * the returned pipeline will depend upon the supplied MakePipelineOptions:
@@ -852,7 +900,28 @@ public:
             const Document& documentKey,
             boost::optional<BSONObj> readConcern) = 0;
 
+        /**
+         * Looks up the documents with each of the document keys in 'documentKeys', as
+         * lookupSingleDocument() would, using a single query per shard. Returns the documents found
+         * in no particular order. Sets '*complete' to false if some matching documents may be
+         * missing from the results because they did not fit in a single batch; the caller should
+         * look those up individually.
+         */
+        virtual std::vector<Document> lookupDocuments(const NamespaceString& nss,
+                                                      UUID collectionUUID,
+                                                      const std::vector<Document>& documentKeys,
+                                                      boost::optional<BSONObj> readConcern,
+                                                      bool* complete) = 0;
+
         // Add new methods as needed.
+
+    protected:
+        /**
+         * Returns a query filter matching the documents with any of the keys in 'documentKeys',
+         * for use by implementations of lookupDocuments(). Uses an $in over _id if the keys
+         * contain only _id, and an $or of the keys otherwise.
+         */
+        static BSONObj makeDocumentKeysFilter(const std::vector<Document>& documentKeys);
     };
 
     DocumentSourceNeedsMongoProcessInterface(const boost::intrusive_ptr<ExpressionContext>& expCtx)
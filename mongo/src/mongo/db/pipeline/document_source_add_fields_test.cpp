@@ -33,6 +33,7 @@
 #include "mongo/bson/bson_depth.h"
 #include "mongo/db/pipeline/aggregation_context_fixture.h"
 #include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/document_batch.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_add_fields.h"
 #include "mongo/db/pipeline/document_source_mock.h"
@@ -112,6 +113,32 @@ TEST_F(AddFieldsTest, ShouldBeAbleToProcessMultipleDocuments) {
     ASSERT_TRUE(addFields->getNext().isEOF());
 }
 
+TEST_F(AddFieldsTest, ShouldTransformBatchesAndPropagatePauses) {
+    auto addFields = DocumentSourceAddFields::create(BSON("c" << 10), getExpCtx());
+    auto mock = DocumentSourceMock::create({Document{{"a", 1}},
+                                            Document{{"a", 2}},
+                                            DocumentSource::GetNextResult::makePauseExecution(),
+                                            Document{{"a", 3}}});
+    addFields->setSource(mock.get());
+
+    DocumentBatch batch(2);
+    addFields->getNextBatch(&batch);
+    ASSERT_TRUE(batch.getStatus() == DocumentBatch::ReturnStatus::kAdvanced);
+    ASSERT_EQ(batch.size(), 2U);
+    ASSERT_DOCUMENT_EQ(batch[0], (Document{{"a", 1}, {"c", 10}}));
+    ASSERT_DOCUMENT_EQ(batch[1], (Document{{"a", 2}, {"c", 10}}));
+
+    // The pause falls on the boundary between batches.
+    addFields->getNextBatch(&batch);
+    ASSERT_TRUE(batch.isPaused());
+    ASSERT_TRUE(batch.empty());
+
+    addFields->getNextBatch(&batch);
+    ASSERT_TRUE(batch.isEOF());
+    ASSERT_EQ(batch.size(), 1U);
+    ASSERT_DOCUMENT_EQ(batch[0], (Document{{"a", 3}, {"c", 10}}));
+}
+
 TEST_F(AddFieldsTest, ShouldAddReferencedFieldsToDependencies) {
     auto addFields = DocumentSourceAddFields::create(
         fromjson("{a: true, x: '$b', y: {$and: ['$c','$d']}, z: {$meta: 'textScore'}}"),
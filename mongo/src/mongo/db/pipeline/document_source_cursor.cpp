@@ -34,6 +34,7 @@
 #include "mongo/db/db_raii.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/document_batch.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/storage/storage_options.h"
 #include "mongo/util/scopeguard.h"
@@ -63,6 +64,25 @@ DocumentSource::GetNextResult DocumentSourceCursor::getNext() {
     return std::move(out);
 }
 
+void DocumentSourceCursor::getNextBatch(DocumentBatch* batch) {
+    pExpCtx->checkForInterrupt();
+
+    batch->clear();
+    while (!batch->full()) {
+        if (_currentBatch.empty()) {
+            loadBatch();
+
+            if (_currentBatch.empty()) {
+                batch->setStatus(DocumentBatch::ReturnStatus::kEOF);
+                return;
+            }
+        }
+
+        batch->push_back(std::move(_currentBatch.front()));
+        _currentBatch.pop_front();
+    }
+}
+
 void DocumentSourceCursor::loadBatch() {
     if (!_exec) {
         // No more documents.
@@ -83,6 +103,15 @@ void DocumentSourceCursor::loadBatch() {
         {
             ON_BLOCK_EXIT([this] { recordPlanSummaryStats(); });
 
+            // Don't let the executor wait for inserts while a later stage is reading ahead of the
+            // results it has already produced.
+            const bool waitForInserts = shouldWaitForInserts(pExpCtx->opCtx);
+            if (pExpCtx->readingAhead) {
+                shouldWaitForInserts(pExpCtx->opCtx) = false;
+            }
+            ON_BLOCK_EXIT(
+                [this, waitForInserts] { shouldWaitForInserts(pExpCtx->opCtx) = waitForInserts; });
+
             while ((state = _exec->getNext(&resultObj, nullptr)) == PlanExecutor::ADVANCED) {
                 if (_shouldProduceEmptyDocs) {
                     _currentBatch.push_back(Document());
@@ -45,6 +45,7 @@ class DocumentSourceCursor final : public DocumentSource {
 public:
     // virtuals from DocumentSource
     GetNextResult getNext() final;
+    void getNextBatch(DocumentBatch* batch) final;
     const char* getSourceName() const final;
     BSONObjSet getOutputSorts() final {
         return _outputSorts;
@@ -30,6 +30,7 @@
 
 #include "mongo/db/pipeline/document_source_facet.h"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -37,16 +38,27 @@
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/bson/bsontypes.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/document_source_tee_consumer.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/field_path.h"
+#include "mongo/db/pipeline/document_source_sample.h"
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/pipeline/tee_buffer.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -59,11 +71,12 @@ DocumentSourceFacet::DocumentSourceFacet(std::vector<FacetPipeline> facetPipelin
                                          const intrusive_ptr<ExpressionContext>& expCtx)
     : DocumentSourceNeedsMongoProcessInterface(expCtx),
       _teeBuffer(TeeBuffer::create(facetPipelines.size())),
-      _facets(std::move(facetPipelines)) {
+      _facets(std::move(facetPipelines)),
+      _facetStates(_facets.size()) {
     for (size_t facetId = 0; facetId < _facets.size(); ++facetId) {
         auto& facet = _facets[facetId];
-        facet.pipeline->addInitialSource(
-            DocumentSourceTeeConsumer::create(pExpCtx, facetId, _teeBuffer));
+        facet.pipeline->addInitialSource(DocumentSourceTeeConsumer::create(
+            facet.pipeline->getContext(), facetId, _teeBuffer));
     }
 }
 
@@ -106,6 +119,65 @@ vector<pair<string, vector<BSONObj>>> extractRawPipelines(const BSONElement& ele
     }
     return rawFacetPipelines;
 }
+
+/**
+ * Returns the threads which help drain the sub-pipelines of $facet stages. The pool is shared by
+ * all $facet stages and intentionally never destroyed, so it needs no shutdown ordering.
+ */
+ThreadPool* getFacetWorkerPool() {
+    static ThreadPool* const pool = [] {
+        ThreadPool::Options options;
+        options.poolName = "FacetWorkerPool";
+        options.threadNamePrefix = "facetWorker";
+        options.minThreads = 0;
+        options.maxThreads = std::max(2u, stdx::thread::hardware_concurrency());
+        auto workerPool = new ThreadPool(options);
+        workerPool->startup();
+        return workerPool;
+    }();
+    return pool;
+}
+
+/**
+ * The sub-pipelines to drain for one batch of input. Participating threads claim them one at a
+ * time until none are left. Held by shared_ptr, since a pool thread may only pick up its task
+ * after the batch has been fully drained by others.
+ */
+struct FacetBatch {
+    explicit FacetBatch(vector<size_t> ids)
+        : facetIds(std::move(ids)), statuses(facetIds.size(), Status::OK()) {}
+
+    void work(const stdx::function<void(size_t)>& drain) {
+        for (size_t i = nextToClaim.fetchAndAdd(1); i < facetIds.size();
+             i = nextToClaim.fetchAndAdd(1)) {
+            Status status = Status::OK();
+            try {
+                drain(facetIds[i]);
+            } catch (...) {
+                status = exceptionToStatus();
+            }
+
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            statuses[i] = std::move(status);
+            if (++nDrained == facetIds.size()) {
+                allDrained.notify_all();
+            }
+        }
+    }
+
+    void waitUntilDrained() {
+        stdx::unique_lock<stdx::mutex> lk(mutex);
+        allDrained.wait(lk, [&] { return nDrained == facetIds.size(); });
+    }
+
+    const vector<size_t> facetIds;
+    vector<Status> statuses;
+    AtomicUInt64 nextToClaim{0};
+
+    stdx::mutex mutex;
+    stdx::condition_variable allDrained;
+    size_t nDrained = 0;
+};
 }  // namespace
 
 std::unique_ptr<DocumentSourceFacet::LiteParsed> DocumentSourceFacet::LiteParsed::parse(
@@ -155,10 +227,21 @@ void DocumentSourceFacet::setSource(DocumentSource* source) {
 }
 
 void DocumentSourceFacet::doDispose() {
+    disposeFacetPipelines();
+    for (auto&& state : _facetStates) {
+        state.spilledOutput.clear();
+    }
+}
+
+void DocumentSourceFacet::disposeFacetPipelines() {
+    if (_facetPipelinesDisposed) {
+        return;
+    }
     for (auto&& facet : _facets) {
         facet.pipeline.get_deleter().dismissDisposal();
         facet.pipeline->dispose(pExpCtx->opCtx);
     }
+    _facetPipelinesDisposed = true;
 }
 
 DocumentSource::GetNextResult DocumentSourceFacet::getNext() {
@@ -169,21 +252,50 @@ DocumentSource::GetNextResult DocumentSourceFacet::getNext() {
     }
 
     vector<vector<Value>> results(_facets.size());
-    bool allPipelinesEOF = false;
-    while (!allPipelinesEOF) {
-        allPipelinesEOF = true;  // Set this to false if any pipeline isn't EOF.
-        for (size_t facetId = 0; facetId < _facets.size(); ++facetId) {
-            const auto& pipeline = _facets[facetId].pipeline;
-            auto next = pipeline->getSources().back()->getNext();
-            for (; next.isAdvanced(); next = pipeline->getSources().back()->getNext()) {
-                results[facetId].emplace_back(next.releaseDocument());
+    if (canRunFacetsConcurrently()) {
+        runFacetsConcurrently(&results);
+    } else {
+        bool allPipelinesEOF = false;
+        while (!allPipelinesEOF) {
+            allPipelinesEOF = true;  // Set this to false if any pipeline isn't EOF.
+            for (size_t facetId = 0; facetId < _facets.size(); ++facetId) {
+                drainFacet(facetId, &results[facetId]);
+                allPipelinesEOF = allPipelinesEOF && _facetStates[facetId].exhausted;
             }
-            allPipelinesEOF = allPipelinesEOF && next.isEOF();
         }
     }
 
+    auto& opDebug = CurOp::get(pExpCtx->opCtx)->debug();
+    for (size_t facetId = 0; facetId < _facets.size(); ++facetId) {
+        opDebug.addFacetExecutionMillis(
+            _facets[facetId].name,
+            durationCount<Milliseconds>(_facetStates[facetId].executionTime));
+    }
+
+    // Every sub-pipeline is exhausted, so the memory held by their stages can be released before
+    // any output written to disk is read back.
+    const bool anySpilled =
+        std::any_of(_facetStates.begin(), _facetStates.end(), [](const FacetState& state) {
+            return !state.spilledOutput.empty();
+        });
+    if (anySpilled) {
+        disposeFacetPipelines();
+    }
+
     MutableDocument resultDoc;
     for (size_t facetId = 0; facetId < _facets.size(); ++facetId) {
+        auto& spilledOutput = _facetStates[facetId].spilledOutput;
+        if (!spilledOutput.empty()) {
+            vector<Value> output;
+            for (auto&& file : spilledOutput) {
+                while (file->more()) {
+                    output.emplace_back(file->next().second);
+                }
+            }
+            spilledOutput.clear();
+            std::move(results[facetId].begin(), results[facetId].end(), std::back_inserter(output));
+            results[facetId] = std::move(output);
+        }
         resultDoc[_facets[facetId].name] = Value(std::move(results[facetId]));
     }
 
@@ -191,12 +303,124 @@ DocumentSource::GetNextResult DocumentSourceFacet::getNext() {
     return resultDoc.freeze();
 }
 
+void DocumentSourceFacet::drainFacet(size_t facetId, vector<Value>* results) {
+    Timer timer;
+    auto& state = _facetStates[facetId];
+    const size_t maxOutputBytes = internalQueryFacetBufferSizeBytes.load();
+    const auto& pipeline = _facets[facetId].pipeline;
+    auto next = pipeline->getSources().back()->getNext();
+    for (; next.isAdvanced(); next = pipeline->getSources().back()->getNext()) {
+        state.outputBytes += next.getDocument().getApproximateSize();
+        results->emplace_back(next.releaseDocument());
+        if (pExpCtx->allowDiskUse && state.outputBytes > maxOutputBytes) {
+            spillFacetOutput(facetId, results);
+        }
+    }
+    state.exhausted = next.isEOF();
+    state.executionTime += Milliseconds(timer.millis());
+}
+
+void DocumentSourceFacet::spillFacetOutput(size_t facetId, vector<Value>* results) {
+    // The output is read back from start to finish, so it is written out in its original order.
+    SortedFileWriter<Value, Document> writer(SortOptions().TempDir(pExpCtx->tempDir));
+    for (auto&& result : *results) {
+        writer.addAlreadySorted(Value(), result.getDocument());
+    }
+    results->clear();
+
+    auto& state = _facetStates[facetId];
+    state.spilledOutput.emplace_back(writer.done());
+    state.outputBytes = 0;
+}
+
+bool DocumentSourceFacet::canRunFacetsConcurrently() const {
+    if (_facets.size() < 2 || internalQueryFacetMaxParallelism.load() < 2) {
+        return false;
+    }
+
+    // Documents from a single-threaded arena may not be touched by the worker threads.
+    if (pExpCtx->documentArena && pExpCtx->documentArena->isSingleThreaded()) {
+        return false;
+    }
+
+    return std::all_of(_facets.begin(), _facets.end(), [&](const FacetPipeline& facet) {
+        // Sub-pipelines sharing the $facet's ExpressionContext also share its variables and
+        // interrupt counter, so they must stay on the operation's thread.
+        if (facet.pipeline->getContext() == pExpCtx) {
+            return false;
+        }
+
+        // Stages which reach the storage engine or other nodes, or which use the Client's random
+        // number generator, are not safe to run off the operation's thread.
+        const auto& sources = facet.pipeline->getSources();
+        return std::none_of(sources.begin(), sources.end(), [](const auto& source) {
+            return dynamic_cast<DocumentSourceNeedsMongoProcessInterface*>(source.get()) ||
+                dynamic_cast<DocumentSourceSample*>(source.get());
+        });
+    });
+}
+
+void DocumentSourceFacet::runFacetsConcurrently(vector<vector<Value>>* results) {
+    _teeBuffer->enableConcurrentConsumers();
+
+    // Only the operation's thread may use the OperationContext, so the sub-pipelines, which have
+    // contexts of their own, do not see it while they are drained.
+    for (auto&& facet : _facets) {
+        facet.pipeline->detachFromOperationContext();
+    }
+    ON_BLOCK_EXIT([&] {
+        for (auto&& facet : _facets) {
+            facet.pipeline->reattachToOperationContext(pExpCtx->opCtx);
+        }
+    });
+
+    const auto drain = [this, results](size_t facetId) {
+        drainFacet(facetId, &(*results)[facetId]);
+    };
+
+    while (true) {
+        vector<size_t> facetIds;
+        for (size_t facetId = 0; facetId < _facets.size(); ++facetId) {
+            if (!_facetStates[facetId].exhausted) {
+                facetIds.push_back(facetId);
+            }
+        }
+        if (facetIds.empty()) {
+            break;
+        }
+
+        // Only this thread reads the input, which may be a cursor holding storage engine state.
+        _teeBuffer->loadNextBatchForConcurrentConsumers();
+
+        auto batch = std::make_shared<FacetBatch>(std::move(facetIds));
+        const size_t nThreads = std::min<size_t>(
+            batch->facetIds.size(), std::max(internalQueryFacetMaxParallelism.load(), 1));
+        for (size_t i = 1; i < nThreads; ++i) {
+            // If the pool refuses the task, this thread just drains more sub-pipelines itself.
+            getFacetWorkerPool()->schedule([batch, drain] { batch->work(drain); }).ignore();
+        }
+        batch->work(drain);
+        batch->waitUntilDrained();
+
+        for (auto&& status : batch->statuses) {
+            uassertStatusOK(status);
+        }
+        pExpCtx->opCtx->checkForInterrupt();
+    }
+}
+
 Value DocumentSourceFacet::serialize(boost::optional<ExplainOptions::Verbosity> explain) const {
     MutableDocument serialized;
     for (auto&& facet : _facets) {
         serialized[facet.name] = Value(explain ? facet.pipeline->writeExplainOps(*explain)
                                                : facet.pipeline->serialize());
     }
+
+    if (explain) {
+        // Facet names may not start with '$', so this cannot collide with a facet's explain.
+        serialized["$concurrent"] = Value(canRunFacetsConcurrently());
+    }
+
     return Value(Document{{"$facet", serialized.freezeToValue()}});
 }
 
@@ -241,13 +465,6 @@ void DocumentSourceFacet::doReattachToOperationContext(OperationContext* opCtx)
 
 DocumentSource::StageConstraints DocumentSourceFacet::constraints(
     Pipeline::SplitState pipeState) const {
-    const bool mayUseDisk = std::any_of(_facets.begin(), _facets.end(), [&](const auto& facet) {
-        const auto sources = facet.pipeline->getSources();
-        return std::any_of(sources.begin(), sources.end(), [&](const auto source) {
-            return source->constraints().diskRequirement == DiskUseRequirement::kWritesTmpData;
-        });
-    });
-
     // Currently we don't split $facet to have a merger part and a shards part (see SERVER-24154).
     // This means that if any stage in any of the $facet pipelines requires the primary shard, then
     // the entire $facet must happen on the merger, and the merger must be the primary shard.
@@ -259,10 +476,11 @@ DocumentSource::StageConstraints DocumentSourceFacet::constraints(
             });
         });
 
+    // The output of the sub-pipelines may be written to disk as well.
     return {StreamType::kBlocking,
             PositionRequirement::kNone,
             needsPrimaryShard ? HostTypeRequirement::kPrimaryShard : HostTypeRequirement::kAnyShard,
-            mayUseDisk ? DiskUseRequirement::kWritesTmpData : DiskUseRequirement::kNoDiskUse,
+            DiskUseRequirement::kWritesTmpData,
             FacetRequirement::kNotAllowed};
 }
 
@@ -292,11 +510,18 @@ DocumentSource::GetDepsReturn DocumentSourceFacet::getDependencies(DepsTracker*
 intrusive_ptr<DocumentSource> DocumentSourceFacet::createFromBson(
     BSONElement elem, const intrusive_ptr<ExpressionContext>& expCtx) {
 
+    // Unless the sub-pipelines can refer to variables defined outside the $facet, parse each of
+    // them with its own copy of the ExpressionContext. They then have separate variables and
+    // interrupt counters, which allows them to run concurrently.
+    const bool isolateSubPipelines = !expCtx->variablesParseState.hasDefinedVariables();
+
     std::vector<FacetPipeline> facetPipelines;
     for (auto&& rawFacet : extractRawPipelines(elem)) {
         const auto facetName = rawFacet.first;
 
-        auto pipeline = uassertStatusOK(Pipeline::parseFacetPipeline(rawFacet.second, expCtx));
+        auto pipeline = uassertStatusOK(Pipeline::parseFacetPipeline(
+            rawFacet.second,
+            isolateSubPipelines ? expCtx->copyWith(expCtx->ns, expCtx->uuid) : expCtx));
 
         facetPipelines.emplace_back(facetName, std::move(pipeline));
     }
@@ -304,3 +529,6 @@ intrusive_ptr<DocumentSource> DocumentSourceFacet::createFromBson(
     return new DocumentSourceFacet(std::move(facetPipelines), expCtx);
 }
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
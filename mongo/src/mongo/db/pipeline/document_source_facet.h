@@ -37,6 +37,8 @@
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
 #include "mongo/db/pipeline/lite_parsed_pipeline.h"
 #include "mongo/db/pipeline/pipeline.h"
+#include "mongo/db/sorter/sorter.h"
+#include "mongo/util/duration.h"
 
 namespace mongo {
 
@@ -150,9 +152,59 @@ private:
 
     Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
 
+    /**
+     * Returns true if the sub-pipelines may be drained on worker threads. This requires more than
+     * one sub-pipeline, internalQueryFacetMaxParallelism of at least 2, and that every sub-pipeline
+     * was parsed with its own ExpressionContext and contains only stages that transform documents
+     * in memory.
+     */
+    bool canRunFacetsConcurrently() const;
+
+    /**
+     * Pulls from the sub-pipeline 'facetId' until it pauses or is exhausted, appending its output
+     * to 'results'. If disk use is allowed, 'results' is written to a temporary file whenever it
+     * holds more than internalQueryFacetBufferSizeBytes.
+     */
+    void drainFacet(size_t facetId, std::vector<Value>* results);
+
+    /**
+     * Writes the output of sub-pipeline 'facetId' held in 'results' to a temporary file, and
+     * empties 'results'.
+     */
+    void spillFacetOutput(size_t facetId, std::vector<Value>* results);
+
+    /**
+     * Disposes of the sub-pipelines, unless that has been done already.
+     */
+    void disposeFacetPipelines();
+
+    /**
+     * Feeds the input to the sub-pipelines one TeeBuffer batch at a time. Each batch is drained by
+     * the operation's thread together with up to internalQueryFacetMaxParallelism - 1 threads from
+     * a worker pool shared by all $facet stages. The sub-pipelines are detached from the
+     * OperationContext meanwhile, and the operation's thread checks for interrupts between
+     * batches.
+     */
+    void runFacetsConcurrently(std::vector<std::vector<Value>>* results);
+
     boost::intrusive_ptr<TeeBuffer> _teeBuffer;
     std::vector<FacetPipeline> _facets;
 
+    // Execution state of each sub-pipeline, indexed like '_facets'. Each entry is only written by
+    // the thread currently draining that sub-pipeline.
+    struct FacetState {
+        bool exhausted = false;
+        Milliseconds executionTime{0};
+
+        // The size of the output held in memory, and the files holding the output written to disk
+        // before it, in order.
+        size_t outputBytes = 0;
+        std::vector<std::unique_ptr<Sorter<Value, Document>::Iterator>> spilledOutput;
+    };
+    std::vector<FacetState> _facetStates;
+
+    bool _facetPipelinesDisposed = false;
+
     bool _done = false;
 };
 }  // namespace mongo
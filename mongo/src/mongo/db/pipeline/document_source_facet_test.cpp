@@ -37,14 +37,18 @@
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/bson/bsontypes.h"
 #include "mongo/bson/json.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/pipeline/aggregation_context_fixture.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/document_source_limit.h"
 #include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/document_source_skip.h"
 #include "mongo/db/pipeline/document_value_test_util.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/unittest/death_test.h"
+#include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 using std::deque;
@@ -464,6 +468,225 @@ TEST_F(DocumentSourceFacetTest, ShouldPropogateDetachingAndReattachingOfOpCtx) {
     ASSERT_FALSE(secondDummy->isDetachedFromOpCtx);
 }
 
+TEST_F(DocumentSourceFacetTest, ConcurrentExecutionShouldProduceSameResultsAsSequential) {
+    auto ctx = getExpCtx();
+
+    // Use tiny batches so that the sub-pipelines pause and resume many times.
+    const auto oldBufferSize = internalQueryFacetBufferSizeBytes.load();
+    const auto oldParallelism = internalQueryFacetMaxParallelism.load();
+    ON_BLOCK_EXIT([&] {
+        internalQueryFacetBufferSizeBytes.store(oldBufferSize);
+        internalQueryFacetMaxParallelism.store(oldParallelism);
+    });
+    internalQueryFacetBufferSizeBytes.store(100);
+
+    const auto spec = fromjson(
+        "{$facet: {"
+        "  byBucket: [{$group: {_id: {$mod: ['$x', 7]}, n: {$sum: 1}}}, {$sort: {_id: 1}}],"
+        "  evens: [{$match: {x: {$mod: [2, 0]}}}, {$count: 'n'}],"
+        "  top: [{$sort: {x: -1}}, {$limit: 3}, {$project: {_id: 0, x: 1}}],"
+        "  first: [{$limit: 2}],"
+        "  squares: [{$project: {_id: 0, sq: {$let: {vars: {v: '$x'}, in: {$multiply: "
+        "['$$v', '$$v']}}}}}, {$skip: 295}]"
+        "}}");
+
+    auto runFacet = [&](int parallelism, bool expectConcurrent) {
+        internalQueryFacetMaxParallelism.store(parallelism);
+
+        deque<DocumentSource::GetNextResult> inputs;
+        for (int i = 0; i < 300; ++i) {
+            inputs.emplace_back(Document{{"_id", i}, {"x", i}});
+        }
+        auto mock = DocumentSourceMock::create(inputs);
+
+        auto facetStage = DocumentSourceFacet::createFromBson(spec.firstElement(), ctx);
+        facetStage->setSource(mock.get());
+
+        vector<Value> explain;
+        facetStage->serializeToArray(explain, ExplainOptions::Verbosity::kQueryPlanner);
+        ASSERT_EQ(explain.size(), 1UL);
+        ASSERT_EQ(explain[0].getDocument().size(), 1UL);
+        ASSERT_VALUE_EQ(explain[0]["$facet"]["$concurrent"], Value(expectConcurrent));
+
+        auto output = facetStage->getNext();
+        ASSERT(output.isAdvanced());
+        ASSERT(facetStage->getNext().isEOF());
+        return output.releaseDocument();
+    };
+
+    auto sequential = runFacet(1, false);
+    auto concurrent = runFacet(4, true);
+    ASSERT_DOCUMENT_EQ(concurrent, sequential);
+
+    ASSERT_VALUE_EQ(sequential["evens"], Value(vector<Value>{Value(Document{{"n", 150}})}));
+    ASSERT_EQ(sequential["byBucket"].getArrayLength(), 7UL);
+    ASSERT_EQ(sequential["first"].getArrayLength(), 2UL);
+    ASSERT_VALUE_EQ(sequential["squares"][4], Value(Document{{"sq", 299 * 299}}));
+}
+
+TEST_F(DocumentSourceFacetTest, ShouldSpillFacetOutputWhenAllowedToUseDisk) {
+    auto ctx = getExpCtx();
+    unittest::TempDir tempDir("DocumentSourceFacetTest");
+    ctx->tempDir = tempDir.path();
+    ctx->allowDiskUse = true;
+
+    // Each sub-pipeline writes its output to disk every few documents.
+    const auto oldBufferSize = internalQueryFacetBufferSizeBytes.load();
+    const auto oldParallelism = internalQueryFacetMaxParallelism.load();
+    ON_BLOCK_EXIT([&] {
+        internalQueryFacetBufferSizeBytes.store(oldBufferSize);
+        internalQueryFacetMaxParallelism.store(oldParallelism);
+    });
+    internalQueryFacetBufferSizeBytes.store(500);
+
+    const auto spec = fromjson(
+        "{$facet: {"
+        "  all: [{$project: {_id: 0, x: 1}}],"
+        "  evens: [{$match: {x: {$mod: [2, 0]}}}, {$project: {_id: 0, x: 1}}]"
+        "}}");
+
+    for (int parallelism : {1, 4}) {
+        internalQueryFacetMaxParallelism.store(parallelism);
+
+        deque<DocumentSource::GetNextResult> inputs;
+        for (int i = 0; i < 300; ++i) {
+            inputs.emplace_back(Document{{"_id", i}, {"x", i}});
+        }
+        auto mock = DocumentSourceMock::create(inputs);
+
+        auto facetStage = DocumentSourceFacet::createFromBson(spec.firstElement(), ctx);
+        facetStage->setSource(mock.get());
+
+        auto output = facetStage->getNext();
+        ASSERT(output.isAdvanced());
+        ASSERT(facetStage->getNext().isEOF());
+
+        // The output keeps its order across the files it was written to.
+        auto all = output.getDocument()["all"];
+        ASSERT_EQ(all.getArrayLength(), 300UL);
+        auto evens = output.getDocument()["evens"];
+        ASSERT_EQ(evens.getArrayLength(), 150UL);
+        for (int i = 0; i < 300; ++i) {
+            ASSERT_VALUE_EQ(all[i], Value(Document{{"x", i}}));
+            if (i % 2 == 0) {
+                ASSERT_VALUE_EQ(evens[i / 2], Value(Document{{"x", i}}));
+            }
+        }
+        facetStage->dispose();
+    }
+
+    // The time spent in each sub-pipeline is reported once per facet name.
+    const auto& facetExecutionMillis = CurOp::get(ctx->opCtx)->debug().facetExecutionMillis;
+    ASSERT_EQ(facetExecutionMillis.size(), 2UL);
+    ASSERT_EQ(facetExecutionMillis[0].first, "all");
+    ASSERT_EQ(facetExecutionMillis[1].first, "evens");
+}
+
+/**
+ * A stage which passes its input through, and records whether 'observed' was attached to an
+ * OperationContext whenever it was asked for a result.
+ */
+class DocumentSourceObservesOpCtx final : public DocumentSourceMock {
+public:
+    explicit DocumentSourceObservesOpCtx(boost::intrusive_ptr<ExpressionContext> observed)
+        : DocumentSourceMock({}), observed(std::move(observed)) {}
+
+    StageConstraints constraints(Pipeline::SplitState pipeState) const final {
+        return {StreamType::kStreaming,
+                PositionRequirement::kNone,
+                HostTypeRequirement::kNone,
+                DiskUseRequirement::kNoDiskUse,
+                FacetRequirement::kAllowed};
+    }
+
+    DocumentSource::GetNextResult getNext() final {
+        sawOpCtx = sawOpCtx || observed->opCtx;
+        return pSource->getNext();
+    }
+
+    boost::intrusive_ptr<ExpressionContext> observed;
+    bool sawOpCtx = false;
+};
+
+TEST_F(DocumentSourceFacetTest, ConcurrentSubPipelinesShouldBeDetachedFromTheOperation) {
+    auto ctx = getExpCtx();
+
+    const auto oldParallelism = internalQueryFacetMaxParallelism.load();
+    ON_BLOCK_EXIT([&] { internalQueryFacetMaxParallelism.store(oldParallelism); });
+    internalQueryFacetMaxParallelism.store(4);
+
+    std::vector<DocumentSourceFacet::FacetPipeline> facets;
+    std::vector<boost::intrusive_ptr<DocumentSourceObservesOpCtx>> stages;
+    for (auto&& name : {"one", "two"}) {
+        auto subCtx = ctx->copyWith(ctx->ns);
+        stages.push_back(new DocumentSourceObservesOpCtx(subCtx));
+        facets.emplace_back(name,
+                            uassertStatusOK(Pipeline::createFacetPipeline({stages.back()}, subCtx)));
+    }
+    auto facetStage = DocumentSourceFacet::create(std::move(facets), ctx);
+
+    deque<DocumentSource::GetNextResult> inputs = {
+        Document{{"_id", 0}}, Document{{"_id", 1}}, Document{{"_id", 2}}};
+    auto mock = DocumentSourceMock::create(inputs);
+    facetStage->setSource(mock.get());
+
+    vector<Value> explain;
+    facetStage->serializeToArray(explain, ExplainOptions::Verbosity::kQueryPlanner);
+    ASSERT_VALUE_EQ(explain[0]["$facet"]["$concurrent"], Value(true));
+
+    auto output = facetStage->getNext();
+    ASSERT(output.isAdvanced());
+    ASSERT_EQ(output.getDocument()["one"].getArrayLength(), 3UL);
+    ASSERT_EQ(output.getDocument()["two"].getArrayLength(), 3UL);
+
+    // Only the operation's thread used the OperationContext, and the sub-pipelines got it back.
+    for (auto&& stage : stages) {
+        ASSERT_FALSE(stage->sawOpCtx);
+        ASSERT_EQ(stage->observed->opCtx, ctx->opCtx);
+    }
+}
+
+TEST_F(DocumentSourceFacetTest, ShouldNotRunConcurrentlyWhenSubPipelinesShareTheContext) {
+    auto ctx = getExpCtx();
+
+    const auto oldParallelism = internalQueryFacetMaxParallelism.load();
+    ON_BLOCK_EXIT([&] { internalQueryFacetMaxParallelism.store(oldParallelism); });
+    internalQueryFacetMaxParallelism.store(4);
+
+    auto firstPipeline = uassertStatusOK(
+        Pipeline::createFacetPipeline({DocumentSourcePassthrough::create()}, ctx));
+    auto secondPipeline = uassertStatusOK(
+        Pipeline::createFacetPipeline({DocumentSourcePassthrough::create()}, ctx));
+
+    std::vector<DocumentSourceFacet::FacetPipeline> facets;
+    facets.emplace_back("one", std::move(firstPipeline));
+    facets.emplace_back("two", std::move(secondPipeline));
+    auto facetStage = DocumentSourceFacet::create(std::move(facets), ctx);
+
+    vector<Value> explain;
+    facetStage->serializeToArray(explain, ExplainOptions::Verbosity::kQueryPlanner);
+    ASSERT_EQ(explain.size(), 1UL);
+    ASSERT_EQ(explain[0].getDocument().size(), 1UL);
+    ASSERT_VALUE_EQ(explain[0]["$facet"]["$concurrent"], Value(false));
+}
+
+TEST_F(DocumentSourceFacetTest, ShouldNotRunConcurrentlyWithASingleThreadedDocumentArena) {
+    auto ctx = getExpCtx();
+    ctx->documentArena = new DocumentArena(true);
+
+    const auto oldParallelism = internalQueryFacetMaxParallelism.load();
+    ON_BLOCK_EXIT([&] { internalQueryFacetMaxParallelism.store(oldParallelism); });
+    internalQueryFacetMaxParallelism.store(4);
+
+    auto spec = fromjson("{$facet: {one: [{$limit: 1}], two: [{$skip: 1}]}}");
+    auto facetStage = DocumentSourceFacet::createFromBson(spec.firstElement(), ctx);
+
+    vector<Value> explain;
+    facetStage->serializeToArray(explain, ExplainOptions::Verbosity::kQueryPlanner);
+    ASSERT_EQ(explain.size(), 1UL);
+    ASSERT_VALUE_EQ(explain[0]["$facet"]["$concurrent"], Value(false));
+}
+
 /**
  * A dummy DocumentSource which has one dependency: the field "a".
  */
@@ -32,13 +32,17 @@
 
 #include "mongo/base/init.h"
 #include "mongo/db/bson/dotted_path_support.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/document_comparator.h"
 #include "mongo/db/pipeline/document_path_support.h"
+#include "mongo/db/pipeline/document_source_limit.h"
+#include "mongo/db/pipeline/document_source_skip.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner_common.h"
 #include "mongo/stdx/memory.h"
 
@@ -48,6 +52,19 @@ using boost::intrusive_ptr;
 
 namespace dps = ::mongo::dotted_path_support;
 
+namespace {
+/**
+ * Returns the elements of 'value' if it is an array, and 'value' itself otherwise. Each of them is
+ * a separate starting point of a search.
+ */
+std::vector<Value> expandSearchValues(Value value) {
+    if (value.isArray()) {
+        return value.getArray();
+    }
+    return {std::move(value)};
+}
+}  // namespace
+
 std::unique_ptr<LiteParsedDocumentSourceForeignCollections> DocumentSourceGraphLookUp::liteParse(
     const AggregationRequest& request, const BSONElement& spec) {
     uassert(ErrorCodes::FailedToParse,
@@ -104,17 +121,16 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::getNext() {
     performSearch();
 
     std::vector<Value> results;
-    while (!_visited.empty()) {
+    while (hasMoreResults()) {
         // Remove elements one at a time to avoid consuming more memory.
-        auto it = _visited.begin();
-        results.push_back(Value(it->second));
-        _visited.erase(it);
+        results.push_back(Value(popResult()));
     }
 
     MutableDocument output(*_input);
     output.setNestedField(_as, Value(std::move(results)));
 
     _visitedUsageBytes = 0;
+    _visitedDocumentsUsageBytes = 0;
 
     invariant(_visited.empty());
 
@@ -127,7 +143,7 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::getNextUnwound() {
     // If the unwind is not preserving empty arrays, we might have to process multiple inputs before
     // we get one that will produce an output.
     while (true) {
-        if (_visited.empty()) {
+        if (!hasMoreResults()) {
             // No results are left for the current input, so we should move on to the next one and
             // perform a new search.
 
@@ -139,11 +155,12 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::getNextUnwound() {
             _input = input.releaseDocument();
             performSearch();
             _visitedUsageBytes = 0;
+            _visitedDocumentsUsageBytes = 0;
             _outputIndex = 0;
         }
         MutableDocument unwound(*_input);
 
-        if (_visited.empty()) {
+        if (!hasMoreResults()) {
             if ((*_unwind)->preserveNullAndEmptyArrays()) {
                 // Since "preserveNullAndEmptyArrays" was specified, output a document even though
                 // we had no result.
@@ -157,13 +174,11 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::getNextUnwound() {
                 continue;
             }
         } else {
-            auto it = _visited.begin();
-            unwound.setNestedField(_as, Value(it->second));
+            unwound.setNestedField(_as, Value(popResult()));
             if (indexPath) {
                 unwound.setNestedField(*indexPath, Value(_outputIndex));
                 ++_outputIndex;
             }
-            _visited.erase(it);
         }
 
         return unwound.freeze();
@@ -174,72 +189,282 @@ void DocumentSourceGraphLookUp::doDispose() {
     _cache.clear();
     _frontier.clear();
     _visited.clear();
+    _spilledIds.clear();
+    _visitedIdsFile.reset();
+    _pending.clear();
+    _spilledResults.clear();
+    _path.clear();
+}
+
+bool DocumentSourceGraphLookUp::hasMoreResults() {
+    if (!_path.empty()) {
+        return true;
+    }
+    while (_visited.empty() && !_spilledResults.empty()) {
+        if (_spilledResults.back()->more()) {
+            return true;
+        }
+        _spilledResults.pop_back();
+    }
+    return !_visited.empty();
+}
+
+Document DocumentSourceGraphLookUp::popResult() {
+    invariant(hasMoreResults());
+    if (!_path.empty()) {
+        Document result = std::move(_path.front());
+        _path.pop_front();
+        return result;
+    }
+    if (_visited.empty()) {
+        return _spilledResults.back()->next().second;
+    }
+
+    auto it = _visited.begin();
+    Document result = std::move(it->second);
+    _visited.erase(it);
+    return result;
 }
 
 void DocumentSourceGraphLookUp::doBreadthFirstSearch() {
+    auto& opDebug = CurOp::get(pExpCtx->opCtx)->debug();
     long long depth = 0;
     bool shouldPerformAnotherQuery;
     do {
-        shouldPerformAnotherQuery = false;
+        OpDebug::GraphLookupDepthStats depthStats;
+        depthStats.frontierValues = _frontier.size();
+        const long long numVisitedBefore = _numVisited;
 
-        // Check whether each key in the frontier exists in the cache or needs to be queried.
+        // Check whether each key in the frontier exists in the cache or needs to be queried. This
+        // empties '_frontier'.
         auto cached = pExpCtx->getDocumentComparator().makeUnorderedDocumentSet();
-        auto matchStage = makeMatchStageFromFrontier(&cached);
+        auto batches = partitionFrontier(&cached);
 
-        ValueUnorderedSet queried = pExpCtx->getValueComparator().makeUnorderedValueSet();
-        _frontier.swap(queried);
-        _frontierUsageBytes = 0;
+        depthStats.cacheHits = depthStats.frontierValues;
+        for (auto&& batch : batches) {
+            depthStats.cacheHits -= batch.size();
+        }
+        depthStats.queries = batches.size();
+        depthStats.documentsReturned = cached.size();
 
         // Process cached values, populating '_frontier' for the next iteration of search.
         while (!cached.empty()) {
             auto doc = *cached.begin();
             cached.erase(cached.begin());
-            shouldPerformAnotherQuery =
-                addToVisitedAndFrontier(std::move(doc), depth) || shouldPerformAnotherQuery;
+            addToVisitedAndFrontier(std::move(doc), depth);
             checkMemoryUsage();
         }
 
-        if (matchStage) {
-            // Query for all keys that were in the frontier and not in the cache, populating
-            // '_frontier' for the next iteration of search.
-
-            // We've already allocated space for the trailing $match stage in '_fromPipeline'.
-            _fromPipeline.back() = *matchStage;
-            auto pipeline =
-                uassertStatusOK(_mongoProcessInterface->makePipeline(_fromPipeline, _fromExpCtx));
-            while (auto next = pipeline->getNext()) {
-                uassert(40271,
-                        str::stream()
-                            << "Documents in the '"
-                            << _from.ns()
-                            << "' namespace must contain an _id for de-duplication in $graphLookup",
-                        !(*next)["_id"].missing());
-
-                shouldPerformAnotherQuery =
-                    addToVisitedAndFrontier(*next, depth) || shouldPerformAnotherQuery;
-                addToCache(std::move(*next), queried);
-            }
+        // Query for all keys that were in the frontier and not in the cache, one batch at a time,
+        // populating '_frontier' for the next iteration of search.
+        for (auto&& batch : batches) {
+            queryFromCollection(_connectToField, batch, [&](Document next) {
+                ++depthStats.documentsReturned;
+                addToVisitedAndFrontier(next, depth);
+                addToCache(next, batch);
+                checkMemoryUsage();
+            });
+        }
+
+        // The documents found at this depth which were held back because the '_id' values of
+        // visited documents are on disk must be visited before moving on to the next depth.
+        if (!_pending.empty()) {
+            mergeVisitedIds();
             checkMemoryUsage();
         }
 
+        depthStats.documentsAdded = _numVisited - numVisitedBefore;
+        opDebug.addGraphLookupDepthStats(depth, depthStats);
+        shouldPerformAnotherQuery = depthStats.documentsAdded > 0;
+
         ++depth;
-    } while (shouldPerformAnotherQuery && depth < std::numeric_limits<long long>::max() &&
-             (!_maxDepth || depth <= *_maxDepth));
+    } while (shouldPerformAnotherQuery && !_frontier.empty() &&
+             depth < std::numeric_limits<long long>::max() && (!_maxDepth || depth <= *_maxDepth));
 
     _frontier.clear();
     _frontierUsageBytes = 0;
+
+    // Results which were spilled are no longer needed for de-duplication.
+    _visitedIdsFile.reset();
+    _spilledIds.clear();
+    _visitedUsageBytes -= _spilledIdsUsageBytes;
+    _spilledIdsUsageBytes = 0;
+}
+
+void DocumentSourceGraphLookUp::doBidirectionalSearch(const std::vector<Value>& startValues,
+                                                      const std::vector<Value>& endValues) {
+    SearchDirection forward(pExpCtx->getValueComparator());
+    SearchDirection backward(pExpCtx->getValueComparator());
+    for (auto&& value : startValues) {
+        if (forward.frontier.emplace(value, Value()).second) {
+            forward.frontierUsageBytes += value.getApproximateSize();
+        }
+    }
+    for (auto&& value : endValues) {
+        if (backward.frontier.emplace(value, Value()).second) {
+            backward.frontierUsageBytes += value.getApproximateSize();
+        }
+    }
+
+    // Both directions start from the documents whose 'connectToField' holds one of their values.
+    // From there, the forward direction follows the edges from 'connectFromField' to
+    // 'connectToField', and the backward direction follows them the other way around.
+    Value meetingId;
+    auto pathLength =
+        extendSearch(&forward, &backward, _connectToField, _connectFromField, &meetingId);
+    if (!pathLength) {
+        pathLength =
+            extendSearch(&backward, &forward, _connectToField, _connectToField, &meetingId);
+    }
+
+    // A direction whose frontier is empty has reached every document it can, so if the two have
+    // not met by then, they never will. Any chain found by extending either direction is one
+    // document longer than the distances they have each covered so far.
+    while (!pathLength && !forward.frontier.empty() && !backward.frontier.empty() &&
+           (!_maxDepth || forward.distance + backward.distance + 1 <= *_maxDepth)) {
+        if (forward.frontier.size() <= backward.frontier.size()) {
+            pathLength =
+                extendSearch(&forward, &backward, _connectToField, _connectFromField, &meetingId);
+        } else {
+            pathLength =
+                extendSearch(&backward, &forward, _connectFromField, _connectToField, &meetingId);
+        }
+    }
+
+    if (pathLength) {
+        // Follow the chain from the meeting document back to the start, and then on to the end.
+        std::vector<Document> toStart;
+        for (Value id = meetingId; !id.missing();) {
+            const auto& reached = forward.reached.at(id);
+            toStart.push_back(reached.document);
+            id = reached.via;
+        }
+        _path.assign(toStart.rbegin(), toStart.rend());
+        for (Value id = backward.reached.at(meetingId).via; !id.missing();) {
+            const auto& reached = backward.reached.at(id);
+            _path.push_back(reached.document);
+            id = reached.via;
+        }
+        invariant(static_cast<long long>(_path.size()) == *pathLength + 1);
+
+        if (_depthField) {
+            for (size_t i = 0; i < _path.size(); ++i) {
+                MutableDocument withDepth(std::move(_path[i]));
+                withDepth.setNestedField(*_depthField, Value(static_cast<long long>(i)));
+                _path[i] = withDepth.freeze();
+            }
+        }
+    }
+
+    _visitedUsageBytes = 0;
+}
+
+boost::optional<long long> DocumentSourceGraphLookUp::extendSearch(SearchDirection* direction,
+                                                                   SearchDirection* other,
+                                                                   const FieldPath& queryField,
+                                                                   const FieldPath& nextField,
+                                                                   Value* meetingId) {
+    auto values = pExpCtx->getValueComparator().makeUnorderedValueSet();
+    for (auto&& entry : direction->frontier) {
+        values.insert(entry.first);
+    }
+
+    // The values being looked up stay in memory until this level is done.
+    auto frontier = std::move(direction->frontier);
+    const size_t frontierUsageBytes = direction->frontierUsageBytes;
+    direction->frontier = pExpCtx->getValueComparator().makeUnorderedValueMap<Value>();
+    direction->frontierUsageBytes = 0;
+    const long long distance = ++direction->distance;
+
+    boost::optional<long long> shortest;
+    for (auto&& batch : splitIntoBatches(values)) {
+        queryFromCollection(queryField, batch, [&](Document next) {
+            auto id = next.getField("_id");
+            if (direction->reached.find(id) != direction->reached.end()) {
+                return;
+            }
+
+            // Find the document of the previous level which led to this one. A document matched
+            // by a value other than those looked up, such as a whole array, is not followed.
+            boost::optional<Value> via;
+            document_path_support::visitAllValuesAtPath(
+                next, queryField, [&](const Value& queriedValue) {
+                    auto it = frontier.find(queriedValue);
+                    if (!via && it != frontier.end()) {
+                        via = it->second;
+                    }
+                });
+            if (!via) {
+                return;
+            }
+
+            document_path_support::visitAllValuesAtPath(
+                next, nextField, [&](const Value& nextFrontierValue) {
+                    if (direction->frontier.emplace(nextFrontierValue, id).second) {
+                        direction->frontierUsageBytes += nextFrontierValue.getApproximateSize();
+                    }
+                });
+
+            auto met = other->reached.find(id);
+            if (met != other->reached.end() &&
+                (!shortest || distance + met->second.distance < *shortest)) {
+                shortest = distance + met->second.distance;
+                *meetingId = id;
+            }
+
+            _visitedUsageBytes += id.getApproximateSize() + next.getApproximateSize();
+            direction->reached.emplace(id, ReachedDocument{std::move(next), *via, distance});
+
+            uassert(40099,
+                    "$graphLookup reached maximum memory consumption",
+                    (_visitedUsageBytes + frontierUsageBytes + direction->frontierUsageBytes +
+                     other->frontierUsageBytes) < _maxMemoryUsageBytes);
+        });
+    }
+
+    return shortest;
 }
 
-bool DocumentSourceGraphLookUp::addToVisitedAndFrontier(Document result, long long depth) {
+void DocumentSourceGraphLookUp::queryFromCollection(
+    const FieldPath& field,
+    const ValueUnorderedSet& batch,
+    const stdx::function<void(Document)>& callback) {
+    // We've already allocated space for the trailing $match stage in '_fromPipeline'.
+    _fromPipeline.back() = makeMatchStage(field, batch);
+    auto pipeline =
+        uassertStatusOK(_mongoProcessInterface->makePipeline(_fromPipeline, _fromExpCtx));
+    while (auto next = pipeline->getNext()) {
+        uassert(40271,
+                str::stream() << "Documents in the '" << _from.ns()
+                              << "' namespace must contain an _id for de-duplication in $graphLookup",
+                !(*next)["_id"].missing());
+
+        callback(std::move(*next));
+    }
+}
+
+void DocumentSourceGraphLookUp::addToVisitedAndFrontier(Document result, long long depth) {
     auto id = result.getField("_id");
 
-    if (_visited.find(id) != _visited.end()) {
+    if (isVisited(id) || _pending.find(id) != _pending.end()) {
         // We've already seen this object, don't repeat any work.
-        return false;
+        return;
+    }
+
+    if (_visitedIdsFile) {
+        // The document may have been visited before its '_id' was written to disk.
+        _pendingUsageBytes += id.getApproximateSize() + result.getApproximateSize();
+        _pending.emplace(id, PendingDocument{std::move(result), depth});
+        return;
     }
 
-    // We have not seen this node before. If '_depthField' was specified, add the field to the
-    // object.
+    visit(std::move(result), depth);
+}
+
+void DocumentSourceGraphLookUp::visit(Document result, long long depth) {
+    auto id = result.getField("_id");
+
+    // If '_depthField' was specified, add the field to the object.
     if (_depthField) {
         MutableDocument mutableDoc(std::move(result));
         mutableDoc.setNestedField(*_depthField, Value(depth));
@@ -256,13 +481,13 @@ bool DocumentSourceGraphLookUp::addToVisitedAndFrontier(Document result, long lo
         });
 
     // Add the object to our '_visited' list and update the size of '_visited' appropriately.
+    const size_t resultSize = result.getApproximateSize();
     _visitedUsageBytes += id.getApproximateSize();
-    _visitedUsageBytes += result.getApproximateSize();
+    _visitedUsageBytes += resultSize;
+    _visitedDocumentsUsageBytes += resultSize;
 
     _visited[id] = std::move(result);
-
-    // We inserted into _visited, so return true.
-    return true;
+    ++_numVisited;
 }
 
 void DocumentSourceGraphLookUp::addToCache(const Document& result,
@@ -280,7 +505,7 @@ void DocumentSourceGraphLookUp::addToCache(const Document& result,
         });
 }
 
-boost::optional<BSONObj> DocumentSourceGraphLookUp::makeMatchStageFromFrontier(
+std::vector<ValueUnorderedSet> DocumentSourceGraphLookUp::partitionFrontier(
     DocumentUnorderedSet* cached) {
     // Add any cached values to 'cached' and remove them from '_frontier'.
     for (auto it = _frontier.begin(); it != _frontier.end();) {
@@ -298,7 +523,38 @@ boost::optional<BSONObj> DocumentSourceGraphLookUp::makeMatchStageFromFrontier(
         }
     }
 
-    // Create a query of the form {$and: [_additionalFilter, {_connectToField: {$in: [...]}}]}.
+    auto batches = splitIntoBatches(_frontier);
+
+    _frontier.clear();
+    _frontierUsageBytes = 0;
+
+    return batches;
+}
+
+std::vector<ValueUnorderedSet> DocumentSourceGraphLookUp::splitIntoBatches(
+    const ValueUnorderedSet& values) const {
+    // Split the values into batches, so that no single query on the 'from' collection grows in
+    // proportion to the size of the frontier.
+    const size_t maxBatchSizeBytes =
+        std::max(1, internalDocumentSourceGraphLookupFrontierBatchSizeBytes.load());
+    std::vector<ValueUnorderedSet> batches;
+    size_t batchSizeBytes = maxBatchSizeBytes;
+    for (auto&& value : values) {
+        if (batchSizeBytes >= maxBatchSizeBytes) {
+            batches.push_back(pExpCtx->getValueComparator().makeUnorderedValueSet());
+            batchSizeBytes = 0;
+        }
+        batches.back().insert(value);
+        batchSizeBytes += value.getApproximateSize();
+    }
+    return batches;
+}
+
+BSONObj DocumentSourceGraphLookUp::makeMatchStage(const FieldPath& field,
+                                                  const ValueUnorderedSet& batch) const {
+    invariant(!batch.empty());
+
+    // Create a query of the form {$and: [_additionalFilter, {field: {$in: [...]}}]}.
     //
     // We wrap the query in a $match so that it can be parsed into a DocumentSourceMatch when
     // constructing a pipeline to execute.
@@ -314,10 +570,10 @@ boost::optional<BSONObj> DocumentSourceGraphLookUp::makeMatchStageFromFrontier(
             {
                 BSONObjBuilder connectToObj(andObj.subobjStart());
                 {
-                    BSONObjBuilder subObj(connectToObj.subobjStart(_connectToField.fullPath()));
+                    BSONObjBuilder subObj(connectToObj.subobjStart(field.fullPath()));
                     {
                         BSONArrayBuilder in(subObj.subarrayStart("$in"));
-                        for (auto&& value : _frontier) {
+                        for (auto&& value : batch) {
                             in << value;
                         }
                     }
@@ -326,24 +582,23 @@ boost::optional<BSONObj> DocumentSourceGraphLookUp::makeMatchStageFromFrontier(
         }
     }
 
-    return _frontier.empty() ? boost::none : boost::optional<BSONObj>(match.obj());
+    return match.obj();
 }
 
 void DocumentSourceGraphLookUp::performSearch() {
     // Make sure _input is set before calling performSearch().
     invariant(_input);
 
-    Value startingValue = _startWith->evaluate(*_input);
+    auto startValues = expandSearchValues(_startWith->evaluate(*_input));
 
-    // If _startWith evaluates to an array, treat each value as a separate starting point.
-    if (startingValue.isArray()) {
-        for (auto value : startingValue.getArray()) {
-            _frontier.insert(value);
-            _frontierUsageBytes += value.getApproximateSize();
-        }
-    } else {
-        _frontier.insert(startingValue);
-        _frontierUsageBytes += startingValue.getApproximateSize();
+    if (_endWith) {
+        doBidirectionalSearch(startValues, expandSearchValues(_endWith->evaluate(*_input)));
+        return;
+    }
+
+    for (auto&& value : startValues) {
+        _frontier.insert(value);
+        _frontierUsageBytes += value.getApproximateSize();
     }
 
     doBreadthFirstSearch();
@@ -372,6 +627,15 @@ Pipeline::SourceContainer::iterator DocumentSourceGraphLookUp::doOptimizeAt(
         container->erase(std::next(itr));
         return itr;
     }
+
+    // Unless we are handling an $unwind, we produce exactly one document per input document, so a
+    // following $skip or $limit can move before us.
+    auto nextSkip = dynamic_cast<DocumentSourceSkip*>((*std::next(itr)).get());
+    auto nextLimit = dynamic_cast<DocumentSourceLimit*>((*std::next(itr)).get());
+    if ((nextSkip || nextLimit) && !_unwind) {
+        std::swap(*itr, *std::next(itr));
+        return itr == container->begin() ? itr : std::prev(itr);
+    }
     return std::next(itr);
 }
 
@@ -388,11 +652,115 @@ BSONObjSet DocumentSourceGraphLookUp::getOutputSorts() {
 }
 
 void DocumentSourceGraphLookUp::checkMemoryUsage() {
-    // TODO SERVER-23980: Implement spilling to disk if allowDiskUse is specified.
+    const auto usageBytes = [this] {
+        return _visitedUsageBytes + _pendingUsageBytes + _frontierUsageBytes;
+    };
+
+    // Only write to disk once the '_id' values or documents in question are a meaningful share of
+    // the limit. Otherwise a frontier which fills memory by itself would have every newly
+    // discovered document written to a file of its own. The '_id' values go first, since merging
+    // them visits the pending documents, which spilling then frees.
+    if (usageBytes() >= _maxMemoryUsageBytes && pExpCtx->allowDiskUse) {
+        if (_spilledIdsUsageBytes + _pendingUsageBytes >= _maxMemoryUsageBytes / kMinSpillFraction) {
+            mergeVisitedIds();
+        }
+        if (_visitedDocumentsUsageBytes >= _maxMemoryUsageBytes / kMinSpillFraction) {
+            spillVisited();
+        }
+    }
+
+    // The frontier must still fit in memory.
     uassert(40099,
             "$graphLookup reached maximum memory consumption",
-            (_visitedUsageBytes + _frontierUsageBytes) < _maxMemoryUsageBytes);
-    _cache.evictDownTo(_maxMemoryUsageBytes - _frontierUsageBytes - _visitedUsageBytes);
+            usageBytes() < _maxMemoryUsageBytes);
+    _cache.evictDownTo(_maxMemoryUsageBytes - usageBytes());
+}
+
+void DocumentSourceGraphLookUp::spillVisited() {
+    // The results are returned in no particular order, so they are written out as they are held
+    // rather than sorted. A file is only ever read back from start to finish.
+    SortedFileWriter<Value, Document> writer(SortOptions().TempDir(pExpCtx->tempDir));
+    for (auto&& entry : _visited) {
+        writer.addAlreadySorted(entry.first, entry.second);
+
+        // The '_id' remains accounted for in '_visitedUsageBytes' through '_spilledIds'.
+        _visitedUsageBytes -= entry.second.getApproximateSize();
+        _spilledIdsUsageBytes += entry.first.getApproximateSize();
+        _spilledIds.insert(entry.first);
+    }
+    _visited.clear();
+    _visitedDocumentsUsageBytes = 0;
+
+    _spilledResults.emplace_back(writer.done());
+}
+
+void DocumentSourceGraphLookUp::mergeVisitedIds() {
+    const auto& comparator = ValueComparator::kInstance;
+
+    std::vector<Value> spilledIds(_spilledIds.begin(), _spilledIds.end());
+    std::sort(spilledIds.begin(), spilledIds.end(), comparator.getLessThan());
+
+    std::vector<Value> pendingIds;
+    pendingIds.reserve(_pending.size());
+    for (auto&& entry : _pending) {
+        pendingIds.push_back(entry.first);
+    }
+    std::sort(pendingIds.begin(), pendingIds.end(), comparator.getLessThan());
+
+    // Write the '_id' values on disk and those in '_spilledIds' to a new file, in order. Pending
+    // documents whose '_id' turns up along the way have been visited already.
+    if (_visitedIdsFile || !spilledIds.empty()) {
+        const auto nextOnDisk = [this]() -> boost::optional<Value> {
+            if (_visitedIdsFile && _visitedIdsFile->more()) {
+                return _visitedIdsFile->next().first;
+            }
+            return boost::none;
+        };
+
+        SortedFileWriter<Value, Value> writer(SortOptions().TempDir(pExpCtx->tempDir));
+        auto onDisk = nextOnDisk();
+        auto spilledIt = spilledIds.begin();
+        auto pendingIt = pendingIds.begin();
+        while (onDisk || spilledIt != spilledIds.end()) {
+            Value id;
+            if (!onDisk ||
+                (spilledIt != spilledIds.end() && comparator.compare(*spilledIt, *onDisk) < 0)) {
+                id = std::move(*spilledIt++);
+            } else {
+                id = std::move(*onDisk);
+                onDisk = nextOnDisk();
+            }
+
+            while (pendingIt != pendingIds.end() && comparator.compare(*pendingIt, id) < 0) {
+                ++pendingIt;
+            }
+            if (pendingIt != pendingIds.end() && comparator.compare(*pendingIt, id) == 0) {
+                auto pending = _pending.find(id);
+                _pendingUsageBytes -=
+                    id.getApproximateSize() + pending->second.document.getApproximateSize();
+                _pending.erase(pending);
+                ++pendingIt;
+            }
+
+            writer.addAlreadySorted(id, Value());
+        }
+        _visitedIdsFile.reset(writer.done());
+    }
+
+    _spilledIds.clear();
+    _visitedUsageBytes -= _spilledIdsUsageBytes;
+    _spilledIdsUsageBytes = 0;
+
+    // The remaining pending documents have not been visited before.
+    for (auto&& entry : _pending) {
+        visit(std::move(entry.second.document), entry.second.depth);
+    }
+    _pending.clear();
+    _pendingUsageBytes = 0;
+}
+
+bool DocumentSourceGraphLookUp::isVisited(const Value& id) const {
+    return _visited.find(id) != _visited.end() || _spilledIds.find(id) != _spilledIds.end();
 }
 
 void DocumentSourceGraphLookUp::serializeToArray(
@@ -405,6 +773,10 @@ void DocumentSourceGraphLookUp::serializeToArray(
                                     << "startWith"
                                     << _startWith->serialize(false)));
 
+    if (_endWith) {
+        spec["endWith"] = _endWith->serialize(false);
+    }
+
     // depthField is optional; serialize it if it was specified.
     if (_depthField) {
         spec["depthField"] = Value(_depthField->fullPath());
@@ -454,7 +826,8 @@ DocumentSourceGraphLookUp::DocumentSourceGraphLookUp(
     boost::optional<BSONObj> additionalFilter,
     boost::optional<FieldPath> depthField,
     boost::optional<long long> maxDepth,
-    boost::optional<boost::intrusive_ptr<DocumentSourceUnwind>> unwindSrc)
+    boost::optional<boost::intrusive_ptr<DocumentSourceUnwind>> unwindSrc,
+    boost::intrusive_ptr<Expression> endWith)
     : DocumentSourceNeedsMongoProcessInterface(expCtx),
       _from(std::move(from)),
       _as(std::move(as)),
@@ -464,8 +837,12 @@ DocumentSourceGraphLookUp::DocumentSourceGraphLookUp(
       _additionalFilter(additionalFilter),
       _depthField(depthField),
       _maxDepth(maxDepth),
+      _endWith(std::move(endWith)),
+      _maxMemoryUsageBytes(internalDocumentSourceGraphLookupMaxMemoryBytes.load()),
       _frontier(pExpCtx->getValueComparator().makeUnorderedValueSet()),
       _visited(ValueComparator::kInstance.makeUnorderedValueMap<Document>()),
+      _spilledIds(ValueComparator::kInstance.makeUnorderedValueSet()),
+      _pending(ValueComparator::kInstance.makeUnorderedValueMap<PendingDocument>()),
       _cache(pExpCtx->getValueComparator()),
       _unwind(unwindSrc) {
     const auto& resolvedNamespace = pExpCtx->getResolvedNamespace(_from);
@@ -488,7 +865,8 @@ intrusive_ptr<DocumentSourceGraphLookUp> DocumentSourceGraphLookUp::create(
     boost::optional<BSONObj> additionalFilter,
     boost::optional<FieldPath> depthField,
     boost::optional<long long> maxDepth,
-    boost::optional<boost::intrusive_ptr<DocumentSourceUnwind>> unwindSrc) {
+    boost::optional<boost::intrusive_ptr<DocumentSourceUnwind>> unwindSrc,
+    intrusive_ptr<Expression> endWith) {
     intrusive_ptr<DocumentSourceGraphLookUp> source(
         new DocumentSourceGraphLookUp(expCtx,
                                       std::move(fromNs),
@@ -499,7 +877,8 @@ intrusive_ptr<DocumentSourceGraphLookUp> DocumentSourceGraphLookUp::create(
                                       additionalFilter,
                                       depthField,
                                       maxDepth,
-                                      unwindSrc));
+                                      unwindSrc,
+                                      std::move(endWith)));
     return source;
 }
 
@@ -508,6 +887,7 @@ intrusive_ptr<DocumentSource> DocumentSourceGraphLookUp::createFromBson(
     NamespaceString from;
     std::string as;
     boost::intrusive_ptr<Expression> startWith;
+    boost::intrusive_ptr<Expression> endWith;
     std::string connectFromField;
     std::string connectToField;
     boost::optional<FieldPath> depthField;
@@ -522,6 +902,9 @@ intrusive_ptr<DocumentSource> DocumentSourceGraphLookUp::createFromBson(
         if (argName == "startWith") {
             startWith = Expression::parseOperand(expCtx, argument, vps);
             continue;
+        } else if (argName == "endWith") {
+            endWith = Expression::parseOperand(expCtx, argument, vps);
+            continue;
         } else if (argName == "maxDepth") {
             uassert(40100,
                     str::stream() << "maxDepth must be numeric, found type: "
@@ -602,8 +985,12 @@ intrusive_ptr<DocumentSource> DocumentSourceGraphLookUp::createFromBson(
                                       additionalFilter,
                                       depthField,
                                       maxDepth,
-                                      boost::none));
+                                      boost::none,
+                                      std::move(endWith)));
 
     return std::move(newSource);
 }
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
@@ -28,11 +28,15 @@
 
 #pragma once
 
+#include <deque>
+
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_unwind.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/lookup_set_cache.h"
 #include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/db/sorter/sorter.h"
+#include "mongo/stdx/functional.h"
 
 namespace mongo {
 
@@ -57,7 +61,7 @@ public:
         StageConstraints constraints(StreamType::kStreaming,
                                      PositionRequirement::kNone,
                                      HostTypeRequirement::kPrimaryShard,
-                                     DiskUseRequirement::kNoDiskUse,
+                                     DiskUseRequirement::kWritesTmpData,
                                      FacetRequirement::kAllowed);
 
         constraints.canSwapWithMatch = true;
@@ -66,6 +70,9 @@ public:
 
     GetDepsReturn getDependencies(DepsTracker* deps) const final {
         _startWith->addDependencies(deps);
+        if (_endWith) {
+            _endWith->addDependencies(deps);
+        }
         return SEE_NEXT;
     };
 
@@ -87,7 +94,8 @@ public:
         boost::optional<BSONObj> additionalFilter,
         boost::optional<FieldPath> depthField,
         boost::optional<long long> maxDepth,
-        boost::optional<boost::intrusive_ptr<DocumentSourceUnwind>> unwindSrc);
+        boost::optional<boost::intrusive_ptr<DocumentSourceUnwind>> unwindSrc,
+        boost::intrusive_ptr<Expression> endWith = nullptr);
 
     static boost::intrusive_ptr<DocumentSource> createFromBson(
         BSONElement elem, const boost::intrusive_ptr<ExpressionContext>& pExpCtx);
@@ -112,7 +120,42 @@ private:
         boost::optional<BSONObj> additionalFilter,
         boost::optional<FieldPath> depthField,
         boost::optional<long long> maxDepth,
-        boost::optional<boost::intrusive_ptr<DocumentSourceUnwind>> unwindSrc);
+        boost::optional<boost::intrusive_ptr<DocumentSourceUnwind>> unwindSrc,
+        boost::intrusive_ptr<Expression> endWith);
+
+    /**
+     * A document reached by the bidirectional search, along with the '_id' of the document it was
+     * reached from and its distance from the end the search started at.
+     */
+    struct ReachedDocument {
+        Document document;
+        Value via;  // Missing for the documents matching the start or end values.
+        long long distance = 0;
+    };
+
+    /**
+     * One direction of the bidirectional search. 'frontier' maps each value to look up next to the
+     * '_id' of the document it came from.
+     */
+    struct SearchDirection {
+        explicit SearchDirection(const ValueComparator& valueComparator)
+            : reached(ValueComparator::kInstance.makeUnorderedValueMap<ReachedDocument>()),
+              frontier(valueComparator.makeUnorderedValueMap<Value>()) {}
+
+        ValueUnorderedMap<ReachedDocument> reached;
+        ValueUnorderedMap<Value> frontier;
+        size_t frontierUsageBytes = 0;
+        long long distance = -1;
+    };
+
+    /**
+     * A document which was found while '_id' values of visited documents are on disk, and which
+     * can only be visited once mergeVisitedIds() has checked that it was not visited before.
+     */
+    struct PendingDocument {
+        Document document;
+        long long depth = 0;
+    };
 
     Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final {
         // Should not be called; use serializeToArray instead.
@@ -120,15 +163,32 @@ private:
     }
 
     /**
-     * Prepares the query to execute on the 'from' collection wrapped in a $match by using the
-     * contents of '_frontier'.
-     *
-     * Fills 'cached' with any values that were retrieved from the cache.
-     *
-     * Returns boost::none if no query is necessary, i.e., all values were retrieved from the cache.
-     * Otherwise, returns a query object.
+     * Empties '_frontier', filling 'cached' with the documents of any values that were found in the
+     * cache. The remaining values are returned split into batches, each of which holds no more than
+     * 'internalDocumentSourceGraphLookupFrontierBatchSizeBytes' worth of values. Returns an empty
+     * vector if no query is necessary, i.e., all values were retrieved from the cache.
+     */
+    std::vector<ValueUnorderedSet> partitionFrontier(DocumentUnorderedSet* cached);
+
+    /**
+     * Splits 'values' into batches, each of which holds no more than
+     * 'internalDocumentSourceGraphLookupFrontierBatchSizeBytes' worth of values.
+     */
+    std::vector<ValueUnorderedSet> splitIntoBatches(const ValueUnorderedSet& values) const;
+
+    /**
+     * Returns the query to execute on the 'from' collection to find the documents whose 'field'
+     * holds one of the values in 'batch', wrapped in a $match.
+     */
+    BSONObj makeMatchStage(const FieldPath& field, const ValueUnorderedSet& batch) const;
+
+    /**
+     * Runs the query of makeMatchStage() on the 'from' collection, calling 'callback' with each
+     * document it returns.
      */
-    boost::optional<BSONObj> makeMatchStageFromFrontier(DocumentUnorderedSet* cached);
+    void queryFromCollection(const FieldPath& field,
+                             const ValueUnorderedSet& batch,
+                             const stdx::function<void(Document)>& callback);
 
     /**
      * If we have internalized a $unwind, getNext() dispatches to this function.
@@ -142,9 +202,31 @@ private:
      */
     void doBreadthFirstSearch();
 
+    /**
+     * Searches from the documents matching 'startValues' and those matching 'endValues' at once,
+     * always extending the direction with the smaller frontier by one level. Fills '_path' with a
+     * shortest chain of documents leading from the former to the latter, if one exists within
+     * '_maxDepth'.
+     */
+    void doBidirectionalSearch(const std::vector<Value>& startValues,
+                               const std::vector<Value>& endValues);
+
+    /**
+     * Extends 'direction' by one level, matching its frontier values against 'queryField' and
+     * taking the next frontier from 'nextField' of the documents found. Returns the length of the
+     * shortest chain through the documents which are now reached from both directions, if any,
+     * and sets 'meetingId' to the '_id' of the document it passes through.
+     */
+    boost::optional<long long> extendSearch(SearchDirection* direction,
+                                            SearchDirection* other,
+                                            const FieldPath& queryField,
+                                            const FieldPath& nextField,
+                                            Value* meetingId);
+
     /**
      * Populates '_frontier' with the '_startWith' value(s) from '_input' and then performs a
-     * breadth-first search. Caller should check that _input is not boost::none.
+     * breadth-first search, or a bidirectional one if '_endWith' was specified. Caller should check
+     * that _input is not boost::none.
      */
     void performSearch();
 
@@ -156,17 +238,53 @@ private:
 
     /**
      * Assert that '_visited' and '_frontier' have not exceeded the maximum meory usage, and then
-     * evict from '_cache' until this source is using less than '_maxMemoryUsageBytes'.
+     * evict from '_cache' until this source is using less than '_maxMemoryUsageBytes'. If disk use
+     * is allowed, the documents in '_visited' and the '_id' values in '_spilledIds' are written to
+     * disk before giving up.
      */
     void checkMemoryUsage();
 
     /**
-     * Process 'result', adding it to '_visited' with the given 'depth', and updating '_frontier'
-     * with the object's 'connectTo' values.
-     *
-     * Returns whether '_visited' was updated, and thus, whether the search should recurse.
+     * Writes the documents in '_visited' to a temporary file and empties it. The '_id' of each
+     * document is kept in '_spilledIds' so that it is not visited again.
      */
-    bool addToVisitedAndFrontier(Document result, long long depth);
+    void spillVisited();
+
+    /**
+     * Merges the '_id' values in '_spilledIds' into the sorted file of '_id' values on disk, and
+     * then visits those of the '_pending' documents whose '_id' was not found in it.
+     */
+    void mergeVisitedIds();
+
+    /**
+     * Returns whether the document with the given '_id' has already been discovered for the
+     * current input and its '_id' is held in memory.
+     */
+    bool isVisited(const Value& id) const;
+
+    /**
+     * Adds 'result' to '_visited' with the given 'depth', and updates '_frontier' with its
+     * 'connectFromField' values.
+     */
+    void visit(Document result, long long depth);
+
+    /**
+     * Returns whether any results of the search for the current input remain to be returned.
+     */
+    bool hasMoreResults();
+
+    /**
+     * Removes and returns the next result of the search for the current input. Spilled results are
+     * returned after those still held in '_visited'.
+     */
+    Document popResult();
+
+    /**
+     * Process 'result', visiting it at the given 'depth' unless it has been visited already. While
+     * '_id' values are on disk, documents whose '_id' is not in memory are added to '_pending'
+     * instead.
+     */
+    void addToVisitedAndFrontier(Document result, long long depth);
 
     // $graphLookup options.
     NamespaceString _from;
@@ -177,6 +295,7 @@ private:
     boost::optional<BSONObj> _additionalFilter;
     boost::optional<FieldPath> _depthField;
     boost::optional<long long> _maxDepth;
+    boost::intrusive_ptr<Expression> _endWith;
 
     // The ExpressionContext used when performing aggregation pipelines against the '_from'
     // namespace.
@@ -185,12 +304,29 @@ private:
     // The aggregation pipeline to perform against the '_from' namespace.
     std::vector<BSONObj> _fromPipeline;
 
-    size_t _maxMemoryUsageBytes = 100 * 1024 * 1024;
+    // '_visited' is only spilled once its documents take up at least this fraction of
+    // '_maxMemoryUsageBytes', so that each spill file holds a meaningful number of them.
+    static constexpr size_t kMinSpillFraction = 10;
+
+    size_t _maxMemoryUsageBytes;
 
     // Track memory usage to ensure we don't exceed '_maxMemoryUsageBytes'.
     size_t _visitedUsageBytes = 0;
     size_t _frontierUsageBytes = 0;
 
+    // The part of '_visitedUsageBytes' taken by the documents held in '_visited', which is what
+    // spilling frees.
+    size_t _visitedDocumentsUsageBytes = 0;
+
+    // The part of '_visitedUsageBytes' taken by '_spilledIds', which is what merging them into
+    // '_visitedIdsFile' frees.
+    size_t _spilledIdsUsageBytes = 0;
+
+    size_t _pendingUsageBytes = 0;
+
+    // The number of documents visited by this stage, used to count those added at each depth.
+    long long _numVisited = 0;
+
     // Only used during the breadth-first search, tracks the set of values on the current frontier.
     ValueUnorderedSet _frontier;
 
@@ -199,6 +335,24 @@ private:
     // using the simple collation.
     ValueUnorderedMap<Document> _visited;
 
+    // The '_id' values of the documents which were spilled from '_visited' during the current
+    // search. Only populated if allowDiskUse is set, and cleared once the search completes.
+    ValueUnorderedSet _spilledIds;
+
+    // An iterator over a file holding the '_id' values of documents visited during the current
+    // search, in ascending order, once '_spilledIds' took up too much memory.
+    std::unique_ptr<Sorter<Value, Value>::Iterator> _visitedIdsFile;
+
+    // Documents found while '_visitedIdsFile' exists, which may or may not have been visited.
+    ValueUnorderedMap<PendingDocument> _pending;
+
+    // The chain of documents found by the bidirectional search, in order.
+    std::deque<Document> _path;
+
+    // Iterators over the files holding documents spilled from '_visited' which have not yet been
+    // returned.
+    std::vector<std::shared_ptr<Sorter<Value, Document>::Iterator>> _spilledResults;
+
     // Caches query results to avoid repeating any work. This structure is maintained across calls
     // to getNext().
     LookupSetCache _cache;
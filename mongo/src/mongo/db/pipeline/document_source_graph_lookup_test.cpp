@@ -31,14 +31,18 @@
 #include <algorithm>
 #include <deque>
 
+#include "mongo/db/curop.h"
 #include "mongo/db/pipeline/aggregation_context_fixture.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/document_source_graph_lookup.h"
 #include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/document_value_test_util.h"
 #include "mongo/db/pipeline/stub_mongo_process_interface.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
@@ -624,5 +628,287 @@ TEST_F(DocumentSourceGraphLookUpTest, ShouldNotExpandArraysWithinArraysAtEndOfCo
     ASSERT(graphLookupStage->getNext().isEOF());
 }
 
+TEST_F(DocumentSourceGraphLookUpTest, ShouldQueryLargeFrontiersInBatches) {
+    auto expCtx = getExpCtx();
+
+    const auto oldBatchSizeBytes = internalDocumentSourceGraphLookupFrontierBatchSizeBytes.load();
+    ON_BLOCK_EXIT(
+        [&] { internalDocumentSourceGraphLookupFrontierBatchSizeBytes.store(oldBatchSizeBytes); });
+    // Place every frontier value in a query of its own.
+    internalDocumentSourceGraphLookupFrontierBatchSizeBytes.store(1);
+
+    std::deque<DocumentSource::GetNextResult> inputs{Document{{"_id", 0}, {"startVal", 0}}};
+    auto inputMock = DocumentSourceMock::create(std::move(inputs));
+
+    Document startDoc{{"_id", 0}, {"to", std::vector<Value>{Value(1), Value(2), Value(3)}}};
+    Document middle1{{"_id", 1}, {"to", 4}};
+    Document middle2{{"_id", 2}, {"to", 4}};
+    Document middle3{{"_id", 3}, {"to", 4}};
+    Document sinkDoc{{"_id", 4}};
+
+    std::deque<DocumentSource::GetNextResult> fromContents{Document(startDoc),
+                                                           Document(middle1),
+                                                           Document(middle2),
+                                                           Document(middle3),
+                                                           Document(sinkDoc)};
+
+    NamespaceString fromNs("test", "graph_lookup");
+    expCtx->setResolvedNamespace(fromNs, {fromNs, std::vector<BSONObj>{}});
+    auto graphLookupStage =
+        DocumentSourceGraphLookUp::create(expCtx,
+                                          fromNs,
+                                          "results",
+                                          "to",
+                                          "_id",
+                                          ExpressionFieldPath::create(expCtx, "startVal"),
+                                          boost::none,
+                                          boost::none,
+                                          boost::none,
+                                          boost::none);
+    graphLookupStage->setSource(inputMock.get());
+    graphLookupStage->injectMongoProcessInterface(
+        std::make_shared<MockMongoProcessInterfaceImplementation>(std::move(fromContents)));
+
+    auto next = graphLookupStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+
+    auto resultsArray = next.getDocument().getField("results").getArray();
+    ASSERT_EQ(5U, resultsArray.size());
+    ASSERT(arrayContains(expCtx, resultsArray, Value(startDoc)));
+    ASSERT(arrayContains(expCtx, resultsArray, Value(middle1)));
+    ASSERT(arrayContains(expCtx, resultsArray, Value(middle2)));
+    ASSERT(arrayContains(expCtx, resultsArray, Value(middle3)));
+    ASSERT(arrayContains(expCtx, resultsArray, Value(sinkDoc)));
+    ASSERT(graphLookupStage->getNext().isEOF());
+
+    // Depth 0 looks up the start value, depth 1 the three values of 'startDoc' with a query each,
+    // and depth 2 the value 4 shared by the three middle documents.
+    const auto& depthStats = CurOp::get(expCtx->opCtx)->debug().graphLookupDepthStats;
+    ASSERT_EQ(3U, depthStats.size());
+    const std::vector<long long> expectedValues{1, 3, 1};
+    for (size_t depth = 0; depth < depthStats.size(); ++depth) {
+        ASSERT_EQ(expectedValues[depth], depthStats[depth].frontierValues);
+        ASSERT_EQ(0, depthStats[depth].cacheHits);
+        ASSERT_EQ(expectedValues[depth], depthStats[depth].queries);
+        ASSERT_EQ(expectedValues[depth], depthStats[depth].documentsReturned);
+        ASSERT_EQ(expectedValues[depth], depthStats[depth].documentsAdded);
+    }
+}
+
+TEST_F(DocumentSourceGraphLookUpTest, ShouldSpillDiscoveredDocumentsWhenAllowedToUseDisk) {
+    auto expCtx = getExpCtx();
+    unittest::TempDir tempDir("DocumentSourceGraphLookUpTest");
+    expCtx->tempDir = tempDir.path();
+
+    const auto oldMaxMemoryBytes = internalDocumentSourceGraphLookupMaxMemoryBytes.load();
+    ON_BLOCK_EXIT(
+        [&] { internalDocumentSourceGraphLookupMaxMemoryBytes.store(oldMaxMemoryBytes); });
+    // Enough for the frontier and a few discovered documents, but not for all of them.
+    internalDocumentSourceGraphLookupMaxMemoryBytes.store(4 * 1024);
+
+    // Make a chain 0 -> 1 -> ... -> 9 of documents which are 1KB each.
+    const std::string padding(1024, 'x');
+    std::vector<Document> chain;
+    std::deque<DocumentSource::GetNextResult> fromContents;
+    for (int i = 0; i < 10; ++i) {
+        chain.push_back(Document{{"_id", i}, {"to", i + 1}, {"padding", padding}});
+        fromContents.push_back(Document(chain.back()));
+    }
+
+    NamespaceString fromNs("test", "graph_lookup");
+    expCtx->setResolvedNamespace(fromNs, {fromNs, std::vector<BSONObj>{}});
+    auto makeGraphLookupStage = [&](DocumentSource* inputMock) {
+        auto graphLookupStage =
+            DocumentSourceGraphLookUp::create(expCtx,
+                                              fromNs,
+                                              "results",
+                                              "to",
+                                              "_id",
+                                              ExpressionFieldPath::create(expCtx, "startVal"),
+                                              boost::none,
+                                              boost::none,
+                                              boost::none,
+                                              boost::none);
+        graphLookupStage->setSource(inputMock);
+        graphLookupStage->injectMongoProcessInterface(
+            std::make_shared<MockMongoProcessInterfaceImplementation>(fromContents));
+        return graphLookupStage;
+    };
+
+    // Without allowDiskUse, the search fails once the discovered documents exceed the limit.
+    auto inputMock = DocumentSourceMock::create(Document{{"_id", 0}, {"startVal", 0}});
+    ASSERT_THROWS_CODE(
+        makeGraphLookupStage(inputMock.get())->getNext(), AssertionException, 40099);
+
+    expCtx->allowDiskUse = true;
+    inputMock = DocumentSourceMock::create(Document{{"_id", 0}, {"startVal", 0}});
+    auto graphLookupStage = makeGraphLookupStage(inputMock.get());
+    auto next = graphLookupStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+
+    auto resultsArray = next.getDocument().getField("results").getArray();
+    ASSERT_EQ(chain.size(), resultsArray.size());
+    for (auto&& doc : chain) {
+        ASSERT(arrayContains(expCtx, resultsArray, Value(doc)));
+    }
+    ASSERT(graphLookupStage->getNext().isEOF());
+}
+
+TEST_F(DocumentSourceGraphLookUpTest, ShouldSpillVisitedIdsWhenAllowedToUseDisk) {
+    auto expCtx = getExpCtx();
+    unittest::TempDir tempDir("DocumentSourceGraphLookUpTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+
+    const auto oldMaxMemoryBytes = internalDocumentSourceGraphLookupMaxMemoryBytes.load();
+    ON_BLOCK_EXIT(
+        [&] { internalDocumentSourceGraphLookupMaxMemoryBytes.store(oldMaxMemoryBytes); });
+    internalDocumentSourceGraphLookupMaxMemoryBytes.store(4 * 1024);
+
+    // Make a chain of documents with large '_id' values, which would take up several times the
+    // memory limit if they were all held in memory. Each document also links back to one found
+    // earlier, which must not be returned twice.
+    const std::string prefix(200, 'x');
+    const auto makeId = [&](int i) { return Value(prefix + std::to_string(i)); };
+    const int numDocs = 60;
+    std::vector<Document> chain;
+    std::deque<DocumentSource::GetNextResult> fromContents;
+    for (int i = 0; i < numDocs; ++i) {
+        chain.push_back(Document{{"_id", makeId(i)},
+                                 {"to", std::vector<Value>{makeId(i + 1), makeId(i / 2)}}});
+        fromContents.push_back(Document(chain.back()));
+    }
+
+    std::deque<DocumentSource::GetNextResult> inputs{
+        Document{{"_id", 0}, {"startVal", makeId(0)}}};
+    auto inputMock = DocumentSourceMock::create(std::move(inputs));
+
+    NamespaceString fromNs("test", "graph_lookup");
+    expCtx->setResolvedNamespace(fromNs, {fromNs, std::vector<BSONObj>{}});
+    auto graphLookupStage =
+        DocumentSourceGraphLookUp::create(expCtx,
+                                          fromNs,
+                                          "results",
+                                          "to",
+                                          "_id",
+                                          ExpressionFieldPath::create(expCtx, "startVal"),
+                                          boost::none,
+                                          boost::none,
+                                          boost::none,
+                                          boost::none);
+    graphLookupStage->setSource(inputMock.get());
+    graphLookupStage->injectMongoProcessInterface(
+        std::make_shared<MockMongoProcessInterfaceImplementation>(std::move(fromContents)));
+
+    auto next = graphLookupStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+
+    auto resultsArray = next.getDocument().getField("results").getArray();
+    ASSERT_EQ(chain.size(), resultsArray.size());
+    for (auto&& doc : chain) {
+        ASSERT(arrayContains(expCtx, resultsArray, Value(doc)));
+    }
+    ASSERT(graphLookupStage->getNext().isEOF());
+}
+
+/**
+ * Returns a $graphLookup stage which searches the documents 0 -> 1 -> 2 -> 3 and 0 -> 4 -> 3 of a
+ * mocked 'from' collection for a chain from 'startVal' to 'endVal' of the input documents.
+ */
+boost::intrusive_ptr<DocumentSourceGraphLookUp> makeBidirectionalGraphLookUp(
+    const boost::intrusive_ptr<ExpressionContextForTest>& expCtx,
+    DocumentSource* inputMock,
+    boost::optional<long long> maxDepth) {
+    std::deque<DocumentSource::GetNextResult> fromContents{
+        Document{{"_id", 0}, {"to", std::vector<Value>{Value(1), Value(4)}}},
+        Document{{"_id", 1}, {"to", 2}},
+        Document{{"_id", 2}, {"to", 3}},
+        Document{{"_id", 3}},
+        Document{{"_id", 4}, {"to", 3}}};
+
+    NamespaceString fromNs("test", "graph_lookup");
+    expCtx->setResolvedNamespace(fromNs, {fromNs, std::vector<BSONObj>{}});
+    auto graphLookupStage =
+        DocumentSourceGraphLookUp::create(expCtx,
+                                          fromNs,
+                                          "results",
+                                          "to",
+                                          "_id",
+                                          ExpressionFieldPath::create(expCtx, "startVal"),
+                                          boost::none,
+                                          FieldPath("depth"),
+                                          maxDepth,
+                                          boost::none,
+                                          ExpressionFieldPath::create(expCtx, "endVal"));
+    graphLookupStage->setSource(inputMock);
+    graphLookupStage->injectMongoProcessInterface(
+        std::make_shared<MockMongoProcessInterfaceImplementation>(std::move(fromContents)));
+    return graphLookupStage;
+}
+
+TEST_F(DocumentSourceGraphLookUpTest, BidirectionalSearchShouldReturnShortestChainInOrder) {
+    auto expCtx = getExpCtx();
+    std::deque<DocumentSource::GetNextResult> inputs{Document{{"startVal", 0}, {"endVal", 3}},
+                                                     Document{{"startVal", 2}, {"endVal", 2}},
+                                                     Document{{"startVal", 3}, {"endVal", 0}},
+                                                     Document{{"startVal", 0}, {"endVal", 5}}};
+    auto inputMock = DocumentSourceMock::create(std::move(inputs));
+    auto graphLookupStage = makeBidirectionalGraphLookUp(expCtx, inputMock.get(), boost::none);
+
+    auto next = graphLookupStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    Document startDoc{{"_id", 0}, {"to", std::vector<Value>{Value(1), Value(4)}}, {"depth", 0LL}};
+    ASSERT_VALUE_EQ(Value(std::vector<Value>{Value(startDoc),
+                                             Value(Document{{"_id", 4}, {"to", 3}, {"depth", 1LL}}),
+                                             Value(Document{{"_id", 3}, {"depth", 2LL}})}),
+                    next.getDocument()["results"]);
+
+    // A document matching both ends is a chain by itself.
+    next = graphLookupStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_VALUE_EQ(
+        Value(std::vector<Value>{Value(Document{{"_id", 2}, {"to", 3}, {"depth", 0LL}})}),
+        next.getDocument()["results"]);
+
+    // There is no chain against the direction of the edges, or to a value no document holds.
+    for (int i = 0; i < 2; ++i) {
+        next = graphLookupStage->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_VALUE_EQ(Value(std::vector<Value>{}), next.getDocument()["results"]);
+    }
+
+    ASSERT(graphLookupStage->getNext().isEOF());
+}
+
+TEST_F(DocumentSourceGraphLookUpTest, BidirectionalSearchShouldRespectMaxDepth) {
+    auto expCtx = getExpCtx();
+    auto inputMock = DocumentSourceMock::create(Document{{"startVal", 0}, {"endVal", 3}});
+    auto next = makeBidirectionalGraphLookUp(expCtx, inputMock.get(), 1LL)->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_VALUE_EQ(Value(std::vector<Value>{}), next.getDocument()["results"]);
+
+    inputMock = DocumentSourceMock::create(Document{{"startVal", 0}, {"endVal", 3}});
+    next = makeBidirectionalGraphLookUp(expCtx, inputMock.get(), 2LL)->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_EQ(3U, next.getDocument()["results"].getArrayLength());
+}
+
+TEST_F(DocumentSourceGraphLookUpTest, ShouldSerializeEndWith) {
+    auto expCtx = getExpCtx();
+    auto inputMock = DocumentSourceMock::create();
+    auto graphLookupStage = makeBidirectionalGraphLookUp(expCtx, inputMock.get(), boost::none);
+
+    std::vector<Value> serialized;
+    graphLookupStage->serializeToArray(serialized);
+    ASSERT_EQ(1U, serialized.size());
+    ASSERT_VALUE_EQ(Value("$endVal"_sd), serialized[0]["$graphLookup"]["endWith"]);
+
+    auto reparsed = DocumentSourceGraphLookUp::createFromBson(
+        serialized[0].getDocument().toBson().firstElement(), expCtx);
+    std::vector<Value> reserialized;
+    reparsed->serializeToArray(reserialized);
+    ASSERT_VALUE_EQ(Value(serialized), Value(reserialized));
+}
+
 }  // namespace
 }  // namespace mongo
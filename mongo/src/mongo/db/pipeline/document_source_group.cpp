@@ -32,12 +32,14 @@
 #include "mongo/db/pipeline/accumulation_statement.h"
 #include "mongo/db/pipeline/accumulator.h"
 #include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/document_batch.h"
 #include "mongo/db/pipeline/document_source_group.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/stdx/memory.h"
 
 namespace mongo {
@@ -479,72 +481,76 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
 
 
     // Barring any pausing, this loop exhausts 'pSource' and populates '_groups'.
-    GetNextResult input = pSource->getNext();
-    for (; input.isAdvanced(); input = pSource->getNext()) {
-        if (_memoryUsageBytes > _maxMemoryUsageBytes) {
-            uassert(16945,
-                    "Exceeded memory limit for $group, but didn't allow external sort."
-                    " Pass allowDiskUse:true to opt in.",
-                    _allowDiskUse);
-            _sortedFiles.push_back(spill());
-            _memoryUsageBytes = 0;
-        }
-
-        // We release the result document here so that it does not outlive the end of this loop
-        // iteration. Not releasing could lead to an array copy when this group follows an unwind.
-        auto rootDocument = input.releaseDocument();
-        Value id = computeId(rootDocument);
-
-        // Look for the _id value in the map. If it's not there, add a new entry with a blank
-        // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
-        // looking it up in '_groups' multiple times.
-        const size_t oldSize = _groups->size();
-        vector<intrusive_ptr<Accumulator>>& group = (*_groups)[id];
-        const bool inserted = _groups->size() != oldSize;
-
-        if (inserted) {
-            _memoryUsageBytes += id.getApproximateSize();
-
-            // Add the accumulators
-            group.reserve(numAccumulators);
-            for (auto&& accumulatedField : _accumulatedFields) {
-                group.push_back(accumulatedField.makeAccumulator(pExpCtx));
+    DocumentBatch batch(internalDocumentSourceBatchSize.load());
+    do {
+        pSource->getNextBatch(&batch);
+        for (auto&& input : batch) {
+            if (_memoryUsageBytes > _maxMemoryUsageBytes) {
+                uassert(16945,
+                        "Exceeded memory limit for $group, but didn't allow external sort."
+                        " Pass allowDiskUse:true to opt in.",
+                        _allowDiskUse);
+                _sortedFiles.push_back(spill());
+                _memoryUsageBytes = 0;
             }
-        } else {
-            for (auto&& groupObj : group) {
-                // subtract old mem usage. New usage added back after processing.
-                _memoryUsageBytes -= groupObj->memUsageForSorter();
+
+            // We release the input document here so that it does not outlive the end of this loop
+            // iteration. Not releasing could lead to an array copy when this group follows an
+            // unwind.
+            auto rootDocument = std::move(input);
+            Value id = computeId(rootDocument);
+
+            // Look for the _id value in the map. If it's not there, add a new entry with a blank
+            // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
+            // looking it up in '_groups' multiple times.
+            const size_t oldSize = _groups->size();
+            vector<intrusive_ptr<Accumulator>>& group = (*_groups)[id];
+            const bool inserted = _groups->size() != oldSize;
+
+            if (inserted) {
+                _memoryUsageBytes += id.getApproximateSize();
+
+                // Add the accumulators
+                group.reserve(numAccumulators);
+                for (auto&& accumulatedField : _accumulatedFields) {
+                    group.push_back(accumulatedField.makeAccumulator(pExpCtx));
+                }
+            } else {
+                for (auto&& groupObj : group) {
+                    // subtract old mem usage. New usage added back after processing.
+                    _memoryUsageBytes -= groupObj->memUsageForSorter();
+                }
             }
-        }
 
-        /* tickle all the accumulators for the group we found */
-        dassert(numAccumulators == group.size());
+            /* tickle all the accumulators for the group we found */
+            dassert(numAccumulators == group.size());
 
-        for (size_t i = 0; i < numAccumulators; i++) {
-            group[i]->process(_accumulatedFields[i].expression->evaluate(rootDocument),
-                              _doingMerge);
+            for (size_t i = 0; i < numAccumulators; i++) {
+                group[i]->process(_accumulatedFields[i].expression->evaluate(rootDocument),
+                                  _doingMerge);
 
-            _memoryUsageBytes += group[i]->memUsageForSorter();
-        }
+                _memoryUsageBytes += group[i]->memUsageForSorter();
+            }
 
-        if (kDebugBuild && !storageGlobalParams.readOnly) {
-            // In debug mode, spill every time we have a duplicate id to stress merge logic.
-            if (!inserted &&                 // is a dup
-                !pExpCtx->inMongos &&        // can't spill to disk in mongos
-                !_allowDiskUse &&            // don't change behavior when testing external sort
-                _sortedFiles.size() < 20) {  // don't open too many FDs
+            if (kDebugBuild && !storageGlobalParams.readOnly) {
+                // In debug mode, spill every time we have a duplicate id to stress merge logic.
+                if (!inserted &&                 // is a dup
+                    !pExpCtx->inMongos &&        // can't spill to disk in mongos
+                    !_allowDiskUse &&            // don't change behavior when testing external sort
+                    _sortedFiles.size() < 20) {  // don't open too many FDs
 
-                _sortedFiles.push_back(spill());
+                    _sortedFiles.push_back(spill());
+                }
             }
         }
-    }
+    } while (batch.getStatus() == DocumentBatch::ReturnStatus::kAdvanced);
 
-    switch (input.getStatus()) {
+    switch (batch.getStatus()) {
         case DocumentSource::GetNextResult::ReturnStatus::kAdvanced: {
             MONGO_UNREACHABLE;  // We consumed all advances above.
         }
         case DocumentSource::GetNextResult::ReturnStatus::kPauseExecution: {
-            return input;  // Propagate pause.
+            return GetNextResult::makePauseExecution();  // Propagate pause.
         }
         case DocumentSource::GetNextResult::ReturnStatus::kEOF: {
             // Do any final steps necessary to prepare to output results.
@@ -576,7 +582,7 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
             // This must happen last so that, unless control gets here, we will re-enter
             // initialization after getting a GetNextResult::ResultState::kPauseExecution.
             _initialized = true;
-            return input;
+            return GetNextResult::makeEOF();
         }
     }
     MONGO_UNREACHABLE;
@@ -622,6 +628,34 @@ shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
     return shared_ptr<Sorter<Value, Value>::Iterator>(writer.done());
 }
 
+boost::optional<std::string> DocumentSourceGroup::getDistinctScanField(
+    bool* needsLastDocument) const {
+    if (_doingMerge || _idExpressions.size() != 1 || !_idFieldNames.empty()) {
+        return boost::none;
+    }
+
+    auto idPath = dynamic_cast<ExpressionFieldPath*>(_idExpressions.front().get());
+    if (!idPath || !idPath->isRootFieldPath() || idPath->getFieldPath().getPathLength() < 2) {
+        return boost::none;
+    }
+
+    // A single index scan visits either the first or the last document of each group, so $first
+    // and $last cannot be mixed.
+    boost::optional<StringData> accumulatorName;
+    for (auto&& accumulatedField : _accumulatedFields) {
+        StringData opName = accumulatedField.makeAccumulator(pExpCtx)->getOpName();
+        if ((opName != "$first" && opName != "$last") ||
+            (accumulatorName && opName != *accumulatorName)) {
+            return boost::none;
+        }
+        accumulatorName = opName;
+    }
+
+    *needsLastDocument = accumulatorName && *accumulatorName == "$last";
+
+    return idPath->getFieldPath().tail().fullPath();
+}
+
 boost::optional<BSONObj> DocumentSourceGroup::findRelevantInputSort() const {
     if (true) {
         // Until streaming $group correctly handles nullish values, the streaming behavior is
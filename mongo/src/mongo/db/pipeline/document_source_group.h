@@ -98,6 +98,16 @@ public:
         return _streaming;
     }
 
+    /**
+     * If this $group can be computed from one document of each group, returns the path of the
+     * field it groups by. That is the case when the _id is a single field path and the
+     * accumulators are either all $first or all $last, so that an index scan which skips to the
+     * next value of that field, DISTINCT_SCAN, provides all the input needed. Sets
+     * 'needsLastDocument' if the accumulators are $last, in which case the scan must run
+     * backwards to see the last document of each group. Returns boost::none otherwise.
+     */
+    boost::optional<std::string> getDistinctScanField(bool* needsLastDocument) const;
+
     // Virtuals for SplittableDocumentSource.
     boost::intrusive_ptr<DocumentSource> getShardSource() final;
     std::list<boost::intrusive_ptr<DocumentSource>> getMergeSources() final;
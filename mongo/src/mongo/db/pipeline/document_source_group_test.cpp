@@ -47,12 +47,14 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
 #include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_test_service_context.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/stdx/unordered_set.h"
 #include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -97,6 +99,41 @@ TEST_F(DocumentSourceGroupTest, ShouldBeAbleToPauseLoading) {
     ASSERT_DOCUMENT_EQ(result.releaseDocument(), (Document{{"_id", BSONNULL}, {"count", 4}}));
 }
 
+TEST_F(DocumentSourceGroupTest, ShouldLoadInBatchesAndPauseOnBatchBoundaries) {
+    const int oldBatchSize = internalDocumentSourceBatchSize.load();
+    internalDocumentSourceBatchSize.store(2);
+    ON_BLOCK_EXIT([oldBatchSize] { internalDocumentSourceBatchSize.store(oldBatchSize); });
+
+    auto expCtx = getExpCtx();
+    expCtx->inMongos = true;  // Disallow external sort.
+                              // This is the only way to do this in a debug build.
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement sumStatement{"total",
+                                       ExpressionFieldPath::parse(expCtx, "$b", vps),
+                                       AccumulationStatement::getFactory("$sum")};
+    auto group = DocumentSourceGroup::create(
+        expCtx, ExpressionConstant::create(expCtx, Value(BSONNULL)), {sumStatement});
+    auto mock = DocumentSourceMock::create({Document{{"b", 1}},
+                                            Document{{"b", 2}},
+                                            DocumentSource::GetNextResult::makePauseExecution(),
+                                            Document{{"b", 3}},
+                                            Document{{"b", 4}},
+                                            Document{{"b", 5}},
+                                            DocumentSource::GetNextResult::makePauseExecution(),
+                                            Document{{"b", 6}}});
+    group->setSource(mock.get());
+
+    // The first pause falls right after a full batch, and the second within a batch.
+    ASSERT_TRUE(group->getNext().isPaused());
+    ASSERT_TRUE(group->getNext().isPaused());
+
+    // Every document is accumulated exactly once.
+    auto result = group->getNext();
+    ASSERT_TRUE(result.isAdvanced());
+    ASSERT_DOCUMENT_EQ(result.releaseDocument(), (Document{{"_id", BSONNULL}, {"total", 21}}));
+    ASSERT_TRUE(group->getNext().isEOF());
+}
+
 TEST_F(DocumentSourceGroupTest, ShouldBeAbleToPauseLoadingWhileSpilled) {
     auto expCtx = getExpCtx();
 
@@ -771,6 +808,45 @@ public:
     }
 };
 
+class DistinctScanField : public Base {
+public:
+    void run() {
+        bool needsLastDocument = true;
+        createGroup(fromjson("{_id: '$x'}"));
+        ASSERT_EQUALS(std::string("x"), *group()->getDistinctScanField(&needsLastDocument));
+        ASSERT_FALSE(needsLastDocument);
+
+        createGroup(fromjson("{_id: '$x.y', a: {$first: '$a'}, b: {$first: '$$ROOT'}}"));
+        ASSERT_EQUALS(std::string("x.y"), *group()->getDistinctScanField(&needsLastDocument));
+        ASSERT_FALSE(needsLastDocument);
+
+        createGroup(fromjson("{_id: '$x', a: {$last: '$a'}, b: {$last: '$$ROOT'}}"));
+        ASSERT_EQUALS(std::string("x"), *group()->getDistinctScanField(&needsLastDocument));
+        ASSERT_TRUE(needsLastDocument);
+
+        // Counting needs every document of the group.
+        createGroup(fromjson("{_id: '$x', n: {$sum: 1}}"));
+        ASSERT_FALSE(group()->getDistinctScanField(&needsLastDocument));
+
+        // The first and the last document of a group cannot both come from one scan.
+        createGroup(fromjson("{_id: '$x', a: {$first: '$a'}, b: {$last: '$b'}}"));
+        ASSERT_FALSE(group()->getDistinctScanField(&needsLastDocument));
+
+        // Only a single field path can be answered by skipping through one index field.
+        createGroup(fromjson("{_id: {x: '$x', y: '$y'}}"));
+        ASSERT_FALSE(group()->getDistinctScanField(&needsLastDocument));
+
+        createGroup(fromjson("{_id: {$add: ['$x', 1]}}"));
+        ASSERT_FALSE(group()->getDistinctScanField(&needsLastDocument));
+
+        createGroup(fromjson("{_id: '$$ROOT'}"));
+        ASSERT_FALSE(group()->getDistinctScanField(&needsLastDocument));
+
+        createGroup(fromjson("{_id: null}"));
+        ASSERT_FALSE(group()->getDistinctScanField(&needsLastDocument));
+    }
+};
+
 class StreamingOptimization : public Base {
 public:
     void run() {
@@ -1155,6 +1231,7 @@ public:
         add<UndefinedAccumulatorValue>();
         add<RouterMerger>();
         add<Dependencies>();
+        add<DistinctScanField>();
         add<StringConstantIdAndAccumulatorExpressions>();
         add<ArrayConstantAccumulatorExpression>();
 #if 0
@@ -35,6 +35,8 @@
 #include "mongo/db/matcher/expression_algo.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/document_path_support.h"
+#include "mongo/db/pipeline/document_source_limit.h"
+#include "mongo/db/pipeline/document_source_skip.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/value.h"
@@ -323,6 +325,16 @@ Pipeline::SourceContainer::iterator DocumentSourceLookUp::doOptimizeAt(
         return itr;
     }
 
+    // Unless we are unwinding our results, we produce exactly one document per input document, so
+    // a following $skip or $limit can move before us. This avoids joining documents which will be
+    // discarded, and allows a $limit to be absorbed by a preceding $sort.
+    auto nextSkip = dynamic_cast<DocumentSourceSkip*>((*std::next(itr)).get());
+    auto nextLimit = dynamic_cast<DocumentSourceLimit*>((*std::next(itr)).get());
+    if ((nextSkip || nextLimit) && !_unwindSrc) {
+        std::swap(*itr, *std::next(itr));
+        return itr == container->begin() ? itr : std::prev(itr);
+    }
+
     // Attempt to internalize any predicates of a $match upon the "_as" field.
     auto nextMatch = dynamic_cast<DocumentSourceMatch*>((*std::next(itr)).get());
 
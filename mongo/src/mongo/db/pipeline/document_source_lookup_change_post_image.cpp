@@ -30,7 +30,13 @@
 
 #include "mongo/db/pipeline/document_source_lookup_change_post_image.h"
 
+#include <algorithm>
+
 #include "mongo/bson/simple_bsonelement_comparator.h"
+#include "mongo/bson/simple_bsonobj_comparator.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -58,22 +64,181 @@ Value assertFieldHasType(const Document& fullDoc, StringData fieldName, BSONType
 DocumentSource::GetNextResult DocumentSourceLookupChangePostImage::getNext() {
     pExpCtx->checkForInterrupt();
 
-    auto input = pSource->getNext();
-    if (!input.isAdvanced()) {
-        return input;
+    if (_window.empty() && !_windowEnd) {
+        loadWindow();
+    }
+
+    if (!_window.empty()) {
+        auto next = _window.front().freeze();
+        _window.pop_front();
+        return next;
+    }
+
+    invariant(_windowEnd);
+    auto windowEnd = std::move(*_windowEnd);
+    _windowEnd = boost::none;
+    return windowEnd;
+}
+
+void DocumentSourceLookupChangePostImage::loadWindow() {
+    const size_t maxWindowSize =
+        std::max(1, internalChangeStreamPostImageLookupBatchSize.load());
+
+    // Once the window holds an event, only read as far ahead as the input can go without waiting
+    // for new events.
+    const bool wasReadingAhead = pExpCtx->readingAhead;
+    ON_BLOCK_EXIT([this, wasReadingAhead] { pExpCtx->readingAhead = wasReadingAhead; });
+
+    std::vector<size_t> updatePositions;
+    while (_window.size() < maxWindowSize) {
+        auto input = pSource->getNext();
+        if (!input.isAdvanced()) {
+            _windowEnd = std::move(input);
+            break;
+        }
+
+        const auto opType = assertFieldHasType(input.getDocument(),
+                                               DocumentSourceChangeStream::kOperationTypeField,
+                                               BSONType::String)
+                                .getString();
+        if (opType == DocumentSourceChangeStream::kUpdateOpType) {
+            updatePositions.push_back(_window.size());
+        }
+        _window.emplace_back(input.releaseDocument());
+
+        // The cursor is closed once an invalidate has been returned, so don't read past one.
+        if (opType == DocumentSourceChangeStream::kInvalidateOpType) {
+            break;
+        }
+        pExpCtx->readingAhead = true;
     }
-    auto opTypeVal = assertFieldHasType(
-        input.getDocument(), DocumentSourceChangeStream::kOperationTypeField, BSONType::String);
-    if (opTypeVal.getString() != DocumentSourceChangeStream::kUpdateOpType) {
-        return input;
+
+    if (!updatePositions.empty()) {
+        lookupPostImages(updatePositions);
     }
+}
 
+void DocumentSourceLookupChangePostImage::lookupPostImages(
+    const std::vector<size_t>& updatePositions) {
     // Temporarily remove any deadline from this operation to avoid timeout during lookup.
     OperationContext::DeadlineStash deadlineStash(pExpCtx->opCtx);
+    Timer timer;
+
+    // Make sure we have well-formed inputs, and collect the keys of the documents to look up. The
+    // updates of a single collection share its UUID; look up any others individually.
+    NamespaceString nss;
+    boost::optional<UUID> uuid;
+    Timestamp clusterTime;
+    std::vector<Document> documentKeys;
+    std::vector<size_t> keyPositions;
+    for (auto position : updatePositions) {
+        auto& updateOp = _window[position];
+        nss = assertNamespaceMatches(updateOp.peek());
+        auto documentKey = assertFieldHasType(updateOp.peek(),
+                                              DocumentSourceChangeStream::kDocumentKeyField,
+                                              BSONType::Object)
+                               .getDocument();
+        auto resumeToken =
+            ResumeToken::parse(updateOp.peek()[DocumentSourceChangeStream::kIdField].getDocument());
+        invariant(resumeToken.getData().uuid);
+        if (uuid && *uuid != *resumeToken.getData().uuid) {
+            updateOp[kFullDocumentFieldName] = lookupPostImage(updateOp.peek());
+            ++_stats.individualLookups;
+            continue;
+        }
 
-    MutableDocument output(input.releaseDocument());
-    output[kFullDocumentFieldName] = lookupPostImage(output.peek());
-    return output.freeze();
+        uuid = resumeToken.getData().uuid;
+        clusterTime = std::max(clusterTime, resumeToken.getData().clusterTime);
+        documentKeys.push_back(std::move(documentKey));
+        keyPositions.push_back(position);
+    }
+
+    // On mongos, read from a majority committed snapshot which includes the latest of the updates.
+    const auto readConcern = pExpCtx->inMongos
+        ? boost::optional<BSONObj>(BSON("level"
+                                        << "majority"
+                                        << "afterClusterTime"
+                                        << clusterTime))
+        : boost::none;
+    bool complete = true;
+    auto lookedUpDocs = _mongoProcessInterface->lookupDocuments(
+        nss, *uuid, documentKeys, readConcern, &complete);
+
+    // Index the keys by their BSON, and collect the distinct lists of fields they are made of.
+    auto keysByBson =
+        SimpleBSONObjComparator::kInstance.makeBSONObjIndexedMap<std::vector<size_t>>();
+    std::vector<std::vector<std::string>> keyFieldLists;
+    for (size_t i = 0; i < documentKeys.size(); ++i) {
+        auto keyObj = documentKeys[i].toBson();
+        keysByBson[keyObj].push_back(i);
+
+        std::vector<std::string> keyFields;
+        for (auto&& elem : keyObj) {
+            keyFields.push_back(elem.fieldName());
+        }
+        if (std::find(keyFieldLists.begin(), keyFieldLists.end(), keyFields) ==
+            keyFieldLists.end()) {
+            keyFieldLists.push_back(std::move(keyFields));
+        }
+    }
+
+    // Match each document found to the keys it was looked up by. Documents are matched on the
+    // exact BSON of their key fields, so a document found through a key which is only equal to it
+    // under the collection's default collation is left unclaimed.
+    std::vector<boost::optional<Document>> postImages(documentKeys.size());
+    bool allClaimed = true;
+    for (auto&& lookedUpDoc : lookedUpDocs) {
+        bool claimed = false;
+        for (auto&& keyFields : keyFieldLists) {
+            BSONObjBuilder keyBuilder;
+            for (auto&& field : keyFields) {
+                auto value = lookedUpDoc.getNestedField(FieldPath(field));
+                if (!value.missing()) {
+                    value.addToBsonObj(&keyBuilder, field);
+                }
+            }
+
+            auto it = keysByBson.find(keyBuilder.obj());
+            if (it == keysByBson.end()) {
+                continue;
+            }
+            for (auto i : it->second) {
+                uassert(ErrorCodes::TooManyMatchingDocuments,
+                        str::stream() << "found more than one document with document key "
+                                      << documentKeys[i].toString()
+                                      << " ["
+                                      << postImages[i]->toString()
+                                      << ", "
+                                      << lookedUpDoc.toString()
+                                      << "]",
+                        !postImages[i]);
+                postImages[i] = lookedUpDoc;
+            }
+            claimed = true;
+        }
+        allClaimed = allClaimed && claimed;
+    }
+
+    for (size_t i = 0; i < documentKeys.size(); ++i) {
+        auto& updateOp = _window[keyPositions[i]];
+        if (postImages[i]) {
+            updateOp[kFullDocumentFieldName] = Value(*postImages[i]);
+        } else if (complete && allClaimed) {
+            // The document may have been deleted in the time since the update op.
+            updateOp[kFullDocumentFieldName] = Value(BSONNULL);
+        } else {
+            // The document may be missing from incomplete results, or be one of the unclaimed
+            // documents, so look it up on its own to be sure.
+            updateOp[kFullDocumentFieldName] = lookupPostImage(updateOp.peek());
+            ++_stats.individualLookups;
+        }
+    }
+
+    _stats.batches++;
+    _stats.documentsLookedUp += updatePositions.size();
+    _stats.lastBatchSize = updatePositions.size();
+    _stats.lastLookupTime = Milliseconds(timer.millis());
+    _stats.totalLookupTime += _stats.lastLookupTime;
 }
 
 NamespaceString DocumentSourceLookupChangePostImage::assertNamespaceMatches(
@@ -120,4 +285,23 @@ Value DocumentSourceLookupChangePostImage::lookupPostImage(const Document& updat
     return (lookedUpDoc ? Value(*lookedUpDoc) : Value(BSONNULL));
 }
 
+Value DocumentSourceLookupChangePostImage::serialize(
+    boost::optional<ExplainOptions::Verbosity> explain) const {
+    if (!explain) {
+        return Value();  // Do not serialize this stage unless we're explaining.
+    }
+
+    MutableDocument spec;
+    spec["batchSize"] = Value(internalChangeStreamPostImageLookupBatchSize.load());
+    if (*explain >= ExplainOptions::Verbosity::kExecStats) {
+        spec["batches"] = Value(_stats.batches);
+        spec["documentsLookedUp"] = Value(_stats.documentsLookedUp);
+        spec["lastBatchSize"] = Value(_stats.lastBatchSize);
+        spec["individualLookups"] = Value(_stats.individualLookups);
+        spec["totalLookupMillis"] = Value(durationCount<Milliseconds>(_stats.totalLookupTime));
+        spec["lastLookupMillis"] = Value(durationCount<Milliseconds>(_stats.lastLookupTime));
+    }
+    return Value{Document{{kStageName, spec.freeze()}}};
+}
+
 }  // namespace mongo
@@ -28,6 +28,10 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
+#include <deque>
+#include <vector>
+
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_change_stream.h"
 
@@ -37,6 +41,11 @@ namespace mongo {
  * Part of the change stream API machinery used to look up the post-image of a document. Uses
  * the "documentKey" field of the input to look up the new version of the document.
  *
+ * Reads a window of up to internalChangeStreamPostImageLookupBatchSize change events ahead, and
+ * looks up the post-images of all the updates among them with a single query per shard. The
+ * window ends early once the input has no more events ready, so reading ahead never delays the
+ * events already read. Events are returned in their original order.
+ *
  * Uses the ExpressionContext to determine what collection to look up into.
  * TODO SERVER-29134 When we allow change streams on multiple collections, this will need to change.
  */
@@ -93,21 +102,42 @@ public:
      */
     GetNextResult getNext() final;
 
-    Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final {
-        if (explain) {
-            return Value{Document{{kStageName, Document()}}};
-        }
-        return Value();  // Do not serialize this stage unless we're explaining.
-    }
+    Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
 
     const char* getSourceName() const final {
         return kStageName.rawData();
     }
 
 private:
+    /**
+     * Statistics about the lookups performed by this stage, reported in explain output.
+     */
+    struct LookupStats {
+        long long batches = 0;
+        long long documentsLookedUp = 0;
+        long long lastBatchSize = 0;
+        long long individualLookups = 0;
+        Milliseconds totalLookupTime{0};
+        Milliseconds lastLookupTime{0};
+    };
+
     DocumentSourceLookupChangePostImage(const boost::intrusive_ptr<ExpressionContext>& expCtx)
         : DocumentSourceNeedsMongoProcessInterface(expCtx) {}
 
+    /**
+     * Reads the next window of change events from the input into '_window', and looks up the
+     * post-images of the updates among them. Stores the result which ended the window in
+     * '_windowEnd' if it was an EOF or a pause.
+     */
+    void loadWindow();
+
+    /**
+     * Looks up the post-images of the update events in '_window' at positions 'updatePositions',
+     * and sets them as the "fullDocument" of those events. Sets Value(BSONNULL) for documents which
+     * couldn't be found.
+     */
+    void lookupPostImages(const std::vector<size_t>& updatePositions);
+
     /**
      * Uses the "documentKey" field from 'updateOp' to look up the current version of the document.
      * Returns Value(BSONNULL) if the document couldn't be found.
@@ -119,6 +149,14 @@ private:
      * ExpressionContext.
      */
     NamespaceString assertNamespaceMatches(const Document& inputDoc) const;
+
+    // The events read ahead from the input which are yet to be returned, in their original order.
+    std::deque<MutableDocument> _window;
+
+    // The EOF or pause which ended the current window, to be returned once it has been drained.
+    boost::optional<GetNextResult> _windowEnd;
+
+    LookupStats _stats;
 };
 
 }  // namespace mongo
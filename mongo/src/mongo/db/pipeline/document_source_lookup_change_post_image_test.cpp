@@ -44,6 +44,8 @@
 #include "mongo/db/pipeline/field_path.h"
 #include "mongo/db/pipeline/stub_mongo_process_interface.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace {
@@ -117,6 +119,7 @@ public:
                                                    UUID collectionUUID,
                                                    const Document& documentKey,
                                                    boost::optional<BSONObj> readConcern) {
+        ++numSingleLookups;
         boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest(nss));
         auto swPipeline = makePipeline({BSON("$match" << documentKey)}, expCtx);
         if (swPipeline == ErrorCodes::NamespaceNotFound) {
@@ -138,6 +141,33 @@ public:
         return lookedUpDocument;
     }
 
+    std::vector<Document> lookupDocuments(const NamespaceString& nss,
+                                          UUID collectionUUID,
+                                          const std::vector<Document>& documentKeys,
+                                          boost::optional<BSONObj> readConcern,
+                                          bool* complete) {
+        ++numBatchedLookups;
+        boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest(nss));
+        auto pipeline = uassertStatusOK(
+            makePipeline({BSON("$match" << makeDocumentKeysFilter(documentKeys))}, expCtx));
+
+        std::vector<Document> lookedUpDocuments;
+        while (auto next = pipeline->getNext()) {
+            lookedUpDocuments.push_back(std::move(*next));
+        }
+
+        // Simulate a batch which could only hold the first document found.
+        *complete = !(returnIncompleteResults && lookedUpDocuments.size() > 1u);
+        if (!*complete) {
+            lookedUpDocuments.resize(1u);
+        }
+        return lookedUpDocuments;
+    }
+
+    int numSingleLookups = 0;
+    int numBatchedLookups = 0;
+    bool returnIncompleteResults = false;
+
 private:
     deque<DocumentSource::GetNextResult> _mockResults;
 };
@@ -333,5 +363,194 @@ TEST_F(DocumentSourceLookupChangePostImageTest, ShouldPropagatePauses) {
     ASSERT_TRUE(lookupChangeStage->getNext().isEOF());
 }
 
+TEST_F(DocumentSourceLookupChangePostImageTest, ShouldLookUpPostImagesOfAWindowInASingleBatch) {
+    auto expCtx = getExpCtx();
+    const auto ns = Document{{"db", expCtx->ns.db()}, {"coll", expCtx->ns.coll()}};
+
+    // Set up the $lookup stage.
+    auto lookupChangeStage = DocumentSourceLookupChangePostImage::create(expCtx);
+
+    // Mock its input with updates surrounding an insert. The last update's document has since been
+    // deleted.
+    auto mockLocalSource = DocumentSourceMock::create(
+        {Document{{"_id", makeResumeToken(0)},
+                  {"documentKey", Document{{"_id", 0}}},
+                  {"operationType", "update"_sd},
+                  {"ns", ns}},
+         Document{{"_id", makeResumeToken(1)},
+                  {"documentKey", Document{{"_id", 1}}},
+                  {"operationType", "insert"_sd},
+                  {"ns", ns},
+                  {"fullDocument", Document{{"_id", 1}}}},
+         Document{{"_id", makeResumeToken(2)},
+                  {"documentKey", Document{{"_id", 2}}},
+                  {"operationType", "update"_sd},
+                  {"ns", ns}},
+         Document{{"_id", makeResumeToken(3)},
+                  {"documentKey", Document{{"_id", 3}}},
+                  {"operationType", "update"_sd},
+                  {"ns", ns}}});
+    lookupChangeStage->setSource(mockLocalSource.get());
+
+    // Mock out the foreign collection.
+    deque<DocumentSource::GetNextResult> mockForeignContents{
+        Document{{"_id", 0}, {"x", 0}}, Document{{"_id", 1}}, Document{{"_id", 2}, {"x", 2}}};
+    auto mongoProcessInterface =
+        std::make_shared<MockMongoProcessInterface>(std::move(mockForeignContents));
+    lookupChangeStage->injectMongoProcessInterface(mongoProcessInterface);
+
+    // The events are returned in their original order, with the post-images of the updates.
+    auto next = lookupChangeStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_VALUE_EQ(next.releaseDocument()["fullDocument"], Value(Document{{"_id", 0}, {"x", 0}}));
+
+    next = lookupChangeStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_VALUE_EQ(next.releaseDocument()["operationType"], Value("insert"_sd));
+
+    next = lookupChangeStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_VALUE_EQ(next.releaseDocument()["fullDocument"], Value(Document{{"_id", 2}, {"x", 2}}));
+
+    next = lookupChangeStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_VALUE_EQ(next.releaseDocument()["fullDocument"], Value(BSONNULL));
+
+    ASSERT_TRUE(lookupChangeStage->getNext().isEOF());
+
+    // All three post-images were looked up together.
+    ASSERT_EQ(1, mongoProcessInterface->numBatchedLookups);
+    ASSERT_EQ(0, mongoProcessInterface->numSingleLookups);
+
+    auto explained = lookupChangeStage->serialize(ExplainOptions::Verbosity::kExecStats);
+    auto stats = explained.getDocument()[DocumentSourceLookupChangePostImage::kStageName];
+    ASSERT_VALUE_EQ(stats["batches"], Value(1LL));
+    ASSERT_VALUE_EQ(stats["documentsLookedUp"], Value(3LL));
+    ASSERT_VALUE_EQ(stats["lastBatchSize"], Value(3LL));
+    ASSERT_VALUE_EQ(stats["individualLookups"], Value(0LL));
+}
+
+TEST_F(DocumentSourceLookupChangePostImageTest, ShouldLimitWindowToBatchSize) {
+    auto expCtx = getExpCtx();
+    const auto ns = Document{{"db", expCtx->ns.db()}, {"coll", expCtx->ns.coll()}};
+
+    const auto originalBatchSize = internalChangeStreamPostImageLookupBatchSize.load();
+    internalChangeStreamPostImageLookupBatchSize.store(2);
+    ON_BLOCK_EXIT([originalBatchSize] {
+        internalChangeStreamPostImageLookupBatchSize.store(originalBatchSize);
+    });
+
+    // Set up the $lookup stage.
+    auto lookupChangeStage = DocumentSourceLookupChangePostImage::create(expCtx);
+
+    // Mock its input with three updates.
+    deque<DocumentSource::GetNextResult> updates;
+    for (int i = 0; i < 3; ++i) {
+        updates.push_back(Document{{"_id", makeResumeToken(i)},
+                                   {"documentKey", Document{{"_id", i}}},
+                                   {"operationType", "update"_sd},
+                                   {"ns", ns}});
+    }
+    auto mockLocalSource = DocumentSourceMock::create(std::move(updates));
+    lookupChangeStage->setSource(mockLocalSource.get());
+
+    // Mock out the foreign collection.
+    deque<DocumentSource::GetNextResult> mockForeignContents{
+        Document{{"_id", 0}}, Document{{"_id", 1}}, Document{{"_id", 2}}};
+    auto mongoProcessInterface =
+        std::make_shared<MockMongoProcessInterface>(std::move(mockForeignContents));
+    lookupChangeStage->injectMongoProcessInterface(mongoProcessInterface);
+
+    for (int i = 0; i < 3; ++i) {
+        auto next = lookupChangeStage->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_VALUE_EQ(next.releaseDocument()["fullDocument"], Value(Document{{"_id", i}}));
+    }
+    ASSERT_TRUE(lookupChangeStage->getNext().isEOF());
+
+    ASSERT_EQ(2, mongoProcessInterface->numBatchedLookups);
+    ASSERT_EQ(0, mongoProcessInterface->numSingleLookups);
+}
+
+TEST_F(DocumentSourceLookupChangePostImageTest, ShouldNotReadPastAnInvalidate) {
+    auto expCtx = getExpCtx();
+    const auto ns = Document{{"db", expCtx->ns.db()}, {"coll", expCtx->ns.coll()}};
+
+    // Set up the $lookup stage.
+    auto lookupChangeStage = DocumentSourceLookupChangePostImage::create(expCtx);
+
+    // Mock its input with an invalidate between two updates.
+    auto mockLocalSource = DocumentSourceMock::create(
+        {Document{{"_id", makeResumeToken(0)},
+                  {"documentKey", Document{{"_id", 0}}},
+                  {"operationType", "update"_sd},
+                  {"ns", ns}},
+         Document{{"_id", makeResumeToken()}, {"operationType", "invalidate"_sd}},
+         Document{{"_id", makeResumeToken(1)},
+                  {"documentKey", Document{{"_id", 1}}},
+                  {"operationType", "update"_sd},
+                  {"ns", ns}}});
+    lookupChangeStage->setSource(mockLocalSource.get());
+
+    // Mock out the foreign collection.
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{{"_id", 0}},
+                                                             Document{{"_id", 1}}};
+    auto mongoProcessInterface =
+        std::make_shared<MockMongoProcessInterface>(std::move(mockForeignContents));
+    lookupChangeStage->injectMongoProcessInterface(mongoProcessInterface);
+
+    auto next = lookupChangeStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_VALUE_EQ(next.releaseDocument()["fullDocument"], Value(Document{{"_id", 0}}));
+
+    next = lookupChangeStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_VALUE_EQ(next.releaseDocument()["operationType"], Value("invalidate"_sd));
+    ASSERT_EQ(1, mongoProcessInterface->numBatchedLookups);
+
+    // The update following the invalidate was left unread until now.
+    next = lookupChangeStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_VALUE_EQ(next.releaseDocument()["fullDocument"], Value(Document{{"_id", 1}}));
+    ASSERT_EQ(2, mongoProcessInterface->numBatchedLookups);
+}
+
+TEST_F(DocumentSourceLookupChangePostImageTest, ShouldLookUpIndividuallyIfBatchIsIncomplete) {
+    auto expCtx = getExpCtx();
+    const auto ns = Document{{"db", expCtx->ns.db()}, {"coll", expCtx->ns.coll()}};
+
+    // Set up the $lookup stage.
+    auto lookupChangeStage = DocumentSourceLookupChangePostImage::create(expCtx);
+
+    // Mock its input with two updates.
+    auto mockLocalSource = DocumentSourceMock::create(
+        {Document{{"_id", makeResumeToken(0)},
+                  {"documentKey", Document{{"_id", 0}}},
+                  {"operationType", "update"_sd},
+                  {"ns", ns}},
+         Document{{"_id", makeResumeToken(1)},
+                  {"documentKey", Document{{"_id", 1}}},
+                  {"operationType", "update"_sd},
+                  {"ns", ns}}});
+    lookupChangeStage->setSource(mockLocalSource.get());
+
+    // Mock out the foreign collection, such that the batched lookup only returns one document.
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{{"_id", 0}},
+                                                             Document{{"_id", 1}}};
+    auto mongoProcessInterface =
+        std::make_shared<MockMongoProcessInterface>(std::move(mockForeignContents));
+    mongoProcessInterface->returnIncompleteResults = true;
+    lookupChangeStage->injectMongoProcessInterface(mongoProcessInterface);
+
+    // The document missing from the batch was looked up on its own.
+    for (int i = 0; i < 2; ++i) {
+        auto next = lookupChangeStage->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_VALUE_EQ(next.releaseDocument()["fullDocument"], Value(Document{{"_id", i}}));
+    }
+    ASSERT_EQ(1, mongoProcessInterface->numBatchedLookups);
+    ASSERT_EQ(1, mongoProcessInterface->numSingleLookups);
+}
+
 }  // namespace
 }  // namespace mongo
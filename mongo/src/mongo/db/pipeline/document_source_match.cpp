@@ -37,9 +37,11 @@
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/matcher/extensions_callback_noop.h"
 #include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/document_batch.h"
 #include "mongo/db/pipeline/document_path_support.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/stringutils.h"
 
@@ -74,6 +76,7 @@ intrusive_ptr<DocumentSource> DocumentSourceMatch::optimize() {
     }
 
     _expression = MatchExpression::optimize(std::move(_expression));
+    _compiledExpression.reset();
 
     return this;
 }
@@ -86,14 +89,7 @@ DocumentSource::GetNextResult DocumentSourceMatch::getNext() {
 
     auto nextInput = pSource->getNext();
     for (; nextInput.isAdvanced(); nextInput = pSource->getNext()) {
-        // MatchExpression only takes BSON documents, so we have to make one. As an optimization,
-        // only serialize the fields we need to do the match.
-        BSONObj toMatch = _dependencies.needWholeDocument
-            ? nextInput.getDocument().toBson()
-            : document_path_support::documentToBsonWithPaths(nextInput.getDocument(),
-                                                             _dependencies.fields);
-
-        if (_expression->matchesBSON(toMatch)) {
+        if (matches(nextInput.getDocument())) {
             return nextInput;
         }
 
@@ -108,6 +104,37 @@ DocumentSource::GetNextResult DocumentSourceMatch::getNext() {
     return nextInput;
 }
 
+void DocumentSourceMatch::getNextBatch(DocumentBatch* batch) {
+    pExpCtx->checkForInterrupt();
+
+    // The user facing error should have been generated earlier.
+    massert(17309, "Should never call getNext on a $match stage with $text clause", !_isTextQuery);
+
+    // Filter our child's batch in place. Keep asking for more if nothing matched, so that we only
+    // return an empty batch along with EOF or a pause.
+    do {
+        pSource->getNextBatch(batch);
+        batch->filter([this](const Document& input) { return matches(input); });
+    } while (batch->empty() && batch->getStatus() == DocumentBatch::ReturnStatus::kAdvanced);
+}
+
+bool DocumentSourceMatch::matches(const Document& input) {
+    // Compile the expression once the pipeline has been optimized and starts executing. Any
+    // rewrite of '_expression' after this point must reset '_compiledExpression'.
+    if (!_compiledExpression && internalQueryEnableCompiledMatchExpressions.load()) {
+        _compiledExpression = CompiledMatchExpression::compile(_expression.get());
+    }
+
+    // MatchExpression only takes BSON documents, so we have to make one. As an optimization, only
+    // serialize the fields we need to do the match.
+    BSONObj toMatch = _dependencies.needWholeDocument
+        ? input.toBson()
+        : document_path_support::documentToBsonWithPaths(input, _dependencies.fields);
+
+    return _compiledExpression ? _compiledExpression->matchesBSON(toMatch)
+                               : _expression->matchesBSON(toMatch);
+}
+
 Pipeline::SourceContainer::iterator DocumentSourceMatch::doOptimizeAt(
     Pipeline::SourceContainer::iterator itr, Pipeline::SourceContainer* container) {
     invariant(*itr == this);
@@ -376,6 +403,7 @@ void DocumentSourceMatch::joinMatchWith(intrusive_ptr<DocumentSourceMatch> other
     StatusWithMatchExpression status = uassertStatusOK(MatchExpressionParser::parse(
         _predicate, pExpCtx, ExtensionsCallbackNoop(), Pipeline::kAllowedMatcherFeatures));
     _expression = std::move(status.getValue());
+    _compiledExpression.reset();
     _dependencies = DepsTracker(_dependencies.getMetadataAvailable());
     getDependencies(&_dependencies);
 }
@@ -383,6 +411,7 @@ void DocumentSourceMatch::joinMatchWith(intrusive_ptr<DocumentSourceMatch> other
 pair<intrusive_ptr<DocumentSourceMatch>, intrusive_ptr<DocumentSourceMatch>>
 DocumentSourceMatch::splitSourceBy(const std::set<std::string>& fields,
                                    const StringMap<std::string>& renames) {
+    _compiledExpression.reset();
     pair<unique_ptr<MatchExpression>, unique_ptr<MatchExpression>> newExpr(
         expression::splitMatchExpressionBy(std::move(_expression), fields, renames));
 
@@ -32,6 +32,7 @@
 #include <utility>
 
 #include "mongo/client/connpool.h"
+#include "mongo/db/matcher/compiled_match_expression.h"
 #include "mongo/db/matcher/matcher.h"
 #include "mongo/db/pipeline/document_source.h"
 
@@ -42,6 +43,7 @@ public:
     virtual ~DocumentSourceMatch() = default;
 
     GetNextResult getNext() override;
+    void getNextBatch(DocumentBatch* batch) final;
     boost::intrusive_ptr<DocumentSource> optimize() final;
     BSONObjSet getOutputSorts() final {
         return pSource ? pSource->getOutputSorts()
@@ -159,8 +161,16 @@ protected:
                         const boost::intrusive_ptr<ExpressionContext>& expCtx);
 
 private:
+    /**
+     * Returns true if 'input' matches '_expression', compiling it first if needed.
+     */
+    bool matches(const Document& input);
+
     std::unique_ptr<MatchExpression> _expression;
 
+    // '_expression' compiled at the start of execution, if enabled.
+    std::unique_ptr<CompiledMatchExpression> _compiledExpression;
+
     BSONObj _predicate;
     const bool _isTextQuery;
 
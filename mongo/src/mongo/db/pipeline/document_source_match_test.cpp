@@ -35,6 +35,7 @@
 #include "mongo/bson/json.h"
 #include "mongo/db/pipeline/aggregation_context_fixture.h"
 #include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/document_batch.h"
 #include "mongo/db/pipeline/document_source_match.h"
 #include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/document_value_test_util.h"
@@ -493,6 +494,45 @@ TEST_F(DocumentSourceMatchTest, ShouldPropagatePauses) {
     ASSERT_TRUE(match->getNext().isEOF());
 }
 
+TEST_F(DocumentSourceMatchTest, ShouldFilterBatchesAndPropagatePauses) {
+    auto match = DocumentSourceMatch::create(BSON("a" << 1), getExpCtx());
+    auto mock = DocumentSourceMock::create({DocumentSource::GetNextResult::makePauseExecution(),
+                                            Document{{"a", 1}, {"b", 1}},
+                                            Document{{"a", 2}},
+                                            Document{{"a", 1}, {"b", 2}},
+                                            DocumentSource::GetNextResult::makePauseExecution(),
+                                            Document{{"a", 2}},
+                                            Document{{"a", 2}},
+                                            DocumentSource::GetNextResult::makePauseExecution(),
+                                            Document{{"a", 1}, {"b", 3}}});
+    match->setSource(mock.get());
+
+    DocumentBatch batch(4);
+    match->getNextBatch(&batch);
+    ASSERT_TRUE(batch.isPaused());
+    ASSERT_TRUE(batch.empty());
+
+    match->getNextBatch(&batch);
+    ASSERT_TRUE(batch.isPaused());
+    ASSERT_EQ(batch.size(), 2U);
+    ASSERT_DOCUMENT_EQ(batch[0], (Document{{"a", 1}, {"b", 1}}));
+    ASSERT_DOCUMENT_EQ(batch[1], (Document{{"a", 1}, {"b", 2}}));
+
+    // Neither {a: 2} matches, so the batch should be empty along with the next pause.
+    match->getNextBatch(&batch);
+    ASSERT_TRUE(batch.isPaused());
+    ASSERT_TRUE(batch.empty());
+
+    match->getNextBatch(&batch);
+    ASSERT_TRUE(batch.isEOF());
+    ASSERT_EQ(batch.size(), 1U);
+    ASSERT_DOCUMENT_EQ(batch[0], (Document{{"a", 1}, {"b", 3}}));
+
+    match->getNextBatch(&batch);
+    ASSERT_TRUE(batch.isEOF());
+    ASSERT_TRUE(batch.empty());
+}
+
 TEST_F(DocumentSourceMatchTest, ShouldCorrectlyJoinWithSubsequentMatch) {
     const auto match = DocumentSourceMatch::create(BSON("a" << 1), getExpCtx());
     const auto secondMatch = DocumentSourceMatch::create(BSON("b" << 1), getExpCtx());
@@ -31,6 +31,7 @@
 #include "mongo/db/pipeline/document_source_out.h"
 
 #include "mongo/db/ops/write_ops.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/destructor_guard.h"
 
@@ -41,6 +42,8 @@ using std::vector;
 
 DocumentSourceOut::~DocumentSourceOut() {
     DESTRUCTOR_GUARD(
+        _bulkLoader.reset();
+
         // Make sure we drop the temp collection if anything goes wrong. Errors are ignored
         // here because nothing can be done about them. Additionally, if this fails and the
         // collection is left behind, it will be cleaned up next time the server is started.
@@ -106,6 +109,25 @@ void DocumentSourceOut::initialize() {
     _tempNs = NamespaceString(str::stream() << _outputNs.db() << ".tmp.agg_out."
                                             << aggOutCounter.addAndFetch(1));
 
+    if (internalDocumentSourceOutBulkLoad.load()) {
+        BSONObjBuilder options;
+        options << "temp" << true;
+        options.appendElementsUnique(_originalOutOptions);
+
+        std::vector<BSONObj> indexSpecs;
+        for (auto&& spec : _originalIndexes) {
+            MutableDocument index((Document(spec)));
+            index.remove("_id");  // indexes shouldn't have _ids but some existing ones do
+            index["ns"] = Value(_tempNs.ns());
+            indexSpecs.push_back(index.freeze().toBson());
+        }
+
+        _bulkLoader = _mongoProcessInterface->createCollectionForBulkLoading(
+            _tempNs, options.done(), std::move(indexSpecs));
+        _initialized = true;
+        return;
+    }
+
     // Create output collection, copying options from existing collection if any.
     {
         BSONObjBuilder cmd;
@@ -145,6 +167,11 @@ void DocumentSourceOut::initialize() {
 }
 
 void DocumentSourceOut::spill(const vector<BSONObj>& toInsert) {
+    if (_bulkLoader) {
+        _bulkLoader->insert(toInsert);
+        return;
+    }
+
     BSONObj err = _mongoProcessInterface->insert(_tempNs, toInsert);
     uassert(16996,
             str::stream() << "insert for $out failed: " << err,
@@ -162,7 +189,12 @@ DocumentSource::GetNextResult DocumentSourceOut::getNext() {
         initialize();
     }
 
-    // Insert all documents into temp collection, batching to perform vectored inserts.
+    // Insert all documents into temp collection, batching to perform vectored inserts. A bulk load
+    // doesn't go through the insert command, so it isn't bound by the command's limits.
+    const int maxBatchBytes =
+        _bulkLoader ? internalDocumentSourceOutBulkLoadBatchSizeBytes.load() : BSONObjMaxUserSize;
+    const size_t maxBatchObjects =
+        _bulkLoader ? std::numeric_limits<size_t>::max() : write_ops::kMaxWriteBatchSize;
     vector<BSONObj> bufferedObjects;
     int bufferedBytes = 0;
 
@@ -171,8 +203,8 @@ DocumentSource::GetNextResult DocumentSourceOut::getNext() {
         BSONObj toInsert = nextInput.releaseDocument().toBson();
 
         bufferedBytes += toInsert.objsize();
-        if (!bufferedObjects.empty() && (bufferedBytes > BSONObjMaxUserSize ||
-                                         bufferedObjects.size() >= write_ops::kMaxWriteBatchSize)) {
+        if (!bufferedObjects.empty() &&
+            (bufferedBytes > maxBatchBytes || bufferedObjects.size() >= maxBatchObjects)) {
             spill(bufferedObjects);
             bufferedObjects.clear();
             bufferedBytes = toInsert.objsize();
@@ -190,6 +222,11 @@ DocumentSource::GetNextResult DocumentSourceOut::getNext() {
             return nextInput;  // Propagate the pause.
         }
         case GetNextResult::ReturnStatus::kEOF: {
+            // Finish building the indexes before the temp collection is renamed.
+            if (_bulkLoader) {
+                _bulkLoader->commit();
+                _bulkLoader.reset();
+            }
 
             auto renameCommandObj =
                 BSON("renameCollection" << _tempNs.ns() << "to" << _outputNs.ns() << "dropTarget"
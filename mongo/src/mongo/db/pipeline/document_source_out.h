@@ -86,7 +86,8 @@ private:
      * Sets '_tempNs' to a unique temporary namespace, makes sure the output collection isn't
      * sharded or capped, and saves the collection options and indexes of the target collection.
      * Then creates the temporary collection we will insert into by copying the collection options
-     * and indexes from the target collection.
+     * and indexes from the target collection. When bulk loading, the indexes are instead built
+     * by '_bulkLoader' as documents are inserted.
      *
      * Sets '_initialized' to true upon completion.
      */
@@ -107,6 +108,9 @@ private:
 
     NamespaceString _tempNs;          // output goes here as it is being processed.
     const NamespaceString _outputNs;  // output will go here after all data is processed.
+
+    // Inserts into '_tempNs' and builds its indexes, if bulk loading.
+    std::unique_ptr<MongoProcessInterface::BulkLoader> _bulkLoader;
 };
 
 }  // namespace mongo
@@ -37,6 +37,7 @@
 #include "mongo/bson/json.h"
 #include "mongo/db/pipeline/aggregation_context_fixture.h"
 #include "mongo/db/pipeline/dependencies.h"
+#include "mongo/db/pipeline/document_batch.h"
 #include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/document_source_project.h"
 #include "mongo/db/pipeline/document_value_test_util.h"
@@ -160,6 +161,43 @@ TEST_F(ProjectStageTest, ShouldPropagatePauses) {
     ASSERT(project->getNext().isEOF());
 }
 
+TEST_F(ProjectStageTest, ShouldTransformBatchesAndPropagatePauses) {
+    auto project = DocumentSourceProject::create(BSON("a" << false), getExpCtx());
+    auto source = DocumentSourceMock::create({Document{{"a", 1}, {"b", 1}},
+                                              Document{{"a", 2}, {"b", 2}},
+                                              DocumentSource::GetNextResult::makePauseExecution(),
+                                              Document{{"a", 3}, {"b", 3}},
+                                              DocumentSource::GetNextResult::makePauseExecution(),
+                                              Document{{"a", 4}, {"b", 4}}});
+    project->setSource(source.get());
+
+    DocumentBatch batch(2);
+    project->getNextBatch(&batch);
+    ASSERT_TRUE(batch.getStatus() == DocumentBatch::ReturnStatus::kAdvanced);
+    ASSERT_EQ(batch.size(), 2U);
+    ASSERT_DOCUMENT_EQ(batch[0], (Document{{"b", 1}}));
+    ASSERT_DOCUMENT_EQ(batch[1], (Document{{"b", 2}}));
+
+    // The previous batch ended right before the pause, so this one holds nothing else.
+    project->getNextBatch(&batch);
+    ASSERT_TRUE(batch.isPaused());
+    ASSERT_TRUE(batch.empty());
+
+    project->getNextBatch(&batch);
+    ASSERT_TRUE(batch.isPaused());
+    ASSERT_EQ(batch.size(), 1U);
+    ASSERT_DOCUMENT_EQ(batch[0], (Document{{"b", 3}}));
+
+    // Single results may be interleaved with batches.
+    auto next = project->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(), (Document{{"b", 4}}));
+
+    project->getNextBatch(&batch);
+    ASSERT_TRUE(batch.isEOF());
+    ASSERT_TRUE(batch.empty());
+}
+
 TEST_F(ProjectStageTest, InclusionShouldAddDependenciesOfIncludedAndComputedFields) {
     auto project = DocumentSourceProject::create(
         fromjson("{a: true, x: '$b', y: {$and: ['$c','$d']}, z: {$meta: 'textScore'}}"),
@@ -0,0 +1,178 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/document_source_shared_oplog_cursor.h"
+
+#include "mongo/db/curop.h"
+#include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/repl/oplog_entry.h"
+#include "mongo/db/repl/replication_coordinator.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+
+using boost::intrusive_ptr;
+
+intrusive_ptr<DocumentSourceSharedOplogCursor> DocumentSourceSharedOplogCursor::create(
+    intrusive_ptr<DocumentSourceCursor> cursor,
+    CursorFactory makeCursor,
+    std::unique_ptr<MatchExpression> oplogFilter,
+    const intrusive_ptr<ExpressionContext>& expCtx) {
+    return new DocumentSourceSharedOplogCursor(
+        std::move(cursor), std::move(makeCursor), std::move(oplogFilter), expCtx);
+}
+
+DocumentSourceSharedOplogCursor::DocumentSourceSharedOplogCursor(
+    intrusive_ptr<DocumentSourceCursor> cursor,
+    CursorFactory makeCursor,
+    std::unique_ptr<MatchExpression> oplogFilter,
+    const intrusive_ptr<ExpressionContext>& expCtx)
+    : DocumentSource(expCtx),
+      _cursor(std::move(cursor)),
+      _makeCursor(std::move(makeCursor)),
+      _oplogFilter(std::move(oplogFilter)),
+      _subscriber(std::make_shared<SharedOplogReader::Subscriber>(expCtx->ns)) {}
+
+DocumentSource::GetNextResult DocumentSourceSharedOplogCursor::getNext() {
+    pExpCtx->checkForInterrupt();
+
+    while (true) {
+        if (!_attached) {
+            auto next = getNextFromCursor();
+            if (!next.isEOF() || !_attached) {
+                return next;
+            }
+        }
+
+        auto next = getNextShared();
+        if (!next.isEOF() || _attached) {
+            return next;
+        }
+    }
+}
+
+DocumentSource::GetNextResult DocumentSourceSharedOplogCursor::getNextShared() {
+    auto reader = SharedOplogReader::get(pExpCtx->opCtx);
+    while (true) {
+        BSONObj entry;
+        Timestamp readThrough;
+        switch (reader->next(_subscriber.get(), &entry, &readThrough)) {
+            case SharedOplogReader::NextResult::kEntry: {
+                const Timestamp ts = entry[repl::OplogEntry::kTimestampFieldName].timestamp();
+                if (ts <= _readThrough) {
+                    // Already returned by '_cursor'.
+                    continue;
+                }
+                _readThrough = ts;
+                if (_oplogFilter->matchesBSON(entry)) {
+                    return Document(entry);
+                }
+                continue;
+            }
+            case SharedOplogReader::NextResult::kEmpty: {
+                _readThrough = std::max(_readThrough, readThrough);
+                if (!shouldWaitForEntries()) {
+                    return GetNextResult::makeEOF();
+                }
+
+                auto opCtx = pExpCtx->opCtx;
+                auto curOp = CurOp::get(opCtx);
+                curOp->pauseTimer();
+                ON_BLOCK_EXIT([curOp] { curOp->resumeTimer(); });
+                if (!reader->waitForEntries(opCtx, _subscriber.get(), opCtx->getDeadline())) {
+                    return GetNextResult::makeEOF();
+                }
+                continue;
+            }
+            case SharedOplogReader::NextResult::kDetached: {
+                // The reader detached us, so a cursor of our own has to catch up with it again.
+                // '_cursor' is still positioned where we attached, so rather than resuming it we
+                // start a new one after the last entry we have seen.
+                _readThrough = std::max(_readThrough, readThrough);
+                _attached = false;
+                _cursor->dispose();
+                _cursor = _makeCursor(_readThrough);
+                return GetNextResult::makeEOF();
+            }
+        }
+        MONGO_UNREACHABLE;
+    }
+}
+
+DocumentSource::GetNextResult DocumentSourceSharedOplogCursor::getNextFromCursor() {
+    if (!_subscriber) {
+        // We have been disposed of.
+        return GetNextResult::makeEOF();
+    }
+
+    auto next = _cursor->getNext();
+    if (next.isAdvanced()) {
+        _readThrough = next.getDocument()[repl::OplogEntry::kTimestampFieldName].getTimestamp();
+        return next;
+    }
+
+    // '_cursor' has read as much of the oplog as it can see, so we can attach to the reader unless
+    // its scan is further ahead.
+    _readThrough = std::max(_readThrough, _cursor->getLatestOplogTimestamp());
+    if (internalChangeStreamUseSharedOplogReader.load() && !_readThrough.isNull()) {
+        _attached = SharedOplogReader::get(pExpCtx->opCtx)->attach(_subscriber, _readThrough);
+    }
+    return GetNextResult::makeEOF();
+}
+
+bool DocumentSourceSharedOplogCursor::shouldWaitForEntries() const {
+    auto opCtx = pExpCtx->opCtx;
+    if (!shouldWaitForInserts(opCtx) || pExpCtx->readingAhead ||
+        !opCtx->checkForInterruptNoAssert().isOK() ||
+        opCtx->getRemainingMaxTimeMicros() <= Microseconds::zero()) {
+        return false;
+    }
+
+    // For operations with a last committed opTime, we should not wait if the replication
+    // coordinator's lastCommittedOpTime has changed.
+    if (!clientsLastKnownCommittedOpTime(opCtx).isNull()) {
+        auto replCoord = repl::ReplicationCoordinator::get(opCtx);
+        return clientsLastKnownCommittedOpTime(opCtx) == replCoord->getLastCommittedOpTime();
+    }
+    return true;
+}
+
+void DocumentSourceSharedOplogCursor::doDispose() {
+    if (_subscriber) {
+        SharedOplogReader::get(pExpCtx->opCtx)->detach(_subscriber);
+        _subscriber.reset();
+        _attached = false;
+    }
+    _cursor->dispose();
+}
+
+}  // namespace mongo
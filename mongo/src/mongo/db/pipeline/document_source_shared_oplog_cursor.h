@@ -0,0 +1,145 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/pipeline/document_source.h"
+#include "mongo/db/pipeline/document_source_cursor.h"
+#include "mongo/db/pipeline/shared_oplog_reader.h"
+#include "mongo/stdx/functional.h"
+
+namespace mongo {
+
+/**
+ * Produces the oplog entries matching a change stream's oplog filter, reading them through the
+ * SharedOplogReader whenever possible.
+ *
+ * The entries are first read from a DocumentSourceCursor over the oplog, as for any other change
+ * stream. Once that cursor has caught up with the shared scan, the stage attaches to the reader
+ * and filters the entries the reader hands it instead. Should the reader detach it, the stage
+ * replaces its cursor with one reading the oplog entries after the last one it has seen, and reads
+ * from that cursor until it can attach again.
+ */
+class DocumentSourceSharedOplogCursor final : public DocumentSource {
+public:
+    /**
+     * Returns a new cursor over the oplog entries matching the oplog filter whose timestamps are
+     * greater than 'readThrough'.
+     */
+    using CursorFactory =
+        stdx::function<boost::intrusive_ptr<DocumentSourceCursor>(Timestamp readThrough)>;
+
+    static boost::intrusive_ptr<DocumentSourceSharedOplogCursor> create(
+        boost::intrusive_ptr<DocumentSourceCursor> cursor,
+        CursorFactory makeCursor,
+        std::unique_ptr<MatchExpression> oplogFilter,
+        const boost::intrusive_ptr<ExpressionContext>& expCtx);
+
+    GetNextResult getNext() final;
+
+    const char* getSourceName() const final {
+        return _cursor->getSourceName();
+    }
+
+    Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final {
+        return _cursor->serialize(explain);
+    }
+
+    StageConstraints constraints(Pipeline::SplitState pipeState) const final {
+        return _cursor->constraints(pipeState);
+    }
+
+    void detachFromOperationContext() final {
+        _cursor->detachFromOperationContext();
+    }
+
+    void reattachToOperationContext(OperationContext* opCtx) final {
+        _cursor->reattachToOperationContext(opCtx);
+    }
+
+    /**
+     * Returns the timestamp of the last oplog entry this stage has read or skipped.
+     */
+    Timestamp getLatestOplogTimestamp() const {
+        return _readThrough;
+    }
+
+    const DocumentSourceCursor* getCursor() const {
+        return _cursor.get();
+    }
+
+protected:
+    void doDispose() final;
+
+private:
+    DocumentSourceSharedOplogCursor(boost::intrusive_ptr<DocumentSourceCursor> cursor,
+                                    CursorFactory makeCursor,
+                                    std::unique_ptr<MatchExpression> oplogFilter,
+                                    const boost::intrusive_ptr<ExpressionContext>& expCtx);
+
+    /**
+     * Returns the next entry handed out by the reader which passes the oplog filter, or EOF once
+     * none is buffered. If the reader has detached '_subscriber', replaces '_cursor' with a cursor
+     * reading on from '_readThrough'.
+     */
+    GetNextResult getNextShared();
+
+    /**
+     * Returns the next entry from '_cursor'. Once '_cursor' is exhausted, attempts to attach to the
+     * reader.
+     */
+    GetNextResult getNextFromCursor();
+
+    /**
+     * Returns true if this getMore should wait for the reader to buffer more entries, as an
+     * awaitData cursor waits for inserts into the oplog.
+     */
+    bool shouldWaitForEntries() const;
+
+    boost::intrusive_ptr<DocumentSourceCursor> _cursor;
+
+    // Builds the cursor which replaces '_cursor' once the reader detaches us. '_cursor' itself is
+    // parked where we attached, which may since have rolled off the oplog.
+    CursorFactory _makeCursor;
+
+    // The oplog filter, evaluated with the simple collation, for the entries handed out by the
+    // reader.
+    std::unique_ptr<MatchExpression> _oplogFilter;
+
+    std::shared_ptr<SharedOplogReader::Subscriber> _subscriber;
+    bool _attached = false;
+
+    // Every oplog entry up to this timestamp has been either returned or skipped.
+    Timestamp _readThrough;
+};
+
+}  // namespace mongo
@@ -33,6 +33,7 @@
 #include <boost/smart_ptr/intrusive_ptr.hpp>
 
 #include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/document_batch.h"
 #include "mongo/db/pipeline/document_source_limit.h"
 #include "mongo/db/pipeline/document_source_skip.h"
 #include "mongo/db/pipeline/expression.h"
@@ -67,6 +68,17 @@ DocumentSource::GetNextResult DocumentSourceSingleDocumentTransformation::getNex
     return _parsedTransform->applyTransformation(input.releaseDocument());
 }
 
+void DocumentSourceSingleDocumentTransformation::getNextBatch(DocumentBatch* batch) {
+    pExpCtx->checkForInterrupt();
+
+    // Transform our child's batch in place. Each input document is released as it is replaced, so
+    // that it is not shared with the output.
+    pSource->getNextBatch(batch);
+    for (auto&& doc : *batch) {
+        doc = _parsedTransform->applyTransformation(std::move(doc));
+    }
+}
+
 intrusive_ptr<DocumentSource> DocumentSourceSingleDocumentTransformation::optimize() {
     _parsedTransform->optimize();
     return this;
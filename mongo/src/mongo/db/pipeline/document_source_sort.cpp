@@ -32,12 +32,14 @@
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/document_batch.h"
 #include "mongo/db/pipeline/document_path_support.h"
 #include "mongo/db/pipeline/document_source_merge_cursors.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/query/query_knobs.h"
 
 namespace mongo {
 
@@ -324,14 +326,19 @@ DocumentSource::GetNextResult DocumentSourceSort::populate() {
         }
         return DocumentSource::GetNextResult::makeEOF();
     } else {
-        auto nextInput = pSource->getNext();
-        for (; nextInput.isAdvanced(); nextInput = pSource->getNext()) {
-            loadDocument(nextInput.releaseDocument());
-        }
-        if (nextInput.isEOF()) {
-            loadingDone();
+        DocumentBatch batch(internalDocumentSourceBatchSize.load());
+        do {
+            pSource->getNextBatch(&batch);
+            for (auto&& doc : batch) {
+                loadDocument(std::move(doc));
+            }
+        } while (batch.getStatus() == DocumentBatch::ReturnStatus::kAdvanced);
+
+        if (batch.isPaused()) {
+            return DocumentSource::GetNextResult::makePauseExecution();
         }
-        return nextInput;
+        loadingDone();
+        return DocumentSource::GetNextResult::makeEOF();
     }
 }
 
@@ -44,8 +44,10 @@
 #include "mongo/db/pipeline/document_source_sort.h"
 #include "mongo/db/pipeline/document_value_test_util.h"
 #include "mongo/db/pipeline/pipeline.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -396,6 +398,33 @@ TEST_F(DocumentSourceSortExecutionTest, ShouldResumePopulationBetweenPauses) {
     ASSERT_TRUE(sort->getNext().isEOF());
 }
 
+TEST_F(DocumentSourceSortExecutionTest, ShouldLoadInBatchesAndPauseOnBatchBoundaries) {
+    const int oldBatchSize = internalDocumentSourceBatchSize.load();
+    internalDocumentSourceBatchSize.store(2);
+    ON_BLOCK_EXIT([oldBatchSize] { internalDocumentSourceBatchSize.store(oldBatchSize); });
+
+    auto sort = DocumentSourceSort::create(getExpCtx(), BSON("a" << 1));
+    auto mock = DocumentSourceMock::create({Document{{"a", 4}},
+                                            Document{{"a", 2}},
+                                            DocumentSource::GetNextResult::makePauseExecution(),
+                                            Document{{"a", 5}},
+                                            Document{{"a", 1}},
+                                            Document{{"a", 3}},
+                                            DocumentSource::GetNextResult::makePauseExecution()});
+    sort->setSource(mock.get());
+
+    // The first pause falls right after a full batch, and the second within a batch.
+    ASSERT_TRUE(sort->getNext().isPaused());
+    ASSERT_TRUE(sort->getNext().isPaused());
+
+    for (int i = 1; i <= 5; ++i) {
+        auto next = sort->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_DOCUMENT_EQ(next.releaseDocument(), (Document{{"a", i}}));
+    }
+    ASSERT_TRUE(sort->getNext().isEOF());
+}
+
 TEST_F(DocumentSourceSortExecutionTest, ShouldBeAbleToPauseLoadingWhileSpilled) {
     auto expCtx = getExpCtx();
 
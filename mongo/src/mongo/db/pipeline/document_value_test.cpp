@@ -34,6 +34,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
 #include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/document_arena.h"
 #include "mongo/db/pipeline/document_comparator.h"
 #include "mongo/db/pipeline/document_value_test_util.h"
 #include "mongo/db/pipeline/field_path.h"
@@ -113,6 +114,88 @@ TEST(DocumentConstruction, FromEmptyDocumentClone) {
     ASSERT_DOCUMENT_EQ(document, documentClone);
 }
 
+TEST(DocumentArena, FreedBuffersAreReusedByLaterDocuments) {
+    boost::intrusive_ptr<mongo::DocumentArena> arena(new mongo::DocumentArena(true));
+    mongo::DocumentArena::Scope arenaScope(arena.get());
+
+    {
+        Document document{{"a", 1}, {"b", "q"_sd}};
+        ASSERT_GT(arena->bytesInUse(), 0U);
+    }
+    ASSERT_EQ(0U, arena->bytesInUse());
+    const size_t cachedBytes = arena->bytesCached();
+    ASSERT_GT(cachedBytes, 0U);
+
+    // Building the same document again should be satisfied entirely from the free lists.
+    Document document{{"a", 1}, {"b", "q"_sd}};
+    ASSERT_GT(arena->bytesInUse(), 0U);
+    ASSERT_EQ(cachedBytes, arena->bytesInUse() + arena->bytesCached());
+}
+
+TEST(DocumentArena, DocumentsKeepTheirArenaAlive) {
+    for (bool singleThreaded : {false, true}) {
+        Document document;
+        {
+            boost::intrusive_ptr<mongo::DocumentArena> arena(
+                new mongo::DocumentArena(singleThreaded));
+            mongo::DocumentArena::Scope arenaScope(arena.get());
+            document = Document{{"a", 1}, {"b", Document{{"c", 2}}}};
+        }
+        ASSERT_FALSE(mongo::DocumentArena::current());
+        ASSERT_DOCUMENT_EQ(document, (Document{{"a", 1}, {"b", Document{{"c", 2}}}}));
+
+        // Modifying the document copies it to the global heap since no arena is installed anymore.
+        MutableDocument md(document);
+        for (int i = 0; i < 100; ++i) {
+            md.addField(std::to_string(i), mongo::Value(i));
+        }
+        ASSERT_EQ(102U, md.freeze().size());
+    }
+}
+
+TEST(DocumentArena, ScopesRestoreThePreviousArena) {
+    boost::intrusive_ptr<mongo::DocumentArena> outer(new mongo::DocumentArena(false));
+    boost::intrusive_ptr<mongo::DocumentArena> inner(new mongo::DocumentArena(true));
+    mongo::DocumentArena::Scope outerScope(outer.get());
+    {
+        mongo::DocumentArena::Scope innerScope(inner.get());
+        ASSERT_EQ(inner.get(), mongo::DocumentArena::current());
+        {
+            mongo::DocumentArena::Scope noArenaScope(nullptr);
+            ASSERT_FALSE(mongo::DocumentArena::current());
+        }
+        ASSERT_EQ(inner.get(), mongo::DocumentArena::current());
+    }
+    ASSERT_EQ(outer.get(), mongo::DocumentArena::current());
+}
+
+TEST(DocumentArena, SingleThreadedArenaDocumentsAreCopiedOnWrite) {
+    boost::intrusive_ptr<mongo::DocumentArena> arena(new mongo::DocumentArena(true));
+    mongo::DocumentArena::Scope arenaScope(arena.get());
+
+    Document original{{"a", 1}, {"b", Document{{"c", 2}}}};
+    {
+        // The plain reference counts must still see the copy, so that writing clones the storage.
+        Document copy = original;
+        MutableDocument md(copy);
+        md.setField("a", mongo::Value(3));
+        ASSERT_DOCUMENT_EQ(md.freeze(), (Document{{"a", 3}, {"b", Document{{"c", 2}}}}));
+    }
+    ASSERT_DOCUMENT_EQ(original, (Document{{"a", 1}, {"b", Document{{"c", 2}}}}));
+
+    original = Document();
+    ASSERT_EQ(0U, arena->bytesInUse());
+}
+
+TEST(DocumentArena, ApproximateSizeCountsWholeArenaBlocks) {
+    boost::intrusive_ptr<mongo::DocumentArena> arena(new mongo::DocumentArena(true));
+    mongo::DocumentArena::Scope arenaScope(arena.get());
+
+    Document document{{"a", 1}};
+    ASSERT_GT(arena->bytesInUse(), 0U);
+    ASSERT_EQ(sizeof(mongo::DocumentStorage) + arena->bytesInUse(), document.getApproximateSize());
+}
+
 /**
  * Appends to 'builder' an object nested 'depth' levels deep.
  */
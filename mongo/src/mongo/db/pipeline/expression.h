@@ -47,6 +47,7 @@
 #include "mongo/stdx/functional.h"
 #include "mongo/util/intrusive_counter.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/summation.h"
 
 namespace mongo {
 
@@ -645,6 +646,32 @@ public:
 
 class ExpressionAdd final : public ExpressionVariadic<ExpressionAdd> {
 public:
+    /**
+     * Adds up the operands of an $add one at a time. Shared by evaluate() and CompiledExpression
+     * so that both produce the same result type, rounding and errors.
+     */
+    class Sum {
+    public:
+        /**
+         * Adds 'val' to the sum. Returns false without changing the sum if 'val' is nullish, in
+         * which case the result of the $add is null. Throws if 'val' is neither numeric nor a date,
+         * or if it is the second date.
+         */
+        bool add(const Value& val);
+
+        Value getValue() const;
+
+    private:
+        // We'll try to return the narrowest possible result value while avoiding overflow, loss
+        // of precision due to intermediate rounding or implicit use of decimal types. To do that,
+        // compute a compensated sum for non-decimal values and a separate decimal sum for decimal
+        // values, and track the current narrowest type.
+        DoubleDoubleSummation _nonDecimalTotal;
+        Decimal128 _decimalTotal;
+        BSONType _totalType = NumberInt;
+        bool _haveDate = false;
+    };
+
     explicit ExpressionAdd(const boost::intrusive_ptr<ExpressionContext>& expCtx)
         : ExpressionVariadic<ExpressionAdd>(expCtx) {}
 
@@ -758,6 +785,10 @@ public:
         const boost::intrusive_ptr<ExpressionContext>& expCtx,
         const boost::intrusive_ptr<Expression>& pExpression);
 
+    const boost::intrusive_ptr<Expression>& getExpression() const {
+        return pExpression;
+    }
+
 protected:
     void _doAddDependencies(DepsTracker* deps) const final;
 
@@ -791,6 +822,12 @@ public:
     Value evaluate(const Document& root) const final;
     const char* getOpName() const final;
 
+    /**
+     * Compares the already evaluated operands 'lhs' and 'rhs' using this expression's operator and
+     * collation.
+     */
+    Value apply(const Value& lhs, const Value& rhs) const;
+
     CmpOp getOp() const {
         return cmpOp;
     }
@@ -1027,6 +1064,11 @@ public:
 
     Value evaluate(const Document& root) const final;
     const char* getOpName() const final;
+
+    /**
+     * Divides the already evaluated operand 'lhs' by 'rhs'.
+     */
+    static Value apply(const Value& lhs, const Value& rhs);
 };
 
 
@@ -1366,6 +1408,31 @@ public:
 
 class ExpressionMultiply final : public ExpressionVariadic<ExpressionMultiply> {
 public:
+    /**
+     * Multiplies the operands of a $multiply one at a time. Shared by evaluate() and
+     * CompiledExpression so that both produce the same result type, rounding and errors.
+     */
+    class Product {
+    public:
+        /**
+         * Multiplies the product by 'val'. Returns false without changing the product if 'val' is
+         * nullish, in which case the result of the $multiply is null. Throws if 'val' is not
+         * numeric.
+         */
+        bool multiply(const Value& val);
+
+        Value getValue() const;
+
+    private:
+        // We'll try to return the narrowest possible result value. To do that without creating
+        // intermediate Values, do the arithmetic for double and integral types in parallel,
+        // tracking the current narrowest type.
+        double _doubleProduct = 1;
+        long long _longProduct = 1;
+        Decimal128 _decimalProduct;  // This will be initialized on encountering the first decimal.
+        BSONType _productType = NumberInt;
+    };
+
     explicit ExpressionMultiply(const boost::intrusive_ptr<ExpressionContext>& expCtx)
         : ExpressionVariadic<ExpressionMultiply>(expCtx) {}
 
@@ -1722,6 +1789,11 @@ public:
 
     Value evaluate(const Document& root) const final;
     const char* getOpName() const final;
+
+    /**
+     * Subtracts the already evaluated operand 'rhs' from 'lhs'.
+     */
+    static Value apply(const Value& lhs, const Value& rhs);
 };
 
 
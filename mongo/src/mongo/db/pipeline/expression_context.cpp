@@ -31,11 +31,41 @@
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/query/collation/collation_spec.h"
 #include "mongo/db/query/collation/collator_factory_interface.h"
+#include "mongo/db/query/query_knobs.h"
 
 namespace mongo {
 
 using boost::intrusive_ptr;
 
+namespace {
+
+/**
+ * Returns true if 'spec' has a $facet stage at any depth. $facet is the only stage which may hand
+ * Documents to other threads.
+ */
+bool containsFacetStage(const BSONObj& spec) {
+    for (auto&& elem : spec) {
+        if (elem.fieldNameStringData() == "$facet") {
+            return true;
+        }
+        if (elem.isABSONObj() && containsFacetStage(elem.Obj())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool containsFacetStage(const std::vector<BSONObj>& pipeline) {
+    for (auto&& stage : pipeline) {
+        if (containsFacetStage(stage)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
 ExpressionContext::ResolvedNamespace::ResolvedNamespace(NamespaceString ns,
                                                         std::vector<BSONObj> pipeline)
     : ns(std::move(ns)), pipeline(std::move(pipeline)) {}
@@ -56,6 +86,16 @@ ExpressionContext::ExpressionContext(OperationContext* opCtx,
     collation = request.getCollation();
     _ownedCollator = std::move(collator);
     _resolvedNamespaces = std::move(resolvedNamespaces);
+
+    if (internalQueryUseDocumentArena.load()) {
+        // Without a $facet in the pipeline or in any view it reads, its Documents stay on this
+        // operation's thread and need neither a locked arena nor atomic reference counts.
+        bool singleThreaded = !containsFacetStage(request.getPipeline());
+        for (auto&& resolvedNs : _resolvedNamespaces) {
+            singleThreaded = singleThreaded && !containsFacetStage(resolvedNs.second.pipeline);
+        }
+        documentArena = new DocumentArena(singleThreaded);
+    }
 }
 ExpressionContext::ExpressionContext(OperationContext* opCtx, const CollatorInterface* collator)
     : opCtx(opCtx),
@@ -70,8 +110,13 @@ ExpressionContext::ExpressionContext(OperationContext* opCtx, const CollatorInte
 void ExpressionContext::checkForInterrupt() {
     // This check could be expensive, at least in relative terms, so don't check every time.
     if (--_interruptCounter == 0) {
-        invariant(opCtx);
         _interruptCounter = kInterruptCheckPeriod;
+
+        // The sub-pipelines of a $facet are detached while worker threads drain them, and the
+        // operation's own thread checks for interrupts on their behalf.
+        if (!opCtx) {
+            return;
+        }
         auto interruptStatus = opCtx->checkForInterruptNoAssert();
         if (interruptStatus == ErrorCodes::ExceededTimeLimit && isTailableAwaitData()) {
             // Don't respect deadline expiration during the pipeline when the cursor is
@@ -140,6 +185,7 @@ intrusive_ptr<ExpressionContext> ExpressionContext::copyWith(
     expCtx->allowDiskUse = allowDiskUse;
     expCtx->bypassDocumentValidation = bypassDocumentValidation;
     expCtx->subPipelineDepth = subPipelineDepth;
+    expCtx->documentArena = documentArena;
 
     expCtx->tempDir = tempDir;
 
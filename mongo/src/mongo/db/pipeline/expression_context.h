@@ -38,6 +38,7 @@
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/pipeline/aggregation_request.h"
+#include "mongo/db/pipeline/document_arena.h"
 #include "mongo/db/pipeline/document_comparator.h"
 #include "mongo/db/pipeline/value_comparator.h"
 #include "mongo/db/pipeline/variables.h"
@@ -111,7 +112,8 @@ public:
 
     /**
      * Used by a pipeline to check for interrupts so that killOp() works. Throws a UserAssertion if
-     * this aggregation pipeline has been interrupted.
+     * this aggregation pipeline has been interrupted. Does nothing while detached from the
+     * OperationContext.
      */
     void checkForInterrupt();
 
@@ -198,9 +200,18 @@ public:
 
     TailableMode tailableMode = TailableMode::kNormal;
 
+    // Set by a stage while it reads ahead of the results it has already produced. Tailable,
+    // awaitData sources return EOF rather than wait for new results while this is true, since the
+    // results read so far are ready to be returned.
+    bool readingAhead = false;
+
     // Tracks the depth of nested aggregation sub-pipelines. Used to enforce depth limits.
     size_t subPipelineDepth = 0;
 
+    // Pool for the buffers of Documents built while executing this pipeline, shared with the
+    // contexts of its sub-pipelines. Null if Documents should allocate from the global heap.
+    boost::intrusive_ptr<DocumentArena> documentArena;
+
 protected:
     static const int kInterruptCheckPeriod = 128;
 
@@ -32,6 +32,8 @@
 
 #include <algorithm>
 
+#include "mongo/db/query/query_knobs.h"
+
 namespace mongo {
 
 namespace parsed_aggregation_projection {
@@ -49,6 +51,16 @@ void InclusionNode::optimize() {
     for (auto&& expressionIt : _expressions) {
         _expressions[expressionIt.first] = expressionIt.second->optimize();
     }
+
+    _compiledExpressions.clear();
+    if (internalQueryCompileAggregationExpressions.load()) {
+        for (auto&& expressionIt : _expressions) {
+            if (auto compiled = CompiledExpression::compile(expressionIt.second)) {
+                _compiledExpressions[expressionIt.first] = std::move(compiled);
+            }
+        }
+    }
+
     for (auto&& childPair : _children) {
         childPair.second->optimize();
     }
@@ -148,6 +160,12 @@ void InclusionNode::addComputedFields(MutableDocument* outputDoc, const Document
             outputDoc->setField(field,
                                 childIt->second->addComputedFields(outputDoc->peek()[field], root));
         } else {
+            auto compiledIt = _compiledExpressions.find(field);
+            if (compiledIt != _compiledExpressions.end()) {
+                outputDoc->setField(field, compiledIt->second->evaluate(root));
+                continue;
+            }
+
             auto expressionIt = _expressions.find(field);
             invariant(expressionIt != _expressions.end());
             outputDoc->setField(field, expressionIt->second->evaluate(root));
@@ -30,6 +30,7 @@
 
 #include <memory>
 
+#include "mongo/db/pipeline/compiled_expression.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/parsed_aggregation_projection.h"
@@ -55,7 +56,8 @@ public:
     InclusionNode(std::string pathToNode = "");
 
     /**
-     * Optimize any computed expressions.
+     * Optimize any computed expressions, then compile them if
+     * 'internalQueryCompileAggregationExpressions' is enabled.
      */
     void optimize();
 
@@ -169,6 +171,11 @@ private:
     std::vector<std::string> _orderToProcessAdditionsAndChildren;
 
     StringMap<boost::intrusive_ptr<Expression>> _expressions;
+
+    // Compiled forms of the entries in '_expressions', filled in by optimize(). Expressions which
+    // gain nothing from compilation are left out and evaluated directly.
+    stdx::unordered_map<std::string, std::unique_ptr<CompiledExpression>> _compiledExpressions;
+
     stdx::unordered_set<std::string> _inclusions;
 
     // TODO use StringMap once SERVER-23700 is resolved.
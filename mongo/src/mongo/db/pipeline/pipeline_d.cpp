@@ -36,12 +36,16 @@
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/collection_catalog_entry.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/catalog/document_validation.h"
 #include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/catalog/collection_options.h"
+#include "mongo/db/catalog/index_create.h"
 #include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/exec/fetch.h"
@@ -50,26 +54,37 @@
 #include "mongo/db/exec/shard_filter.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/matcher/extensions_callback_real.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/op_observer.h"
+#include "mongo/db/ops/insert.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_change_stream.h"
 #include "mongo/db/pipeline/document_source_cursor.h"
+#include "mongo/db/pipeline/document_source_group.h"
 #include "mongo/db/pipeline/document_source_match.h"
 #include "mongo/db/pipeline/document_source_merge_cursors.h"
 #include "mongo/db/pipeline/document_source_sample.h"
 #include "mongo/db/pipeline/document_source_sample_from_random_cursor.h"
+#include "mongo/db/pipeline/document_source_shared_oplog_cursor.h"
 #include "mongo/db/pipeline/document_source_single_document_transformation.h"
 #include "mongo/db/pipeline/document_source_sort.h"
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/query/collation/collator_interface.h"
 #include "mongo/db/query/get_executor.h"
+#include "mongo/db/query/parsed_distinct.h"
 #include "mongo/db/query/plan_summary_stats.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/s/collection_metadata.h"
 #include "mongo/db/s/collection_sharding_state.h"
 #include "mongo/db/s/metadata_manager.h"
 #include "mongo/db/s/sharding_state.h"
+#include "mongo/db/server_options.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/stats/fill_locker_info.h"
 #include "mongo/db/stats/storage_stats.h"
@@ -85,6 +100,7 @@
 #include "mongo/util/log.h"
 #include "mongo/util/net/sock.h"
 #include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -95,6 +111,267 @@ using std::unique_ptr;
 
 namespace {
 
+/**
+ * Inserts into a new collection without maintaining any of its indexes, handing each document's
+ * keys to a bulk builder per index instead. The indexes, including _id unless the collection
+ * options disable it, are created and replicated while the collection is still empty, so that
+ * secondaries maintain them as they apply the inserts. On the primary they stay empty until
+ * commit() builds them bottom-up from the sorted keys. This avoids both maintaining every index
+ * on every insert and scanning the collection again to build the indexes afterwards.
+ *
+ * Until then the collection is marked as having incomplete indexes, so that queries and validate
+ * refuse to read it. The mark is kept in the collection's catalog entry as well as in memory, so
+ * that it survives a restart in the middle of the load. A load that fails leaves the mark in place
+ * until the collection is dropped, which for the temporary $out collection happens at the latest
+ * when temporary collections are cleared at startup or on stepUp.
+ *
+ * No locks are held between calls and nothing keeps the collection from being dropped, for
+ * example by dropDatabase, in the meantime. Every call therefore first checks that the collection
+ * and its indexes are still the ones the loader created, and fails the load otherwise.
+ */
+class MongodBulkLoader final
+    : public DocumentSourceNeedsMongoProcessInterface::MongoProcessInterface::BulkLoader {
+public:
+    MongodBulkLoader(const intrusive_ptr<ExpressionContext>& ctx,
+                     const NamespaceString& nss,
+                     const BSONObj& collectionOptions,
+                     std::vector<BSONObj> indexSpecs)
+        : _ctx(ctx), _opCtx(ctx->opCtx), _nss(nss) {
+        AutoGetOrCreateDb autoDb(_opCtx, _nss.db(), MODE_X);
+        assertCanAcceptWrites();
+
+        writeConflictRetry(_opCtx, "$out bulk load", _nss.ns(), [&] {
+            WriteUnitOfWork wunit(_opCtx);
+            uassertStatusOK(userCreateNS(_opCtx,
+                                         autoDb.getDb(),
+                                         _nss.ns(),
+                                         collectionOptions,
+                                         CollectionOptions::parseForCommand,
+                                         false /* createDefaultIndexes */));
+            wunit.commit();
+        });
+        _collection = autoDb.getDb()->getCollection(_opCtx, _nss);
+        invariant(_collection);
+        _uuid = _collection->uuid();
+
+        // Add the _id index under the same conditions as creating the collection with its default
+        // indexes would.
+        CollectionOptions options;
+        uassertStatusOK(options.parse(collectionOptions, CollectionOptions::parseForCommand));
+        if (_collection->requiresIdIndex() && options.autoIndexId != CollectionOptions::NO &&
+            std::none_of(indexSpecs.begin(), indexSpecs.end(), [](const BSONObj& spec) {
+                return IndexDescriptor::isIdIndexPattern(spec["key"].Obj());
+            })) {
+            indexSpecs.push_back(_collection->getIndexCatalog()->getDefaultIdIndexSpec(
+                serverGlobalParams.featureCompatibility.getVersion()));
+        }
+
+        // Create the indexes on the empty collection and log them before any of its documents,
+        // the same way the createIndexes command does.
+        MultiIndexBlock indexer(_opCtx, _collection);
+        const auto specs = writeConflictRetry(_opCtx, "$out bulk load", _nss.ns(), [&] {
+            return uassertStatusOK(indexer.init(indexSpecs));
+        });
+        uassertStatusOK(indexer.doneInserting());
+        writeConflictRetry(_opCtx, "$out bulk load", _nss.ns(), [&] {
+            WriteUnitOfWork wunit(_opCtx);
+            indexer.commit();
+            for (auto&& infoObj : specs) {
+                getGlobalServiceContext()->getOpObserver()->onCreateIndex(
+                    _opCtx, _nss, _uuid, infoObj, false);
+            }
+
+            // Mark the collection in the same unit of work that makes the indexes ready, so that
+            // no restart can find them ready without the mark. The secondaries maintain their
+            // indexes as they apply the inserts, so the mark is not replicated.
+            _collection->getCatalogEntry()->setIndexesIncomplete(_opCtx, true);
+            wunit.commit();
+        });
+
+        IndexCatalog* indexCatalog = _collection->getIndexCatalog();
+        const size_t maxMemoryUsageBytes = specs.empty()
+            ? 0
+            : static_cast<size_t>(maxIndexBuildMemoryUsageMegabytes.load()) * 1024 * 1024 /
+                specs.size();
+        for (auto&& infoObj : specs) {
+            IndexToLoad index;
+            index.name = infoObj["name"].str();
+            index.descriptor = indexCatalog->findIndexByName(_opCtx, index.name);
+            invariant(index.descriptor);
+            index.filterExpression =
+                indexCatalog->getEntry(index.descriptor)->getFilterExpression();
+            IndexCatalog::prepareInsertDeleteOptions(_opCtx, index.descriptor, &index.options);
+            index.bulk =
+                indexCatalog->getIndex(index.descriptor)->initiateBulk(maxMemoryUsageBytes);
+            _indexes.push_back(std::move(index));
+        }
+        _collection->infoCache()->setIndexesIncomplete(true);
+
+        setCurOpMessage(str::stream() << "$out: inserting into " << _nss.ns());
+    }
+
+    void insert(const std::vector<BSONObj>& objs) final {
+        invariant(_ctx->opCtx == _opCtx);
+        boost::optional<DisableDocumentValidation> maybeDisableValidation;
+        if (_ctx->bypassDocumentValidation)
+            maybeDisableValidation.emplace(_opCtx);
+
+        AutoGetCollection autoColl(_opCtx, _nss, MODE_IX);
+        assertCanAcceptWrites();
+        assertCollectionUnchanged(autoColl.getCollection());
+
+        // Commit in batches no larger than those of the insert command, so that no storage
+        // transaction holds more than that in the cache.
+        auto batchBegin = objs.begin();
+        while (batchBegin != objs.end()) {
+            // A batch takes at least one document, however large.
+            auto batchEnd = batchBegin + 1;
+            int64_t batchBytes = batchBegin->objsize();
+            while (batchEnd != objs.end() &&
+                   batchEnd - batchBegin < internalInsertMaxBatchSize.load() &&
+                   batchBytes + batchEnd->objsize() <= insertVectorMaxBytes) {
+                batchBytes += batchEnd->objsize();
+                ++batchEnd;
+            }
+            insertBatch(batchBegin, batchEnd);
+            batchBegin = batchEnd;
+        }
+
+        _numInserted += objs.size();
+        setCurOpMessage(str::stream() << "$out: inserting into " << _nss.ns() << ", "
+                                      << _numInserted
+                                      << " documents inserted");
+    }
+
+    void commit() final {
+        invariant(_ctx->opCtx == _opCtx);
+        setCurOpMessage(str::stream() << "$out: building " << _indexes.size() << " indexes on "
+                                      << _nss.ns());
+
+        // Writing out the indexes only needs the collection itself.
+        AutoGetCollection autoColl(_opCtx, _nss, MODE_IX, MODE_X);
+        assertCanAcceptWrites();
+        assertCollectionUnchanged(autoColl.getCollection());
+
+        IndexCatalog* indexCatalog = _collection->getIndexCatalog();
+        for (auto&& index : _indexes) {
+            uassertStatusOK(indexCatalog->getIndex(index.descriptor)
+                                ->commitBulk(_opCtx,
+                                             std::move(index.bulk),
+                                             true /* mayInterrupt */,
+                                             index.options.dupsAllowed,
+                                             nullptr));
+        }
+        _indexes.clear();
+
+        writeConflictRetry(_opCtx, "$out bulk load", _nss.ns(), [&] {
+            WriteUnitOfWork wunit(_opCtx);
+            _collection->getCatalogEntry()->setIndexesIncomplete(_opCtx, false);
+            wunit.commit();
+        });
+        _collection->infoCache()->setIndexesIncomplete(false);
+    }
+
+private:
+    struct IndexToLoad {
+        std::string name;
+        const IndexDescriptor* descriptor = nullptr;
+        const MatchExpression* filterExpression = nullptr;
+        InsertDeleteOptions options;
+        std::unique_ptr<IndexAccessMethod::BulkBuilder> bulk;
+    };
+
+    /**
+     * Inserts the documents in ['begin', 'end') in one unit of work, retrying it on write
+     * conflicts, and hands their keys to the bulk builders once it has committed. Keys handed to
+     * the bulk builders can't be taken back, so they must not see an insert which rolls back.
+     */
+    void insertBatch(std::vector<BSONObj>::const_iterator begin,
+                     std::vector<BSONObj>::const_iterator end) {
+        std::vector<std::pair<BSONObj, RecordId>> inserted;
+        writeConflictRetry(_opCtx, "$out bulk load", _nss.ns(), [&] {
+            inserted.clear();
+            WriteUnitOfWork wunit(_opCtx);
+            for (auto it = begin; it != end; ++it) {
+                auto fixed =
+                    uassertStatusOK(fixDocumentForInsert(_opCtx->getServiceContext(), *it));
+                const BSONObj doc = fixed.isEmpty() ? *it : fixed;
+                uassertStatusOK(_collection->insertDocumentForBulkLoader(
+                    _opCtx,
+                    doc,
+                    [&](const RecordId& loc) {
+                        inserted.emplace_back(doc, loc);
+                        return Status::OK();
+                    },
+                    false /* enforceQuota */));
+            }
+            wunit.commit();
+        });
+
+        for (auto&& docAndLoc : inserted) {
+            uassertStatusOK(addKeys(docAndLoc.first, docAndLoc.second));
+        }
+    }
+
+    void assertCanAcceptWrites() {
+        uassert(ErrorCodes::NotMaster,
+                str::stream() << "Not primary while writing to " << _nss.ns(),
+                repl::ReplicationCoordinator::get(_opCtx)->canAcceptWritesFor(_opCtx, _nss));
+    }
+
+    /**
+     * Throws unless 'collection' is the collection the loader created, with exactly the indexes
+     * it created. The pointers the loader keeps into the collection are only valid if so.
+     */
+    void assertCollectionUnchanged(Collection* collection) {
+        uassert(ErrorCodes::NamespaceNotFound,
+                str::stream() << "collection " << _nss.ns()
+                              << " was dropped or renamed during the $out bulk load",
+                collection && collection == _collection && collection->uuid() == _uuid);
+
+        IndexCatalog* indexCatalog = collection->getIndexCatalog();
+        bool indexesUnchanged =
+            indexCatalog->numIndexesTotal(_opCtx) == static_cast<int>(_indexes.size());
+        for (auto&& index : _indexes) {
+            indexesUnchanged = indexesUnchanged &&
+                indexCatalog->findIndexByName(_opCtx, index.name) == index.descriptor;
+        }
+        uassert(ErrorCodes::IndexNotFound,
+                str::stream() << "indexes of " << _nss.ns()
+                              << " changed during the $out bulk load",
+                indexesUnchanged);
+    }
+
+    Status addKeys(const BSONObj& doc, const RecordId& loc) {
+        for (auto&& index : _indexes) {
+            if (index.filterExpression && !index.filterExpression->matchesBSON(doc)) {
+                continue;
+            }
+
+            int64_t unused;
+            Status status = index.bulk->insert(_opCtx, doc, loc, index.options, &unused);
+            if (!status.isOK()) {
+                return status;
+            }
+        }
+        return Status::OK();
+    }
+
+    void setCurOpMessage(const std::string& message) {
+        stdx::lock_guard<Client> lk(*_opCtx->getClient());
+        CurOp::get(_opCtx)->setMessage_inlock(message.c_str());
+    }
+
+    const intrusive_ptr<ExpressionContext> _ctx;
+    OperationContext* const _opCtx;
+    const NamespaceString _nss;
+
+    Collection* _collection = nullptr;
+    OptionalCollectionUUID _uuid;
+    std::vector<IndexToLoad> _indexes;
+    size_t _numInserted = 0;
+};
+
 class MongodProcessInterface final
     : public DocumentSourceNeedsMongoProcessInterface::MongoProcessInterface {
 public:
@@ -200,6 +477,14 @@ public:
                                           str::stream() << "renameCollection failed: " << info};
     }
 
+    std::unique_ptr<BulkLoader> createCollectionForBulkLoading(
+        const NamespaceString& ns,
+        const BSONObj& collectionOptions,
+        std::vector<BSONObj> indexSpecs) final {
+        return stdx::make_unique<MongodBulkLoader>(
+            _ctx, ns, collectionOptions, std::move(indexSpecs));
+    }
+
     StatusWith<std::unique_ptr<Pipeline, Pipeline::Deleter>> makePipeline(
         const std::vector<BSONObj>& rawPipeline,
         const boost::intrusive_ptr<ExpressionContext>& expCtx,
@@ -339,6 +624,10 @@ public:
                 Locker::LockerInfo lockerInfo;
                 clientOpCtx->lockState()->getLockerInfo(&lockerInfo);
                 fillLockerInfo(lockerInfo, infoBuilder);
+
+                infoBuilder.append("ticketWaitMicros",
+                                   durationCount<Microseconds>(
+                                       clientOpCtx->lockState()->getTimeQueuedForTicket()));
             }
 
             ops.emplace_back(infoBuilder.obj());
@@ -417,6 +706,36 @@ public:
         return lookedUpDocument;
     }
 
+    std::vector<Document> lookupDocuments(const NamespaceString& nss,
+                                          UUID collectionUUID,
+                                          const std::vector<Document>& documentKeys,
+                                          boost::optional<BSONObj> readConcern,
+                                          bool* complete) final {
+        invariant(!readConcern);  // See lookupSingleDocument().
+        Timer timer;
+
+        // Be sure to do the lookup using the collection default collation. A local pipeline
+        // returns every matching document, so the results are always complete.
+        *complete = true;
+        std::vector<Document> lookedUpDocuments;
+        auto foreignExpCtx =
+            _ctx->copyWith(nss, collectionUUID, _getCollectionDefaultCollator(nss, collectionUUID));
+        auto swPipeline = makePipeline({BSON("$match" << makeDocumentKeysFilter(documentKeys))},
+                                       foreignExpCtx);
+        if (swPipeline != ErrorCodes::NamespaceNotFound) {
+            auto pipeline = uassertStatusOK(std::move(swPipeline));
+            while (auto next = pipeline->getNext()) {
+                lookedUpDocuments.push_back(std::move(*next));
+            }
+        }
+
+        auto opCtx = _ctx->opCtx;
+        stdx::lock_guard<Client> lk(*opCtx->getClient());
+        CurOp::get(opCtx)->recordDocumentKeyLookups_inlock(documentKeys.size(),
+                                                           Milliseconds(timer.millis()));
+        return lookedUpDocuments;
+    }
+
 private:
     /**
      * Looks up the collection default collator for the collection given by 'collectionUUID'. A
@@ -521,17 +840,15 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> createRandomCursorEx
         opCtx, std::move(ws), std::move(stage), collection, PlanExecutor::YIELD_AUTO);
 }
 
-StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> attemptToGetExecutor(
+StatusWith<std::unique_ptr<CanonicalQuery>> canonicalizeForPipeline(
     OperationContext* opCtx,
-    Collection* collection,
     const NamespaceString& nss,
     const intrusive_ptr<ExpressionContext>& pExpCtx,
     bool oplogReplay,
     BSONObj queryObj,
     BSONObj projectionObj,
     BSONObj sortObj,
-    const AggregationRequest* aggRequest,
-    const size_t plannerOpts) {
+    const AggregationRequest* aggRequest) {
     auto qr = stdx::make_unique<QueryRequest>(nss);
     qr->setTailableMode(pExpCtx->tailableMode);
     qr->setOplogReplay(oplogReplay);
@@ -555,8 +872,23 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> attemptToGetExe
 
     const ExtensionsCallbackReal extensionsCallback(pExpCtx->opCtx, &nss);
 
-    auto cq = CanonicalQuery::canonicalize(
+    return CanonicalQuery::canonicalize(
         opCtx, std::move(qr), pExpCtx, extensionsCallback, Pipeline::kAllowedMatcherFeatures);
+}
+
+StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> attemptToGetExecutor(
+    OperationContext* opCtx,
+    Collection* collection,
+    const NamespaceString& nss,
+    const intrusive_ptr<ExpressionContext>& pExpCtx,
+    bool oplogReplay,
+    BSONObj queryObj,
+    BSONObj projectionObj,
+    BSONObj sortObj,
+    const AggregationRequest* aggRequest,
+    const size_t plannerOpts) {
+    auto cq = canonicalizeForPipeline(
+        opCtx, nss, pExpCtx, oplogReplay, queryObj, projectionObj, sortObj, aggRequest);
 
     if (!cq.isOK()) {
         // Return an error instead of uasserting, since there are cases where the combination of
@@ -571,6 +903,88 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> attemptToGetExe
         opCtx, collection, nss, std::move(cq.getValue()), PlanExecutor::YIELD_AUTO, plannerOpts);
 }
 
+/**
+ * Attempts to answer a leading $group whose _id is a single field path and whose accumulators are
+ * all $first, or all $last, with a DISTINCT_SCAN, which visits one index key per group instead of
+ * every document. The scan runs backwards if 'needsLastDocument' is set. The $group stage is left
+ * in the pipeline, so the executor only has to produce one document for each distinct value of
+ * the field. Fails if no suitable index exists, or if the collection is sharded: a DISTINCT_SCAN
+ * cannot filter out orphaned documents.
+ */
+StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> attemptToGetDistinctScanExecutor(
+    OperationContext* opCtx,
+    Collection* collection,
+    const NamespaceString& nss,
+    const intrusive_ptr<ExpressionContext>& pExpCtx,
+    BSONObj queryObj,
+    BSONObj projectionObj,
+    const AggregationRequest* aggRequest,
+    const std::string& distinctField,
+    bool needsLastDocument) {
+    if (!collection || pExpCtx->tailableMode != TailableMode::kNormal ||
+        (aggRequest && !aggRequest->getHint().isEmpty())) {
+        return {ErrorCodes::BadValue, "DISTINCT_SCAN is not applicable to this aggregation"};
+    }
+
+    if (ShardingState::get(opCtx)->needCollectionMetadata(opCtx, nss.ns())) {
+        return {ErrorCodes::BadValue, "DISTINCT_SCAN cannot apply the shard filter"};
+    }
+
+    auto cq = canonicalizeForPipeline(
+        opCtx, nss, pExpCtx, false, queryObj, projectionObj, BSONObj(), aggRequest);
+    if (!cq.isOK()) {
+        return {cq.getStatus()};
+    }
+
+    ParsedDistinct parsedDistinct(std::move(cq.getValue()), distinctField);
+    return getExecutorDistinct(opCtx,
+                               collection,
+                               nss.ns(),
+                               &parsedDistinct,
+                               PlanExecutor::YIELD_AUTO,
+                               QueryPlannerParams::STRICT_DISTINCT_ONLY |
+                                   (needsLastDocument ? QueryPlannerParams::REVERSE_DISTINCT_SCAN
+                                                      : 0));
+}
+
+/**
+ * Returns a factory for the cursors with which a change stream reading the oplog through the
+ * SharedOplogReader catches up with it again after being detached. Each cursor reads the entries
+ * matching 'queryObj' whose timestamps are greater than the one it is given.
+ */
+DocumentSourceSharedOplogCursor::CursorFactory makeOplogCursorFactory(
+    const NamespaceString& nss,
+    const BSONObj& queryObj,
+    const intrusive_ptr<ExpressionContext>& expCtx) {
+    const BSONObj ownedQuery = queryObj.getOwned();
+    return [nss, ownedQuery, expCtx](Timestamp readThrough) {
+        auto opCtx = expCtx->opCtx;
+        AutoGetCollectionForRead autoColl(opCtx, nss);
+
+        const BSONObj resumeQuery =
+            BSON("$and" << BSON_ARRAY(ownedQuery << BSON("ts" << BSON("$gt" << readThrough))));
+        auto exec = uassertStatusOK(
+            attemptToGetExecutor(opCtx,
+                                 autoColl.getCollection(),
+                                 nss,
+                                 expCtx,
+                                 true,
+                                 resumeQuery,
+                                 BSONObj(),
+                                 BSONObj(),
+                                 nullptr,
+                                 QueryPlannerParams::DEFAULT |
+                                     QueryPlannerParams::TRACK_LATEST_OPLOG_TS));
+
+        // DocumentSourceCursor expects a yielding PlanExecutor that has had its state saved.
+        exec->saveState();
+        auto cursor =
+            DocumentSourceCursor::create(autoColl.getCollection(), std::move(exec), expCtx);
+        cursor->setQuery(resumeQuery);
+        return cursor;
+    };
+}
+
 BSONObj removeSortKeyMetaProjection(BSONObj projectionObj) {
     if (!projectionObj[Document::metaFieldSortKey]) {
         return projectionObj;
@@ -701,6 +1115,21 @@ void PipelineD::prepareCursorSource(Collection* collection,
 
     addCursorSource(
         collection, pipeline, expCtx, std::move(exec), deps, queryObj, sortObj, projForQuery);
+
+    // Rather than each scanning the oplog, change streams share the scan of the SharedOplogReader
+    // once their own cursor has caught up with it.
+    if (oplogReplay && expCtx->tailableMode == TailableMode::kTailableAndAwaitData &&
+        !expCtx->explain && internalChangeStreamUseSharedOplogReader.load()) {
+        intrusive_ptr<DocumentSourceCursor> cursorStage =
+            static_cast<DocumentSourceCursor*>(sources.front().get());
+        auto oplogFilter = uassertStatusOK(MatchExpressionParser::parse(queryObj, expCtx));
+        sources.pop_front();
+        pipeline->addInitialSource(
+            DocumentSourceSharedOplogCursor::create(std::move(cursorStage),
+                                                    makeOplogCursorFactory(nss, queryObj, expCtx),
+                                                    std::move(oplogFilter),
+                                                    expCtx));
+    }
 }
 
 StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prepareExecutor(
@@ -750,13 +1179,48 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prep
         plannerOpts |= QueryPlannerParams::NO_UNCOVERED_PROJECTIONS;
     }
 
-    if (expCtx->needsMerge && expCtx->tailableMode == TailableMode::kTailableAndAwaitData) {
+    // A change stream which may attach to the SharedOplogReader needs to know how far its own
+    // cursor has read the oplog, as does one whose results are merged on mongoS.
+    if (expCtx->tailableMode == TailableMode::kTailableAndAwaitData &&
+        (expCtx->needsMerge ||
+         (oplogReplay && internalChangeStreamUseSharedOplogReader.load()))) {
         plannerOpts |= QueryPlannerParams::TRACK_LATEST_OPLOG_TS;
     }
 
     const BSONObj emptyProjection;
     const BSONObj metaSortProjection = BSON("$meta"
                                             << "sortKey");
+
+    // A leading $group that only needs the first or the last document of each group can skip
+    // through an index on its _id field rather than scanning the whole collection.
+    auto groupStage = !sortStage && !pipeline->_sources.empty()
+        ? dynamic_cast<DocumentSourceGroup*>(pipeline->_sources.front().get())
+        : nullptr;
+    if (groupStage && !oplogReplay && !deps.getNeedTextScore() && !deps.getNeedSortKey()) {
+        bool needsLastDocument = false;
+        if (auto distinctField = groupStage->getDistinctScanField(&needsLastDocument)) {
+            auto swExecutorDistinct = attemptToGetDistinctScanExecutor(opCtx,
+                                                                       collection,
+                                                                       nss,
+                                                                       expCtx,
+                                                                       queryObj,
+                                                                       *projectionObj,
+                                                                       aggRequest,
+                                                                       *distinctField,
+                                                                       needsLastDocument);
+            if (swExecutorDistinct.isOK()) {
+                // The plan may or may not fetch, so let ParsedDeps pick out the fields we need.
+                *projectionObj = BSONObj();
+                return std::move(swExecutorDistinct.getValue());
+            } else if (swExecutorDistinct == ErrorCodes::QueryPlanKilled) {
+                return {ErrorCodes::OperationFailed,
+                        str::stream() << "Failed to determine whether query system can provide a "
+                                         "distinct scan: "
+                                      << swExecutorDistinct.getStatus().toString()};
+            }
+        }
+    }
+
     if (sortStage) {
         // See if the query system can provide a non-blocking sort.
         auto swExecutorSort =
@@ -909,12 +1373,30 @@ Timestamp PipelineD::getLatestOplogTimestamp(const Pipeline* pipeline) {
             dynamic_cast<DocumentSourceCursor*>(pipeline->_sources.front().get())) {
         return docSourceCursor->getLatestOplogTimestamp();
     }
+    if (auto sharedOplogCursor =
+            dynamic_cast<DocumentSourceSharedOplogCursor*>(pipeline->_sources.front().get())) {
+        // Only report the timestamp when mongoS needs it to merge the results of the shards.
+        return pipeline->getContext()->needsMerge ? sharedOplogCursor->getLatestOplogTimestamp()
+                                                  : Timestamp();
+    }
     return Timestamp();
 }
 
+namespace {
+/**
+ * Returns the DocumentSourceCursor which reads the input of 'pipeline', if any.
+ */
+const DocumentSourceCursor* getInputCursor(const Pipeline::SourceContainer& sources) {
+    if (auto sharedOplogCursor =
+            dynamic_cast<DocumentSourceSharedOplogCursor*>(sources.front().get())) {
+        return sharedOplogCursor->getCursor();
+    }
+    return dynamic_cast<DocumentSourceCursor*>(sources.front().get());
+}
+}  // namespace
+
 std::string PipelineD::getPlanSummaryStr(const Pipeline* pPipeline) {
-    if (auto docSourceCursor =
-            dynamic_cast<DocumentSourceCursor*>(pPipeline->_sources.front().get())) {
+    if (auto docSourceCursor = getInputCursor(pPipeline->_sources)) {
         return docSourceCursor->getPlanSummaryStr();
     }
 
@@ -924,8 +1406,7 @@ std::string PipelineD::getPlanSummaryStr(const Pipeline* pPipeline) {
 void PipelineD::getPlanSummaryStats(const Pipeline* pPipeline, PlanSummaryStats* statsOut) {
     invariant(statsOut);
 
-    if (auto docSourceCursor =
-            dynamic_cast<DocumentSourceCursor*>(pPipeline->_sources.front().get())) {
+    if (auto docSourceCursor = getInputCursor(pPipeline->_sources)) {
         *statsOut = docSourceCursor->getPlanSummaryStats();
     }
 
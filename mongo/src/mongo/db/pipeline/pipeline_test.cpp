@@ -621,6 +621,52 @@ TEST(PipelineOptimizationTest, LookupDoesNotAbsorbUnwindOnSubfieldOfAsButStillMo
     assertPipelineOptimizesTo(inputPipe, outputPipe);
 }
 
+TEST(PipelineOptimizationTest, LookupShouldSwapWithSkipAndLimit) {
+    string inputPipe =
+        "[{$lookup: {from: 'lookupColl', as: 'x', localField: 'y', foreignField: 'z'}}, "
+        " {$skip: 3}, "
+        " {$limit: 5}]";
+    string outputPipe =
+        "[{$limit: 8}, "
+        " {$skip: 3}, "
+        " {$lookup: {from: 'lookupColl', as: 'x', localField: 'y', foreignField: 'z'}}]";
+    assertPipelineOptimizesTo(inputPipe, outputPipe);
+}
+
+TEST(PipelineOptimizationTest, LookupShouldNotSwapWithLimitWhenUnwinding) {
+    string inputPipe =
+        "[{$lookup: {from: 'lookupColl', as: 'x', localField: 'y', foreignField: 'z'}}, "
+        " {$unwind: {path: '$x'}}, "
+        " {$limit: 5}]";
+    string outputPipe =
+        "[{$lookup: {from: 'lookupColl', as: 'x', localField: 'y', foreignField: 'z', "
+        "            unwinding: {preserveNullAndEmptyArrays: false}}}, "
+        " {$limit: 5}]";
+    string serializedPipe =
+        "[{$lookup: {from: 'lookupColl', as: 'x', localField: 'y', foreignField: 'z'}}, "
+        " {$unwind: {path: '$x'}}, "
+        " {$limit: 5}]";
+    assertPipelineOptimizesAndSerializesTo(inputPipe, outputPipe, serializedPipe);
+}
+
+TEST(PipelineOptimizationTest, SortLookupLimitBecomesTopKSortLookup) {
+    string inputPipe =
+        "[{$sort: {a: 1}}, "
+        " {$lookup: {from: 'lookupColl', as: 'x', localField: 'y', foreignField: 'z'}}, "
+        " {$addFields: {b: 1}}, "
+        " {$limit: 5}]";
+    string outputPipe =
+        "[{$sort: {sortKey: {a: 1}, limit: 5}}, "
+        " {$lookup: {from: 'lookupColl', as: 'x', localField: 'y', foreignField: 'z'}}, "
+        " {$addFields: {b: {$const: 1}}}]";
+    string serializedPipe =
+        "[{$sort: {a: 1}}, "
+        " {$limit: 5}, "
+        " {$lookup: {from: 'lookupColl', as: 'x', localField: 'y', foreignField: 'z'}}, "
+        " {$addFields: {b: {$const: 1}}}]";
+    assertPipelineOptimizesAndSerializesTo(inputPipe, outputPipe, serializedPipe);
+}
+
 TEST(PipelineOptimizationTest, MatchShouldDuplicateItselfBeforeRedact) {
     string inputPipe = "[{$redact: '$$PRUNE'}, {$match: {a: 1, b:12}}]";
     string outputPipe =
@@ -791,6 +837,19 @@ TEST(PipelineOptimizationTest, GraphLookupShouldNotCoalesceWithUnwindNotOnAs) {
     assertPipelineOptimizesTo(inputPipe, outputPipe);
 }
 
+TEST(PipelineOptimizationTest, GraphLookupShouldSwapWithLimit) {
+    string inputPipe =
+        "[{$graphLookup: {from: 'lookupColl', as: 'out', connectToField: 'b', "
+        "                 connectFromField: 'c', startWith: '$d'}}, "
+        " {$limit: 5}]";
+
+    string outputPipe =
+        "[{$limit: 5}, "
+        " {$graphLookup: {from: 'lookupColl', as: 'out', connectToField: 'b', "
+        "                 connectFromField: 'c', startWith: '$d'}}]";
+    assertPipelineOptimizesTo(inputPipe, outputPipe);
+}
+
 TEST(PipelineOptimizationTest, GraphLookupShouldSwapWithMatch) {
     string inputPipe =
         "[{$graphLookup: {"
@@ -0,0 +1,292 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/shared_oplog_reader.h"
+
+#include <algorithm>
+
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/repl/oplog_entry.h"
+#include "mongo/db/service_context.h"
+
+namespace mongo {
+
+namespace {
+const auto getSharedOplogReader = ServiceContext::declareDecoration<SharedOplogReader>();
+}  // namespace
+
+// static
+SharedOplogReader* SharedOplogReader::get(ServiceContext* service) {
+    return &getSharedOplogReader(service);
+}
+
+// static
+SharedOplogReader* SharedOplogReader::get(OperationContext* opCtx) {
+    return get(opCtx->getServiceContext());
+}
+
+bool SharedOplogReader::attach(const std::shared_ptr<Subscriber>& subscriber,
+                               Timestamp readThrough) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    if (_numSubscribers == 0) {
+        _position = readThrough;
+        _subscribersCV.notify_all();
+    } else if (readThrough < _position) {
+        return false;
+    }
+
+    {
+        stdx::lock_guard<stdx::mutex> subscriberLk(subscriber->_mutex);
+        invariant(!subscriber->_attached && subscriber->_buffer.empty());
+        subscriber->_attached = true;
+    }
+    _addToIndex_inlock(subscriber);
+    ++_numAttaches;
+    return true;
+}
+
+void SharedOplogReader::detach(const std::shared_ptr<Subscriber>& subscriber) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    {
+        stdx::lock_guard<stdx::mutex> subscriberLk(subscriber->_mutex);
+        if (!subscriber->_attached) {
+            return;
+        }
+        subscriber->_attached = false;
+        subscriber->_detachedAfter = _position;
+    }
+    _removeFromIndex_inlock(subscriber);
+}
+
+SharedOplogReader::NextResult SharedOplogReader::next(Subscriber* subscriber,
+                                                      BSONObj* entry,
+                                                      Timestamp* readThrough) {
+    {
+        stdx::lock_guard<stdx::mutex> subscriberLk(subscriber->_mutex);
+        if (!subscriber->_buffer.empty()) {
+            *entry = std::move(subscriber->_buffer.front());
+            subscriber->_buffer.pop_front();
+            return NextResult::kEntry;
+        }
+    }
+
+    // The scan position must be read together with the buffer, so that no entry can be buffered
+    // between the two.
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    stdx::lock_guard<stdx::mutex> subscriberLk(subscriber->_mutex);
+    if (!subscriber->_buffer.empty()) {
+        *entry = std::move(subscriber->_buffer.front());
+        subscriber->_buffer.pop_front();
+        return NextResult::kEntry;
+    }
+    if (subscriber->_attached) {
+        *readThrough = _position;
+        return NextResult::kEmpty;
+    }
+    *readThrough = subscriber->_detachedAfter;
+    return NextResult::kDetached;
+}
+
+bool SharedOplogReader::waitForEntries(OperationContext* opCtx,
+                                       Subscriber* subscriber,
+                                       Date_t deadline) {
+    stdx::unique_lock<stdx::mutex> subscriberLk(subscriber->_mutex);
+    while (subscriber->_buffer.empty() && subscriber->_attached) {
+        auto swWait = opCtx->waitForConditionOrInterruptNoAssertUntil(
+            subscriber->_cv, subscriberLk, deadline);
+        if (!swWait.isOK() || swWait.getValue() == stdx::cv_status::timeout) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SharedOplogReader::waitForSubscribers(Date_t deadline) {
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    return _subscribersCV.wait_until(
+        lk, deadline.toSystemTimePoint(), [&] { return _numSubscribers > 0; });
+}
+
+Timestamp SharedOplogReader::getScanPosition() {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    if (_numSubscribers == 0) {
+        _position = Timestamp();
+    }
+    return _position;
+}
+
+void SharedOplogReader::dispatch(Timestamp scannedAfter,
+                                 const std::vector<BSONObj>& entries,
+                                 Milliseconds scanDuration) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    ++_numScanPasses;
+    _numEntriesScanned += entries.size();
+    _totalScanTime += scanDuration;
+    if (scannedAfter != _position) {
+        return;
+    }
+
+    SubscriberList overflowed;
+    const auto pushTo = [&](const SubscriberList& subscribers, const BSONObj& entry,
+                            Timestamp previous) {
+        for (auto&& subscriber : subscribers) {
+            if (!_push(subscriber.get(), entry, previous)) {
+                overflowed.push_back(subscriber);
+            }
+        }
+    };
+
+    for (auto&& entry : entries) {
+        const Timestamp ts = entry[repl::OplogEntry::kTimestampFieldName].timestamp();
+        if (ts <= _position) {
+            continue;
+        }
+        const Timestamp previous = _position;
+        _position = ts;
+
+        const StringData ns = entry[repl::OplogEntry::kNamespaceFieldName].valueStringData();
+        if (entry[repl::OplogEntry::kOpTypeFieldName].valueStringData() == "c"_sd) {
+            // Commands are logged against the $cmd namespace of their database, and may concern
+            // any collection in it, as well as the target of a rename into another database.
+            const StringData db = nsToDatabaseSubstring(ns);
+            auto byDatabase = _byDatabase.find(db);
+            if (byDatabase != _byDatabase.end()) {
+                pushTo(byDatabase->second, entry, previous);
+            }
+
+            const BSONElement renameTarget = entry.getObjectField("o")["to"];
+            if (renameTarget.type() == String &&
+                nsToDatabaseSubstring(renameTarget.valueStringData()) != db) {
+                auto byNamespace = _byNamespace.find(renameTarget.valueStringData());
+                if (byNamespace != _byNamespace.end()) {
+                    pushTo(byNamespace->second, entry, previous);
+                }
+            }
+        } else {
+            auto byNamespace = _byNamespace.find(ns);
+            if (byNamespace != _byNamespace.end()) {
+                pushTo(byNamespace->second, entry, previous);
+            }
+        }
+
+        for (auto&& subscriber : overflowed) {
+            _removeFromIndex_inlock(subscriber);
+            ++_numOverflows;
+        }
+        overflowed.clear();
+    }
+}
+
+void SharedOplogReader::reset() {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    for (auto&& byNamespace : _byNamespace) {
+        for (auto&& subscriber : byNamespace.second) {
+            stdx::lock_guard<stdx::mutex> subscriberLk(subscriber->_mutex);
+            subscriber->_attached = false;
+            subscriber->_detachedAfter = _position;
+            subscriber->_cv.notify_all();
+        }
+    }
+    _byNamespace.clear();
+    _byDatabase.clear();
+    _numSubscribers = 0;
+    _position = Timestamp();
+}
+
+void SharedOplogReader::appendStats(BSONObjBuilder* builder) const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    long long numBuffered = 0;
+    long long maxBuffered = 0;
+    for (auto&& byNamespace : _byNamespace) {
+        for (auto&& subscriber : byNamespace.second) {
+            stdx::lock_guard<stdx::mutex> subscriberLk(subscriber->_mutex);
+            const long long bufferSize = subscriber->_buffer.size();
+            numBuffered += bufferSize;
+            maxBuffered = std::max(maxBuffered, bufferSize);
+        }
+    }
+
+    builder->append("subscribers", _numSubscribers);
+    builder->append("namespaces", static_cast<long long>(_byNamespace.size()));
+    builder->append("position", _position);
+    builder->append("bufferedEntries", numBuffered);
+    builder->append("maxBufferedEntries", maxBuffered);
+    builder->append("attaches", _numAttaches);
+    builder->append("overflows", _numOverflows);
+
+    BSONObjBuilder scanBuilder(builder->subobjStart("scan"));
+    scanBuilder.append("passes", _numScanPasses);
+    scanBuilder.append("entriesScanned", _numEntriesScanned);
+    scanBuilder.append("entriesDispatched", _numEntriesDispatched);
+    scanBuilder.append("totalMillis", durationCount<Milliseconds>(_totalScanTime));
+    scanBuilder.doneFast();
+}
+
+void SharedOplogReader::_addToIndex_inlock(const std::shared_ptr<Subscriber>& subscriber) {
+    _byNamespace[subscriber->nss().ns()].push_back(subscriber);
+    _byDatabase[subscriber->nss().db()].push_back(subscriber);
+    ++_numSubscribers;
+}
+
+void SharedOplogReader::_removeFromIndex_inlock(const std::shared_ptr<Subscriber>& subscriber) {
+    const auto removeFrom = [&](StringMap<SubscriberList>* index, StringData key) {
+        auto it = index->find(key);
+        invariant(it != index->end());
+        auto& subscribers = it->second;
+        subscribers.erase(std::find(subscribers.begin(), subscribers.end(), subscriber));
+        if (subscribers.empty()) {
+            index->erase(it);
+        }
+    };
+    removeFrom(&_byNamespace, subscriber->nss().ns());
+    removeFrom(&_byDatabase, subscriber->nss().db());
+    --_numSubscribers;
+}
+
+bool SharedOplogReader::_push(Subscriber* subscriber, const BSONObj& entry, Timestamp previous) {
+    const size_t maxBuffered =
+        std::max(1, internalChangeStreamSharedOplogReaderMaxBufferedEntries.load());
+
+    stdx::lock_guard<stdx::mutex> subscriberLk(subscriber->_mutex);
+    if (subscriber->_buffer.size() >= maxBuffered) {
+        subscriber->_attached = false;
+        subscriber->_detachedAfter = previous;
+        subscriber->_cv.notify_all();
+        return false;
+    }
+    subscriber->_buffer.push_back(entry);
+    subscriber->_cv.notify_all();
+    ++_numEntriesDispatched;
+    return true;
+}
+
+}  // namespace mongo
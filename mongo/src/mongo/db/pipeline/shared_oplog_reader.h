@@ -0,0 +1,205 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/bson/timestamp.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/string_map.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+class OperationContext;
+class ServiceContext;
+
+/**
+ * Reads the oplog once on behalf of all the change streams on this node, decorating the
+ * ServiceContext.
+ *
+ * A background job scans the majority committed oplog forward from the reader's position and
+ * hands each entry to the subscribers it may concern, looked up by namespace: CRUD entries go to
+ * the subscribers of the entry's namespace, while commands go to the subscribers of every
+ * collection in the command's database and to those of the target of a rename. Each subscriber
+ * buffers the entries it is given until its change stream consumes them and applies its own oplog
+ * filter to them, so the scan never evaluates the filter of every change stream.
+ *
+ * A change stream reads the oplog on its own until it has caught up with the shared scan, and only
+ * then attaches to the reader. A subscriber whose buffer is full is detached rather than allowed
+ * to hold back the scan for everybody else; its change stream drains the buffer and reads the
+ * oplog on its own again, from the last entry it was given, until it catches up once more.
+ */
+class SharedOplogReader {
+    MONGO_DISALLOW_COPYING(SharedOplogReader);
+
+public:
+    /**
+     * The state of one change stream's subscription.
+     */
+    class Subscriber {
+        MONGO_DISALLOW_COPYING(Subscriber);
+
+    public:
+        explicit Subscriber(NamespaceString nss) : _nss(std::move(nss)) {}
+
+        const NamespaceString& nss() const {
+            return _nss;
+        }
+
+    private:
+        friend class SharedOplogReader;
+
+        const NamespaceString _nss;
+
+        // Protects the members below. Acquired after SharedOplogReader::_mutex, if both are held.
+        stdx::mutex _mutex;
+
+        // Notified when an entry is buffered or the subscriber is detached.
+        stdx::condition_variable _cv;
+
+        std::deque<BSONObj> _buffer;
+        bool _attached = false;
+
+        // Once detached, the timestamp of the last oplog entry which the shared scan handled on
+        // behalf of this subscriber.
+        Timestamp _detachedAfter;
+    };
+
+    enum class NextResult {
+        // An oplog entry was returned.
+        kEntry,
+        // No entry is buffered, and the subscriber is still attached.
+        kEmpty,
+        // No entry is buffered, and the subscriber is detached.
+        kDetached,
+    };
+
+    SharedOplogReader() = default;
+
+    static SharedOplogReader* get(ServiceContext* service);
+    static SharedOplogReader* get(OperationContext* opCtx);
+
+    /**
+     * Attaches 'subscriber', which has read every oplog entry up to and including 'readThrough' on
+     * its own. If no subscriber is attached, the shared scan starts after 'readThrough'. Returns
+     * false, and leaves the subscriber detached, if the scan is already past 'readThrough'.
+     */
+    bool attach(const std::shared_ptr<Subscriber>& subscriber, Timestamp readThrough);
+
+    /**
+     * Detaches 'subscriber' when its change stream goes away. Does nothing if it is not attached.
+     */
+    void detach(const std::shared_ptr<Subscriber>& subscriber);
+
+    /**
+     * Pops the next buffered entry of 'subscriber' into '*entry'. Otherwise sets '*readThrough' to
+     * the timestamp up to which the shared scan has handled the oplog on behalf of the subscriber.
+     */
+    NextResult next(Subscriber* subscriber, BSONObj* entry, Timestamp* readThrough);
+
+    /**
+     * Waits until 'deadline' for an entry to be buffered for 'subscriber', or for it to be
+     * detached. Returns false if neither happened.
+     */
+    bool waitForEntries(OperationContext* opCtx, Subscriber* subscriber, Date_t deadline);
+
+    /**
+     * Waits until 'deadline' for a subscriber to be attached. Returns true if one is attached. The
+     * scanner waits here rather than on the oplog while no change stream uses the reader.
+     */
+    bool waitForSubscribers(Date_t deadline);
+
+    /**
+     * Returns the timestamp of the last oplog entry handled by the shared scan, which must scan the
+     * oplog after it. Returns a null timestamp, and forgets the position, if no subscriber is
+     * attached, in which case there is nothing to scan for.
+     */
+    Timestamp getScanPosition();
+
+    /**
+     * Hands each of 'entries', the oplog entries following 'scannedAfter' in timestamp order, to
+     * the attached subscribers, and advances the scan position past them. 'scanDuration' is the
+     * time it took to read them. The entries are dropped if the position is no longer
+     * 'scannedAfter', which happens when every subscriber left and a new one restarted the scan
+     * while they were being read.
+     */
+    void dispatch(Timestamp scannedAfter,
+                  const std::vector<BSONObj>& entries,
+                  Milliseconds scanDuration);
+
+    /**
+     * Detaches every subscriber, for instance because the oplog can no longer be read from the
+     * scan position.
+     */
+    void reset();
+
+    void appendStats(BSONObjBuilder* builder) const;
+
+private:
+    using SubscriberList = std::vector<std::shared_ptr<Subscriber>>;
+
+    void _addToIndex_inlock(const std::shared_ptr<Subscriber>& subscriber);
+    void _removeFromIndex_inlock(const std::shared_ptr<Subscriber>& subscriber);
+
+    /**
+     * Buffers 'entry' for 'subscriber'. If the buffer is full, detaches the subscriber after
+     * 'previous', the entry handled before this one, and returns false.
+     */
+    bool _push(Subscriber* subscriber, const BSONObj& entry, Timestamp previous);
+
+    mutable stdx::mutex _mutex;
+
+    // The attached subscribers, by the namespace they watch and by its database.
+    StringMap<SubscriberList> _byNamespace;
+    StringMap<SubscriberList> _byDatabase;
+    long long _numSubscribers = 0;
+
+    // Signalled when the first subscriber is attached.
+    stdx::condition_variable _subscribersCV;
+
+    Timestamp _position;
+
+    long long _numScanPasses = 0;
+    long long _numEntriesScanned = 0;
+    long long _numEntriesDispatched = 0;
+    long long _numAttaches = 0;
+    long long _numOverflows = 0;
+    Milliseconds _totalScanTime{0};
+};
+
+}  // namespace mongo
@@ -0,0 +1,222 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <memory>
+#include <vector>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/pipeline/shared_oplog_reader.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+namespace {
+
+using Subscriber = SharedOplogReader::Subscriber;
+using NextResult = SharedOplogReader::NextResult;
+
+BSONObj makeInsert(unsigned int secs, StringData ns) {
+    return BSON("ts" << Timestamp(secs, 1) << "op"
+                     << "i"
+                     << "ns"
+                     << ns
+                     << "o"
+                     << BSON("_id" << 1));
+}
+
+BSONObj makeCommand(unsigned int secs, StringData db, BSONObj command) {
+    return BSON("ts" << Timestamp(secs, 1) << "op"
+                     << "c"
+                     << "ns"
+                     << db + ".$cmd"
+                     << "o"
+                     << command);
+}
+
+class SharedOplogReaderTest : public unittest::Test {
+protected:
+    std::shared_ptr<Subscriber> subscribe(StringData ns, unsigned int readThroughSecs) {
+        auto subscriber = std::make_shared<Subscriber>(NamespaceString(ns));
+        ASSERT_TRUE(reader.attach(subscriber, Timestamp(readThroughSecs, 1)));
+        return subscriber;
+    }
+
+    void dispatch(std::vector<BSONObj> entries) {
+        reader.dispatch(reader.getScanPosition(), entries, Milliseconds(0));
+    }
+
+    /**
+     * Returns the timestamps of the entries buffered for 'subscriber'.
+     */
+    std::vector<Timestamp> drain(Subscriber* subscriber) {
+        std::vector<Timestamp> timestamps;
+        BSONObj entry;
+        Timestamp readThrough;
+        while (reader.next(subscriber, &entry, &readThrough) == NextResult::kEntry) {
+            timestamps.push_back(entry["ts"].timestamp());
+        }
+        return timestamps;
+    }
+
+    BSONObj stats() {
+        BSONObjBuilder builder;
+        reader.appendStats(&builder);
+        return builder.obj();
+    }
+
+    SharedOplogReader reader;
+};
+
+TEST_F(SharedOplogReaderTest, DispatchesCrudEntriesByNamespace) {
+    auto subscriberA = subscribe("test.a", 1);
+    auto subscriberB = subscribe("test.b", 1);
+
+    dispatch({makeInsert(2, "test.a"), makeInsert(3, "test.b"), makeInsert(4, "test.c")});
+
+    ASSERT(drain(subscriberA.get()) == std::vector<Timestamp>{Timestamp(2, 1)});
+    ASSERT(drain(subscriberB.get()) == std::vector<Timestamp>{Timestamp(3, 1)});
+
+    // Once the buffer is empty, the subscriber has seen everything up to the scan position.
+    BSONObj entry;
+    Timestamp readThrough;
+    ASSERT(reader.next(subscriberA.get(), &entry, &readThrough) == NextResult::kEmpty);
+    ASSERT_EQ(readThrough, Timestamp(4, 1));
+
+    auto scanStats = stats()["scan"].Obj();
+    ASSERT_EQ(scanStats["entriesScanned"].numberLong(), 3);
+    ASSERT_EQ(scanStats["entriesDispatched"].numberLong(), 2);
+}
+
+TEST_F(SharedOplogReaderTest, DispatchesCommandsToTheirDatabaseAndRenameTarget) {
+    auto subscriberA = subscribe("test.a", 1);
+    auto subscriberB = subscribe("other.b", 1);
+
+    dispatch({makeCommand(2, "test", BSON("drop"
+                                          << "x")),
+              makeCommand(3,
+                          "test",
+                          BSON("renameCollection"
+                               << "test.x"
+                               << "to"
+                               << "other.b"))});
+
+    ASSERT(drain(subscriberA.get()) == (std::vector<Timestamp>{Timestamp(2, 1), Timestamp(3, 1)}));
+    ASSERT(drain(subscriberB.get()) == std::vector<Timestamp>{Timestamp(3, 1)});
+}
+
+TEST_F(SharedOplogReaderTest, CannotAttachBehindTheScan) {
+    auto subscriberA = subscribe("test.a", 5);
+    ASSERT_EQ(reader.getScanPosition(), Timestamp(5, 1));
+
+    auto subscriberB = std::make_shared<Subscriber>(NamespaceString("test.b"));
+    ASSERT_FALSE(reader.attach(subscriberB, Timestamp(3, 1)));
+    ASSERT_TRUE(reader.attach(subscriberB, Timestamp(6, 1)));
+    ASSERT_EQ(stats()["subscribers"].numberLong(), 2);
+
+    // Once every subscriber has left, the scan stops and the next subscriber restarts it.
+    reader.detach(subscriberA);
+    reader.detach(subscriberB);
+    ASSERT_EQ(reader.getScanPosition(), Timestamp());
+    subscribe("test.c", 2);
+    ASSERT_EQ(reader.getScanPosition(), Timestamp(2, 1));
+}
+
+TEST_F(SharedOplogReaderTest, DropsEntriesScannedFromAStalePosition) {
+    auto subscriber = subscribe("test.a", 5);
+    reader.dispatch(Timestamp(3, 1), {makeInsert(4, "test.a")}, Milliseconds(0));
+    ASSERT(drain(subscriber.get()).empty());
+    ASSERT_EQ(reader.getScanPosition(), Timestamp(5, 1));
+}
+
+TEST_F(SharedOplogReaderTest, SubscriberWithFullBufferIsDetached) {
+    const auto maxBuffered = internalChangeStreamSharedOplogReaderMaxBufferedEntries.load();
+    ON_BLOCK_EXIT(
+        [&] { internalChangeStreamSharedOplogReaderMaxBufferedEntries.store(maxBuffered); });
+    internalChangeStreamSharedOplogReaderMaxBufferedEntries.store(2);
+
+    auto slow = subscribe("test.a", 1);
+    auto fast = subscribe("test.b", 1);
+    dispatch({makeInsert(2, "test.a"),
+              makeInsert(3, "test.a"),
+              makeInsert(4, "test.b"),
+              makeInsert(5, "test.a"),
+              makeInsert(6, "test.a")});
+
+    // The slow subscriber keeps what was buffered before it overflowed, and has to read the oplog
+    // on its own after the last entry handled on its behalf.
+    ASSERT(drain(slow.get()) == (std::vector<Timestamp>{Timestamp(2, 1), Timestamp(3, 1)}));
+    BSONObj entry;
+    Timestamp readThrough;
+    ASSERT(reader.next(slow.get(), &entry, &readThrough) == NextResult::kDetached);
+    ASSERT_EQ(readThrough, Timestamp(4, 1));
+
+    // The other subscriber is unaffected.
+    ASSERT(drain(fast.get()) == std::vector<Timestamp>{Timestamp(4, 1)});
+    ASSERT(reader.next(fast.get(), &entry, &readThrough) == NextResult::kEmpty);
+    ASSERT_EQ(readThrough, Timestamp(6, 1));
+
+    auto readerStats = stats();
+    ASSERT_EQ(readerStats["subscribers"].numberLong(), 1);
+    ASSERT_EQ(readerStats["overflows"].numberLong(), 1);
+
+    // Once it has caught up, the slow subscriber can attach again.
+    ASSERT_TRUE(reader.attach(slow, Timestamp(6, 1)));
+}
+
+TEST_F(SharedOplogReaderTest, ResetDetachesEverySubscriber) {
+    auto subscriber = subscribe("test.a", 1);
+    dispatch({makeInsert(2, "test.b")});
+    reader.reset();
+
+    BSONObj entry;
+    Timestamp readThrough;
+    ASSERT(reader.next(subscriber.get(), &entry, &readThrough) == NextResult::kDetached);
+    ASSERT_EQ(readThrough, Timestamp(2, 1));
+    ASSERT_EQ(reader.getScanPosition(), Timestamp());
+}
+
+TEST_F(SharedOplogReaderTest, WaitsForTheFirstSubscriber) {
+    ASSERT_FALSE(reader.waitForSubscribers(Date_t::now() + Milliseconds(10)));
+
+    stdx::thread subscribing([&] { subscribe("test.a", 1); });
+    ON_BLOCK_EXIT([&] { subscribing.join(); });
+    ASSERT_TRUE(reader.waitForSubscribers(Date_t::now() + Seconds(60)));
+
+    // It does not wait while a subscriber is attached.
+    ASSERT_TRUE(reader.waitForSubscribers(Date_t::now()));
+}
+
+}  // namespace
+}  // namespace mongo
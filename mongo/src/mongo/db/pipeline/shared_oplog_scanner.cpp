@@ -0,0 +1,227 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/shared_oplog_scanner.h"
+
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/pipeline/shared_oplog_reader.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/get_executor.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/query/query_request.h"
+#include "mongo/db/repl/oplog_entry.h"
+#include "mongo/db/repl/replication_coordinator.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage/recovery_unit.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/util/background.h"
+#include "mongo/util/concurrency/idle_thread_block.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+namespace {
+
+// How long the scanner waits for the oplog to change when it has nothing to read, or for a change
+// stream to subscribe when there is none. Inserts into the oplog, advances of the majority commit
+// point and new subscribers wake it up sooner.
+const Milliseconds kMaxIdleWait(1000);
+
+class SharedOplogScanner : public BackgroundJob {
+public:
+    std::string name() const override {
+        return "SharedOplogScanner";
+    }
+
+    void run() override {
+        Client::initThread(name().c_str());
+        AuthorizationSession::get(cc())->grantInternalAuthorization();
+
+        auto reader = SharedOplogReader::get(getGlobalServiceContext());
+        while (!globalInShutdownDeprecated()) {
+            // Stay away from the oplog, and its insert notifications, while nothing subscribes.
+            if (!internalChangeStreamUseSharedOplogReader.load()) {
+                // Change streams which subscribed before the reader was turned off go back to
+                // their own cursors.
+                reader->reset();
+                MONGO_IDLE_THREAD_BLOCK;
+                sleepFor(kMaxIdleWait);
+                continue;
+            }
+            {
+                MONGO_IDLE_THREAD_BLOCK;
+                if (!reader->waitForSubscribers(Date_t::now() + kMaxIdleWait)) {
+                    continue;
+                }
+            }
+
+            std::shared_ptr<CappedInsertNotifier> notifier;
+            uint64_t notifierVersion = 0;
+            bool readEntries = false;
+            {
+                const ServiceContext::UniqueOperationContext opCtx = cc().makeOperationContext();
+                try {
+                    readEntries = doPass(opCtx.get(), reader, &notifier, &notifierVersion);
+                } catch (const DBException& ex) {
+                    // The subscribers go back to reading the oplog on their own, and report the
+                    // error to their clients if it persists.
+                    LOG(1) << "shared oplog scan failed: " << redact(ex.toStatus());
+                    reader->reset();
+                }
+            }
+
+            if (!readEntries) {
+                MONGO_IDLE_THREAD_BLOCK;
+                if (notifier) {
+                    notifier->wait(notifierVersion, kMaxIdleWait);
+                } else {
+                    sleepFor(kMaxIdleWait);
+                }
+            }
+        }
+    }
+
+private:
+    /**
+     * Reads the oplog entries which follow the scan position and dispatches them to the
+     * subscribers. Sets '*notifier' and '*notifierVersion' to wait for the oplog to change when
+     * there is nothing more to read. Returns true if any entry was read.
+     */
+    bool doPass(OperationContext* opCtx,
+                SharedOplogReader* reader,
+                std::shared_ptr<CappedInsertNotifier>* notifier,
+                uint64_t* notifierVersion) {
+        const NamespaceString& oplogNss = NamespaceString::kRsOplogNamespace;
+
+        // Capture the notifier version before reading, so that no change to the oplog can be
+        // missed between the end of the scan and the wait.
+        {
+            AutoGetCollection autoColl(opCtx, oplogNss, MODE_IS);
+            if (!autoColl.getCollection()) {
+                return false;
+            }
+            *notifier = autoColl.getCollection()->getCappedInsertNotifier();
+            *notifierVersion = (*notifier)->getVersion();
+        }
+
+        const Timestamp scannedAfter = reader->getScanPosition();
+        if (scannedAfter.isNull()) {
+            return false;
+        }
+
+        // If not in a readable state (e.g. during initial sync), let the change streams find out on
+        // their own.
+        auto replCoord = repl::ReplicationCoordinator::get(opCtx);
+        if (replCoord->getReplicationMode() != repl::ReplicationCoordinator::modeReplSet ||
+            !replCoord->getMemberState().readable()) {
+            reader->reset();
+            return false;
+        }
+
+        // Change streams only return majority committed changes.
+        Status snapshotStatus = opCtx->recoveryUnit()->setReadFromMajorityCommittedSnapshot();
+        if (snapshotStatus == ErrorCodes::ReadConcernMajorityNotAvailableYet) {
+            return false;
+        }
+        uassertStatusOK(snapshotStatus);
+
+        Timer timer;
+        std::vector<BSONObj> entries;
+        {
+            AutoGetCollectionForRead autoColl(opCtx, oplogNss);
+            Collection* oplog = autoColl.getCollection();
+            if (!oplog) {
+                return false;
+            }
+
+            auto qr = stdx::make_unique<QueryRequest>(oplogNss);
+            qr->setFilter(BSON(repl::OplogEntry::kTimestampFieldName << GT << scannedAfter));
+            qr->setOplogReplay(true);
+            auto cq = uassertStatusOK(CanonicalQuery::canonicalize(opCtx, std::move(qr)));
+            auto exec = uassertStatusOK(getExecutorFind(
+                opCtx, oplog, oplogNss, std::move(cq), PlanExecutor::YIELD_AUTO));
+
+            const size_t batchSize =
+                std::max(1, internalChangeStreamSharedOplogReaderBatchSize.load());
+            BSONObj entry;
+            PlanExecutor::ExecState state = PlanExecutor::ADVANCED;
+            while (entries.size() < batchSize &&
+                   (state = exec->getNext(&entry, nullptr)) == PlanExecutor::ADVANCED) {
+                entries.push_back(entry.getOwned());
+            }
+            uassert(ErrorCodes::OperationFailed,
+                    str::stream() << "Executor error during shared oplog scan: "
+                                  << WorkingSetCommon::toStatusString(entry),
+                    state != PlanExecutor::FAILURE && state != PlanExecutor::DEAD);
+        }
+
+        reader->dispatch(scannedAfter, entries, Milliseconds(timer.millis()));
+        return !entries.empty();
+    }
+};
+
+/**
+ * Reports the subscribers of the shared oplog reader, how many entries are buffered for them and
+ * how much of the oplog the shared scan has read.
+ */
+class SharedOplogReaderServerStatus : public ServerStatusSection {
+public:
+    SharedOplogReaderServerStatus() : ServerStatusSection("sharedOplogReader") {}
+
+    bool includeByDefault() const {
+        return true;
+    }
+
+    BSONObj generateSection(OperationContext* opCtx, const BSONElement& configElement) const {
+        BSONObjBuilder builder;
+        SharedOplogReader::get(opCtx)->appendStats(&builder);
+        return builder.obj();
+    }
+} sharedOplogReaderServerStatus;
+
+}  // namespace
+
+void startSharedOplogScanner() {
+    // The scanner is never stopped, so it can be leaked.
+    (new SharedOplogScanner())->go();
+}
+
+}  // namespace mongo
@@ -92,6 +92,13 @@ public:
         MONGO_UNREACHABLE;
     }
 
+    std::unique_ptr<BulkLoader> createCollectionForBulkLoading(
+        const NamespaceString& ns,
+        const BSONObj& collectionOptions,
+        std::vector<BSONObj> indexSpecs) override {
+        MONGO_UNREACHABLE;
+    }
+
     StatusWith<std::unique_ptr<Pipeline, Pipeline::Deleter>> makePipeline(
         const std::vector<BSONObj>& rawPipeline,
         const boost::intrusive_ptr<ExpressionContext>& expCtx,
@@ -124,5 +131,13 @@ public:
                                                    boost::optional<BSONObj> readConcern) {
         MONGO_UNREACHABLE;
     }
+
+    std::vector<Document> lookupDocuments(const NamespaceString& nss,
+                                          UUID collectionUUID,
+                                          const std::vector<Document>& documentKeys,
+                                          boost::optional<BSONObj> readConcern,
+                                          bool* complete) override {
+        MONGO_UNREACHABLE;
+    }
 };
 }  // namespace mongo
@@ -49,6 +49,15 @@ boost::intrusive_ptr<TeeBuffer> TeeBuffer::create(size_t nConsumers, int bufferS
 }
 
 DocumentSource::GetNextResult TeeBuffer::getNext(size_t consumerId) {
+    if (_concurrentConsumers) {
+        auto& consumer = _consumers[consumerId];
+        if (consumer.nLeftToReturn == 0) {
+            return _exhausted ? DocumentSource::GetNextResult::makeEOF()
+                              : DocumentSource::GetNextResult::makePauseExecution();
+        }
+        return _buffer[_buffer.size() - consumer.nLeftToReturn--];
+    }
+
     size_t nConsumersStillProcessingThisBatch =
         std::count_if(_consumers.begin(), _consumers.end(), [](const ConsumerInfo& info) {
             return info.nLeftToReturn > 0;
@@ -75,6 +84,27 @@ DocumentSource::GetNextResult TeeBuffer::getNext(size_t consumerId) {
     return _buffer[bufferIndex];
 }
 
+void TeeBuffer::loadNextBatchForConcurrentConsumers() {
+    invariant(_concurrentConsumers);
+    if (_exhausted) {
+        return;
+    }
+
+    if (std::none_of(_consumers.begin(), _consumers.end(), [](const ConsumerInfo& info) {
+            return info.stillInUse;
+        })) {
+        _buffer.clear();
+        _exhausted = true;
+        if (_source) {
+            _source->dispose();
+        }
+        return;
+    }
+
+    loadNextBatch();
+    _exhausted = _buffer.empty();
+}
+
 void TeeBuffer::loadNextBatch() {
     _buffer.clear();
     size_t bytesInBuffer = 0;
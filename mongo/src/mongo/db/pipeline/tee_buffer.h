@@ -65,6 +65,11 @@ public:
     void dispose(size_t consumerId) {
         _consumers[consumerId].stillInUse = false;
         _consumers[consumerId].nLeftToReturn = 0;
+        if (_concurrentConsumers) {
+            // Other consumers may be reading the batch right now. The buffer and the source are
+            // released by the next call to loadNextBatchForConcurrentConsumers() instead.
+            return;
+        }
         if (std::none_of(_consumers.begin(), _consumers.end(), [](const ConsumerInfo& info) {
                 return info.stillInUse;
             })) {
@@ -82,6 +87,26 @@ public:
      */
     DocumentSource::GetNextResult getNext(size_t consumerId);
 
+    /**
+     * Switches this buffer to serving consumers which run concurrently on different threads. In
+     * this mode getNext() never loads input itself. Instead, a single coordinating thread calls
+     * loadNextBatchForConcurrentConsumers() once every consumer has paused on the current batch.
+     * While the consumers run they only read the batch and update their own position, so no
+     * locking is needed, and at most one batch is ever buffered.
+     *
+     * Must be called before any consumer has requested a document.
+     */
+    void enableConcurrentConsumers() {
+        _concurrentConsumers = true;
+    }
+
+    /**
+     * Replaces the current batch with the next one from '_source'. Must only be called in
+     * concurrent mode, while no consumer is running. Once the input is exhausted, or no consumer
+     * is still in use, all consumers will see EOF.
+     */
+    void loadNextBatchForConcurrentConsumers();
+
 private:
     TeeBuffer(size_t nConsumers, size_t bufferSizeBytes);
 
@@ -102,5 +127,10 @@ private:
         int nLeftToReturn = 0;
     };
     std::vector<ConsumerInfo> _consumers;
+
+    bool _concurrentConsumers = false;
+
+    // Only used in concurrent mode: whether the last load found no more input.
+    bool _exhausted = false;
 };
 }  // namespace mongo
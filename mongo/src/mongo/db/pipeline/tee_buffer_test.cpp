@@ -166,5 +166,62 @@ TEST(TeeBufferTest, ShouldAllowOtherConsumersToAdvanceOnceTrailingConsumerIsDisp
     ASSERT_TRUE(teeBuffer->getNext(0).isEOF());
     ASSERT_TRUE(teeBuffer->getNext(0).isEOF());
 }
+
+TEST(TeeBufferTest, ConcurrentConsumersShouldOnlyAdvanceWhenNextBatchIsLoadedExplicitly) {
+    std::deque<DocumentSource::GetNextResult> inputs{Document{{"a", 1}}, Document{{"a", 2}}};
+    auto mock = DocumentSourceMock::create(inputs);
+
+    const size_t nConsumers = 2;
+    const size_t bufferBytes = 1;  // Both docs won't fit in a single batch.
+    auto teeBuffer = TeeBuffer::create(nConsumers, bufferBytes);
+    teeBuffer->setSource(mock.get());
+    teeBuffer->enableConcurrentConsumers();
+
+    // Nothing has been loaded yet, and consumers never load by themselves.
+    ASSERT_TRUE(teeBuffer->getNext(0).isPaused());
+
+    teeBuffer->loadNextBatchForConcurrentConsumers();
+    for (size_t consumerId = 0; consumerId < nConsumers; ++consumerId) {
+        auto next = teeBuffer->getNext(consumerId);
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_DOCUMENT_EQ(next.getDocument(), inputs.front().getDocument());
+        ASSERT_TRUE(teeBuffer->getNext(consumerId).isPaused());
+    }
+
+    teeBuffer->loadNextBatchForConcurrentConsumers();
+    for (size_t consumerId = 0; consumerId < nConsumers; ++consumerId) {
+        auto next = teeBuffer->getNext(consumerId);
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_DOCUMENT_EQ(next.getDocument(), inputs.back().getDocument());
+        ASSERT_TRUE(teeBuffer->getNext(consumerId).isPaused());
+    }
+
+    teeBuffer->loadNextBatchForConcurrentConsumers();
+    ASSERT_TRUE(teeBuffer->getNext(0).isEOF());
+    ASSERT_TRUE(teeBuffer->getNext(1).isEOF());
+}
+
+TEST(TeeBufferTest, ConcurrentConsumersShouldDisposeSourceOnLoadOnceAllConsumersAreDisposed) {
+    std::deque<DocumentSource::GetNextResult> inputs{Document{{"a", 1}}, Document{{"a", 2}}};
+    auto mock = DocumentSourceMock::create(inputs);
+
+    const size_t nConsumers = 2;
+    const size_t bufferBytes = 1;
+    auto teeBuffer = TeeBuffer::create(nConsumers, bufferBytes);
+    teeBuffer->setSource(mock.get());
+    teeBuffer->enableConcurrentConsumers();
+
+    teeBuffer->loadNextBatchForConcurrentConsumers();
+    teeBuffer->dispose(0);
+    teeBuffer->dispose(1);
+
+    // Disposing must not touch the buffer or the source while other consumers may be running.
+    ASSERT_FALSE(mock->isDisposed);
+
+    teeBuffer->loadNextBatchForConcurrentConsumers();
+    ASSERT_TRUE(mock->isDisposed);
+    ASSERT_TRUE(teeBuffer->getNext(0).isEOF());
+    ASSERT_TRUE(teeBuffer->getNext(1).isEOF());
+}
 }  // namespace
 }  // namespace mongo
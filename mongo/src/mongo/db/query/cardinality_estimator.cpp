@@ -0,0 +1,199 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/cardinality_estimator.h"
+
+#include <algorithm>
+
+#include "mongo/db/index_names.h"
+
+namespace mongo {
+
+namespace {
+
+bool isAllValues(const OrderedIntervalList& oil) {
+    if (oil.intervals.size() != 1) {
+        return false;
+    }
+    const Interval& interval = oil.intervals[0];
+    return (interval.start.type() == MinKey && interval.end.type() == MaxKey) ||
+        (interval.start.type() == MaxKey && interval.end.type() == MinKey);
+}
+
+/**
+ * Estimated number of keys examined by 'node', or a negative number if the index cannot be
+ * estimated. The bounds on the leading field of the index are estimated from its histogram. Each
+ * constrained trailing field scales that estimate by its own selectivity, assuming the fields are
+ * independent, since the scan seeks past keys outside the trailing bounds.
+ */
+double estimateIndexScan(IndexScanNode* node, const CollectionStatistics& stats, double scale) {
+    // Keys of other access methods and of indexes with a collation are not ordered like the
+    // sampled values. A skip scan examines far fewer keys than its leading field bounds suggest.
+    if (INDEX_BTREE != node->index.type || node->index.collator || node->skipScan) {
+        return -1;
+    }
+
+    BSONElement leadingField = node->index.keyPattern.firstElement();
+    if (leadingField.eoo()) {
+        return -1;
+    }
+
+    const Histogram* histogram = stats.getHistogram(leadingField.fieldNameStringData());
+    if (!histogram) {
+        return -1;
+    }
+
+    double keys = 0;
+    if (node->bounds.isSimpleRange) {
+        // The start and end keys of a compound index do not bound the trailing fields separately.
+        if (node->index.keyPattern.nFields() > 1) {
+            return -1;
+        }
+
+        BSONElement start = node->bounds.startKey.firstElement();
+        BSONElement end = node->bounds.endKey.firstElement();
+        if (start.eoo() || end.eoo()) {
+            return -1;
+        }
+
+        BSONObjBuilder bob;
+        bob.appendAs(start, "");
+        bob.appendAs(end, "");
+        keys = histogram->estimateInterval(Interval(bob.obj(), true, true));
+    } else {
+        if (node->bounds.fields.empty()) {
+            return -1;
+        }
+
+        for (auto&& interval : node->bounds.fields[0].intervals) {
+            keys += histogram->estimateInterval(interval);
+        }
+
+        for (size_t i = 1; i < node->bounds.fields.size(); ++i) {
+            const OrderedIntervalList& oil = node->bounds.fields[i];
+            if (isAllValues(oil)) {
+                continue;
+            }
+
+            const Histogram* trailingHistogram = stats.getHistogram(oil.name);
+            if (!trailingHistogram || trailingHistogram->totalCount() <= 0) {
+                return -1;
+            }
+
+            double matching = 0;
+            for (auto&& interval : oil.intervals) {
+                matching += trailingHistogram->estimateInterval(interval);
+            }
+            keys *= std::min(1.0, matching / trailingHistogram->totalCount());
+        }
+    }
+
+    keys *= scale;
+    node->estimatedKeys = static_cast<long long>(keys + 0.5);
+    return keys;
+}
+
+double estimateNode(QuerySolutionNode* node,
+                    const CollectionStatistics& stats,
+                    double numRecords,
+                    double scale) {
+    switch (node->getType()) {
+        case STAGE_IXSCAN:
+            return estimateIndexScan(static_cast<IndexScanNode*>(node), stats, scale);
+        case STAGE_COLLSCAN:
+            return numRecords;
+        default:
+            break;
+    }
+
+    // Any other leaf, such as a geo or text stage, is beyond what the histograms can tell us.
+    if (node->children.empty()) {
+        return -1;
+    }
+
+    double total = 0;
+    for (auto&& child : node->children) {
+        double childEstimate = estimateNode(child, stats, numRecords, scale);
+        if (childEstimate < 0) {
+            return -1;
+        }
+        total += childEstimate;
+    }
+    return total;
+}
+
+}  // namespace
+
+double CardinalityEstimator::estimate(QuerySolution* solution,
+                                      const CollectionStatistics& stats,
+                                      long long numRecords) {
+    if (!solution->root) {
+        return -1;
+    }
+
+    return estimateSubtree(solution->root.get(), stats, numRecords);
+}
+
+double CardinalityEstimator::estimateSubtree(QuerySolutionNode* node,
+                                             const CollectionStatistics& stats,
+                                             long long numRecords) {
+    // Histogram counts were scaled to the size of the collection when it was analyzed. Assume the
+    // distribution has not changed since, only the size.
+    double scale = 1.0;
+    if (stats.numRecords > 0) {
+        scale = static_cast<double>(numRecords) / stats.numRecords;
+    }
+
+    return estimateNode(node, stats, numRecords, scale);
+}
+
+std::vector<bool> CardinalityEstimator::selectCandidates(const std::vector<double>& estimates,
+                                                         double ratio) {
+    std::vector<bool> keep(estimates.size(), true);
+    if (ratio <= 0 || estimates.size() < 2) {
+        return keep;
+    }
+
+    if (std::any_of(estimates.begin(), estimates.end(), [](double e) { return e < 0; })) {
+        return keep;
+    }
+
+    // Guard against a best estimate of zero keys, which would otherwise prune every plan that is
+    // expected to examine even a single key.
+    const double best = *std::min_element(estimates.begin(), estimates.end());
+    const double cutoff = std::max(best, 1.0) * ratio;
+    for (size_t i = 0; i < estimates.size(); ++i) {
+        keep[i] = estimates[i] <= cutoff;
+    }
+    return keep;
+}
+
+}  // namespace mongo
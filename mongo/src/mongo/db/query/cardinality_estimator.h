@@ -0,0 +1,74 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/query/collection_statistics.h"
+#include "mongo/db/query/query_solution.h"
+
+namespace mongo {
+
+/**
+ * Uses the histograms gathered by the analyze command to estimate how much work candidate query
+ * solutions will do, so that plans which are clearly worse than another can be dropped before
+ * multi-planning.
+ *
+ * The cost of a solution is the estimated number of index keys examined by its index scans plus
+ * the number of documents examined by its collection scans. Only the leading field of each index
+ * is used, so the estimate of a compound index scan is an upper bound.
+ */
+class CardinalityEstimator {
+public:
+    /**
+     * Returns the estimated cost of 'solution' over a collection which currently holds
+     * 'numRecords' documents, or a negative number if some leaf of the solution cannot be
+     * estimated from 'stats'. Records the estimate of each index scan in its 'estimatedKeys'.
+     */
+    static double estimate(QuerySolution* solution,
+                           const CollectionStatistics& stats,
+                           long long numRecords);
+
+    /**
+     * Like estimate(), but for the subtree rooted at 'node' rather than a whole solution.
+     */
+    static double estimateSubtree(QuerySolutionNode* node,
+                                  const CollectionStatistics& stats,
+                                  long long numRecords);
+
+    /**
+     * Given the estimated costs of a set of candidate solutions, returns which of them are worth
+     * multi-planning: every solution whose cost is within 'ratio' times that of the cheapest one.
+     * Keeps every solution if any cost is unknown or if 'ratio' is not positive.
+     */
+    static std::vector<bool> selectCandidates(const std::vector<double>& estimates, double ratio);
+};
+
+}  // namespace mongo
@@ -0,0 +1,278 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/cardinality_estimator.h"
+
+#include "mongo/bson/json.h"
+#include "mongo/db/query/collection_statistics.h"
+#include "mongo/db/query/histogram.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+std::vector<BSONObj> valuesFromInts(const std::vector<int>& ints) {
+    std::vector<BSONObj> values;
+    for (int i : ints) {
+        values.push_back(BSON("" << i));
+    }
+    return values;
+}
+
+Interval makeInterval(const BSONObj& bounds, bool startInclusive, bool endInclusive) {
+    return Interval(bounds, startInclusive, endInclusive);
+}
+
+// Builds a histogram over 0, 1, ..., 999 plus 'extraSevens' additional copies of 7.
+Histogram buildTestHistogram(size_t numBuckets, int extraSevens, double scale = 1.0) {
+    std::vector<int> ints;
+    for (int i = 0; i < 1000; ++i) {
+        ints.push_back(i);
+    }
+    for (int i = 0; i < extraSevens; ++i) {
+        ints.push_back(7);
+    }
+    auto values = valuesFromInts(ints);
+    return Histogram::build(&values, numBuckets, scale);
+}
+
+TEST(HistogramTest, EmptySampleProducesEmptyHistogram) {
+    std::vector<BSONObj> values;
+    Histogram histogram = Histogram::build(&values, 10, 1.0);
+    ASSERT_EQ(0U, histogram.buckets().size());
+    ASSERT_EQ(0, histogram.totalCount());
+    ASSERT_EQ(0, histogram.estimateEqual(BSON("" << 1).firstElement()));
+}
+
+TEST(HistogramTest, BucketsAreEquiDepth) {
+    Histogram histogram = buildTestHistogram(10, 0);
+    ASSERT_EQ(10U, histogram.buckets().size());
+    ASSERT_EQ(1000, histogram.totalCount());
+    for (auto&& bucket : histogram.buckets()) {
+        ASSERT_EQ(100, bucket.rangeCount + bucket.equalCount);
+    }
+}
+
+TEST(HistogramTest, EstimatesRangesOfUniformValues) {
+    Histogram histogram = buildTestHistogram(10, 0);
+    ASSERT_APPROX_EQUAL(
+        100, histogram.estimateInterval(makeInterval(BSON("" << 0 << "" << 99), true, true)), 2);
+    ASSERT_APPROX_EQUAL(
+        250, histogram.estimateInterval(makeInterval(BSON("" << 500 << "" << 750), true, false)), 2);
+    ASSERT_APPROX_EQUAL(
+        1000,
+        histogram.estimateInterval(makeInterval(BSON("" << MINKEY << "" << MAXKEY), true, true)),
+        0.001);
+    ASSERT_EQ(0,
+              histogram.estimateInterval(makeInterval(BSON("" << 2000 << "" << 3000), true, true)));
+}
+
+TEST(HistogramTest, EstimatesReversedIntervals) {
+    Histogram histogram = buildTestHistogram(10, 0);
+    ASSERT_APPROX_EQUAL(
+        histogram.estimateInterval(makeInterval(BSON("" << 200 << "" << 400), true, true)),
+        histogram.estimateInterval(makeInterval(BSON("" << 400 << "" << 200), true, true)),
+        0.001);
+}
+
+TEST(HistogramTest, EstimatesFrequentValues) {
+    Histogram histogram = buildTestHistogram(10, 900);
+    ASSERT_APPROX_EQUAL(901, histogram.estimateEqual(BSON("" << 7).firstElement()), 0.001);
+    ASSERT_APPROX_EQUAL(1, histogram.estimateEqual(BSON("" << 500).firstElement()), 0.5);
+    ASSERT_EQ(0, histogram.estimateEqual(BSON("" << -1).firstElement()));
+}
+
+TEST(HistogramTest, ScalesSampleToCollection) {
+    Histogram histogram = buildTestHistogram(10, 0, 10.0);
+    ASSERT_EQ(10000, histogram.totalCount());
+    ASSERT_APPROX_EQUAL(
+        1000, histogram.estimateInterval(makeInterval(BSON("" << 0 << "" << 99), true, true)), 20);
+    ASSERT_GT(histogram.distinctValues(), 1000);
+}
+
+TEST(HistogramTest, SerializationRoundTrips) {
+    Histogram histogram = buildTestHistogram(16, 100);
+
+    BSONObjBuilder bob;
+    histogram.serialize(&bob);
+    auto parsed = Histogram::parse(bob.obj());
+    ASSERT_OK(parsed.getStatus());
+
+    ASSERT_EQ(histogram.buckets().size(), parsed.getValue().buckets().size());
+    ASSERT_EQ(histogram.totalCount(), parsed.getValue().totalCount());
+    ASSERT_EQ(histogram.distinctValues(), parsed.getValue().distinctValues());
+    Interval interval = makeInterval(BSON("" << 3 << "" << 333), true, false);
+    ASSERT_EQ(histogram.estimateInterval(interval),
+              parsed.getValue().estimateInterval(interval));
+}
+
+TEST(HistogramTest, ParseRejectsMalformedHistograms) {
+    ASSERT_NOT_OK(Histogram::parse(fromjson("{totalCount: 1}")).getStatus());
+    ASSERT_NOT_OK(
+        Histogram::parse(fromjson("{totalCount: 1, distinctValues: 1, buckets: [{rangeCount: 1}]}"))
+            .getStatus());
+    ASSERT_NOT_OK(Histogram::parse(fromjson("{totalCount: 1, distinctValues: 1, buckets: "
+                                            "[{upperBound: 1, rangeCount: 0, equalCount: 1, "
+                                            "rangeDistinct: 0}]}"))
+                      .getStatus());
+}
+
+TEST(CollectionStatisticsTest, SerializationRoundTrips) {
+    CollectionStatistics stats;
+    stats.numRecords = 1000;
+    stats.analyzedAt = Date_t::fromMillisSinceEpoch(1000);
+    stats.histograms["a"] = buildTestHistogram(8, 0);
+
+    auto parsed = CollectionStatistics::parse(stats.toBSON());
+    ASSERT_OK(parsed.getStatus());
+    ASSERT_EQ(1000, parsed.getValue().numRecords);
+    ASSERT_EQ(stats.analyzedAt, parsed.getValue().analyzedAt);
+    ASSERT(parsed.getValue().getHistogram("a"));
+    ASSERT_FALSE(parsed.getValue().getHistogram("b"));
+}
+
+std::unique_ptr<QuerySolution> makeIndexScanSolution(const BSONObj& keyPattern,
+                                                     const Interval& interval) {
+    auto ixscan = new IndexScanNode(IndexEntry(keyPattern));
+    OrderedIntervalList oil(keyPattern.firstElementFieldName());
+    oil.intervals.push_back(interval);
+    ixscan->bounds.fields.push_back(oil);
+
+    auto fetch = new FetchNode();
+    fetch->children.push_back(ixscan);
+
+    auto soln = stdx::make_unique<QuerySolution>();
+    soln->root.reset(fetch);
+    return soln;
+}
+
+IndexScanNode* getIndexScan(QuerySolution* soln) {
+    return static_cast<IndexScanNode*>(soln->root->children[0]);
+}
+
+TEST(CardinalityEstimatorTest, EstimatesIndexScanAndRecordsEstimate) {
+    CollectionStatistics stats;
+    stats.numRecords = 1000;
+    stats.histograms["a"] = buildTestHistogram(10, 0);
+
+    auto soln = makeIndexScanSolution(BSON("a" << 1),
+                                      makeInterval(BSON("" << 0 << "" << 99), true, true));
+    ASSERT_APPROX_EQUAL(100, CardinalityEstimator::estimate(soln.get(), stats, 1000), 2);
+    ASSERT_APPROX_EQUAL(100, getIndexScan(soln.get())->estimatedKeys, 2);
+
+    // The estimate follows the growth of the collection since it was analyzed.
+    ASSERT_APPROX_EQUAL(200, CardinalityEstimator::estimate(soln.get(), stats, 2000), 4);
+}
+
+TEST(CardinalityEstimatorTest, CannotEstimateWithoutHistogram) {
+    CollectionStatistics stats;
+    stats.numRecords = 1000;
+    stats.histograms["a"] = buildTestHistogram(10, 0);
+
+    auto soln = makeIndexScanSolution(BSON("b" << 1),
+                                      makeInterval(BSON("" << 0 << "" << 99), true, true));
+    ASSERT_LT(CardinalityEstimator::estimate(soln.get(), stats, 1000), 0);
+    ASSERT_LT(getIndexScan(soln.get())->estimatedKeys, 0);
+
+    auto hashed = makeIndexScanSolution(BSON("a"
+                                             << "hashed"),
+                                        makeInterval(BSON("" << 0 << "" << 99), true, true));
+    ASSERT_LT(CardinalityEstimator::estimate(hashed.get(), stats, 1000), 0);
+}
+
+TEST(CardinalityEstimatorTest, EstimatesCompoundIndexScanFromTrailingFields) {
+    CollectionStatistics stats;
+    stats.numRecords = 1000;
+    stats.histograms["a"] = buildTestHistogram(10, 0);
+    stats.histograms["b"] = buildTestHistogram(10, 0);
+
+    auto soln = makeIndexScanSolution(BSON("a" << 1 << "b" << 1),
+                                      makeInterval(BSON("" << 0 << "" << 99), true, true));
+    OrderedIntervalList oil("b");
+    oil.intervals.push_back(makeInterval(BSON("" << 0 << "" << 99), true, true));
+    getIndexScan(soln.get())->bounds.fields.push_back(oil);
+    ASSERT_APPROX_EQUAL(10, CardinalityEstimator::estimate(soln.get(), stats, 1000), 1);
+
+    // An unconstrained trailing field does not change the estimate.
+    getIndexScan(soln.get())->bounds.fields[1].intervals[0] =
+        makeInterval(BSON("" << MINKEY << "" << MAXKEY), true, true);
+    ASSERT_APPROX_EQUAL(100, CardinalityEstimator::estimate(soln.get(), stats, 1000), 2);
+
+    // A constrained trailing field without a histogram cannot be estimated.
+    auto unknown = makeIndexScanSolution(BSON("a" << 1 << "c" << 1),
+                                         makeInterval(BSON("" << 0 << "" << 99), true, true));
+    OrderedIntervalList unknownOil("c");
+    unknownOil.intervals.push_back(makeInterval(BSON("" << 5 << "" << 5), true, true));
+    getIndexScan(unknown.get())->bounds.fields.push_back(unknownOil);
+    ASSERT_LT(CardinalityEstimator::estimate(unknown.get(), stats, 1000), 0);
+}
+
+TEST(CardinalityEstimatorTest, EstimatesSubtreeOfSolution) {
+    CollectionStatistics stats;
+    stats.numRecords = 1000;
+    stats.histograms["a"] = buildTestHistogram(10, 0);
+
+    auto soln = makeIndexScanSolution(BSON("a" << 1),
+                                      makeInterval(BSON("" << 0 << "" << 99), true, true));
+    ASSERT_APPROX_EQUAL(
+        100, CardinalityEstimator::estimateSubtree(getIndexScan(soln.get()), stats, 1000), 2);
+    ASSERT_APPROX_EQUAL(
+        200, CardinalityEstimator::estimateSubtree(getIndexScan(soln.get()), stats, 2000), 4);
+}
+
+TEST(CardinalityEstimatorTest, SelectCandidatesPrunesExpensivePlans) {
+    auto keep = CardinalityEstimator::selectCandidates({5, 40, 60, 5000}, 10);
+    ASSERT_EQ(4U, keep.size());
+    ASSERT_TRUE(keep[0]);
+    ASSERT_TRUE(keep[1]);
+    ASSERT_FALSE(keep[2]);
+    ASSERT_FALSE(keep[3]);
+
+    // A best estimate of zero keys does not prune plans that examine a handful of keys.
+    keep = CardinalityEstimator::selectCandidates({0, 8, 11}, 10);
+    ASSERT_TRUE(keep[0]);
+    ASSERT_TRUE(keep[1]);
+    ASSERT_FALSE(keep[2]);
+}
+
+TEST(CardinalityEstimatorTest, SelectCandidatesKeepsAllWhenAnyEstimateUnknown) {
+    auto keep = CardinalityEstimator::selectCandidates({5, -1, 5000}, 10);
+    ASSERT_TRUE(keep[0]);
+    ASSERT_TRUE(keep[1]);
+    ASSERT_TRUE(keep[2]);
+
+    keep = CardinalityEstimator::selectCandidates({5, 5000}, 0);
+    ASSERT_TRUE(keep[0]);
+    ASSERT_TRUE(keep[1]);
+}
+
+}  // namespace
+}  // namespace mongo
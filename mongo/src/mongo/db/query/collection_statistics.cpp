@@ -0,0 +1,237 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/collection_statistics.h"
+
+#include <functional>
+
+#include "mongo/db/operation_context.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage/recovery_unit.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+namespace {
+const auto getStatisticsCatalog = ServiceContext::declareDecoration<StatisticsCatalog>();
+}  // namespace
+
+// static
+StatusWith<CollectionStatistics> CollectionStatistics::parse(const BSONObj& obj) {
+    CollectionStatistics stats;
+
+    BSONElement numRecords = obj["numRecords"];
+    BSONElement analyzedAt = obj["analyzedAt"];
+    BSONElement fields = obj["fields"];
+    if (!numRecords.isNumber() || analyzedAt.type() != Date || fields.type() != Array) {
+        return {ErrorCodes::FailedToParse,
+                str::stream() << "malformed collection statistics, expected numRecords, "
+                                 "analyzedAt and fields: "
+                              << obj};
+    }
+    stats.numRecords = numRecords.safeNumberLong();
+    stats.analyzedAt = analyzedAt.date();
+
+    for (auto&& fieldElem : fields.Obj()) {
+        if (fieldElem.type() != Object || fieldElem.Obj()["field"].type() != String ||
+            fieldElem.Obj()["histogram"].type() != Object) {
+            return {ErrorCodes::FailedToParse,
+                    str::stream() << "malformed field statistics: " << fieldElem};
+        }
+
+        auto histogram = Histogram::parse(fieldElem.Obj()["histogram"].Obj());
+        if (!histogram.isOK()) {
+            return histogram.getStatus();
+        }
+        stats.histograms[fieldElem.Obj()["field"].String()] = std::move(histogram.getValue());
+    }
+
+    return stats;
+}
+
+BSONObj CollectionStatistics::toBSON() const {
+    BSONObjBuilder builder;
+    builder.append("numRecords", numRecords);
+    builder.append("analyzedAt", analyzedAt);
+
+    // Field paths contain dots, so they are stored as values rather than as field names.
+    BSONArrayBuilder fieldsBuilder(builder.subarrayStart("fields"));
+    for (auto&& fieldAndHistogram : histograms) {
+        BSONObjBuilder fieldBuilder(fieldsBuilder.subobjStart());
+        fieldBuilder.append("field", fieldAndHistogram.first);
+        BSONObjBuilder histogramBuilder(fieldBuilder.subobjStart("histogram"));
+        fieldAndHistogram.second.serialize(&histogramBuilder);
+    }
+    fieldsBuilder.doneFast();
+    return builder.obj();
+}
+
+const Histogram* CollectionStatistics::getHistogram(StringData field) const {
+    auto it = histograms.find(field.toString());
+    return it == histograms.end() ? nullptr : &it->second;
+}
+
+const StringData StatisticsCatalog::kCollectionName = "system.statistics"_sd;
+
+// static
+StatisticsCatalog* StatisticsCatalog::get(ServiceContext* service) {
+    return &getStatisticsCatalog(service);
+}
+
+// static
+StatisticsCatalog* StatisticsCatalog::get(OperationContext* opCtx) {
+    return get(opCtx->getServiceContext());
+}
+
+// static
+NamespaceString StatisticsCatalog::statisticsNamespace(StringData dbName) {
+    return NamespaceString(dbName, kCollectionName);
+}
+
+// static
+unsigned long long StatisticsCatalog::_hash(const NamespaceString& nss) {
+    const unsigned long long hash = std::hash<std::string>()(nss.ns());
+    return hash ? hash : 1;
+}
+
+bool StatisticsCatalog::knownToHaveNoStatistics(const NamespaceString& nss) const {
+    const unsigned long long hash = _hash(nss);
+    return _noStatistics[hash % kNumNoStatisticsSlots].load() == hash;
+}
+
+bool StatisticsCatalog::lookup(const NamespaceString& nss,
+                               std::shared_ptr<const CollectionStatistics>* stats,
+                               long long* modifications,
+                               unsigned long long* epoch) const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    auto it = _entries.find(nss.ns());
+    if (it == _entries.end()) {
+        *epoch = _epoch;
+        return false;
+    }
+    *stats = it->second.stats;
+    *modifications = _writeCounterFor(nss).load() - it->second.writesAtSet;
+    return true;
+}
+
+void StatisticsCatalog::set(const NamespaceString& nss,
+                            std::shared_ptr<const CollectionStatistics> stats) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _setInLock(lk, nss, std::move(stats));
+}
+
+void StatisticsCatalog::setLoaded(const NamespaceString& nss,
+                                  std::shared_ptr<const CollectionStatistics> stats,
+                                  unsigned long long epoch) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    if (epoch != _epoch) {
+        return;
+    }
+    _setInLock(lk, nss, std::move(stats));
+}
+
+void StatisticsCatalog::_setInLock(WithLock,
+                                   const NamespaceString& nss,
+                                   std::shared_ptr<const CollectionStatistics> stats) {
+    Entry& entry = _entries[nss.ns()];
+    if (entry.stats) {
+        _numWithStatistics.subtractAndFetch(1);
+    }
+    if (stats) {
+        _numWithStatistics.addAndFetch(1);
+    }
+    entry.stats = std::move(stats);
+    entry.writesAtSet = _writeCounterFor(nss).load();
+
+    // A slot remembers one collection at a time; another one hashing to it is looked up as usual.
+    const unsigned long long hash = _hash(nss);
+    AtomicUInt64& slot = _noStatistics[hash % kNumNoStatisticsSlots];
+    if (!entry.stats) {
+        slot.store(hash);
+    } else if (slot.load() == hash) {
+        slot.store(0);
+    }
+}
+
+void StatisticsCatalog::_eraseInLock(WithLock, std::map<std::string, Entry>::iterator it) {
+    if (it->second.stats) {
+        _numWithStatistics.subtractAndFetch(1);
+    }
+    const unsigned long long hash = _hash(NamespaceString(it->first));
+    AtomicUInt64& slot = _noStatistics[hash % kNumNoStatisticsSlots];
+    if (slot.load() == hash) {
+        slot.store(0);
+    }
+    _entries.erase(it);
+}
+
+void StatisticsCatalog::noteWrites(OperationContext* opCtx,
+                                   const NamespaceString& nss,
+                                   long long numWrites) {
+    if (_numWithStatistics.load() == 0) {
+        return;
+    }
+
+    AtomicInt64* counter = &_writeCounterFor(nss);
+    opCtx->recoveryUnit()->onCommit([counter, numWrites] { counter->fetchAndAdd(numWrites); });
+}
+
+AtomicInt64& StatisticsCatalog::_writeCounterFor(const NamespaceString& nss) {
+    return _writeCounters[std::hash<std::string>()(nss.ns()) % kNumWriteCounters];
+}
+
+const AtomicInt64& StatisticsCatalog::_writeCounterFor(const NamespaceString& nss) const {
+    return _writeCounters[std::hash<std::string>()(nss.ns()) % kNumWriteCounters];
+}
+
+void StatisticsCatalog::invalidate(const NamespaceString& nss) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    ++_epoch;
+    auto it = _entries.find(nss.ns());
+    if (it == _entries.end()) {
+        return;
+    }
+    _eraseInLock(lk, it);
+}
+
+void StatisticsCatalog::invalidateDatabase(StringData dbName) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    ++_epoch;
+    for (auto it = _entries.begin(); it != _entries.end();) {
+        if (nsToDatabaseSubstring(it->first) != dbName) {
+            ++it;
+            continue;
+        }
+        _eraseInLock(lk, it++);
+    }
+}
+
+}  // namespace mongo
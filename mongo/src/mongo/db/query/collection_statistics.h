@@ -0,0 +1,178 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status_with.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/query/histogram.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+class OperationContext;
+class ServiceContext;
+
+/**
+ * The statistics gathered for one collection by the analyze command: a histogram per analyzed
+ * field, and the size of the collection at the time.
+ *
+ * They are persisted as one document per collection in <db>.system.statistics, with the
+ * collection name as _id.
+ */
+struct CollectionStatistics {
+    static StatusWith<CollectionStatistics> parse(const BSONObj& obj);
+
+    BSONObj toBSON() const;
+
+    /**
+     * Returns the histogram for 'field', or nullptr if the field was not analyzed.
+     */
+    const Histogram* getHistogram(StringData field) const;
+
+    long long numRecords = 0;
+    Date_t analyzedAt;
+    std::map<std::string, Histogram> histograms;
+};
+
+/**
+ * In-memory cache of the statistics of every collection that has been planned for, decorating
+ * the ServiceContext.
+ *
+ * Entries are filled lazily from <db>.system.statistics by the query planner and dropped when
+ * that collection changes, including through replication. The catalog also counts the committed
+ * writes to each collection since its statistics were cached, so that stale statistics can be
+ * ignored. Writes are counted in a fixed array of atomic counters indexed by a hash of the
+ * namespace, so they never take '_mutex'. Collections sharing a counter see each other's writes,
+ * which can only make their statistics look stale sooner.
+ *
+ * Most collections are never analyzed, so the catalog also remembers, in a fixed array of slots
+ * indexed by a hash of the namespace, the collections it has found to have no statistics. Queries
+ * against them check their slot instead of taking '_mutex'.
+ */
+class StatisticsCatalog {
+    MONGO_DISALLOW_COPYING(StatisticsCatalog);
+
+public:
+    static const StringData kCollectionName;
+
+    StatisticsCatalog() = default;
+
+    static StatisticsCatalog* get(ServiceContext* service);
+    static StatisticsCatalog* get(OperationContext* opCtx);
+
+    static NamespaceString statisticsNamespace(StringData dbName);
+
+    /**
+     * Returns true if 'nss' is known to have no statistics. Does not take '_mutex'.
+     */
+    bool knownToHaveNoStatistics(const NamespaceString& nss) const;
+
+    /**
+     * Looks up the statistics of 'nss'. Returns false if the catalog does not know about 'nss',
+     * in which case the caller should load them and pass them to setLoaded() along with
+     * '*epoch'. Otherwise sets '*stats', to nullptr if the collection has no statistics, and
+     * '*modifications' to the number of writes to the collection since.
+     */
+    bool lookup(const NamespaceString& nss,
+                std::shared_ptr<const CollectionStatistics>* stats,
+                long long* modifications,
+                unsigned long long* epoch) const;
+
+    /**
+     * Caches 'stats' for 'nss', which may be nullptr to remember that it has no statistics.
+     */
+    void set(const NamespaceString& nss, std::shared_ptr<const CollectionStatistics> stats);
+
+    /**
+     * Caches 'stats', loaded after lookup() returned 'epoch', unless an entry has been invalidated
+     * since. The statistics may then have been read before the change that invalidated them.
+     */
+    void setLoaded(const NamespaceString& nss,
+                   std::shared_ptr<const CollectionStatistics> stats,
+                   unsigned long long epoch);
+
+    /**
+     * Counts 'numWrites' writes to 'nss' once the storage transaction of 'opCtx' commits.
+     */
+    void noteWrites(OperationContext* opCtx, const NamespaceString& nss, long long numWrites);
+
+    void invalidate(const NamespaceString& nss);
+    void invalidateDatabase(StringData dbName);
+
+private:
+    static const size_t kNumWriteCounters = 1024;
+    static const size_t kNumNoStatisticsSlots = 1024;
+
+    struct Entry {
+        std::shared_ptr<const CollectionStatistics> stats;
+        // The value of the collection's write counter when 'stats' were cached.
+        long long writesAtSet = 0;
+    };
+
+    AtomicInt64& _writeCounterFor(const NamespaceString& nss);
+    const AtomicInt64& _writeCounterFor(const NamespaceString& nss) const;
+
+    /**
+     * Returns a non-zero hash of 'nss', which is what its slot in '_noStatistics' holds while it
+     * is known to have no statistics.
+     */
+    static unsigned long long _hash(const NamespaceString& nss);
+
+    void _setInLock(WithLock,
+                    const NamespaceString& nss,
+                    std::shared_ptr<const CollectionStatistics> stats);
+    void _eraseInLock(WithLock, std::map<std::string, Entry>::iterator it);
+
+    mutable stdx::mutex _mutex;
+    std::map<std::string, Entry> _entries;
+
+    // Incremented by every invalidation.
+    unsigned long long _epoch = 0;
+
+    // Written under '_mutex', read without it.
+    AtomicUInt64 _noStatistics[kNumNoStatisticsSlots];
+
+    AtomicInt64 _writeCounters[kNumWriteCounters];
+
+    // How many entries have statistics. Writes to other collections check this instead of taking
+    // '_mutex'.
+    AtomicInt64 _numWithStatistics;
+};
+
+}  // namespace mongo
@@ -154,6 +154,9 @@ size_t getDocsExamined(StageType type, const SpecificStats* specific) {
     if (STAGE_COLLSCAN == type) {
         const CollectionScanStats* spec = static_cast<const CollectionScanStats*>(specific);
         return spec->docsTested;
+    } else if (STAGE_COLUMN_SCAN == type) {
+        const ColumnScanStats* spec = static_cast<const ColumnScanStats*>(specific);
+        return spec->docsTested;
     } else if (STAGE_FETCH == type) {
         const FetchStats* spec = static_cast<const FetchStats*>(specific);
         return spec->docsExamined;
@@ -369,6 +372,20 @@ void Explain::statsToBSON(const PlanStageStats& stats,
                                   spec->mapAfterChild[i]);
             }
         }
+    } else if (STAGE_AND_BITMAP == stats.stageType) {
+        AndBitmapStats* spec = static_cast<AndBitmapStats*>(stats.specific.get());
+
+        if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
+            bob->appendNumber("memUsage", spec->memUsage);
+            bob->appendNumber("memLimit", spec->memLimit);
+
+            bob->appendNumber("flaggedButPassed", spec->flaggedButPassed);
+            bob->appendNumber("flaggedInProgress", spec->flaggedInProgress);
+            for (size_t i = 0; i < spec->bitmapAfterChild.size(); ++i) {
+                bob->appendNumber(string(stream() << "bitmapAfterChild_" << i),
+                                  spec->bitmapAfterChild[i]);
+            }
+        }
     } else if (STAGE_AND_SORTED == stats.stageType) {
         AndSortedStats* spec = static_cast<AndSortedStats*>(stats.specific.get());
 
@@ -387,6 +404,12 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("docsExamined", spec->docsTested);
         }
+    } else if (STAGE_COLUMN_SCAN == stats.stageType) {
+        ColumnScanStats* spec = static_cast<ColumnScanStats*>(stats.specific.get());
+        bob->append("fields", spec->fields);
+        if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
+            bob->appendNumber("docsExamined", spec->docsTested);
+        }
     } else if (STAGE_COUNT == stats.stageType) {
         CountStats* spec = static_cast<CountStats*>(stats.specific.get());
 
@@ -399,6 +422,9 @@ void Explain::statsToBSON(const PlanStageStats& stats,
 
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("keysExamined", spec->keysExamined);
+            if (!spec->indexBounds.isEmpty()) {
+                bob->appendNumber("seeks", spec->seeks);
+            }
         }
 
         bob->append("keyPattern", spec->keyPattern);
@@ -415,12 +441,17 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         bob->appendBool("isPartial", spec->isPartial);
         bob->append("indexVersion", spec->indexVersion);
 
-        BSONObjBuilder indexBoundsBob;
-        indexBoundsBob.append("startKey", spec->startKey);
-        indexBoundsBob.append("startKeyInclusive", spec->startKeyInclusive);
-        indexBoundsBob.append("endKey", spec->endKey);
-        indexBoundsBob.append("endKeyInclusive", spec->endKeyInclusive);
-        bob->append("indexBounds", indexBoundsBob.obj());
+        if (!spec->indexBounds.isEmpty()) {
+            // A multi-interval count scan reports its bounds the way IXSCAN does.
+            bob->append("indexBounds", spec->indexBounds);
+        } else {
+            BSONObjBuilder indexBoundsBob;
+            indexBoundsBob.append("startKey", spec->startKey);
+            indexBoundsBob.append("startKeyInclusive", spec->startKeyInclusive);
+            indexBoundsBob.append("endKey", spec->endKey);
+            indexBoundsBob.append("endKeyInclusive", spec->endKeyInclusive);
+            bob->append("indexBounds", indexBoundsBob.obj());
+        }
     } else if (STAGE_DELETE == stats.stageType) {
         DeleteStats* spec = static_cast<DeleteStats*>(stats.specific.get());
 
@@ -523,6 +554,14 @@ void Explain::statsToBSON(const PlanStageStats& stats,
             bob->append("indexBounds", spec->indexBounds);
         }
 
+        if (spec->estimatedKeys >= 0) {
+            bob->appendNumber("estimatedKeysExamined", spec->estimatedKeys);
+        }
+
+        if (spec->skipScan) {
+            bob->appendBool("skipScan", true);
+        }
+
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("keysExamined", spec->keysExamined);
             bob->appendNumber("seeks", spec->seeks);
@@ -560,6 +599,12 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("memUsage", spec->memUsage);
             bob->appendNumber("memLimit", spec->memLimit);
+            if (spec->spills > 0) {
+                bob->appendBool("usedDisk", true);
+                bob->appendNumber("spills", spec->spills);
+                bob->appendNumber("spilledRecords", spec->spilledRecords);
+                bob->appendNumber("spilledBytes", spec->spilledBytes);
+            }
         }
 
         if (spec->limit > 0) {
@@ -844,6 +889,15 @@ void Explain::explainStages(PlanExecutor* exec,
             durationCount<Milliseconds>(CurOp::get(opCtx)->elapsedTimeTotal());
         generateExecStats(winningStats.get(), verbosity, &execBob, totalTimeMillis);
 
+        // Report how the multi-planner spent its trial period.
+        if (mps) {
+            const MultiPlanStats* mpsStats =
+                static_cast<const MultiPlanStats*>(mps->getSpecificStats());
+            execBob.appendNumber("planningTimeMicros", mpsStats->planningTimeMicros);
+            execBob.appendNumber("candidatePlans", mpsStats->numCandidates);
+            execBob.appendNumber("discardedPlans", mpsStats->numDiscarded);
+        }
+
         // Also generate exec stats for all plans, if the verbosity level is high enough.
         // These stats reflect what happened during the trial period that ranked the plans.
         if (verbosity >= ExplainOptions::Verbosity::kExecAllPlans) {
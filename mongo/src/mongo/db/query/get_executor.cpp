@@ -32,6 +32,7 @@
 
 #include "mongo/db/query/get_executor.h"
 
+#include <algorithm>
 #include <boost/optional.hpp>
 #include <limits>
 #include <memory>
@@ -39,7 +40,10 @@
 #include "mongo/base/error_codes.h"
 #include "mongo/base/parse_number.h"
 #include "mongo/client/dbclientinterface.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/exec/cached_plan.h"
 #include "mongo/db/exec/count.h"
 #include "mongo/db/exec/delete.h"
@@ -53,13 +57,16 @@
 #include "mongo/db/exec/sort_key_generator.h"
 #include "mongo/db/exec/subplan.h"
 #include "mongo/db/exec/update.h"
+#include "mongo/db/index/index_access_method.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/index_names.h"
 #include "mongo/db/matcher/extensions_callback_noop.h"
 #include "mongo/db/matcher/extensions_callback_real.h"
 #include "mongo/db/ops/update_lifecycle.h"
 #include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/cardinality_estimator.h"
 #include "mongo/db/query/collation/collator_factory_interface.h"
+#include "mongo/db/query/collection_statistics.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/db/query/internal_plans.h"
@@ -206,6 +213,11 @@ void fillOutPlannerParams(OperationContext* opCtx,
         plannerParams->options |= QueryPlannerParams::GENERATE_COVERED_IXSCANS;
     }
 
+    if ((plannerParams->options & QueryPlannerParams::USE_COLUMN_STORE) &&
+        internalQueryPlannerEnableColumnScan.load()) {
+        plannerParams->columnStoreFields = collection->getRecordStore()->getColumnStoreFields();
+    }
+
     plannerParams->options |= QueryPlannerParams::SPLIT_LIMITED_SORT;
 
     // Doc-level locking storage engines cannot answer predicates implicitly via exact index
@@ -247,6 +259,258 @@ struct PrepareExecutionResult {
     unique_ptr<PlanStage> root;  
 };
 
+/**
+ * Reads the statistics of 'nss' from <db>.system.statistics. Returns nullptr if the collection
+ * has not been analyzed.
+ */
+std::shared_ptr<const CollectionStatistics> loadCollectionStatistics(OperationContext* opCtx,
+                                                                     const NamespaceString& nss) {
+    const NamespaceString statsNss = StatisticsCatalog::statisticsNamespace(nss.db());
+    Lock::CollectionLock statsLock(opCtx->lockState(), statsNss.ns(), MODE_IS);
+
+    Database* db = dbHolder().get(opCtx, nss.db());
+    Collection* statsColl = db ? db->getCollection(opCtx, statsNss) : nullptr;
+    if (!statsColl) {
+        return nullptr;
+    }
+
+    IndexCatalog* indexCatalog = statsColl->getIndexCatalog();
+    const IndexDescriptor* idIndex = indexCatalog->findIdIndex(opCtx);
+    if (!idIndex) {
+        return nullptr;
+    }
+
+    RecordId rid = indexCatalog->getIndex(idIndex)->findSingle(opCtx, BSON("_id" << nss.coll()));
+    if (rid.isNull()) {
+        return nullptr;
+    }
+
+    auto parsed = CollectionStatistics::parse(statsColl->docFor(opCtx, rid).value());
+    if (!parsed.isOK()) {
+        warning() << "Ignoring invalid statistics for " << nss.ns() << ": " << parsed.getStatus();
+        return nullptr;
+    }
+    return std::make_shared<const CollectionStatistics>(std::move(parsed.getValue()));
+}
+
+/**
+ * Returns the statistics gathered for 'collection' by the analyze command, or nullptr if there
+ * are none or if the collection has changed too much since they were gathered.
+ */
+std::shared_ptr<const CollectionStatistics> getCollectionStatistics(OperationContext* opCtx,
+                                                                    Collection* collection) {
+    StatisticsCatalog* catalog = StatisticsCatalog::get(opCtx);
+    const NamespaceString& nss = collection->ns();
+    if (catalog->knownToHaveNoStatistics(nss)) {
+        return nullptr;
+    }
+
+    std::shared_ptr<const CollectionStatistics> stats;
+    long long modifications = 0;
+    unsigned long long epoch = 0;
+    if (!catalog->lookup(nss, &stats, &modifications, &epoch)) {
+        stats = loadCollectionStatistics(opCtx, nss);
+        catalog->setLoaded(nss, stats, epoch);
+    }
+
+    if (!stats) {
+        return nullptr;
+    }
+
+    // Writes are only counted while the statistics are cached, so also compare the sizes to catch
+    // changes made before they were loaded.
+    const double staleThreshold = internalQueryStatsStaleFraction.load() * stats->numRecords;
+    const long long sizeChange =
+        std::abs(static_cast<long long>(collection->numRecords(opCtx)) - stats->numRecords);
+    if (modifications > staleThreshold || sizeChange > staleThreshold) {
+        return nullptr;
+    }
+    return stats;
+}
+
+/**
+ * Looks up the statistics of a collection the first time a planning step asks for them, so that
+ * planning a query consults the StatisticsCatalog at most once.
+ */
+class LazyCollectionStatistics {
+public:
+    LazyCollectionStatistics(OperationContext* opCtx, Collection* collection)
+        : _opCtx(opCtx), _collection(collection) {}
+
+    const CollectionStatistics* get() {
+        if (!_lookedUp) {
+            _stats = getCollectionStatistics(_opCtx, _collection);
+            _lookedUp = true;
+        }
+        return _stats.get();
+    }
+
+private:
+    OperationContext* const _opCtx;
+    Collection* const _collection;
+    bool _lookedUp = false;
+    std::shared_ptr<const CollectionStatistics> _stats;
+};
+
+/**
+ * Lists in 'plannerParams' the compound indexes whose leading field the collection statistics
+ * estimate to have few enough distinct values for a skip scan over them to be worth considering.
+ */
+void fillOutSkipScanIndexes(LazyCollectionStatistics* statistics,
+                            QueryPlannerParams* plannerParams) {
+    const int maxPrefixValues = internalQueryPlannerSkipScanMaxPrefixValues.load();
+    if (maxPrefixValues <= 0) {
+        return;
+    }
+
+    const CollectionStatistics* stats = statistics->get();
+    if (!stats) {
+        return;
+    }
+
+    for (auto&& index : plannerParams->indices) {
+        if (INDEX_BTREE != index.type || index.keyPattern.nFields() < 2) {
+            continue;
+        }
+
+        const Histogram* histogram =
+            stats->getHistogram(index.keyPattern.firstElement().fieldNameStringData());
+        if (histogram && histogram->distinctValues() <= maxPrefixValues) {
+            plannerParams->skipScanIndexes.insert(index.name);
+        }
+    }
+}
+
+/**
+ * Removes from 'solutions' the candidates which the collection statistics show to examine many
+ * times more keys or documents than the cheapest candidate, so that the multi-planner does not
+ * spend time running them. Records the estimates of the remaining candidates for explain.
+ */
+void pruneSolutionsUsingStatistics(OperationContext* opCtx,
+                                   Collection* collection,
+                                   LazyCollectionStatistics* statistics,
+                                   const CanonicalQuery& canonicalQuery,
+                                   vector<QuerySolution*>* solutions) {
+    const double pruneRatio = internalQueryPlannerStatsPruneRatio.load();
+    if (pruneRatio <= 0 || solutions->size() < 2) {
+        return;
+    }
+
+    // With a sort or a limit, the plan which examines the fewest keys is not necessarily the one
+    // which produces the first results soonest. Leave those to the multi-planner.
+    const QueryRequest& qr = canonicalQuery.getQueryRequest();
+    if (!qr.getSort().isEmpty() || qr.getLimit() || qr.getNToReturn()) {
+        return;
+    }
+
+    const CollectionStatistics* stats = statistics->get();
+    if (!stats) {
+        return;
+    }
+
+    const long long numRecords = collection->numRecords(opCtx);
+    vector<double> estimates;
+    for (QuerySolution* soln : *solutions) {
+        estimates.push_back(CardinalityEstimator::estimate(soln, *stats, numRecords));
+    }
+
+    const std::vector<bool> keep = CardinalityEstimator::selectCandidates(estimates, pruneRatio);
+    vector<QuerySolution*> remaining;
+    for (size_t i = 0; i < solutions->size(); ++i) {
+        if (keep[i]) {
+            remaining.push_back((*solutions)[i]);
+            continue;
+        }
+
+        LOG(2) << "Pruning candidate plan with estimated cost " << estimates[i]
+               << " for query " << redact(canonicalQuery.toStringShort());
+        delete (*solutions)[i];
+    }
+    solutions->swap(remaining);
+}
+
+bool containsStage(const QuerySolutionNode* node, StageType stage) {
+    if (stage == node->getType()) {
+        return true;
+    }
+    for (auto&& child : node->children) {
+        if (containsStage(child, stage)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns true if 'node' contains a bitmap intersection whose index scans the collection statistics
+ * estimate to examine more than 'maxKeys' keys.
+ */
+bool hasUnselectiveBitmapIntersection(QuerySolutionNode* node,
+                                      const CollectionStatistics& stats,
+                                      long long numRecords,
+                                      double maxKeys) {
+    if (STAGE_AND_BITMAP == node->getType()) {
+        const double keys = CardinalityEstimator::estimateSubtree(node, stats, numRecords);
+        return keys > maxKeys;
+    }
+    for (auto&& child : node->children) {
+        if (hasUnselectiveBitmapIntersection(child, stats, numRecords, maxKeys)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Removes from 'solutions' the bitmap intersection plans whose index scans the collection
+ * statistics show to return too many RecordIds for the bitmaps to pay off, as long as another
+ * candidate remains. Plans which cannot be estimated are kept.
+ */
+void dropUnselectiveBitmapIntersections(OperationContext* opCtx,
+                                        Collection* collection,
+                                        LazyCollectionStatistics* statistics,
+                                        const CanonicalQuery& canonicalQuery,
+                                        vector<QuerySolution*>* solutions) {
+    const double maxSelectivity = internalQueryPlannerBitmapIntersectionMaxSelectivity.load();
+    if (maxSelectivity <= 0 || solutions->size() < 2) {
+        return;
+    }
+
+    if (std::none_of(solutions->begin(), solutions->end(), [](const QuerySolution* soln) {
+            return containsStage(soln->root.get(), STAGE_AND_BITMAP);
+        })) {
+        return;
+    }
+
+    const CollectionStatistics* stats = statistics->get();
+    if (!stats) {
+        return;
+    }
+
+    const long long numRecords = collection->numRecords(opCtx);
+    const double maxKeys = maxSelectivity * numRecords;
+    vector<QuerySolution*> remaining;
+    vector<QuerySolution*> dropped;
+    for (QuerySolution* soln : *solutions) {
+        if (hasUnselectiveBitmapIntersection(soln->root.get(), *stats, numRecords, maxKeys)) {
+            dropped.push_back(soln);
+        } else {
+            remaining.push_back(soln);
+        }
+    }
+
+    if (remaining.empty()) {
+        return;
+    }
+
+    for (QuerySolution* soln : dropped) {
+        LOG(2) << "Dropping unselective bitmap intersection plan for query "
+               << redact(canonicalQuery.toStringShort());
+        delete soln;
+    }
+    solutions->swap(remaining);
+}
+
 /**
  * Build an execution tree for the query described in 'canonicalQuery'.
  *
@@ -307,12 +571,21 @@ StatusWith<PrepareExecutionResult> prepareExecution(OperationContext* opCtx,
             std::move(canonicalQuery), std::move(querySolution), std::move(root));
     }
 
+    // Until a bulk load commits, the indexes of the collection are missing keys.
+    if (collection->infoCache()->indexesIncomplete()) {
+        return Status(ErrorCodes::BackgroundOperationInProgressForNamespace,
+                      str::stream() << "Cannot query " << collection->ns().ns()
+                                    << " while its indexes are being bulk loaded");
+    }
+
     // Fill out the planning params.  We use these for both cached solutions and non-cached.
     QueryPlannerParams plannerParams;
     plannerParams.options = plannerOptions;
 	//ȡplannerParamsϢ
 	//ȡcollection϶ӦϢ洢indicesУͬʱԲʼֵ
     fillOutPlannerParams(opCtx, collection, canonicalQuery.get(), &plannerParams);
+    LazyCollectionStatistics statistics(opCtx, collection);
+    fillOutSkipScanIndexes(&statistics, &plannerParams);
 
     // If the canonical query does not have a user-specified collation, set it from the collection
     // default. 
@@ -498,6 +771,10 @@ StatusWith<PrepareExecutionResult> prepareExecution(OperationContext* opCtx,
         }
     }
 
+    // Use collection statistics, if any, to discard candidates that are clearly too expensive.
+    dropUnselectiveBitmapIntersections(opCtx, collection, &statistics, *canonicalQuery, &solutions);
+    pruneSolutionsUsingStatistics(opCtx, collection, &statistics, *canonicalQuery, &solutions);
+
 	//ǸQueryPlanner::planɵQuerySolutionPlanStage
     if (1 == solutions.size()) { //ֻһplan
         // Only one possible plan.  Run it.  Build the stages from the solution.
@@ -786,6 +1063,8 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>>
 		//ƬģʽϸñǻͷڱƬݲӦڱƬɾ
         plannerOptions |= QueryPlannerParams::INCLUDE_SHARD_FILTER;
     }
+    // Reads of whole documents only, so a collection scan may read the column store instead.
+    plannerOptions |= QueryPlannerParams::USE_COLUMN_STORE;
     return getExecutor( //pickBestPlanѡȡŵplan  CanonicalQueryõıʽ,getExecutorõյPlanExecutor
         opCtx, collection, std::move(canonicalQuery), PlanExecutor::YIELD_AUTO, plannerOptions);
 }
@@ -1244,22 +1523,50 @@ bool turnIxscanIntoCount(QuerySolution* soln) {
     BSONObj endKey;
     bool endKeyInclusive;
 
-    if (!IndexBoundsBuilder::isSingleInterval(
-            isn->bounds, &startKey, &startKeyInclusive, &endKey, &endKeyInclusive)) {
+    const bool isSingleInterval = IndexBoundsBuilder::isSingleInterval(
+        isn->bounds, &startKey, &startKeyInclusive, &endKey, &endKeyInclusive);
+
+    // With several intervals, e.g. an $in or a range on a prefix of a compound index with
+    // predicates on the suffix, the count scan checks the keys against the bounds and seeks over
+    // the gaps between intervals. It only scans forward.
+    if (!isSingleInterval && isn->direction != 1) {
         return false;
     }
 
     // Make the count node that we replace the fetch + ixscan with.
     CountScanNode* csn = new CountScanNode(isn->index);
-    csn->startKey = startKey;
-    csn->startKeyInclusive = startKeyInclusive;
-    csn->endKey = endKey;
-    csn->endKeyInclusive = endKeyInclusive;
+    if (isSingleInterval) {
+        csn->startKey = startKey;
+        csn->startKeyInclusive = startKeyInclusive;
+        csn->endKey = endKey;
+        csn->endKeyInclusive = endKeyInclusive;
+    } else {
+        csn->bounds = isn->bounds;
+        csn->startKeyInclusive = false;
+        csn->endKeyInclusive = false;
+    }
+
     // Takes ownership of 'cn' and deletes the old root.
     soln->root.reset(csn);
     return true;
 }
 
+/**
+ * Makes 'distinctNode' scan its bounds in the opposite direction, so that it returns the last key
+ * of each distinct value rather than the first.
+ */
+void reverseDistinctScan(DistinctNode* distinctNode) {
+    distinctNode->direction *= -1;
+    for (auto&& field : distinctNode->bounds.fields) {
+        std::reverse(field.intervals.begin(), field.intervals.end());
+        for (auto&& interval : field.intervals) {
+            interval.reverse();
+        }
+    }
+    invariant(
+        distinctNode->bounds.isValidFor(distinctNode->index.keyPattern, distinctNode->direction));
+}
+
 /**
  * Returns true if indices contains an index that can be used with DistinctNode (the "fast distinct
  * hack" node, which can be used only if there is an empty query predicate).  Sets indexOut to the
@@ -1594,7 +1901,15 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDistinct(
     Collection* collection,
     const std::string& ns,
     ParsedDistinct* parsedDistinct,
-    PlanExecutor::YieldPolicy yieldPolicy) {
+    PlanExecutor::YieldPolicy yieldPolicy,
+    size_t plannerOptions) {
+    const bool strictDistinctOnly = plannerOptions & QueryPlannerParams::STRICT_DISTINCT_ONLY;
+    const bool reverseScan = plannerOptions & QueryPlannerParams::REVERSE_DISTINCT_SCAN;
+    invariant(strictDistinctOnly || !reverseScan);
+    const Status noDistinctScan(ErrorCodes::BadValue,
+                                str::stream() << "no DISTINCT_SCAN plan for key "
+                                              << parsedDistinct->getKey());
+
     if (!collection) {
         // Treat collections that do not exist as empty collections.
         return PlanExecutor::make(opCtx,
@@ -1623,6 +1938,12 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDistinct(
     while (ii.more()) {
         const IndexDescriptor* desc = ii.next();
         IndexCatalogEntry* ice = ii.catalogEntry(desc);
+        if (strictDistinctOnly &&
+            (desc->isMultikey(opCtx) || desc->isSparse() ||
+             !CollatorInterface::collatorsMatch(ice->getCollator(),
+                                                parsedDistinct->getQuery()->getCollator()))) {
+            continue;
+        }
         if (desc->keyPattern().hasField(parsedDistinct->getKey())) {
             plannerParams.indices.push_back(IndexEntry(desc->keyPattern(),
                                                        desc->getAccessMethodName(),
@@ -1642,6 +1963,9 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDistinct(
     // If there are no suitable indices for the distinct hack bail out now into regular planning
     // with no projection.
     if (plannerParams.indices.empty()) {
+        if (strictDistinctOnly) {
+            return noDistinctScan;
+        }
         return getExecutor(opCtx, collection, parsedDistinct->releaseQuery(), yieldPolicy);
     }
 
@@ -1651,11 +1975,12 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDistinct(
 
     // Applying a projection allows the planner to try to give us covered plans that we can turn
     // into the projection hack.  getDistinctProjection deals with .find() projection semantics
-    // (ie _id:1 being implied by default).
-    BSONObj projection = getDistinctProjection(parsedDistinct->getKey());
-
+    // (ie _id:1 being implied by default). A caller asking for STRICT_DISTINCT_ONLY has already
+    // set the projection of the fields it needs.
     auto qr = stdx::make_unique<QueryRequest>(parsedDistinct->getQuery()->getQueryRequest());
-    qr->setProj(projection);
+    if (!strictDistinctOnly) {
+        qr->setProj(getDistinctProjection(parsedDistinct->getKey()));
+    }
 
     const boost::intrusive_ptr<ExpressionContext> expCtx;
     auto statusWithCQ =
@@ -1690,6 +2015,9 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDistinct(
         dn->direction = 1;
         IndexBoundsBuilder::allValuesBounds(dn->index.keyPattern, &dn->bounds);
         dn->fieldNo = 0;
+        if (reverseScan) {
+            reverseDistinctScan(dn.get());
+        }
 
         // An index with a non-simple collation requires a FETCH stage.
         std::unique_ptr<QuerySolutionNode> solnRoot = std::move(dn);
@@ -1728,6 +2056,9 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDistinct(
     vector<QuerySolution*> solutions;
     Status status = QueryPlanner::plan(*cq, plannerParams, &solutions);
     if (!status.isOK()) {
+        if (strictDistinctOnly) {
+            return noDistinctScan;
+        }
         return getExecutor(opCtx, collection, std::move(cq), yieldPolicy);
     }
 
@@ -1744,6 +2075,12 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDistinct(
             // Build and return the SSR over solutions[i].
             unique_ptr<WorkingSet> ws = make_unique<WorkingSet>();
             unique_ptr<QuerySolution> currentSolution(solutions[i]);
+            if (reverseScan) {
+                // The DISTINCT_SCAN is the only child of the FETCH or PROJECTION at the root.
+                auto distinctNode = currentSolution->root->children[0];
+                invariant(STAGE_DISTINCT_SCAN == distinctNode->getType());
+                reverseDistinctScan(static_cast<DistinctNode*>(distinctNode));
+            }
             PlanStage* rawRoot;
             verify(
                 StageBuilder::build(opCtx, collection, *cq, *currentSolution, ws.get(), &rawRoot));
@@ -1769,6 +2106,9 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDistinct(
         delete solutions[i];
     }
 
+    if (strictDistinctOnly) {
+        return noDistinctScan;
+    }
     return getExecutor(opCtx, collection, parsedDistinct->releaseQuery(), yieldPolicy);
 }
 
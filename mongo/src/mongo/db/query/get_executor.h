@@ -109,13 +109,19 @@ bool turnIxscanIntoDistinctIxscan(QuerySolution* soln, const std::string& field)
  * Distinct is unique in that it doesn't care about getting all the results; it just wants all
  * possible values of a certain field.  As such, we can skip lots of data in certain cases (see
  * body of method for detail).
+ *
+ * With QueryPlannerParams::STRICT_DISTINCT_ONLY in 'plannerOptions', the projection of the
+ * parsed query is kept rather than replaced by one on the distinct key, and a BadValue error is
+ * returned if the plan would not use a DISTINCT_SCAN. Such plans do not apply a shard filter.
+ * QueryPlannerParams::REVERSE_DISTINCT_SCAN additionally makes the DISTINCT_SCAN run backwards.
  */
 StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDistinct(
     OperationContext* opCtx,
     Collection* collection,
     const std::string& ns,
     ParsedDistinct* parsedDistinct,
-    PlanExecutor::YieldPolicy yieldPolicy);
+    PlanExecutor::YieldPolicy yieldPolicy,
+    size_t plannerOptions = QueryPlannerParams::DEFAULT);
 
 /*
  * Get a PlanExecutor for a query executing as part of a count command.
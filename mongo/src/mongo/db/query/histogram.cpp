@@ -0,0 +1,263 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/bson/simple_bsonobj_comparator.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+namespace {
+
+/**
+ * Where 'value' lies between 'lower' and 'upper', as a fraction of the range. Only numbers can be
+ * interpolated; anything else is assumed to lie in the middle.
+ */
+double fractionOfRange(const BSONElement& lower,
+                       const BSONElement& value,
+                       const BSONElement& upper) {
+    if (!lower.isNumber() || !value.isNumber() || !upper.isNumber()) {
+        return 0.5;
+    }
+
+    const double lo = lower.numberDouble();
+    const double hi = upper.numberDouble();
+    if (!(hi > lo)) {
+        return 0.5;
+    }
+    return std::min(1.0, std::max(0.0, (value.numberDouble() - lo) / (hi - lo)));
+}
+
+}  // namespace
+
+// static
+Histogram Histogram::build(std::vector<BSONObj>* values, size_t maxBuckets, double scale) {
+    invariant(maxBuckets > 0);
+    Histogram histogram;
+    if (values->empty()) {
+        return histogram;
+    }
+
+    std::sort(values->begin(), values->end(), SimpleBSONObjComparator::kInstance.makeLessThan());
+
+    // Collapse the sorted sample into runs of equal values.
+    std::vector<std::pair<BSONObj, size_t>> runs;
+    for (const BSONObj& value : *values) {
+        if (runs.empty() || runs.back().first.woCompare(value, BSONObj(), false) != 0) {
+            runs.emplace_back(value, 0);
+        }
+        ++runs.back().second;
+    }
+
+    // Estimate the number of distinct values in the whole collection from the sample using the
+    // GEE estimator: values seen once in the sample stand for sqrt(scale) distinct values each.
+    size_t seenOnce = 0;
+    for (const auto& run : runs) {
+        if (run.second == 1) {
+            ++seenOnce;
+        }
+    }
+    histogram._distinctValues = std::min(
+        std::sqrt(std::max(scale, 1.0)) * seenOnce + (runs.size() - seenOnce),
+        static_cast<double>(values->size()) * std::max(scale, 1.0));
+    const double distinctScale = histogram._distinctValues / runs.size();
+
+    const size_t depth = (values->size() + maxBuckets - 1) / maxBuckets;
+    histogram._lowerBound = runs.front().first.getOwned();
+
+    Bucket bucket;
+    size_t bucketValues = 0;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        const size_t count = runs[i].second;
+        if (bucketValues + count < depth && i + 1 < runs.size()) {
+            bucket.rangeCount += count;
+            bucket.rangeDistinct += 1;
+            bucketValues += count;
+            continue;
+        }
+
+        // This run closes the bucket.
+        bucket.upperBound = runs[i].first.getOwned();
+        bucket.equalCount = count * scale;
+        bucket.rangeCount *= scale;
+        bucket.rangeDistinct *= distinctScale;
+        histogram._buckets.push_back(bucket);
+
+        bucket = Bucket();
+        bucketValues = 0;
+    }
+
+    histogram._totalCount = values->size() * scale;
+    return histogram;
+}
+
+// static
+StatusWith<Histogram> Histogram::parse(const BSONObj& obj) {
+    Histogram histogram;
+
+    BSONElement totalCount = obj["totalCount"];
+    BSONElement distinctValues = obj["distinctValues"];
+    BSONElement buckets = obj["buckets"];
+    if (!totalCount.isNumber() || !distinctValues.isNumber() || buckets.type() != Array) {
+        return {ErrorCodes::FailedToParse,
+                str::stream() << "malformed histogram, expected totalCount, distinctValues "
+                                 "and buckets: "
+                              << obj};
+    }
+    histogram._totalCount = totalCount.numberDouble();
+    histogram._distinctValues = distinctValues.numberDouble();
+
+    for (auto&& bucketElem : buckets.Obj()) {
+        if (bucketElem.type() != Object) {
+            return {ErrorCodes::FailedToParse,
+                    str::stream() << "histogram bucket must be an object: " << bucketElem};
+        }
+        BSONObj bucketObj = bucketElem.Obj();
+        BSONElement upperBound = bucketObj["upperBound"];
+        BSONElement rangeCount = bucketObj["rangeCount"];
+        BSONElement equalCount = bucketObj["equalCount"];
+        BSONElement rangeDistinct = bucketObj["rangeDistinct"];
+        if (upperBound.eoo() || !rangeCount.isNumber() || !equalCount.isNumber() ||
+            !rangeDistinct.isNumber()) {
+            return {ErrorCodes::FailedToParse,
+                    str::stream() << "malformed histogram bucket: " << bucketObj};
+        }
+
+        Bucket bucket;
+        BSONObjBuilder upperBoundBuilder;
+        upperBoundBuilder.appendAs(upperBound, "");
+        bucket.upperBound = upperBoundBuilder.obj();
+        bucket.rangeCount = rangeCount.numberDouble();
+        bucket.equalCount = equalCount.numberDouble();
+        bucket.rangeDistinct = rangeDistinct.numberDouble();
+        histogram._buckets.push_back(bucket);
+    }
+
+    if (!histogram._buckets.empty()) {
+        BSONElement lowerBound = obj["lowerBound"];
+        if (lowerBound.eoo()) {
+            return {ErrorCodes::FailedToParse,
+                    str::stream() << "histogram with buckets must have a lowerBound: " << obj};
+        }
+        BSONObjBuilder lowerBoundBuilder;
+        lowerBoundBuilder.appendAs(lowerBound, "");
+        histogram._lowerBound = lowerBoundBuilder.obj();
+    }
+
+    return histogram;
+}
+
+void Histogram::serialize(BSONObjBuilder* builder) const {
+    builder->append("totalCount", _totalCount);
+    builder->append("distinctValues", _distinctValues);
+    if (!_lowerBound.isEmpty()) {
+        builder->appendAs(_lowerBound.firstElement(), "lowerBound");
+    }
+
+    BSONArrayBuilder bucketsBuilder(builder->subarrayStart("buckets"));
+    for (const Bucket& bucket : _buckets) {
+        BSONObjBuilder bucketBuilder(bucketsBuilder.subobjStart());
+        bucketBuilder.appendAs(bucket.upperBound.firstElement(), "upperBound");
+        bucketBuilder.append("rangeCount", bucket.rangeCount);
+        bucketBuilder.append("equalCount", bucket.equalCount);
+        bucketBuilder.append("rangeDistinct", bucket.rangeDistinct);
+    }
+}
+
+double Histogram::estimateEqual(const BSONElement& value) const {
+    if (_buckets.empty() || value.woCompare(_lowerBound.firstElement(), false) < 0) {
+        return 0;
+    }
+
+    for (const Bucket& bucket : _buckets) {
+        const int cmp = value.woCompare(bucket.upperBound.firstElement(), false);
+        if (cmp == 0) {
+            return bucket.equalCount;
+        }
+        if (cmp < 0) {
+            return bucket.rangeDistinct > 0 ? bucket.rangeCount / bucket.rangeDistinct : 0;
+        }
+    }
+    return 0;
+}
+
+double Histogram::_estimateLessThan(const BSONElement& value, bool inclusive) const {
+    if (_buckets.empty()) {
+        return 0;
+    }
+
+    BSONElement lower = _lowerBound.firstElement();
+    if (value.woCompare(lower, false) < 0) {
+        return 0;
+    }
+
+    double count = 0;
+    for (const Bucket& bucket : _buckets) {
+        BSONElement upper = bucket.upperBound.firstElement();
+        const int cmp = value.woCompare(upper, false);
+        if (cmp > 0) {
+            count += bucket.rangeCount + bucket.equalCount;
+            lower = upper;
+            continue;
+        }
+
+        if (cmp == 0) {
+            return count + bucket.rangeCount + (inclusive ? bucket.equalCount : 0);
+        }
+        return count + bucket.rangeCount * fractionOfRange(lower, value, upper);
+    }
+    return count;
+}
+
+double Histogram::estimateInterval(const Interval& interval) const {
+    if (interval.isPoint()) {
+        return estimateEqual(interval.start);
+    }
+
+    BSONElement start = interval.start;
+    BSONElement end = interval.end;
+    bool startInclusive = interval.startInclusive;
+    bool endInclusive = interval.endInclusive;
+    if (start.woCompare(end, false) > 0) {
+        std::swap(start, end);
+        std::swap(startInclusive, endInclusive);
+    }
+
+    const double estimate =
+        _estimateLessThan(end, endInclusive) - _estimateLessThan(start, !startInclusive);
+    return std::max(0.0, estimate);
+}
+
+}  // namespace mongo
@@ -0,0 +1,114 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/base/status_with.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/query/interval.h"
+
+namespace mongo {
+
+/**
+ * An equi-depth histogram over the values of one field of a collection, built from a sample of
+ * its documents.
+ *
+ * Values are collected the way a single-field btree index would see them: each element of an
+ * array counts as a separate value and a missing field counts as null. Counts are scaled from the
+ * sample up to the size of the collection when the histogram is built, so they estimate numbers
+ * of index keys rather than numbers of sampled values.
+ *
+ * Bucket i covers the values in (upperBound(i - 1), upperBound(i)]. It remembers how many values
+ * fall strictly inside that range, how many are equal to its upper bound, and how many distinct
+ * values lie strictly inside. The first bucket starts at the smallest sampled value.
+ */
+class Histogram {
+public:
+    struct Bucket {
+        // A single-element object {"": <value>}.
+        BSONObj upperBound;
+        double rangeCount = 0;
+        double equalCount = 0;
+        double rangeDistinct = 0;
+    };
+
+    Histogram() = default;
+
+    /**
+     * Builds a histogram with at most 'maxBuckets' buckets. 'values' holds one single-element
+     * object per sampled value and is sorted in place. Every sampled value stands for 'scale'
+     * values of the collection.
+     */
+    static Histogram build(std::vector<BSONObj>* values, size_t maxBuckets, double scale);
+
+    static StatusWith<Histogram> parse(const BSONObj& obj);
+
+    void serialize(BSONObjBuilder* builder) const;
+
+    /**
+     * Estimated number of values equal to 'value'.
+     */
+    double estimateEqual(const BSONElement& value) const;
+
+    /**
+     * Estimated number of values inside 'interval'. The interval may be oriented either way.
+     */
+    double estimateInterval(const Interval& interval) const;
+
+    /**
+     * Estimated number of distinct values of the field in the whole collection.
+     */
+    double distinctValues() const {
+        return _distinctValues;
+    }
+
+    double totalCount() const {
+        return _totalCount;
+    }
+
+    const std::vector<Bucket>& buckets() const {
+        return _buckets;
+    }
+
+private:
+    /**
+     * Estimated number of values less than 'value', or less than or equal to it if 'inclusive'.
+     */
+    double _estimateLessThan(const BSONElement& value, bool inclusive) const;
+
+    BSONObj _lowerBound;
+    std::vector<Bucket> _buckets;
+    double _totalCount = 0;
+    double _distinctValues = 0;
+};
+
+}  // namespace mongo
@@ -201,6 +201,9 @@ struct SolutionCacheData {
         //ȫɨ
         COLLSCAN_SOLN,   //οQueryPlanner::plan
 
+        // The cached plan skip-scans the index in 'tree', see QueryPlannerAccess::makeSkipScan.
+        SKIP_SCAN_SOLN,
+
         // Build the solution by using 'tree'
         // to tag the match expression.
         //ߺѡSolutionCacheDataʹõĬֵ
@@ -127,8 +127,19 @@ size_t PlanRanker::pickBestPlan(const vector<CandidatePlan>& candidates, PlanRan
     std::stable_sort(
         scoresAndCandidateindices.begin(), scoresAndCandidateindices.end(), scoreComparator);
 
-    // Determine whether plans tied for the win.
-    if (scoresAndCandidateindices.size() > 1U) {
+    // Plans discarded during the trial period did less work than the others, so their scores are
+    // not comparable. Rank them behind every plan that ran for the whole trial.
+    auto firstDiscarded = std::stable_partition(
+        scoresAndCandidateindices.begin(),
+        scoresAndCandidateindices.end(),
+        [&candidates](const std::pair<double, size_t>& scoreAndCandidateIndex) {
+            return !candidates[scoreAndCandidateIndex.second].discarded;
+        });
+    why->numDiscarded = std::distance(firstDiscarded, scoresAndCandidateindices.end());
+
+    // Determine whether plans tied for the win. Only plans that ran for the whole trial can tie,
+    // so there is no runner-up if at most one of them survived.
+    if (scoresAndCandidateindices.size() - why->numDiscarded > 1U) {
         double bestScore = scoresAndCandidateindices[0].first;
         double runnerUpScore = scoresAndCandidateindices[1].first;
         const double epsilon = 1e-10;
@@ -138,7 +149,8 @@ size_t PlanRanker::pickBestPlan(const vector<CandidatePlan>& candidates, PlanRan
     }
 
     // Update results in 'why'
-    // Stats and scores in 'why' are sorted in descending order by score.
+    // Stats and scores in 'why' are sorted in descending order by score among the plans that ran
+    // for the whole trial, followed by the discarded plans in descending order by score.
     why->stats.clear();
     why->scores.clear();
     why->candidateOrder.clear();
@@ -270,7 +282,8 @@ double PlanRanker::scoreTree(const PlanStageStats* stats) {
     // can be made up via the no fetch bonus.
     double noIxisectBonus = epsilon;
 	//STAGE_AND_HASH || STAGE_AND_SORTEDҪڽʱ
-    if (hasStage(STAGE_AND_HASH, stats) || hasStage(STAGE_AND_SORTED, stats)) {
+    if (hasStage(STAGE_AND_HASH, stats) || hasStage(STAGE_AND_SORTED, stats) ||
+        hasStage(STAGE_AND_BITMAP, stats)) {
         noIxisectBonus = 0;
     }
 
@@ -297,7 +310,8 @@ double PlanRanker::scoreTree(const PlanStageStats* stats) {
     LOG(2) << scoreStr;
 
     if (internalQueryForceIntersectionPlans.load()) {
-        if (hasStage(STAGE_AND_HASH, stats) || hasStage(STAGE_AND_SORTED, stats)) {
+        if (hasStage(STAGE_AND_HASH, stats) || hasStage(STAGE_AND_SORTED, stats) ||
+            hasStage(STAGE_AND_BITMAP, stats)) {
             // The boost should be >2.001 to make absolutely sure the ixisect plan will win due
             // to the combination of 1) productivity, 2) eof bonus, and 3) no ixisect bonus.
             score += 3;
@@ -70,7 +70,7 @@ public:
  */ //ֵMultiPlanStage::addPlan    ýṹմMultiPlanStage._candidatesԱ
 struct CandidatePlan { //תΪPlanStageͶӦQuerySolutionýṹ
     CandidatePlan(QuerySolution* s, PlanStage* r, WorkingSet* w)
-        : solution(s), root(r), ws(w), failed(false) {}
+        : solution(s), root(r), ws(w), failed(false), discarded(false) {}
 
     std::unique_ptr<QuerySolution> solution;
     //MultiPlanStage::workAllPlansִwork
@@ -83,6 +83,10 @@ struct CandidatePlan { //
     std::list<WorkingSetID> results;
 
     bool failed;
+
+    // True if the multi-planner stopped working this plan during the trial period because it was
+    // clearly losing. Discarded plans rank behind all other plans.
+    bool discarded;
 };
 
 /**
@@ -108,16 +112,19 @@ struct PlanRankingDecision {
         }
         decision->scores = scores;
         decision->candidateOrder = candidateOrder;
+        decision->numDiscarded = numDiscarded;
+        decision->planningTimeMicros = planningTimeMicros;
         return decision;
     }
 
-    // Stats of all plans sorted in descending order by score.
+    // Stats of all plans sorted in descending order by score, except that the plans discarded
+    // during the trial period come after all of the others.
     // Owned by us.
     //ԲοPlanCacheListPlans::listͨPlanCacheListPlans
     std::vector<std::unique_ptr<PlanStageStats>> stats; //ֵοPlanRanker::pickBestPlan
 
     // The "goodness" score corresponding to 'stats'.
-    // Sorted in descending order.
+    // Sorted in the same order as 'stats'.
     std::vector<double> scores; //ֵοPlanRanker::pickBestPlan
 
     // Ordering of original plans in descending of score.
@@ -128,12 +135,19 @@ struct PlanRankingDecision {
     // candidates[candidateOrder[2]], ...
     std::vector<size_t> candidateOrder; //ֵοPlanRanker::pickBestPlan
 
-    // Whether two plans tied for the win.
+    // Whether two plans that ran for the whole trial period tied for the win.
     //
     // Reading this flag is the only reliable way for callers to determine if there was a tie,
     // because the scores kept inside the PlanRankingDecision do not incorporate the EOF bonus.
     //ŵĲѯƻȵڶŵĲѯƻ÷С1e-10tieForBestΪ1Ϊ0
     bool tieForBest = false; //ֵοPlanRanker::pickBestPlan
+
+    // How many candidates were discarded during the trial period. These are the last
+    // 'numDiscarded' entries of 'candidateOrder'.
+    size_t numDiscarded = 0;
+
+    // How long the trial period took.
+    long long planningTimeMicros = 0;
 };
 
 }  // namespace mongo
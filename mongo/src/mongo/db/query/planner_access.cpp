@@ -34,6 +34,7 @@
 
 #include <algorithm>
 #include <memory>
+#include <set>
 #include <vector>
 
 #include "mongo/base/owned_pointer_vector.h"
@@ -42,9 +43,11 @@
 #include "mongo/db/matcher/expression_array.h"
 #include "mongo/db/matcher/expression_geo.h"
 #include "mongo/db/matcher/expression_text.h"
+#include "mongo/db/query/collation/collator_interface.h"
 #include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/db/query/index_tag.h"
 #include "mongo/db/query/indexability.h"
+#include "mongo/db/query/planner_ixselect.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/query_planner_common.h"
@@ -136,6 +139,158 @@ std::vector<bool> canProvideSortWithMergeSort(const std::vector<QuerySolutionNod
     return shouldReverseScan;
 }
 
+/**
+ * Adds the top-level field of 'path' to 'needed'. Returns false if the column store doesn't
+ * contain it.
+ */
+bool addColumnStoreField(StringData path,
+                         const std::vector<std::string>& columnStoreFields,
+                         std::set<std::string>* needed) {
+    const StringData field = path.substr(0, path.find('.'));
+    if (field.empty() ||
+        std::find(columnStoreFields.begin(), columnStoreFields.end(), field) ==
+            columnStoreFields.end()) {
+        return false;
+    }
+    needed->insert(field.toString());
+    return true;
+}
+
+/**
+ * Adds the top-level fields that 'expr' reads to 'needed'. Returns false if 'expr' may need
+ * something other than these fields, or if the column store doesn't contain all of them.
+ */
+bool addColumnStoreFields(const MatchExpression* expr,
+                          const std::vector<std::string>& columnStoreFields,
+                          std::set<std::string>* needed) {
+    switch (expr->matchType()) {
+        case MatchExpression::AND:
+        case MatchExpression::OR:
+        case MatchExpression::NOR:
+        case MatchExpression::NOT:
+            for (size_t i = 0; i < expr->numChildren(); ++i) {
+                if (!addColumnStoreFields(expr->getChild(i), columnStoreFields, needed)) {
+                    return false;
+                }
+            }
+            return true;
+        case MatchExpression::ALWAYS_FALSE:
+        case MatchExpression::ALWAYS_TRUE:
+            return true;
+        case MatchExpression::ELEM_MATCH_OBJECT:
+        case MatchExpression::ELEM_MATCH_VALUE:
+        case MatchExpression::SIZE:
+        case MatchExpression::EQ:
+        case MatchExpression::LTE:
+        case MatchExpression::LT:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+        case MatchExpression::REGEX:
+        case MatchExpression::MOD:
+        case MatchExpression::EXISTS:
+        case MatchExpression::MATCH_IN:
+        case MatchExpression::BITS_ALL_SET:
+        case MatchExpression::BITS_ALL_CLEAR:
+        case MatchExpression::BITS_ANY_SET:
+        case MatchExpression::BITS_ANY_CLEAR:
+        case MatchExpression::TYPE_OPERATOR:
+        case MatchExpression::GEO:
+            return addColumnStoreField(expr->path(), columnStoreFields, needed);
+        default:
+            return false;
+    }
+}
+
+/**
+ * Returns the column store fields that a collection scan answering 'query' would need, or an
+ * empty vector if the scan cannot read the column store instead of the documents. That is the
+ * case when nothing in the plan needs a field outside of the column store, the RecordId, or a
+ * particular scan direction.
+ */
+std::vector<std::string> getColumnScanFields(const CanonicalQuery& query,
+                                             bool tailable,
+                                             const QueryPlannerParams& params) {
+    const std::vector<std::string>& columnStoreFields = params.columnStoreFields;
+    if (!(params.options & QueryPlannerParams::USE_COLUMN_STORE) || columnStoreFields.empty() ||
+        (params.options & QueryPlannerParams::INCLUDE_SHARD_FILTER) ||
+        (params.options & QueryPlannerParams::TRACK_LATEST_OPLOG_TS) || tailable) {
+        return {};
+    }
+
+    const QueryRequest& qr = query.getQueryRequest();
+    if (!qr.getHint().isEmpty() || qr.getMaxScan() != 0 || qr.showRecordId() ||
+        qr.returnKey()) {
+        return {};
+    }
+
+    const ParsedProjection* proj = query.getProj();
+    if (!proj || proj->requiresDocument() || proj->requiresMatchDetails() ||
+        proj->wantIndexKey() || proj->wantSortKey()) {
+        return {};
+    }
+
+    std::set<std::string> needed;
+    for (auto&& field : proj->getRequiredFields()) {
+        if (!addColumnStoreField(field, columnStoreFields, &needed)) {
+            return {};
+        }
+    }
+
+    for (auto&& elem : qr.getSort()) {
+        // Rules out {$natural: ...} and {$meta: ...} sorts.
+        if (elem.type() == Object ||
+            !addColumnStoreField(elem.fieldNameStringData(), columnStoreFields, &needed)) {
+            return {};
+        }
+    }
+
+    if (!addColumnStoreFields(query.root(), columnStoreFields, &needed)) {
+        return {};
+    }
+
+    std::vector<std::string> fields;
+    for (auto&& field : columnStoreFields) {
+        if (needed.count(field)) {
+            fields.push_back(field);
+        }
+    }
+    return fields;
+}
+
+// An index scan in a bitmap intersection may seek at most this many exact keys.
+const size_t kMaxBitmapIntersectionPoints = 16;
+
+/**
+ * Returns true if 'node' is an index scan which seeks a few exact keys, as one answering an
+ * equality or a small $in on every field of its index does. Without statistics to tell, only
+ * such scans are taken to be selective enough for a bitmap of all the RecordIds they return to be
+ * cheaper than fetching the documents of a single index scan.
+ */
+bool isSelectiveIndexScan(const QuerySolutionNode* node) {
+    if (STAGE_IXSCAN != node->getType()) {
+        return false;
+    }
+
+    const IndexBounds& bounds = static_cast<const IndexScanNode*>(node)->bounds;
+    if (bounds.isSimpleRange || bounds.fields.empty()) {
+        return false;
+    }
+
+    size_t points = 1;
+    for (auto&& oil : bounds.fields) {
+        for (auto&& interval : oil.intervals) {
+            if (!interval.isPoint()) {
+                return false;
+            }
+        }
+        points *= oil.intervals.size();
+        if (points > kMaxBitmapIntersectionPoints) {
+            return false;
+        }
+    }
+    return true;
+}
+
 }  // namespace
 
 namespace mongo {
@@ -148,6 +303,16 @@ using stdx::make_unique;
 // static
 std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::makeCollectionScan(
     const CanonicalQuery& query, bool tailable, const QueryPlannerParams& params) {
+    // Scan the column store instead if it has every field the query needs.
+    std::vector<std::string> columnScanFields = getColumnScanFields(query, tailable, params);
+    if (!columnScanFields.empty()) {
+        auto csn = stdx::make_unique<ColumnScanNode>();
+        csn->name = query.ns();
+        csn->filter = query.root()->shallowClone();
+        csn->fields = std::move(columnScanFields);
+        return std::move(csn);
+    }
+
     // Make the (only) node, a collection scan.
     auto csn = stdx::make_unique<CollectionScanNode>();
     csn->name = query.ns();
@@ -994,6 +1159,15 @@ QuerySolutionNode* QueryPlannerAccess::buildIndexedAnd(const CanonicalQuery& que
         clonedRoot = root->shallowClone();
     }
 
+    // A bitmap intersection outputs no index keys, so the documents it returns can only be
+    // checked against the full filter. Keep a copy in case we build one.
+    const bool canUseBitmapIntersection = !inArrayOperator &&
+        !internalQueryPlannerEnableHashIntersection.load() &&
+        internalQueryPlannerEnableBitmapIntersection.load();
+    if (canUseBitmapIntersection && !clonedRoot) {
+        clonedRoot = root->shallowClone();
+    }
+
     vector<QuerySolutionNode*> ixscanNodes;
 	//rootȡÿڵӦQuerySolutionNodeϢմ浽ixscanNodes
     if (!processIndexScans(query, root, inArrayOperator, indices, params, &ixscanNodes)) {
@@ -1045,9 +1219,15 @@ QuerySolutionNode* QueryPlannerAccess::buildIndexedAnd(const CanonicalQuery& que
                     break;
                 }
             }
+        } else if (canUseBitmapIntersection &&
+                   std::all_of(ixscanNodes.begin(), ixscanNodes.end(), isSelectiveIndexScan)) {
+            AndBitmapNode* abn = new AndBitmapNode();
+            abn->children.swap(ixscanNodes);
+            andResult = abn;
         } else {
-            // We can't use sort-based intersection, and hash-based intersection is disabled.
-            // Clean up the index scans and bail out by returning NULL.
+            // We can't use sort-based intersection, hash-based intersection is disabled, and
+            // bitmap-based intersection is disabled or the index scans are not selective. Clean
+            // up the index scans and bail out by returning NULL.
             /*
 			³룺
 			2021-02-10T09:54:03.666+0800 D QUERY    [conn-4] About to build solntree(QuerySolution tree) from tagged tree:
@@ -1061,7 +1241,8 @@ QuerySolutionNode* QueryPlannerAccess::buildIndexedAnd(const CanonicalQuery& que
 			2021-02-10T09:54:03.666+0800 D QUERY    [conn-4] Can't build index intersection solution: AND_SORTED is not possible and AND_HASH is disabled.
 			*/
             LOG(5) << "Can't build index intersection solution: "
-                   << "AND_SORTED is not possible and AND_HASH is disabled.";
+                   << "AND_SORTED is not possible, AND_HASH is disabled and AND_BITMAP is "
+                   << "disabled or not selective.";
 
             for (size_t i = 0; i < ixscanNodes.size(); i++) {
                 delete ixscanNodes[i];
@@ -1076,8 +1257,9 @@ QuerySolutionNode* QueryPlannerAccess::buildIndexedAnd(const CanonicalQuery& que
     }
 
     // XXX: This block is a hack to accommodate the storage layer concurrency model.
-    if ((params.options & QueryPlannerParams::CANNOT_TRIM_IXISECT) &&
-        (andResult->getType() == STAGE_AND_HASH || andResult->getType() == STAGE_AND_SORTED)) {
+    if (((params.options & QueryPlannerParams::CANNOT_TRIM_IXISECT) &&
+         (andResult->getType() == STAGE_AND_HASH || andResult->getType() == STAGE_AND_SORTED)) ||
+        andResult->getType() == STAGE_AND_BITMAP) {
         // We got an index intersection solution, and we aren't allowed to answer predicates
         // using the index. We add a fetch with the entire filter.
         invariant(clonedRoot.get());
@@ -1335,6 +1517,86 @@ QuerySolutionNode* QueryPlannerAccess::scanWholeIndex(const IndexEntry& index,
     return solnRoot;
 }
 
+// static
+QuerySolutionNode* QueryPlannerAccess::makeSkipScan(const IndexEntry& index,
+                                                    const CanonicalQuery& query,
+                                                    const QueryPlannerParams& params) {
+    // Multikey and sparse indexes need the planner's usual care when combining bounds, which is
+    // not worth repeating here.
+    if (INDEX_BTREE != index.type || index.multikey || index.sparse || index.filterExpr ||
+        index.keyPattern.nFields() < 2 ||
+        !CollatorInterface::collatorsMatch(index.collator, query.getCollator())) {
+        return NULL;
+    }
+
+    MatchExpression* root = query.root();
+    if (QueryPlannerCommon::hasNode(root, MatchExpression::GEO_NEAR) ||
+        QueryPlannerCommon::hasNode(root, MatchExpression::TEXT)) {
+        return NULL;
+    }
+
+    // Only predicates which must hold for every result can bound the scan.
+    std::vector<MatchExpression*> predicates;
+    if (MatchExpression::AND == root->matchType()) {
+        for (size_t i = 0; i < root->numChildren(); ++i) {
+            predicates.push_back(root->getChild(i));
+        }
+    } else {
+        predicates.push_back(root);
+    }
+
+    unique_ptr<IndexScanNode> isn = make_unique<IndexScanNode>(index);
+    isn->maxScan = query.getQueryRequest().getMaxScan();
+    isn->addKeyMetadata = query.getQueryRequest().returnKey();
+    isn->queryCollator = query.getCollator();
+    isn->skipScan = true;
+
+    bool boundedSuffix = false;
+    size_t pos = 0;
+    for (auto&& elt : index.keyPattern) {
+        OrderedIntervalList oil;
+        bool bounded = false;
+        for (auto&& pred : predicates) {
+            if (pred->path() != elt.fieldNameStringData() ||
+                !QueryPlannerIXSelect::compatible(elt, index, pred, query.getCollator())) {
+                continue;
+            }
+
+            // A constrained leading field is handled by regular planning.
+            if (0 == pos) {
+                return NULL;
+            }
+
+            IndexBoundsBuilder::BoundsTightness tightness;
+            if (bounded) {
+                IndexBoundsBuilder::translateAndIntersect(pred, elt, index, &oil, &tightness);
+            } else {
+                IndexBoundsBuilder::translate(pred, elt, index, &oil, &tightness);
+                bounded = true;
+            }
+        }
+
+        if (!bounded) {
+            IndexBoundsBuilder::allValuesForField(elt, &oil);
+        }
+        boundedSuffix = boundedSuffix || bounded;
+        isn->bounds.fields.push_back(oil);
+        ++pos;
+    }
+
+    if (!boundedSuffix) {
+        return NULL;
+    }
+
+    IndexBoundsBuilder::alignBounds(&isn->bounds, index.keyPattern);
+
+    // The bounds may be inexact, so always fetch and filter.
+    unique_ptr<FetchNode> fetch = make_unique<FetchNode>();
+    fetch->filter = root->shallowClone();
+    fetch->children.push_back(isn.release());
+    return fetch.release();
+}
+
 // static
 void QueryPlannerAccess::addFilterToSolutionNode(QuerySolutionNode* node,
                                                  MatchExpression* match,
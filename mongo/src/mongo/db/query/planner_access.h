@@ -204,6 +204,17 @@ public:
                                              const QueryPlannerParams& params,
                                              int direction = 1);
 
+    /**
+     * Return a plan that skip-scans the compound index 'index', whose leading field is not
+     * constrained by 'query' but some later field is: the index scan is unbounded on the leading
+     * field and bounded on the others, so that it seeks from one distinct value of the leading
+     * field to the next. A fetch applies the whole query as a filter. Returns NULL if the index is
+     * not suitable.
+     */
+    static QuerySolutionNode* makeSkipScan(const IndexEntry& index,
+                                           const CanonicalQuery& query,
+                                           const QueryPlannerParams& params);
+
     /**
      * Return a plan that scans the provided index from [startKey to endKey).
      */ //scanWholeIndexstartKeyendkey
@@ -716,8 +716,9 @@ QuerySolution* QueryPlannerAnalysis::analyzeDataAccess(
     }
 
     // A solution can be blocking if it has a blocking sort stage or
-    // a hashed AND stage.
-    bool hasAndHashStage = hasNode(solnRoot.get(), STAGE_AND_HASH);
+    // a hashed or bitmap AND stage.
+    bool hasAndHashStage = hasNode(solnRoot.get(), STAGE_AND_HASH) ||
+        hasNode(solnRoot.get(), STAGE_AND_BITMAP);
     soln->hasBlockingStage = hasSortStage || hasAndHashStage;
 
 	//ȡԭʼQueryRequestϢ
@@ -39,6 +39,12 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationCollFraction, double, 0
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationMaxResults, int, 101);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationHalvingWorks, int, 0);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerStatsPruneRatio, double, 10.0);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryStatsStaleFraction, double, 0.2);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheSize, int, 5000);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheFeedbacksStored, int, 20);
@@ -57,6 +63,14 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableIndexIntersection, bool,
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableHashIntersection, bool, false);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableBitmapIntersection, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerBitmapIntersectionMaxSelectivity, double, 0.1);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerSkipScanMaxPrefixValues, int, 100);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCompileInclusionProjections, bool, true);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanOrChildrenIndependently, bool, true);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryMaxScansToExplode, int, 200);
@@ -69,6 +83,8 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldPeriodMS, int, 10);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryFacetBufferSizeBytes, int, 100 * 1024 * 1024);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryFacetMaxParallelism, int, 4);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalInsertMaxBatchSize,
                               int,
                               internalQueryExecYieldIterations.load() / 2); //(128 / 2)
@@ -77,9 +93,60 @@ MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceCursorBatchSizeBytes, int, 4
 
 MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceLookupCacheSizeBytes, int, 100 * 1024 * 1024);
 
+AtomicInt32 internalDocumentSourceBatchSize(128);
+
+class ExportedDocumentSourceBatchSizeParameter
+    : public ExportedServerParameter<int, ServerParameterType::kStartupAndRuntime> {
+public:
+    ExportedDocumentSourceBatchSizeParameter()
+        : ExportedServerParameter<int, ServerParameterType::kStartupAndRuntime>(
+              ServerParameterSet::getGlobal(),
+              "internalDocumentSourceBatchSize",
+              &internalDocumentSourceBatchSize) {}
+
+    virtual Status validate(const int& potentialNewValue) {
+        if (potentialNewValue < 1) {
+            return Status(ErrorCodes::BadValue,
+                          "internalDocumentSourceBatchSize must be greater than 0");
+        }
+
+        return Status::OK();
+    }
+} exportedDocumentSourceBatchSizeParam;
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryUseDocumentArena, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceOutBulkLoad, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceOutBulkLoadBatchSizeBytes,
+                              int,
+                              64 * 1024 * 1024);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGraphLookupMaxMemoryBytes,
+                              int,
+                              100 * 1024 * 1024);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGraphLookupFrontierBatchSizeBytes,
+                              int,
+                              1024 * 1024);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCompileAggregationExpressions, bool, true);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerGenerateCoveredWholeIndexScans, bool, false);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableColumnScan, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryEnableCompiledMatchExpressions, bool, true);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryIgnoreUnknownJSONSchemaKeywords, bool, false);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryProhibitBlockingMergeOnMongoS, bool, false);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalChangeStreamUseSharedOplogReader, bool, true);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalChangeStreamSharedOplogReaderBatchSize, int, 1000);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalChangeStreamSharedOplogReaderMaxBufferedEntries, int, 1000);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalChangeStreamPostImageLookupBatchSize, int, 100);
 }  // namespace mongo
@@ -49,6 +49,20 @@ extern AtomicDouble internalQueryPlanEvaluationCollFraction;
 //Ĭ101
 extern AtomicInt32 internalQueryPlanEvaluationMaxResults;
 
+// How many rounds the candidate plans get before the multi-planner first discards the plans
+// scoring in the bottom half. The interval doubles after every cut. Zero, the default, disables
+// discarding.
+extern AtomicInt32 internalQueryPlanEvaluationHalvingWorks;
+
+// When the collection has statistics from the analyze command, candidate plans whose estimated
+// number of keys or documents examined exceeds that of the cheapest plan by more than this factor
+// are not given to the multi-planner. Zero disables pruning.
+extern AtomicDouble internalQueryPlannerStatsPruneRatio;
+
+// Collection statistics are ignored by the planner once the number of writes to the collection
+// since they were gathered exceeds this fraction of its size at the time.
+extern AtomicDouble internalQueryStatsStaleFraction;
+
 // Do we give a big ranking bonus to intersection plans?
 extern AtomicBool internalQueryForceIntersectionPlans;
 
@@ -58,6 +72,24 @@ extern AtomicBool internalQueryPlannerEnableIndexIntersection;
 // Do we use hash-based intersection for rooted $and queries?
 extern AtomicBool internalQueryPlannerEnableHashIntersection;
 
+// Do we use bitmap-based intersection for rooted $and queries when AND_SORTED is not possible and
+// hash-based intersection is disabled? Only index scans which seek a few exact keys are
+// intersected this way.
+extern AtomicBool internalQueryPlannerEnableBitmapIntersection;
+
+// A bitmap intersection plan is dropped before multi-planning if the collection statistics
+// estimate its index scans to examine more keys than this fraction of the documents.
+extern AtomicDouble internalQueryPlannerBitmapIntersectionMaxSelectivity;
+
+// A compound index whose leading field is not constrained by the query is considered for a skip
+// scan if the collection statistics estimate that field to have at most this many distinct values.
+// Zero disables skip scans.
+extern AtomicInt32 internalQueryPlannerSkipScanMaxPrefixValues;
+
+// Are inclusion projections compiled into a CompiledInclusionProjection rather than interpreted
+// by ProjectionExec for every document?
+extern AtomicBool internalQueryCompileInclusionProjections;
+
 //
 // plan cache
 //
@@ -97,6 +129,12 @@ extern AtomicInt32 internalQueryMaxScansToExplode;
 // Allow the planner to generate covered whole index scans, rather than falling back to a COLLSCAN.
 extern AtomicBool internalQueryPlannerGenerateCoveredWholeIndexScans;
 
+// Allow collection scans to read the column store of collections that have one.
+extern AtomicBool internalQueryPlannerEnableColumnScan;
+
+// Evaluate filters in COLLSCAN, FETCH and $match through a CompiledMatchExpression.
+extern AtomicBool internalQueryEnableCompiledMatchExpressions;
+
 // Ignore unknown JSON Schema keywords.
 extern AtomicBool internalQueryIgnoreUnknownJSONSchemaKeywords;
 
@@ -122,6 +160,10 @@ const int64_t insertVectorMaxBytes = 256 * 1024;
 
 // The number of bytes to buffer at once during a $facet stage.
 extern AtomicInt32 internalQueryFacetBufferSizeBytes;
+
+// The maximum number of $facet sub-pipelines to run at once, counting the operation's own thread.
+// Values less than 2 run the sub-pipelines one after another on the operation's thread.
+extern AtomicInt32 internalQueryFacetMaxParallelism;
 //AtomicInt32ͱͨinternalInsertMaxBatchSize.load()
 extern AtomicInt32 internalInsertMaxBatchSize;
 
@@ -129,5 +171,47 @@ extern AtomicInt32 internalDocumentSourceCursorBatchSizeBytes;
 
 extern AtomicInt32 internalDocumentSourceLookupCacheSizeBytes;
 
+// The number of documents blocking stages such as $group and $sort ask their input for at once
+// through DocumentSource::getNextBatch(). Must be positive.
+extern AtomicInt32 internalDocumentSourceBatchSize;
+
+// If true, Documents built while an aggregation pipeline executes allocate their field buffers from
+// a pool owned by the pipeline's ExpressionContext rather than directly from the global heap.
+extern AtomicBool internalQueryUseDocumentArena;
+
+// If true, $out builds the indexes of its temporary collection from the keys of the documents as
+// they are inserted, rather than maintaining each index on every insert.
+extern AtomicBool internalDocumentSourceOutBulkLoad;
+
+// The maximum number of bytes of documents $out inserts at once when bulk loading.
+extern AtomicInt32 internalDocumentSourceOutBulkLoadBatchSizeBytes;
+
+// The maximum number of bytes $graphLookup may use for its frontier and discovered documents
+// before it spills the discovered documents to disk, or fails if disk use is not allowed.
+extern AtomicInt32 internalDocumentSourceGraphLookupMaxMemoryBytes;
+
+// The maximum number of bytes of frontier values $graphLookup places in a single query against
+// the 'from' collection. Larger frontiers are looked up with several queries.
+extern AtomicInt32 internalDocumentSourceGraphLookupFrontierBatchSizeBytes;
+
+// If true, the computed fields of $project and $addFields are compiled into a flat instruction
+// sequence after optimization rather than evaluated by walking the expression tree.
+extern AtomicBool internalQueryCompileAggregationExpressions;
+
 extern AtomicBool internalQueryProhibitBlockingMergeOnMongoS;
+
+// If true, a change stream reads the oplog through the SharedOplogReader once it has caught up with
+// the shared scan, rather than scanning the oplog with its own cursor.
+extern AtomicBool internalChangeStreamUseSharedOplogReader;
+
+// The maximum number of oplog entries the shared oplog reader scans before dispatching them.
+extern AtomicInt32 internalChangeStreamSharedOplogReaderBatchSize;
+
+// The maximum number of oplog entries the shared oplog reader buffers for a single change stream.
+// A change stream whose buffer is full goes back to scanning the oplog with its own cursor.
+extern AtomicInt32 internalChangeStreamSharedOplogReaderMaxBufferedEntries;
+
+// The maximum number of change events a fullDocument: "updateLookup" change stream reads ahead so
+// that it can look up the post-images of their updates together.
+extern AtomicInt32 internalChangeStreamPostImageLookupBatchSize;
 }  // namespace mongo
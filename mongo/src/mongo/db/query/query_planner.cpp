@@ -304,6 +304,17 @@ QuerySolution* buildWholeIXSoln(const IndexEntry& index,
     return QueryPlannerAnalysis::analyzeDataAccess(query, params, std::move(solnRoot));
 }
 
+QuerySolution* buildSkipScanSoln(const IndexEntry& index,
+                                 const CanonicalQuery& query,
+                                 const QueryPlannerParams& params) {
+    std::unique_ptr<QuerySolutionNode> solnRoot(
+        QueryPlannerAccess::makeSkipScan(index, query, params));
+    if (!solnRoot) {
+        return NULL;
+    }
+    return QueryPlannerAnalysis::analyzeDataAccess(query, params, std::move(solnRoot));
+}
+
 // For example:
 // - Sparse index {a: 1, b: 1} should be able to provide a sort for
 //	 find({b: 1}).sort({a: 1}).  SERVER-13908.
@@ -509,6 +520,14 @@ Status QueryPlanner::planFromCache(const CanonicalQuery& query,
             *out = soln;
             return Status::OK();
         }
+    } else if (SolutionCacheData::SKIP_SCAN_SOLN == winnerCacheData.solnType) {
+        QuerySolution* soln = buildSkipScanSoln(*winnerCacheData.tree->entry, query, params);
+        if (soln == NULL) {
+            return Status(ErrorCodes::BadValue, "plan cache error: skip scan soln");
+        } else {
+            *out = soln;
+            return Status::OK();
+        }
     } else if (SolutionCacheData::COLLSCAN_SOLN == winnerCacheData.solnType) {
         // The cached solution is a collection scan. We don't cache collscans
         // with tailable==true, hence the false below.
@@ -1325,6 +1344,30 @@ Status QueryPlanner::plan(const CanonicalQuery& query,
         }
     }
 
+    // A compound index whose leading field the query leaves unconstrained can still be used by
+    // seeking to each distinct value of that field in turn, if there are few of them.
+    for (auto&& index : params.indices) {
+        if (!params.skipScanIndexes.count(index.name)) {
+            continue;
+        }
+
+        QuerySolution* soln = buildSkipScanSoln(index, query, params);
+        if (!soln) {
+            continue;
+        }
+
+        LOG(2) << "Planner: outputting a skip scan:" << endl << redact(soln->toString());
+        PlanCacheIndexTree* indexTree = new PlanCacheIndexTree();
+        indexTree->setIndexEntry(index);
+
+        SolutionCacheData* scd = new SolutionCacheData();
+        scd->tree.reset(indexTree);
+        scd->solnType = SolutionCacheData::SKIP_SCAN_SOLN;
+        soln->cacheData.reset(scd);
+
+        out->push_back(soln);
+    }
+
     return Status::OK();
 }
 
@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <set>
+#include <string>
 #include <vector>
 
 #include "mongo/db/jsobj.h"
@@ -111,6 +113,19 @@ struct QueryPlannerParams {
 
         // Set this to track the most recent timestamp seen by this cursor while scanning the oplog.
         TRACK_LATEST_OPLOG_TS = 1 << 12,
+
+        // Set this to allow a collection scan to read the collection's column store, see
+        // 'columnStoreFields' below.
+        USE_COLUMN_STORE = 1 << 13,
+
+        // Set this on a distinct executor which is only worth having if it uses a DISTINCT_SCAN,
+        // such as one answering a $group. No executor is returned otherwise. Multikey and sparse
+        // indexes are not considered, since they do not have exactly one key per document.
+        STRICT_DISTINCT_ONLY = 1 << 14,
+
+        // Set this together with STRICT_DISTINCT_ONLY to run the DISTINCT_SCAN backwards, so that
+        // it returns the last index entry of each distinct value rather than the first.
+        REVERSE_DISTINCT_SCAN = 1 << 15,
     };
 
     // See Options enum above.
@@ -134,6 +149,14 @@ struct QueryPlannerParams {
     // index+query combinations.
     //Ĭ64 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerMaxIndexedSolutions, int, 64);
     size_t maxIndexedSolutions;
+
+    // The fields of the collection's column store, empty if it has none. Only used with
+    // USE_COLUMN_STORE.
+    std::vector<std::string> columnStoreFields;
+
+    // The names of the compound indexes whose leading field has few enough distinct values that
+    // the planner may skip-scan them when the query does not constrain that field.
+    std::set<std::string> skipScanIndexes;
 };
 
 }  // namespace mongo
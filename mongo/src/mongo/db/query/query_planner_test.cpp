@@ -38,6 +38,7 @@
 #include "mongo/db/query/collation/collator_interface_mock.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/query_planner_test_fixture.h"
+#include "mongo/util/scopeguard.h"
 
 namespace {
 
@@ -3406,9 +3407,11 @@ TEST_F(QueryPlannerTest, IntersectCanBeVeryBig) {
 // Ensure that disabling AND_HASH intersection works properly.
 TEST_F(QueryPlannerTest, IntersectDisableAndHash) {
     bool oldEnableHashIntersection = internalQueryPlannerEnableHashIntersection.load();
+    bool oldEnableBitmapIntersection = internalQueryPlannerEnableBitmapIntersection.load();
 
-    // Turn index intersection on but disable hash-based intersection.
+    // Turn index intersection on but disable hash-based and bitmap-based intersection.
     internalQueryPlannerEnableHashIntersection.store(false);
+    internalQueryPlannerEnableBitmapIntersection.store(false);
     params.options = QueryPlannerParams::NO_TABLE_SCAN | QueryPlannerParams::INDEX_INTERSECTION;
 
     addIndex(BSON("a" << 1));
@@ -3435,6 +3438,107 @@ TEST_F(QueryPlannerTest, IntersectDisableAndHash) {
 
     // Restore the old value of the has intersection switch.
     internalQueryPlannerEnableHashIntersection.store(oldEnableHashIntersection);
+    internalQueryPlannerEnableBitmapIntersection.store(oldEnableBitmapIntersection);
+}
+
+// When bitmap intersection is enabled, AND_SORTED is not possible, AND_HASH is disabled and every
+// index scan seeks a few exact keys, we fall back to AND_BITMAP. The bitmap carries no index keys,
+// so the whole predicate must be re-applied by the fetch.
+TEST_F(QueryPlannerTest, IntersectUsesAndBitmapWhenHashDisabled) {
+    bool oldEnableHashIntersection = internalQueryPlannerEnableHashIntersection.load();
+    bool oldEnableBitmapIntersection = internalQueryPlannerEnableBitmapIntersection.load();
+    ON_BLOCK_EXIT([oldEnableHashIntersection, oldEnableBitmapIntersection] {
+        internalQueryPlannerEnableHashIntersection.store(oldEnableHashIntersection);
+        internalQueryPlannerEnableBitmapIntersection.store(oldEnableBitmapIntersection);
+    });
+
+    internalQueryPlannerEnableHashIntersection.store(false);
+    internalQueryPlannerEnableBitmapIntersection.store(true);
+    params.options = QueryPlannerParams::NO_TABLE_SCAN | QueryPlannerParams::INDEX_INTERSECTION;
+
+    addIndex(BSON("a" << 1));
+    addIndex(BSON("b" << 1));
+
+    // The $in scan is not sorted by RecordId, so AND_SORTED is not possible.
+    runQuery(fromjson("{a: {$in: [1, 5]}, b: 1}"));
+
+    assertNumSolutions(3U);
+    assertSolutionExists(
+        "{fetch: {filter: {b: 1}, node: {ixscan: "
+        "{pattern: {a: 1}, bounds: {a: [[1,1,true,true], [5,5,true,true]]}}}}}");
+    assertSolutionExists(
+        "{fetch: {filter: {a: {$in: [1, 5]}}, node: {ixscan: "
+        "{pattern: {b: 1}, bounds: {b: [[1,1,true,true]]}}}}}");
+    assertSolutionExists(
+        "{fetch: {filter: {a: {$in: [1, 5]}, b: 1}, node: {andBitmap: {nodes: ["
+        "{ixscan: {filter: null, pattern: {a:1}}},"
+        "{ixscan: {filter: null, pattern: {b:1}}}]}}}}");
+}
+
+TEST_F(QueryPlannerTest, IntersectDoesNotUseAndBitmapForRangeScans) {
+    bool oldEnableHashIntersection = internalQueryPlannerEnableHashIntersection.load();
+    bool oldEnableBitmapIntersection = internalQueryPlannerEnableBitmapIntersection.load();
+    ON_BLOCK_EXIT([oldEnableHashIntersection, oldEnableBitmapIntersection] {
+        internalQueryPlannerEnableHashIntersection.store(oldEnableHashIntersection);
+        internalQueryPlannerEnableBitmapIntersection.store(oldEnableBitmapIntersection);
+    });
+
+    internalQueryPlannerEnableHashIntersection.store(false);
+    internalQueryPlannerEnableBitmapIntersection.store(true);
+    params.options = QueryPlannerParams::NO_TABLE_SCAN | QueryPlannerParams::INDEX_INTERSECTION;
+
+    addIndex(BSON("a" << 1));
+    addIndex(BSON("b" << 1));
+
+    // A range scan may return most of the collection, which is not worth a bitmap.
+    runQuery(fromjson("{a: {$gt: 1}, b: 1}"));
+
+    assertNumSolutions(2U);
+    assertSolutionExists(
+        "{fetch: {filter: {b: 1}, node: {ixscan: "
+        "{pattern: {a: 1}, bounds: {a: [[1,Infinity,false,true]]}}}}}");
+    assertSolutionExists(
+        "{fetch: {filter: {a: {$gt: 1}}, node: {ixscan: "
+        "{pattern: {b: 1}, bounds: {b: [[1,1,true,true]]}}}}}");
+}
+
+//
+// Skip scans
+//
+
+TEST_F(QueryPlannerTest, SkipScanWhenLeadingFieldUnconstrained) {
+    addIndex(BSON("a" << 1 << "b" << 1));
+    params.skipScanIndexes.insert("hari_king_of_the_stove");
+
+    runQuery(fromjson("{b: {$gte: 3, $lt: 5}, c: 1}"));
+
+    assertNumSolutions(2U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+    assertSolutionExists(
+        "{fetch: {filter: {b: {$gte: 3, $lt: 5}, c: 1}, node: {ixscan: {pattern: {a: 1, b: 1}, "
+        "bounds: {a: [['MinKey','MaxKey',true,true]], b: [[3,5,true,false]]}}}}}");
+}
+
+TEST_F(QueryPlannerTest, NoSkipScanWithoutLowCardinalityPrefix) {
+    addIndex(BSON("a" << 1 << "b" << 1));
+
+    runQuery(fromjson("{b: 3}"));
+
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+}
+
+TEST_F(QueryPlannerTest, NoSkipScanWhenLeadingFieldConstrained) {
+    addIndex(BSON("a" << 1 << "b" << 1));
+    params.skipScanIndexes.insert("hari_king_of_the_stove");
+
+    runQuery(fromjson("{a: {$gt: 1}, b: 3}"));
+
+    assertNumSolutions(2U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+    assertSolutionExists(
+        "{fetch: {filter: null, node: {ixscan: {pattern: {a: 1, b: 1}, "
+        "bounds: {a: [[1,Infinity,false,true]], b: [[3,3,true,true]]}}}}}");
 }
 
 //
@@ -5445,4 +5549,56 @@ TEST_F(QueryPlannerTest, EmptyQueryWithProjectionUsesCollscanIfIndexCollationDif
         "{proj: {spec: {_id: 0, a: 1}, node: "
         "{cscan: {dir: 1}}}}");
 }
+
+//
+// Column store
+//
+
+TEST_F(QueryPlannerTest, ColumnScanWhenProjectionAndFilterAreCovered) {
+    params.options = QueryPlannerParams::USE_COLUMN_STORE;
+    params.columnStoreFields = {"a", "b", "c"};
+    runQueryAsCommand(
+        fromjson("{find: 'testns', filter: {c: {$gt: 1}}, projection: {_id: 0, a: 1}}"));
+    assertNumSolutions(1);
+    assertSolutionExists(
+        "{proj: {spec: {_id: 0, a: 1}, node: "
+        "{columnscan: {fields: ['a', 'c'], filter: {c: {$gt: 1}}}}}}");
+}
+
+TEST_F(QueryPlannerTest, ColumnScanCoversSortFields) {
+    params.options = QueryPlannerParams::USE_COLUMN_STORE;
+    params.columnStoreFields = {"a", "b"};
+    runQueryAsCommand(fromjson("{find: 'testns', projection: {_id: 0, a: 1}, sort: {b: 1}}"));
+    assertNumSolutions(1);
+    assertSolutionExists(
+        "{proj: {spec: {_id: 0, a: 1}, node: {sort: {pattern: {b: 1}, limit: 0, node: "
+        "{sortKeyGen: {node: {columnscan: {fields: ['a', 'b']}}}}}}}}");
+}
+
+TEST_F(QueryPlannerTest, NoColumnScanWhenAFieldIsMissing) {
+    params.options = QueryPlannerParams::USE_COLUMN_STORE;
+    params.columnStoreFields = {"a", "b"};
+    runQueryAsCommand(fromjson("{find: 'testns', filter: {c: 1}, projection: {_id: 0, a: 1}}"));
+    assertNumSolutions(1);
+    assertSolutionExists("{proj: {spec: {_id: 0, a: 1}, node: {cscan: {dir: 1}}}}");
+
+    // The projection includes _id by default.
+    runQueryAsCommand(fromjson("{find: 'testns', projection: {a: 1}}"));
+    assertNumSolutions(1);
+    assertSolutionExists("{proj: {spec: {a: 1}, node: {cscan: {dir: 1}}}}");
+}
+
+TEST_F(QueryPlannerTest, NoColumnScanWithoutProjectionOrOption) {
+    params.options = QueryPlannerParams::USE_COLUMN_STORE;
+    params.columnStoreFields = {"a", "b"};
+    runQueryAsCommand(fromjson("{find: 'testns', filter: {a: 1}}"));
+    assertNumSolutions(1);
+    assertSolutionExists("{cscan: {dir: 1, filter: {a: 1}}}");
+
+    params.options = 0;
+    runQueryAsCommand(fromjson("{find: 'testns', projection: {_id: 0, a: 1}}"));
+    assertNumSolutions(1);
+    assertSolutionExists("{proj: {spec: {_id: 0, a: 1}, node: {cscan: {dir: 1}}}}");
+}
+
 }  // namespace
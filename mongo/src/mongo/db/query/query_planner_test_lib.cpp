@@ -267,6 +267,35 @@ bool QueryPlannerTestLib::solutionMatches(const BSONObj& testSoln,
         }
 
         return filterMatches(filter.Obj(), collation, trueSoln);
+    } else if (STAGE_COLUMN_SCAN == trueSoln->getType()) {
+        const ColumnScanNode* csn = static_cast<const ColumnScanNode*>(trueSoln);
+        BSONElement el = testSoln["columnscan"];
+        if (el.eoo() || !el.isABSONObj()) {
+            return false;
+        }
+        BSONObj csObj = el.Obj();
+
+        BSONElement fields = csObj["fields"];
+        if (fields.eoo() || fields.type() != Array) {
+            return false;
+        }
+        std::vector<std::string> expectedFields;
+        for (auto&& field : fields.Obj()) {
+            expectedFields.push_back(field.str());
+        }
+        if (expectedFields != csn->fields) {
+            return false;
+        }
+
+        BSONElement filter = csObj["filter"];
+        if (filter.eoo()) {
+            return true;
+        } else if (filter.isNull()) {
+            return NULL == csn->filter;
+        } else if (!filter.isABSONObj()) {
+            return false;
+        }
+        return filterMatches(filter.Obj(), BSONObj(), trueSoln);
     } else if (STAGE_IXSCAN == trueSoln->getType()) {
         const IndexScanNode* ixn = static_cast<const IndexScanNode*>(trueSoln);
         BSONElement el = testSoln["ixscan"];
@@ -546,6 +575,13 @@ bool QueryPlannerTestLib::solutionMatches(const BSONObj& testSoln,
         }
 
         return childrenMatch(andSortedObj, asn);
+    } else if (STAGE_AND_BITMAP == trueSoln->getType()) {
+        const AndBitmapNode* abn = static_cast<const AndBitmapNode*>(trueSoln);
+        BSONElement el = testSoln["andBitmap"];
+        if (el.eoo() || !el.isABSONObj()) {
+            return false;
+        }
+        return childrenMatch(el.Obj(), abn);
     } else if (STAGE_PROJECTION == trueSoln->getType()) {
         const ProjectionNode* pn = static_cast<const ProjectionNode*>(trueSoln);
 
@@ -234,6 +234,7 @@ db.runCommand(
       "noCursorTimeout": <bool>,
       "awaitData": <bool>,
       "allowPartialResults": <bool>,
+      "allowDiskUse": <bool>,
       "collation": <document>
    }
 )
@@ -591,6 +592,17 @@ public:
         _allowPartialResults = allowPartialResults;
     }
 
+    /**
+     * Whether a blocking sort may spill to disk rather than fail once it exceeds its memory limit.
+     */
+    bool allowDiskUse() const {
+        return _allowDiskUse;
+    }
+
+    void setAllowDiskUse(bool allowDiskUse) {
+        _allowDiskUse = allowDiskUse;
+    }
+
     boost::optional<long long> getReplicationTerm() const {
         return _replicationTerm;
     }
@@ -727,6 +739,7 @@ private:
     bool _noCursorTimeout = false;
     bool _exhaust = false;
     bool _allowPartialResults = false;
+    bool _allowDiskUse = false;
 
     boost::optional<long long> _replicationTerm;
 };
@@ -26,6 +26,7 @@
  *    it in the license file.
  */
 
+#include <algorithm>
 #include <vector>
 
 #include "mongo/db/query/query_solution.h"
@@ -260,6 +261,46 @@ QuerySolutionNode* CollectionScanNode::clone() const {
     return copy;
 }
 
+//
+// ColumnScanNode
+//
+
+ColumnScanNode::ColumnScanNode() : _sort(SimpleBSONObjComparator::kInstance.makeBSONObjSet()) {}
+
+bool ColumnScanNode::hasField(const std::string& field) const {
+    const StringData topLevelField = StringData(field).substr(0, field.find('.'));
+    return std::find(fields.begin(), fields.end(), topLevelField) != fields.end();
+}
+
+void ColumnScanNode::appendToString(mongoutils::str::stream* ss, int indent) const {
+    addIndent(ss, indent);
+    *ss << "COLUMN_SCAN\n";
+    addIndent(ss, indent + 1);
+    *ss << "ns = " << name << '\n';
+    addIndent(ss, indent + 1);
+    *ss << "fields = [";
+    for (size_t i = 0; i < fields.size(); i++) {
+        *ss << (i ? ", " : "") << fields[i];
+    }
+    *ss << "]\n";
+    if (NULL != filter) {
+        addIndent(ss, indent + 1);
+        *ss << "filter = " << filter->toString();
+    }
+    addCommon(ss, indent);
+}
+
+QuerySolutionNode* ColumnScanNode::clone() const {
+    ColumnScanNode* copy = new ColumnScanNode();
+    cloneBaseData(copy);
+
+    copy->_sort = this->_sort;
+    copy->name = this->name;
+    copy->fields = this->fields;
+
+    return copy;
+}
+
 //
 // AndHashNode
 //
@@ -366,6 +407,34 @@ QuerySolutionNode* AndSortedNode::clone() const {
     return copy;
 }
 
+//
+// AndBitmapNode
+//
+
+AndBitmapNode::AndBitmapNode() : _sort(SimpleBSONObjComparator::kInstance.makeBSONObjSet()) {}
+
+AndBitmapNode::~AndBitmapNode() {}
+
+void AndBitmapNode::appendToString(mongoutils::str::stream* ss, int indent) const {
+    addIndent(ss, indent);
+    *ss << "AND_BITMAP\n";
+    addCommon(ss, indent);
+    for (size_t i = 0; i < children.size(); ++i) {
+        addIndent(ss, indent + 1);
+        *ss << "Child " << i << ":\n";
+        children[i]->appendToString(ss, indent + 1);
+    }
+}
+
+QuerySolutionNode* AndBitmapNode::clone() const {
+    AndBitmapNode* copy = new AndBitmapNode();
+    cloneBaseData(copy);
+
+    copy->_sort = this->_sort;
+
+    return copy;
+}
+
 //
 // OrNode
 //
@@ -545,7 +614,9 @@ IndexScanNode::IndexScanNode(IndexEntry index)
       direction(1),
       maxScan(0),
       addKeyMetadata(false),
-      queryCollator(nullptr) {}
+      queryCollator(nullptr),
+      estimatedKeys(-1),
+      skipScan(false) {}
 
 void IndexScanNode::appendToString(mongoutils::str::stream* ss, int indent) const {
     addIndent(ss, indent);
@@ -561,6 +632,10 @@ void IndexScanNode::appendToString(mongoutils::str::stream* ss, int indent) cons
     *ss << "direction = " << direction << '\n';
     addIndent(ss, indent + 1);
     *ss << "bounds = " << bounds.toString() << '\n';
+    if (skipScan) {
+        addIndent(ss, indent + 1);
+        *ss << "skipScan = 1\n";
+    }
     addCommon(ss, indent);
 }
 
@@ -821,6 +896,8 @@ QuerySolutionNode* IndexScanNode::clone() const {
     copy->addKeyMetadata = this->addKeyMetadata;
     copy->bounds = this->bounds;
     copy->queryCollator = this->queryCollator;
+    copy->estimatedKeys = this->estimatedKeys;
+    copy->skipScan = this->skipScan;
 
     return copy;
 }
@@ -1173,6 +1250,10 @@ void CountScanNode::appendToString(mongoutils::str::stream* ss, int indent) cons
     *ss << "startKey = " << startKey << '\n';
     addIndent(ss, indent + 1);
     *ss << "endKey = " << endKey << '\n';
+    if (!bounds.fields.empty()) {
+        addIndent(ss, indent + 1);
+        *ss << "bounds = " << bounds.toString() << '\n';
+    }
 }
 
 QuerySolutionNode* CountScanNode::clone() const {
@@ -1184,6 +1265,7 @@ QuerySolutionNode* CountScanNode::clone() const {
     copy->startKeyInclusive = this->startKeyInclusive;
     copy->endKey = this->endKey;
     copy->endKeyInclusive = this->endKeyInclusive;
+    copy->bounds = this->bounds;
 
     return copy;
 }
@@ -337,6 +337,42 @@ struct CollectionScanNode : public QuerySolutionNode {
     int maxScan;
 };
 
+/**
+ * Scans the column store of a collection. Produces owned objects holding only 'fields', which the
+ * planner has checked to cover everything the query needs.
+ */
+struct ColumnScanNode : public QuerySolutionNode {
+    ColumnScanNode();
+    virtual ~ColumnScanNode() {}
+
+    virtual StageType getType() const {
+        return STAGE_COLUMN_SCAN;
+    }
+
+    virtual void appendToString(mongoutils::str::stream* ss, int indent) const;
+
+    bool fetched() const {
+        return true;
+    }
+    bool hasField(const std::string& field) const;
+    bool sortedByDiskLoc() const {
+        return false;
+    }
+    const BSONObjSet& getSort() const {
+        return _sort;
+    }
+
+    QuerySolutionNode* clone() const;
+
+    BSONObjSet _sort;
+
+    // Name of the namespace.
+    std::string name;
+
+    // The top-level fields read from the column store.
+    std::vector<std::string> fields;
+};
+
 
 /*
 ³룺 ͬһѯÿֶθ
@@ -446,6 +482,39 @@ struct AndSortedNode : public QuerySolutionNode {
     BSONObjSet _sort;
 };
 
+/**
+ * Intersects the RecordIds of its children with compressed bitmaps. Outputs RecordIds only, in
+ * RecordId order, so it never provides fetched data or covers fields: the planner always puts a
+ * FETCH with the full filter above it.
+ */
+struct AndBitmapNode : public QuerySolutionNode {
+    AndBitmapNode();
+    virtual ~AndBitmapNode();
+
+    virtual StageType getType() const {
+        return STAGE_AND_BITMAP;
+    }
+
+    virtual void appendToString(mongoutils::str::stream* ss, int indent) const;
+
+    bool fetched() const {
+        return false;
+    }
+    bool hasField(const std::string& field) const {
+        return false;
+    }
+    bool sortedByDiskLoc() const {
+        return true;
+    }
+    const BSONObjSet& getSort() const {
+        return _sort;
+    }
+
+    QuerySolutionNode* clone() const;
+
+    BSONObjSet _sort;
+};
+
 struct OrNode : public QuerySolutionNode {
     OrNode();
     virtual ~OrNode();
@@ -595,6 +664,14 @@ struct IndexScanNode : public QuerySolutionNode {
     //
     // The correct set of paths is computed and stored here by computeProperties().
     std::set<StringData> multikeyFields;
+
+    // Number of index keys this scan is expected to examine, as estimated from collection
+    // statistics by the CardinalityEstimator. Negative if no estimate is available.
+    long long estimatedKeys;
+
+    // Set on scans built by QueryPlannerAccess::makeSkipScan, whose leading field is unbounded
+    // and which rely on seeking past each of its distinct values.
+    bool skipScan;
 };
 
 struct ProjectionNode : public QuerySolutionNode {
@@ -1049,6 +1126,10 @@ struct CountScanNode : public QuerySolutionNode {
 
     BSONObj endKey;
     bool endKeyInclusive;
+
+    // When not empty, the keys to count are those within these bounds, which may be made of
+    // several intervals, and startKey/endKey are unused.
+    IndexBounds bounds;
 };
 
 /**
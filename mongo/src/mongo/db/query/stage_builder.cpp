@@ -36,9 +36,11 @@
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/client.h"
+#include "mongo/db/exec/and_bitmap.h"
 #include "mongo/db/exec/and_hash.h"
 #include "mongo/db/exec/and_sorted.h"
 #include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/column_scan.h"
 #include "mongo/db/exec/count_scan.h"
 #include "mongo/db/exec/distinct_scan.h"
 #include "mongo/db/exec/ensure_sorted.h"
@@ -85,6 +87,10 @@ PlanStage* buildStages(OperationContext* opCtx,     //
             params.maxScan = csn->maxScan;
             return new CollectionScan(opCtx, params, ws, csn->filter.get());
         }
+        case STAGE_COLUMN_SCAN: {
+            const ColumnScanNode* csn = static_cast<const ColumnScanNode*>(root);
+            return new ColumnScan(opCtx, collection, csn->fields, ws, csn->filter.get());
+        }
         case STAGE_IXSCAN: {
             const IndexScanNode* ixn = static_cast<const IndexScanNode*>(root);
 
@@ -103,6 +109,8 @@ PlanStage* buildStages(OperationContext* opCtx,     //
             params.direction = ixn->direction;
             params.maxScan = ixn->maxScan;
             params.addKeyMetadata = ixn->addKeyMetadata;
+            params.estimatedKeys = ixn->estimatedKeys;
+            params.skipScan = ixn->skipScan;
             return new IndexScan(opCtx, params, ws, ixn->filter.get());
         }
         case STAGE_FETCH: {
@@ -125,6 +133,7 @@ PlanStage* buildStages(OperationContext* opCtx,     //
             params.collection = collection;
             params.pattern = sn->pattern;
             params.limit = sn->limit;
+            params.allowDiskUse = cq.getQueryRequest().allowDiskUse();
             return new SortStage(opCtx, params, ws, childStage);
         }
         case STAGE_SORT_KEY_GENERATOR: {
@@ -196,6 +205,19 @@ PlanStage* buildStages(OperationContext* opCtx,     //
             }
             return ret.release();
         }
+        case STAGE_AND_BITMAP: {
+            const AndBitmapNode* abn = static_cast<const AndBitmapNode*>(root);
+            auto ret = make_unique<AndBitmapStage>(opCtx, ws, collection);
+            for (size_t i = 0; i < abn->children.size(); ++i) {
+                PlanStage* childStage =
+                    buildStages(opCtx, collection, cq, qsol, abn->children[i], ws);
+                if (nullptr == childStage) {
+                    return nullptr;
+                }
+                ret->addChild(childStage);
+            }
+            return ret.release();
+        }
         case STAGE_OR: {
             const OrNode* orn = static_cast<const OrNode*>(root);
             auto ret = make_unique<OrStage>(opCtx, ws, orn->dedup, orn->filter.get());
@@ -352,6 +374,7 @@ PlanStage* buildStages(OperationContext* opCtx,     //
             params.startKeyInclusive = csn->startKeyInclusive;
             params.endKey = csn->endKey;
             params.endKeyInclusive = csn->endKeyInclusive;
+            params.bounds = csn->bounds;
 
             return new CountScan(opCtx, params, ws);
         }
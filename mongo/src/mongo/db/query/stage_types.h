@@ -128,6 +128,12 @@ enum StageType { //
     STAGE_TEXT_OR,
     STAGE_TEXT_MATCH, //35
 
+    // Scans the column store of a collection instead of its documents.
+    STAGE_COLUMN_SCAN,
+
+    // Intersects the RecordIds of its children using compressed bitmaps.
+    STAGE_AND_BITMAP,
+
     STAGE_UNKNOWN,
 
     STAGE_UPDATE,
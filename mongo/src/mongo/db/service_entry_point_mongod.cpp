@@ -1336,6 +1336,7 @@ DbResponse ServiceEntryPointMongod::handleRequest(OperationContext* opCtx, const
     currentOp.done(); //ʱȷʼʱ//execCommandDatabase->ensureStarted
 	//ȡrunCommandsִʱ䣬Ҳڲʱ
     debug.executionTimeMicros = durationCount<Microseconds>(currentOp.elapsedTimeExcludingPauses());
+    debug.setResourceUsageMetrics(opCtx, currentOp);
 
 	//mongodдʱӳͳ  db.serverStatus().opLatencies  
     Top::get(opCtx->getServiceContext())
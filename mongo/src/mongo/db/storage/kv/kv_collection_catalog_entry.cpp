@@ -344,6 +344,12 @@ void KVCollectionCatalogEntry::setIsTemp(OperationContext* opCtx, bool isTemp) {
     _catalog->putMetaData(opCtx, ns().toString(), md);
 }
 
+void KVCollectionCatalogEntry::setIndexesIncomplete(OperationContext* opCtx, bool incomplete) {
+    MetaData md = _getMetaData(opCtx);
+    md.options.indexesIncomplete = incomplete;
+    _catalog->putMetaData(opCtx, ns().toString(), md);
+}
+
 void KVCollectionCatalogEntry::updateCappedSize(OperationContext* opCtx, long long size) {
     MetaData md = _getMetaData(opCtx);
     md.options.cappedSize = size;
@@ -88,6 +88,8 @@ public:
 
     void setIsTemp(OperationContext* opCtx, bool isTemp);
 
+    void setIndexesIncomplete(OperationContext* opCtx, bool incomplete) final;
+
     void updateCappedSize(OperationContext*, long long int) final;
 
     void addUUID(OperationContext* opCtx, CollectionUUID uuid, Collection* coll) final;
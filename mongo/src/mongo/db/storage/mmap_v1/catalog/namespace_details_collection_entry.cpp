@@ -501,6 +501,12 @@ void NamespaceDetailsCollectionCatalogEntry::setIsTemp(OperationContext* opCtx,
     _updateSystemNamespaces(opCtx, BSON("$set" << BSON("options.temp" << isTemp)));
 }
 
+void NamespaceDetailsCollectionCatalogEntry::setIndexesIncomplete(OperationContext* opCtx,
+                                                                  bool incomplete) {
+    _updateSystemNamespaces(opCtx,
+                            BSON("$set" << BSON("options.indexesIncomplete" << incomplete)));
+}
+
 
 void NamespaceDetailsCollectionCatalogEntry::setNamespacesRecordId(OperationContext* opCtx,
                                                                    RecordId newId) {
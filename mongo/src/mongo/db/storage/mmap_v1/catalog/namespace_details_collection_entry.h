@@ -111,6 +111,8 @@ public:
 
     void setIsTemp(OperationContext* opCtx, bool isTemp) final;
 
+    void setIndexesIncomplete(OperationContext* opCtx, bool incomplete) final;
+
     void updateCappedSize(OperationContext* opCtx, long long size) final;
 
     // not part of interface, but available to my storage engine
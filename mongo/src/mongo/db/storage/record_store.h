@@ -549,6 +549,25 @@ public:
         return out;
     }
 
+    /**
+     * Returns the top-level fields that this record store also keeps in a column store, next to
+     * the full documents. Empty unless the collection was created with a column store.
+     */
+    virtual std::vector<std::string> getColumnStoreFields() const {
+        return {};
+    }
+
+    /**
+     * Constructs a forward cursor over the column store. For every record it returns a document
+     * holding only those of 'fields' present in the record, in their original order. 'fields'
+     * must be a subset of getColumnStoreFields(); reading fewer fields reads less data. Returns
+     * NULL if there is no column store.
+     */
+    virtual std::unique_ptr<RecordCursor> getColumnStoreCursor(
+        OperationContext* opCtx, const std::vector<std::string>& fields) const {
+        return {};
+    }
+
     // higher level
 
 
@@ -74,6 +74,23 @@ public:
      */
     virtual void reportState(BSONObjBuilder* b) const {}
 
+    /**
+     * Storage engine work done on behalf of the operations using this recovery unit, counted from
+     * its creation. CurOp reports the part of it done while each operation ran in the profiler and
+     * the slow query log.
+     */
+    struct OperationStatistics {
+        long long bytesRead = 0;
+        long long bytesWritten = 0;
+    };
+
+    /**
+     * Returns the statistics above. Storage engines which do not track them return all zeros.
+     */
+    virtual OperationStatistics getOperationStatistics() const {
+        return {};
+    }
+
     /**
      * These should be called through WriteUnitOfWork rather than directly.
      *
@@ -0,0 +1,421 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/wiredtiger/wiredtiger_cache_warmer.h"
+
+#include <algorithm>
+#include <boost/filesystem/operations.hpp>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "mongo/bson/bson_validate.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/client.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/mmap_v1/paths.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
+#include "mongo/util/concurrency/idle_thread_block.h"
+#include "mongo/util/file.h"
+#include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+namespace {
+
+// Records the working set and warms the cache up from it on the next startup.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(wiredTigerCacheWarmupEnabled, bool, false);
+
+// Upper bound on the rate at which the warm-up loads data into the cache. 0 means unlimited.
+MONGO_EXPORT_SERVER_PARAMETER(wiredTigerCacheWarmupMaxMBPerSec, int, 100);
+
+// How often the working set is recorded while running, in addition to on clean shutdown. 0 means
+// only on clean shutdown.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(wiredTigerCacheWarmupRecordIntervalSecs, int, 600);
+
+const int kManifestVersion = 1;
+
+// Stop warming up once the cache reaches WiredTiger's default eviction target, so that the warm-up
+// never evicts pages brought in by the actual workload.
+const int kMaxCacheFillPercent = 80;
+
+// Number of cursor steps between two checks of a table's cache footprint.
+const int kCursorStepsPerBatch = 256;
+
+// A table is considered fully loaded by random sampling once this many batches in a row did not
+// grow its footprint.
+const int kMaxStalledBatches = 8;
+
+enum class WarmupState { kIdle, kWarming, kDone };
+
+AtomicWord<WarmupState> warmupState(WarmupState::kIdle);
+AtomicInt64 tablesToWarm;
+AtomicInt64 tablesWarmed;
+AtomicInt64 bytesTarget;
+AtomicInt64 bytesLoaded;
+AtomicInt64 warmupMillis;
+AtomicInt64 lastRecordedMillis;
+AtomicInt64 tablesRecorded;
+
+const char* stateToString(WarmupState state) {
+    switch (state) {
+        case WarmupState::kIdle:
+            return "idle";
+        case WarmupState::kWarming:
+            return "warming";
+        case WarmupState::kDone:
+            return "done";
+    }
+    MONGO_UNREACHABLE;
+}
+
+}  // namespace
+
+const char* WiredTigerCacheWarmer::kManifestFileName = "cacheWarmup.bson";
+
+bool WiredTigerCacheWarmer::isEnabled() {
+    return wiredTigerCacheWarmupEnabled;
+}
+
+WiredTigerCacheWarmer::WiredTigerCacheWarmer(WT_CONNECTION* conn, const std::string& dbpath)
+    : BackgroundJob(false /* deleteSelf */),
+      _manifestPath((boost::filesystem::path(dbpath) / kManifestFileName).string()),
+      _session(conn) {}
+
+void WiredTigerCacheWarmer::run() {
+    Client::initThread(name().c_str());
+
+    LOG(1) << "starting " << name() << " thread";
+
+    BSONObj manifest = readManifest();
+    if (!manifest.isEmpty()) {
+        warmUp(manifest);
+    }
+
+    const int intervalSecs = wiredTigerCacheWarmupRecordIntervalSecs;
+    while (!_shuttingDown.load()) {
+        const int64_t waitMillis = intervalSecs > 0 ? intervalSecs * 1000LL : 60 * 1000LL;
+        if (!_sleepUnlessShuttingDown(waitMillis)) {
+            break;
+        }
+        if (intervalSecs > 0) {
+            recordWorkingSet();
+        }
+    }
+
+    LOG(1) << "stopping " << name() << " thread";
+}
+
+void WiredTigerCacheWarmer::shutdown() {
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _shuttingDown.store(true);
+    }
+    _condvar.notify_one();
+    wait();
+
+    // A warm-up interrupted by shutdown has only loaded part of the previous working set. Keep the
+    // previous manifest rather than replacing it with the partial picture.
+    if (warmupState.load() != WarmupState::kWarming) {
+        recordWorkingSet();
+    }
+}
+
+void WiredTigerCacheWarmer::recordWorkingSet() {
+    WT_SESSION* session = _session.getSession();
+
+    std::vector<std::string> uris;
+    {
+        WT_CURSOR* cursor;
+        int ret = session->open_cursor(session, "metadata:", nullptr, nullptr, &cursor);
+        if (ret != 0) {
+            warning() << "Unable to list tables to record the cache working set: "
+                      << wiredtiger_strerror(ret);
+            return;
+        }
+        ON_BLOCK_EXIT(cursor->close, cursor);
+
+        while (cursor->next(cursor) == 0) {
+            const char* key;
+            invariantWTOK(cursor->get_key(cursor, &key));
+            StringData uri(key);
+            if (uri.startsWith("table:")) {
+                uris.push_back(uri.toString());
+            }
+        }
+    }
+
+    // (cached bytes, uri, size on disk) of every table with data in the cache.
+    std::vector<std::pair<int64_t, std::pair<std::string, int64_t>>> tables;
+    for (auto&& uri : uris) {
+        int64_t cachedBytes = _cachedBytes(uri);
+        if (cachedBytes <= 0) {
+            continue;
+        }
+        auto size = WiredTigerUtil::getStatisticsValueAs<int64_t>(
+            session, "statistics:" + uri, "statistics=(fast)", WT_STAT_DSRC_BLOCK_SIZE);
+        tables.push_back({cachedBytes, {uri, size.isOK() ? size.getValue() : 0}});
+    }
+    std::sort(tables.begin(), tables.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first > rhs.first;
+    });
+
+    BSONObjBuilder builder;
+    builder.append("version", kManifestVersion);
+    builder.appendDate("recorded", Date_t::now());
+    {
+        BSONArrayBuilder arr(builder.subarrayStart("tables"));
+        for (auto&& table : tables) {
+            arr.append(BSON("uri" << table.second.first << "cachedBytes"
+                                  << static_cast<long long>(table.first)
+                                  << "size"
+                                  << static_cast<long long>(table.second.second)));
+        }
+    }
+    BSONObj manifest = builder.obj();
+
+    // Write to a temporary file first so that a crash never leaves a truncated manifest behind:
+    // 1) write and fsync the temporary file.
+    // 2) rename it over the manifest.
+    // 3) fsync the directory, so that the rename itself survives a crash.
+    const std::string tmpPath = _manifestPath + ".tmp";
+    {
+        std::ofstream out(tmpPath.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(manifest.objdata(), manifest.objsize());
+        out.close();
+        if (!out) {
+            warning() << "Unable to write the cache working set to " << tmpPath;
+            return;
+        }
+    }
+    {
+        File file;
+        file.open(tmpPath.c_str(), /*read-only*/ false, /*direct-io*/ false);
+        if (!file.is_open()) {
+            warning() << "Unable to open " << tmpPath << " to flush the cache working set";
+            return;
+        }
+        file.fsync();
+    }
+    boost::system::error_code ec;
+    boost::filesystem::rename(tmpPath, _manifestPath, ec);
+    if (ec) {
+        warning() << "Unable to rename " << tmpPath << " to " << _manifestPath << ": "
+                  << ec.message();
+        return;
+    }
+    try {
+        flushMyDirectory(_manifestPath);
+    } catch (const DBException& ex) {
+        warning() << "Unable to flush the directory of " << _manifestPath << ": " << redact(ex);
+        return;
+    }
+
+    tablesRecorded.store(tables.size());
+    lastRecordedMillis.store(Date_t::now().toMillisSinceEpoch());
+    LOG(1) << "Recorded the cache footprint of " << tables.size() << " tables in "
+           << _manifestPath;
+}
+
+BSONObj WiredTigerCacheWarmer::readManifest() const {
+    std::ifstream in(_manifestPath.c_str(), std::ios::binary);
+    if (!in) {
+        return BSONObj();
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    const std::string data = buffer.str();
+
+    if (!validateBSON(data.data(), data.size(), BSONVersion::kLatest).isOK() ||
+        BSONObj(data.data()).getIntField("version") != kManifestVersion) {
+        warning() << "Ignoring invalid cache warm-up manifest " << _manifestPath;
+        return BSONObj();
+    }
+    return BSONObj(data.data()).getOwned();
+}
+
+void WiredTigerCacheWarmer::warmUp(const BSONObj& manifest) {
+    const long long startMillis = curTimeMillis64();
+    warmupState.store(WarmupState::kWarming);
+    tablesWarmed.store(0);
+    bytesTarget.store(0);
+    bytesLoaded.store(0);
+
+    std::vector<BSONObj> tables;
+    BSONElement tablesElem = manifest["tables"];
+    if (tablesElem.type() == Array) {
+        for (auto&& elem : tablesElem.Obj()) {
+            if (elem.type() != Object) {
+                continue;
+            }
+            tables.push_back(elem.Obj());
+            bytesTarget.fetchAndAdd(elem.Obj()["cachedBytes"].safeNumberLong());
+        }
+    }
+    tablesToWarm.store(tables.size());
+
+    log() << "Warming up the WiredTiger cache with " << tables.size() << " tables totaling to "
+          << bytesTarget.load() << " bytes, recorded at " << manifest["recorded"].date();
+
+    for (auto&& table : tables) {
+        if (_shuttingDown.load()) {
+            break;
+        }
+        const int cacheFillPercent = WiredTigerUtil::getCacheFillPercent(_session.getSession());
+        if (cacheFillPercent >= kMaxCacheFillPercent) {
+            log() << "Stopping the cache warm-up, the cache is " << cacheFillPercent << "% full";
+            break;
+        }
+
+        const int64_t cachedBytes = table["cachedBytes"].safeNumberLong();
+        const int64_t size = table["size"].safeNumberLong();
+
+        // Scanning a table that was (almost) fully cached is cheaper than sampling it.
+        const bool sequential = size > 0 && cachedBytes * 10 >= size * 9;
+        _warmTable(table["uri"].str(), cachedBytes, sequential);
+        tablesWarmed.addAndFetch(1);
+        warmupMillis.store(curTimeMillis64() - startMillis);
+    }
+
+    warmupMillis.store(curTimeMillis64() - startMillis);
+    if (!_shuttingDown.load()) {
+        warmupState.store(WarmupState::kDone);
+    }
+    log() << "Finished warming up the WiredTiger cache, loaded " << bytesLoaded.load()
+          << " bytes from " << tablesWarmed.load() << " tables in " << warmupMillis.load()
+          << "ms";
+}
+
+int64_t WiredTigerCacheWarmer::_warmTable(const std::string& uri,
+                                          int64_t targetBytes,
+                                          bool sequential) {
+    const int64_t initialBytes = _cachedBytes(uri);
+    if (initialBytes < 0 || initialBytes >= targetBytes) {
+        return 0;
+    }
+
+    WT_SESSION* session = _session.getSession();
+    WT_CURSOR* cursor;
+    const char* config = sequential ? "raw" : "raw,next_random=true";
+    int ret = session->open_cursor(session, uri.c_str(), nullptr, config, &cursor);
+    if (ret != 0) {
+        LOG(1) << "Skipping " << uri << " during cache warm-up: " << wiredtiger_strerror(ret);
+        return 0;
+    }
+    ON_BLOCK_EXIT(cursor->close, cursor);
+
+    LOG(1) << "Warming up " << uri << (sequential ? " by scanning" : " by sampling") << " until "
+           << targetBytes << " bytes are cached";
+
+    const long long startMillis = curTimeMillis64();
+    int64_t cachedBytes = initialBytes;
+    int stalledBatches = 0;
+    bool exhausted = false;
+    while (!exhausted && cachedBytes < targetBytes && !_shuttingDown.load()) {
+        for (int i = 0; i < kCursorStepsPerBatch; ++i) {
+            ret = cursor->next(cursor);
+            if (ret != 0) {
+                // WT_NOTFOUND at the end of a scan, or any error. Either way, move on.
+                exhausted = true;
+                break;
+            }
+        }
+
+        const int64_t nowCached = _cachedBytes(uri);
+        if (nowCached < 0) {
+            break;
+        }
+        if (nowCached > cachedBytes) {
+            bytesLoaded.fetchAndAdd(nowCached - cachedBytes);
+            stalledBatches = 0;
+        } else if (++stalledBatches >= kMaxStalledBatches) {
+            break;
+        }
+        cachedBytes = std::max(cachedBytes, nowCached);
+
+        _throttle(startMillis, cachedBytes - initialBytes);
+    }
+
+    // Do not keep the last page pinned.
+    cursor->reset(cursor);
+    return cachedBytes - initialBytes;
+}
+
+int64_t WiredTigerCacheWarmer::_cachedBytes(const std::string& uri) const {
+    auto result = WiredTigerUtil::getStatisticsValueAs<int64_t>(_session.getSession(),
+                                                                "statistics:" + uri,
+                                                                "statistics=(fast)",
+                                                                WT_STAT_DSRC_CACHE_BYTES_INUSE);
+    return result.isOK() ? result.getValue() : -1;
+}
+
+void WiredTigerCacheWarmer::_throttle(long long startMillis, int64_t bytes) {
+    const int maxMBPerSec = wiredTigerCacheWarmupMaxMBPerSec.load();
+    if (maxMBPerSec <= 0) {
+        return;
+    }
+    const int64_t expectedMillis = bytes * 1000 / (int64_t(maxMBPerSec) * 1024 * 1024);
+    const int64_t elapsedMillis = curTimeMillis64() - startMillis;
+    if (expectedMillis > elapsedMillis) {
+        _sleepUnlessShuttingDown(expectedMillis - elapsedMillis);
+    }
+}
+
+bool WiredTigerCacheWarmer::_sleepUnlessShuttingDown(int64_t millis) {
+    stdx::unique_lock<stdx::mutex> lock(_mutex);
+    MONGO_IDLE_THREAD_BLOCK;
+    _condvar.wait_for(lock, stdx::chrono::milliseconds(millis), [this] {
+        return _shuttingDown.load();
+    });
+    return !_shuttingDown.load();
+}
+
+void WiredTigerCacheWarmer::appendGlobalStats(BSONObjBuilder& b) {
+    BSONObjBuilder bb(b.subobjStart("cacheWarmup"));
+    bb.append("state", stateToString(warmupState.load()));
+    bb.append("tablesToWarm", static_cast<long long>(tablesToWarm.load()));
+    bb.append("tablesWarmed", static_cast<long long>(tablesWarmed.load()));
+    bb.append("bytesTarget", static_cast<long long>(bytesTarget.load()));
+    bb.append("bytesLoaded", static_cast<long long>(bytesLoaded.load()));
+    bb.append("elapsedMillis", static_cast<long long>(warmupMillis.load()));
+    bb.append("tablesRecorded", static_cast<long long>(tablesRecorded.load()));
+    if (lastRecordedMillis.load()) {
+        bb.appendDate("lastRecorded", Date_t::fromMillisSinceEpoch(lastRecordedMillis.load()));
+    }
+    bb.done();
+}
+
+}  // namespace mongo
@@ -0,0 +1,121 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <wiredtiger.h>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/background.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+
+/**
+ * Shortens the period of cold-cache latency after a restart.
+ *
+ * WiredTiger does not expose which pages are resident in its cache, so the working set is
+ * approximated per table: the warmer periodically, and once more on clean shutdown, records how
+ * many bytes of every table are in the cache into a manifest in the dbpath. On startup, a
+ * background thread reads the manifest and loads the hottest tables back into the cache until each
+ * one reaches its recorded footprint, limited to a configurable IO bandwidth. Tables that were
+ * (almost) entirely cached are scanned sequentially, others are loaded by sampling random pages.
+ *
+ * Progress is reported in serverStatus().wiredTiger.cacheWarmup.
+ */
+class WiredTigerCacheWarmer : public BackgroundJob {
+    MONGO_DISALLOW_COPYING(WiredTigerCacheWarmer);
+
+public:
+    static const char* kManifestFileName;
+
+    // True if the server was started with wiredTigerCacheWarmupEnabled.
+    static bool isEnabled();
+
+    WiredTigerCacheWarmer(WT_CONNECTION* conn, const std::string& dbpath);
+
+    std::string name() const override {
+        return "WTCacheWarmer";
+    }
+
+    void run() override;
+
+    /**
+     * Stops the background thread and then records the current working set one last time. Must be
+     * called before the WiredTiger connection is closed.
+     */
+    void shutdown();
+
+    /**
+     * Writes the cache footprint of every table to the manifest, hottest table first.
+     */
+    void recordWorkingSet();
+
+    /**
+     * Returns the manifest currently stored in the dbpath, or an empty object if there is none or
+     * it cannot be read.
+     */
+    BSONObj readManifest() const;
+
+    /**
+     * Loads the tables listed in 'manifest' into the cache. Returns early on shutdown or when the
+     * cache has filled up.
+     */
+    void warmUp(const BSONObj& manifest);
+
+    static void appendGlobalStats(BSONObjBuilder& b);
+
+private:
+    // Loads 'uri' into the cache until it holds 'targetBytes'. Returns the number of bytes loaded.
+    int64_t _warmTable(const std::string& uri, int64_t targetBytes, bool sequential);
+
+    // Returns the number of bytes of 'uri' in the cache, or -1 if the table cannot be inspected.
+    int64_t _cachedBytes(const std::string& uri) const;
+
+    // Sleeps long enough to keep the load rate below the configured bandwidth since 'startMillis'.
+    void _throttle(long long startMillis, int64_t bytesLoaded);
+
+    bool _sleepUnlessShuttingDown(int64_t millis);
+
+    const std::string _manifestPath;
+    const WiredTigerSession _session;  // Used by the background thread, then by shutdown().
+
+    stdx::mutex _mutex;
+    stdx::condition_variable _condvar;
+    AtomicBool _shuttingDown{false};
+};
+
+}  // namespace mongo
@@ -0,0 +1,426 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/wiredtiger/wiredtiger_column_store.h"
+
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+
+#include "mongo/base/parse_number.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_global_options.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+
+namespace {
+
+const char kUriSuffix[] = ".columns";
+const size_t kMaxFields = 64;
+
+std::string columnName(size_t i) {
+    return str::stream() << "c" << i;
+}
+
+/**
+ * Packs a RecordId into a raw key for the column store table.
+ */
+class RawKey {
+public:
+    RawKey(WT_SESSION* session, const RecordId& id) {
+        invariantWTOK(wiredtiger_struct_size(session, &_size, "q", id.repr()));
+        invariant(_size <= sizeof(_buf));
+        invariantWTOK(wiredtiger_struct_pack(session, _buf, sizeof(_buf), "q", id.repr()));
+    }
+
+    WiredTigerItem item() const {
+        return WiredTigerItem(_buf, _size);
+    }
+
+private:
+    char _buf[16];
+    size_t _size;
+};
+
+}  // namespace
+
+const char* WiredTigerColumnStore::kOptionName = "columnStore";
+
+StatusWith<std::vector<std::string>> WiredTigerColumnStore::parseFields(const BSONElement& elem) {
+    if (elem.type() != Array) {
+        return {ErrorCodes::InvalidOptions,
+                str::stream() << "'" << kOptionName << "' must be an array of field names"};
+    }
+
+    std::vector<std::string> fields;
+    for (auto&& field : elem.Obj()) {
+        if (field.type() != String) {
+            return {ErrorCodes::InvalidOptions,
+                    str::stream() << "'" << kOptionName << "' must be an array of field names"};
+        }
+        const StringData name = field.valueStringData();
+        if (name.empty() || name[0] == '$' || name.find('.') != std::string::npos) {
+            return {ErrorCodes::InvalidOptions,
+                    str::stream() << "'" << name << "' is not a valid column store field, only "
+                                                    "top-level field names are supported"};
+        }
+        if (std::find(fields.begin(), fields.end(), name) != fields.end()) {
+            return {ErrorCodes::InvalidOptions,
+                    str::stream() << "duplicate column store field '" << name << "'"};
+        }
+        fields.push_back(name.toString());
+    }
+
+    if (fields.empty() || fields.size() > kMaxFields) {
+        return {ErrorCodes::InvalidOptions,
+                str::stream() << "'" << kOptionName << "' must name between 1 and " << kMaxFields
+                              << " fields"};
+    }
+    return {std::move(fields)};
+}
+
+std::vector<std::string> WiredTigerColumnStore::getFields(const BSONObj& engineOptions) {
+    BSONElement elem = engineOptions[kOptionName];
+    if (elem.eoo()) {
+        return {};
+    }
+    auto swFields = parseFields(elem);
+    if (!swFields.isOK()) {
+        return {};
+    }
+    return std::move(swFields.getValue());
+}
+
+std::string WiredTigerColumnStore::uriFor(const std::string& tableUri) {
+    return tableUri + kUriSuffix;
+}
+
+bool WiredTigerColumnStore::isColumnStoreUri(StringData uri) {
+    return uri.endsWith(kUriSuffix);
+}
+
+Status WiredTigerColumnStore::create(WT_SESSION* session,
+                                     const std::string& tableUri,
+                                     const std::vector<std::string>& fields) {
+    const std::string uri = uriFor(tableUri);
+
+    // Every field is a 'u' column in its own column group.
+    str::stream columns;
+    str::stream colgroups;
+    for (size_t i = 0; i < fields.size(); i++) {
+        columns << "," << columnName(i);
+        colgroups << (i ? "," : "") << columnName(i);
+    }
+    const std::string config = str::stream()
+        << "key_format=q,value_format=" << std::string(fields.size(), 'u') << ",columns=(id"
+        << std::string(columns) << "),colgroups=(" << std::string(colgroups) << ")";
+    LOG(2) << "WiredTigerColumnStore::create uri: " << uri << " config: " << config;
+    int ret = session->create(session, uri.c_str(), config.c_str());
+    if (ret != 0) {
+        return wtRCToStatus(ret);
+    }
+
+    const StringData tableName = StringData(uri).substr(std::strlen("table:"));
+    for (size_t i = 0; i < fields.size(); i++) {
+        const std::string colgroupUri = str::stream() << "colgroup:" << tableName << ":"
+                                                      << columnName(i);
+        const std::string colgroupConfig = str::stream()
+            << "columns=(" << columnName(i) << "),"
+            << "block_compressor=" << wiredTigerGlobalOptions.collectionBlockCompressor
+            << ",log=(enabled=true)";
+        ret = session->create(session, colgroupUri.c_str(), colgroupConfig.c_str());
+        if (ret != 0) {
+            return wtRCToStatus(ret);
+        }
+    }
+    return Status::OK();
+}
+
+WiredTigerColumnStore::WiredTigerColumnStore(const std::string& tableUri,
+                                             std::vector<std::string> fields)
+    : _uri(uriFor(tableUri)),
+      _tableId(WiredTigerSession::genTableId()),
+      _fields(std::move(fields)) {}
+
+void WiredTigerColumnStore::insert(OperationContext* opCtx,
+                                   const RecordId& id,
+                                   const BSONObj& doc) {
+    // Rename each stored field to its position in the document.
+    std::vector<BSONObj> values(_fields.size());
+    int pos = 0;
+    for (auto&& elem : doc) {
+        auto it = std::find(_fields.begin(), _fields.end(), elem.fieldNameStringData());
+        if (it != _fields.end() && values[it - _fields.begin()].isEmpty()) {
+            BSONObjBuilder column;
+            column.appendAs(elem, BSONObjBuilder::numStr(pos));
+            values[it - _fields.begin()] = column.obj();
+        }
+        pos++;
+    }
+
+    WiredTigerSession* session = WiredTigerRecoveryUnit::get(opCtx)->getSession();
+    WT_SESSION* s = session->getSession();
+
+    // Upper bound of the packed size: every column but the last carries a length prefix.
+    size_t size = 0;
+    for (const BSONObj& value : values) {
+        size += (value.isEmpty() ? 0 : value.objsize()) + 16;
+    }
+    std::vector<char> packed(size);
+    WT_PACK_STREAM* ps;
+    const std::string valueFormat(_fields.size(), 'u');
+    invariantWTOK(wiredtiger_pack_start(s, valueFormat.c_str(), packed.data(), size, &ps));
+    for (const BSONObj& value : values) {
+        WiredTigerItem item(value.isEmpty() ? "" : value.objdata(),
+                            value.isEmpty() ? 0 : value.objsize());
+        invariantWTOK(wiredtiger_pack_item(ps, &item));
+    }
+    size_t used;
+    invariantWTOK(wiredtiger_pack_close(ps, &used));
+
+    WT_CURSOR* c = session->getCursor(_uri, _tableId, "raw");
+    invariant(c);
+    ON_BLOCK_EXIT([&] { session->releaseCursor(_tableId, c); });
+
+    RawKey key(s, id);
+    WiredTigerItem keyItem = key.item();
+    WiredTigerItem valueItem(packed.data(), used);
+    c->set_key(c, keyItem.Get());
+    c->set_value(c, valueItem.Get());
+    invariantWTOK(WT_OP_CHECK(c->insert(c)));
+}
+
+void WiredTigerColumnStore::remove(OperationContext* opCtx, const RecordId& id) {
+    WiredTigerSession* session = WiredTigerRecoveryUnit::get(opCtx)->getSession();
+    WT_CURSOR* c = session->getCursor(_uri, _tableId, "raw");
+    invariant(c);
+    ON_BLOCK_EXIT([&] { session->releaseCursor(_tableId, c); });
+
+    RawKey key(session->getSession(), id);
+    WiredTigerItem keyItem = key.item();
+    c->set_key(c, keyItem.Get());
+    int ret = WT_OP_CHECK(c->remove(c));
+    if (ret != WT_NOTFOUND) {
+        invariantWTOK(ret);
+    }
+}
+
+void WiredTigerColumnStore::truncate(OperationContext* opCtx) {
+    WiredTigerSession* session = WiredTigerRecoveryUnit::get(opCtx)->getSession();
+    WT_CURSOR* start = session->getCursor(_uri, _tableId, "raw");
+    invariant(start);
+    ON_BLOCK_EXIT([&] { session->releaseCursor(_tableId, start); });
+
+    int ret = WT_READ_CHECK(start->next(start));
+    if (ret == WT_NOTFOUND) {
+        return;
+    }
+    invariantWTOK(ret);
+
+    WT_SESSION* s = session->getSession();
+    invariantWTOK(WT_OP_CHECK(s->truncate(s, NULL, start, NULL, NULL)));
+}
+
+/**
+ * Scans a projection of the column store table, so that WiredTiger only reads the column groups
+ * of the requested fields. The cursor is not cached since its projection is specific to the query.
+ */
+class WiredTigerColumnStore::Cursor final : public RecordCursor {
+public:
+    Cursor(OperationContext* opCtx,
+           const WiredTigerColumnStore& store,
+           const std::vector<std::string>& fields)
+        : _opCtx(opCtx), _fields(fields), _valueFormat(fields.size(), 'u') {
+        str::stream uri;
+        uri << store.getURI() << "(";
+        for (size_t i = 0; i < fields.size(); i++) {
+            auto it = std::find(store.getFields().begin(), store.getFields().end(), fields[i]);
+            invariant(it != store.getFields().end());
+            uri << (i ? "," : "") << columnName(it - store.getFields().begin());
+        }
+        uri << ")";
+        _projectionUri = uri;
+    }
+
+    ~Cursor() {
+        _close();
+    }
+
+    boost::optional<Record> next() final {
+        if (_eof)
+            return {};
+
+        if (!_cursor)
+            _open();
+
+        if (!_skipNextAdvance) {
+            int ret = WT_READ_CHECK(_cursor->next(_cursor));
+            if (ret == WT_NOTFOUND) {
+                _eof = true;
+                return {};
+            }
+            invariantWTOK(ret);
+        }
+        _skipNextAdvance = false;
+
+        WT_ITEM key;
+        invariantWTOK(_cursor->get_key(_cursor, &key));
+        int64_t repr;
+        invariantWTOK(wiredtiger_struct_unpack(_session, key.data, key.size, "q", &repr));
+        _lastReturnedId = RecordId(repr);
+
+        WT_ITEM value;
+        invariantWTOK(_cursor->get_value(_cursor, &value));
+        BSONObj doc = _buildDocument(value);
+        return {{_lastReturnedId, RecordData(doc.objdata(), doc.objsize()).getOwned()}};
+    }
+
+    void save() final {
+        try {
+            if (_cursor)
+                invariantWTOK(_cursor->reset(_cursor));
+        } catch (const WriteConflictException&) {
+            // Ignore since this is only called when we are about to kill our transaction
+            // anyway.
+        }
+    }
+
+    bool restore() final {
+        if (!_cursor)
+            _open();
+
+        _skipNextAdvance = false;
+        if (_eof || _lastReturnedId.isNull())
+            return true;
+
+        RawKey key(_session, _lastReturnedId);
+        WiredTigerItem keyItem = key.item();
+        _cursor->set_key(_cursor, keyItem.Get());
+        int cmp;
+        int ret = WT_READ_CHECK(_cursor->search_near(_cursor, &cmp));
+        if (ret == WT_NOTFOUND) {
+            _eof = true;
+            return true;
+        }
+        invariantWTOK(ret);
+
+        // If the last returned record was deleted, we are now positioned on a neighbour. Only
+        // stay on it if it comes after that record.
+        if (cmp > 0)
+            _skipNextAdvance = true;
+        return true;
+    }
+
+    void detachFromOperationContext() final {
+        _close();
+        _opCtx = nullptr;
+    }
+
+    void reattachToOperationContext(OperationContext* opCtx) final {
+        _opCtx = opCtx;
+    }
+
+private:
+    void _open() {
+        _session = WiredTigerRecoveryUnit::get(_opCtx)->getSession()->getSession();
+        invariantWTOK(
+            _session->open_cursor(_session, _projectionUri.c_str(), NULL, "raw", &_cursor));
+    }
+
+    void _close() {
+        if (_cursor) {
+            invariantWTOK(_cursor->close(_cursor));
+            _cursor = nullptr;
+        }
+    }
+
+    BSONObj _buildDocument(const WT_ITEM& value) const {
+        // (position in the original document, index into _fields, value)
+        std::vector<std::tuple<int, size_t, BSONElement>> present;
+        present.reserve(_fields.size());
+
+        WT_PACK_STREAM* ps;
+        invariantWTOK(
+            wiredtiger_unpack_start(_session, _valueFormat.c_str(), value.data, value.size, &ps));
+        for (size_t i = 0; i < _fields.size(); i++) {
+            WT_ITEM item;
+            invariantWTOK(wiredtiger_unpack_item(ps, &item));
+            if (item.size == 0)
+                continue;
+            BSONElement elem = BSONObj(static_cast<const char*>(item.data)).firstElement();
+            int pos;
+            invariantOK(parseNumberFromString(elem.fieldNameStringData(), &pos));
+            present.emplace_back(pos, i, elem);
+        }
+        size_t used;
+        invariantWTOK(wiredtiger_pack_close(ps, &used));
+
+        std::sort(present.begin(), present.end(), [](const auto& a, const auto& b) {
+            return std::get<0>(a) < std::get<0>(b);
+        });
+
+        BSONObjBuilder bob;
+        for (auto&& column : present) {
+            bob.appendAs(std::get<2>(column), _fields[std::get<1>(column)]);
+        }
+        return bob.obj();
+    }
+
+    OperationContext* _opCtx;
+    const std::vector<std::string> _fields;
+    const std::string _valueFormat;
+    std::string _projectionUri;
+
+    WT_SESSION* _session = nullptr;
+    WT_CURSOR* _cursor = nullptr;  // Owned.
+    bool _eof = false;
+    bool _skipNextAdvance = false;
+    RecordId _lastReturnedId;
+};
+
+std::unique_ptr<RecordCursor> WiredTigerColumnStore::getCursor(
+    OperationContext* opCtx, const std::vector<std::string>& fields) const {
+    return stdx::make_unique<Cursor>(opCtx, *this, fields);
+}
+
+}  // namespace mongo
@@ -0,0 +1,131 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <wiredtiger.h>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status_with.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonelement.h"
+#include "mongo/db/record_id.h"
+
+namespace mongo {
+
+class BSONObj;
+class OperationContext;
+class RecordCursor;
+
+/**
+ * A column store kept next to the table of a WiredTiger record store, for collections created
+ * with { storageEngine: { wiredTiger: { columnStore: [<field>, ...] } } }.
+ *
+ * The column store is a WiredTiger table keyed by RecordId with one column group, and therefore one
+ * file, per configured top-level field. Scans that only need some of the fields read only their
+ * files instead of reading and parsing whole documents. Each column value is the BSON object
+ * { <position of the field in the document>: <value> }, or empty if the document lacks the field,
+ * so that documents can be rebuilt with their fields in the original order.
+ *
+ * The record store keeps the column store up to date within the same WiredTiger transaction as its
+ * own writes.
+ */
+class WiredTigerColumnStore {
+    MONGO_DISALLOW_COPYING(WiredTigerColumnStore);
+
+public:
+    static const char* kOptionName;
+
+    /**
+     * Parses and validates the 'columnStore' element of the wiredTiger storage engine options.
+     */
+    static StatusWith<std::vector<std::string>> parseFields(const BSONElement& elem);
+
+    /**
+     * Returns the fields configured in 'engineOptions', the wiredTiger storage engine options of a
+     * collection, or an empty vector if it has no (valid) column store.
+     */
+    static std::vector<std::string> getFields(const BSONObj& engineOptions);
+
+    /**
+     * Returns the URI of the column store belonging to the record store table 'tableUri'.
+     */
+    static std::string uriFor(const std::string& tableUri);
+
+    /**
+     * Returns true if 'uri' names a column store rather than a collection or index.
+     */
+    static bool isColumnStoreUri(StringData uri);
+
+    /**
+     * Creates the column store table and its column groups for the record store table 'tableUri'.
+     * Like record store tables (see WiredTigerRecordStore::generateCreateString()), the column
+     * groups are always logged.
+     */
+    static Status create(WT_SESSION* session,
+                         const std::string& tableUri,
+                         const std::vector<std::string>& fields);
+
+    WiredTigerColumnStore(const std::string& tableUri, std::vector<std::string> fields);
+
+    const std::string& getURI() const {
+        return _uri;
+    }
+
+    const std::vector<std::string>& getFields() const {
+        return _fields;
+    }
+
+    /**
+     * Inserts, or replaces, the column values of the record 'id' whose document is 'doc'.
+     */
+    void insert(OperationContext* opCtx, const RecordId& id, const BSONObj& doc);
+
+    void remove(OperationContext* opCtx, const RecordId& id);
+
+    void truncate(OperationContext* opCtx);
+
+    /**
+     * See RecordStore::getColumnStoreCursor().
+     */
+    std::unique_ptr<RecordCursor> getCursor(OperationContext* opCtx,
+                                            const std::vector<std::string>& fields) const;
+
+private:
+    class Cursor;
+
+    const std::string _uri;
+    const uint64_t _tableId;
+    const std::vector<std::string> _fields;
+};
+
+}  // namespace mongo
@@ -62,6 +62,8 @@
 #include "mongo/db/service_context.h"
 #include "mongo/db/storage/journal_listener.h"
 #include "mongo/db/storage/storage_options.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_cache_warmer.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_column_store.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_customization_hooks.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_extensions.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_global_options.h"
@@ -514,6 +516,11 @@ WiredTigerKVEngine::WiredTigerKVEngine(const std::string& canonicalName,
 	//WiredTigerSizeStorer::fillCache
 	_sizeStorer->fillCache();
 
+    if (!_readOnly && !_ephemeral && WiredTigerCacheWarmer::isEnabled()) {
+        _cacheWarmer = stdx::make_unique<WiredTigerCacheWarmer>(_conn, path);
+        _cacheWarmer->go();
+    }
+
 	//WiredTigerKVEngine::WiredTigerKVEngine->Locker::setGlobalThrottling
     Locker::setGlobalThrottling(&openReadTransaction, &openWriteTransaction);
 }
@@ -560,6 +567,15 @@ void WiredTigerKVEngine::appendGlobalStats(BSONObjBuilder& b) {
         bbb.done();
     }
     bb.done();
+
+    WiredTigerCacheWarmer::appendGlobalStats(b);
+}
+
+void WiredTigerKVEngine::appendSizeStorerStats(BSONObjBuilder* b) const {
+    if (!_sizeStorer)
+        return;
+    BSONObjBuilder bb(b->subobjStart("sizeStorer"));
+    _sizeStorer->appendStats(&bb);
 }
 
 /* CTRL+C˳ʱ
@@ -583,6 +599,12 @@ void WiredTigerKVEngine::cleanShutdown() {
     if (!_readOnly)
         syncSizeInfo(true);
     if (_conn) {
+        // Records the working set, so this must happen while the connection is still usable.
+        if (_cacheWarmer) {
+            _cacheWarmer->shutdown();
+            // Its session has to be closed before the connection is.
+            _cacheWarmer.reset();
+        }
         // these must be the last things we do before _conn->close();
         if (_journalFlusher)
             _journalFlusher->shutdown();
@@ -894,7 +916,17 @@ Status WiredTigerKVEngine::createGroupedRecordStore(OperationContext* opCtx,
     LOG(2) << "WiredTigerKVEngine::createGroupedRecordStore ns: " << ns << " uri: " << uri
            << " config: " << config;
 	//Ӧwiredtiger session->create  
-    return wtRCToStatus(s->create(s, uri.c_str(), config.c_str()));
+    Status status = wtRCToStatus(s->create(s, uri.c_str(), config.c_str()));
+    if (!status.isOK() || prefixed) {
+        return status;
+    }
+
+    const std::vector<std::string> columnStoreFields =
+        WiredTigerColumnStore::getFields(options.storageEngine.getObjectField(_canonicalName));
+    if (columnStoreFields.empty()) {
+        return status;
+    }
+    return WiredTigerColumnStore::create(s, uri, columnStoreFields);
 }
 
 //KVDatabaseCatalogEntryBase::createCollection->WiredTigerKVEngine::getGroupedRecordStoreе
@@ -930,6 +962,10 @@ std::unique_ptr<RecordStore> WiredTigerKVEngine::getGroupedRecordStore(
     params.cappedMaxDocs = -1;
     if (options.capped && options.cappedMaxDocs)
         params.cappedMaxDocs = options.cappedMaxDocs;
+    if (!options.capped && prefix == KVPrefix::kNotPrefixed) {
+        params.columnStoreFields =
+            WiredTigerColumnStore::getFields(options.storageEngine.getObjectField(_canonicalName));
+    }
 
     std::unique_ptr<WiredTigerRecordStore> ret;
     if (prefix == KVPrefix::kNotPrefixed) {
@@ -1089,6 +1125,18 @@ KVStorageEngine::reconcileCatalogAndIdents
 Status WiredTigerKVEngine::dropIdent(OperationContext* opCtx, StringData ident) {
     string uri = _uri(ident);
 
+    const string columnStoreUri = WiredTigerColumnStore::uriFor(uri);
+    if (_hasUri(WiredTigerSession(_conn).getSession(), columnStoreUri)) {
+        Status status = _dropUri(opCtx, columnStoreUri);
+        if (!status.isOK()) {
+            return status;
+        }
+    }
+    return _dropUri(opCtx, uri);
+}
+
+Status WiredTigerKVEngine::_dropUri(OperationContext* opCtx, const std::string& uri) {
+
 	//WiredTigerRecoveryUnit* get
     WiredTigerRecoveryUnit* ru = WiredTigerRecoveryUnit::get(opCtx);
 	
@@ -1276,6 +1324,8 @@ std::vector<std::string> WiredTigerKVEngine::getAllIdents(OperationContext* opCt
         StringData ident = key.substr(idx + 1);
         if (ident == "sizeStorer")
             continue;
+        if (WiredTigerColumnStore::isColumnStoreUri(ident))
+            continue;
 
         all.push_back(ident.toString());
     }
@@ -50,6 +50,7 @@ namespace mongo {
 
 class ClockSource;
 class JournalListener;
+class WiredTigerCacheWarmer;
 class WiredTigerRecordStore;
 class WiredTigerSessionCache;
 class WiredTigerSizeStorer;
@@ -268,6 +269,11 @@ public:
 
     static void appendGlobalStats(BSONObjBuilder& b);
 
+    /**
+     * Appends size storer sync statistics to 'b'. Does nothing if the engine has no size storer.
+     */
+    void appendSizeStorerStats(BSONObjBuilder* b) const;
+
 private:
     class WiredTigerJournalFlusher;
     class WiredTigerCheckpointThread;
@@ -277,6 +283,9 @@ private:
 
     bool _hasUri(WT_SESSION* session, const std::string& uri) const;
 
+    // Drops 'uri', or queues the drop if the table is busy.
+    Status _dropUri(OperationContext* opCtx, const std::string& uri);
+
     std::string _uri(StringData ident) const;
 
     Timestamp _previousSetOldestTimestamp;
@@ -315,6 +324,7 @@ private:
     
     std::unique_ptr<WiredTigerJournalFlusher> _journalFlusher;  // Depends on _sizeStorer
     std::unique_ptr<WiredTigerCheckpointThread> _checkpointThread;
+    std::unique_ptr<WiredTigerCacheWarmer> _cacheWarmer;
 
     std::string _rsOptions;
     std::string _indexOptions;
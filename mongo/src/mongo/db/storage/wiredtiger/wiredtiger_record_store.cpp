@@ -44,8 +44,10 @@
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/repl/repl_settings.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/storage/oplog_hack.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_column_store.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_customization_hooks.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_global_options.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_kv_engine.h"
@@ -62,6 +64,7 @@
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/scopeguard.h"
 #include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
 
 //ļӿʵֵײWTKVز
 namespace mongo {
@@ -85,6 +88,15 @@ void checkOplogFormatVersion(OperationContext* opCtx, const std::string& uri) {
 }
 }  // namespace
 
+// When enabled, the oplog stones are saved in the size storer alongside the oplog's size and count
+// and reused on startup instead of sampling or scanning the oplog again.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(wiredTigerPersistOplogStones, bool, true);
+
+// The oplog truncation thread postpones reclaiming stones while more than this percentage of the
+// WiredTiger cache is in use, unless the oplog has grown 10% beyond its maximum size. A value of
+// 100 or more disables the throttling.
+MONGO_EXPORT_SERVER_PARAMETER(wiredTigerOplogTruncationMaxCacheFillPercent, int, 95);
+
 MONGO_FP_DECLARE(WTWriteConflictException);
 MONGO_FP_DECLARE(WTWriteConflictExceptionForReads);
 
@@ -132,6 +144,7 @@ public:
 
         stdx::lock_guard<stdx::mutex> lk(_oplogStones->_mutex);
         _oplogStones->_stones.clear();
+        _oplogStones->_persistStones_inlock();
     }
 
     void rollback() final {}
@@ -156,7 +169,13 @@ WiredTigerRecordStore::OplogStones::OplogStones(OperationContext* opCtx, WiredTi
     _minBytesPerStone = maxSize / numStonesToKeep;
     invariant(_minBytesPerStone > 0);
 
-    _calculateStones(opCtx, numStonesToKeep);
+    Timer timer;
+    if (!_loadPersistedStones(opCtx)) {
+        _calculateStones(opCtx, numStonesToKeep);
+        _persistStones_inlock();
+    }
+    _totalTimeProcessingMicros = timer.micros();
+
     _pokeReclaimThreadIfNeeded();  // Reclaim stones if over the limit.
 }
 
@@ -188,6 +207,15 @@ void WiredTigerRecordStore::OplogStones::awaitHasExcessStonesOrDead() {
     }
 }
 
+int64_t WiredTigerRecordStore::OplogStones::excessBytes() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    int64_t totalBytes = 0;
+    for (auto&& stone : _stones) {
+        totalBytes += stone.bytes;
+    }
+    return totalBytes - _rs->cappedMaxSize();
+}
+
 boost::optional<WiredTigerRecordStore::OplogStones::Stone>
 WiredTigerRecordStore::OplogStones::peekOldestStoneIfNeeded() const {
     stdx::lock_guard<stdx::mutex> lk(_mutex);
@@ -202,6 +230,7 @@ WiredTigerRecordStore::OplogStones::peekOldestStoneIfNeeded() const {
 void WiredTigerRecordStore::OplogStones::popOldestStone() {
     stdx::lock_guard<stdx::mutex> lk(_mutex);
     _stones.pop_front();
+    _persistStones_inlock();
 }
 
 void WiredTigerRecordStore::OplogStones::createNewStoneIfNeeded(RecordId lastRecord) {
@@ -227,6 +256,7 @@ void WiredTigerRecordStore::OplogStones::createNewStoneIfNeeded(RecordId lastRec
     LOG(2) << "create new oplogStone, current stones:" << _stones.size();
     OplogStones::Stone stone = {_currentRecords.swap(0), _currentBytes.swap(0), lastRecord};
     _stones.push_back(stone);
+    _persistStones_inlock();
 
     _pokeReclaimThreadIfNeeded();
 }
@@ -266,6 +296,7 @@ void WiredTigerRecordStore::OplogStones::updateStonesAfterCappedTruncateAfter(
     // Remove the stones corresponding to the records that were deleted.
     int64_t offset = _stones.size() - numStonesToRemove;
     _stones.erase(_stones.begin() + offset, _stones.end());
+    _persistStones_inlock();
 
     // Account for any remaining records from a partially truncated stone in the stone currently
     // being filled.
@@ -313,8 +344,86 @@ void WiredTigerRecordStore::OplogStones::_calculateStones(OperationContext* opCt
     _calculateStonesBySampling(opCtx, int64_t(estRecordsPerStone), int64_t(estBytesPerStone));
 }
 
+bool WiredTigerRecordStore::OplogStones::_loadPersistedStones(OperationContext* opCtx) {
+    if (!wiredTigerPersistOplogStones || !_rs->_sizeStorer) {
+        return false;
+    }
+
+    BSONObj persisted = _rs->_sizeStorer->loadOplogStonesFromCache(_rs->getURI());
+    if (persisted.isEmpty()) {
+        return false;
+    }
+
+    RecordId earliest;
+    RecordId latest;
+    {
+        auto record = _rs->getCursor(opCtx, /*forward=*/true)->next();
+        if (!record) {
+            return false;
+        }
+        earliest = record->id;
+    }
+    {
+        auto record = _rs->getCursor(opCtx, /*forward=*/false)->next();
+        if (!record) {
+            return false;
+        }
+        latest = record->id;
+    }
+
+    // The size storer is only synced periodically, so the persisted stones may describe records
+    // that have since been truncated, or records past the end of the oplog after an unclean
+    // shutdown or a rollback. Only keep the stones that still fall within the oplog.
+    std::deque<OplogStones::Stone> stones;
+    int64_t recordsInStones = 0;
+    int64_t bytesInStones = 0;
+    RecordId previous;
+    for (auto&& elem : persisted) {
+        if (elem.type() != Object) {
+            log() << "Ignoring malformed persisted oplog stones: " << redact(persisted);
+            return false;
+        }
+        BSONObj obj = elem.Obj();
+        OplogStones::Stone stone = {obj["records"].safeNumberLong(),
+                                    obj["bytes"].safeNumberLong(),
+                                    RecordId(obj["lastRecord"].safeNumberLong())};
+        if (stone.records <= 0 || stone.bytes <= 0 || !stone.lastRecord.isNormal() ||
+            stone.lastRecord <= previous) {
+            log() << "Ignoring malformed persisted oplog stones: " << redact(persisted);
+            return false;
+        }
+        previous = stone.lastRecord;
+
+        if (stone.lastRecord < earliest) {
+            continue;
+        }
+        if (stone.lastRecord > latest) {
+            break;
+        }
+        stones.push_back(stone);
+        recordsInStones += stone.records;
+        bytesInStones += stone.bytes;
+    }
+
+    if (stones.empty()) {
+        return false;
+    }
+
+    _processingMethod = "persisted";
+    _stones.swap(stones);
+
+    // Whatever the stones do not account for belongs to the partially filled chunk.
+    _currentRecords.store(std::max<int64_t>(_rs->numRecords(opCtx) - recordsInStones, 0));
+    _currentBytes.store(std::max<int64_t>(_rs->dataSize(opCtx) - bytesInStones, 0));
+
+    log() << "Loaded " << _stones.size() << " persisted markers for oplog truncation, the newest at"
+          << " optime " << Timestamp(_stones.back().lastRecord.repr()).toStringPretty();
+    return true;
+}
+
 void WiredTigerRecordStore::OplogStones::_calculateStonesByScanning(OperationContext* opCtx) {
     log() << "Scanning the oplog to determine where to place markers for truncation";
+    _processingMethod = "scanning";
 
     long long numRecords = 0;
     long long dataSize = 0;
@@ -374,6 +483,7 @@ void WiredTigerRecordStore::OplogStones::_calculateStonesBySampling(OperationCon
 
     log() << "Sampling from the oplog between " << earliestOpTime.toStringPretty() << " and "
           << latestOpTime.toStringPretty() << " to determine where to place markers for truncation";
+    _processingMethod = "sampling";
 
     int64_t wholeStones = _rs->numRecords(opCtx) / estRecordsPerStone;
     int64_t numSamples = kRandomSamplesPerStone * _rs->numRecords(opCtx) / estRecordsPerStone;
@@ -427,6 +537,46 @@ void WiredTigerRecordStore::OplogStones::_pokeReclaimThreadIfNeeded() {
     }
 }
 
+void WiredTigerRecordStore::OplogStones::_persistStones_inlock() {
+    if (!wiredTigerPersistOplogStones || !_rs->_sizeStorer) {
+        return;
+    }
+
+    BSONArrayBuilder arr;
+    for (auto&& stone : _stones) {
+        arr.append(BSON("records" << stone.records << "bytes" << stone.bytes << "lastRecord"
+                                  << stone.lastRecord.repr()));
+    }
+    _rs->_sizeStorer->storeOplogStonesToCache(_rs->getURI(), arr.arr());
+}
+
+void WiredTigerRecordStore::OplogStones::recordTruncation(int64_t micros,
+                                                          int64_t recordsRemoved,
+                                                          int64_t bytesRemoved) {
+    _totalTimeTruncatingMicros.fetchAndAdd(micros);
+    _truncateCount.fetchAndAdd(1);
+    _recordsReclaimed.fetchAndAdd(recordsRemoved);
+    _bytesReclaimed.fetchAndAdd(bytesRemoved);
+}
+
+void WiredTigerRecordStore::OplogStones::getOplogStonesStats(BSONObjBuilder& builder) const {
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        builder.append("numStones", static_cast<long long>(_stones.size()));
+        builder.append("minBytesPerStone", static_cast<long long>(_minBytesPerStone));
+    }
+    builder.append("currentStoneRecords", static_cast<long long>(currentRecords()));
+    builder.append("currentStoneBytes", static_cast<long long>(currentBytes()));
+    builder.append("processingMethod", _processingMethod);
+    builder.append("totalTimeProcessingMicros", static_cast<long long>(_totalTimeProcessingMicros));
+    builder.append("totalTimeTruncatingMicros",
+                   static_cast<long long>(_totalTimeTruncatingMicros.load()));
+    builder.append("truncateCount", static_cast<long long>(_truncateCount.load()));
+    builder.append("recordsReclaimed", static_cast<long long>(_recordsReclaimed.load()));
+    builder.append("bytesReclaimed", static_cast<long long>(_bytesReclaimed.load()));
+    builder.append("throttledCount", static_cast<long long>(_throttledCount.load()));
+}
+
 void WiredTigerRecordStore::OplogStones::adjust(int64_t maxSize) {
     stdx::lock_guard<stdx::mutex> lk(_mutex);
     const unsigned long long kMinStonesToKeep = 10ULL;
@@ -450,6 +600,12 @@ StatusWith<std::string> WiredTigerRecordStore::parseOptionsField(const BSONObj o
                 return status;
             }
             ss << elem.valueStringData() << ',';
+        } else if (elem.fieldNameStringData() == WiredTigerColumnStore::kOptionName) {
+            // The column store is a separate table, it doesn't change the config string.
+            auto swFields = WiredTigerColumnStore::parseFields(elem);
+            if (!swFields.isOK()) {
+                return swFields.getStatus();
+            }
         } else {
             // Return error on first unrecognized field.
             return StatusWith<std::string>(ErrorCodes::InvalidOptions,
@@ -485,6 +641,7 @@ public:
 
         WT_ITEM value;
         invariantWTOK(_cursor->get_value(_cursor, &value));
+        WiredTigerRecoveryUnit::get(_opCtx)->incrementBytesRead(value.size);
 
         return {{id, {static_cast<const char*>(value.data), static_cast<int>(value.size)}}};
     }
@@ -572,6 +729,15 @@ StatusWith<std::string> WiredTigerRecordStore::generateCreateString(
 
     ss << customOptions.getValue();
 
+    if (options.capped || prefixed) {
+        if (options.storageEngine.getObjectField(engineName).hasField(
+                WiredTigerColumnStore::kOptionName)) {
+            return {ErrorCodes::InvalidOptions,
+                    str::stream() << "'" << WiredTigerColumnStore::kOptionName
+                                  << "' is not supported for capped or grouped collections"};
+        }
+    }
+
     if (NamespaceString::oplog(ns)) {
         // force file for oplog
         ss << "type=file,";
@@ -631,8 +797,12 @@ WiredTigerRecordStore::WiredTigerRecordStore(WiredTigerKVEngine* kvEngine,
       _shuttingDown(false),
       _cappedDeleteCheckCount(0),
       _sizeStorer(params.sizeStorer),
-      _sizeStorerCounter(0),
       _kvEngine(kvEngine) {
+    if (!params.columnStoreFields.empty()) {
+        _columnStore =
+            stdx::make_unique<WiredTigerColumnStore>(_uri, std::move(params.columnStoreFields));
+    }
+
     Status versionStatus = WiredTigerUtil::checkApplicationMetadataFormatVersion(
                                ctx, _uri, kMinimumRecordStoreVersion, kMaximumRecordStoreVersion)
                                .getStatus();
@@ -701,23 +871,21 @@ void WiredTigerRecordStore::postConstructorInit(OperationContext* opCtx) {
             long long dataSize;
 			//ȡǰ
             _sizeStorer->loadFromCache(_uri, &numRecords, &dataSize);
-            _numRecords.store(numRecords);
-            _dataSize.store(dataSize);
+            _sizeInfo.set(numRecords, dataSize);
             _sizeStorer->onCreate(this, numRecords, dataSize);
         } else {
             LOG(1) << "Doing scan of collection " << ns() << " to get size and count info";
 
-            _numRecords.store(0);
-            _dataSize.store(0);
-
+            long long numRecords = 0;
+            long long dataSize = 0;
             do {
-                _numRecords.fetchAndAdd(1);
-                _dataSize.fetchAndAdd(record->data.size());
+                numRecords++;
+                dataSize += record->data.size();
             } while ((record = cursor->next()));
+            _sizeInfo.set(numRecords, dataSize);
         }
     } else {
-        _dataSize.store(0);
-        _numRecords.store(0);
+        _sizeInfo.set(0, 0);
         // Need to start at 1 so we are always higher than RecordId::min()
         _nextIdNum.store(1);
         if (_sizeStorer)
@@ -744,11 +912,11 @@ bool WiredTigerRecordStore::inShutdown() const {
 }
 
 long long WiredTigerRecordStore::dataSize(OperationContext* opCtx) const {
-    return _dataSize.load();
+    return _sizeInfo.dataSize();
 }
 
 long long WiredTigerRecordStore::numRecords(OperationContext* opCtx) const {
-    return _numRecords.load();
+    return _sizeInfo.numRecords();
 }
 
 bool WiredTigerRecordStore::isCapped() const {
@@ -851,6 +1019,10 @@ void WiredTigerRecordStore::deleteRecord(OperationContext* opCtx, const RecordId
     ret = WT_OP_CHECK(c->remove(c));
     invariantWTOK(ret);
 
+    if (_columnStore) {
+        _columnStore->remove(opCtx, id);
+    }
+
     _changeNumRecords(opCtx, -1);
     _increaseDataSize(opCtx, -old_length);
 }
@@ -860,10 +1032,10 @@ bool WiredTigerRecordStore::cappedAndNeedDelete() const {
     if (!_isCapped)
         return false;
 
-    if (_dataSize.load() >= _cappedMaxSize)
+    if (_sizeInfo.dataSize() >= _cappedMaxSize)
         return true;
 
-    if ((_cappedMaxDocs != -1) && (_numRecords.load() > _cappedMaxDocs))
+    if ((_cappedMaxDocs != -1) && (_sizeInfo.numRecords() > _cappedMaxDocs))
         return true;
 
     return false;
@@ -890,7 +1062,7 @@ int64_t WiredTigerRecordStore::cappedDeleteAsNeeded(OperationContext* opCtx,
         if (!lock.try_lock()) {
             // Someone else is deleting old records. Apply back-pressure if too far behind,
             // otherwise continue.
-            if ((_dataSize.load() - _cappedMaxSize) < _cappedMaxSizeSlack)
+            if ((_sizeInfo.dataSize() - _cappedMaxSize) < _cappedMaxSizeSlack)
                 return 0;
 
             // Don't wait forever: we're in a transaction, we could block eviction.
@@ -905,7 +1077,7 @@ int64_t WiredTigerRecordStore::cappedDeleteAsNeeded(OperationContext* opCtx,
 
             // If we already waited, let someone else do cleanup unless we are significantly
             // over the limit.
-            if ((_dataSize.load() - _cappedMaxSize) < (2 * _cappedMaxSizeSlack))
+            if ((_sizeInfo.dataSize() - _cappedMaxSize) < (2 * _cappedMaxSizeSlack))
                 return 0;
         }
     }
@@ -926,8 +1098,8 @@ int64_t WiredTigerRecordStore::cappedDeleteAsNeeded_inlock(OperationContext* opC
 
     WT_SESSION* session = WiredTigerRecoveryUnit::get(opCtx)->getSession()->getSession();
 
-    int64_t dataSize = _dataSize.load();
-    int64_t numRecords = _numRecords.load();
+    int64_t dataSize = _sizeInfo.dataSize();
+    int64_t numRecords = _sizeInfo.numRecords();
 
     int64_t sizeOverCap = (dataSize > _cappedMaxSize) ? dataSize - _cappedMaxSize : 0;
     int64_t sizeSaved = 0;
@@ -1074,17 +1246,31 @@ bool WiredTigerRecordStore::yieldAndAwaitOplogDeletionRequest(OperationContext*
 //WiredTigerRecordStoreThread::_deleteExcessDocuments
 //localreplset.oplogTruncateAfterPointݴñָʱ䷶Χ
 //oplogTruncateAfterPoint ֻڱ⣬֤ oplog batch ӦõԭԣĿȷݵһ
-void WiredTigerRecordStore::reclaimOplog(OperationContext* opCtx) {
+bool WiredTigerRecordStore::reclaimOplog(OperationContext* opCtx) {
     while (auto stone = _oplogStones->peekOldestStoneIfNeeded()) {
         invariant(stone->lastRecord.isNormal());
 
+        WiredTigerRecoveryUnit* ru = WiredTigerRecoveryUnit::get(opCtx);
+        WT_SESSION* session = ru->getSession()->getSession();
+
+        // Truncating a whole stone dirties a lot of pages at once. Hold off while the cache is
+        // already under pressure, as long as the oplog has not overshot its maximum size by much.
+        const int maxCacheFillPercent = wiredTigerOplogTruncationMaxCacheFillPercent.load();
+        if (maxCacheFillPercent < 100 && _oplogStones->excessBytes() < _cappedMaxSize / 10) {
+            const int cacheFillPercent = WiredTigerUtil::getCacheFillPercent(session);
+            if (cacheFillPercent > maxCacheFillPercent) {
+                LOG(1) << "Postponing oplog truncation, WiredTiger cache is " << cacheFillPercent
+                       << "% full";
+                _oplogStones->recordThrottledTruncation();
+                return false;
+            }
+        }
+
         LOG(1) << "Truncating the oplog between " << _oplogStones->firstRecord << " and "
                << stone->lastRecord << " to remove approximately " << stone->records
                << " records totaling to " << stone->bytes << " bytes";
 
-        WiredTigerRecoveryUnit* ru = WiredTigerRecoveryUnit::get(opCtx);
-        WT_SESSION* session = ru->getSession()->getSession();
-
+        Timer timer;
         try {
             WriteUnitOfWork wuow(opCtx);
 
@@ -1104,6 +1290,7 @@ void WiredTigerRecordStore::reclaimOplog(OperationContext* opCtx) {
 
             // Remove the stone after a successful truncation.
             _oplogStones->popOldestStone();
+            _oplogStones->recordTruncation(timer.micros(), stone->records, stone->bytes);
 
             // Stash the truncate point for next time to cleanly skip over tombstones, etc.
             _oplogStones->firstRecord = stone->lastRecord;
@@ -1112,8 +1299,15 @@ void WiredTigerRecordStore::reclaimOplog(OperationContext* opCtx) {
         }
     }
 
-    LOG(1) << "Finished truncating the oplog, it now contains approximately " << _numRecords.load()
-           << " records totaling to " << _dataSize.load() << " bytes";
+    LOG(1) << "Finished truncating the oplog, it now contains approximately " << _sizeInfo.numRecords()
+           << " records totaling to " << _sizeInfo.dataSize() << " bytes";
+    return true;
+}
+
+void WiredTigerRecordStore::getOplogTruncateStats(BSONObjBuilder& builder) const {
+    if (_oplogStones) {
+        _oplogStones->getOplogStonesStats(builder);
+    }
 }
 
 /*
@@ -1262,9 +1456,16 @@ Status WiredTigerRecordStore::_insertRecords(OperationContext* opCtx,
             return wtRCToStatus(ret, "WiredTigerRecordStore::insertRecord");
     }
 
+    if (_columnStore) {
+        for (size_t i = 0; i < nRecords; i++) {
+            _columnStore->insert(opCtx, records[i].id, records[i].data.toBson());
+        }
+    }
+
 	//¼ñеݴС
     _changeNumRecords(opCtx, nRecords);
     _increaseDataSize(opCtx, totalLength);
+    WiredTigerRecoveryUnit::get(opCtx)->incrementBytesWritten(totalLength);
 
     if (_oplogStones) {
         _oplogStones->updateCurrentStoneAfterInsertOnCommit(
@@ -1374,7 +1575,12 @@ Status WiredTigerRecordStore::updateRecord(OperationContext* opCtx,
     ret = WT_OP_CHECK(c->insert(c));
     invariantWTOK(ret);
 
+    if (_columnStore) {
+        _columnStore->insert(opCtx, id, BSONObj(data));
+    }
+
     _increaseDataSize(opCtx, len - old_length);
+    WiredTigerRecoveryUnit::get(opCtx)->incrementBytesWritten(len);
     if (!_oplogStones) {
         cappedDeleteAsNeeded(opCtx, id);
     }
@@ -1419,7 +1625,11 @@ StatusWith<RecordData> WiredTigerRecordStore::updateWithDamages(
     WT_ITEM value;
     invariantWTOK(c->get_value(c, &value));
 
-    return RecordData(static_cast<const char*>(value.data), value.size).getOwned();
+    RecordData newRec = RecordData(static_cast<const char*>(value.data), value.size).getOwned();
+    if (_columnStore) {
+        _columnStore->insert(opCtx, id, newRec.toBson());
+    }
+    return newRec;
 }
 
 std::unique_ptr<RecordCursor> WiredTigerRecordStore::getRandomCursor(
@@ -1435,6 +1645,21 @@ std::vector<std::unique_ptr<RecordCursor>> WiredTigerRecordStore::getManyCursors
     return cursors;
 }
 
+std::vector<std::string> WiredTigerRecordStore::getColumnStoreFields() const {
+    if (!_columnStore) {
+        return {};
+    }
+    return _columnStore->getFields();
+}
+
+std::unique_ptr<RecordCursor> WiredTigerRecordStore::getColumnStoreCursor(
+    OperationContext* opCtx, const std::vector<std::string>& fields) const {
+    if (!_columnStore) {
+        return {};
+    }
+    return _columnStore->getCursor(opCtx, fields);
+}
+
 Status WiredTigerRecordStore::truncate(OperationContext* opCtx) {
     WiredTigerCursor startWrap(_uri, _tableId, true, opCtx);
     WT_CURSOR* start = startWrap.get();
@@ -1447,6 +1672,9 @@ Status WiredTigerRecordStore::truncate(OperationContext* opCtx) {
 
     WT_SESSION* session = WiredTigerRecoveryUnit::get(opCtx)->getSession()->getSession();
     invariantWTOK(WT_OP_CHECK(session->truncate(session, NULL, start, NULL, NULL)));
+    if (_columnStore) {
+        _columnStore->truncate(opCtx);
+    }
     _changeNumRecords(opCtx, -numRecords(opCtx));
     _increaseDataSize(opCtx, -dataSize(opCtx));
 
@@ -1632,8 +1860,7 @@ boost::optional<RecordId> WiredTigerRecordStore::oplogStartHack(
 void WiredTigerRecordStore::updateStatsAfterRepair(OperationContext* opCtx,
                                                    long long numRecords,
                                                    long long dataSize) {
-    _numRecords.store(numRecords);
-    _dataSize.store(dataSize);
+    _sizeInfo.set(numRecords, dataSize);
 
     if (_sizeStorer) {
         _sizeStorer->storeToCache(_uri, numRecords, dataSize);
@@ -1656,7 +1883,7 @@ public:
     NumRecordsChange(WiredTigerRecordStore* rs, int64_t diff) : _rs(rs), _diff(diff) {}
     virtual void commit() {}
     virtual void rollback() {
-        _rs->_numRecords.fetchAndAdd(-_diff);
+        _rs->_changeNumRecords(NULL, -_diff);
     }
 
 private:
@@ -1665,10 +1892,14 @@ private:
 };
 
 //WiredTigerRecordStore::deleteRecord  WiredTigerRecordStore::_insertRecords
-void WiredTigerRecordStore::_changeNumRecords(OperationContext* opCtx, int64_t diff) { //diffΪ
-    opCtx->recoveryUnit()->registerChange(new NumRecordsChange(this, diff));
-    if (_numRecords.fetchAndAdd(diff) < 0) //_numRecordsС0ֵΪ0
-        _numRecords.store(std::max(diff, int64_t(0)));
+void WiredTigerRecordStore::_changeNumRecords(OperationContext* opCtx, int64_t diff) {
+    if (opCtx)
+        opCtx->recoveryUnit()->registerChange(new NumRecordsChange(this, diff));
+
+    _sizeInfo.changeNumRecords(diff);
+    if (_sizeStorer && _sizeInfo.markDirty()) {
+        _sizeStorer->markDirty(_uri);
+    }
 }
 
 class WiredTigerRecordStore::DataSizeChange : public RecoveryUnit::Change {
@@ -1689,11 +1920,9 @@ void WiredTigerRecordStore::_increaseDataSize(OperationContext* opCtx, int64_t a
     if (opCtx)
         opCtx->recoveryUnit()->registerChange(new DataSizeChange(this, amount));
 
-    if (_dataSize.fetchAndAdd(amount) < 0)
-        _dataSize.store(std::max(amount, int64_t(0)));
-
-    if (_sizeStorer && _sizeStorerCounter++ % 1000 == 0) {
-        _sizeStorer->storeToCache(_uri, _numRecords.load(), _dataSize.load());
+    _sizeInfo.changeDataSize(amount);
+    if (_sizeStorer && _sizeInfo.markDirty()) {
+        _sizeStorer->markDirty(_uri);
     }
 }
 
@@ -1825,6 +2054,7 @@ boost::optional<Record> WiredTigerRecordStoreCursorBase::next() {
 
     WT_ITEM value;
     invariantWTOK(c->get_value(c, &value));
+    WiredTigerRecoveryUnit::get(_opCtx)->incrementBytesRead(value.size);
 
     _lastReturnedId = id;
     return {{id, {static_cast<const char*>(value.data), static_cast<int>(value.size)}}};
@@ -1846,6 +2076,7 @@ boost::optional<Record> WiredTigerRecordStoreCursorBase::seekExact(const RecordI
 
     WT_ITEM value;
     invariantWTOK(c->get_value(c, &value));//__wt_cursor_get_value
+    WiredTigerRecoveryUnit::get(_opCtx)->incrementBytesRead(value.size);
 
     _lastReturnedId = id;
     _eof = false;
@@ -31,8 +31,10 @@
 
 #pragma once
 
+#include <memory>
 #include <set>
 #include <string>
+#include <vector>
 #include <wiredtiger.h>
 
 #include "mongo/db/catalog/collection_options.h"
@@ -41,6 +43,7 @@
 #include "mongo/db/storage/record_store.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_kv_engine.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_size_storer.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/mutex.h"
@@ -64,10 +67,14 @@ namespace mongo {
 
 class RecoveryUnit;
 class WiredTigerSessionCache;
+class WiredTigerColumnStore;
 class WiredTigerSizeStorer;
 
 extern const std::string kWiredTigerEngineName;
 
+// Oplog truncation is postponed while the WiredTiger cache is fuller than this percentage.
+extern AtomicInt32 wiredTigerOplogTruncationMaxCacheFillPercent;
+
 //WiredTigerSizeStorer.Entry *rsΪ 
 //WiredTigerSizeStorer._entries[].rs mapм¼еļͳϢ
 
@@ -134,6 +141,8 @@ public:
         */
         WiredTigerSizeStorer* sizeStorer;
         bool isReadOnly;
+        // Fields of the column store created with the table, empty if there is none.
+        std::vector<std::string> columnStoreFields;
     };
 
     WiredTigerRecordStore(WiredTigerKVEngine* kvEngine, OperationContext* opCtx, Params params);
@@ -202,6 +211,11 @@ public:
 
     std::vector<std::unique_ptr<RecordCursor>> getManyCursors(OperationContext* opCtx) const final;
 
+    std::vector<std::string> getColumnStoreFields() const final;
+
+    std::unique_ptr<RecordCursor> getColumnStoreCursor(
+        OperationContext* opCtx, const std::vector<std::string>& fields) const final;
+
     virtual Status truncate(OperationContext* opCtx);
 
     virtual bool compactSupported() const {
@@ -267,11 +281,23 @@ public:
         _sizeStorer = ss;
     }
 
+    WiredTigerSizeStorer::SizeInfo& sizeInfo() {
+        return _sizeInfo;
+    }
+
     bool isOpHidden_forTest(const RecordId& id) const;
 
     bool inShutdown() const;
 
-    void reclaimOplog(OperationContext* opCtx);
+    /**
+     * Truncates the oldest oplog stones while there are more than the oplog's maximum size
+     * permits. Returns false if truncation was postponed because of WiredTiger cache pressure, in
+     * which case the caller should back off before trying again.
+     */
+    bool reclaimOplog(OperationContext* opCtx);
+
+    // Appends the oplog truncation statistics if this record store maintains oplog stones.
+    void getOplogTruncateStats(BSONObjBuilder& builder) const;
 
     int64_t cappedDeleteAsNeeded(OperationContext* opCtx, const RecordId& justInserted);
 
@@ -354,15 +380,17 @@ private:
     mutable stdx::timed_mutex _cappedDeleterMutex;
 
     AtomicInt64 _nextIdNum;
-    AtomicInt64 _dataSize;
-    AtomicInt64 _numRecords;
+    WiredTigerSizeStorer::SizeInfo _sizeInfo;
 
     //
     WiredTigerSizeStorer* _sizeStorer;  // not owned, can be NULL
-    int _sizeStorerCounter;
 
     WiredTigerKVEngine* _kvEngine;  // not owned.
 
+    // Non-null if the collection was created with a column store. Written in the same
+    // transactions as the table itself.
+    std::unique_ptr<WiredTigerColumnStore> _columnStore;
+
     // Non-null if this record store is underlying the active oplog.
     std::shared_ptr<OplogStones> _oplogStones;
 };
@@ -38,6 +38,7 @@
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/client.h"
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/namespace_string.h"
@@ -76,6 +77,7 @@ public:
     //WiredTigerRecordStoreThread::_deleteExcessDocuments
     //WiredTigerRecordStoreThread::run߳ѭ
     bool _deleteExcessDocuments() {
+        bool throttled = false;
         if (!getGlobalServiceContext()->getGlobalStorageEngine()) {
             LOG(2) << "no global storage engine yet";
             return false;
@@ -108,13 +110,19 @@ public:
             }
 
 			//WiredTigerRecordStore::reclaimOplog
-            rs->reclaimOplog(&opCtx);
+            throttled = !rs->reclaimOplog(&opCtx);
         } catch (const std::exception& e) {
             severe() << "error in WiredTigerRecordStoreThread: " << e.what();
             fassertFailedNoTrace(!"error in WiredTigerRecordStoreThread");
         } catch (...) {
             fassertFailedNoTrace(!"unknown error in WiredTigerRecordStoreThread");
         }
+
+        if (throttled) {
+            // Give eviction a chance to catch up before truncating again. The locks have been
+            // released by now.
+            sleepmillis(100);
+        }
         return true;
     }
 
@@ -159,6 +167,34 @@ bool initRsOplogBackgroundThread(StringData ns) {
     return true;
 }
 
+// Reports the oplog stones and the work done by the truncation thread. Only includes the section
+// when this node has an oplog maintained by oplog stones.
+class OplogTruncationServerStatus : public ServerStatusSection {
+public:
+    OplogTruncationServerStatus() : ServerStatusSection("oplogTruncation") {}
+
+    bool includeByDefault() const {
+        return true;
+    }
+
+    BSONObj generateSection(OperationContext* opCtx, const BSONElement& configElement) const {
+        AutoGetCollection autoColl(opCtx, NamespaceString::kRsOplogNamespace, MODE_IS);
+        Collection* oplog = autoColl.getCollection();
+        if (!oplog) {
+            return BSONObj();
+        }
+
+        WiredTigerRecordStore* rs = dynamic_cast<WiredTigerRecordStore*>(oplog->getRecordStore());
+        if (!rs) {
+            return BSONObj();
+        }
+
+        BSONObjBuilder builder;
+        rs->getOplogTruncateStats(builder);
+        return builder.obj();
+    }
+} oplogTruncationServerStatus;
+
 MONGO_INITIALIZER(SetInitRsOplogBackgroundThreadCallback)(InitializerContext* context) {
     WiredTigerKVEngine::setInitRsOplogBackgroundThreadCallback(initRsOplogBackgroundThread);
     return Status::OK();
@@ -30,6 +30,7 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <string>
 
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
 #include "mongo/platform/atomic_word.h"
@@ -67,6 +68,9 @@ public:
         return total_bytes > _rs->cappedMaxSize();
     }
 
+    // Returns how many bytes the stones hold beyond the configured maximum size of the oplog.
+    int64_t excessBytes() const;
+
     void awaitHasExcessStonesOrDead();
 
     boost::optional<OplogStones::Stone> peekOldestStoneIfNeeded() const;
@@ -90,6 +94,17 @@ public:
     // Resize oplog size
     void adjust(int64_t maxSize);
 
+    // Records a successful truncation of the oldest stone for reporting in serverStatus.
+    void recordTruncation(int64_t micros, int64_t recordsRemoved, int64_t bytesRemoved);
+
+    // Records that a round of truncation was postponed because of WiredTiger cache pressure.
+    void recordThrottledTruncation() {
+        _throttledCount.fetchAndAdd(1);
+    }
+
+    // Appends the statistics reported in serverStatus().oplogTruncation.
+    void getOplogStonesStats(BSONObjBuilder& builder) const;
+
     // The start point of where to truncate next. Used by the background reclaim thread to
     // efficiently truncate records with WiredTiger by skipping over tombstones, etc.
     RecordId firstRecord;
@@ -118,6 +133,7 @@ private:
     class TruncateChange;
 
     void _calculateStones(OperationContext* opCtx, size_t size);
+    bool _loadPersistedStones(OperationContext* opCtx);
     void _calculateStonesByScanning(OperationContext* opCtx);
     void _calculateStonesBySampling(OperationContext* opCtx,
                                     int64_t estRecordsPerStone,
@@ -125,6 +141,9 @@ private:
 
     void _pokeReclaimThreadIfNeeded();
 
+    // Hands the current set of stones to the size storer so they survive a restart.
+    void _persistStones_inlock();
+
     static const uint64_t kRandomSamplesPerStone = 10;
 
     WiredTigerRecordStore* _rs;
@@ -145,6 +164,17 @@ private:
 
     mutable stdx::mutex _mutex;  // Protects against concurrent access to the deque of oplog stones.
     std::deque<OplogStones::Stone> _stones;  // front = oldest, back = newest.
+
+    // How the stones were determined on startup ("persisted", "sampling" or "scanning") and how
+    // long it took. Both are written once by the constructor.
+    std::string _processingMethod;
+    int64_t _totalTimeProcessingMicros = 0;
+
+    AtomicInt64 _totalTimeTruncatingMicros;
+    AtomicInt64 _truncateCount;
+    AtomicInt64 _recordsReclaimed;
+    AtomicInt64 _bytesReclaimed;
+    AtomicInt64 _throttledCount;
 };
 
 }  // namespace mongo
@@ -45,6 +45,7 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store_oplog_stones.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_size_storer.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
 #include "mongo/stdx/memory.h"
@@ -853,5 +854,179 @@ TEST(WiredTigerRecordStoreTest, OplogStones_AscendingOrder) {
     }
 }
 
+// Verify that persisted oplog stones are reused on startup, keeping only the stones that still fall
+// within the oplog.
+TEST(WiredTigerRecordStoreTest, OplogStones_LoadPersistedStones) {
+    std::unique_ptr<RecordStoreHarnessHelper> harnessHelper = newRecordStoreHarnessHelper();
+
+    const int64_t cappedMaxSize = 10 * 1024;  // 10KB
+    unique_ptr<RecordStore> rs(
+        harnessHelper->newCappedRecordStore("local.oplog.stones", cappedMaxSize, -1));
+
+    WiredTigerRecordStore* wtrs = static_cast<WiredTigerRecordStore*>(rs.get());
+    wtrs->oplogStones()->setMinBytesPerStone(1000);
+
+    ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+    WiredTigerSizeStorer sizeStorer(
+        WiredTigerRecoveryUnit::get(opCtx.get())->getSessionCache()->conn(),
+        "table:sizeStorer",
+        false);
+    wtrs->setSizeStorer(&sizeStorer);
+    ON_BLOCK_EXIT([&] { rs.reset(); });
+
+    for (int i = 1; i <= 6; i++) {
+        ASSERT_EQ(insertBSONWithSize(opCtx.get(), rs.get(), Timestamp(1, i), 100), RecordId(1, i));
+    }
+    ASSERT_EQ(0U, wtrs->oplogStones()->numStones());
+
+    // The first stone was truncated away and the last one describes records past the end of the
+    // oplog, as after an unclean shutdown.
+    sizeStorer.storeOplogStonesToCache(
+        wtrs->getURI(),
+        BSON_ARRAY(BSON("records" << 2LL << "bytes" << 200LL << "lastRecord"
+                                  << RecordId(0, 5).repr())
+                   << BSON("records" << 2LL << "bytes" << 200LL << "lastRecord"
+                                     << RecordId(1, 2).repr())
+                   << BSON("records" << 2LL << "bytes" << 200LL << "lastRecord"
+                                     << RecordId(1, 4).repr())
+                   << BSON("records" << 1LL << "bytes" << 100LL << "lastRecord"
+                                     << RecordId(2, 1).repr())));
+
+    WiredTigerRecordStore::OplogStones oplogStones(opCtx.get(), wtrs);
+    ASSERT_EQ(2U, oplogStones.numStones());
+    ASSERT_EQ(2, oplogStones.currentRecords());
+    ASSERT_EQ(200, oplogStones.currentBytes());
+
+    BSONObjBuilder builder;
+    oplogStones.getOplogStonesStats(builder);
+    ASSERT_EQ("persisted", builder.obj()["processingMethod"].String());
+}
+
+// Verify that malformed persisted oplog stones are ignored and the stones are computed again.
+TEST(WiredTigerRecordStoreTest, OplogStones_IgnoreMalformedPersistedStones) {
+    std::unique_ptr<RecordStoreHarnessHelper> harnessHelper = newRecordStoreHarnessHelper();
+
+    const int64_t cappedMaxSize = 10 * 1024;  // 10KB
+    unique_ptr<RecordStore> rs(
+        harnessHelper->newCappedRecordStore("local.oplog.stones", cappedMaxSize, -1));
+
+    WiredTigerRecordStore* wtrs = static_cast<WiredTigerRecordStore*>(rs.get());
+    wtrs->oplogStones()->setMinBytesPerStone(1000);
+
+    ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+    WiredTigerSizeStorer sizeStorer(
+        WiredTigerRecoveryUnit::get(opCtx.get())->getSessionCache()->conn(),
+        "table:sizeStorer",
+        false);
+    wtrs->setSizeStorer(&sizeStorer);
+    ON_BLOCK_EXIT([&] { rs.reset(); });
+
+    for (int i = 1; i <= 6; i++) {
+        ASSERT_EQ(insertBSONWithSize(opCtx.get(), rs.get(), Timestamp(1, i), 100), RecordId(1, i));
+    }
+
+    // Stones out of order.
+    sizeStorer.storeOplogStonesToCache(
+        wtrs->getURI(),
+        BSON_ARRAY(BSON("records" << 2LL << "bytes" << 200LL << "lastRecord"
+                                  << RecordId(1, 4).repr())
+                   << BSON("records" << 2LL << "bytes" << 200LL << "lastRecord"
+                                     << RecordId(1, 2).repr())));
+
+    WiredTigerRecordStore::OplogStones oplogStones(opCtx.get(), wtrs);
+    BSONObjBuilder builder;
+    oplogStones.getOplogStonesStats(builder);
+    ASSERT_EQ("scanning", builder.obj()["processingMethod"].String());
+
+    // The recomputed stones replace the malformed ones in the size storer.
+    BSONObj persisted = sizeStorer.loadOplogStonesFromCache(wtrs->getURI());
+    ASSERT_EQ(static_cast<int>(oplogStones.numStones()), persisted.nFields());
+}
+
+// Verify that oplog truncation is postponed under cache pressure, unless the oplog has grown well
+// beyond its maximum size.
+TEST(WiredTigerRecordStoreTest, OplogStones_ThrottleReclaimUnderCachePressure) {
+    std::unique_ptr<RecordStoreHarnessHelper> harnessHelper = newRecordStoreHarnessHelper();
+
+    const int64_t cappedMaxSize = 10 * 1024;  // 10KB
+    unique_ptr<RecordStore> rs(
+        harnessHelper->newCappedRecordStore("local.oplog.stones", cappedMaxSize, -1));
+
+    WiredTigerRecordStore* wtrs = static_cast<WiredTigerRecordStore*>(rs.get());
+    WiredTigerRecordStore::OplogStones* oplogStones = wtrs->oplogStones();
+
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        ASSERT_OK(wtrs->updateCappedSize(opCtx.get(), 320U));
+    }
+
+    oplogStones->setMinBytesPerStone(100);
+
+    // Any cache usage counts as pressure.
+    const int oldMaxCacheFillPercent = wiredTigerOplogTruncationMaxCacheFillPercent.load();
+    ON_BLOCK_EXIT([&] {
+        wiredTigerOplogTruncationMaxCacheFillPercent.store(oldMaxCacheFillPercent);
+    });
+    wiredTigerOplogTruncationMaxCacheFillPercent.store(-1);
+
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+
+        ASSERT_EQ(insertBSONWithSize(opCtx.get(), rs.get(), Timestamp(1, 1), 100), RecordId(1, 1));
+        ASSERT_EQ(insertBSONWithSize(opCtx.get(), rs.get(), Timestamp(1, 2), 110), RecordId(1, 2));
+        ASSERT_EQ(insertBSONWithSize(opCtx.get(), rs.get(), Timestamp(1, 3), 120), RecordId(1, 3));
+        ASSERT_EQ(3U, oplogStones->numStones());
+    }
+
+    // The oplog is only 10 bytes over its maximum size, so truncation waits for the cache.
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+
+        ASSERT_FALSE(wtrs->reclaimOplog(opCtx.get()));
+
+        ASSERT_EQ(3, rs->numRecords(opCtx.get()));
+        ASSERT_EQ(330, rs->dataSize(opCtx.get()));
+        ASSERT_EQ(3U, oplogStones->numStones());
+
+        BSONObjBuilder builder;
+        oplogStones->getOplogStonesStats(builder);
+        ASSERT_EQ(1, builder.obj()["throttledCount"].numberLong());
+    }
+
+    // While the oplog overshoots its maximum size by 10%, truncation goes ahead regardless. Once
+    // the oldest stone is gone, the remaining 25 bytes of excess wait for the cache again.
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+
+        ASSERT_EQ(insertBSONWithSize(opCtx.get(), rs.get(), Timestamp(1, 4), 115), RecordId(1, 4));
+        ASSERT_EQ(4U, oplogStones->numStones());
+
+        ASSERT_FALSE(wtrs->reclaimOplog(opCtx.get()));
+
+        ASSERT_EQ(3, rs->numRecords(opCtx.get()));
+        ASSERT_EQ(345, rs->dataSize(opCtx.get()));
+        ASSERT_EQ(3U, oplogStones->numStones());
+    }
+
+    // Without throttling, truncation brings the oplog back under its maximum size.
+    wiredTigerOplogTruncationMaxCacheFillPercent.store(100);
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+
+        ASSERT_TRUE(wtrs->reclaimOplog(opCtx.get()));
+
+        ASSERT_EQ(2, rs->numRecords(opCtx.get()));
+        ASSERT_EQ(235, rs->dataSize(opCtx.get()));
+        ASSERT_EQ(2U, oplogStones->numStones());
+
+        BSONObjBuilder builder;
+        oplogStones->getOplogStonesStats(builder);
+        BSONObj stats = builder.obj();
+        ASSERT_EQ(2, stats["throttledCount"].numberLong());
+        ASSERT_EQ(2, stats["truncateCount"].numberLong());
+        ASSERT_EQ(210, stats["bytesReclaimed"].numberLong());
+    }
+}
+
 }  // namespace
 }  // namespace mongo
@@ -368,6 +368,13 @@ Status WiredTigerRecoveryUnit::selectSnapshot(Timestamp timestamp) {
     return Status::OK();
 }
 
+RecoveryUnit::OperationStatistics WiredTigerRecoveryUnit::getOperationStatistics() const {
+    OperationStatistics stats;
+    stats.bytesRead = _bytesRead;
+    stats.bytesWritten = _bytesWritten;
+    return stats;
+}
+
 void WiredTigerRecoveryUnit::setIsOplogReader() {
     // Note: it would be nice to assert !active here, but OplogStones currently opens a cursor on
     // the oplog while the recovery unit is already active.
@@ -92,11 +92,24 @@ public:
 
     void setRollbackWritesDisabled() override {}
 
+    OperationStatistics getOperationStatistics() const override;
+
     // ---- WT STUFF
 
     WiredTigerSession* getSession();
     void setIsOplogReader();
 
+    /**
+     * Per-operation accounting of the record bytes moved through this RU, reported by
+     * getOperationStatistics(). Only called by the thread that owns the operation.
+     */
+    void incrementBytesRead(long long bytes) {
+        _bytesRead += bytes;
+    }
+    void incrementBytesWritten(long long bytes) {
+        _bytesWritten += bytes;
+    }
+
     /**
      * Enter a period of wait or computation during which there are no WT calls.
      * Any non-relevant cached handles can be closed.
@@ -160,6 +173,8 @@ private:
     Timestamp _readAtTimestamp;
     std::unique_ptr<Timer> _timer;
     bool _isOplogReader = false;
+    long long _bytesRead = 0;
+    long long _bytesWritten = 0;
     typedef std::vector<std::unique_ptr<Change>> Changes;
     //ύ عWiredTigerRecoveryUnit::_commit WiredTigerRecoveryUnit::_abort
     //pushֵWiredTigerRecoveryUnit::registerChange
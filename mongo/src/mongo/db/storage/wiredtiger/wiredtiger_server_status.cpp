@@ -79,6 +79,12 @@ BSONObj WiredTigerServerStatusSection::generateSection(OperationContext* opCtx,
     }
 
     WiredTigerKVEngine::appendGlobalStats(bob);
+    _engine->appendSizeStorerStats(&bob);
+
+    {
+        BSONObjBuilder journal(bob.subobjStart("journal"));
+        WiredTigerRecoveryUnit::get(opCtx)->getSessionCache()->appendJournalStats(&journal);
+    }
 
     return bob.obj();
 }
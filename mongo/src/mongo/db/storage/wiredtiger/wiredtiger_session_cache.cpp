@@ -36,6 +36,8 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
 
 #include "mongo/base/error_codes.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/mongod_options.h"
 #include "mongo/db/repl/repl_settings.h"
 #include "mongo/db/storage/journal_listener.h"
@@ -45,6 +47,7 @@
 #include "mongo/stdx/thread.h"
 #include "mongo/util/log.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 /*
@@ -83,6 +86,17 @@ db/storage/wiredtiger/wiredtiger_kv_engine.cpp:    WiredTigerSession session(_co
 db/storage/wiredtiger/wiredtiger_session_cache.cpp:        UniqueWiredTigerSession session = getSession();
 */ //עЩطṹʹ
 //WiredTigerSessionCache::getSession->WiredTigerSession::WiredTigerSessionconnлȡһsessionϢ 
+namespace {
+// Upper bound on how long the thread flushing the journal for waitUntilDurable() holds the flush
+// back to let concurrent waiters join it. The actual delay is half of the last flush latency,
+// and no delay is taken unless other waiters are present. Zero disables the delay.
+MONGO_EXPORT_SERVER_PARAMETER(wiredTigerJournalCommitMaxDelayMicros, int, 1000);
+
+// Number of concurrent waiters at which a pending journal flush is issued without waiting for
+// the rest of the delay.
+MONGO_EXPORT_SERVER_PARAMETER(wiredTigerJournalCommitMaxGroupSize, int, 64);
+}  // namespace
+
 WiredTigerSession::WiredTigerSession(WT_CONNECTION* conn, uint64_t epoch, uint64_t cursorEpoch)
     : _epoch(epoch),
       _cursorEpoch(cursorEpoch),
@@ -156,6 +170,10 @@ if the record does not previously exist.
 
 //ȡcursor  ͬʱûȡc_cursorsбȥ
 WT_CURSOR* WiredTigerSession::getCursor(const std::string& uri, uint64_t id, bool forRecordStore) {
+    return getCursor(uri, id, forRecordStore ? "" : "overwrite=false");
+}
+
+WT_CURSOR* WiredTigerSession::getCursor(const std::string& uri, uint64_t id, const char* config) {
     // Find the most recently used cursor  
     for (CursorCache::iterator i = _cursors.begin(); i != _cursors.end(); ++i) {
         if (i->_id == id) {
@@ -169,7 +187,7 @@ WT_CURSOR* WiredTigerSession::getCursor(const std::string& uri, uint64_t id, boo
 
     WT_CURSOR* c = NULL; 
     int ret = _session->open_cursor( //falseظĻWT_DUPLICATE_KEYΪtureʼճɹд
-        _session, uri.c_str(), NULL, forRecordStore ? "" : "overwrite=false", &c);
+        _session, uri.c_str(), NULL, config, &c);
     if (ret != ENOENT)
         invariantWTOK(ret);
     if (c)
@@ -339,7 +357,23 @@ void WiredTigerSessionCache::waitUntilDurable(bool forceCheckpoint, bool stableC
         return;
     }
 
+    // Read _lastSyncTime before counting this thread as a waiter, so that every counted waiter is
+    // covered by the next flush to bump it.
     uint32_t start = _lastSyncTime.load();
+    const unsigned long long waitStart = curTimeMicros64();
+    const int waiters = _durableWaiters.addAndFetch(1);
+    ON_BLOCK_EXIT([this, waitStart] {
+        _durableWaiters.fetchAndSubtract(1);
+        _journalWaiters.fetchAndAdd(1);
+        _journalWaitMicros.fetchAndAdd(curTimeMicros64() - waitStart);
+    });
+
+    if (waiters >= wiredTigerJournalCommitMaxGroupSize.load()) {
+        // The group is full, so let a gathering leader flush right away.
+        stdx::lock_guard<stdx::mutex> gclk(_groupCommitMutex);
+        _groupCommitCond.notify_one();
+    }
+
     // Do the remainder in a critical section that ensures only a single thread at a time
     // will attempt to synchronize.
     stdx::unique_lock<stdx::mutex> lk(_lastSyncMutex);
@@ -348,9 +382,40 @@ void WiredTigerSessionCache::waitUntilDurable(bool forceCheckpoint, bool stableC
         // Someone else synced already since we read lastSyncTime, so we're done!
         return;
     }
+
+    // Nobody has synched yet, so we have to sync ourselves. If other threads are waiting as
+    // well, or the previous flush served more than one waiter, hold the flush back for a
+    // fraction of the last flush latency so that waiters arriving meanwhile share it. Waiters
+    // that read _lastSyncTime before it is bumped below are covered by this flush, since the
+    // journal listener token is only taken afterwards.
+    const int maxDelayMicros = std::min(wiredTigerJournalCommitMaxDelayMicros.load(), 100 * 1000);
+    if (maxDelayMicros > 0 && (_durableWaiters.load() > 1 || _lastGroupSize.load() > 1)) {
+        const long long delayMicros =
+            std::min<long long>(maxDelayMicros, _lastFlushMicros.load() / 2);
+        if (delayMicros > 0) {
+            const unsigned long long gatherStart = curTimeMicros64();
+            stdx::unique_lock<stdx::mutex> gclk(_groupCommitMutex);
+            _groupCommitCond.wait_for(gclk, stdx::chrono::microseconds(delayMicros), [this] {
+                return _durableWaiters.load() >= wiredTigerJournalCommitMaxGroupSize.load();
+            });
+            _journalGatherMicros.fetchAndAdd(curTimeMicros64() - gatherStart);
+        }
+    }
+
     _lastSyncTime.store(current + 1);
 
-    // Nobody has synched yet, so we have to sync ourselves.
+    // Every thread currently counted as a waiter has read _lastSyncTime by now, so this is an
+    // upper bound on the waiters served by this flush.
+    const int groupSize = _durableWaiters.load();
+    _lastGroupSize.store(groupSize);
+    _journalFlushes.fetchAndAdd(1);
+    _journalWaitersServed.fetchAndAdd(groupSize);
+    for (long long maxGroup = _journalMaxGroupSize.load(); groupSize > maxGroup;) {
+        const long long prev = _journalMaxGroupSize.compareAndSwap(maxGroup, groupSize);
+        if (prev == maxGroup)
+            break;
+        maxGroup = prev;
+    }
 
     // This gets the token (OpTime) from the last write, before flushing (either the journal, or a
     // checkpoint), and then reports that token (OpTime) as a durable write.
@@ -364,6 +429,7 @@ void WiredTigerSessionCache::waitUntilDurable(bool forceCheckpoint, bool stableC
     }
 
     // Use the journal when available, or a checkpoint otherwise.
+    const unsigned long long flushStart = curTimeMicros64();
     if (_engine && _engine->isDurable()) { //Ӧwiredtigerеlog־ģ
         invariantWTOK(_waitUntilDurableSession->log_flush(_waitUntilDurableSession, "sync=on"));
         LOG(4) << "flushed journal";
@@ -371,11 +437,29 @@ void WiredTigerSessionCache::waitUntilDurable(bool forceCheckpoint, bool stableC
         invariantWTOK(_waitUntilDurableSession->checkpoint(_waitUntilDurableSession, NULL));
         LOG(4) << "created checkpoint";
     }
+    const long long flushMicros = curTimeMicros64() - flushStart;
+    _lastFlushMicros.store(flushMicros);
+    _journalFlushMicros.fetchAndAdd(flushMicros);
 
 	//ReplicationCoordinatorExternalStateImpl::onDurable
     _journalListener->onDurable(token);
 }
 
+void WiredTigerSessionCache::appendJournalStats(BSONObjBuilder* builder) const {
+    const long long flushes = _journalFlushes.load();
+    builder->append("flushes", flushes);
+    builder->append("waiters", _journalWaiters.load());
+    builder->append("waitersServedByFlushes", _journalWaitersServed.load());
+    builder->append("averageGroupSize",
+                    flushes ? static_cast<double>(_journalWaitersServed.load()) / flushes : 0.0);
+    builder->append("maxGroupSize", _journalMaxGroupSize.load());
+    builder->append("currentWaiters", _durableWaiters.load());
+    builder->append("lastFlushMicros", _lastFlushMicros.load());
+    builder->append("totalFlushMicros", _journalFlushMicros.load());
+    builder->append("totalGatherMicros", _journalGatherMicros.load());
+    builder->append("totalWaitMicros", _journalWaitMicros.load());
+}
+
 void WiredTigerSessionCache::closeAllCursors(const std::string& uri) {
     stdx::lock_guard<stdx::mutex> lock(_cacheLock);
     for (SessionCache::iterator i = _sessions.begin(); i != _sessions.end(); i++) {
@@ -39,11 +39,13 @@
 #include "mongo/db/storage/journal_listener.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_snapshot_manager.h"
 #include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/mutex.h"
 #include "mongo/util/concurrency/spin_lock.h"
 
 namespace mongo {
 
+class BSONObjBuilder;
 class WiredTigerKVEngine;
 class WiredTigerSessionCache;
 
@@ -96,6 +98,12 @@ public:
 
     WT_CURSOR* getCursor(const std::string& uri, uint64_t id, bool forRecordStore);
 
+    /**
+     * Like above, but opens a missing cursor with the given 'config', e.g. "raw". All cursors
+     * cached under 'id' must have been opened with the same config.
+     */
+    WT_CURSOR* getCursor(const std::string& uri, uint64_t id, const char* config);
+
     void releaseCursor(uint64_t id, WT_CURSOR* cursor);
 
     void closeCursorsForQueuedDrops(WiredTigerKVEngine* engine);
@@ -201,6 +209,12 @@ public:
      */
     void waitUntilDurable(bool forceCheckpoint, bool stableCheckpoint);
 
+    /**
+     * Appends group commit statistics for waitUntilDurable() (flushes issued, waiters served
+     * per flush, time spent gathering, flushing and waiting) to 'builder'.
+     */
+    void appendJournalStats(BSONObjBuilder* builder) const;
+
     WT_CONNECTION* conn() const {
         return _conn;
     }
@@ -252,6 +266,24 @@ private:
     AtomicUInt32 _lastSyncTime;
     stdx::mutex _lastSyncMutex;
 
+    // Group commit state for waitUntilDurable. The thread that wins _lastSyncMutex may wait for
+    // a short, latency-derived window so that concurrent waiters share a single flush. Arriving
+    // waiters signal _groupCommitCond once the group is full.
+    stdx::mutex _groupCommitMutex;
+    stdx::condition_variable _groupCommitCond;
+    AtomicInt32 _durableWaiters;
+    AtomicInt32 _lastGroupSize;
+    AtomicInt64 _lastFlushMicros;
+
+    // Group commit statistics, reported under serverStatus().wiredTiger.journal.
+    AtomicInt64 _journalFlushes;
+    AtomicInt64 _journalWaiters;
+    AtomicInt64 _journalWaitersServed;
+    AtomicInt64 _journalMaxGroupSize;
+    AtomicInt64 _journalGatherMicros;
+    AtomicInt64 _journalFlushMicros;
+    AtomicInt64 _journalWaitMicros;
+
     // Protects _journalListener.
     stdx::mutex _journalListenerMutex;
     // Notified when we commit to the journal.
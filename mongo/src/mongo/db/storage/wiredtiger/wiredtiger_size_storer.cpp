@@ -46,6 +46,7 @@
 #include "mongo/stdx/thread.h"
 #include "mongo/util/log.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -53,6 +54,61 @@ using std::string;
 
 namespace {
 int MAGIC = 123123;
+
+// Hands out SizeInfo shards to threads in round robin order.
+AtomicUInt32 nextShard;
+}
+
+WiredTigerSizeStorer::SizeInfo::Shard& WiredTigerSizeStorer::SizeInfo::_shardFor(Shard* shards) {
+    static thread_local int shard = -1;
+    if (MONGO_unlikely(shard < 0)) {
+        shard = nextShard.fetchAndAdd(1) % kNumShards;
+    }
+    return shards[shard];
+}
+
+long long WiredTigerSizeStorer::SizeInfo::_sum(AtomicInt64 Shard::*counter) const {
+    long long total = 0;
+    for (const Shard& shard : _shards) {
+        total += (shard.*counter).load();
+    }
+    return total;
+}
+
+long long WiredTigerSizeStorer::SizeInfo::numRecords() const {
+    return std::max(_sum(&Shard::numRecords), 0LL);
+}
+
+long long WiredTigerSizeStorer::SizeInfo::dataSize() const {
+    return std::max(_sum(&Shard::dataSize), 0LL);
+}
+
+void WiredTigerSizeStorer::SizeInfo::changeNumRecords(long long diff) {
+    _shardFor(_shards).numRecords.fetchAndAdd(diff);
+}
+
+void WiredTigerSizeStorer::SizeInfo::changeDataSize(long long diff) {
+    _shardFor(_shards).dataSize.fetchAndAdd(diff);
+}
+
+void WiredTigerSizeStorer::SizeInfo::resetNegativeTotals() {
+    const long long numRecords = _sum(&Shard::numRecords);
+    if (numRecords < 0) {
+        _shards[0].numRecords.fetchAndAdd(-numRecords);
+    }
+    const long long dataSize = _sum(&Shard::dataSize);
+    if (dataSize < 0) {
+        _shards[0].dataSize.fetchAndAdd(-dataSize);
+    }
+}
+
+void WiredTigerSizeStorer::SizeInfo::set(long long numRecords, long long dataSize) {
+    for (int i = 1; i < kNumShards; i++) {
+        _shards[i].numRecords.store(0);
+        _shards[i].dataSize.store(0);
+    }
+    _shards[0].numRecords.store(numRecords);
+    _shards[0].dataSize.store(dataSize);
 }
 
 /* 
@@ -161,7 +217,7 @@ void WiredTigerSizeStorer::onCreate(WiredTigerRecordStore* rs,
     entry.rs = rs;
     entry.numRecords = numRecords;
     entry.dataSize = dataSize;
-    entry.dirty = true;
+    _dirtyUris.insert(rs->getURI());
 }
 
 void WiredTigerSizeStorer::onDestroy(WiredTigerRecordStore* rs) {
@@ -170,8 +226,8 @@ void WiredTigerSizeStorer::onDestroy(WiredTigerRecordStore* rs) {
     Entry& entry = _entries[rs->getURI()];
     entry.numRecords = rs->numRecords(NULL);
     entry.dataSize = rs->dataSize(NULL);
-    entry.dirty = true;
     entry.rs = NULL;
+    _dirtyUris.insert(rs->getURI());
 }
 
 //WiredTigerRecordStore::_increaseDataSize   WiredTigerKVEngine::okToRename
@@ -183,7 +239,7 @@ void WiredTigerSizeStorer::storeToCache(StringData uri, long long numRecords, lo
     Entry& entry = _entries[uri.toString()];
     entry.numRecords = numRecords;
     entry.dataSize = dataSize;
-    entry.dirty = true;
+    _dirtyUris.insert(uri.toString());
 }
 
 //WiredTigerSizeStorer::storeToCacheWiredTigerSizeStorer::loadFromCacheӦ
@@ -204,6 +260,30 @@ void WiredTigerSizeStorer::loadFromCache(StringData uri,
     *dataSize = it->second.dataSize;
 }
 
+void WiredTigerSizeStorer::storeOplogStonesToCache(StringData uri, const BSONObj& stones) {
+    _checkMagic();
+    stdx::lock_guard<stdx::mutex> lk(_entriesMutex);
+    Entry& entry = _entries[uri.toString()];
+    entry.oplogStones = stones.getOwned();
+    _dirtyUris.insert(uri.toString());
+}
+
+void WiredTigerSizeStorer::markDirty(StringData uri) {
+    _checkMagic();
+    stdx::lock_guard<stdx::mutex> lk(_entriesMutex);
+    _dirtyUris.insert(uri.toString());
+}
+
+BSONObj WiredTigerSizeStorer::loadOplogStonesFromCache(StringData uri) const {
+    _checkMagic();
+    stdx::lock_guard<stdx::mutex> lk(_entriesMutex);
+    Map::const_iterator it = _entries.find(uri.toString());
+    if (it == _entries.end()) {
+        return BSONObj();
+    }
+    return it->second.oplogStones;
+}
+
 //sizeStorer.wtȡݴcacheؽṹ
 void WiredTigerSizeStorer::fillCache() {
     stdx::lock_guard<stdx::mutex> cursorLock(_cursorMutex);
@@ -238,13 +318,17 @@ void WiredTigerSizeStorer::fillCache() {
             Entry& e = m[uriKey];
             e.numRecords = data["numRecords"].safeNumberLong();
             e.dataSize = data["dataSize"].safeNumberLong();
-            e.dirty = false;
+            BSONElement stonesElem = data["oplogStones"];
+            if (stonesElem.type() == Array) {
+                e.oplogStones = stonesElem.Obj().getOwned();
+            }
             e.rs = NULL;
         }
     }
 
     stdx::lock_guard<stdx::mutex> lk(_entriesMutex);
     _entries.swap(m);
+    _dirtyUris.clear();
 }
 
 //ͬwiredtiger  οhttp://www.mongoing.com/archives/5476
@@ -254,28 +338,28 @@ void WiredTigerSizeStorer::syncCache(bool syncToDisk) {
     stdx::lock_guard<stdx::mutex> cursorLock(_cursorMutex);
     _checkMagic();
 
+    Timer timer;
     Map myMap;
     {
-		//ҳڴкWT洢вһµdataSizenumRecords洢myMap
+        // Only tables reported dirty since the last sync are visited. The size info of a live
+        // record store is marked clean before it is read, so that changes racing with this sync
+        // report the table again.
         stdx::lock_guard<stdx::mutex> lk(_entriesMutex);
-        for (Map::iterator it = _entries.begin(); it != _entries.end(); ++it) {
-            std::string uriKey = it->first;
+        for (const std::string& uriKey : _dirtyUris) {
+            Map::iterator it = _entries.find(uriKey);
+            if (it == _entries.end())
+                continue;
             Entry& entry = it->second;
             if (entry.rs) {
-                if (entry.dataSize != entry.rs->dataSize(NULL)) {
-                    entry.dataSize = entry.rs->dataSize(NULL);
-                    entry.dirty = true;
-                }
-                if (entry.numRecords != entry.rs->numRecords(NULL)) {
-                    entry.numRecords = entry.rs->numRecords(NULL);
-                    entry.dirty = true;
-                }
+                entry.rs->sizeInfo().markClean();
+                // Syncs are serialized by '_cursorMutex', so no other thread resets these totals.
+                entry.rs->sizeInfo().resetNegativeTotals();
+                entry.numRecords = entry.rs->numRecords(NULL);
+                entry.dataSize = entry.rs->dataSize(NULL);
             }
-
-            if (!entry.dirty)
-                continue;
             myMap[uriKey] = entry;
         }
+        _dirtyUris.clear();
     }
 
     if (myMap.empty())
@@ -295,6 +379,9 @@ void WiredTigerSizeStorer::syncCache(bool syncToDisk) {
             BSONObjBuilder b;
             b.append("numRecords", entry.numRecords);
             b.append("dataSize", entry.dataSize);
+            if (!entry.oplogStones.isEmpty()) {
+                b.appendArray("oplogStones", entry.oplogStones);
+            }
             data = b.obj();
         }
 
@@ -312,11 +399,21 @@ void WiredTigerSizeStorer::syncCache(bool syncToDisk) {
     rollbacker.Dismiss();
     invariantWTOK(session->commit_transaction(session, NULL));
 
-    {
-        stdx::lock_guard<stdx::mutex> lk(_entriesMutex);
-        for (Map::iterator it = _entries.begin(); it != _entries.end(); ++it) {
-            it->second.dirty = false;
-        }
+    const long long micros = timer.micros();
+    _syncCount.fetchAndAdd(1);
+    _syncEntriesWritten.fetchAndAdd(myMap.size());
+    _syncTotalMicros.fetchAndAdd(micros);
+    _syncLastMicros.store(micros);
+    if (micros > _syncMaxMicros.load()) {
+        _syncMaxMicros.store(micros);  // Only the thread holding _cursorMutex writes this.
     }
 }
+
+void WiredTigerSizeStorer::appendStats(BSONObjBuilder* builder) const {
+    builder->append("syncs", _syncCount.load());
+    builder->append("entriesWritten", _syncEntriesWritten.load());
+    builder->append("totalSyncMicros", _syncTotalMicros.load());
+    builder->append("lastSyncMicros", _syncLastMicros.load());
+    builder->append("maxSyncMicros", _syncMaxMicros.load());
+}
 }
@@ -32,15 +32,19 @@
 #pragma once
 
 #include <map>
+#include <set>
 #include <string>
 #include <wiredtiger.h>
 
 #include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobj.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/mutex.h"
 
 namespace mongo {
 
+class BSONObjBuilder;
 class WiredTigerRecordStore;
 class WiredTigerSession;
 /*
@@ -55,6 +59,70 @@ mongodbʹ
 //WiredTigerKVEngine._sizeStorer(Աtable:sizeStorer)   WiredTigerRecordStore._sizeStorer(ÿһWiredTigerRecordStore࣬_sizeStorerΪͳϢ)
 class WiredTigerSizeStorer {
 public:
+    /**
+     * Record count and data size of a table. Changes are added to one of several cache line
+     * sized shards picked by the calling thread, so concurrent writers to one collection do not
+     * contend on a single counter; readers add the shards up. The dirty flag tells the owning
+     * record store when it has to report itself to the size storer again.
+     */
+    class SizeInfo {
+    public:
+        SizeInfo() = default;
+        SizeInfo(const SizeInfo&) = delete;
+        SizeInfo& operator=(const SizeInfo&) = delete;
+
+        long long numRecords() const;
+        long long dataSize() const;
+
+        void changeNumRecords(long long diff);
+        void changeDataSize(long long diff);
+
+        /**
+         * Replaces the current values. Changes made concurrently by other threads may be lost.
+         */
+        void set(long long numRecords, long long dataSize);
+
+        /**
+         * Brings a total that was decremented below zero back to zero, so that it does not absorb
+         * later increments. The readers above only clamp what they return. Concurrent calls may
+         * overshoot, so only the size storer's sync calls this, one table at a time.
+         */
+        void resetNegativeTotals();
+
+        /**
+         * Returns true if the table was clean, that is, if the caller must report it to the size
+         * storer. Every insert and delete calls this, so the common case of an already dirty
+         * table only reads the flag rather than writing to its cache line.
+         */
+        bool markDirty() {
+            return !_dirty.load() && !_dirty.swap(true);
+        }
+
+        /**
+         * Returns true if the table was dirty. Must be called before reading the values to write
+         * out, so that concurrent changes mark the table dirty again.
+         */
+        bool markClean() {
+            return _dirty.swap(false);
+        }
+
+    private:
+        static const int kNumShards = 16;
+
+        struct Shard {
+            AtomicInt64 numRecords;
+            AtomicInt64 dataSize;
+            char pad[64 - 2 * sizeof(AtomicInt64)];
+        };
+
+        static Shard& _shardFor(Shard* shards);
+
+        long long _sum(AtomicInt64 Shard::*counter) const;
+
+        Shard _shards[kNumShards];
+        AtomicBool _dirty;
+    };
+
     WiredTigerSizeStorer(WT_CONNECTION* conn,
                          const std::string& storageUri,
                          const bool isWiredTigerLoggingEnabled,
@@ -68,24 +136,47 @@ public:
 
     void loadFromCache(StringData uri, long long* numRecords, long long* dataSize) const;
 
+    /**
+     * Called by a record store whose size info went from clean to dirty, so that the next sync
+     * writes out its current size and count. Only tables reported here are visited by syncCache().
+     */
+    void markDirty(StringData uri);
+
+    /**
+     * Remembers the oplog stones of the table 'uri' so that they are written out together with
+     * its size and count on the next sync. 'stones' is an array of { records, bytes, lastRecord }
+     * documents ordered from oldest to newest.
+     */
+    void storeOplogStonesToCache(StringData uri, const BSONObj& stones);
+
+    /**
+     * Returns the oplog stones last stored for the table 'uri', or an empty object if none exist.
+     */
+    BSONObj loadOplogStonesFromCache(StringData uri) const;
+
     /**
      * Loads from the underlying table.
      */
     void fillCache();
 
     /**
-     * Writes all changes to the underlying table.
+     * Writes all changes to the underlying table, using a single transaction.
      */
     void syncCache(bool syncToDisk);
 
+    /**
+     * Appends the number, duration and size of the syncs done so far to 'builder'.
+     */
+    void appendStats(BSONObjBuilder* builder) const;
+
 private:
     void _checkMagic() const;
 
     struct Entry { //Map _entries;õýṹ
-        Entry() : numRecords(0), dataSize(0), dirty(false), rs(NULL) {}
+        Entry() : numRecords(0), dataSize(0), rs(NULL) {}
         long long numRecords;
         long long dataSize;
-        bool dirty; //Ƿdirtyݣsynְ̺λfalse
+        BSONObj oplogStones;  // Owned. Empty unless the entry belongs to the oplog.
         WiredTigerRecordStore* rs;  // not owned  ӦļWiredTigerRecordStore.uri
     };
 
@@ -101,5 +192,13 @@ private:
     //ÿ60ͬһΡdirty entryµwt,ʱʵּ_sizeStorerSyncTracker
     Map _entries; //WiredTigerSizeStorer._entries[].rs mapм¼еļͳϢ
     mutable stdx::mutex _entriesMutex;
+    // Tables that may have changed since the last sync. Guarded by _entriesMutex.
+    std::set<std::string> _dirtyUris;
+
+    AtomicInt64 _syncCount;
+    AtomicInt64 _syncEntriesWritten;
+    AtomicInt64 _syncTotalMicros;
+    AtomicInt64 _syncLastMicros;
+    AtomicInt64 _syncMaxMicros;
 };
 }
@@ -43,6 +43,8 @@
 #include "mongo/db/storage/kv/kv_engine_test_harness.h"
 #include "mongo/db/storage/kv/kv_prefix.h"
 #include "mongo/db/storage/record_store_test_harness.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_cache_warmer.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_column_store.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_kv_engine.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store_oplog_stones.h"
@@ -51,11 +53,13 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_size_storer.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/clock_source_mock.h"
 #include "mongo/util/fail_point.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 namespace {
@@ -124,6 +128,44 @@ public:
         return std::move(ret);
     }
 
+    std::unique_ptr<RecordStore> newColumnStoreRecordStore(const std::string& ns,
+                                                           std::vector<std::string> fields) {
+        WiredTigerRecoveryUnit* ru =
+            dynamic_cast<WiredTigerRecoveryUnit*>(_engine.newRecoveryUnit());
+        OperationContextNoop opCtx(ru);
+        string uri = "table:" + ns;
+
+        const bool prefixed = false;
+        StatusWith<std::string> result = WiredTigerRecordStore::generateCreateString(
+            kWiredTigerEngineName, ns, CollectionOptions(), "", prefixed);
+        ASSERT_TRUE(result.isOK());
+        std::string config = result.getValue();
+
+        {
+            WriteUnitOfWork uow(&opCtx);
+            WT_SESSION* s = ru->getSession()->getSession();
+            invariantWTOK(s->create(s, uri.c_str(), config.c_str()));
+            ASSERT_OK(WiredTigerColumnStore::create(s, uri, fields));
+            uow.commit();
+        }
+
+        WiredTigerRecordStore::Params params;
+        params.ns = ns;
+        params.uri = uri;
+        params.engineName = kWiredTigerEngineName;
+        params.isCapped = false;
+        params.isEphemeral = false;
+        params.cappedMaxSize = -1;
+        params.cappedMaxDocs = -1;
+        params.cappedCallback = nullptr;
+        params.sizeStorer = nullptr;
+        params.columnStoreFields = std::move(fields);
+
+        auto ret = stdx::make_unique<StandardWiredTigerRecordStore>(&_engine, &opCtx, params);
+        ret->postConstructorInit(&opCtx);
+        return std::move(ret);
+    }
+
     virtual std::unique_ptr<RecordStore> newCappedRecordStore(int64_t cappedSizeBytes,
                                                               int64_t cappedMaxDocs) final {
         return newCappedRecordStore("a.b", cappedSizeBytes, cappedMaxDocs);
@@ -296,6 +338,329 @@ TEST(WiredTigerRecordStoreTest, SizeStorer1) {
     rs.reset(NULL);  // this has to be deleted before ss
 }
 
+TEST(WiredTigerRecordStoreTest, SizeStorerPersistsOplogStones) {
+    unique_ptr<WiredTigerHarnessHelper> harnessHelper(new WiredTigerHarnessHelper());
+
+    string uri = "table:local/oplog";
+    string sizeStorerUri = "table:sizeStorer";
+    const bool enableWtLogging = false;
+
+    BSONObj stones = BSON_ARRAY(BSON("records" << 10LL << "bytes" << 100LL << "lastRecord" << 5LL)
+                                << BSON("records" << 20LL << "bytes" << 200LL << "lastRecord"
+                                                  << 9LL));
+    {
+        WiredTigerSizeStorer ss(harnessHelper->conn(), sizeStorerUri, enableWtLogging);
+        ASSERT_TRUE(ss.loadOplogStonesFromCache(uri).isEmpty());
+
+        ss.storeToCache(uri, 30, 300);
+        ss.storeOplogStonesToCache(uri, stones);
+        ASSERT_BSONOBJ_EQ(stones, ss.loadOplogStonesFromCache(uri));
+        ss.syncCache(true);
+    }
+
+    {
+        WiredTigerSizeStorer ss(harnessHelper->conn(), sizeStorerUri, enableWtLogging);
+        ss.fillCache();
+
+        long long numRecords;
+        long long dataSize;
+        ss.loadFromCache(uri, &numRecords, &dataSize);
+        ASSERT_EQUALS(30, numRecords);
+        ASSERT_EQUALS(300, dataSize);
+        ASSERT_BSONOBJ_EQ(stones, ss.loadOplogStonesFromCache(uri));
+
+        // Tables without oplog stones are stored without them.
+        ss.storeToCache("table:a.b", 1, 1);
+        ss.syncCache(true);
+        ss.fillCache();
+        ASSERT_TRUE(ss.loadOplogStonesFromCache("table:a.b").isEmpty());
+    }
+}
+
+TEST(WiredTigerRecordStoreTest, SizeStorerSyncsOnlyDirtyEntries) {
+    unique_ptr<WiredTigerHarnessHelper> harnessHelper(new WiredTigerHarnessHelper());
+    const bool enableWtLogging = false;
+    WiredTigerSizeStorer ss(harnessHelper->conn(), "table:sizeStorer", enableWtLogging);
+
+    auto entriesWritten = [&] {
+        BSONObjBuilder builder;
+        ss.appendStats(&builder);
+        return builder.obj()["entriesWritten"].numberLong();
+    };
+
+    ss.storeToCache("table:a", 1, 10);
+    ss.storeToCache("table:b", 2, 20);
+    ss.syncCache(true);
+    ASSERT_EQUALS(2, entriesWritten());
+
+    ss.syncCache(true);
+    ASSERT_EQUALS(2, entriesWritten());
+
+    ss.storeToCache("table:b", 3, 30);
+    ss.syncCache(true);
+    ASSERT_EQUALS(3, entriesWritten());
+
+    // A record store reports itself once per sync, however many writes it takes.
+    unique_ptr<RecordStore> rs(harnessHelper->newNonCappedRecordStore());
+    WiredTigerRecordStore* wtrs = checked_cast<WiredTigerRecordStore*>(rs.get());
+    wtrs->setSizeStorer(&ss);
+    ss.onCreate(wtrs, 0, 0);
+    ss.syncCache(true);
+    ASSERT_EQUALS(4, entriesWritten());
+
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        WriteUnitOfWork uow(opCtx.get());
+        for (int i = 0; i < 100; i++) {
+            ASSERT_OK(rs->insertRecord(opCtx.get(), "a", 2, Timestamp(), false).getStatus());
+        }
+        uow.commit();
+    }
+    ss.syncCache(true);
+    ASSERT_EQUALS(5, entriesWritten());
+
+    long long numRecords;
+    long long dataSize;
+    ss.loadFromCache(wtrs->getURI(), &numRecords, &dataSize);
+    ASSERT_EQUALS(100, numRecords);
+    ASSERT_EQUALS(200, dataSize);
+
+    rs.reset(NULL);  // this has to be deleted before ss
+}
+
+TEST(WiredTigerRecordStoreTest, SizeInfoSumsConcurrentChanges) {
+    WiredTigerSizeStorer::SizeInfo sizeInfo;
+    sizeInfo.set(10, 100);
+
+    const int kThreads = 8;
+    const int kChangesPerThread = 1000;
+    std::vector<stdx::thread> threads;
+    for (int i = 0; i < kThreads; i++) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < kChangesPerThread; j++) {
+                sizeInfo.changeNumRecords(1);
+                sizeInfo.changeDataSize(3);
+            }
+        });
+    }
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQUALS(10 + kThreads * kChangesPerThread, sizeInfo.numRecords());
+    ASSERT_EQUALS(100 + 3 * kThreads * kChangesPerThread, sizeInfo.dataSize());
+
+    sizeInfo.set(5, 50);
+    ASSERT_EQUALS(5, sizeInfo.numRecords());
+    ASSERT_EQUALS(50, sizeInfo.dataSize());
+
+    // Counts never go negative, and once the size storer has reset them a decrement below zero
+    // does not absorb later increments.
+    sizeInfo.changeNumRecords(-10);
+    sizeInfo.changeDataSize(-80);
+    ASSERT_EQUALS(0, sizeInfo.numRecords());
+    ASSERT_EQUALS(0, sizeInfo.dataSize());
+
+    sizeInfo.resetNegativeTotals();
+    sizeInfo.changeNumRecords(2);
+    sizeInfo.changeDataSize(7);
+    ASSERT_EQUALS(2, sizeInfo.numRecords());
+    ASSERT_EQUALS(7, sizeInfo.dataSize());
+}
+
+TEST(WiredTigerRecordStoreTest, CacheWarmerRecordsWorkingSet) {
+    unique_ptr<WiredTigerHarnessHelper> harnessHelper(new WiredTigerHarnessHelper());
+    unique_ptr<RecordStore> rs(harnessHelper->newNonCappedRecordStore());
+    string uri = checked_cast<WiredTigerRecordStore*>(rs.get())->getURI();
+
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        WriteUnitOfWork uow(opCtx.get());
+        for (int i = 0; i < 1000; i++) {
+            ASSERT_OK(rs->insertRecord(opCtx.get(), "abcdefgh", 9, Timestamp(), false).getStatus());
+        }
+        uow.commit();
+    }
+
+    unittest::TempDir manifestDir("wt_cache_warmer");
+    WiredTigerCacheWarmer warmer(harnessHelper->conn(), manifestDir.path());
+    ASSERT_TRUE(warmer.readManifest().isEmpty());
+
+    warmer.recordWorkingSet();
+    BSONObj manifest = warmer.readManifest();
+    ASSERT_EQUALS(1, manifest.getIntField("version"));
+
+    bool found = false;
+    for (auto&& elem : manifest["tables"].Obj()) {
+        if (elem.Obj()["uri"].str() == uri) {
+            found = true;
+            ASSERT_GREATER_THAN(elem.Obj()["cachedBytes"].safeNumberLong(), 0);
+        }
+    }
+    ASSERT_TRUE(found);
+
+    // Everything is still cached, so warming up has nothing left to load.
+    warmer.warmUp(manifest);
+    BSONObjBuilder stats;
+    WiredTigerCacheWarmer::appendGlobalStats(stats);
+    BSONObj warmupStats = stats.obj()["cacheWarmup"].Obj();
+    ASSERT_EQUALS("done", warmupStats["state"].str());
+    ASSERT_EQUALS(manifest["tables"].Obj().nFields(), warmupStats["tablesWarmed"].numberInt());
+
+    rs.reset(NULL);
+}
+
+TEST(WiredTigerRecordStoreTest, ColumnStoreParsesFields) {
+    ASSERT_OK(WiredTigerColumnStore::parseFields(fromjson("{c: ['a', 'b']}")["c"]).getStatus());
+    ASSERT_NOT_OK(WiredTigerColumnStore::parseFields(fromjson("{c: 'a'}")["c"]).getStatus());
+    ASSERT_NOT_OK(WiredTigerColumnStore::parseFields(fromjson("{c: []}")["c"]).getStatus());
+    ASSERT_NOT_OK(WiredTigerColumnStore::parseFields(fromjson("{c: ['a.b']}")["c"]).getStatus());
+    ASSERT_NOT_OK(WiredTigerColumnStore::parseFields(fromjson("{c: ['$a']}")["c"]).getStatus());
+    ASSERT_NOT_OK(WiredTigerColumnStore::parseFields(fromjson("{c: ['a', 'a']}")["c"]).getStatus());
+
+    CollectionOptions options;
+    options.capped = true;
+    options.cappedSize = 4096;
+    options.storageEngine = fromjson("{wiredTiger: {columnStore: ['a']}}");
+    ASSERT_NOT_OK(WiredTigerRecordStore::generateCreateString(
+                      kWiredTigerEngineName, "a.b", options, "", false)
+                      .getStatus());
+}
+
+TEST(WiredTigerRecordStoreTest, ColumnStoreFollowsWrites) {
+    unique_ptr<WiredTigerHarnessHelper> harnessHelper(new WiredTigerHarnessHelper());
+    unique_ptr<RecordStore> rs(harnessHelper->newColumnStoreRecordStore("a.c", {"a", "b", "c"}));
+    ASSERT(rs->getColumnStoreFields() == std::vector<std::string>({"a", "b", "c"}));
+
+    const BSONObj docs[] = {fromjson("{_id: 1, a: 1, b: 'x', c: [1]}"),
+                            fromjson("{_id: 2, c: 3, a: 2}"),
+                            fromjson("{_id: 3, z: 1}")};
+    RecordId ids[3];
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        WriteUnitOfWork uow(opCtx.get());
+        for (int i = 0; i < 3; i++) {
+            auto res = rs->insertRecord(
+                opCtx.get(), docs[i].objdata(), docs[i].objsize(), Timestamp(), false);
+            ASSERT_OK(res.getStatus());
+            ids[i] = res.getValue();
+        }
+        uow.commit();
+    }
+
+    auto scan = [&](const std::vector<std::string>& fields) {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        std::vector<BSONObj> out;
+        auto cursor = rs->getColumnStoreCursor(opCtx.get(), fields);
+        ASSERT(cursor);
+        while (auto record = cursor->next()) {
+            out.push_back(record->data.toBson().getOwned());
+        }
+        return out;
+    };
+
+    // Documents keep the original order of their fields.
+    std::vector<BSONObj> out = scan({"a", "c"});
+    ASSERT_EQUALS(3U, out.size());
+    ASSERT_BSONOBJ_EQ(fromjson("{a: 1, c: [1]}"), out[0]);
+    ASSERT_BSONOBJ_EQ(fromjson("{c: 3, a: 2}"), out[1]);
+    ASSERT_BSONOBJ_EQ(BSONObj(), out[2]);
+
+    out = scan({"b"});
+    ASSERT_EQUALS(3U, out.size());
+    ASSERT_BSONOBJ_EQ(fromjson("{b: 'x'}"), out[0]);
+
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        WriteUnitOfWork uow(opCtx.get());
+        BSONObj updated = fromjson("{_id: 1, a: 5}");
+        ASSERT_OK(rs->updateRecord(
+            opCtx.get(), ids[0], updated.objdata(), updated.objsize(), false, NULL));
+        rs->deleteRecord(opCtx.get(), ids[1]);
+        uow.commit();
+    }
+
+    out = scan({"a", "b", "c"});
+    ASSERT_EQUALS(2U, out.size());
+    ASSERT_BSONOBJ_EQ(fromjson("{a: 5}"), out[0]);
+    ASSERT_BSONOBJ_EQ(BSONObj(), out[1]);
+
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        WriteUnitOfWork uow(opCtx.get());
+        ASSERT_OK(rs->truncate(opCtx.get()));
+        uow.commit();
+    }
+    ASSERT_EQUALS(0U, scan({"a"}).size());
+}
+
+/**
+ * Holds back the first journal flush until a given number of threads are waiting for durability,
+ * so that they all arrive while that flush is in progress.
+ */
+class BlockingJournalListener : public JournalListener {
+public:
+    BlockingJournalListener(WiredTigerSessionCache* sessionCache, long long waitersToBlockFor)
+        : _sessionCache(sessionCache), _waitersToBlockFor(waitersToBlockFor) {}
+
+    Token getToken() override {
+        if (!_blocked) {
+            _blocked = true;
+            while (currentWaiters() < _waitersToBlockFor) {
+                sleepmillis(1);
+            }
+        }
+        return Token();
+    }
+
+    void onDurable(const Token& token) override {}
+
+private:
+    long long currentWaiters() const {
+        BSONObjBuilder builder;
+        _sessionCache->appendJournalStats(&builder);
+        return builder.obj()["currentWaiters"].numberLong();
+    }
+
+    WiredTigerSessionCache* const _sessionCache;
+    const long long _waitersToBlockFor;
+
+    // Only accessed while the session cache holds its journal listener mutex.
+    bool _blocked = false;
+};
+
+TEST(WiredTigerRecordStoreTest, WaitUntilDurableGroupsConcurrentWaiters) {
+    unique_ptr<WiredTigerHarnessHelper> harnessHelper(new WiredTigerHarnessHelper());
+    unique_ptr<RecoveryUnit> ru(harnessHelper->newRecoveryUnit());
+    WiredTigerSessionCache* sessionCache =
+        checked_cast<WiredTigerRecoveryUnit*>(ru.get())->getSessionCache();
+
+    // The first flush is held back until all of the threads are waiting. The waiters that arrive
+    // after it started then share at most one more flush.
+    const int kThreads = 16;
+    BlockingJournalListener listener(sessionCache, kThreads);
+    sessionCache->setJournalListener(&listener);
+    ON_BLOCK_EXIT([&] { sessionCache->setJournalListener(&NoOpJournalListener::instance); });
+
+    std::vector<stdx::thread> threads;
+    for (int i = 0; i < kThreads; i++) {
+        threads.emplace_back([&] { sessionCache->waitUntilDurable(false, false); });
+    }
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+
+    BSONObjBuilder builder;
+    sessionCache->appendJournalStats(&builder);
+    BSONObj stats = builder.obj();
+    ASSERT_EQUALS(kThreads, stats["waiters"].numberLong());
+    ASSERT_EQUALS(0, stats["currentWaiters"].numberLong());
+    ASSERT_GREATER_THAN_OR_EQUALS(stats["flushes"].numberLong(), 1);
+    ASSERT_LESS_THAN_OR_EQUALS(stats["flushes"].numberLong(), 2);
+    ASSERT_LESS_THAN(stats["flushes"].numberLong(), stats["waiters"].numberLong());
+    ASSERT_LESS_THAN_OR_EQUALS(stats["maxGroupSize"].numberLong(), kThreads);
+}
+
 class GoodValidateAdaptor : public ValidateAdaptor {
 public:
     virtual Status validate(const RecordId& recordId, const RecordData& record, size_t* dataSize) {
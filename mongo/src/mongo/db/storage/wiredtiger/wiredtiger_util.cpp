@@ -332,6 +332,17 @@ int64_t WiredTigerUtil::getIdentSize(WT_SESSION* s, const std::string& uri) {
     return result.getValue();
 }
 
+int WiredTigerUtil::getCacheFillPercent(WT_SESSION* session) {
+    auto inUse = getStatisticsValueAs<int64_t>(
+        session, "statistics:", "statistics=(fast)", WT_STAT_CONN_CACHE_BYTES_INUSE);
+    auto max = getStatisticsValueAs<int64_t>(
+        session, "statistics:", "statistics=(fast)", WT_STAT_CONN_CACHE_BYTES_MAX);
+    if (!inUse.isOK() || !max.isOK() || max.getValue() <= 0) {
+        return 0;
+    }
+    return static_cast<int>(100 * inUse.getValue() / max.getValue());
+}
+
 //GBתΪMB
 size_t WiredTigerUtil::getCacheSizeMB(double requestedCacheSizeGB) {
     double cacheSizeMB;
@@ -176,6 +176,12 @@ public:
 
     static int64_t getIdentSize(WT_SESSION* s, const std::string& uri);
 
+    /**
+     * Returns the percentage of the WiredTiger cache currently in use, or 0 if the connection
+     * statistics cannot be read.
+     */
+    static int getCacheFillPercent(WT_SESSION* session);
+
 
     /**
      * Return amount of memory to use for the WiredTiger cache based on either the startup
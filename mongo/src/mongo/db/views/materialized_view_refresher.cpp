@@ -0,0 +1,599 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/views/materialized_view_refresher.h"
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/simple_bsonobj_comparator.h"
+#include "mongo/client/dbclientcursor.h"
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/fsync.h"
+#include "mongo/db/concurrency/d_concurrency.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/dbdirectclient.h"
+#include "mongo/db/dbhelpers.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/pipeline/accumulation_statement.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/query/cursor_response.h"
+#include "mongo/db/query/internal_plans.h"
+#include "mongo/db/repl/oplog.h"
+#include "mongo/db/repl/replication_coordinator_global.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage/storage_engine.h"
+#include "mongo/db/views/materialized_view_registry.h"
+#include "mongo/db/views/view.h"
+#include "mongo/db/views/view_catalog.h"
+#include "mongo/rpc/get_status_from_command_result.h"
+#include "mongo/util/background.h"
+#include "mongo/util/concurrency/idle_thread_block.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+#include "mongo/util/md5.hpp"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+MONGO_EXPORT_SERVER_PARAMETER(materializedViewRefresherEnabled, bool, true);
+MONGO_EXPORT_SERVER_PARAMETER(materializedViewRefreshIntervalMillis, int, 1000);
+// The least time between the end of one full refresh of a view and the start of the next. The
+// changes which require one are coalesced in the meantime.
+MONGO_EXPORT_SERVER_PARAMETER(materializedViewMinFullRefreshIntervalMillis, int, 10000);
+
+namespace {
+
+// How many inserted documents are looked up by one incremental refresh query.
+const size_t kIncrementalRefreshBatchSize = 1000;
+
+// How many results are written to the backing collection under one exclusive lock.
+const size_t kWriteBatchSize = 100;
+
+/**
+ * Returns true if documents inserted into the source collection of a view defined by 'pipeline'
+ * can be folded into its backing collection without recomputing the rest. That is the case for
+ * $match, $project and $addFields stages, optionally followed by a $group whose accumulators are
+ * all $sum, $min or $max. Fills '*accumulators' with the accumulator of each field of that $group.
+ */
+bool canRefreshIncrementally(const std::vector<BSONObj>& pipeline,
+                             StringMap<std::string>* accumulators) {
+    for (size_t i = 0; i < pipeline.size(); ++i) {
+        const StringData stageName = pipeline[i].firstElementFieldName();
+        if (stageName == "$match"_sd || stageName == "$project"_sd ||
+            stageName == "$addFields"_sd) {
+            continue;
+        }
+
+        const BSONElement groupSpec = pipeline[i].firstElement();
+        if (stageName != "$group"_sd || i != pipeline.size() - 1 || groupSpec.type() != Object) {
+            return false;
+        }
+        for (auto&& field : groupSpec.Obj()) {
+            if (field.fieldNameStringData() == "_id"_sd) {
+                continue;
+            }
+            if (field.type() != Object || field.Obj().nFields() != 1) {
+                return false;
+            }
+            const StringData accumulator = field.Obj().firstElementFieldName();
+            if (accumulator != "$sum"_sd && accumulator != "$min"_sd &&
+                accumulator != "$max"_sd) {
+                return false;
+            }
+            (*accumulators)[field.fieldNameStringData()] = accumulator.toString();
+        }
+    }
+    return true;
+}
+
+/**
+ * Runs 'pipeline' on 'nss' and passes each result to 'callback'.
+ */
+void runAggregation(OperationContext* opCtx,
+                    const NamespaceString& nss,
+                    const std::vector<BSONObj>& pipeline,
+                    const CollatorInterface* collator,
+                    const stdx::function<void(const BSONObj&)>& callback) {
+    BSONObjBuilder cmdBuilder;
+    cmdBuilder.append("aggregate", nss.coll());
+    cmdBuilder.append("pipeline", pipeline);
+    cmdBuilder.append("cursor", BSONObj());
+    cmdBuilder.append("allowDiskUse", true);
+    if (collator) {
+        cmdBuilder.append("collation", collator->getSpec().toBSON());
+    }
+
+    DBDirectClient client(opCtx);
+    BSONObj response;
+    client.runCommand(nss.db().toString(), cmdBuilder.obj(), response);
+    uassertStatusOK(getStatusFromCommandResult(response));
+
+    auto cursorResponse = uassertStatusOK(CursorResponse::parseFromBSON(response));
+    for (auto&& result : cursorResponse.getBatch()) {
+        callback(result);
+    }
+    if (cursorResponse.getCursorId()) {
+        DBClientCursor cursor(&client, nss.ns(), cursorResponse.getCursorId(), 0, 0);
+        while (cursor.more()) {
+            callback(cursor.nextSafe());
+        }
+    }
+}
+
+/**
+ * Returns the _id under which to store 'result' in the backing collection, as an {_id: <value>}
+ * document: the result's own _id if it has one which is not in 'seenIds', and otherwise one
+ * derived from its contents. Identical results get the same _id on every full refresh, so that
+ * they are not rewritten. Adds the _id to 'seenIds'.
+ */
+BSONObj storedIdFor(const BSONObj& result, BSONObjSet* seenIds) {
+    const BSONElement idElem = result["_id"];
+    if (!idElem.eoo()) {
+        BSONObj id = idElem.wrap();
+        if (seenIds->insert(id).second) {
+            return id;
+        }
+    }
+
+    const std::string digest = md5simpledigest(result.objdata(), result.objsize());
+    BSONObj id = BSON("_id" << digest);
+    for (int n = 1; !seenIds->insert(id).second; ++n) {
+        id = BSON("_id" << std::string(str::stream() << digest << "-" << n));
+    }
+    return id;
+}
+
+/**
+ * Returns the backing collection document which stores 'result' under the _id in 'id'.
+ */
+BSONObj wrapResult(const BSONObj& id, const BSONObj& result) {
+    BSONObjBuilder builder;
+    builder.appendElements(id);
+    builder.append(MaterializedViewRegistry::kResultField, result);
+    return builder.obj();
+}
+
+/**
+ * Combines a $group result already in the backing collection with the partial result computed
+ * for newly inserted documents. Both are backing collection documents.
+ */
+BSONObj mergeGroupResult(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                         const StringMap<std::string>& accumulators,
+                         const BSONObj& existingDoc,
+                         const BSONObj& deltaDoc) {
+    const BSONObj existing = existingDoc[MaterializedViewRegistry::kResultField].Obj();
+    const BSONObj delta = deltaDoc[MaterializedViewRegistry::kResultField].Obj();
+    MutableDocument merged{Document(existing)};
+    for (auto&& fieldAndAccumulator : accumulators) {
+        auto accumulator = AccumulationStatement::getFactory(fieldAndAccumulator.second)(expCtx);
+        accumulator->process(Value(existing[fieldAndAccumulator.first]), true);
+        accumulator->process(Value(delta[fieldAndAccumulator.first]), true);
+        merged.setField(fieldAndAccumulator.first, accumulator->getValue(false));
+    }
+    return wrapResult(existingDoc["_id"].wrap(), merged.freeze().toBson());
+}
+
+/**
+ * Stores the backing collection document 'resultDoc', replacing the document with the same _id.
+ * If 'accumulators' is not empty, 'resultDoc' is merged into that document instead.
+ */
+void applyResult(OperationContext* opCtx,
+                 Collection* backingColl,
+                 const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                 const StringMap<std::string>& accumulators,
+                 const BSONObj& resultDoc) {
+    writeConflictRetry(opCtx, "materializedViewRefresh", backingColl->ns().ns(), [&] {
+        BSONObj doc = resultDoc;
+        const RecordId rid = Helpers::findById(opCtx, backingColl, resultDoc["_id"].wrap());
+
+        WriteUnitOfWork wuow(opCtx);
+        if (!rid.isNull()) {
+            const BSONObj existing = backingColl->docFor(opCtx, rid).value();
+            if (!accumulators.empty()) {
+                doc = mergeGroupResult(expCtx, accumulators, existing, resultDoc);
+            }
+            if (SimpleBSONObjComparator::kInstance.evaluate(existing == doc)) {
+                return;
+            }
+            backingColl->deleteDocument(opCtx, kUninitializedStmtId, rid, nullptr);
+        }
+        uassertStatusOK(backingColl->insertDocument(opCtx, InsertStatement(doc), nullptr, false));
+        wuow.commit();
+    });
+}
+
+/**
+ * Runs 'writeBatch' on the backing collection 'backingNss' under an exclusive lock. The lock is
+ * only taken for one batch of writes at a time, so that reads of the view wait for that batch
+ * rather than for the whole refresh, and the view's pipeline runs without holding any lock.
+ */
+void writeToBackingCollection(OperationContext* opCtx,
+                              const NamespaceString& backingNss,
+                              const stdx::function<void(Collection*)>& writeBatch) {
+    AutoGetCollection autoColl(opCtx, backingNss, MODE_X);
+    Collection* backingColl = autoColl.getCollection();
+    uassert(ErrorCodes::NamespaceNotFound,
+            str::stream() << "backing collection " << backingNss.ns()
+                          << " was dropped during the refresh",
+            backingColl);
+    uassert(ErrorCodes::NotMaster,
+            str::stream() << "not primary while refreshing " << backingNss.ns(),
+            repl::getGlobalReplicationCoordinator()->canAcceptWritesFor(opCtx, backingNss));
+    writeBatch(backingColl);
+}
+
+/**
+ * Collects the results of a refresh and stores them in the backing collection kWriteBatchSize at
+ * a time.
+ */
+class ResultWriter {
+    MONGO_DISALLOW_COPYING(ResultWriter);
+
+public:
+    ResultWriter(OperationContext* opCtx,
+                 const NamespaceString& backingNss,
+                 const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                 const StringMap<std::string>& accumulators)
+        : _opCtx(opCtx), _backingNss(backingNss), _expCtx(expCtx), _accumulators(accumulators) {}
+
+    /**
+     * Adds 'result' to be stored under the _id in 'id'.
+     */
+    void add(const BSONObj& id, const BSONObj& result) {
+        _results.push_back(wrapResult(id, result));
+        if (_results.size() >= kWriteBatchSize) {
+            flush();
+        }
+    }
+
+    void flush() {
+        if (_results.empty()) {
+            return;
+        }
+        writeToBackingCollection(_opCtx, _backingNss, [&](Collection* backingColl) {
+            for (auto&& result : _results) {
+                applyResult(_opCtx, backingColl, _expCtx, _accumulators, result);
+            }
+        });
+        _results.clear();
+    }
+
+private:
+    OperationContext* const _opCtx;
+    const NamespaceString _backingNss;
+    const boost::intrusive_ptr<ExpressionContext> _expCtx;
+    const StringMap<std::string>& _accumulators;
+    std::vector<BSONObj> _results;
+};
+
+/**
+ * Recomputes the whole view, writing only the results which changed.
+ */
+void doFullRefresh(OperationContext* opCtx,
+                   const ViewDefinition& view,
+                   const NamespaceString& backingNss,
+                   const boost::intrusive_ptr<ExpressionContext>& expCtx) {
+    const StringMap<std::string> noAccumulators;
+    ResultWriter writer(opCtx, backingNss, expCtx, noAccumulators);
+    auto seenIds = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+    runAggregation(
+        opCtx, view.viewOn(), view.pipeline(), view.defaultCollator(), [&](const BSONObj& result) {
+            writer.add(storedIdFor(result, &seenIds), result);
+        });
+    writer.flush();
+
+    // Remove the results which the pipeline no longer produces. Only the refresher writes to the
+    // backing collection, so they are still there once the scan has released its lock.
+    std::vector<BSONObj> removedIds;
+    {
+        AutoGetCollection autoColl(opCtx, backingNss, MODE_IS);
+        Collection* backingColl = autoColl.getCollection();
+        uassert(ErrorCodes::NamespaceNotFound,
+                str::stream() << "backing collection " << backingNss.ns()
+                              << " was dropped during the refresh",
+                backingColl);
+        auto exec = InternalPlanner::collectionScan(
+            opCtx, backingNss.ns(), backingColl, PlanExecutor::YIELD_AUTO);
+        BSONObj doc;
+        PlanExecutor::ExecState state;
+        while (PlanExecutor::ADVANCED == (state = exec->getNext(&doc, nullptr))) {
+            BSONObj id = doc["_id"].wrap();
+            if (!seenIds.count(id)) {
+                removedIds.push_back(std::move(id));
+            }
+        }
+        if (state == PlanExecutor::FAILURE || state == PlanExecutor::DEAD) {
+            uassertStatusOK(WorkingSetCommon::getMemberObjectStatus(doc));
+        }
+    }
+
+    for (size_t start = 0; start < removedIds.size(); start += kWriteBatchSize) {
+        const size_t end = std::min(removedIds.size(), start + kWriteBatchSize);
+        writeToBackingCollection(opCtx, backingNss, [&](Collection* backingColl) {
+            for (size_t i = start; i < end; ++i) {
+                writeConflictRetry(opCtx, "materializedViewRefresh", backingNss.ns(), [&] {
+                    const RecordId rid = Helpers::findById(opCtx, backingColl, removedIds[i]);
+                    if (rid.isNull()) {
+                        return;
+                    }
+                    WriteUnitOfWork wuow(opCtx);
+                    backingColl->deleteDocument(opCtx, kUninitializedStmtId, rid, nullptr);
+                    wuow.commit();
+                });
+            }
+        });
+    }
+}
+
+/**
+ * Runs the view's pipeline over the inserted documents only, and folds the results into the
+ * backing collection. Returns false, having possibly applied some of the results, if a result
+ * can't be told apart from those already stored. The view must then be refreshed in full.
+ */
+bool doIncrementalRefresh(OperationContext* opCtx,
+                          const ViewDefinition& view,
+                          const NamespaceString& backingNss,
+                          const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                          const StringMap<std::string>& accumulators,
+                          const std::vector<BSONObj>& insertedIds) {
+    // The results of a $group are merged with the stored result of the same group. Without a
+    // $group, each result must keep the _id of the inserted document it came from, since any
+    // other _id might be that of a stored result from a different document.
+    const bool endsWithGroup = !view.pipeline().empty() &&
+        StringData(view.pipeline().back().firstElementFieldName()) == "$group"_sd;
+
+    for (size_t start = 0; start < insertedIds.size(); start += kIncrementalRefreshBatchSize) {
+        const size_t end = std::min(insertedIds.size(), start + kIncrementalRefreshBatchSize);
+        auto batchIds = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+        BSONArrayBuilder idsBuilder;
+        for (size_t i = start; i < end; ++i) {
+            batchIds.insert(insertedIds[i]);
+            idsBuilder.append(insertedIds[i]["_id"]);
+        }
+
+        std::vector<BSONObj> pipeline{
+            BSON("$match" << BSON("_id" << BSON("$in" << idsBuilder.arr())))};
+        pipeline.insert(pipeline.end(), view.pipeline().begin(), view.pipeline().end());
+
+        ResultWriter writer(opCtx, backingNss, expCtx, accumulators);
+        auto seenIds = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+        bool idsUsable = true;
+        runAggregation(
+            opCtx, view.viewOn(), pipeline, view.defaultCollator(), [&](const BSONObj& result) {
+                const BSONElement idElem = result["_id"];
+                idsUsable = idsUsable && !idElem.eoo() && seenIds.insert(idElem.wrap()).second &&
+                    (endsWithGroup || batchIds.count(idElem.wrap()));
+                if (idsUsable) {
+                    writer.add(idElem.wrap(), result);
+                }
+            });
+        writer.flush();
+        if (!idsUsable) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Creates the backing collection of 'viewNss' if it does not exist yet. Returns false if it
+ * cannot be created on this node.
+ */
+bool ensureBackingCollection(OperationContext* opCtx, const NamespaceString& backingNss) {
+    {
+        AutoGetCollection autoColl(opCtx, backingNss, MODE_IS);
+        if (autoColl.getCollection()) {
+            return true;
+        }
+    }
+
+    return writeConflictRetry(opCtx, "createMaterializedView", backingNss.ns(), [&] {
+        AutoGetDb autoDb(opCtx, backingNss.db(), MODE_X);
+        Database* db = autoDb.getDb();
+        if (!db ||
+            !repl::getGlobalReplicationCoordinator()->canAcceptWritesFor(opCtx, backingNss)) {
+            return false;
+        }
+        if (db->getCollection(opCtx, backingNss)) {
+            return true;
+        }
+
+        WriteUnitOfWork wuow(opCtx);
+        invariant(db->createCollection(opCtx, backingNss.ns()));
+        wuow.commit();
+        return true;
+    });
+}
+
+void refreshView(OperationContext* opCtx, const NamespaceString& viewNss) {
+    auto registry = MaterializedViewRegistry::get(opCtx);
+    if (!registry->needsRefresh(viewNss)) {
+        return;
+    }
+
+    const auto backingNss = MaterializedViewRegistry::backingNamespace(viewNss);
+    if (!ensureBackingCollection(opCtx, backingNss)) {
+        return;
+    }
+
+    std::shared_ptr<ViewDefinition> view;
+    {
+        AutoGetDb autoDb(opCtx, viewNss.db(), MODE_IS);
+        if (!autoDb.getDb()) {
+            return;
+        }
+        view = autoDb.getDb()->getViewCatalog()->lookup(opCtx, viewNss.ns());
+    }
+    if (!view || !view->isMaterialized()) {
+        return;
+    }
+
+    // The _ids of inserted documents are matched exactly, which a non-simple collation would not
+    // do.
+    StringMap<std::string> accumulators;
+    const bool incrementalPossible =
+        !view->defaultCollator() && canRefreshIncrementally(view->pipeline(), &accumulators);
+
+    // A view which was refreshed in full recently is left alone until it may be again, so that
+    // the changes to its source are coalesced into one full refresh.
+    const bool fullRefreshAllowed = registry->mayRefreshInFull(
+        viewNss, Milliseconds(materializedViewMinFullRefreshIntervalMillis.load()));
+    if (!incrementalPossible && !fullRefreshAllowed) {
+        return;
+    }
+
+    // Writes to the source collection are only held off while the pending changes are taken. The
+    // ones which commit during the refresh are recorded for the next one.
+    MaterializedViewRegistry::PendingChanges changes;
+    {
+        Lock::DBLock dbLock(opCtx, viewNss.db(), MODE_IS);
+        if (!repl::getGlobalReplicationCoordinator()->canAcceptWritesFor(opCtx, backingNss)) {
+            return;
+        }
+        Lock::CollectionLock sourceLock(opCtx->lockState(), view->viewOn().ns(), MODE_S);
+        changes = registry->takePendingChanges(viewNss, fullRefreshAllowed);
+    }
+    if (!changes.needsFullRefresh && changes.insertedIds.empty()) {
+        return;
+    }
+
+    // No lock is held from here on. The backing collection is only locked while each batch of
+    // results is written, so reads of the view may see a refresh partially applied.
+    bool fullRefresh = changes.needsFullRefresh || !incrementalPossible;
+    boost::intrusive_ptr<ExpressionContext> expCtx(
+        new ExpressionContext(opCtx, view->defaultCollator()));
+    Timer timer;
+    try {
+        if (!fullRefresh &&
+            !doIncrementalRefresh(
+                opCtx, *view, backingNss, expCtx, accumulators, changes.insertedIds)) {
+            if (!fullRefreshAllowed) {
+                registry->onRefreshFailed(viewNss);
+                return;
+            }
+            fullRefresh = true;
+        }
+        if (fullRefresh) {
+            doFullRefresh(opCtx, *view, backingNss, expCtx);
+        }
+    } catch (const DBException&) {
+        registry->onRefreshFailed(viewNss);
+        throw;
+    }
+
+    LOG(1) << "refreshed materialized view " << viewNss << (fullRefresh ? " in full" : "")
+           << " in " << timer.millis() << "ms";
+    registry->onRefreshed(viewNss, changes, fullRefresh, Milliseconds(timer.millis()));
+}
+
+class MaterializedViewRefresher : public BackgroundJob {
+public:
+    std::string name() const override {
+        return "MaterializedViewRefresher";
+    }
+
+    void run() override {
+        Client::initThread(name().c_str());
+        AuthorizationSession::get(cc())->grantInternalAuthorization();
+
+        while (!globalInShutdownDeprecated()) {
+            {
+                MONGO_IDLE_THREAD_BLOCK;
+                sleepmillis(materializedViewRefreshIntervalMillis.load());
+            }
+
+            if (!materializedViewRefresherEnabled.load() || lockedForWriting()) {
+                continue;
+            }
+
+            const ServiceContext::UniqueOperationContext opCtx = cc().makeOperationContext();
+            doPass(opCtx.get());
+        }
+    }
+
+private:
+    void doPass(OperationContext* opCtx) {
+        // If part of replSet but not in a readable state (e.g. during initial sync), skip.
+        if (repl::getGlobalReplicationCoordinator()->getReplicationMode() ==
+                repl::ReplicationCoordinator::modeReplSet &&
+            !repl::getGlobalReplicationCoordinator()->getMemberState().readable())
+            return;
+
+        std::vector<std::string> dbNames;
+        opCtx->getServiceContext()->getGlobalStorageEngine()->listDatabases(&dbNames);
+
+        std::vector<std::pair<NamespaceString, NamespaceString>> views;
+        for (auto&& dbName : dbNames) {
+            try {
+                AutoGetDb autoDb(opCtx, dbName, MODE_IS);
+                if (!autoDb.getDb()) {
+                    continue;
+                }
+                autoDb.getDb()->getViewCatalog()->iterate(opCtx, [&](const ViewDefinition& view) {
+                    if (view.isMaterialized()) {
+                        views.emplace_back(view.name(), view.viewOn());
+                    }
+                });
+            } catch (const DBException& ex) {
+                LOG(1) << "could not list the views of database " << dbName << ": "
+                       << redact(ex.toStatus());
+            }
+        }
+
+        auto registry = MaterializedViewRegistry::get(opCtx);
+        registry->setViews(views);
+        for (auto&& viewNss : registry->getViews()) {
+            try {
+                refreshView(opCtx, viewNss);
+            } catch (const DBException& ex) {
+                warning() << "failed to refresh materialized view " << viewNss << ": "
+                          << redact(ex.toStatus());
+            }
+        }
+    }
+};
+
+}  // namespace
+
+void startMaterializedViewRefresher() {
+    // The refresher is never stopped, so it can be leaked.
+    (new MaterializedViewRefresher())->go();
+}
+
+}  // namespace mongo
@@ -0,0 +1,411 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/views/materialized_view_registry.h"
+
+#include <algorithm>
+#include <functional>
+#include <set>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/repl/oplog.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage/recovery_unit.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+namespace {
+const auto getMaterializedViewRegistry =
+    ServiceContext::declareDecoration<MaterializedViewRegistry>();
+
+// Beyond this many inserts awaiting a refresh, a view is recomputed in full instead.
+MONGO_EXPORT_SERVER_PARAMETER(materializedViewMaxPendingInserts, int, 10000);
+}  // namespace
+
+const StringData MaterializedViewRegistry::kBackingCollectionPrefix = "system.materialized."_sd;
+const StringData MaterializedViewRegistry::kResultField = "r"_sd;
+
+// static
+MaterializedViewRegistry* MaterializedViewRegistry::get(ServiceContext* service) {
+    return &getMaterializedViewRegistry(service);
+}
+
+// static
+MaterializedViewRegistry* MaterializedViewRegistry::get(OperationContext* opCtx) {
+    return get(opCtx->getServiceContext());
+}
+
+// static
+NamespaceString MaterializedViewRegistry::backingNamespace(const NamespaceString& viewNss) {
+    return NamespaceString(viewNss.db(),
+                           str::stream() << kBackingCollectionPrefix << viewNss.coll());
+}
+
+// static
+StatusWith<std::vector<BSONObj>> MaterializedViewRegistry::backingCollectionPipeline(
+    const std::vector<BSONObj>& pipeline) {
+    // The sort which determines the order of the pipeline's results, if any.
+    BSONObj orderingSort;
+    for (auto&& stage : pipeline) {
+        const StringData stageName = stage.firstElementFieldName();
+        if (stageName == "$sort"_sd) {
+            for (auto&& key : stage.firstElement().Obj()) {
+                if (key.type() == Object) {
+                    return {ErrorCodes::OptionNotSupportedOnView,
+                            "A materialized view cannot sort by metadata"};
+                }
+            }
+            orderingSort = stage;
+        } else if (stageName == "$sortByCount"_sd) {
+            orderingSort = BSON("$sort" << BSON("count" << -1));
+        } else if (stageName == "$bucket"_sd || stageName == "$bucketAuto"_sd) {
+            orderingSort = BSON("$sort" << BSON("_id" << 1));
+        } else if (stageName == "$group"_sd || stageName == "$count"_sd ||
+                   stageName == "$sample"_sd) {
+            // These stages do not return their results in any particular order.
+            orderingSort = BSONObj();
+        } else if (stageName == "$geoNear"_sd) {
+            return {ErrorCodes::OptionNotSupportedOnView,
+                    "A materialized view cannot keep the order of a $geoNear"};
+        } else if (!orderingSort.isEmpty() && stageName != "$match"_sd &&
+                   stageName != "$limit"_sd && stageName != "$skip"_sd) {
+            return {ErrorCodes::OptionNotSupportedOnView,
+                    str::stream() << "A materialized view cannot keep the order of a sort "
+                                     "followed by "
+                                  << stageName};
+        }
+    }
+
+    std::vector<BSONObj> stages{
+        BSON("$replaceRoot" << BSON("newRoot" << ("$" + kResultField.toString())))};
+    if (!orderingSort.isEmpty()) {
+        stages.push_back(orderingSort.getOwned());
+    }
+    return stages;
+}
+
+void MaterializedViewRegistry::setViews(
+    const std::vector<std::pair<NamespaceString, NamespaceString>>& views) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    const auto now = Date_t::now();
+
+    std::set<std::string> current;
+    for (auto&& viewAndSource : views) {
+        const auto& viewNss = viewAndSource.first;
+        const auto& sourceNss = viewAndSource.second;
+        current.insert(viewNss.ns());
+
+        auto it = _entries.find(viewNss.ns());
+        if (it == _entries.end()) {
+            Entry entry;
+            entry.sourceNss = sourceNss;
+            _noteChange(&entry, now);
+            _entries.emplace(viewNss.ns(), std::move(entry));
+        } else if (it->second.sourceNss != sourceNss) {
+            it->second.sourceNss = sourceNss;
+            it->second.populated = false;
+            it->second.needsFullRefresh = true;
+            it->second.insertedIds.clear();
+            _noteChange(&it->second, now);
+        }
+    }
+
+    for (auto it = _entries.begin(); it != _entries.end();) {
+        if (current.count(it->first)) {
+            ++it;
+        } else {
+            it = _entries.erase(it);
+        }
+    }
+
+    _viewsBySource.clear();
+    uint64_t sourceFilter = 0;
+    for (auto&& entry : _entries) {
+        _viewsBySource[entry.second.sourceNss.ns()].push_back(entry.first);
+        sourceFilter |= _sourceFilterBit(entry.second.sourceNss);
+    }
+    _sourceFilter.store(sourceFilter);
+    _numViews.store(_entries.size());
+}
+
+std::vector<NamespaceString> MaterializedViewRegistry::getViews() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    std::vector<NamespaceString> views;
+    for (auto&& entry : _entries) {
+        views.emplace_back(entry.first);
+    }
+    return views;
+}
+
+bool MaterializedViewRegistry::needsRefresh(const NamespaceString& viewNss) const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    auto it = _entries.find(viewNss.ns());
+    return it != _entries.end() &&
+        (it->second.needsFullRefresh || !it->second.populated || !it->second.insertedIds.empty());
+}
+
+bool MaterializedViewRegistry::mayRefreshInFull(const NamespaceString& viewNss,
+                                                Milliseconds minInterval) const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    auto it = _entries.find(viewNss.ns());
+    if (it == _entries.end() || !it->second.populated) {
+        return true;
+    }
+
+    const auto& entry = it->second;
+    return Date_t::now() - entry.lastFullRefresh >=
+        std::max(minInterval, entry.lastFullRefreshDuration);
+}
+
+MaterializedViewRegistry::PendingChanges MaterializedViewRegistry::takePendingChanges(
+    const NamespaceString& viewNss, bool fullRefreshAllowed) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    PendingChanges changes;
+    auto it = _entries.find(viewNss.ns());
+    if (it == _entries.end()) {
+        return changes;
+    }
+
+    auto& entry = it->second;
+    changes.needsFullRefresh = entry.needsFullRefresh || !entry.populated;
+    if (changes.needsFullRefresh && !fullRefreshAllowed) {
+        return PendingChanges();
+    }
+    changes.insertedIds.swap(entry.insertedIds);
+    changes.changeSeq = entry.changeSeq;
+    entry.needsFullRefresh = false;
+    entry.oldestRefreshingChange = entry.oldestPendingChange;
+    entry.oldestPendingChange = Date_t();
+    return changes;
+}
+
+void MaterializedViewRegistry::onRefreshed(const NamespaceString& viewNss,
+                                           const PendingChanges& changes,
+                                           bool fullRefresh,
+                                           Milliseconds duration) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    auto it = _entries.find(viewNss.ns());
+    if (it == _entries.end()) {
+        return;
+    }
+
+    auto& entry = it->second;
+    if (fullRefresh) {
+        entry.populated = true;
+        ++entry.numFullRefreshes;
+        entry.lastFullRefresh = Date_t::now();
+        entry.lastFullRefreshDuration = duration;
+        if (entry.changeSeq != changes.changeSeq) {
+            entry.needsFullRefresh = true;
+            entry.insertedIds.clear();
+        }
+    } else {
+        ++entry.numIncrementalRefreshes;
+    }
+    entry.oldestRefreshingChange = Date_t();
+    entry.lastRefresh = Date_t::now();
+    entry.lastRefreshDuration = duration;
+}
+
+void MaterializedViewRegistry::onRefreshFailed(const NamespaceString& viewNss) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    auto it = _entries.find(viewNss.ns());
+    if (it == _entries.end()) {
+        return;
+    }
+
+    // The backing collection may have been partially updated, so only a full refresh can bring it
+    // back in line with the source collection.
+    auto& entry = it->second;
+    entry.needsFullRefresh = true;
+    entry.insertedIds.clear();
+    if (entry.oldestRefreshingChange != Date_t()) {
+        if (entry.oldestPendingChange == Date_t() ||
+            entry.oldestRefreshingChange < entry.oldestPendingChange) {
+            entry.oldestPendingChange = entry.oldestRefreshingChange;
+        }
+        entry.oldestRefreshingChange = Date_t();
+    }
+}
+
+bool MaterializedViewRegistry::isPopulated(const NamespaceString& viewNss) const {
+    if (_numViews.load() == 0) {
+        return false;
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    auto it = _entries.find(viewNss.ns());
+    return it != _entries.end() && it->second.populated;
+}
+
+void MaterializedViewRegistry::appendStats(const NamespaceString& viewNss,
+                                           BSONObjBuilder* builder) const {
+    builder->append("backingCollection", backingNamespace(viewNss).coll());
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    auto it = _entries.find(viewNss.ns());
+    if (it == _entries.end()) {
+        // The refresher has not yet come across this view.
+        builder->append("populated", false);
+        builder->append("stale", true);
+        return;
+    }
+
+    const auto& entry = it->second;
+    Date_t oldestChange = entry.oldestPendingChange;
+    if (entry.oldestRefreshingChange != Date_t() &&
+        (oldestChange == Date_t() || entry.oldestRefreshingChange < oldestChange)) {
+        oldestChange = entry.oldestRefreshingChange;
+    }
+
+    builder->append("populated", entry.populated);
+    builder->append("stale", !entry.populated || oldestChange != Date_t());
+    if (entry.lastRefresh != Date_t()) {
+        builder->append("lastRefresh", entry.lastRefresh);
+        builder->append("lastRefreshDurationMillis",
+                        durationCount<Milliseconds>(entry.lastRefreshDuration));
+    }
+    builder->append("refreshLagMillis",
+                    oldestChange == Date_t()
+                        ? 0LL
+                        : durationCount<Milliseconds>(Date_t::now() - oldestChange));
+    builder->append("pendingInserts", static_cast<long long>(entry.insertedIds.size()));
+    builder->append("fullRefreshes", entry.numFullRefreshes);
+    builder->append("incrementalRefreshes", entry.numIncrementalRefreshes);
+}
+
+void MaterializedViewRegistry::onInserts(OperationContext* opCtx,
+                                         const NamespaceString& nss,
+                                         std::vector<InsertStatement>::const_iterator begin,
+                                         std::vector<InsertStatement>::const_iterator end) {
+    const std::vector<std::string> views = _getViewsOnSource(nss);
+    if (views.empty()) {
+        return;
+    }
+
+    std::vector<BSONObj> ids;
+    bool missingId = false;
+    for (auto it = begin; it != end; ++it) {
+        BSONElement idElem = it->doc["_id"];
+        if (idElem.eoo()) {
+            missingId = true;
+            break;
+        }
+        ids.push_back(idElem.wrap());
+    }
+
+    opCtx->recoveryUnit()->onCommit([ this, views, ids = std::move(ids), missingId ]() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        const auto now = Date_t::now();
+        const size_t maxPendingInserts = materializedViewMaxPendingInserts.load();
+        for (auto&& view : views) {
+            auto it = _entries.find(view);
+            if (it == _entries.end()) {
+                continue;
+            }
+
+            auto& entry = it->second;
+            _noteChange(&entry, now);
+            if (entry.needsFullRefresh) {
+                continue;
+            }
+            if (missingId || entry.insertedIds.size() + ids.size() > maxPendingInserts) {
+                entry.needsFullRefresh = true;
+                entry.insertedIds.clear();
+                continue;
+            }
+            entry.insertedIds.insert(entry.insertedIds.end(), ids.begin(), ids.end());
+        }
+    });
+}
+
+void MaterializedViewRegistry::onWrite(OperationContext* opCtx, const NamespaceString& nss) {
+    const std::vector<std::string> views = _getViewsOnSource(nss);
+    if (views.empty()) {
+        return;
+    }
+
+    opCtx->recoveryUnit()->onCommit([this, views]() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        const auto now = Date_t::now();
+        for (auto&& view : views) {
+            auto it = _entries.find(view);
+            if (it != _entries.end()) {
+                _noteChange(&it->second, now);
+                it->second.needsFullRefresh = true;
+                it->second.insertedIds.clear();
+            }
+        }
+    });
+}
+
+void MaterializedViewRegistry::invalidate(OperationContext* opCtx,
+                                          const NamespaceString& viewNss) {
+    opCtx->recoveryUnit()->onCommit([this, viewNss]() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        auto it = _entries.find(viewNss.ns());
+        if (it != _entries.end()) {
+            _noteChange(&it->second, Date_t::now());
+            it->second.populated = false;
+            it->second.needsFullRefresh = true;
+            it->second.insertedIds.clear();
+        }
+    });
+}
+
+std::vector<std::string> MaterializedViewRegistry::_getViewsOnSource(
+    const NamespaceString& sourceNss) const {
+    if (!(_sourceFilter.load() & _sourceFilterBit(sourceNss))) {
+        return {};
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    auto it = _viewsBySource.find(sourceNss.ns());
+    return it == _viewsBySource.end() ? std::vector<std::string>() : it->second;
+}
+
+// static
+uint64_t MaterializedViewRegistry::_sourceFilterBit(const NamespaceString& sourceNss) {
+    return uint64_t(1) << (std::hash<std::string>()(sourceNss.ns()) % 64);
+}
+
+// static
+void MaterializedViewRegistry::_noteChange(Entry* entry, Date_t now) {
+    ++entry->changeSeq;
+    if (entry->oldestPendingChange == Date_t()) {
+        entry->oldestPendingChange = now;
+    }
+}
+
+}  // namespace mongo
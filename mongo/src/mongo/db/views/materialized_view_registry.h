@@ -0,0 +1,222 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status_with.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+struct InsertStatement;
+class OperationContext;
+class ServiceContext;
+
+/**
+ * Tracks the materialized views known to this node, decorating the ServiceContext.
+ *
+ * The result of a materialized view's pipeline is stored in a backing collection,
+ * <db>.system.materialized.<view>, which the materialized view refresher brings up to date in the
+ * background. The registry records, as they commit, the writes to the collection each view is
+ * defined on: inserts are remembered by _id so that they can be folded into the backing collection
+ * incrementally, while any other change requires the pipeline to be recomputed in full. Reads are
+ * served from the backing collection once it has been populated by a full refresh, and expand the
+ * view as usual before that.
+ *
+ * Each result is stored as {_id: <id>, r: <result>}. The results of a pipeline need not have an
+ * _id, nor a unique one, so the refresher picks the _id of each document in the backing collection.
+ *
+ * The set of views is maintained by the refresher, which scans the view catalogs on every pass.
+ */
+class MaterializedViewRegistry {
+    MONGO_DISALLOW_COPYING(MaterializedViewRegistry);
+
+public:
+    static const StringData kBackingCollectionPrefix;
+
+    // The field of a backing collection document which holds one result of the view's pipeline.
+    static const StringData kResultField;
+
+    /**
+     * The changes to a view's source collection which have not yet been applied to its backing
+     * collection.
+     */
+    struct PendingChanges {
+        bool needsFullRefresh = false;
+        // The _ids of the inserted documents, each as a {_id: <value>} document.
+        std::vector<BSONObj> insertedIds;
+        // The sequence number of the last change among these, for onRefreshed().
+        long long changeSeq = 0;
+    };
+
+    MaterializedViewRegistry() = default;
+
+    static MaterializedViewRegistry* get(ServiceContext* service);
+    static MaterializedViewRegistry* get(OperationContext* opCtx);
+
+    static NamespaceString backingNamespace(const NamespaceString& viewNss);
+
+    /**
+     * Returns the stages which turn the documents of a backing collection back into the results of
+     * a view defined by 'pipeline', in the order in which the pipeline returns them. Fails with
+     * OptionNotSupportedOnView if that order cannot be restored from the results alone, in which
+     * case the view cannot be materialized.
+     */
+    static StatusWith<std::vector<BSONObj>> backingCollectionPipeline(
+        const std::vector<BSONObj>& pipeline);
+
+    /**
+     * Replaces the set of tracked views by 'views', a list of (view, source collection) pairs.
+     * Views which are new, or whose source collection changed, start out unpopulated.
+     */
+    void setViews(const std::vector<std::pair<NamespaceString, NamespaceString>>& views);
+
+    std::vector<NamespaceString> getViews() const;
+
+    /**
+     * Returns true if the backing collection of 'viewNss' is missing changes to its source.
+     */
+    bool needsRefresh(const NamespaceString& viewNss) const;
+
+    /**
+     * Returns true if 'viewNss' may be refreshed in full now: it has not been populated yet, or
+     * the last full refresh ended at least 'minInterval' ago, and at least as long ago as it took.
+     */
+    bool mayRefreshInFull(const NamespaceString& viewNss, Milliseconds minInterval) const;
+
+    /**
+     * Returns the changes to apply to the backing collection of 'viewNss' and forgets them. The
+     * caller must hold a lock which keeps writes to the source collection from committing while
+     * it takes them, so that each committed write is either among them or recorded afterwards.
+     * The lock need not be held while the changes are applied.
+     *
+     * If 'fullRefreshAllowed' is false and the changes require a full refresh, none are taken, so
+     * that they accumulate until one is allowed.
+     */
+    PendingChanges takePendingChanges(const NamespaceString& viewNss,
+                                      bool fullRefreshAllowed = true);
+
+    /**
+     * Called once the changes returned by takePendingChanges() have been applied. A full refresh
+     * may or may not have seen the writes which committed while it ran, so if there were any, the
+     * next refresh is a full one as well.
+     */
+    void onRefreshed(const NamespaceString& viewNss,
+                     const PendingChanges& changes,
+                     bool fullRefresh,
+                     Milliseconds duration);
+    void onRefreshFailed(const NamespaceString& viewNss);
+
+    /**
+     * Returns true if reads of 'viewNss' can be served from its backing collection.
+     */
+    bool isPopulated(const NamespaceString& viewNss) const;
+
+    /**
+     * Appends the refresh state of 'viewNss' for collStats, including how far behind its source
+     * collection the backing collection is.
+     */
+    void appendStats(const NamespaceString& viewNss, BSONObjBuilder* builder) const;
+
+    /**
+     * Called by the OpObserver for writes to any collection. The changes are recorded when the
+     * current WriteUnitOfWork commits.
+     */
+    void onInserts(OperationContext* opCtx,
+                   const NamespaceString& nss,
+                   std::vector<InsertStatement>::const_iterator begin,
+                   std::vector<InsertStatement>::const_iterator end);
+    void onWrite(OperationContext* opCtx, const NamespaceString& nss);
+
+    /**
+     * Called when the definition of 'viewNss' changes. Reads expand the view until the next full
+     * refresh.
+     */
+    void invalidate(OperationContext* opCtx, const NamespaceString& viewNss);
+
+private:
+    struct Entry {
+        NamespaceString sourceNss;
+        bool populated = false;
+        bool needsFullRefresh = true;
+        std::vector<BSONObj> insertedIds;
+
+        // The time of the oldest change not yet applied, and of the oldest change being applied
+        // by the refresh in progress, if any.
+        Date_t oldestPendingChange;
+        Date_t oldestRefreshingChange;
+
+        // Incremented by every change to the source collection or to the view.
+        long long changeSeq = 0;
+
+        Date_t lastRefresh;
+        Milliseconds lastRefreshDuration{0};
+        Date_t lastFullRefresh;
+        Milliseconds lastFullRefreshDuration{0};
+        long long numFullRefreshes = 0;
+        long long numIncrementalRefreshes = 0;
+    };
+
+    /**
+     * Returns the views on 'sourceNss'. Only takes '_mutex' if '_sourceFilter' says there may be
+     * any.
+     */
+    std::vector<std::string> _getViewsOnSource(const NamespaceString& sourceNss) const;
+
+    static uint64_t _sourceFilterBit(const NamespaceString& sourceNss);
+
+    static void _noteChange(Entry* entry, Date_t now);
+
+    mutable stdx::mutex _mutex;
+    std::map<std::string, Entry> _entries;
+
+    // The views on each source collection, keyed by the namespace of the source collection.
+    std::map<std::string, std::vector<std::string>> _viewsBySource;
+
+    // How many views are tracked. Reads check this instead of taking '_mutex'.
+    AtomicInt64 _numViews;
+
+    // The union of _sourceFilterBit() of every source collection. Writes to a collection whose bit
+    // is not set skip '_mutex' entirely. A view added concurrently with a write may miss it, which
+    // is harmless since new views start with a full refresh.
+    AtomicUInt64 _sourceFilter;
+};
+
+}  // namespace mongo
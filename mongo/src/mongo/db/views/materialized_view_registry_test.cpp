@@ -0,0 +1,271 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <vector>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/bson/json.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/query_test_service_context.h"
+#include "mongo/db/repl/oplog.h"
+#include "mongo/db/views/materialized_view_registry.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+const NamespaceString viewNss("db.view");
+const NamespaceString sourceNss("db.coll");
+
+class MaterializedViewRegistryTest : public unittest::Test {
+protected:
+    void setUp() override {
+        registry()->setViews({{viewNss, sourceNss}});
+    }
+
+    MaterializedViewRegistry* registry() {
+        return MaterializedViewRegistry::get(_serviceContext.getServiceContext());
+    }
+
+    void insert(const NamespaceString& nss, std::vector<BSONObj> docs, bool commit = true) {
+        std::vector<InsertStatement> inserts;
+        for (auto&& doc : docs) {
+            inserts.emplace_back(doc);
+        }
+        WriteUnitOfWork wuow(opCtx.get());
+        registry()->onInserts(opCtx.get(), nss, inserts.cbegin(), inserts.cend());
+        if (commit) {
+            wuow.commit();
+        }
+    }
+
+    void refreshInFull(const NamespaceString& nss) {
+        auto changes = registry()->takePendingChanges(nss);
+        registry()->onRefreshed(nss, changes, true, Milliseconds(5));
+    }
+
+    BSONObj stats() {
+        BSONObjBuilder builder;
+        registry()->appendStats(viewNss, &builder);
+        return builder.obj();
+    }
+
+private:
+    QueryTestServiceContext _serviceContext;
+
+protected:
+    ServiceContext::UniqueOperationContext opCtx = _serviceContext.makeOperationContext();
+};
+
+TEST_F(MaterializedViewRegistryTest, NewViewNeedsFullRefreshBeforeItIsPopulated) {
+    ASSERT_EQ(MaterializedViewRegistry::backingNamespace(viewNss).ns(),
+              "db.system.materialized.view");
+    ASSERT_FALSE(registry()->isPopulated(viewNss));
+    ASSERT_TRUE(stats()["stale"].trueValue());
+
+    auto changes = registry()->takePendingChanges(viewNss);
+    ASSERT_TRUE(changes.needsFullRefresh);
+    registry()->onRefreshed(viewNss, changes, true, Milliseconds(5));
+
+    ASSERT_TRUE(registry()->isPopulated(viewNss));
+    ASSERT_FALSE(registry()->needsRefresh(viewNss));
+    ASSERT_FALSE(stats()["stale"].trueValue());
+    ASSERT_EQ(stats()["fullRefreshes"].numberLong(), 1);
+}
+
+TEST_F(MaterializedViewRegistryTest, RecordsCommittedInsertsIntoTheSourceCollection) {
+    refreshInFull(viewNss);
+
+    insert(sourceNss, {BSON("_id" << 1), BSON("_id" << 2)});
+    insert(sourceNss, {BSON("_id" << 3)}, false);
+    insert(NamespaceString("db.other"), {BSON("_id" << 4)});
+
+    ASSERT_TRUE(stats()["stale"].trueValue());
+    ASSERT_EQ(stats()["pendingInserts"].numberLong(), 2);
+
+    auto changes = registry()->takePendingChanges(viewNss);
+    ASSERT_FALSE(changes.needsFullRefresh);
+    ASSERT_EQ(changes.insertedIds.size(), 2U);
+    ASSERT_BSONOBJ_EQ(changes.insertedIds[0], BSON("_id" << 1));
+    ASSERT_BSONOBJ_EQ(changes.insertedIds[1], BSON("_id" << 2));
+
+    // The view stays stale, and keeps being served from its backing collection, until the
+    // refresh completes.
+    ASSERT_TRUE(stats()["stale"].trueValue());
+    ASSERT_TRUE(registry()->isPopulated(viewNss));
+    registry()->onRefreshed(viewNss, changes, false, Milliseconds(1));
+    ASSERT_FALSE(stats()["stale"].trueValue());
+    ASSERT_EQ(stats()["incrementalRefreshes"].numberLong(), 1);
+}
+
+TEST_F(MaterializedViewRegistryTest, OtherWritesAndFailedRefreshesRequireFullRefresh) {
+    refreshInFull(viewNss);
+
+    {
+        WriteUnitOfWork wuow(opCtx.get());
+        registry()->onWrite(opCtx.get(), sourceNss);
+        wuow.commit();
+    }
+    auto changes = registry()->takePendingChanges(viewNss);
+    ASSERT_TRUE(changes.needsFullRefresh);
+    registry()->onRefreshed(viewNss, changes, true, Milliseconds(5));
+
+    insert(sourceNss, {BSON("_id" << 1)});
+    ASSERT_FALSE(registry()->takePendingChanges(viewNss).needsFullRefresh);
+    registry()->onRefreshFailed(viewNss);
+    ASSERT_TRUE(stats()["stale"].trueValue());
+    ASSERT_TRUE(registry()->takePendingChanges(viewNss).needsFullRefresh);
+}
+
+TEST_F(MaterializedViewRegistryTest, WritesDuringFullRefreshRequireAnotherFullRefresh) {
+    auto changes = registry()->takePendingChanges(viewNss);
+    ASSERT_TRUE(changes.needsFullRefresh);
+
+    // The full refresh may or may not see this insert, so it can't be folded in afterwards.
+    insert(sourceNss, {BSON("_id" << 1)});
+    registry()->onRefreshed(viewNss, changes, true, Milliseconds(5));
+    ASSERT_TRUE(registry()->isPopulated(viewNss));
+    ASSERT_TRUE(registry()->needsRefresh(viewNss));
+    changes = registry()->takePendingChanges(viewNss);
+    ASSERT_TRUE(changes.needsFullRefresh);
+    registry()->onRefreshed(viewNss, changes, true, Milliseconds(5));
+    ASSERT_FALSE(registry()->needsRefresh(viewNss));
+
+    // An incremental refresh only looks up the inserts it took, so later ones stay pending.
+    insert(sourceNss, {BSON("_id" << 2)});
+    changes = registry()->takePendingChanges(viewNss);
+    ASSERT_FALSE(changes.needsFullRefresh);
+    insert(sourceNss, {BSON("_id" << 3)});
+    registry()->onRefreshed(viewNss, changes, false, Milliseconds(1));
+    changes = registry()->takePendingChanges(viewNss);
+    ASSERT_FALSE(changes.needsFullRefresh);
+    ASSERT_EQ(changes.insertedIds.size(), 1U);
+    ASSERT_BSONOBJ_EQ(changes.insertedIds[0], BSON("_id" << 3));
+}
+
+TEST_F(MaterializedViewRegistryTest, FullRefreshesAreSpacedOut) {
+    ASSERT_TRUE(registry()->mayRefreshInFull(viewNss, Hours(1)));
+    refreshInFull(viewNss);
+    ASSERT_FALSE(registry()->mayRefreshInFull(viewNss, Hours(1)));
+    ASSERT_TRUE(registry()->mayRefreshInFull(viewNss, Milliseconds(0)));
+
+    // Changes requiring a full refresh are left to accumulate until one is allowed.
+    insert(sourceNss, {BSON("_id" << 1)});
+    {
+        WriteUnitOfWork wuow(opCtx.get());
+        registry()->onWrite(opCtx.get(), sourceNss);
+        wuow.commit();
+    }
+    auto changes = registry()->takePendingChanges(viewNss, false);
+    ASSERT_FALSE(changes.needsFullRefresh);
+    ASSERT_TRUE(changes.insertedIds.empty());
+    ASSERT_TRUE(registry()->needsRefresh(viewNss));
+    ASSERT_TRUE(stats()["stale"].trueValue());
+
+    changes = registry()->takePendingChanges(viewNss, true);
+    ASSERT_TRUE(changes.needsFullRefresh);
+    registry()->onRefreshed(viewNss, changes, true, Milliseconds(5));
+    ASSERT_FALSE(registry()->needsRefresh(viewNss));
+
+    // Inserts which can be folded in incrementally are taken regardless.
+    insert(sourceNss, {BSON("_id" << 2)});
+    changes = registry()->takePendingChanges(viewNss, false);
+    ASSERT_FALSE(changes.needsFullRefresh);
+    ASSERT_EQ(changes.insertedIds.size(), 1U);
+}
+
+TEST_F(MaterializedViewRegistryTest, TracksViewsBySourceCollection) {
+    const NamespaceString otherViewNss("db.otherView");
+    const NamespaceString otherSourceNss("db.otherColl");
+    registry()->setViews({{viewNss, sourceNss}, {otherViewNss, otherSourceNss}});
+    refreshInFull(viewNss);
+    refreshInFull(otherViewNss);
+
+    insert(otherSourceNss, {BSON("_id" << 1)});
+    ASSERT_FALSE(registry()->needsRefresh(viewNss));
+    ASSERT_TRUE(registry()->needsRefresh(otherViewNss));
+
+    // Moving a view to another source collection stops tracking writes to the old one.
+    registry()->setViews({{viewNss, sourceNss}, {otherViewNss, sourceNss}});
+    refreshInFull(otherViewNss);
+    insert(otherSourceNss, {BSON("_id" << 2)});
+    ASSERT_FALSE(registry()->needsRefresh(otherViewNss));
+    insert(sourceNss, {BSON("_id" << 3)});
+    ASSERT_TRUE(registry()->needsRefresh(viewNss));
+    ASSERT_TRUE(registry()->needsRefresh(otherViewNss));
+}
+
+TEST_F(MaterializedViewRegistryTest, DroppedViewIsForgotten) {
+    refreshInFull(viewNss);
+    registry()->setViews({});
+
+    ASSERT_FALSE(registry()->isPopulated(viewNss));
+    ASSERT_TRUE(registry()->getViews().empty());
+}
+
+TEST(MaterializedViewBackingPipelineTest, UnwrapsResultsOfAnUnorderedPipeline) {
+    auto stages = unittest::assertGet(MaterializedViewRegistry::backingCollectionPipeline(
+        {fromjson("{$sort: {a: 1}}"), fromjson("{$group: {_id: '$a', n: {$sum: 1}}}")}));
+    ASSERT_EQ(stages.size(), 1U);
+    ASSERT_BSONOBJ_EQ(stages[0], fromjson("{$replaceRoot: {newRoot: '$r'}}"));
+}
+
+TEST(MaterializedViewBackingPipelineTest, RestoresTheOrderOfATrailingSort) {
+    auto stages = unittest::assertGet(MaterializedViewRegistry::backingCollectionPipeline(
+        {fromjson("{$project: {_id: 0, a: 1}}"),
+         fromjson("{$sort: {a: -1}}"),
+         fromjson("{$limit: 10}")}));
+    ASSERT_EQ(stages.size(), 2U);
+    ASSERT_BSONOBJ_EQ(stages[0], fromjson("{$replaceRoot: {newRoot: '$r'}}"));
+    ASSERT_BSONOBJ_EQ(stages[1], fromjson("{$sort: {a: -1}}"));
+
+    stages = unittest::assertGet(MaterializedViewRegistry::backingCollectionPipeline(
+        {fromjson("{$sortByCount: '$a'}")}));
+    ASSERT_EQ(stages.size(), 2U);
+    ASSERT_BSONOBJ_EQ(stages[1], fromjson("{$sort: {count: -1}}"));
+}
+
+TEST(MaterializedViewBackingPipelineTest, RejectsOrdersWhichCannotBeRestored) {
+    ASSERT_EQ(MaterializedViewRegistry::backingCollectionPipeline(
+                  {fromjson("{$sort: {a: 1}}"), fromjson("{$project: {a: 0}}")})
+                  .getStatus(),
+              ErrorCodes::OptionNotSupportedOnView);
+    ASSERT_EQ(MaterializedViewRegistry::backingCollectionPipeline(
+                  {fromjson("{$match: {$text: {$search: 'x'}}}"),
+                   fromjson("{$sort: {score: {$meta: 'textScore'}}}")})
+                  .getStatus(),
+              ErrorCodes::OptionNotSupportedOnView);
+}
+
+}  // namespace
+}  // namespace mongo
@@ -51,7 +51,8 @@ public:
                    StringData viewName,
                    StringData viewOnName,
                    const BSONObj& pipeline,
-                   std::unique_ptr<CollatorInterface> collation);
+                   std::unique_ptr<CollatorInterface> collation,
+                   bool materialized = false);
 
     /**
      * Copying a view 'other' clones its collator and does a simple copy of all other fields.
@@ -89,6 +90,14 @@ public:
         return _collator.get();
     }
 
+    /**
+     * Returns true if the result of this view's pipeline is stored in a backing collection, which
+     * is kept up to date by the MaterializedViewRegistry, rather than recomputed on every read.
+     */
+    bool isMaterialized() const {
+        return _materialized;
+    }
+
     void setViewOn(const NamespaceString& viewOnNss);
 
     /**
@@ -101,5 +110,6 @@ private:
     NamespaceString _viewOnNss;
     std::unique_ptr<CollatorInterface> _collator;
     std::vector<BSONObj> _pipeline;
+    bool _materialized;
 };
 }  // namespace mongo
@@ -52,6 +52,7 @@
 #include "mongo/db/query/collation/collator_factory_interface.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/recovery_unit.h"
+#include "mongo/db/views/materialized_view_registry.h"
 #include "mongo/db/views/resolved_view.h"
 #include "mongo/db/views/view.h"
 #include "mongo/db/views/view_graph.h"
@@ -163,11 +164,13 @@ Status ViewCatalog::_reloadIfNeeded_inlock(OperationContext* opCtx) {
             }
         }
 
+        const bool materialized = view["materialized"].trueValue();
         _viewMap[viewName.ns()] = std::make_shared<ViewDefinition>(viewName.db(),
                                                                    viewName.coll(),
                                                                    view["viewOn"].str(),
                                                                    pipeline,
-                                                                   std::move(collator.getValue()));
+                                                                   std::move(collator.getValue()),
+                                                                   materialized);
         return Status::OK();
     });
     _valid.store(status.isOK());
@@ -192,7 +195,8 @@ Status ViewCatalog::_createOrUpdateView_inlock(OperationContext* opCtx,
                                                const NamespaceString& viewName,
                                                const NamespaceString& viewOn,
                                                const BSONArray& pipeline,
-                                               std::unique_ptr<CollatorInterface> collator) {
+                                               std::unique_ptr<CollatorInterface> collator,
+                                               bool materialized) {
     _requireValidCatalog_inlock(opCtx);
 
     // Build the BSON definition for this view to be saved in the durable view catalog. If the
@@ -204,10 +208,36 @@ Status ViewCatalog::_createOrUpdateView_inlock(OperationContext* opCtx,
     if (collator) {
         viewDefBuilder.append("collation", collator->getSpec().toBSON());
     }
+    if (materialized) {
+        viewDefBuilder.append("materialized", true);
+    }
 
     BSONObj ownedPipeline = pipeline.getOwned();
-    auto view = std::make_shared<ViewDefinition>(
-        viewName.db(), viewName.coll(), viewOn.coll(), ownedPipeline, std::move(collator));
+    auto view = std::make_shared<ViewDefinition>(viewName.db(),
+                                                 viewName.coll(),
+                                                 viewOn.coll(),
+                                                 ownedPipeline,
+                                                 std::move(collator),
+                                                 materialized);
+
+    if (materialized) {
+        // The refresher tracks changes to the source collection only, so the result must not
+        // depend on anything else.
+        if (_lookup_inlock(opCtx, viewOn.ns())) {
+            return {ErrorCodes::OptionNotSupportedOnView,
+                    "A materialized view must be defined on a collection"};
+        }
+        AggregationRequest request(viewOn, view->pipeline());
+        if (!LiteParsedPipeline(request).getInvolvedNamespaces().empty()) {
+            return {ErrorCodes::OptionNotSupportedOnView,
+                    "The pipeline of a materialized view cannot read from other collections"};
+        }
+        auto backingPipeline =
+            MaterializedViewRegistry::backingCollectionPipeline(view->pipeline());
+        if (!backingPipeline.isOK()) {
+            return backingPipeline.getStatus();
+        }
+    }
 
     // Check that the resulting dependency graph is acyclic and within the maximum depth.
     Status graphStatus = _upsertIntoGraph(opCtx, *(view.get()));
@@ -349,7 +379,8 @@ Status ViewCatalog::createView(OperationContext* opCtx,
                                const NamespaceString& viewName,
                                const NamespaceString& viewOn,
                                const BSONArray& pipeline,
-                               const BSONObj& collation) {
+                               const BSONObj& collation,
+                               bool materialized) {
     stdx::lock_guard<stdx::mutex> lk(_mutex);
 
     if (viewName.db() != viewOn.db())
@@ -373,7 +404,7 @@ Status ViewCatalog::createView(OperationContext* opCtx,
         return collator.getStatus();
 
     return _createOrUpdateView_inlock(
-        opCtx, viewName, viewOn, pipeline, std::move(collator.getValue()));
+        opCtx, viewName, viewOn, pipeline, std::move(collator.getValue()), materialized);
 }
 
 Status ViewCatalog::modifyView(OperationContext* opCtx,
@@ -400,12 +431,18 @@ Status ViewCatalog::modifyView(OperationContext* opCtx,
         this->_viewMap[viewName.ns()] = std::make_shared<ViewDefinition>(savedDefinition);
     });
 
+    if (savedDefinition.isMaterialized()) {
+        // The backing collection holds the result of the old definition.
+        MaterializedViewRegistry::get(opCtx)->invalidate(opCtx, viewName);
+    }
+
     return _createOrUpdateView_inlock(
         opCtx,
         viewName,
         viewOn,
         pipeline,
-        CollatorInterface::cloneCollator(savedDefinition.defaultCollator()));
+        CollatorInterface::cloneCollator(savedDefinition.defaultCollator()),
+        savedDefinition.isMaterialized());
 }
 
 Status ViewCatalog::dropView(OperationContext* opCtx, const NamespaceString& viewName) {
@@ -488,10 +525,28 @@ StatusWith<ResolvedView> ViewCatalog::resolveView(OperationContext* opCtx,
                 {*resolvedNss, std::move(resolvedPipeline), std::move(collation)});
         }
 
-        resolvedNss = &(view->viewOn());
         collation = view->defaultCollator() ? view->defaultCollator()->getSpec().toBSON()
                                             : CollationSpec::kSimpleSpec;
 
+        if (view->isMaterialized() &&
+            MaterializedViewRegistry::get(opCtx)->isPopulated(view->name())) {
+            // The backing collection already holds the result of this view's pipeline, wrapped
+            // in documents which these stages unwrap and put back in order.
+            auto backingPipeline =
+                MaterializedViewRegistry::backingCollectionPipeline(view->pipeline());
+            if (backingPipeline.isOK()) {
+                resolvedPipeline.insert(resolvedPipeline.begin(),
+                                        backingPipeline.getValue().begin(),
+                                        backingPipeline.getValue().end());
+                return StatusWith<ResolvedView>(
+                    {MaterializedViewRegistry::backingNamespace(view->name()),
+                     std::move(resolvedPipeline),
+                     std::move(collation)});
+            }
+        }
+
+        resolvedNss = &(view->viewOn());
+
         // Prepend the underlying view's pipeline to the current working pipeline.
         const std::vector<BSONObj>& toPrepend = view->pipeline();
         resolvedPipeline.insert(resolvedPipeline.begin(), toPrepend.begin(), toPrepend.end());
@@ -46,6 +46,7 @@
 #include "mongo/db/server_options.h"
 #include "mongo/db/service_context_noop.h"
 #include "mongo/db/views/durable_view_catalog.h"
+#include "mongo/db/views/materialized_view_registry.h"
 #include "mongo/db/views/view.h"
 #include "mongo/db/views/view_catalog.h"
 #include "mongo/db/views/view_graph.h"
@@ -606,6 +607,92 @@ TEST_F(ViewCatalogFixture, ResolveViewCorrectPipeline) {
     }
 }
 
+TEST_F(ViewCatalogFixture, CannotCreateMaterializedViewOnView) {
+    const NamespaceString view1("db.view1");
+    const NamespaceString view2("db.view2");
+    const NamespaceString viewOn("db.coll");
+
+    ASSERT_OK(viewCatalog.createView(opCtx.get(), view1, viewOn, emptyPipeline, emptyCollation));
+    ASSERT_EQ(
+        viewCatalog.createView(opCtx.get(), view2, view1, emptyPipeline, emptyCollation, true),
+        ErrorCodes::OptionNotSupportedOnView);
+}
+
+TEST_F(ViewCatalogFixture, CannotCreateMaterializedViewReadingOtherCollections) {
+    const NamespaceString viewName("db.view");
+    const NamespaceString viewOn("db.coll");
+    auto pipeline = BSON_ARRAY(BSON("$lookup" << BSON("from"
+                                                      << "other"
+                                                      << "localField"
+                                                      << "a"
+                                                      << "foreignField"
+                                                      << "b"
+                                                      << "as"
+                                                      << "c")));
+
+    ASSERT_EQ(viewCatalog.createView(opCtx.get(), viewName, viewOn, pipeline, emptyCollation, true),
+              ErrorCodes::OptionNotSupportedOnView);
+}
+
+TEST_F(ViewCatalogFixture, CannotCreateMaterializedViewWhoseOrderCannotBeRestored) {
+    const NamespaceString viewName("db.view");
+    const NamespaceString viewOn("db.coll");
+    auto pipeline =
+        BSON_ARRAY(BSON("$sort" << BSON("a" << 1)) << BSON("$project" << BSON("a" << 0)));
+
+    ASSERT_EQ(viewCatalog.createView(opCtx.get(), viewName, viewOn, pipeline, emptyCollation, true),
+              ErrorCodes::OptionNotSupportedOnView);
+}
+
+TEST_F(ViewCatalogFixture, ResolveMaterializedViewToBackingCollectionOncePopulated) {
+    const NamespaceString materializedView("db.materialized");
+    const NamespaceString viewOnMaterialized("db.view");
+    const NamespaceString viewOn("db.coll");
+    const auto groupStage = BSON("$group" << BSON("_id"
+                                                  << "$a"
+                                                  << "n"
+                                                  << BSON("$sum" << 1)));
+    const auto matchStage = BSON("$match" << BSON("n" << BSON("$gt" << 1)));
+
+    ASSERT_OK(viewCatalog.createView(
+        opCtx.get(), materializedView, viewOn, BSON_ARRAY(groupStage), emptyCollation, true));
+    ASSERT_OK(viewCatalog.createView(opCtx.get(),
+                                     viewOnMaterialized,
+                                     materializedView,
+                                     BSON_ARRAY(matchStage),
+                                     emptyCollation));
+    ASSERT_TRUE(viewCatalog.lookup(opCtx.get(), materializedView.ns())->isMaterialized());
+
+    // Until its backing collection is populated, the view is expanded as usual.
+    auto resolvedView = viewCatalog.resolveView(opCtx.get(), viewOnMaterialized);
+    ASSERT_OK(resolvedView.getStatus());
+    ASSERT_EQ(resolvedView.getValue().getNamespace(), viewOn);
+    ASSERT_EQ(resolvedView.getValue().getPipeline().size(), 2U);
+
+    auto registry = MaterializedViewRegistry::get(getServiceContext());
+    registry->setViews({{materializedView, viewOn}});
+    auto changes = registry->takePendingChanges(materializedView);
+    registry->onRefreshed(materializedView, changes, true, Milliseconds(1));
+
+    resolvedView = viewCatalog.resolveView(opCtx.get(), viewOnMaterialized);
+    ASSERT_OK(resolvedView.getStatus());
+    ASSERT_EQ(resolvedView.getValue().getNamespace(),
+              MaterializedViewRegistry::backingNamespace(materializedView));
+    ASSERT_EQ(resolvedView.getValue().getPipeline().size(), 2U);
+    ASSERT_BSONOBJ_EQ(resolvedView.getValue().getPipeline()[0],
+                      BSON("$replaceRoot" << BSON("newRoot"
+                                                  << "$r")));
+    ASSERT_BSONOBJ_EQ(resolvedView.getValue().getPipeline()[1], matchStage);
+
+    // Changing the definition of the view invalidates its backing collection.
+    {
+        WriteUnitOfWork wuow(opCtx.get());
+        ASSERT_OK(viewCatalog.modifyView(opCtx.get(), materializedView, viewOn, emptyPipeline));
+        wuow.commit();
+    }
+    ASSERT_FALSE(registry->isPopulated(materializedView));
+}
+
 TEST_F(ViewCatalogFixture, ResolveViewCorrectlyExtractsDefaultCollation) {
     const NamespaceString view1("db.view1");
     const NamespaceString view2("db.view2");
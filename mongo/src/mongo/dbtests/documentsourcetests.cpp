@@ -38,6 +38,7 @@
 #include "mongo/db/exec/multi_plan.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/pipeline/dependencies.h"
+#include "mongo/db/pipeline/document_batch.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_cursor.h"
 #include "mongo/db/pipeline/document_value_test_util.h"
@@ -185,6 +186,40 @@ TEST_F(DocumentSourceCursorTest, IterateDispose) {
     ASSERT(source()->getNext().isEOF());
 }
 
+/** Iterate a DocumentSourceCursor in batches, interleaved with single results. */
+TEST_F(DocumentSourceCursorTest, IterateBatches) {
+    for (int i = 1; i <= 5; ++i) {
+        client.insert(nss.ns(), BSON("a" << i));
+    }
+    createSource();
+
+    auto next = source()->getNext();
+    ASSERT(next.isAdvanced());
+    ASSERT_VALUE_EQ(Value(1), next.getDocument().getField("a"));
+
+    // Each batch is filled to capacity while the executor has results left.
+    DocumentBatch batch(2);
+    source()->getNextBatch(&batch);
+    ASSERT(batch.getStatus() == DocumentBatch::ReturnStatus::kAdvanced);
+    ASSERT_EQ(batch.size(), 2U);
+    ASSERT_VALUE_EQ(Value(2), batch[0].getField("a"));
+    ASSERT_VALUE_EQ(Value(3), batch[1].getField("a"));
+
+    // A full batch does not look ahead for the end of the results.
+    source()->getNextBatch(&batch);
+    ASSERT(batch.getStatus() == DocumentBatch::ReturnStatus::kAdvanced);
+    ASSERT_EQ(batch.size(), 2U);
+    ASSERT_VALUE_EQ(Value(4), batch[0].getField("a"));
+    ASSERT_VALUE_EQ(Value(5), batch[1].getField("a"));
+
+    source()->getNextBatch(&batch);
+    ASSERT(batch.isEOF());
+    ASSERT(batch.empty());
+    ASSERT(source()->getNext().isEOF());
+    // Exhausting the source releases the read lock.
+    ASSERT(!opCtx()->lockState()->isReadLocked());
+}
+
 /** Set a value or await an expected value. */
 class PendingValue {
 public:
@@ -41,6 +41,7 @@
 #include "mongo/db/client.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
+#include "mongo/db/exec/and_bitmap.h"
 #include "mongo/db/exec/and_hash.h"
 #include "mongo/db/exec/and_sorted.h"
 #include "mongo/db/exec/fetch.h"
@@ -1448,6 +1449,293 @@ public:
 };
 
 
+//
+// Bitmap AND tests
+//
+
+// An AND with two children whose output is not in RecordId order.
+class QueryStageAndBitmapTwoLeaf : public QueryStageAndBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = ctx.getCollection();
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+
+        for (int i = 0; i < 50; ++i) {
+            insert(BSON("foo" << i << "bar" << i));
+        }
+
+        addIndex(BSON("foo" << 1));
+        addIndex(BSON("bar" << 1));
+
+        WorkingSet ws;
+        auto ab = make_unique<AndBitmapStage>(&_opCtx, &ws, coll);
+
+        // Foo <= 20
+        IndexScanParams params;
+        params.descriptor = getIndex(BSON("foo" << 1), coll);
+        params.bounds.isSimpleRange = true;
+        params.bounds.startKey = BSON("" << 20);
+        params.bounds.endKey = BSONObj();
+        params.bounds.boundInclusion = BoundInclusion::kIncludeBothStartAndEndKeys;
+        params.direction = -1;
+        ab->addChild(new IndexScan(&_opCtx, params, &ws, NULL));
+
+        // Bar >= 10
+        params.descriptor = getIndex(BSON("bar" << 1), coll);
+        params.bounds.startKey = BSON("" << 10);
+        params.bounds.endKey = BSONObj();
+        params.bounds.boundInclusion = BoundInclusion::kIncludeBothStartAndEndKeys;
+        params.direction = 1;
+        ab->addChild(new IndexScan(&_opCtx, params, &ws, NULL));
+
+        // foo == bar, and foo<=20, bar>=10, so our values are 10 through 20. They come out in
+        // increasing RecordId order and carry no index keys.
+        int count = 0;
+        RecordId last;
+        while (!ab->isEOF()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState status = ab->work(&id);
+            if (PlanStage::ADVANCED != status) {
+                continue;
+            }
+            ++count;
+            WorkingSetMember* member = ws.get(id);
+            ASSERT_EQUALS(WorkingSetMember::RID_AND_IDX, member->getState());
+            ASSERT_TRUE(member->keyData.empty());
+            ASSERT_LESS_THAN(last, member->recordId);
+            last = member->recordId;
+
+            BSONObj obj = coll->docFor(&_opCtx, member->recordId).value();
+            ASSERT_LESS_THAN_OR_EQUALS(obj["foo"].numberInt(), 20);
+            ASSERT_GREATER_THAN_OR_EQUALS(obj["bar"].numberInt(), 10);
+        }
+        ASSERT_EQUALS(11, count);
+
+        const AndBitmapStats* stats = static_cast<const AndBitmapStats*>(ab->getSpecificStats());
+        ASSERT_EQUALS(2U, stats->bitmapAfterChild.size());
+        ASSERT_EQUALS(21U, stats->bitmapAfterChild[0]);
+        ASSERT_EQUALS(11U, stats->bitmapAfterChild[1]);
+    }
+};
+
+// An AND where the last child has nothing; the intersection is empty.
+class QueryStageAndBitmapWithNothing : public QueryStageAndBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = ctx.getCollection();
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+
+        for (int i = 0; i < 50; ++i) {
+            insert(BSON("foo" << i << "bar" << 20));
+        }
+
+        addIndex(BSON("foo" << 1));
+        addIndex(BSON("bar" << 1));
+
+        WorkingSet ws;
+        auto ab = make_unique<AndBitmapStage>(&_opCtx, &ws, coll);
+
+        // Foo <= 20
+        IndexScanParams params;
+        params.descriptor = getIndex(BSON("foo" << 1), coll);
+        params.bounds.isSimpleRange = true;
+        params.bounds.startKey = BSON("" << 20);
+        params.bounds.endKey = BSONObj();
+        params.bounds.boundInclusion = BoundInclusion::kIncludeBothStartAndEndKeys;
+        params.direction = -1;
+        ab->addChild(new IndexScan(&_opCtx, params, &ws, NULL));
+
+        // Bar == 5.  Index scan should be eof.
+        params.descriptor = getIndex(BSON("bar" << 1), coll);
+        params.bounds.startKey = BSON("" << 5);
+        params.bounds.endKey = BSON("" << 5);
+        params.bounds.boundInclusion = BoundInclusion::kIncludeBothStartAndEndKeys;
+        params.direction = 1;
+        ab->addChild(new IndexScan(&_opCtx, params, &ws, NULL));
+
+        ASSERT_EQUALS(0, countResults(ab.get()));
+
+        // The WSMs of the first child are freed as they are read.
+        ASSERT_EQUALS(0U, ws.getFlagged().size());
+    }
+};
+
+/**
+ * Invalidate a RecordId held by a bitmap AND before the AND finishes evaluating.  The AND should
+ * flag the invalidated RecordId in the WorkingSet and not return it.
+ */
+class QueryStageAndBitmapInvalidation : public QueryStageAndBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = ctx.getCollection();
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+
+        for (int i = 0; i < 50; ++i) {
+            insert(BSON("foo" << i << "bar" << i));
+        }
+
+        addIndex(BSON("foo" << 1));
+        addIndex(BSON("bar" << 1));
+
+        WorkingSet ws;
+        auto ab = make_unique<AndBitmapStage>(&_opCtx, &ws, coll);
+
+        // Foo <= 20
+        IndexScanParams params;
+        params.descriptor = getIndex(BSON("foo" << 1), coll);
+        params.bounds.isSimpleRange = true;
+        params.bounds.startKey = BSON("" << 20);
+        params.bounds.endKey = BSONObj();
+        params.bounds.boundInclusion = BoundInclusion::kIncludeBothStartAndEndKeys;
+        params.direction = -1;
+        ab->addChild(new IndexScan(&_opCtx, params, &ws, NULL));
+
+        // Bar >= 10
+        params.descriptor = getIndex(BSON("bar" << 1), coll);
+        params.bounds.startKey = BSON("" << 10);
+        params.bounds.endKey = BSONObj();
+        params.bounds.boundInclusion = BoundInclusion::kIncludeBothStartAndEndKeys;
+        params.direction = 1;
+        ab->addChild(new IndexScan(&_opCtx, params, &ws, NULL));
+
+        // Read all of the first child (21 results and EOF) and some of the second.
+        for (int i = 0; i < 30; ++i) {
+            WorkingSetID out;
+            PlanStage::StageState status = ab->work(&out);
+            ASSERT_EQUALS(PlanStage::NEED_TIME, status);
+        }
+
+        ab->saveState();
+        set<RecordId> data;
+        getRecordIds(&data, coll);
+        for (set<RecordId>::const_iterator it = data.begin(); it != data.end(); ++it) {
+            if (coll->docFor(&_opCtx, *it).value()["foo"].numberInt() == 15) {
+                ab->invalidate(&_opCtx, *it, INVALIDATION_DELETION);
+                remove(coll->docFor(&_opCtx, *it).value());
+                break;
+            }
+        }
+        ab->restoreState();
+
+        // Expect to find foo==15 flagged for review, with its object fetched.
+        const unordered_set<WorkingSetID>& flagged = ws.getFlagged();
+        ASSERT_EQUALS(size_t(1), flagged.size());
+        WorkingSetMember* member = ws.get(*flagged.begin());
+        ASSERT_EQUALS(WorkingSetMember::OWNED_OBJ, member->getState());
+        BSONElement elt;
+        ASSERT_TRUE(member->getFieldDotted("foo", &elt));
+        ASSERT_EQUALS(15, elt.numberInt());
+
+        // Since foo == bar, we would have 11 results, but one was invalidated.
+        ASSERT_EQUALS(10, countResults(ab.get()));
+
+        const AndBitmapStats* stats = static_cast<const AndBitmapStats*>(ab->getSpecificStats());
+        ASSERT_EQUALS(1U, stats->flaggedInProgress);
+        ASSERT_EQUALS(0U, stats->flaggedButPassed);
+    }
+};
+
+// The bitmap AND fails once its bitmaps use more memory than allowed.
+class QueryStageAndBitmapExceedsMemLimit : public QueryStageAndBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = ctx.getCollection();
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+
+        // Enough documents for a memory check, which happens every 4096 RecordIds.
+        for (int i = 0; i < 5000; ++i) {
+            insert(BSON("foo" << i << "bar" << i));
+        }
+
+        addIndex(BSON("foo" << 1));
+        addIndex(BSON("bar" << 1));
+
+        WorkingSet ws;
+        auto ab = make_unique<AndBitmapStage>(&_opCtx, &ws, coll, 1024);
+
+        IndexScanParams params;
+        params.descriptor = getIndex(BSON("foo" << 1), coll);
+        params.bounds.isSimpleRange = true;
+        params.bounds.startKey = BSON("" << 0);
+        params.bounds.endKey = BSONObj();
+        params.bounds.boundInclusion = BoundInclusion::kIncludeBothStartAndEndKeys;
+        params.direction = 1;
+        ab->addChild(new IndexScan(&_opCtx, params, &ws, NULL));
+
+        params.descriptor = getIndex(BSON("bar" << 1), coll);
+        ab->addChild(new IndexScan(&_opCtx, params, &ws, NULL));
+
+        ASSERT_EQUALS(-1, countResults(ab.get()));
+        ASSERT_GREATER_THAN(ab->getMemUsage(), 1024U);
+    }
+};
+
+// A bitmap AND returns the largest possible RecordId last and then hits EOF.
+class QueryStageAndBitmapMaxRecordId : public QueryStageAndBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = ctx.getCollection();
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, ns());
+            wuow.commit();
+        }
+
+        WorkingSet ws;
+        auto ab = make_unique<AndBitmapStage>(&_opCtx, &ws, coll);
+        for (int i = 0; i < 2; ++i) {
+            auto childStage = make_unique<QueuedDataStage>(&_opCtx, &ws);
+            for (auto&& recordId : {RecordId(1), RecordId::max()}) {
+                WorkingSetID id = ws.allocate();
+                ws.get(id)->recordId = recordId;
+                ws.transitionToRecordIdAndIdx(id);
+                childStage->pushBack(id);
+            }
+            ab->addChild(childStage.release());
+        }
+
+        std::vector<RecordId> results;
+        while (!ab->isEOF()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            if (PlanStage::ADVANCED == ab->work(&id)) {
+                results.push_back(ws.get(id)->recordId);
+            }
+        }
+        ASSERT_EQUALS(2U, results.size());
+        ASSERT_EQUALS(RecordId(1), results[0]);
+        ASSERT_EQUALS(RecordId::max(), results[1]);
+
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        ASSERT_EQUALS(PlanStage::IS_EOF, ab->work(&id));
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("query_stage_and") {}
@@ -1472,6 +1760,11 @@ public:
         add<QueryStageAndSortedByLastChild>();
         add<QueryStageAndSortedFirstChildFetched>();
         add<QueryStageAndSortedSecondChildFetched>();
+        add<QueryStageAndBitmapTwoLeaf>();
+        add<QueryStageAndBitmapWithNothing>();
+        add<QueryStageAndBitmapInvalidation>();
+        add<QueryStageAndBitmapExceedsMemLimit>();
+        add<QueryStageAndBitmapMaxRecordId>();
     }
 };
 
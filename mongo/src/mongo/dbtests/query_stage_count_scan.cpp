@@ -641,6 +641,53 @@ public:
     }
 };
 
+//
+// Count over multi-interval bounds on a compound index, seeking over the keys between the
+// intervals.
+//
+class QueryStageCountScanMultiIntervalBounds : public CountBase {
+public:
+    void run() {
+        OldClientWriteContext ctx(&_opCtx, ns());
+
+        for (int a = 0; a < 10; ++a) {
+            for (int b = 0; b < 10; ++b) {
+                insert(BSON("a" << a << "b" << b));
+            }
+        }
+        addIndex(BSON("a" << 1 << "b" << 1));
+
+        // {a: {$in: [2, 5]}, b: {$gte: 3, $lte: 6}}
+        CountScanParams params;
+        params.descriptor = getIndex(ctx.db(), BSON("a" << 1 << "b" << 1));
+        OrderedIntervalList oilA("a");
+        oilA.intervals.push_back(Interval(BSON("" << 2 << "" << 2), true, true));
+        oilA.intervals.push_back(Interval(BSON("" << 5 << "" << 5), true, true));
+        OrderedIntervalList oilB("b");
+        oilB.intervals.push_back(Interval(BSON("" << 3 << "" << 6), true, true));
+        params.bounds.fields.push_back(oilA);
+        params.bounds.fields.push_back(oilB);
+
+        WorkingSet ws;
+        CountScan count(&_opCtx, params, &ws);
+
+        int numCounted = runCount(&count);
+        ASSERT_EQUALS(8, numCounted);
+
+        // Each interval of 'a' is entered with a seek, and so is the next 'b' range after each
+        // key past the end of the current one, instead of scanning the keys in between.
+        const CountScanStats* stats =
+            static_cast<const CountScanStats*>(count.getSpecificStats());
+        ASSERT_GREATER_THAN(stats->seeks, 0U);
+        ASSERT_LESS_THAN(stats->keysExamined, 20U);
+
+        std::unique_ptr<PlanStageStats> planStats = count.getStats();
+        const CountScanStats* explained =
+            static_cast<const CountScanStats*>(planStats->specific.get());
+        ASSERT_BSONOBJ_EQ(params.bounds.toBSON(), explained->indexBounds);
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("query_stage_count_scan") {}
@@ -657,6 +704,7 @@ public:
         add<QueryStageCountScanInsertNewDocsDuringYield>();
         add<QueryStageCountScanBecomesMultiKeyDuringYield>();
         add<QueryStageCountScanUnusedKeys>();
+        add<QueryStageCountScanMultiIntervalBounds>();
     }
 };
 
@@ -37,6 +37,7 @@
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
+#include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/dbtests/dbtests.h"
 
 namespace QueryStageIxscan {
@@ -314,6 +315,148 @@ public:
     }
 };
 
+/**
+ * Skip scans over the compound index {a: 1, b: 1}, where 'a' has 50 distinct values and each of
+ * them is paired with every value of 'b' from 0 to 9.
+ */
+class IndexSkipScanTest : public IndexScanTest {
+public:
+    void setup() override {
+        IndexScanTest::setup();
+
+        {
+            WriteUnitOfWork wunit(&_opCtx);
+            ASSERT_OK(_coll->getIndexCatalog()->createIndexOnEmptyCollection(
+                &_opCtx,
+                BSON("ns" << ns() << "key" << keyPattern() << "name"
+                          << DBClientBase::genIndexName(keyPattern())
+                          << "v"
+                          << static_cast<int>(kIndexVersion))));
+            wunit.commit();
+        }
+
+        for (int i = 0; i < 500; ++i) {
+            insert(BSON("_id" << i << "a" << i % 50 << "b" << i / 50));
+        }
+    }
+
+    static BSONObj keyPattern() {
+        return BSON("a" << 1 << "b" << 1);
+    }
+
+    /**
+     * Returns a scan which is unbounded on 'a' and requires 'b' to lie in [bLow, bHigh].
+     */
+    IndexScan* createSkipScan(int bLow, int bHigh, int direction = 1) {
+        IndexCatalog* catalog = _coll->getIndexCatalog();
+        std::vector<IndexDescriptor*> indexes;
+        catalog->findIndexesByKeyPattern(&_opCtx, keyPattern(), false, &indexes);
+        ASSERT_EQ(indexes.size(), 1U);
+
+        IndexScanParams params;
+        params.descriptor = indexes[0];
+        params.direction = direction;
+        params.skipScan = true;
+
+        OrderedIntervalList aOil("a");
+        aOil.intervals.push_back(IndexBoundsBuilder::allValues());
+        params.bounds.fields.push_back(aOil);
+
+        OrderedIntervalList bOil("b");
+        bOil.intervals.push_back(Interval(BSON("" << bLow << "" << bHigh), true, true));
+        params.bounds.fields.push_back(bOil);
+
+        IndexBoundsBuilder::alignBounds(&params.bounds, keyPattern(), direction);
+
+        MatchExpression* filter = NULL;
+        return new IndexScan(&_opCtx, params, &_ws, filter);
+    }
+
+    /**
+     * Works 'ixscan' to EOF and returns the keys it produced.
+     */
+    std::vector<BSONObj> getAllKeys(IndexScan* ixscan) {
+        std::vector<BSONObj> keys;
+        WorkingSetID id;
+        PlanStage::StageState state;
+        while (PlanStage::IS_EOF != (state = ixscan->work(&id))) {
+            ASSERT_NE(PlanStage::DEAD, state);
+            ASSERT_NE(PlanStage::FAILURE, state);
+            if (PlanStage::ADVANCED == state) {
+                keys.push_back(_ws.get(id)->keyData[0].keyData.getOwned());
+            }
+        }
+        return keys;
+    }
+};
+
+class QueryStageIxscanSkipScan : public IndexSkipScanTest {
+public:
+    void run() {
+        setup();
+
+        std::unique_ptr<IndexScan> ixscan(createSkipScan(3, 4));
+        std::vector<BSONObj> keys = getAllKeys(ixscan.get());
+
+        ASSERT_EQ(keys.size(), 100U);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            const int a = static_cast<int>(i) / 2;
+            const int b = 3 + static_cast<int>(i) % 2;
+            ASSERT_BSONOBJ_EQ(keys[i], BSON("" << a << "" << b));
+        }
+
+        // Each value of 'a' costs a seek to its first matching key and a seek past its last one,
+        // instead of a pass over all ten of its keys.
+        const IndexScanStats* stats =
+            static_cast<const IndexScanStats*>(ixscan->getSpecificStats());
+        ASSERT_TRUE(stats->skipScan);
+        ASSERT_GREATER_THAN_OR_EQUALS(stats->seeks, 50U);
+        ASSERT_LESS_THAN(stats->keysExamined, 250U);
+    }
+};
+
+class QueryStageIxscanSkipScanReverse : public IndexSkipScanTest {
+public:
+    void run() {
+        setup();
+
+        std::unique_ptr<IndexScan> ixscan(createSkipScan(7, 7, -1 /* reverse scan */));
+        std::vector<BSONObj> keys = getAllKeys(ixscan.get());
+
+        ASSERT_EQ(keys.size(), 50U);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            ASSERT_BSONOBJ_EQ(keys[i], BSON("" << 49 - static_cast<int>(i) << "" << 7));
+        }
+
+        const IndexScanStats* stats =
+            static_cast<const IndexScanStats*>(ixscan->getSpecificStats());
+        ASSERT_LESS_THAN(stats->keysExamined, 200U);
+    }
+};
+
+// A value of the leading field inserted while the skip scan is saved is still visited.
+class QueryStageIxscanSkipScanInsertDuringSave : public IndexSkipScanTest {
+public:
+    void run() {
+        setup();
+
+        std::unique_ptr<IndexScan> ixscan(createSkipScan(3, 3));
+
+        WorkingSetMember* member = getNext(ixscan.get());
+        ASSERT_BSONOBJ_EQ(member->keyData[0].keyData, BSON("" << 0 << "" << 3));
+
+        ixscan->saveState();
+        insert(BSON("_id" << 500 << "a" << 100 << "b" << 3));
+        insert(BSON("_id" << 501 << "a" << 100 << "b" << 4));
+        ixscan->restoreState();
+
+        std::vector<BSONObj> keys = getAllKeys(ixscan.get());
+        ASSERT_EQ(keys.size(), 50U);
+        ASSERT_BSONOBJ_EQ(keys.front(), BSON("" << 1 << "" << 3));
+        ASSERT_BSONOBJ_EQ(keys.back(), BSON("" << 100 << "" << 3));
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("query_stage_ixscan") {}
@@ -324,6 +467,9 @@ public:
         add<QueryStageIxscanInsertDuringSaveExclusive>();
         add<QueryStageIxscanInsertDuringSaveExclusive2>();
         add<QueryStageIxscanInsertDuringSaveReverse>();
+        add<QueryStageIxscanSkipScan>();
+        add<QueryStageIxscanSkipScanReverse>();
+        add<QueryStageIxscanSkipScanInsertDuringSave>();
     }
 } QueryStageIxscanAll;
 
@@ -54,6 +54,7 @@
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/clock_source_mock.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -385,6 +386,55 @@ TEST_F(QueryStageMultiPlanTest, MPSExplainAllPlans) {
     }
 }
 
+// Test that successive halving stops working clearly losing plans during the trial period.
+TEST_F(QueryStageMultiPlanTest, MPSDiscardsLosingPlans) {
+    const int oldHalvingWorks = internalQueryPlanEvaluationHalvingWorks.load();
+    internalQueryPlanEvaluationHalvingWorks.store(16);
+    ON_BLOCK_EXIT([&] { internalQueryPlanEvaluationHalvingWorks.store(oldHalvingWorks); });
+
+    // Insert a document to create the collection.
+    insert(BSON("x" << 1));
+
+    const int nDocs = 500;
+
+    // The first plan always advances, the second plan advances half the time, and the third plan
+    // never advances.
+    auto ws = stdx::make_unique<WorkingSet>();
+    auto fastPlan = stdx::make_unique<QueuedDataStage>(_opCtx.get(), ws.get());
+    auto slowPlan = stdx::make_unique<QueuedDataStage>(_opCtx.get(), ws.get());
+    auto stuckPlan = stdx::make_unique<QueuedDataStage>(_opCtx.get(), ws.get());
+    for (int i = 0; i < nDocs; ++i) {
+        addMember(fastPlan.get(), ws.get(), BSON("x" << 1));
+        addMember(slowPlan.get(), ws.get(), BSON("x" << 1));
+        slowPlan->pushBack(PlanStage::NEED_TIME);
+        stuckPlan->pushBack(PlanStage::NEED_TIME);
+    }
+
+    AutoGetCollectionForReadCommand ctx(_opCtx.get(), nss);
+
+    auto qr = stdx::make_unique<QueryRequest>(nss);
+    qr->setFilter(BSON("x" << 1));
+    auto cq = uassertStatusOK(CanonicalQuery::canonicalize(opCtx(), std::move(qr)));
+    unique_ptr<MultiPlanStage> mps =
+        make_unique<MultiPlanStage>(_opCtx.get(), ctx.getCollection(), cq.get());
+    mps->addPlan(new QuerySolution(), fastPlan.release(), ws.get());
+    mps->addPlan(new QuerySolution(), slowPlan.release(), ws.get());
+    mps->addPlan(new QuerySolution(), stuckPlan.release(), ws.get());
+
+    PlanYieldPolicy yieldPolicy(PlanExecutor::NO_YIELD, _clock);
+    ASSERT_OK(mps->pickBestPlan(&yieldPolicy));
+    ASSERT_EQ(mps->bestPlanIdx(), 0);
+
+    // The stuck plan is cut after the first 16 rounds, the slow plan after 32.
+    auto stats = mps->getStats();
+    ASSERT_EQ(stats->children[2]->common.works, 16U);
+    ASSERT_EQ(stats->children[1]->common.works, 32U);
+
+    auto mpsStats = static_cast<const MultiPlanStats*>(mps->getSpecificStats());
+    ASSERT_EQ(mpsStats->numCandidates, 3U);
+    ASSERT_EQ(mpsStats->numDiscarded, 2U);
+}
+
 // Test that the plan summary only includes stats from the winning plan.
 //
 // This is a regression test for SERVER-20111.
@@ -41,6 +41,7 @@
 #include "mongo/db/operation_context.h"
 #include "mongo/db/pipeline/document_source_change_stream.h"
 #include "mongo/db/pipeline/document_source_out.h"
+#include "mongo/db/pipeline/document_source_sort.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/lite_parsed_pipeline.h"
 #include "mongo/db/pipeline/pipeline.h"
@@ -199,10 +200,39 @@ std::set<ShardId> getTargetedShards(OperationContext* opCtx,
     return {routingInfo.primaryId()};
 }
 
+/**
+ * Returns true if the merging half of a split pipeline will be executed on mongoS rather than on
+ * one of the shards.
+ */
+bool mergeRunsOnMongos(const Pipeline* pipelineForMerging) {
+    return pipelineForMerging->requiredToRunOnMongos() ||
+        (!internalQueryProhibitMergingOnMongoS.load() && pipelineForMerging->canRunOnMongos());
+}
+
+/**
+ * Returns the batch size to request in each shard's initial response to a split pipeline. Cursors
+ * are normally established without doing any work. However, if the shards' half of the pipeline
+ * ends in a $sort with an absorbed $limit, every shard must complete its top-k sort before it can
+ * return anything. When the results are merged on mongoS, the merger can consume the documents of
+ * the initial responses, so we ask for the top-k results straight away rather than waiting for a
+ * getMore round trip to every shard before the first result can be merged.
+ */
+long long getInitialBatchSizeForShards(const Pipeline* pipelineForTargetedShards,
+                                       const Pipeline* pipelineForMerging) {
+    const auto& shardSources = pipelineForTargetedShards->getSources();
+    if (!pipelineForMerging || shardSources.empty() || !mergeRunsOnMongos(pipelineForMerging)) {
+        return 0;
+    }
+
+    auto sortStage = dynamic_cast<DocumentSourceSort*>(shardSources.back().get());
+    return (sortStage && sortStage->getLimitSrc()) ? sortStage->getLimit() : 0;
+}
+
 BSONObj createCommandForTargetedShards(
     const AggregationRequest& request,
     const BSONObj originalCmdObj,
-    const std::unique_ptr<Pipeline, Pipeline::Deleter>& pipelineForTargetedShards) {
+    const std::unique_ptr<Pipeline, Pipeline::Deleter>& pipelineForTargetedShards,
+    const std::unique_ptr<Pipeline, Pipeline::Deleter>& pipelineForMerging) {
     // Create the command for the shards.
     MutableDocument targetedCmd(request.serializeToCommandObj());
     targetedCmd[AggregationRequest::kFromMongosName] = Value(true);
@@ -215,7 +245,8 @@ BSONObj createCommandForTargetedShards(
         if (pipelineForTargetedShards->isSplitForShards()) {
             targetedCmd[AggregationRequest::kNeedsMergeName] = Value(true);
             targetedCmd[AggregationRequest::kCursorName] =
-                Value(DOC(AggregationRequest::kBatchSizeName << 0));
+                Value(DOC(AggregationRequest::kBatchSizeName << getInitialBatchSizeForShards(
+                              pipelineForTargetedShards.get(), pipelineForMerging.get())));
         }
     }
 
@@ -426,7 +457,8 @@ StatusWith<DispatchShardPipelineResults> dispatchShardPipeline(
 
         // Generate the command object for the targeted shards.
         targetedCommand =
-            createCommandForTargetedShards(aggRequest, originalCmdObj, pipelineForTargetedShards);
+            createCommandForTargetedShards(
+                aggRequest, originalCmdObj, pipelineForTargetedShards, pipelineForMerging);
 
         // Refresh the shard registry if we're targeting all shards.  We need the shard registry
         // to be at least as current as the logical time used when creating the command for
@@ -804,8 +836,7 @@ Status ClusterAggregate::runAggregate(OperationContext* opCtx,
 
     // First, check whether we can merge on the mongoS. If the merge pipeline MUST run on mongoS,
     // then ignore the internalQueryProhibitMergingOnMongoS parameter.
-    if (mergingPipeline->requiredToRunOnMongos() ||
-        (!internalQueryProhibitMergingOnMongoS.load() && mergingPipeline->canRunOnMongos())) {
+    if (mergeRunsOnMongos(mergingPipeline.get())) {
         // Register the new mongoS cursor, and retrieve the initial batch of results.
         auto cursorResponse =
             establishMergingMongosCursor(opCtx,
@@ -901,7 +932,7 @@ Status ClusterAggregate::aggPassthrough(OperationContext* opCtx,
     // Format the command for the shard. This adds the 'fromMongos' field, wraps the command as an
     // explain if necessary, and rewrites the result into a format safe to forward to shards.
     cmdObj = Command::filterCommandRequestForPassthrough(
-        createCommandForTargetedShards(aggRequest, cmdObj, nullptr));
+        createCommandForTargetedShards(aggRequest, cmdObj, nullptr, nullptr));
 
     auto cmdResponse = uassertStatusOK(shard->runCommandWithFixedRetryAttempts(
         opCtx,
@@ -32,7 +32,9 @@
 
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/query/collation/collation_spec.h"
+#include "mongo/db/query/killcursors_request.h"
 #include "mongo/db/repl/read_concern_args.h"
+#include "mongo/executor/remote_command_request.h"
 #include "mongo/executor/task_executor_pool.h"
 #include "mongo/s/catalog_cache.h"
 #include "mongo/s/commands/cluster_commands_helpers.h"
@@ -147,6 +149,13 @@ public:
         MONGO_UNREACHABLE;
     }
 
+    std::unique_ptr<BulkLoader> createCollectionForBulkLoading(
+        const NamespaceString& ns,
+        const BSONObj& collectionOptions,
+        std::vector<BSONObj> indexSpecs) final {
+        MONGO_UNREACHABLE;
+    }
+
     StatusWith<std::unique_ptr<Pipeline, Pipeline::Deleter>> makePipeline(
         const std::vector<BSONObj>& rawPipeline,
         const boost::intrusive_ptr<ExpressionContext>& expCtx,
@@ -268,6 +277,118 @@ public:
         return (!batch.empty() ? Document(batch.front()) : boost::optional<Document>{});
     }
 
+    std::vector<Document> lookupDocuments(const NamespaceString& nss,
+                                          UUID collectionUUID,
+                                          const std::vector<Document>& documentKeys,
+                                          boost::optional<BSONObj> readConcern,
+                                          bool* complete) final {
+        auto foreignExpCtx = _expCtx->copyWith(nss, collectionUUID);
+        auto taskExecutor = Grid::get(_expCtx->opCtx)->getExecutorPool()->getArbitraryExecutor();
+        *complete = true;
+
+        // Create the parts of the find command which are common to the requests sent to each
+        // shard.
+        BSONObjBuilder cmdBuilder;
+        bool findCmdIsByUuid(foreignExpCtx->uuid);
+        if (findCmdIsByUuid) {
+            foreignExpCtx->uuid->appendToBuilder(&cmdBuilder, "find");
+        } else {
+            cmdBuilder.append("find", nss.coll());
+        }
+        cmdBuilder.append("comment", _expCtx->comment);
+        if (readConcern) {
+            cmdBuilder.append(repl::ReadConcernArgs::kReadConcernFieldName, *readConcern);
+        }
+
+        auto swShardResults =
+            makeStatusWith<std::vector<ClusterClientCursorParams::RemoteCursor>>();
+        auto findCmd = cmdBuilder.obj();
+        size_t numAttempts = 0;
+        do {
+            // Verify that the collection exists, with the correct UUID.
+            auto catalogCache = Grid::get(_expCtx->opCtx)->catalogCache();
+            auto swRoutingInfo = getCollectionRoutingInfo(foreignExpCtx);
+            if (swRoutingInfo == ErrorCodes::NamespaceNotFound) {
+                return {};
+            }
+            auto routingInfo = uassertStatusOK(std::move(swRoutingInfo));
+            if (findCmdIsByUuid && routingInfo.cm()) {
+                // See lookupSingleDocument() for why it is safe to find by namespace here.
+                findCmd = findCmd.addField(BSON("find" << nss.coll()).firstElement());
+                findCmdIsByUuid = false;
+            }
+
+            // Group the document keys by the shard which owns them.
+            std::map<ShardId, std::pair<ChunkVersion, std::vector<Document>>> keysByShard;
+            for (auto&& documentKey : documentKeys) {
+                auto shardInfo = getSingleTargetedShardForQuery(
+                    _expCtx->opCtx, routingInfo, documentKey.toBson());
+                auto& shardKeys =
+                    keysByShard
+                        .emplace(shardInfo.first,
+                                 std::make_pair(shardInfo.second, std::vector<Document>()))
+                        .first->second;
+                shardKeys.second.push_back(documentKey);
+            }
+
+            // Send each shard a single query for all of its keys. Limiting the query to the number
+            // of keys lets the shard close its cursor once it has found them all.
+            std::vector<std::pair<ShardId, BSONObj>> requests;
+            for (auto&& shardKeys : keysByShard) {
+                const auto numKeys = static_cast<long long>(shardKeys.second.second.size());
+                BSONObjBuilder shardCmdBuilder;
+                shardCmdBuilder.appendElements(findCmd);
+                shardCmdBuilder.append("filter", makeDocumentKeysFilter(shardKeys.second.second));
+                shardCmdBuilder.append("limit", numKeys);
+                shardCmdBuilder.append("batchSize", numKeys);
+                requests.emplace_back(
+                    shardKeys.first,
+                    appendShardVersion(shardCmdBuilder.obj(), shardKeys.second.first));
+            }
+
+            swShardResults = establishCursors(_expCtx->opCtx,
+                                              taskExecutor,
+                                              nss,
+                                              ReadPreferenceSetting::get(_expCtx->opCtx),
+                                              requests,
+                                              false,
+                                              nullptr);
+
+            // See lookupSingleDocument().
+            if (swShardResults.getStatus().code() == ErrorCodes::NamespaceNotFound) {
+                return {};
+            }
+            if (ErrorCodes::isStaleShardingError(swShardResults.getStatus().code())) {
+                catalogCache->onStaleConfigError(std::move(routingInfo));
+            }
+        } while (!swShardResults.isOK() && ++numAttempts < kMaxNumStaleVersionRetries);
+
+        std::vector<Document> lookedUpDocuments;
+        for (auto&& shardResult : uassertStatusOK(std::move(swShardResults))) {
+            auto& cursor = shardResult.cursorResponse;
+            for (auto&& obj : cursor.getBatch()) {
+                lookedUpDocuments.emplace_back(obj);
+            }
+
+            if (cursor.getCursorId() != 0) {
+                // The documents found did not fit in a single batch. Rather than fetch the rest,
+                // kill the cursor and let the caller look up any missing documents individually.
+                *complete = false;
+                BSONObj cmdObj = KillCursorsRequest(nss, {cursor.getCursorId()}).toBSON();
+                executor::RemoteCommandRequest request(
+                    shardResult.hostAndPort, nss.db().toString(), cmdObj, _expCtx->opCtx);
+
+                // We make a good-faith attempt at cleaning up the cursor, and ignore any errors.
+                taskExecutor
+                    ->scheduleRemoteCommand(
+                        request,
+                        [](const executor::TaskExecutor::RemoteCommandCallbackArgs& cbData) {})
+                    .status_with_transitional_ignore();
+            }
+        }
+        return lookedUpDocuments;
+    }
+
 private:
     intrusive_ptr<ExpressionContext> _expCtx;
     OperationContext* _opCtx;
@@ -42,7 +42,15 @@ boost::intrusive_ptr<DocumentSourceRouterAdapter> DocumentSourceRouterAdapter::c
 }
 
 DocumentSource::GetNextResult DocumentSourceRouterAdapter::getNext() {
-    auto next = uassertStatusOK(_child->next(_execContext));
+    // A later stage reading ahead of the results it has already produced must not block waiting
+    // for new results, as if a result had already been added to this batch.
+    auto execContext = _execContext;
+    if (pExpCtx->readingAhead &&
+        execContext == RouterExecStage::ExecContext::kGetMoreNoResultsYet) {
+        execContext = RouterExecStage::ExecContext::kGetMoreWithAtLeastOneResultInBatch;
+    }
+
+    auto next = uassertStatusOK(_child->next(execContext));
     if (auto nextObj = next.getResult()) {
         return Document::fromBsonWithMetaData(*nextObj);
     }
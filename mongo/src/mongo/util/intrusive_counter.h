@@ -93,16 +93,26 @@ class RefCountable {
 public:
     /// If false you have exclusive access to this object. This is useful for implementing COW.
     bool isShared() const {
-        // TODO: switch to unfenced read method after SERVER-6973
-        return reinterpret_cast<unsigned&>(_count) > 1;
+        return _count.loadRelaxed() > 1;
     }
 
     friend void intrusive_ptr_add_ref(const RefCountable* ptr) {
+        if (ptr->_singleThreaded) {
+            ptr->_count.storeRelaxed(ptr->_count.loadRelaxed() + 1);
+            return;
+        }
         ptr->_count.addAndFetch(1);
     };
 
     friend void intrusive_ptr_release(const RefCountable* ptr) {
-        if (ptr->_count.subtractAndFetch(1) == 0) {
+        unsigned count;
+        if (ptr->_singleThreaded) {
+            count = ptr->_count.loadRelaxed() - 1;
+            ptr->_count.storeRelaxed(count);
+        } else {
+            count = ptr->_count.subtractAndFetch(1);
+        }
+        if (count == 0) {
             delete ptr;  // uses subclass destructor and operator delete
         }
     };
@@ -111,8 +121,16 @@ protected:
     RefCountable() {}
     virtual ~RefCountable() {}
 
+    /// Makes the reference count use relaxed loads and stores rather than atomic
+    /// read-modify-writes. Only for objects which are never referenced from more than one thread
+    /// at a time.
+    void setSingleThreaded() {
+        _singleThreaded = true;
+    }
+
 private:
     mutable AtomicUInt32 _count;  // default initialized to 0
+    bool _singleThreaded = false;  // fits in the padding after _count
 };
 
 /// This is an immutable reference-counted string